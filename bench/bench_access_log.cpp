@@ -0,0 +1,136 @@
+// nginx-manager/bench/bench_access_log.cpp
+// 基准 - 换行扫描吞吐量，以及跟随 + 解析 + 滚动统计的整体行速率（目标单核 ≥ 100 万行/秒）
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_access_log.cpp ../src/access_log.cpp ../src/log_format.cpp ../src/log_rotator.cpp ../src/nginx_conf.cpp ../src/lz4_frame.cpp ../src/log_model.cpp ../src/log_tailer.cpp ../src/line_scan.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_access_log.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_access_log.cpp ../src/access_log.cpp ../src/log_format.cpp ../src/log_rotator.cpp ../src/nginx_conf.cpp ../src/lz4_frame.cpp ../src/log_model.cpp ../src/log_tailer.cpp ../src/line_scan.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_access_log
+
+#include "access_log.h"
+#include "line_scan.h"
+#include "log_format.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 生成 combined 格式日志，每秒 2 万行，状态码与长度按固定比例变化
+static void GenerateLog(const std::string& path, int lines) {
+    static const char* const paths[] = {
+        "/", "/index.html", "/api/v1/users?id=42&expand=profile", "/static/js/app.8f3a2c.js",
+        "/images/banner-large.png", "/login", "/api/v1/orders/1234567/items",
+    };
+    static const char* const agents[] = {
+        "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36",
+        "curl/8.4.0",
+        "Mozilla/5.0 (iPhone; CPU iPhone OS 17_0 like Mac OS X) AppleWebKit/605.1.15 Mobile/15E148",
+    };
+    static const int statuses[] = { 200, 200, 200, 200, 200, 304, 200, 404, 200, 502 };
+    static const char* const months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                          "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    FILE* out = fopen(path.c_str(), "wb");
+    std::vector<char> buffer(1 << 20);
+    setvbuf(out, buffer.data(), _IOFBF, buffer.size());
+    for (int i = 0; i < lines; ++i) {
+        int second = i / 20000;
+        fprintf(out,
+                "10.%d.%d.%d - - [18/%s/2026:%02d:%02d:%02d +0800] \"GET %s HTTP/1.1\" %d %d \"-\" \"%s\"\n",
+                i % 200, (i / 7) % 250, i % 251, months[9], 10 + second / 3600, (second / 60) % 60, second % 60,
+                paths[i % 7], statuses[i % 10], 100 + (i * 37) % 20000, agents[i % 3]);
+    }
+    fclose(out);
+}
+
+static std::vector<char> ReadWholeFile(const std::string& path) {
+    std::vector<char> data;
+    FILE* in = fopen(path.c_str(), "rb");
+    if (!in) return data;
+    fseek(in, 0, SEEK_END);
+    data.resize((size_t)ftell(in));
+    fseek(in, 0, SEEK_SET);
+    if (fread(data.data(), 1, data.size(), in) != data.size()) data.clear();
+    fclose(in);
+    return data;
+}
+
+typedef const char* (*ScanFunc)(const char*, const char*);
+
+static void BenchScan(const char* name, ScanFunc scan, const std::vector<char>& data, int rounds) {
+    uint64_t best = ~0ull;
+    size_t lines = 0;
+    for (int r = 0; r < rounds; ++r) {
+        const char* p = data.data();
+        const char* end = p + data.size();
+        lines = 0;
+        uint64_t begin = MonotonicMicros();
+        for (;;) {
+            const char* newline = scan(p, end);
+            if (newline == end) break;
+            ++lines;
+            p = newline + 1;
+        }
+        uint64_t elapsed = MonotonicMicros() - begin;
+        if (elapsed < best) best = elapsed;
+    }
+    printf("  %-8s %8.2f GB/s  %7.1f M 行/秒  (%zu 行)\n", name,
+           data.size() / (best / 1e6) / 1e9, lines / (best / 1e6) / 1e6, lines);
+}
+
+static const char* ScanMemchr(const char* begin, const char* end) {
+    const void* hit = memchr(begin, '\n', (size_t)(end - begin));
+    return hit ? static_cast<const char*>(hit) : end;
+}
+
+int main(int argc, char** argv) {
+    std::string path = argc > 1 ? argv[1] : "bench-access.log";
+    int lines = argc > 2 ? atoi(argv[2]) : 2000000;
+    int rounds = argc > 3 ? atoi(argv[3]) : 5;
+
+    GenerateLog(path, lines);
+    std::vector<char> data = ReadWholeFile(path);
+    printf("日志 %d 行, %.1f MB, 当前换行扫描实现: %s\n", lines, data.size() / (1024.0 * 1024.0),
+           NewlineScanLevel());
+
+    printf("换行扫描:\n");
+    BenchScan("scalar", FindNewlineScalar, data, rounds);
+    BenchScan("SSE2", FindNewlineSse2, data, rounds);
+    BenchScan("AVX2", FindNewlineAvx2, data, rounds);
+    BenchScan("memchr", ScanMemchr, data, rounds);
+
+    // 整体：从文件读取 → 切行 → 解析 → 滚动统计
+    uint64_t best = ~0ull;
+    TrafficSnapshot snapshot;
+    uint64_t delivered = 0;
+    for (int r = 0; r < rounds; ++r) {
+        LogTailer tailer;
+        LogFormatParser parser(LogFormat(), LOG_FIELD_TIME | LOG_FIELD_STATUS | LOG_FIELD_BYTES);
+        TrafficMetrics metrics;
+        tailer.Open(path, true);
+        uint64_t begin = MonotonicMicros();
+        delivered = tailer.Poll([&](const char* line, size_t length) {
+            AccessLogEntry entry;
+            if (parser.Parse(line, length, &entry)) {
+                AccessLogRecord record;
+                record.second = entry.second;
+                record.status = entry.status;
+                record.bytes = entry.bytes;
+                metrics.Add(record);
+            } else {
+                metrics.AddParseError();
+            }
+        });
+        uint64_t elapsed = MonotonicMicros() - begin;
+        if (elapsed < best) best = elapsed;
+        snapshot = metrics.Snapshot(metrics.LatestSecond() + 1, 10);
+    }
+
+    printf("跟随 + 解析 + 统计: %llu 行, 最佳 %.1f ms, %.2f M 行/秒, %.0f MB/s\n",
+           (unsigned long long)delivered, best / 1000.0, delivered / (best / 1e6) / 1e6,
+           data.size() / (best / 1e6) / (1024.0 * 1024.0));
+    printf("最近 10 秒: %.0f req/s, %.1f MB/s, 2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu, 解析失败 %llu\n",
+           snapshot.requestsPerSec, snapshot.bytesPerSec / (1024.0 * 1024.0),
+           (unsigned long long)snapshot.windowClasses[2], (unsigned long long)snapshot.windowClasses[3],
+           (unsigned long long)snapshot.windowClasses[4], (unsigned long long)snapshot.windowClasses[5],
+           (unsigned long long)snapshot.parseErrors);
+    return 0;
+}
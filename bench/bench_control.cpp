@@ -0,0 +1,187 @@
+// nginx-manager/bench/bench_control.cpp
+// 基准 - 控制通道的状态查询吞吐与延迟：多个客户端长连接查询 vs 每次查询启动一个进程
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_control.cpp ../src/control_server.cpp ../src/control_client.cpp ../src/control_protocol.cpp ../src/process_table.cpp ../src/nginx_control.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_control.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_control.cpp ../src/control_server.cpp ../src/control_client.cpp ../src/control_protocol.cpp ../src/process_table.cpp ../src/nginx_control.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_control
+//
+// 服务端与守护进程的状态查询路径相同：读取最多 100ms 前刷新的进程表缓存，在事件循环线程中直接回答。
+
+#include "control_client.h"
+#include "control_server.h"
+#include "process_table.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+static const uint64_t kStatusMaxAgeMicros = 100000;
+
+static std::string BenchEndpoint() {
+#ifdef _WIN32
+    return "\\\\.\\pipe\\nginx-manager-bench";
+#else
+    return "/tmp/nginx-manager-bench.sock";
+#endif
+}
+
+static double Percentile(std::vector<uint32_t>& samples, double p) {
+    if (samples.empty()) return 0;
+    size_t index = (size_t)(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// 一个客户端进程只做一次查询（模拟每次查询都启动 ngctl）
+static int RunChildQuery(const std::string& endpoint) {
+    ControlClient client;
+    ControlFrame response;
+    if (!client.Connect(endpoint, 5000, nullptr)) return 1;
+    return client.Call(CONTROL_STATUS, std::string(), &response, nullptr) && response.code == CONTROL_OK ? 0 : 1;
+}
+
+struct ClientResult {
+    uint64_t queries = 0;
+    uint64_t failures = 0;
+    std::vector<uint32_t> latencies;  // 微秒
+};
+
+// 每个线程一个长连接，depth 为连续发送而不等待响应的请求数
+static void RunClient(const std::string& endpoint, uint64_t deadline, int depth, ClientResult* result) {
+    ControlClient client;
+    if (!client.Connect(endpoint, 5000, nullptr)) {
+        ++result->failures;
+        return;
+    }
+    std::vector<uint64_t> sent(depth);
+    ControlFrame response;
+    uint32_t nextId = 1;
+    while (MonotonicMicros() < deadline) {
+        for (int i = 0; i < depth; ++i) {
+            sent[i] = MonotonicMicros();
+            if (!client.Send(nextId + i, CONTROL_STATUS, std::string(), nullptr)) {
+                ++result->failures;
+                return;
+            }
+        }
+        for (int i = 0; i < depth; ++i) {
+            if (!client.Receive(&response, nullptr) || response.code != CONTROL_OK) {
+                ++result->failures;
+                return;
+            }
+            uint32_t index = response.id - nextId;
+            if (index < (uint32_t)depth) result->latencies.push_back((uint32_t)(MonotonicMicros() - sent[index]));
+            ++result->queries;
+        }
+        nextId += depth;
+    }
+}
+
+static void RunRound(const std::string& endpoint, int threads, int depth, uint32_t durationMs) {
+    std::vector<ClientResult> results(threads);
+    std::vector<std::thread> workers;
+    uint64_t begin = MonotonicMicros();
+    uint64_t deadline = begin + (uint64_t)durationMs * 1000;
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(RunClient, endpoint, deadline, depth, &results[i]);
+    }
+    for (std::thread& worker : workers) worker.join();
+    double seconds = (MonotonicMicros() - begin) / 1e6;
+
+    ClientResult total;
+    for (ClientResult& result : results) {
+        total.queries += result.queries;
+        total.failures += result.failures;
+        total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+    }
+    printf("长连接 %3d 个客户端 x 深度 %2d: %9.0f 次/秒, 延迟 p50 %6.0f us, p99 %6.0f us, 失败 %llu\n", threads,
+           depth, total.queries / seconds, Percentile(total.latencies, 0.5), Percentile(total.latencies, 0.99),
+           (unsigned long long)total.failures);
+}
+
+static void RunSpawnRound(const std::string& self, const std::string& endpoint, int count) {
+    std::vector<uint32_t> latencies;
+    uint64_t begin = MonotonicMicros();
+    int failures = 0;
+    for (int i = 0; i < count; ++i) {
+        uint64_t start = MonotonicMicros();
+        int code = 1;
+#ifdef _WIN32
+        std::wstring commandLine = L"\"" + Utf8ToWide(self) + L"\" --child " + Utf8ToWide(endpoint);
+        STARTUPINFOW si = {};
+        si.cb = sizeof(si);
+        PROCESS_INFORMATION pi = {};
+        if (CreateProcessW(NULL, &commandLine[0], NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+            WaitForSingleObject(pi.hProcess, INFINITE);
+            DWORD exitCode = 1;
+            GetExitCodeProcess(pi.hProcess, &exitCode);
+            code = (int)exitCode;
+            CloseHandle(pi.hThread);
+            CloseHandle(pi.hProcess);
+        }
+#else
+        const char* argv[] = { self.c_str(), "--child", endpoint.c_str(), NULL };
+        pid_t pid = 0;
+        if (posix_spawn(&pid, self.c_str(), NULL, NULL, (char* const*)argv, environ) == 0) {
+            int status = 0;
+            waitpid(pid, &status, 0);
+            code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+        }
+#endif
+        if (code != 0) ++failures;
+        latencies.push_back((uint32_t)(MonotonicMicros() - start));
+    }
+    double seconds = (MonotonicMicros() - begin) / 1e6;
+    printf("每次查询启动进程 (%d 次):    %9.0f 次/秒, 延迟 p50 %6.0f us, p99 %6.0f us, 失败 %d\n", count,
+           count / seconds, Percentile(latencies, 0.5), Percentile(latencies, 0.99), failures);
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "--child") == 0) return RunChildQuery(argv[2]);
+
+    std::string endpoint = BenchEndpoint();
+    ControlServer server;
+    ProcessTable table;
+    uint64_t statusMicros = 0;
+    uint64_t refreshes = 0;
+    std::string error;
+    bool started = server.Start(endpoint, [&](const ControlRequest& request) {
+        uint64_t now = MonotonicMicros();
+        if (now - statusMicros > kStatusMaxAgeMicros) {
+            table.Refresh();
+            statusMicros = now;
+            ++refreshes;
+        }
+        std::string payload;
+        AppendField(&payload, "state", std::string(table.MasterPid() != 0 ? "running" : "stopped"));
+        AppendField(&payload, "master_pid", (uint64_t)table.MasterPid());
+        AppendField(&payload, "workers", (uint64_t)table.WorkerPids().size());
+        AppendField(&payload, "snapshot_age_ms", (now - statusMicros) / 1000.0);
+        server.Respond(request.connection, request.id, CONTROL_OK, payload);
+    }, &error);
+    if (!started) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    RunSpawnRound(argv[0], endpoint, 200);
+    RunRound(endpoint, 1, 1, 1000);
+    RunRound(endpoint, 8, 1, 1000);
+    RunRound(endpoint, 64, 1, 1000);
+    RunRound(endpoint, 64, 16, 1000);
+
+    server.Stop();
+    ControlServerStats stats = server.Stats();
+    printf("服务端: 连接 %llu 个, 请求 %llu 个, 响应 %llu 个, 协议错误 %llu, 进程表扫描 %llu 次\n",
+           (unsigned long long)stats.accepted, (unsigned long long)stats.requests,
+           (unsigned long long)stats.responses, (unsigned long long)stats.protocolErrors,
+           (unsigned long long)refreshes);
+    return 0;
+}
@@ -0,0 +1,270 @@
+// nginx-manager/bench/bench_health_prober.cpp
+// 基准 - upstream 健康检查：时间轮的设置 / 推进速度，对大量本机地址的并发探测（首轮耗时、稳态 CPU 占用）与超时判定的准确度
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_health_prober.cpp ../src/health_prober.cpp ../src/timer_wheel.cpp ../src/nginx_conf.cpp ../src/socket_util.cpp ../src/file_util.cpp ../src/trace.cpp -lws2_32 -o bench_health_prober.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_health_prober.cpp ../src/health_prober.cpp ../src/timer_wheel.cpp ../src/nginx_conf.cpp ../src/socket_util.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_health_prober
+//
+// 用法: bench_health_prober [探测地址数，默认 2000] [稳态测量秒数，默认 10]
+// 探测地址为 127.0.x.y（整个 127.0.0.0/8 都是本机地址），一半指向有监听的端口、一半指向已关闭的端口；
+// 超时测试中的监听端口从不 accept 也不响应，HTTP 检查必然在超时后判为不可用。
+
+#include "health_prober.h"
+#include "socket_util.h"
+#include "timer_wheel.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+static const char* kConfPath = "bench-health.conf";
+#else
+#include <netinet/in.h>
+#include <sys/resource.h>
+static const char* kConfPath = "/tmp/bench-health.conf";
+#endif
+
+// 本进程已消耗的 CPU 时间（微秒）
+static uint64_t ProcessCpuMicros() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+    uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (k + u) / 10;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec +
+           (uint64_t)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+#endif
+}
+
+static uint64_t Percentile(std::vector<int64_t> values, double percentile) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return (uint64_t)std::max<int64_t>(values[(size_t)(percentile / 100.0 * (values.size() - 1) + 0.5)], 0);
+}
+
+// 监听 INADDR_ANY 的随机端口；accept 为 true 时接受连接后立即关闭，否则连接只停留在监听队列中
+class Listener {
+public:
+    bool Start(bool accept, int backlog) {
+        m_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(m_listen, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listen, backlog) != 0) return false;
+        socklen_t length = sizeof(address);
+        getsockname(m_listen, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+        if (accept) m_acceptor = std::thread(&Listener::AcceptLoop, this);
+        return true;
+    }
+
+    void Stop() {
+        m_stopping = true;
+        if (m_acceptor.joinable()) {
+            SocketHandle wake = ConnectTcp("127.0.0.1", m_port, 1000, nullptr);
+            CloseSocket(wake);
+            m_acceptor.join();
+        }
+        CloseSocket(m_listen);
+    }
+
+    uint16_t Port() const { return m_port; }
+
+private:
+    void AcceptLoop() {
+        while (!m_stopping) CloseSocket(::accept(m_listen, nullptr, nullptr));
+    }
+
+    SocketHandle m_listen = kInvalidSocket;
+    uint16_t m_port = 0;
+    std::atomic<bool> m_stopping{false};
+    std::thread m_acceptor;
+};
+
+// 一个当前没有监听的端口（绑定后立即关闭）
+static uint16_t ClosedPort() {
+    Listener listener;
+    listener.Start(false, 1);
+    uint16_t port = listener.Port();
+    listener.Stop();
+    return port;
+}
+
+// 第 i 个探测地址：127.0.x.y，跳过 .0 与 .255
+static std::string TargetHost(size_t i) {
+    return "127.0." + std::to_string(1 + i / 254) + "." + std::to_string(1 + i % 254);
+}
+
+// 写出只含 upstream 的配置：每组 (名称, 端口, 数量) 一个 upstream 块
+static bool WriteConf(const std::vector<std::pair<std::string, std::pair<uint16_t, size_t>>>& groups) {
+    FILE* file = fopen(kConfPath, "wb");
+    if (!file) return false;
+    fprintf(file, "events {}\nhttp {\n");
+    size_t next = 0;
+    for (const auto& group : groups) {
+        fprintf(file, "    upstream %s {\n", group.first.c_str());
+        for (size_t i = 0; i < group.second.second; ++i) {
+            fprintf(file, "        server %s:%u;\n", TargetHost(next++).c_str(), (unsigned)group.second.first);
+        }
+        fprintf(file, "    }\n");
+    }
+    fprintf(file, "}\n");
+    fclose(file);
+    return true;
+}
+
+// 1. 时间轮：设置、改设与推进的单次耗时
+static void BenchTimerWheel() {
+    const uint32_t timers = 100000;
+    const int rounds = 20;
+    TimerWheel wheel(10000, 1024);
+    wheel.Reset(timers, 0);
+    uint64_t seed = 88172645463325252ull;
+    auto next = [&seed]() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return seed;
+    };
+
+    uint64_t begin = MonotonicMicros();
+    for (int r = 0; r < rounds; ++r) {
+        for (uint32_t id = 0; id < timers; ++id) wheel.Schedule(id, next() % 20000000);
+    }
+    uint64_t scheduleMicros = MonotonicMicros() - begin;
+
+    std::vector<uint32_t> expired;
+    expired.reserve(timers);
+    begin = MonotonicMicros();
+    for (uint64_t now = 0; now <= 20000000; now += 10000) wheel.Advance(now, &expired);
+    uint64_t advanceMicros = MonotonicMicros() - begin;
+
+    printf("时间轮 (%u 个定时器, 10ms 刻度, 1024 槽)\n", timers);
+    printf("    设置 / 改设    %6.1f ns/次\n", scheduleMicros * 1000.0 / ((double)timers * rounds));
+    printf("    推进 20 秒     %6.2f ms (到期 %zu 个, 每个刻度 %.2f us)\n", advanceMicros / 1000.0, expired.size(),
+           advanceMicros / 2000.0);
+}
+
+// 2. TCP 连接检查：首轮全部完成的耗时与稳态的 CPU 占用
+static bool BenchConnect(size_t targets, int seconds) {
+    Listener open;
+    if (!open.Start(true, 4096)) {
+        fprintf(stderr, "无法监听\n");
+        return false;
+    }
+    uint16_t closed = ClosedPort();
+    WriteConf({ { "open", { open.Port(), targets / 2 } }, { "closed", { closed, targets - targets / 2 } } });
+
+    HealthCheckOptions options;
+    options.intervalMs = 1000;
+    options.timeoutMs = 1000;
+    options.failThreshold = 1;
+    options.maxInFlight = 1024;
+    HealthProber prober;
+    prober.SetOptions(options);
+
+    uint64_t begin = MonotonicMicros();
+    prober.Start(kConfPath);
+    HealthSnapshot snapshot;
+    uint64_t firstRound = 0;
+    while (MonotonicMicros() - begin < 10000000) {
+        snapshot = prober.Snapshot();
+        if (snapshot.targets > 0 && snapshot.unknown == 0) {
+            firstRound = MonotonicMicros() - begin;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    uint64_t cpuBegin = ProcessCpuMicros();
+    uint64_t wallBegin = MonotonicMicros();
+    HealthSnapshot before = prober.Snapshot();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    HealthSnapshot after = prober.Snapshot();
+    double wall = (MonotonicMicros() - wallBegin) / 1e6;
+    double cpu = (ProcessCpuMicros() - cpuBegin) / 1e6;
+    prober.Stop();
+    open.Stop();
+
+    uint64_t probes = after.probes - before.probes;
+    printf("TCP 连接检查 (%u 个地址, 间隔 1 秒)\n", after.targets);
+    printf("    首轮完成       %7.1f ms (首轮在一个间隔内错开发出)\n", firstRound / 1000.0);
+    printf("    结果           %u 可用 · %u 不可用 · %u 未知\n", after.up, after.down, after.unknown);
+    printf("    稳态           %.0f 次探测/秒, 事件循环 %.2f us/次, 进程 CPU %.1f%% (含监听端的 accept 线程)\n",
+           probes / wall, probes ? (after.loopMicros - before.loopMicros) / (double)probes : 0.0, cpu / wall * 100);
+    return after.unknown == 0 && after.up == targets / 2;
+}
+
+// 3. 超时判定：从不响应的 HTTP 检查应在开始后 timeout 判为不可用，统计实际时刻相对预期的偏差
+static bool BenchTimeout(size_t targets) {
+    Listener silent;
+    // 连接停留在监听队列中，队列须放得下全部探测
+    if (!silent.Start(false, (int)targets * 2)) {
+        fprintf(stderr, "无法监听\n");
+        return false;
+    }
+    WriteConf({ { "silent", { silent.Port(), targets } } });
+
+    const uint32_t intervalMs = 1000;
+    const uint32_t timeoutMs = 300;
+    std::mutex mutex;
+    std::unordered_map<std::string, uint64_t> downAt;
+    HealthProber prober;
+    prober.SetHandler([&](const HealthEvent& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (event.health == UPSTREAM_DOWN) downAt.emplace(event.address, MonotonicMicros());
+    });
+    HealthCheckOptions options;
+    options.intervalMs = intervalMs;
+    options.timeoutMs = timeoutMs;
+    options.httpPath = "/";
+    options.failThreshold = 1;
+    options.maxInFlight = (uint32_t)targets;
+    prober.SetOptions(options);
+
+    uint64_t begin = MonotonicMicros();
+    prober.Start(kConfPath);
+    std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs + timeoutMs + 500));
+    prober.Stop();
+    silent.Stop();
+
+    // 首轮第 i 个地址在 begin + interval * i / n 发出（另有配置解析的几毫秒，计入偏差）
+    std::vector<int64_t> late;
+    std::vector<std::string> errors;
+    for (size_t i = 0; i < targets; ++i) {
+        auto found = downAt.find(TargetHost(i) + ":" + std::to_string(silent.Port()));
+        if (found == downAt.end()) continue;
+        uint64_t expected = begin + (uint64_t)intervalMs * 1000 * i / targets + (uint64_t)timeoutMs * 1000;
+        late.push_back((int64_t)found->second - (int64_t)expected);
+    }
+    printf("超时判定 (%zu 个地址, 超时 %u ms, 刻度 10 ms)\n", targets, timeoutMs);
+    printf("    判为不可用     %zu / %zu\n", late.size(), targets);
+    printf("    相对预期的延后 p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n", Percentile(late, 50) / 1000.0,
+           Percentile(late, 99) / 1000.0, Percentile(late, 100) / 1000.0);
+    return late.size() == targets;
+}
+
+int main(int argc, char** argv) {
+    size_t targets = argc > 1 ? (size_t)atoi(argv[1]) : 2000;
+    int seconds = argc > 2 ? atoi(argv[2]) : 10;
+    if (targets < 2 || targets > 254 * 250) {
+        fprintf(stderr, "探测地址数应在 2 ~ %d 之间\n", 254 * 250);
+        return 1;
+    }
+    if (!InitSockets()) return 1;
+
+    BenchTimerWheel();
+    bool ok = BenchConnect(targets, seconds);
+    ok = BenchTimeout(std::min<size_t>(targets / 4, 1000)) && ok;
+    remove(kConfPath);
+    return ok ? 0 : 1;
+}
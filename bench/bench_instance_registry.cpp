@@ -0,0 +1,131 @@
+// nginx-manager/bench/bench_instance_registry.cpp
+// 基准 - 模拟数百个 nginx 实例，比较登记表的单次扫描探测与逐实例扫描的耗时
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_instance_registry.cpp ../src/instance_registry.cpp ../src/process_table.cpp ../src/nginx_control.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_instance_registry.exe
+// 编译 (Linux):  g++ -O2 -I../src bench_instance_registry.cpp ../src/instance_registry.cpp ../src/process_table.cpp ../src/nginx_control.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_instance_registry
+//
+// Linux 上每个模拟实例是一个改名为 nginx 的子进程（命令行带 -p <prefix>），外加两个 worker；
+// Windows 上无法伪造 nginx.exe 进程，只测量登记表本身在没有运行实例时的开销。
+
+#include "instance_registry.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// 子进程入口：改名为 nginx，再派生两个 worker，然后一直等待被结束
+static int RunFakeMaster() {
+    prctl(PR_SET_NAME, "nginx", 0, 0, 0);
+    for (int i = 0; i < 2; ++i) {
+        if (fork() == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL, 0, 0, 0);
+            for (;;) pause();
+        }
+    }
+    for (;;) pause();
+}
+
+static pid_t SpawnFakeMaster(const std::string& prefix) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        const char* argv[] = { "nginx", "-p", prefix.c_str(), "--fake-master", nullptr };
+        execv("/proc/self/exe", (char* const*)argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+static void KillFakeMaster(pid_t pid) {
+    kill(-pid, SIGKILL);
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+}
+#endif
+
+int main(int argc, char** argv) {
+#ifndef _WIN32
+    if (argc >= 4 && std::string(argv[3]) == "--fake-master") {
+        setpgid(0, 0);
+        return RunFakeMaster();
+    }
+#endif
+    int count = argc > 1 ? atoi(argv[1]) : 300;
+    int rounds = 50;
+
+    InstanceRegistry registry;
+    std::vector<std::string> prefixes;
+    for (int i = 0; i < count; ++i) {
+#ifdef _WIN32
+        prefixes.push_back("C:\\nginx-bench\\instance-" + std::to_string(i));
+#else
+        prefixes.push_back("/tmp/nginx-bench/instance-" + std::to_string(i) + "/");
+#endif
+        registry.Add(prefixes.back(), "");
+    }
+
+#ifndef _WIN32
+    std::vector<pid_t> masters;
+    for (const std::string& prefix : prefixes) {
+        masters.push_back(SpawnFakeMaster(prefix));
+    }
+    usleep(500 * 1000);  // 等待所有子进程完成改名并派生 worker
+#endif
+
+    // 1. 首轮探测：需要为每个 master 解析前缀
+    InstanceProbeStats stats;
+    std::vector<uint32_t> changed;
+    registry.Probe(&changed, &stats);
+    printf("首轮探测: %zu 个实例, %zu 个 nginx 进程, %zu 个 master, 解析 %zu 个前缀, "
+           "扫描 %.2f ms + 归属 %.2f ms\n",
+           stats.instances, stats.processes, stats.masters, stats.resolved,
+           stats.scanMicros / 1000.0, stats.matchMicros / 1000.0);
+
+    // 2. 稳态探测：前缀全部命中缓存
+    uint64_t scanTotal = 0;
+    uint64_t matchTotal = 0;
+    for (int i = 0; i < rounds; ++i) {
+        registry.Probe(&changed, &stats);
+        scanTotal += stats.scanMicros;
+        matchTotal += stats.matchMicros;
+    }
+    size_t running = 0;
+    for (const InstanceInfo& info : registry.List()) {
+        if (info.state == INSTANCE_RUNNING && info.workerCount == 2) ++running;
+    }
+    printf("稳态探测: 平均扫描 %.2f ms + 归属 %.3f ms (每实例 %.2f us), 解析 %zu 个前缀, %zu/%d 个实例运行中\n",
+           scanTotal / 1000.0 / rounds, matchTotal / 1000.0 / rounds,
+           (double)(scanTotal + matchTotal) / rounds / count, stats.resolved, running, count);
+
+    // 3. 对比：每个实例各自扫描一次进程表（旧的单实例做法）
+    int sample = count < 20 ? count : 20;
+    uint64_t begin = MonotonicMicros();
+    for (int i = 0; i < sample; ++i) {
+        ProcessTable table;
+        table.SetPrefix(prefixes[i]);
+        table.Refresh();
+    }
+    double perInstance = (MonotonicMicros() - begin) / (double)sample;
+    printf("逐实例扫描: 每实例 %.2f ms, %d 个实例合计约 %.1f ms\n", perInstance / 1000.0, count,
+           perInstance * count / 1000.0);
+
+#ifndef _WIN32
+    // 4. 结束一部分实例，确认下一轮探测能识别状态变化
+    int stopped = count / 10;
+    for (int i = 0; i < stopped; ++i) {
+        KillFakeMaster(masters[i]);
+    }
+    registry.Probe(&changed, &stats);
+    printf("结束 %d 个实例后: %zu 个实例状态变化\n", stopped, changed.size());
+
+    for (size_t i = stopped; i < masters.size(); ++i) {
+        KillFakeMaster(masters[i]);
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,95 @@
+// nginx-manager/bench/bench_journal.cpp
+// 基准 - 操作日志持久化：界面线程调用 Append 的耗时（写入交给后台线程）、按时间查询的耗时，以及分段保留上限
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_journal.cpp ../src/journal.cpp ../src/content_hash.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_journal.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_journal.cpp ../src/journal.cpp ../src/content_hash.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_journal
+
+#include "journal.h"
+#include "file_util.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+static const char* kDirectory = "bench-journal";
+#else
+static const char* kDirectory = "/tmp/bench-journal";
+#endif
+
+static void ClearDirectory(const std::string& directory) {
+    for (const std::string& name : ListDirectory(directory)) RemoveFile(JoinPath(directory, name));
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? (size_t)strtoul(argv[1], nullptr, 10) : 200000;
+    MakeDirectory(kDirectory);
+    ClearDirectory(kDirectory);
+
+    // 1. 追加：每条记录模拟一行操作日志，间隔 1ms
+    Journal journal;
+    journal.SetSegmentLimit(4ull * 1024 * 1024);
+    journal.SetRetention(16ull * 1024 * 1024);
+    std::string error;
+    if (!journal.Open(kDirectory, &error)) {
+        fprintf(stderr, "无法打开: %s\n", error.c_str());
+        return 1;
+    }
+    const int64_t start = 1760688000000000LL;
+    std::vector<uint32_t> latencies;
+    latencies.reserve(count);
+    size_t rejected = 0;
+    uint64_t begin = MonotonicMicros();
+    for (size_t i = 0; i < count; ++i) {
+        char text[128];
+        snprintf(text, sizeof(text), "[%zu] 配置校验通过，重新加载 nginx (worker 已接管，耗时 %zu ms)", i, i % 500);
+        uint64_t before = MonotonicMicros();
+        if (!journal.Append(i % 10 == 0 ? JOURNAL_EVENT : JOURNAL_LOG, 2, (int64_t)(i % 500) * 1000, text,
+                            start + (int64_t)i * 1000)) {
+            ++rejected;
+        }
+        latencies.push_back((uint32_t)(MonotonicMicros() - before));
+    }
+    uint64_t appendMicros = MonotonicMicros() - begin;
+    std::sort(latencies.begin(), latencies.end());
+    printf("追加 %zu 条: 共 %.1f ms, 调用耗时 p50 %u us, p99 %u us, max %u us, 排队已满被拒绝 %zu 条\n", count,
+           appendMicros / 1000.0, latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100],
+           latencies.back(), rejected);
+
+    // 2. 按时间查询最后一分钟（先写完排队中的记录）
+    std::vector<JournalRecord> records;
+    const int64_t end = start + (int64_t)count * 1000;
+    begin = MonotonicMicros();
+    journal.Query(end - 60000000, end, kJournalAllTypes, 100000, &records);
+    uint64_t queryMicros = MonotonicMicros() - begin;
+    size_t expected = std::min(count, (size_t)60000);
+    printf("查询最后一分钟: %zu 条 (应为 %zu 条, 减去被拒绝的), %.2f ms\n", records.size(), expected,
+           queryMicros / 1000.0);
+
+    begin = MonotonicMicros();
+    journal.Query(end - 60000000, end, JournalMask(JOURNAL_EVENT), 100000, &records);
+    printf("只查事件: %zu 条, %.2f ms\n", records.size(), (MonotonicMicros() - begin) / 1000.0);
+
+    // 3. 保留上限：已封存分段的总大小不超过 16MB
+    uint64_t total = 0;
+    for (const std::string& name : ListDirectory(kDirectory)) {
+        uint64_t size = 0;
+        if (StatFile(JoinPath(kDirectory, name), &size)) total += size;
+    }
+    printf("分段 %zu 个, 目录共 %.1f MB (保留上限 16MB + 活动分段 4MB)\n", journal.SegmentCount(),
+           total / 1048576.0);
+    journal.Close();
+
+    // 4. 重新打开：从最后一个分段恢复序号
+    Journal reopened;
+    if (!reopened.Open(kDirectory, &error)) {
+        fprintf(stderr, "无法重新打开: %s\n", error.c_str());
+        return 1;
+    }
+    printf("重新打开后下一个序号 %llu (应为 %zu)\n", (unsigned long long)reopened.NextSequence(),
+           count - rejected + 1);
+    reopened.Close();
+    ClearDirectory(kDirectory);
+    return 0;
+}
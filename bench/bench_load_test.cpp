@@ -0,0 +1,233 @@
+// nginx-manager/bench/bench_load_test.cpp
+// 基准 - 压测：延迟直方图的记录速度与分位数误差，对本地模拟服务的不限速 / 限速压测，以及服务端停顿时两种模式的尾延迟
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_load_test.cpp ../src/load_test.cpp ../src/load_history.cpp ../src/log_model.cpp ../src/socket_util.cpp ../src/http_client.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -lws2_32 -o bench_load_test.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_load_test.cpp ../src/load_test.cpp ../src/load_history.cpp ../src/log_model.cpp ../src/socket_util.cpp ../src/http_client.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_load_test
+//
+// 用法: bench_load_test [连接数，默认 16] [每段时长秒，默认 3]
+
+#include "load_history.h"
+#include "load_test.h"
+#include "socket_util.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#endif
+
+// 模拟 nginx：HTTP/1.1 长连接，每个连接处理 keepaliveRequests 个请求后关闭；
+// 每 10 个响应有一个用 chunked 编码；Stall 让所有连接暂停一段时间，模拟服务端卡顿
+class StandInServer {
+public:
+    bool Start(uint32_t keepaliveRequests) {
+        m_keepaliveRequests = keepaliveRequests;
+        InitSockets();
+        m_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (bind(m_listen, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listen, 128) != 0) return false;
+        socklen_t length = sizeof(address);
+        getsockname(m_listen, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+        m_acceptor = std::thread(&StandInServer::AcceptLoop, this);
+        return true;
+    }
+
+    void Stop() {
+        m_stopping = true;
+        // 连一次自己，让 accept 返回
+        SocketHandle wake = ConnectTcp("127.0.0.1", m_port, 1000, nullptr);
+        CloseSocket(wake);
+        m_acceptor.join();
+        CloseSocket(m_listen);
+        for (std::thread& t : m_connections) t.join();
+    }
+
+    // 此后 micros 微秒内收到的请求都等到期满才响应
+    void Stall(uint64_t micros) { m_stallUntil = MonotonicMicros() + micros; }
+
+    uint16_t Port() const { return m_port; }
+    uint64_t Requests() const { return m_requests; }
+
+private:
+    void AcceptLoop() {
+        while (!m_stopping) {
+            SocketHandle client = accept(m_listen, nullptr, nullptr);
+            if (client == kInvalidSocket || m_stopping) {
+                CloseSocket(client);
+                continue;
+            }
+            m_connections.emplace_back(&StandInServer::Serve, this, client);
+        }
+    }
+
+    void Serve(SocketHandle client) {
+        // nginx 默认首页的大小
+        static const std::string kBody(612, 'x');
+        std::string buffer;
+        char chunk[4096];
+        uint32_t served = 0;
+        while (!m_stopping) {
+            size_t end;
+            while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+                int n = recv(client, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    CloseSocket(client);
+                    return;
+                }
+                buffer.append(chunk, (size_t)n);
+            }
+            buffer.erase(0, end + 4);
+
+            while (MonotonicMicros() < m_stallUntil) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            uint64_t requests = ++m_requests;
+            bool close = ++served >= m_keepaliveRequests;
+            std::string response = "HTTP/1.1 200 OK\r\nServer: nginx\r\nContent-Type: text/html\r\n";
+            if (requests % 10 == 0) {
+                char size[16];
+                snprintf(size, sizeof(size), "%x", (unsigned)(kBody.size() - 100));
+                response += std::string("Transfer-Encoding: chunked\r\nConnection: ") + (close ? "close" : "keep-alive") +
+                            "\r\n\r\n64\r\n" + kBody.substr(0, 100) + "\r\n" + size + "\r\n" + kBody.substr(100) +
+                            "\r\n0\r\n\r\n";
+            } else {
+                response += "Content-Length: " + std::to_string(kBody.size()) + "\r\nConnection: " +
+                            (close ? "close" : "keep-alive") + "\r\n\r\n" + kBody;
+            }
+            send(client, response.data(), (int)response.size(), 0);
+            if (close) break;
+        }
+        CloseSocket(client);
+    }
+
+    SocketHandle m_listen = kInvalidSocket;
+    uint16_t m_port = 0;
+    uint32_t m_keepaliveRequests = 100;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint64_t> m_stallUntil{0};
+    std::thread m_acceptor;
+    std::vector<std::thread> m_connections;
+};
+
+// 1. 直方图：记录速度与分位数相对误差
+static void BenchHistogram() {
+    const size_t count = 10000000;
+    std::vector<uint64_t> values(count);
+    uint64_t seed = 88172645463325252ull;
+    for (size_t i = 0; i < count; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        // 对数均匀分布在 1us ~ 10s 之间
+        values[i] = (uint64_t)std::exp((double)(seed % 1000000) / 1000000.0 * std::log(1e7));
+    }
+
+    LatencyHistogram histogram;
+    uint64_t begin = MonotonicMicros();
+    for (uint64_t value : values) histogram.Record(value);
+    uint64_t micros = MonotonicMicros() - begin;
+
+    std::sort(values.begin(), values.end());
+    double worst = 0;
+    const double percentiles[] = { 50, 90, 99, 99.9, 99.99 };
+    for (double percentile : percentiles) {
+        uint64_t exact = values[(size_t)(percentile / 100.0 * count + 0.5) - 1];
+        uint64_t reported = histogram.ValueAtPercentile(percentile);
+        double error = exact ? std::fabs((double)reported - (double)exact) / (double)exact : 0;
+        worst = std::max(worst, error);
+    }
+    printf("直方图: 记录 %zu 个值 %.1f ns/个, p50~p99.99 最大相对误差 %.3f%%, max %s\n", count,
+           micros * 1000.0 / count, worst * 100, histogram.Max() == values.back() ? "准确" : "不准确");
+}
+
+static void PrintResult(const char* label, const LoadTestResult& result, uint64_t serverRequests) {
+    printf("%s: %s\n", label, FormatLoadTestSummary(result).c_str());
+    printf("    %llu 个请求 (服务端共 %llu), 超时 %llu, 连接失败 %llu, 读取错误 %llu, 重连 %llu, 最大排队 %llu\n",
+           (unsigned long long)result.requests, (unsigned long long)serverRequests,
+           (unsigned long long)result.timeouts, (unsigned long long)result.connectErrors,
+           (unsigned long long)result.readErrors, (unsigned long long)result.reconnects,
+           (unsigned long long)result.backlogMax);
+}
+
+int main(int argc, char** argv) {
+    uint32_t connections = argc > 1 ? (uint32_t)atoi(argv[1]) : 16;
+    uint32_t seconds = argc > 2 ? (uint32_t)atoi(argv[2]) : 3;
+
+    BenchHistogram();
+
+    StandInServer server;
+    if (!server.Start(100)) {
+        fprintf(stderr, "无法监听本地端口\n");
+        return 1;
+    }
+
+    LoadTestOptions options;
+    options.port = server.Port();
+    options.connections = connections;
+    options.durationMs = seconds * 1000;
+    options.warmupMs = 500;
+    std::string error;
+
+    // 2. 不限速：测量最大吞吐
+    LoadTestResult closed;
+    if (!RunLoadTest(options, nullptr, &closed, &error)) {
+        fprintf(stderr, "压测失败: %s\n", error.c_str());
+        return 1;
+    }
+    PrintResult("不限速", closed, server.Requests());
+
+    // 3. 限速到最大吞吐的一半
+    LoadTestOptions paced = options;
+    paced.requestsPerSec = (uint32_t)std::max(100.0, closed.RequestsPerSec() / 2);
+    LoadTestResult open;
+    uint64_t before = server.Requests();
+    RunLoadTest(paced, nullptr, &open, &error);
+    printf("限速 %u/s 实际 %.0f/s\n", paced.requestsPerSec, open.RequestsPerSec());
+    PrintResult("限速", open, server.Requests() - before);
+
+    // 4. 服务端每秒停顿 100ms：不限速模式只有每个连接上的一个请求变慢，限速模式把停顿期间本应发出的请求都计入
+    paced.requestsPerSec = 2000;
+    for (int mode = 0; mode < 2; ++mode) {
+        LoadTestOptions stalled = mode == 0 ? options : paced;
+        std::atomic<bool> done(false);
+        std::thread staller([&]() {
+            while (!done) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(900));
+                server.Stall(100000);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        });
+        LoadTestResult result;
+        before = server.Requests();
+        RunLoadTest(stalled, nullptr, &result, &error);
+        done = true;
+        staller.join();
+        PrintResult(mode == 0 ? "停顿 + 不限速" : "停顿 + 限速 2000/s", result, server.Requests() - before);
+    }
+    server.Stop();
+
+    // 5. 保存并对比两份 "配置" 的结果
+    LoadTestHistory history("bench_loadtest");
+    history.Append(MakeLoadTestRecord(0x1111222233334444ull, options, closed), &error);
+    history.Append(MakeLoadTestRecord(0x5555666677778888ull, options, open), &error);
+    LoadTestRecord base;
+    LoadTestRecord other;
+    if (history.Find("1111", &base, &error) && history.Find("5555", &other, &error)) {
+        printf("\n%s", FormatLoadTestComparison(base, other).c_str());
+    } else {
+        printf("读取压测记录失败: %s\n", error.c_str());
+    }
+    remove("bench_loadtest/1111222233334444.txt");
+    remove("bench_loadtest/5555666677778888.txt");
+    return 0;
+}
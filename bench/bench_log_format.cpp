@@ -0,0 +1,268 @@
+// nginx-manager/bench/bench_log_format.cpp
+// 基准 - 按 log_format 编译的行解析程序与通用分词解析的行速率对比（combined 与一个较宽的自定义格式），并核对两者结果一致
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_log_format.cpp ../src/log_format.cpp ../src/log_model.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_log_format.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_log_format.cpp ../src/log_format.cpp ../src/log_model.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_log_format
+//
+// 用法: bench_log_format [行数，默认 1000000] [轮数，默认 5]
+
+#include "log_format.h"
+#include "platform.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+static const char* kCombined =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent "
+    "\"$http_referer\" \"$http_user_agent\"";
+
+// 带 ISO 时间、Host、耗时与若干只需跳过的字段
+static const char* kWide =
+    "$remote_addr - $remote_user [$time_iso8601] \"$request\" $status $body_bytes_sent \"$http_referer\" "
+    "\"$http_user_agent\" \"$http_x_forwarded_for\" $host $request_length $request_time $upstream_response_time "
+    "$connection $connection_requests";
+
+static const char* const kPaths[] = {
+    "/", "/index.html", "/api/v1/users?id=42&expand=profile", "/static/js/app.8f3a2c.js",
+    "/images/banner-large.png", "/login", "/api/v1/orders/1234567/items",
+};
+static const char* const kAgents[] = {
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36",
+    "curl/8.4.0",
+    "Mozilla/5.0 (iPhone; CPU iPhone OS 17_0 like Mac OS X) AppleWebKit/605.1.15 Mobile/15E148",
+};
+static const char* const kHosts[] = { "www.example.com", "api.example.com", "static.example.com" };
+static const int kStatuses[] = { 200, 200, 200, 200, 200, 304, 200, 404, 200, 502 };
+static const char* const kMonths[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                       "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+// 生成日志，每秒 2 万行；wide 为 true 时按 kWide 输出
+static std::string GenerateLog(int lines, bool wide) {
+    std::string text;
+    text.reserve((size_t)lines * (wide ? 300 : 220));
+    char line[1024];
+    for (int i = 0; i < lines; ++i) {
+        int second = i / 20000;
+        int hour = 10 + second / 3600, minute = (second / 60) % 60, sec = second % 60;
+        int length;
+        if (!wide) {
+            length = snprintf(line, sizeof(line),
+                              "10.%d.%d.%d - - [18/%s/2026:%02d:%02d:%02d +0800] \"GET %s HTTP/1.1\" %d %d \"-\" \"%s\"\n",
+                              i % 200, (i / 7) % 250, i % 251, kMonths[9], hour, minute, sec, kPaths[i % 7],
+                              kStatuses[i % 10], 100 + (i * 37) % 20000, kAgents[i % 3]);
+        } else {
+            int ms = (i * 13) % 900;
+            length = snprintf(line, sizeof(line),
+                              "10.%d.%d.%d - - [2026-10-18T%02d:%02d:%02d+08:00] \"%s %s HTTP/1.1\" %d %d "
+                              "\"https://www.example.com/\" \"%s\" \"-\" %s %d 0.%03d 0.%03d %d %d\n",
+                              i % 200, (i / 7) % 250, i % 251, hour, minute, sec, i % 9 ? "GET" : "POST",
+                              kPaths[i % 7], kStatuses[i % 10], 100 + (i * 37) % 20000, kAgents[i % 3],
+                              kHosts[i % 3], 300 + i % 700, ms, ms > 0 ? ms - 1 : 0, 1000 + i % 5000, 1 + i % 20);
+        }
+        text.append(line, (size_t)length);
+    }
+    return text;
+}
+
+// ---------------------------------------------------------------------------
+// 对照组：通用分词解析。按空白切分（"..." 与 [...] 视为一个词），每个词复制成 std::string，
+// 再按变量名查表取值，数字用 strtol / strtod，时间用 sscanf 拆分
+
+static int64_t DaysFromCivil(int64_t year, unsigned month, unsigned day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = (unsigned)(year - era * 400);
+    const unsigned doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void Tokenize(const char* p, const char* end, std::vector<std::string>* tokens) {
+    tokens->clear();
+    while (p < end) {
+        while (p < end && *p == ' ') ++p;
+        if (p >= end) break;
+        char close = *p == '"' ? '"' : *p == '[' ? ']' : ' ';
+        if (close != ' ') ++p;
+        const char* start = p;
+        while (p < end && *p != close) ++p;
+        tokens->push_back(std::string(start, (size_t)(p - start)));
+        if (p < end && close != ' ') ++p;
+    }
+}
+
+class GenericParser {
+public:
+    explicit GenericParser(const char* format) {
+        std::vector<std::string> tokens;
+        Tokenize(format, format + strlen(format), &tokens);
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            if (!tokens[i].empty() && tokens[i][0] == '$') m_index[tokens[i].substr(1)] = i;
+        }
+    }
+
+    bool Parse(const char* line, size_t length, AccessLogEntry* entry) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) --length;
+        Tokenize(line, line + length, &m_tokens);
+        *entry = AccessLogEntry();
+        m_method.clear();
+        m_uri.clear();
+        const std::string* value;
+        if ((value = Find("time_local"))) {
+            int day, year, hour, minute, second, zh, zm;
+            char month[4], sign;
+            if (sscanf(value->c_str(), "%d/%3s/%d:%d:%d:%d %c%2d%2d", &day, month, &year, &hour, &minute, &second,
+                       &sign, &zh, &zm) != 9) {
+                return false;
+            }
+            unsigned mon = 0;
+            while (mon < 12 && strcmp(kMonths[mon], month) != 0) ++mon;
+            if (mon == 12) return false;
+            int64_t offset = (zh * 3600 + zm * 60) * (sign == '-' ? -1 : 1);
+            entry->second = DaysFromCivil(year, mon + 1, (unsigned)day) * 86400 + hour * 3600 + minute * 60 + second -
+                            offset;
+        } else if ((value = Find("time_iso8601"))) {
+            int year, month, day, hour, minute, second, zh, zm;
+            char sign;
+            if (sscanf(value->c_str(), "%d-%d-%dT%d:%d:%d%c%d:%d", &year, &month, &day, &hour, &minute, &second,
+                       &sign, &zh, &zm) != 9) {
+                return false;
+            }
+            int64_t offset = (zh * 3600 + zm * 60) * (sign == '-' ? -1 : 1);
+            entry->second = DaysFromCivil(year, (unsigned)month, (unsigned)day) * 86400 + hour * 3600 + minute * 60 +
+                            second - offset;
+        }
+        if ((value = Find("request"))) {
+            size_t space = value->find(' ');
+            m_method = value->substr(0, space);
+            if (space != std::string::npos) {
+                size_t uriEnd = value->find_first_of(" ?", space + 1);
+                m_uri = value->substr(space + 1, uriEnd == std::string::npos ? std::string::npos : uriEnd - space - 1);
+            }
+            entry->method = m_method;
+            entry->uri = m_uri;
+        }
+        if ((value = Find("host"))) entry->host = *value;
+        if ((value = Find("status"))) entry->status = (int)strtol(value->c_str(), nullptr, 10);
+        if ((value = Find("body_bytes_sent"))) entry->bytes = strtoull(value->c_str(), nullptr, 10);
+        if ((value = Find("request_time"))) entry->requestMs = (uint32_t)llround(strtod(value->c_str(), nullptr) * 1000);
+        return true;
+    }
+
+private:
+    const std::string* Find(const char* name) const {
+        auto it = m_index.find(name);
+        if (it == m_index.end() || it->second >= m_tokens.size()) return nullptr;
+        return &m_tokens[it->second];
+    }
+
+    std::map<std::string, size_t> m_index;
+    std::vector<std::string> m_tokens;
+    std::string m_method;
+    std::string m_uri;
+};
+
+// ---------------------------------------------------------------------------
+
+static bool SameEntry(const AccessLogEntry& a, const AccessLogEntry& b) {
+    return a.second == b.second && a.method == b.method && a.uri == b.uri && a.host == b.host &&
+           a.status == b.status && a.bytes == b.bytes && a.requestMs == b.requestMs;
+}
+
+// 对整段文本逐行调用 parse，返回最佳一轮的微秒数；checksum 防止解析结果被优化掉
+template <typename Parse>
+static uint64_t Measure(const std::string& text, int rounds, Parse parse, uint64_t* checksum) {
+    uint64_t best = ~0ull;
+    for (int r = 0; r < rounds; ++r) {
+        uint64_t sum = 0;
+        uint64_t begin = MonotonicMicros();
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* newline = static_cast<const char*>(memchr(p, '\n', (size_t)(end - p)));
+            const char* lineEnd = newline ? newline + 1 : end;
+            AccessLogEntry entry;
+            if (parse(p, (size_t)(lineEnd - p), &entry)) {
+                sum += (uint64_t)entry.second + (uint64_t)entry.status + entry.bytes + entry.requestMs +
+                       entry.uri.size() + entry.host.size();
+            }
+            p = lineEnd;
+        }
+        uint64_t elapsed = MonotonicMicros() - begin;
+        if (elapsed < best) best = elapsed;
+        *checksum = sum;
+    }
+    return best;
+}
+
+static bool RunFormat(const char* title, const char* formatText, int lines, int rounds) {
+    LogFormat format;
+    std::string error;
+    if (!format.Compile(title, formatText, LOG_ESCAPE_DEFAULT, &error)) {
+        fprintf(stderr, "%s: %s\n", title, error.c_str());
+        return false;
+    }
+    std::string text = GenerateLog(lines, strcmp(title, "combined") != 0);
+    printf("%s (%d 行, %.1f MB)\n", title, lines, text.size() / 1048576.0);
+
+    // 核对：所有字段逐行一致
+    LogFormatParser compiled(format);
+    GenericParser generic(formatText);
+    int mismatched = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', (size_t)(end - p))) + 1;
+        AccessLogEntry a, b;
+        bool okA = compiled.Parse(p, (size_t)(lineEnd - p), &a);
+        bool okB = generic.Parse(p, (size_t)(lineEnd - p), &b);
+        if (okA != okB || !SameEntry(a, b)) {
+            if (mismatched++ == 0) fprintf(stderr, "    ✗ 结果不一致: %.*s", (int)(lineEnd - p), p);
+        }
+        p = lineEnd;
+    }
+
+    uint64_t checksum = 0;
+    auto report = [&](const char* name, uint64_t micros, double baseline) {
+        double rate = lines / (micros / 1e6);
+        printf("    %-24s %8.2f M 行/秒  %7.0f MB/秒", name, rate / 1e6, text.size() / (micros / 1e6) / 1048576.0);
+        if (baseline > 0) printf("  (通用分词的 %.1f 倍)", rate / baseline);
+        printf("\n");
+        return rate;
+    };
+    uint64_t genericMicros = Measure(text, rounds, [&](const char* line, size_t length, AccessLogEntry* entry) {
+        return generic.Parse(line, length, entry);
+    }, &checksum);
+    double baseline = report("通用分词", genericMicros, 0);
+    uint64_t allMicros = Measure(text, rounds, [&](const char* line, size_t length, AccessLogEntry* entry) {
+        return compiled.Parse(line, length, entry);
+    }, &checksum);
+    report("编译解析（全部字段）", allMicros, baseline);
+    // 滚动统计只需要时间、状态码与字节数
+    LogFormatParser partial(format, LOG_FIELD_TIME | LOG_FIELD_STATUS | LOG_FIELD_BYTES);
+    uint64_t partialMicros = Measure(text, rounds, [&](const char* line, size_t length, AccessLogEntry* entry) {
+        return partial.Parse(line, length, entry);
+    }, &checksum);
+    report("编译解析（时间/状态/字节）", partialMicros, baseline);
+    printf("    结果核对: %s (校验和 %llu)\n\n", mismatched ? "✗ 不一致" : "一致", (unsigned long long)checksum);
+    return mismatched == 0;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    int lines = argc > 1 ? atoi(argv[1]) : 1000000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 5;
+    if (lines <= 0 || rounds <= 0) {
+        fprintf(stderr, "用法: bench_log_format [行数] [轮数]\n");
+        return 1;
+    }
+    bool ok = RunFormat("combined", kCombined, lines, rounds);
+    ok = RunFormat("wide", kWide, lines, rounds) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+// nginx-manager/bench/bench_log_rotator.cpp
+// 基准 - 日志轮转：LZ4 帧压缩的吞吐与压缩率，以及持续写入时轮转对写入方的影响（最长写入间隔、是否丢行）
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_log_rotator.cpp ../src/log_rotator.cpp ../src/lz4_frame.cpp ../src/nginx_conf.cpp ../src/log_format.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_log_rotator.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_log_rotator.cpp ../src/log_rotator.cpp ../src/lz4_frame.cpp ../src/nginx_conf.cpp ../src/log_format.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_log_rotator
+//
+// 用法: bench_log_rotator [压缩限速 MB/s，默认 0 不限]
+// 第二部分在当前目录下创建 bench_rotate/logs，由一个线程模拟 nginx worker 持续逐行写入 access.log，
+// 收到重新打开通知后像 nginx 一样关闭旧文件、打开新文件；结束后解压全部归档，检查序号是否连续。
+
+#include "log_rotator.h"
+#include "lz4_frame.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char* kDirectory = "bench_rotate";
+static const char* kLogDirectory = "bench_rotate/logs";
+static const char* kLogPath = "bench_rotate/logs/access.log";
+
+// 模拟 combined 格式的访问日志
+static std::string MakeLine(uint64_t sequence, uint32_t seed) {
+    static const char* const kPaths[] = { "/", "/api/v1/items", "/static/app.js", "/login", "/api/v1/orders" };
+    static const int kStatus[] = { 200, 200, 200, 304, 404, 502 };
+    char line[320];
+    snprintf(line, sizeof(line),
+             "10.%u.%u.%u - - [18/Oct/2026:12:%02u:%02u +0800] \"GET %s/%llu HTTP/1.1\" %d %u \"-\" "
+             "\"Mozilla/5.0 (X11; Linux x86_64) bench/1.0\"\n",
+             seed % 256, (seed >> 8) % 256, (seed >> 16) % 256, (seed >> 3) % 60, (seed >> 9) % 60,
+             kPaths[seed % 5], (unsigned long long)sequence, kStatus[(seed >> 5) % 6], seed % 20000);
+    return line;
+}
+
+static void MakeDirectory(const char* path) {
+#ifdef _WIN32
+    CreateDirectoryW(Utf8ToWide(path).c_str(), NULL);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+// 与 nginx 相同的打开方式：追加写入，Windows 上允许其他进程改名 / 删除
+class AppendFile {
+public:
+    ~AppendFile() { Close(); }
+
+    bool Open(const char* path) {
+#ifdef _WIN32
+        m_file = CreateFileW(Utf8ToWide(path).c_str(), FILE_APPEND_DATA,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, NULL);
+        return m_file != INVALID_HANDLE_VALUE;
+#else
+        m_fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+        return m_fd >= 0;
+#endif
+    }
+
+    void Write(const std::string& text) {
+#ifdef _WIN32
+        DWORD written = 0;
+        WriteFile(m_file, text.data(), (DWORD)text.size(), &written, NULL);
+#else
+        if (write(m_fd, text.data(), text.size()) < 0) perror("write");
+#endif
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_fd >= 0) close(m_fd);
+        m_fd = -1;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+static bool ReadWhole(const std::string& path, std::string* text) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    char buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) text->append(buffer, count);
+    fclose(file);
+    return true;
+}
+
+// 1. 压缩吞吐与压缩率
+static void BenchEncoder() {
+    std::string input;
+    uint32_t seed = 12345;
+    for (uint64_t i = 0; input.size() < (64u << 20); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        input += MakeLine(i, seed);
+    }
+
+    Lz4FrameEncoder* encoder = new Lz4FrameEncoder();
+    std::vector<uint8_t> block(Lz4FrameEncoder::kMaxBlockOutput);
+    std::string frame;
+    frame.reserve(input.size() / 2);
+    uint64_t begin = MonotonicMicros();
+    frame.append((const char*)block.data(), encoder->Header(block.data()));
+    for (size_t offset = 0; offset < input.size(); offset += Lz4FrameEncoder::kBlockSize) {
+        size_t size = std::min(input.size() - offset, Lz4FrameEncoder::kBlockSize);
+        size_t encoded = encoder->EncodeBlock((const uint8_t*)input.data() + offset, size, block.data());
+        frame.append((const char*)block.data(), encoded);
+    }
+    frame.append((const char*)block.data(), encoder->Trailer(block.data()));
+    uint64_t encodeMicros = MonotonicMicros() - begin;
+    delete encoder;
+
+    std::string decoded;
+    std::string error;
+    begin = MonotonicMicros();
+    bool ok = Lz4DecodeFrame((const uint8_t*)frame.data(), frame.size(), &decoded, &error);
+    uint64_t decodeMicros = MonotonicMicros() - begin;
+
+    printf("LZ4 帧压缩: %.1f MB → %.1f MB (%.1f%%), 压缩 %.0f MB/s, 解压校验 %.0f MB/s, 往返%s\n",
+           input.size() / 1048576.0, frame.size() / 1048576.0, frame.size() * 100.0 / input.size(),
+           input.size() / 1048576.0 / (encodeMicros / 1e6), input.size() / 1048576.0 / (decodeMicros / 1e6),
+           ok && decoded == input ? "一致" : ("不一致 " + error).c_str());
+}
+
+// 2. 持续写入时轮转
+static void BenchRotation(uint64_t compressBytesPerSec) {
+    MakeDirectory(kDirectory);
+    MakeDirectory(kLogDirectory);
+
+    std::atomic<bool> reopen(false);
+    std::atomic<bool> stop(false);
+    std::atomic<uint64_t> written(0);
+    uint64_t maxGapMicros = 0;
+
+    std::thread writer([&]() {
+        AppendFile file;
+        file.Open(kLogPath);
+        uint32_t seed = 777;
+        uint64_t last = MonotonicMicros();
+        for (uint64_t sequence = 0; !stop; ++sequence) {
+            if (reopen.exchange(false)) {
+                file.Close();
+                file.Open(kLogPath);
+            }
+            seed = seed * 1103515245u + 12345u;
+            file.Write(MakeLine(sequence, seed));
+            written = sequence + 1;
+            uint64_t now = MonotonicMicros();
+            maxGapMicros = std::max(maxGapMicros, now - last);
+            last = now;
+            // 约每秒 2 万行
+            if (sequence % 20 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    LogRotationPolicy policy;
+    policy.maxBytes = 4u << 20;
+    policy.keepFiles = 0;
+    policy.compressBytesPerSec = compressBytesPerSec;
+    policy.checkIntervalMs = 100;
+    policy.settleMs = 300;
+    LogRotator rotator;
+    std::vector<uint64_t> rotateMicros;
+    std::vector<std::string> archives;      // 事件中得到的归档，压缩后换成 .lz4
+    std::mutex eventMutex;
+    rotator.SetHandlers(
+        [&](std::string*) {
+            reopen = true;
+            return true;
+        },
+        [&](const LogRotationEvent& event) {
+            std::lock_guard<std::mutex> lock(eventMutex);
+            if (event.type == LOG_ROTATED) {
+                rotateMicros.push_back(event.micros);
+                archives.push_back(event.archive);
+            } else if (event.type == LOG_COMPRESSED) {
+                std::string raw = event.archive.substr(0, event.archive.size() - 4);
+                std::replace(archives.begin(), archives.end(), raw, event.archive);
+            } else if (event.type == LOG_ROTATE_FAILED || event.type == LOG_COMPRESS_FAILED) {
+                printf("  %s\n", FormatLogRotationEvent(event).c_str());
+            }
+        });
+    rotator.SetPolicy(policy);
+    rotator.Start(kDirectory, std::string(kDirectory) + "/conf/nginx.conf");
+
+    std::this_thread::sleep_for(std::chrono::seconds(10));
+    stop = true;
+    writer.join();
+    // 等待剩余归档压缩完成
+    for (int i = 0; i < 100 && rotator.Stats().pending > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    LogRotationStats stats = rotator.Stats();
+    rotator.Stop();
+
+    uint64_t slowest = 0;
+    for (uint64_t micros : rotateMicros) slowest = std::max(slowest, micros);
+    printf("持续写入 10 秒: 写入 %llu 行, 轮转 %llu 次 (改名并通知最长 %.2f ms), 写入方最长间隔 %.2f ms\n",
+           (unsigned long long)written.load(), (unsigned long long)stats.rotations, slowest / 1000.0,
+           maxGapMicros / 1000.0);
+    printf("后台压缩: %llu 个归档, %.1f MB → %.1f MB, %.1f MB/s (限速 %s), 剩余 %u 个\n",
+           (unsigned long long)stats.compressed, stats.bytesIn / 1048576.0, stats.bytesOut / 1048576.0,
+           stats.compressMicros > 0 ? stats.bytesIn / 1048576.0 / (stats.compressMicros / 1e6) : 0.0,
+           compressBytesPerSec ? (std::to_string(compressBytesPerSec >> 20) + " MB/s").c_str() : "无",
+           stats.pending);
+
+    // 解压全部归档并与当前文件拼接，按序号检查丢行与重复
+    std::vector<char> seen(written.load(), 0);
+    uint64_t lines = 0;
+    uint64_t duplicates = 0;
+    std::vector<std::string> paths = archives;
+    paths.push_back(kLogPath);
+    for (const std::string& path : paths) {
+        std::string raw;
+        if (!ReadWhole(path, &raw)) {
+            printf("  无法读取 %s\n", path.c_str());
+            continue;
+        }
+        std::string text;
+        std::string error;
+        if (path.size() > 4 && path.compare(path.size() - 4, 4, ".lz4") == 0) {
+            if (!Lz4DecodeFrame((const uint8_t*)raw.data(), raw.size(), &text, &error)) {
+                printf("  %s: %s\n", path.c_str(), error.c_str());
+                continue;
+            }
+        } else {
+            text.swap(raw);
+        }
+        for (size_t pos = text.find("HTTP/1.1"); pos != std::string::npos; pos = text.find("HTTP/1.1", pos + 8)) {
+            size_t slash = text.rfind('/', pos);
+            uint64_t sequence = strtoull(text.c_str() + slash + 1, nullptr, 10);
+            ++lines;
+            if (sequence < seen.size()) {
+                if (seen[sequence]) ++duplicates;
+                seen[sequence] = 1;
+            }
+        }
+        remove(path.c_str());
+    }
+    uint64_t missing = (uint64_t)std::count(seen.begin(), seen.end(), 0);
+    printf("校验: %zu 个文件, %llu 行, 丢失 %llu 行, 重复 %llu 行\n", paths.size(), (unsigned long long)lines,
+           (unsigned long long)missing, (unsigned long long)duplicates);
+}
+
+int main(int argc, char** argv) {
+    uint64_t compressBytesPerSec = argc > 1 ? strtoull(argv[1], nullptr, 10) << 20 : 0;
+    BenchEncoder();
+    BenchRotation(compressBytesPerSec);
+    return 0;
+}
@@ -0,0 +1,241 @@
+// nginx-manager/bench/bench_log_store.cpp
+// 基准 - 访问日志列存：导入速度（明文与 .lz4 归档）、压缩比，聚合查询的扫描速度与分段区间索引的排除效果，并核对查询结果
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_log_store.cpp ../src/log_store.cpp ../src/log_format.cpp ../src/log_model.cpp ../src/log_rotator.cpp ../src/lz4_frame.cpp ../src/nginx_conf.cpp ../src/line_scan.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_log_store.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_log_store.cpp ../src/log_store.cpp ../src/log_format.cpp ../src/log_model.cpp ../src/log_rotator.cpp ../src/lz4_frame.cpp ../src/nginx_conf.cpp ../src/line_scan.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_log_store
+//
+// 用法: bench_log_store [总行数（百万），默认 16] [查询线程数，默认硬件线程数]
+// 在当前目录下创建 bench_store/，每次生成 100 万行 main 格式（末尾带 $request_time）的日志，一半写成 .lz4 归档，
+// 导入后删除原文；日志时间均匀分布在一天内。结束后删除整个目录。
+
+#include "log_rotator.h"
+#include "log_store.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+static const char* kDirectory = "bench_store";
+static const char* kStoreDirectory = "bench_store/store";
+
+static const char* kMainFormat =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent "
+    "\"$http_referer\" \"$http_user_agent\" $request_time";
+
+static const uint32_t kLinesPerFile = 1000000;
+static const int64_t kBaseSecond = 1792195200;     // 2026-10-16 16:00:00 UTC，日志中写作 +0800 的 17/Oct 00:00:00
+
+static void MakeDirectory(const char* path) {
+#ifdef _WIN32
+    CreateDirectoryW(Utf8ToWide(path).c_str(), NULL);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+static uint64_t g_seed = 88172645463325252ull;
+
+static uint64_t NextRandom() {
+    g_seed ^= g_seed << 13;
+    g_seed ^= g_seed >> 7;
+    g_seed ^= g_seed << 17;
+    return g_seed;
+}
+
+// 生成过程中累计的期望值，用于核对查询结果
+struct Expected {
+    uint64_t rows = 0;
+    uint64_t server5xx = 0;
+    uint64_t checkout = 0;           // POST /api/checkout
+    uint64_t lastHour = 0;           // 最后一小时
+};
+
+// 路径：少量热点路径占大部分请求，其余为带 ID 的长尾
+static std::string MakeUri(uint64_t random) {
+    static const char* const kHot[] = { "/", "/index.html", "/api/v1/items", "/api/v1/orders", "/static/app.js",
+                                        "/static/app.css", "/login", "/api/checkout" };
+    if (random % 10 < 7) return kHot[(random >> 8) % 8];
+    return "/item/" + std::to_string((random >> 8) % 50000);
+}
+
+// 生成一个日志文件，行时间从 first 秒开始递增，覆盖 seconds 秒
+static bool WriteLog(const std::string& path, uint64_t index, uint32_t lines, int64_t first, int64_t seconds,
+                     int64_t dayEnd, Expected* expected) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    static const char* const kMonths[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct",
+                                           "Nov", "Dec" };
+    std::string buffer;
+    for (uint32_t i = 0; i < lines; ++i) {
+        int64_t second = first + seconds * i / lines;
+        time_t local = (time_t)(second + 8 * 3600);
+        struct tm parts;
+#ifdef _WIN32
+        gmtime_s(&parts, &local);
+#else
+        gmtime_r(&local, &parts);
+#endif
+        uint64_t random = NextRandom();
+        std::string uri = MakeUri(random);
+        const char* method = random % 100 < 85 ? "GET" : random % 100 < 97 ? "POST" : "HEAD";
+        uint32_t roll = (uint32_t)((random >> 20) % 1000);
+        int status = roll < 900 ? 200 : roll < 950 ? 304 : roll < 985 ? 404 : roll < 995 ? 500 : 502;
+        // 耗时：大多在几十毫秒内，少量慢请求
+        uint32_t ms = (uint32_t)((random >> 32) % 40) + ((random >> 40) % 100 == 0 ? (uint32_t)((random >> 48) % 3000) : 0);
+        char line[512];
+        int length = snprintf(line, sizeof(line),
+                              "10.%u.%u.%u - - [%02d/%s/%04d:%02d:%02d:%02d +0800] \"%s %s?page=%u HTTP/1.1\" %d %u "
+                              "\"-\" \"Mozilla/5.0 (X11; Linux x86_64) bench/1.0\" %u.%03u\n",
+                              (unsigned)(index % 256), (unsigned)(random % 256), (unsigned)((random >> 8) % 256),
+                              parts.tm_mday, kMonths[parts.tm_mon], parts.tm_year + 1900, parts.tm_hour, parts.tm_min,
+                              parts.tm_sec, method, uri.c_str(), (unsigned)(random % 10), status,
+                              (unsigned)((random >> 12) % 60000), ms / 1000, ms % 1000);
+        buffer.append(line, (size_t)length);
+        ++expected->rows;
+        if (status >= 500) ++expected->server5xx;
+        if (uri == "/api/checkout" && strcmp(method, "POST") == 0) ++expected->checkout;
+        if (second >= dayEnd - 3600) ++expected->lastHour;
+        if (buffer.size() >= (1 << 20)) {
+            fwrite(buffer.data(), 1, buffer.size(), file);
+            buffer.clear();
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), file);
+    fclose(file);
+    return true;
+}
+
+static void RemoveDirectory(const std::string& directory) {
+#ifdef _WIN32
+    std::string command = "rmdir /s /q " + directory;
+#else
+    std::string command = "rm -rf " + directory;
+#endif
+    if (system(command.c_str()) != 0) fprintf(stderr, "无法删除 %s\n", directory.c_str());
+}
+
+// 运行一个查询并打印结果；returns 匹配行数
+static uint64_t RunQuery(LogStore& store, const char* title, const std::string& text, uint32_t threads,
+                         int64_t now, bool print) {
+    LogQuery query;
+    std::string error;
+    if (!ParseLogQueryText(text, now, &query, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 0;
+    }
+    query.threads = threads;
+    LogQueryResult result = store.Query(query);
+    printf("%s  [%s]\n", title, text.c_str());
+    std::string table = FormatLogQueryResult(query, result);
+    if (!print) table = table.substr(0, table.find('\n') + 1);
+    printf("%s", table.c_str());
+    if (!result.error.empty()) printf("    ✗ %s\n", result.error.c_str());
+    return result.matchedRows;
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    uint32_t millions = argc > 1 ? (uint32_t)atoi(argv[1]) : 16;
+    uint32_t threads = argc > 2 ? (uint32_t)atoi(argv[2]) : 0;
+    if (millions == 0) {
+        fprintf(stderr, "总行数至少为 1 百万\n");
+        return 1;
+    }
+    RemoveDirectory(kDirectory);
+    MakeDirectory(kDirectory);
+
+    // 1. 导入：每个文件覆盖一天中相邻的一段
+    LogFormat format;
+    std::string formatError;
+    if (!format.Compile("main", kMainFormat, LOG_ESCAPE_DEFAULT, &formatError)) {
+        fprintf(stderr, "%s\n", formatError.c_str());
+        return 1;
+    }
+    LogStore store(kStoreDirectory);
+    Expected expected;
+    LogIngestStats plain, compressed;
+    uint64_t compressedBytes = 0;
+    const int64_t dayEnd = kBaseSecond + 86400;
+    for (uint32_t i = 0; i < millions; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s/access.log.20261017-%06u", kDirectory, i);
+        std::string path = name;
+        int64_t first = kBaseSecond + 86400LL * i / millions;
+        int64_t span = 86400LL * (i + 1) / millions - 86400LL * i / millions;
+        if (!WriteLog(path, i, kLinesPerFile, first, span, dayEnd, &expected)) {
+            fprintf(stderr, "无法写入 %s\n", path.c_str());
+            return 1;
+        }
+        bool lz4 = i % 2 == 1;
+        std::string error;
+        if (lz4) {
+            uint64_t in = 0, out = 0;
+            if (!CompressFileLz4(path, path + ".lz4", 0, nullptr, &in, &out, &error)) {
+                fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+            remove(path.c_str());
+            path += ".lz4";
+            compressedBytes += out;
+        }
+        if (!store.IngestFile(path, format, lz4 ? &compressed : &plain, nullptr)) {
+            fprintf(stderr, "导入失败: %s\n", (lz4 ? compressed : plain).error.c_str());
+            return 1;
+        }
+        remove(path.c_str());
+    }
+    auto report = [](const char* title, const LogIngestStats& stats) {
+        double seconds = stats.micros / 1e6;
+        printf("    %-10s %8.2f M 行/秒  %7.1f MB/秒  (%llu 行, %u 段)\n", title,
+               seconds > 0 ? stats.lines / seconds / 1e6 : 0.0, seconds > 0 ? stats.inputBytes / seconds / 1048576.0 : 0.0,
+               (unsigned long long)stats.rows, stats.segments);
+    };
+    LogStoreInfo info = store.Info();
+    uint64_t inputBytes = plain.inputBytes + compressed.inputBytes;
+    printf("导入 %u M 行 (日志原文 %.1f MB)\n", millions, inputBytes / 1048576.0);
+    report("明文", plain);
+    report(".lz4", compressed);
+    printf("    列存 %.1f MB = 原文的 %.1f%% (%.1f 字节/行)；同样内容的 .lz4 约 %.1f%%\n", info.bytes / 1048576.0,
+           info.bytes * 100.0 / inputBytes, (double)info.bytes / info.rows,
+           compressed.inputBytes ? compressedBytes * 100.0 / compressed.inputBytes : 0.0);
+
+    // 2. 查询：单线程与多线程的扫描速度，区间索引对窄时间范围的排除
+    int64_t now = dayEnd;
+    uint32_t hardware = std::thread::hardware_concurrency();
+    printf("\n");
+    bool ok = true;
+    ok = RunQuery(store, "合计 (1 线程)", "group=none", 1, now, true) == expected.rows && ok;
+    ok = RunQuery(store, "合计", "group=none", threads, now, false) == expected.rows && ok;
+    ok = RunQuery(store, "路径 Top 10 按 p99", "group=uri order=p99 limit=10", threads, now, true) == expected.rows && ok;
+    ok = RunQuery(store, "5xx 按路径", "status=5xx group=uri limit=5", threads, now, true) == expected.server5xx && ok;
+    ok = RunQuery(store, "POST /api/checkout 按状态码", "method=POST uri=/api/checkout group=status", threads, now,
+                  true) == expected.checkout && ok;
+    ok = RunQuery(store, "最后一小时按分钟", "from=-1h group=minute limit=5", threads, now, true) == expected.lastHour && ok;
+    ok = RunQuery(store, "按小时", "group=hour limit=3", threads, now, false) == expected.rows && ok;
+
+    // 每天 5 亿行的估算：以单线程合计查询的扫描速度外推
+    LogQuery query;
+    query.groupBy = LOG_GROUP_URI;
+    query.threads = 1;
+    LogQueryResult single = store.Query(query);
+    query.threads = threads;
+    LogQueryResult parallel = store.Query(query);
+    double singleRate = single.micros ? single.scannedRows / (single.micros / 1e6) : 0;
+    double parallelRate = parallel.micros ? parallel.scannedRows / (parallel.micros / 1e6) : 0;
+    printf("\n按路径分组的全量扫描: 1 线程 %.1f M 行/秒, %u 线程 %.1f M 行/秒 (硬件线程 %u)\n", singleRate / 1e6,
+           parallel.threads, parallelRate / 1e6, hardware);
+    if (parallelRate > 0) printf("    5 亿行（一天）估计 %.1f 秒\n", 5e8 / parallelRate);
+
+    printf("\n查询结果核对: %s\n", ok ? "一致" : "✗ 不一致");
+    RemoveDirectory(kDirectory);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+// nginx-manager/bench/bench_nginx_conf.cpp
+// 基准 - 解析合成的 10 万 server 配置（数百个 include 文件）
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_nginx_conf.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_nginx_conf.exe
+// 编译 (Linux):  g++ -O2 -I../src bench_nginx_conf.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_nginx_conf
+
+#include "nginx_conf.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef _WIN32
+#define MKDIR(path) CreateDirectoryW(Utf8ToWide(path).c_str(), NULL)
+#else
+#include <sys/stat.h>
+#define MKDIR(path) mkdir((path).c_str(), 0755)
+#endif
+
+// 生成 main 配置 + files 个 include 文件，共 servers 个 server 块
+static void GenerateConfig(const std::string& dir, int servers, int files) {
+    MKDIR(dir);
+    MKDIR(dir + "/sites");
+
+    FILE* main = fopen((dir + "/nginx.conf").c_str(), "wb");
+    fprintf(main,
+            "worker_processes auto;\n"
+            "pid logs/nginx.pid;\n"
+            "events { worker_connections 1024; }\n"
+            "http {\n"
+            "    include sites/*.conf;\n"
+            "}\n");
+    fclose(main);
+
+    int perFile = (servers + files - 1) / files;
+    int index = 0;
+    for (int f = 0; f < files; ++f) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/sites/site-%04d.conf", dir.c_str(), f);
+        FILE* out = fopen(path, "wb");
+        for (int i = 0; i < perFile && index < servers; ++i, ++index) {
+            fprintf(out,
+                    "server {\n"
+                    "    listen %d;\n"
+                    "    server_name host%d.example.com www.host%d.example.com;\n"
+                    "    access_log logs/host%d.access.log main;\n"
+                    "    location / {\n"
+                    "        proxy_pass http://127.0.0.1:%d;\n"
+                    "        proxy_set_header Host \"$host\";  # 注释\n"
+                    "    }\n"
+                    "}\n",
+                    8000 + index % 100, index, index, index, 9000 + index % 50);
+        }
+        fclose(out);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string dir = argc > 1 ? argv[1] : "bench-conf";
+    int servers = argc > 2 ? atoi(argv[2]) : 100000;
+    int files = argc > 3 ? atoi(argv[3]) : 200;
+    int rounds = argc > 4 ? atoi(argv[4]) : 5;
+
+    GenerateConfig(dir, servers, files);
+
+    uint64_t best = ~0ull;
+    NginxConfig config;
+    for (int r = 0; r < rounds; ++r) {
+        std::string error;
+        uint64_t begin = MonotonicMicros();
+        if (!config.Load(dir + "/nginx.conf", &error)) {
+            printf("解析失败: %s\n", error.c_str());
+            return 1;
+        }
+        uint64_t elapsed = MonotonicMicros() - begin;
+        if (elapsed < best) best = elapsed;
+    }
+
+    double mb = config.TotalBytes() / (1024.0 * 1024.0);
+    printf("文件 %zu 个, %.1f MB, 指令 %zu 条, server %zu 个\n", config.Files().size(), mb,
+           config.Directives().size(), config.FindByName("server").size());
+    printf("最佳解析耗时 %.1f ms (%.0f MB/s)\n", best / 1000.0, mb / (best / 1e6));
+
+    // 索引查询
+    const int lookups = 1000000;
+    uint64_t begin = MonotonicMicros();
+    size_t hits = 0;
+    for (int i = 0; i < lookups; ++i) {
+        char name[64];
+        snprintf(name, sizeof(name), "host%d.example.com", i % servers);
+        hits += config.ServersByName(name).size();
+    }
+    uint64_t elapsed = MonotonicMicros() - begin;
+    printf("server_name 查询 %d 次, 命中 %zu, 平均 %.3f us\n", lookups, hits, (double)elapsed / lookups);
+    printf("端口 8000 上的 server: %zu 个\n", config.ServersByPort(8000).size());
+    return 0;
+}
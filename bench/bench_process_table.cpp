@@ -0,0 +1,121 @@
+// nginx-manager/bench/bench_process_table.cpp
+// 微基准 - ProcessTable 与旧的 tasklist | findstr 探测方式对比，以及从 nginx 改写后的进程标题中取出 -p 前缀
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_process_table.cpp ../src/process_table.cpp ../src/nginx_control.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_process_table.exe
+// 编译 (Linux):  g++ -O2 -I../src bench_process_table.cpp ../src/process_table.cpp ../src/nginx_control.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_process_table
+
+#include "process_table.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// 旧实现：通过 shell 管道查找 nginx 进程
+static bool LegacyProbe() {
+#ifdef _WIN32
+    STARTUPINFOW si = {};
+    PROCESS_INFORMATION pi = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+
+    wchar_t cmdLine[] = L"cmd /c tasklist | findstr /i nginx.exe";
+    if (!CreateProcessW(NULL, cmdLine, NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+        return false;
+    }
+    WaitForSingleObject(pi.hProcess, 5000);
+    DWORD exitCode = 1;
+    GetExitCodeProcess(pi.hProcess, &exitCode);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+    return exitCode == 0;
+#else
+    int status = system("ps -e | grep -q nginx");
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+// 各种形式的 cmdline 中取出的 -p 前缀
+static bool CheckPrefixArgument() {
+    struct Case {
+        const char* data;
+        size_t length;
+        const char* expected;            // NULL 表示没有 -p
+    };
+    // 运行中的 master：整个标题是第一个字段，其后以 '\0' 填充
+    static const char kTitle[] = "nginx: master process /usr/sbin/nginx -p /srv/a -c conf/nginx.conf\0\0\0\0";
+    static const char kAttached[] = "nginx: master process /usr/sbin/nginx -p/srv/b\0\0";
+    static const char kWorker[] = "nginx: worker process\0\0\0\0\0\0\0\0\0";
+    static const char kArgv[] = "/usr/sbin/nginx\0-p\0/srv/c\0-g\0daemon off;";
+    static const char kNoPrefix[] = "/usr/sbin/nginx\0-c\0/etc/nginx/nginx.conf";
+    const Case cases[] = {
+        { kTitle, sizeof(kTitle) - 1, "/srv/a" },
+        { kAttached, sizeof(kAttached) - 1, "/srv/b" },
+        { kWorker, sizeof(kWorker) - 1, NULL },
+        { kArgv, sizeof(kArgv), "/srv/c" },
+        { kNoPrefix, sizeof(kNoPrefix), NULL },
+    };
+    bool ok = true;
+    for (const Case& c : cases) {
+        std::string prefix;
+        bool found = FindPrefixArgument(c.data, c.length, &prefix);
+        bool pass = c.expected ? (found && prefix == c.expected) : !found;
+        printf("%-4s %-48.48s -> %s\n", pass ? "ok" : "FAIL", c.data, found ? prefix.c_str() : "(无 -p)");
+        ok = ok && pass;
+    }
+
+#ifndef _WIN32
+    // 真实进程：argv 只有一个以空格连接的标题，与 nginx master 改写后的 /proc/<pid>/cmdline 相同
+    pid_t child = fork();
+    if (child == 0) {
+        execl("/bin/sleep", "nginx: master process /usr/sbin/nginx -p /srv/fixture -c conf/nginx.conf",
+              "5", (char*)NULL);
+        _exit(127);
+    }
+    if (child > 0) {
+        usleep(50000);
+        std::string prefix;
+        bool found = ResolveProcessPrefix((ProcessId)child, &prefix);
+        bool pass = found && prefix == "/srv/fixture";
+        printf("%-4s 进程 %d 的标题 -> %s\n", pass ? "ok" : "FAIL", (int)child, found ? prefix.c_str() : "(未解析)");
+        ok = ok && pass;
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+    }
+#endif
+    printf("\n");
+    return ok;
+}
+
+template <typename Fn>
+static void Measure(const char* name, int iterations, Fn fn) {
+    bool result = false;
+    uint64_t begin = MonotonicMicros();
+    for (int i = 0; i < iterations; ++i) {
+        result = fn();
+    }
+    uint64_t elapsed = MonotonicMicros() - begin;
+    printf("%-28s %8d 次  平均 %12.3f us  (running=%d)\n",
+           name, iterations, (double)elapsed / iterations, result ? 1 : 0);
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 100000;
+    int legacyIterations = argc > 2 ? atoi(argv[2]) : 20;
+
+    bool prefixOk = CheckPrefixArgument();
+
+    ProcessTable table;
+    table.Refresh();
+    printf("master=%u workers=%zu\n\n", table.MasterPid(), table.WorkerPids().size());
+
+    Measure("ProcessTable::IsRunning", iterations, [&]() { return table.IsRunning(); });
+    Measure("ProcessTable::Refresh", iterations / 100 + 1, [&]() { return table.Refresh(); });
+    Measure("tasklist | findstr (旧)", legacyIterations, []() { return LegacyProbe(); });
+    return prefixOk ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+// nginx-manager/bench/bench_service.cpp
+// 基准 - 服务控制：对真实的 nginx 安装目录反复启动 / 重新加载 / 停止，统计各操作的就绪耗时与总耗时
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_service.cpp ../src/nginx_service.cpp ../src/nginx_control.cpp ../src/process_table.cpp ../src/readiness.cpp ../src/op_queue.cpp ../src/config_cache.cpp ../src/nginx_conf.cpp ../src/content_hash.cpp ../src/socket_util.cpp ../src/cpu_topology.cpp ../src/conf_edit.cpp ../src/file_util.cpp ../src/trace.cpp -lws2_32 -o bench_service.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_service.cpp ../src/nginx_service.cpp ../src/nginx_control.cpp ../src/process_table.cpp ../src/readiness.cpp ../src/op_queue.cpp ../src/config_cache.cpp ../src/nginx_conf.cpp ../src/content_hash.cpp ../src/socket_util.cpp ../src/cpu_topology.cpp ../src/conf_edit.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_service
+// 或使用 CMake:  cmake -S . -B build -DNGINX_MANAGER_BENCH=ON && cmake --build build --target bench_service
+//
+// 用法: bench_service <nginx 安装目录> [轮数，默认 20]
+// 两个平台走同一套 NginxService 流程（图形界面、无界面模式与 ngctl 也是），测得的耗时可以直接对比。
+// 就绪耗时是 ServiceOutcome::latencyMicros（启动到 pid 文件写入且端口可连接、停止到进程全部退出、
+// 重新加载到新一代 worker 接管），总耗时另含配置校验（内容未变时命中缓存）与进程表扫描。
+
+#include "nginx_service.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 一种操作的耗时样本（微秒）
+struct Samples {
+    explicit Samples(const char* label) : name(label) {}
+
+    const char* name;
+    std::vector<uint64_t> latency;
+    std::vector<uint64_t> total;
+    size_t failures = 0;
+};
+
+static uint64_t Percentile(std::vector<uint64_t> values, double percentile) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    size_t index = (size_t)(percentile / 100.0 * (values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static void Measure(Samples* samples, const std::function<ServiceOutcome()>& operation) {
+    uint64_t begin = MonotonicMicros();
+    ServiceOutcome outcome = operation();
+    uint64_t total = MonotonicMicros() - begin;
+    if (!outcome.ok || !outcome.changed) {
+        ++samples->failures;
+        fprintf(stderr, "%s 失败: %s\n", samples->name, outcome.detail.c_str());
+        return;
+    }
+    samples->latency.push_back(outcome.latencyMicros);
+    samples->total.push_back(total);
+}
+
+static void Print(const Samples& samples) {
+    printf("%-8s 成功 %zu 次, 失败 %zu 次\n", samples.name, samples.latency.size(), samples.failures);
+    if (samples.latency.empty()) return;
+    printf("    就绪耗时 p50 %7.2f ms  p90 %7.2f ms  max %7.2f ms\n", Percentile(samples.latency, 50) / 1000.0,
+           Percentile(samples.latency, 90) / 1000.0, Percentile(samples.latency, 100) / 1000.0);
+    printf("    总耗时   p50 %7.2f ms  p90 %7.2f ms  max %7.2f ms\n", Percentile(samples.total, 50) / 1000.0,
+           Percentile(samples.total, 90) / 1000.0, Percentile(samples.total, 100) / 1000.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "用法: bench_service <nginx 安装目录> [轮数，默认 20]\n");
+        return 1;
+    }
+    int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+    NginxService service(argv[1]);
+    bool verbose = getenv("BENCH_VERBOSE") != NULL;
+    service.SetLogSink([verbose](LogSeverity severity, const std::string& text) {
+        if (verbose || severity == LOG_ERROR) fprintf(stderr, "  %s\n", text.c_str());
+    });
+
+    // 不经过操作队列，直接在本线程中执行，永不取消
+    OperationContext context(0, 0, std::make_shared<std::atomic<bool>>(false));
+    if (service.IsRunning()) {
+        fprintf(stderr, "%s 下的 nginx 正在运行，先停止\n", argv[1]);
+        if (!service.Stop(context).ok) return 1;
+    }
+
+    Samples start("启动");
+    Samples reload("重新加载");
+    Samples stop("停止");
+    for (int i = 0; i < rounds; ++i) {
+        Measure(&start, [&]() { return service.Start(context); });
+        if (!service.IsRunning()) continue;
+        Measure(&reload, [&]() { return service.Reload(context); });
+        Measure(&stop, [&]() { return service.Stop(context); });
+    }
+
+#ifdef _WIN32
+    printf("平台: Windows (CreateProcess / nginx -s / TerminateProcess)\n");
+#else
+    printf("平台: Linux (posix_spawn / kill / SIGKILL)\n");
+#endif
+    printf("%d 轮\n", rounds);
+    Print(start);
+    Print(reload);
+    Print(stop);
+    return start.failures + reload.failures + stop.failures == 0 ? 0 : 1;
+}
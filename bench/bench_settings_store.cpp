@@ -0,0 +1,78 @@
+// nginx-manager/bench/bench_settings_store.cpp
+// 基准 - 模拟在路径输入框中连续输入，比较每次按键同步写文件与合并后台落盘的调用耗时和写盘次数
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_settings_store.cpp ../src/settings_store.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_settings_store.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_settings_store.cpp ../src/settings_store.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_settings_store
+
+#include "settings_store.h"
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+static const char* kPath = "bench-settings.ini";
+#else
+static const char* kPath = "/tmp/bench-settings.ini";
+#endif
+
+static const char* kInitial =
+    "; nginx-manager 配置\n"
+    "[Settings]\n"
+    "NginxPath=D:\\nginx\n"
+    "\n"
+    "[Fonts]\n"
+    "TitleSize=24\n"
+    "LogSize=14\n";
+
+int main() {
+    const std::string typed = "D:\\servers\\nginx-1.26.3\\instances\\site-a";
+    const int keystrokeGapMs = 5;
+
+    FILE* file = fopen(kPath, "wb");
+    fputs(kInitial, file);
+    fclose(file);
+
+    // 1. 旧方式：每次按键同步写一次文件（这里用同样的原子写入，实际的 WritePrivateProfileString 还要再读一遍文件）
+    SettingsStore direct;
+    direct.Open(kPath, nullptr);
+    uint64_t directMicros = 0;
+    for (size_t i = 1; i <= typed.size(); ++i) {
+        uint64_t begin = MonotonicMicros();
+        direct.SetString("Settings", "NginxPath", typed.substr(0, i));
+        direct.Flush(nullptr);
+        directMicros += MonotonicMicros() - begin;
+    }
+    direct.Close();
+    printf("每次按键写盘: %zu 次按键, 写盘 %llu 次, 界面线程每次按键 %.1f us\n", typed.size(),
+           (unsigned long long)direct.Stats().flushes, (double)directMicros / typed.size());
+
+    // 2. 合并落盘：按键只改内存，静默 200ms 后由后台线程写一次
+    SettingsStore store;
+    store.Open(kPath, nullptr);
+    store.SetDebounce(200, 1000);
+    uint64_t setMicros = 0;
+    for (size_t i = 1; i <= typed.size(); ++i) {
+        uint64_t begin = MonotonicMicros();
+        store.SetString("Settings", "NginxPath", typed.substr(0, i));
+        setMicros += MonotonicMicros() - begin;
+        std::this_thread::sleep_for(std::chrono::milliseconds(keystrokeGapMs));
+    }
+    store.SetInt("Fonts", "LogSize", 16);
+    store.SetString("Instances", "Prefix1", "D:\\nginx-site-b");
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    SettingsStoreStats stats = store.Stats();
+    printf("合并落盘:     %zu 次按键 + 2 次修改, 写盘 %llu 次 (耗时 %.1f us), 界面线程每次修改 %.2f us\n",
+           typed.size(), (unsigned long long)stats.flushes, (double)stats.lastFlushMicros,
+           (double)setMicros / typed.size());
+    store.Close();
+
+    // 3. 重新读入，确认内容与注释都保留
+    SettingsStore reopened;
+    reopened.Open(kPath, nullptr);
+    bool ok = reopened.GetString("settings", "nginxpath", "") == typed && reopened.GetInt("Fonts", "LogSize", 0) == 16 &&
+              reopened.GetInt("Fonts", "TitleSize", 0) == 24 && reopened.Has("Instances", "Prefix1");
+    printf("重新读入: %s\n%s", ok ? "一致" : "不一致", reopened.Serialize().c_str());
+    reopened.Close();
+    remove(kPath);
+    return ok ? 0 : 1;
+}
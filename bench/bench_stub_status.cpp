@@ -0,0 +1,187 @@
+// nginx-manager/bench/bench_stub_status.cpp
+// 基准 - 对本地模拟的 stub_status 服务测量长连接与逐次建连的请求耗时，并验证轮询线程与时间序列
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_stub_status.cpp ../src/stub_status.cpp ../src/http_client.cpp ../src/socket_util.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -lws2_32 -o bench_stub_status.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_stub_status.cpp ../src/stub_status.cpp ../src/http_client.cpp ../src/socket_util.cpp ../src/nginx_conf.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_stub_status
+
+#include "stub_status.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#endif
+
+// 模拟 nginx 的 stub_status：HTTP/1.1 长连接，每个连接最多处理 keepaliveRequests 个请求后关闭
+class StandInServer {
+public:
+    bool Start(uint32_t keepaliveRequests) {
+        m_keepaliveRequests = keepaliveRequests;
+        InitSockets();
+        m_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        if (bind(m_listen, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_listen, 16) != 0) return false;
+        socklen_t length = sizeof(address);
+        getsockname(m_listen, (sockaddr*)&address, &length);
+        m_port = ntohs(address.sin_port);
+        m_acceptor = std::thread(&StandInServer::AcceptLoop, this);
+        return true;
+    }
+
+    void Stop() {
+        m_stopping = true;
+        // 连一次自己，让 accept 返回
+        SocketHandle wake = ConnectTcp("127.0.0.1", m_port, 1000, nullptr);
+        CloseSocket(wake);
+        m_acceptor.join();
+        CloseSocket(m_listen);
+        for (std::thread& t : m_connections) t.join();
+    }
+
+    uint16_t Port() const { return m_port; }
+    uint64_t Accepted() const { return m_accepted; }
+
+private:
+    void AcceptLoop() {
+        while (!m_stopping) {
+            SocketHandle client = accept(m_listen, nullptr, nullptr);
+            if (client == kInvalidSocket || m_stopping) {
+                CloseSocket(client);
+                continue;
+            }
+            ++m_accepted;
+            ++m_open;
+            m_connections.emplace_back(&StandInServer::Serve, this, client);
+        }
+    }
+
+    void Serve(SocketHandle client) {
+        std::string buffer;
+        char chunk[4096];
+        uint32_t served = 0;
+        while (!m_stopping) {
+            size_t end;
+            while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+                int n = recv(client, chunk, sizeof(chunk), 0);
+                if (n <= 0) {
+                    CloseSocket(client);
+                    --m_open;
+                    return;
+                }
+                buffer.append(chunk, (size_t)n);
+            }
+            buffer.erase(0, end + 4);
+
+            uint64_t requests = ++m_requests;
+            char body[256];
+            int bodyLength = snprintf(body, sizeof(body),
+                                      "Active connections: %u \nserver accepts handled requests\n %llu %llu %llu \n"
+                                      "Reading: 0 Writing: 1 Waiting: %u \n",
+                                      (unsigned)m_open.load(), (unsigned long long)m_accepted.load(),
+                                      (unsigned long long)m_accepted.load(), (unsigned long long)requests,
+                                      (unsigned)m_open.load() - 1);
+            bool close = ++served >= m_keepaliveRequests;
+            char response[512];
+            int length = snprintf(response, sizeof(response),
+                                  "HTTP/1.1 200 OK\r\nServer: nginx\r\nContent-Type: text/plain\r\n"
+                                  "Content-Length: %d\r\nConnection: %s\r\n\r\n%s",
+                                  bodyLength, close ? "close" : "keep-alive", body);
+            send(client, response, length, 0);
+            if (close) break;
+        }
+        CloseSocket(client);
+        --m_open;
+    }
+
+    SocketHandle m_listen = kInvalidSocket;
+    uint16_t m_port = 0;
+    uint32_t m_keepaliveRequests = 1000;
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_accepted{0};
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint32_t> m_open{0};
+    std::thread m_acceptor;
+    std::vector<std::thread> m_connections;
+};
+
+static double RunRequests(uint16_t port, int count, bool keepAlive, uint64_t* connections) {
+    HttpClient client;
+    client.SetTarget("127.0.0.1", port, "");
+    HttpResponse response;
+    StubStatus status;
+    std::string error;
+    uint64_t begin = MonotonicMicros();
+    for (int i = 0; i < count; ++i) {
+        if (!client.Get("/nginx_status", 2000, &response, &error) || response.status != 200 ||
+            !ParseStubStatus(response.body, &status)) {
+            printf("请求失败: %s\n", error.c_str());
+            return -1;
+        }
+        if (!keepAlive) client.Close();
+    }
+    *connections = client.Connections();
+    return (MonotonicMicros() - begin) / (double)count;
+}
+
+int main() {
+    const int requests = 20000;
+
+    // 1. 长连接（服务端每 100 个请求主动关闭一次，与 nginx 的 keepalive_requests 相同）
+    StandInServer server;
+    if (!server.Start(100)) {
+        printf("无法启动模拟服务\n");
+        return 1;
+    }
+    uint64_t connections = 0;
+    double keepAlive = RunRequests(server.Port(), requests, true, &connections);
+    printf("长连接:   %.1f us/请求, %d 个请求共建立 %llu 个连接\n", keepAlive, requests,
+           (unsigned long long)connections);
+    double perRequest = RunRequests(server.Port(), requests, false, &connections);
+    printf("逐次建连: %.1f us/请求, %d 个请求共建立 %llu 个连接\n", perRequest, requests,
+           (unsigned long long)connections);
+
+    // 2. 轮询线程：10ms 间隔运行 1 秒
+    StubStatusEndpoint endpoint;
+    endpoint.host = "127.0.0.1";
+    endpoint.port = server.Port();
+    endpoint.path = "/nginx_status";
+    StubStatusPoller poller;
+    poller.SetInterval(10);
+    poller.StartEndpoint(endpoint);
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    StubStatusSnapshot snapshot = poller.Snapshot();
+    poller.Stop();
+    printf("轮询线程: %llu 次采样, %llu 个连接, 最近一次 %.1f us, active=%llu requests=%llu%s%s\n",
+           (unsigned long long)snapshot.samples, (unsigned long long)snapshot.connections,
+           snapshot.latencyMicros / 1.0, (unsigned long long)snapshot.latest.active,
+           (unsigned long long)snapshot.latest.requests, snapshot.error.empty() ? "" : " 错误: ",
+           snapshot.error.c_str());
+    server.Stop();
+
+    // 3. 时间序列：写入一整天的秒级采样
+    LoadSeries series;
+    StubStatus sample;
+    const int64_t start = 1760000000;
+    uint64_t begin = MonotonicMicros();
+    for (int64_t s = 0; s < 86400; ++s) {
+        sample.active = 100 + s % 50;
+        sample.requests += 250;
+        series.Add(start + s, sample);
+    }
+    double addNs = (MonotonicMicros() - begin) * 1000.0 / 86400;
+    std::vector<LoadPoint> points;
+    series.Query(start, start + 86400, false, &points);
+    size_t secondPoints = points.size();
+    series.Query(start, start + 86400, true, &points);
+    printf("时间序列: 每次写入 %.0f ns, 秒级 %zu 个桶, 分钟级 %zu 个桶, 最近 10 秒 %.1f req/s, 内存 %zu KB\n",
+           addNs, secondPoints, points.size(), series.RequestRate(start + 86399, 10),
+           (LoadSeries::kSecondPoints + LoadSeries::kMinutePoints) * sizeof(LoadPoint) / 1024);
+    return 0;
+}
@@ -0,0 +1,206 @@
+// nginx-manager/bench/bench_supervisor.cpp
+// 基准 - 崩溃监护：进程被结束到检测到退出的延迟、自动恢复耗时、崩溃循环识别与空闲时的 CPU 占用
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_supervisor.cpp ../src/supervisor.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_supervisor.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_supervisor.cpp ../src/supervisor.cpp ../src/file_util.cpp ../src/trace.cpp -o bench_supervisor
+//
+// 模拟的 master 是本程序以 --child 参数启动的子进程：sleep 模式一直等待被结束，crash 模式立即退出。
+
+#include "supervisor.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+static std::string g_self;
+
+static ProcessId SpawnChild(const char* mode) {
+#ifdef _WIN32
+    std::wstring commandLine = L"\"" + Utf8ToWide(g_self) + L"\" --child " + Utf8ToWide(mode);
+    STARTUPINFOW si = {};
+    si.cb = sizeof(si);
+    PROCESS_INFORMATION pi = {};
+    if (!CreateProcessW(NULL, &commandLine[0], NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) return 0;
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+    return pi.dwProcessId;
+#else
+    const char* argv[] = { g_self.c_str(), "--child", mode, NULL };
+    pid_t pid = 0;
+    if (posix_spawn(&pid, g_self.c_str(), NULL, NULL, (char* const*)argv, environ) != 0) return 0;
+    return (ProcessId)pid;
+#endif
+}
+
+static void KillChild(ProcessId pid) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_TERMINATE, FALSE, pid);
+    if (process) {
+        TerminateProcess(process, 1);
+        CloseHandle(process);
+    }
+#else
+    kill((pid_t)pid, SIGKILL);
+#endif
+}
+
+// 本进程已消耗的 CPU 时间（微秒）
+static uint64_t ProcessCpuMicros() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user);
+    uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+    uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+    return (k + u) / 10;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_utime.tv_sec * 1000000 + usage.ru_utime.tv_usec +
+           (uint64_t)usage.ru_stime.tv_sec * 1000000 + usage.ru_stime.tv_usec;
+#endif
+}
+
+// 收集监护事件，主线程按类型等待
+struct EventLog {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::pair<SupervisorEvent, uint64_t>> events;
+
+    void Add(const SupervisorEvent& event) {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.emplace_back(event, MonotonicMicros());
+        changed.notify_all();
+    }
+
+    bool WaitFor(SupervisorEventType type, size_t from, uint32_t timeoutMs, SupervisorEvent* event,
+                 uint64_t* atMicros, size_t* index) {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t i = from;
+        bool found = changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() {
+            for (; i < events.size(); ++i) {
+                if (events[i].first.type == type) return true;
+            }
+            return false;
+        });
+        if (!found) return false;
+        if (event) *event = events[i].first;
+        if (atMicros) *atMicros = events[i].second;
+        if (index) *index = i + 1;
+        return true;
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "--child") == 0) {
+        if (strcmp(argv[2], "crash") == 0) return 3;
+        std::this_thread::sleep_for(std::chrono::hours(1));
+        return 0;
+    }
+    g_self = argv[0];
+
+    EventLog log;
+    Supervisor supervisor;
+    SupervisorPolicy policy;
+    policy.initialDelayMs = 20;
+    policy.maxDelayMs = 200;
+    policy.stableMs = 60000;
+    policy.loopCrashes = 5;
+    policy.loopWindowMs = 10000;
+    supervisor.SetPolicy(policy);
+
+    // 模拟 master 的启动方式：RESTART 事件到来时按 crashMode 选择立即退出或正常运行
+    std::atomic<bool> crashMode(false);
+    std::string error;
+    supervisor.Start([&](const SupervisorEvent& event) {
+        log.Add(event);
+        if (event.type == SUPERVISOR_RESTART) {
+            ProcessId pid = SpawnChild(crashMode ? "crash" : "sleep");
+            if (pid) {
+                supervisor.RestartSucceeded(pid);
+            } else {
+                supervisor.RestartFailed("无法创建进程");
+            }
+        }
+    }, &error);
+
+    // 1. 空闲：没有被监护的进程，也没有退避中的重启
+    uint64_t cpuBegin = ProcessCpuMicros();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    printf("空闲 1 秒 (无监护进程):   CPU %llu us\n", (unsigned long long)(ProcessCpuMicros() - cpuBegin));
+
+    ProcessId pid = SpawnChild("sleep");
+    supervisor.Watch(pid);
+    cpuBegin = ProcessCpuMicros();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    printf("空闲 1 秒 (监护 1 个进程): CPU %llu us\n", (unsigned long long)(ProcessCpuMicros() - cpuBegin));
+
+    // 2. 反复结束 master，测量检测延迟与恢复耗时（这一段放宽崩溃循环阈值）
+    SupervisorPolicy relaxed = policy;
+    relaxed.loopCrashes = 1000;
+    supervisor.SetPolicy(relaxed);
+    const int rounds = 20;
+    std::vector<uint32_t> detect;
+    std::vector<uint32_t> recover;
+    size_t next = 0;
+    for (int i = 0; i < rounds; ++i) {
+        pid = supervisor.WatchedPid();
+        uint64_t killed = MonotonicMicros();
+        KillChild(pid);
+        uint64_t exitAt = 0;
+        SupervisorEvent recovered;
+        if (!log.WaitFor(SUPERVISOR_EXITED, next, 5000, nullptr, &exitAt, &next) ||
+            !log.WaitFor(SUPERVISOR_RECOVERED, next, 5000, &recovered, nullptr, &next)) {
+            printf("第 %d 轮未恢复\n", i + 1);
+            return 1;
+        }
+        detect.push_back((uint32_t)(exitAt - killed));
+        recover.push_back((uint32_t)recovered.downtimeMicros);
+    }
+    std::sort(detect.begin(), detect.end());
+    std::sort(recover.begin(), recover.end());
+    printf("结束进程到检测到退出:     p50 %u us, 最大 %u us (%d 次)\n", detect[rounds / 2], detect.back(), rounds);
+    printf("检测到退出到恢复运行:     p50 %.1f ms, 最大 %.1f ms (含退避 %u..%u ms)\n", recover[rounds / 2] / 1000.0,
+           recover.back() / 1000.0, policy.initialDelayMs / 2, policy.maxDelayMs);
+
+    // 3. 崩溃循环：新进程一启动就退出
+    supervisor.SetPolicy(policy);
+    pid = supervisor.WatchedPid();
+    supervisor.Unwatch();
+    supervisor.Watch(pid);           // 重新开始监护，清空上一段的崩溃记录
+    crashMode = true;
+    uint64_t loopBegin = MonotonicMicros();
+    KillChild(supervisor.WatchedPid());
+    SupervisorEvent gaveUp;
+    bool loopDetected = log.WaitFor(SUPERVISOR_CRASH_LOOP, next, 10000, &gaveUp, nullptr, &next);
+    size_t restarts = 0;
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        for (size_t i = 0; i < log.events.size(); ++i) {
+            if (log.events[i].second >= loopBegin && log.events[i].first.type == SUPERVISOR_RESTART) ++restarts;
+        }
+    }
+    printf("崩溃循环: %s (窗口内 %u 次退出, 自动重启 %zu 次, 耗时 %.0f ms), 状态 %s\n",
+           loopDetected ? "已识别" : "未识别", gaveUp.recentCrashes, restarts,
+           (MonotonicMicros() - loopBegin) / 1000.0, SupervisorStateName(supervisor.State()));
+
+    supervisor.Stop();
+#ifndef _WIN32
+    while (waitpid(-1, NULL, WNOHANG) > 0) {
+    }
+#endif
+    return loopDetected ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+// nginx-manager/bench/bench_trace.cpp
+// 基准 - 追踪关闭 / 开启时每个区间的开销，以及多个线程持续记录时并发汇总、导出的结果是否完整
+//
+// 编译 (MinGW):  g++ -O2 -I../src bench_trace.cpp ../src/trace.cpp ../src/file_util.cpp -o bench_trace.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src bench_trace.cpp ../src/trace.cpp ../src/file_util.cpp -o bench_trace
+
+#include "trace.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+static const char* kPath = "bench-trace.json";
+#else
+static const char* kPath = "/tmp/bench-trace.json";
+#endif
+
+static const uint64_t kSpanMicros = 7;
+static volatile uint64_t g_sink;     // 防止计算被优化掉
+
+static uint64_t Plain(uint64_t i) {
+    return i * 2654435761u + 1;
+}
+
+static uint64_t Traced(uint64_t i) {
+    TraceSpan span(TRACE_PROBE, "bench-span");
+    return i * 2654435761u + 1;
+}
+
+// 每次循环的纳秒数
+template <typename Body>
+static double NanosPerCall(uint64_t iterations, Body body, uint64_t* sink) {
+    uint64_t begin = MonotonicMicros();
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i) sum += body(i);
+    *sink += sum;
+    return (double)(MonotonicMicros() - begin) * 1000.0 / (double)iterations;
+}
+
+static const char* kWriterLabels[] = { "bench-a", "bench-b", "bench-c", "bench-d" };
+
+// 导出文件中写入线程的区间：dur 应为 kSpanMicros，arg 为区间开始时刻，与 ts 之差在整个文件中相同
+static bool CheckExport(size_t* events, size_t* checked) {
+    std::ifstream in(kPath, std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string json = buffer.str();
+    if (json.compare(0, 2, "{\"") != 0 || json.find("\n]}") == std::string::npos) return false;
+
+    bool ok = true;
+    bool haveOrigin = false;
+    long long origin = 0;
+    *events = 0;
+    *checked = 0;
+    size_t pos = 0;
+    while ((pos = json.find("\"ph\":\"X\"", pos)) != std::string::npos) {
+        size_t lineBegin = json.rfind('\n', pos);
+        size_t lineEnd = json.find('\n', pos);
+        std::string line = json.substr(lineBegin + 1, lineEnd - lineBegin - 1);
+        pos = lineEnd;
+        (*events)++;
+        if (line.find("\"name\":\"bench-") == std::string::npos || line.find("bench-span") != std::string::npos) continue;
+        unsigned long long ts = 0;
+        unsigned long long dur = 0;
+        long long arg = 0;
+        const char* tsField = strstr(line.c_str(), "\"ts\":");
+        const char* durField = strstr(line.c_str(), "\"dur\":");
+        const char* argField = strstr(line.c_str(), "\"arg\":");
+        if (!tsField || !durField || !argField || sscanf(tsField, "\"ts\":%llu", &ts) != 1 ||
+            sscanf(durField, "\"dur\":%llu", &dur) != 1 || sscanf(argField, "\"arg\":%lld", &arg) != 1) {
+            ok = false;
+            continue;
+        }
+        if (!haveOrigin) {
+            origin = arg - (long long)ts;
+            haveOrigin = true;
+        }
+        if (dur != kSpanMicros || arg - (long long)ts != origin) ok = false;
+        (*checked)++;
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const uint64_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 20000000;
+    uint64_t sink = 0;
+
+    // 1. 每个区间的开销：无追踪点、追踪关闭、追踪开启
+    double plain = NanosPerCall(iterations, Plain, &sink);
+    double disabled = NanosPerCall(iterations, Traced, &sink);
+    TraceEnable(true);
+    double enabled = NanosPerCall(iterations / 10, Traced, &sink);
+    TraceEnable(false);
+    printf("每次调用: 无追踪点 %.2f ns, 追踪关闭 %.2f ns (+%.2f), 追踪开启 %.1f ns (含两次读时钟)\n", plain, disabled,
+           disabled - plain, enabled);
+
+    // 2. 四个线程持续记录，同时反复汇总与导出
+    TraceEnable(true);
+    const int writers = 4;
+    const uint64_t perWriter = iterations / 20;
+    std::atomic<int> running(writers);
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([w, perWriter, &running]() {
+            static const char* const kNames[] = { "writer-0", "writer-1", "writer-2", "writer-3" };
+            TraceSetThreadName(kNames[w]);
+            for (uint64_t i = 0; i < perWriter; ++i) {
+                uint64_t begin = MonotonicMicros();
+                TraceRecord(TRACE_PROCESS, kWriterLabels[w], begin, begin + kSpanMicros, (int64_t)begin);
+            }
+            running--;
+        });
+    }
+
+    bool ok = true;
+    int rounds = 0;
+    size_t exportedTotal = 0;
+    size_t checkedTotal = 0;
+    uint64_t exportMicros = 0;
+    while (running.load() > 0 || rounds == 0) {
+        TraceSummary summary = CollectTraceSummary();
+        uint64_t begin = MonotonicMicros();
+        size_t exported = 0;
+        std::string error;
+        if (!ExportChromeTrace(kPath, &exported, &error)) {
+            printf("导出失败: %s\n", error.c_str());
+            ok = false;
+            break;
+        }
+        exportMicros += MonotonicMicros() - begin;
+        size_t events = 0;
+        size_t checked = 0;
+        if (!CheckExport(&events, &checked) || events != exported) ok = false;
+        exportedTotal += exported;
+        checkedTotal += checked;
+        rounds++;
+        (void)summary;
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    TraceSummary summary = CollectTraceSummary();
+    uint64_t recorded = 0;
+    for (const TraceStat& stat : summary.stats) {
+        for (const char* label : kWriterLabels) {
+            if (stat.label == label) {
+                recorded += stat.count;
+                if (stat.p50Micros != kSpanMicros || stat.maxMicros != kSpanMicros) ok = false;
+            }
+        }
+    }
+    if (recorded != perWriter * writers) ok = false;
+    printf("并发记录: %d 个线程各 %llu 个区间, 直方图计入 %llu 个; 同时导出 %d 次 (平均 %.1f ms, %zu 个区间, 校验 %zu 个)\n",
+           writers, (unsigned long long)perWriter, (unsigned long long)recorded, rounds,
+           rounds ? exportMicros / 1000.0 / rounds : 0.0, exportedTotal, checkedTotal);
+    printf("%s\n", FormatTraceSummary(summary).c_str());
+    printf("结果: %s\n", ok ? "一致" : "不一致");
+    remove(kPath);
+    g_sink = sink;
+    return ok ? 0 : 1;
+}
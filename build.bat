@@ -39,7 +39,10 @@ if %errorlevel% neq 0 (
 )
 
 echo Step 3: Compile main program...
-g++ -O2 -s -mwindows -o ngTool.exe simple-main.cpp resource.o -lgdi32 -luser32 -lkernel32 -lshell32 -lole32
+g++ -O2 -s -mwindows -o ngTool.exe simple-main.cpp process_table.cpp nginx_control.cpp readiness.cpp op_queue.cpp nginx_conf.cpp content_hash.cpp config_cache.cpp line_scan.cpp log_tailer.cpp access_log.cpp log_model.cpp log_view.cpp journal.cpp socket_util.cpp http_client.cpp stub_status.cpp instance_registry.cpp settings_store.cpp control_protocol.cpp control_server.cpp nginx_service.cpp daemon.cpp supervisor.cpp process_sampler.cpp cpu_topology.cpp conf_edit.cpp log_rotator.cpp lz4_frame.cpp load_test.cpp load_history.cpp status_view.cpp timer_wheel.cpp health_prober.cpp log_store.cpp log_format.cpp conf_watcher.cpp trace.cpp file_util.cpp resource.o -lgdi32 -luser32 -lkernel32 -lshell32 -lole32 -lws2_32
+
+echo Step 4: Compile command line tool...
+g++ -O2 -s -o ngctl.exe ngctl.cpp control_client.cpp control_protocol.cpp
 
 if exist "ngTool.exe" (
     echo.
@@ -47,6 +50,10 @@ if exist "ngTool.exe" (
     echo.
     if exist "..\ngTool.exe" del "..\ngTool.exe"
     move ngTool.exe ..
+    if exist "ngctl.exe" (
+        if exist "..\ngctl.exe" del "..\ngctl.exe"
+        move ngctl.exe ..
+    )
     cd ..
     dir ngTool.exe | findstr ngTool.exe
     echo.
@@ -0,0 +1,177 @@
+// nginx-manager/src/access_log.cpp
+// 访问日志统计 - 按 access.log 的 log_format 跟随解析，用固定大小的环形缓冲维护滚动指标
+
+#include "access_log.h"
+#include "log_rotator.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+// 后台线程的轮询间隔
+static const uint32_t kPollIntervalMs = 250;
+
+// 持有统计锁期间最多连续处理的行数
+static const uint32_t kLinesPerLock = 4096;
+
+// ---------------------------------------------------------------------------
+// TrafficMetrics
+
+void TrafficMetrics::Reset() {
+    memset(m_ring, 0, sizeof(m_ring));
+    for (SecondBucket& bucket : m_ring) bucket.second = -1;
+    memset(m_statusCounts, 0, sizeof(m_statusCounts));
+    m_totalRequests = 0;
+    m_totalBytes = 0;
+    m_parseErrors = 0;
+    m_latestSecond = 0;
+}
+
+void TrafficMetrics::Add(const AccessLogRecord& record) {
+    ++m_totalRequests;
+    m_totalBytes += record.bytes;
+    int statusClass = record.status >= 100 && record.status < 600 ? record.status / 100 : 0;
+    if (statusClass != 0) ++m_statusCounts[record.status];
+    if (record.second > m_latestSecond) m_latestSecond = record.second;
+
+    // 早于环形窗口的记录（例如启动时读到的旧日志）只计入累计值
+    if (record.second <= m_latestSecond - (int64_t)kRingSeconds) return;
+
+    SecondBucket& bucket = m_ring[(uint64_t)record.second % kRingSeconds];
+    if (bucket.second != record.second) {
+        memset(&bucket, 0, sizeof(bucket));
+        bucket.second = record.second;
+    }
+    ++bucket.requests;
+    bucket.bytes += record.bytes;
+    ++bucket.classes[statusClass];
+}
+
+TrafficSnapshot TrafficMetrics::Snapshot(int64_t nowSecond, uint32_t windowSeconds) const {
+    TrafficSnapshot snapshot;
+    if (windowSeconds == 0) windowSeconds = 1;
+    if (windowSeconds > kRingSeconds - 1) windowSeconds = kRingSeconds - 1;
+    snapshot.windowSeconds = windowSeconds;
+    snapshot.totalRequests = m_totalRequests;
+    snapshot.totalBytes = m_totalBytes;
+    snapshot.parseErrors = m_parseErrors;
+    snapshot.latestSecond = m_latestSecond;
+
+    uint64_t bytes = 0;
+    for (int64_t second = nowSecond - windowSeconds; second < nowSecond; ++second) {
+        if (second < 0) continue;
+        const SecondBucket& bucket = m_ring[(uint64_t)second % kRingSeconds];
+        if (bucket.second != second) continue;
+        snapshot.windowRequests += bucket.requests;
+        bytes += bucket.bytes;
+        for (int i = 0; i < kStatusClasses; ++i) snapshot.windowClasses[i] += bucket.classes[i];
+    }
+    snapshot.requestsPerSec = (double)snapshot.windowRequests / windowSeconds;
+    snapshot.bytesPerSec = (double)bytes / windowSeconds;
+    return snapshot;
+}
+
+uint64_t TrafficMetrics::StatusCount(int status) const {
+    return status >= 100 && status < 600 ? m_statusCounts[status] : 0;
+}
+
+// ---------------------------------------------------------------------------
+// AccessLogMonitor
+
+AccessLogMonitor::~AccessLogMonitor() {
+    Stop();
+}
+
+void AccessLogMonitor::Start(const std::string& prefix, const std::string& confPath) {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (m_worker.joinable() && prefix == m_prefix && confPath == m_confPath) return;
+    }
+    Stop();
+
+    {
+        std::lock_guard<std::mutex> lock(m_metricsMutex);
+        m_metrics.Reset();
+    }
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    m_stopping = false;
+    m_rediscover = false;
+    m_prefix = prefix;
+    m_confPath = confPath;
+    m_worker = std::thread(&AccessLogMonitor::Run, this, prefix, confPath);
+}
+
+void AccessLogMonitor::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+void AccessLogMonitor::Rediscover() {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_rediscover = true;
+    }
+    m_wake.notify_all();
+}
+
+TrafficSnapshot AccessLogMonitor::Snapshot(uint32_t windowSeconds) const {
+    std::lock_guard<std::mutex> lock(m_metricsMutex);
+    return m_metrics.Snapshot((int64_t)time(nullptr), windowSeconds);
+}
+
+void AccessLogMonitor::Run(std::string prefix, std::string confPath) {
+    TraceSetThreadName("access-log");
+    LogTailer tailer;
+    std::unique_ptr<LogFormatParser> parser;
+    std::string formatText;
+    // 配置中的格式变化时才换解析器；滚动统计只用到时间、状态码与字节数，解析到其中最后一个字段为止
+    auto discover = [&]() {
+        AccessLogSource source = CollectAccessLogSources(prefix, confPath).front();
+        if (!tailer.IsOpen()) tailer.Open(source.path, false);
+        if (parser && source.format.Text() == formatText) return;
+        parser.reset(new LogFormatParser(source.format, LOG_FIELD_TIME | LOG_FIELD_STATUS | LOG_FIELD_BYTES));
+        formatText = source.format.Text();
+    };
+    discover();
+
+    // Poll 期间持有统计锁，每处理一批行短暂释放一次，积压很多时也不会让取快照的界面线程久等
+    std::unique_lock<std::mutex> metrics(m_metricsMutex, std::defer_lock);
+    uint32_t batch = 0;
+    LogTailer::LineHandler handler = [this, &parser, &metrics, &batch](const char* line, size_t length) {
+        AccessLogEntry entry;
+        if (parser->Parse(line, length, &entry)) {
+            AccessLogRecord record;
+            record.second = entry.second;
+            record.status = entry.status;
+            record.bytes = entry.bytes;
+            m_metrics.Add(record);
+        } else {
+            m_metrics.AddParseError();
+        }
+        if (++batch == kLinesPerLock) {
+            batch = 0;
+            metrics.unlock();
+            metrics.lock();
+        }
+    };
+
+    std::unique_lock<std::mutex> control(m_controlMutex);
+    while (!m_stopping) {
+        bool rediscover = m_rediscover;
+        m_rediscover = false;
+        control.unlock();
+        if (rediscover) discover();
+        metrics.lock();
+        tailer.Poll(handler);
+        metrics.unlock();
+        control.lock();
+        m_wake.wait_for(control, std::chrono::milliseconds(kPollIntervalMs),
+                        [this]() { return m_stopping || m_rediscover; });
+    }
+}
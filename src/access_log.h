@@ -0,0 +1,104 @@
+// nginx-manager/src/access_log.h
+// 访问日志统计 - 按 access.log 的 log_format 跟随解析，用固定大小的环形缓冲维护滚动指标
+
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include "log_tailer.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// 一条访问记录中统计所需的字段
+struct AccessLogRecord {
+    int64_t second = 0;              // $time_local 换算成的 UTC 秒
+    int status = 0;
+    uint64_t bytes = 0;              // $body_bytes_sent
+};
+
+// 状态码分类：0 为无法识别，1..5 对应 1xx..5xx
+const int kStatusClasses = 6;
+
+// 滚动窗口统计结果
+struct TrafficSnapshot {
+    double requestsPerSec = 0;
+    double bytesPerSec = 0;
+    uint64_t windowRequests = 0;
+    uint64_t windowClasses[kStatusClasses] = {};
+    uint32_t windowSeconds = 0;
+    uint64_t totalRequests = 0;
+    uint64_t totalBytes = 0;
+    uint64_t parseErrors = 0;
+    int64_t latestSecond = 0;        // 最近一条记录的时间，尚无记录时为 0
+};
+
+// 按秒聚合的滚动指标，最近 kRingSeconds 秒各占一个槽位，另有整个生命周期的状态码直方图
+class TrafficMetrics {
+public:
+    static const uint32_t kRingSeconds = 64;
+
+    TrafficMetrics() { Reset(); }
+
+    void Add(const AccessLogRecord& record);
+    void AddParseError() { ++m_parseErrors; }
+    void Reset();
+
+    // 统计 [nowSecond - windowSeconds, nowSecond) 内完整的若干秒
+    TrafficSnapshot Snapshot(int64_t nowSecond, uint32_t windowSeconds) const;
+
+    // 某个状态码累计出现的次数
+    uint64_t StatusCount(int status) const;
+    int64_t LatestSecond() const { return m_latestSecond; }
+
+private:
+    struct SecondBucket {
+        int64_t second;
+        uint32_t requests;
+        uint64_t bytes;
+        uint32_t classes[kStatusClasses];
+    };
+
+    SecondBucket m_ring[kRingSeconds];
+    uint64_t m_statusCounts[600];
+    uint64_t m_totalRequests;
+    uint64_t m_totalBytes;
+    uint64_t m_parseErrors;
+    int64_t m_latestSecond;
+};
+
+// 后台线程跟随 access.log 并更新 TrafficMetrics，界面线程随时取快照
+class AccessLogMonitor {
+public:
+    AccessLogMonitor() {}
+    ~AccessLogMonitor();
+
+    AccessLogMonitor(const AccessLogMonitor&) = delete;
+    AccessLogMonitor& operator=(const AccessLogMonitor&) = delete;
+
+    // 开始跟随 prefix 下默认的 access.log（只统计之后追加的行），按配置中为它指定的 log_format 解析；
+    // 已在跟随其他实例时先停止
+    void Start(const std::string& prefix, const std::string& confPath);
+    void Stop();
+    // 重新读取配置中的格式（重新加载后调用），格式变化时此后的行按新格式解析
+    void Rediscover();
+
+    // 以当前时间为终点的滚动统计
+    TrafficSnapshot Snapshot(uint32_t windowSeconds) const;
+
+private:
+    void Run(std::string prefix, std::string confPath);
+
+    std::thread m_worker;
+    std::mutex m_controlMutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+    bool m_rediscover = false;
+    std::string m_prefix;
+    std::string m_confPath;
+
+    mutable std::mutex m_metricsMutex;
+    TrafficMetrics m_metrics;
+};
+
+#endif // ACCESS_LOG_H
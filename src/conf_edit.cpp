@@ -0,0 +1,162 @@
+// nginx-manager/src/conf_edit.cpp
+// nginx 配置改写 - 原地替换或插入 main 上下文的指令，原子写回并可恢复原内容
+
+#include "conf_edit.h"
+#include "file_util.h"
+#include "nginx_conf.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 一处文本替换：[begin, end) 换成 text
+struct Splice {
+    uint32_t file = 0;
+    size_t begin = 0;
+    size_t end = 0;
+    std::string text;
+};
+
+// 指令在映射内存中的位置；名称或参数是转义后的副本时无法定位，返回 false
+bool LocateDirective(const NginxConfig& config, uint32_t index, size_t* begin, size_t* end) {
+    const ConfDirective& directive = config.At(index);
+    const MappedFile& file = config.FileContent(directive.file);
+    const char* data = file.Data();
+    size_t size = file.Size();
+    if (!data || directive.name.data() < data || directive.name.data() >= data + size) return false;
+
+    size_t cursor = (size_t)(directive.name.data() - data) + directive.name.size();
+    if (directive.argCount > 0) {
+        std::string_view last = config.Arg(directive, directive.argCount - 1);
+        if (last.data() < data || last.data() > data + size) return false;
+        cursor = (size_t)(last.data() - data) + last.size();
+    }
+    // 跳过参数的右引号与空白，直到结束指令的分号
+    while (cursor < size && data[cursor] != ';') ++cursor;
+    if (cursor >= size) return false;
+
+    *begin = (size_t)(directive.name.data() - data);
+    *end = cursor + 1;
+    return true;
+}
+
+// 指令所在行的缩进
+std::string IndentOf(const char* data, size_t offset) {
+    size_t lineBegin = offset;
+    while (lineBegin > 0 && data[lineBegin - 1] != '\n') --lineBegin;
+    size_t i = lineBegin;
+    while (i < offset && (data[i] == ' ' || data[i] == '\t')) ++i;
+    return std::string(data + lineBegin, i - lineBegin);
+}
+
+// 沿用文件已有的换行风格
+const char* NewlineOf(const char* data, size_t size) {
+    const void* lf = data ? memchr(data, '\n', size) : nullptr;
+    if (lf && lf != data && ((const char*)lf)[-1] == '\r') return "\r\n";
+    return "\n";
+}
+
+}  // namespace
+
+bool SetMainDirectives(const std::string& confPath, const std::vector<DirectiveEdit>& edits, ConfBackup* backup,
+                       std::string* error) {
+    NginxConfig config;
+    std::string parseError;
+    if (!config.Load(confPath, &parseError)) {
+        if (error) *error = parseError;
+        return false;
+    }
+
+    std::vector<Splice> splices;
+    uint32_t anchorFile = 0;
+    size_t anchor = 0;               // 下一条待插入指令的位置：前一条编辑的指令之后，初始为主配置文件开头
+    std::string anchorIndent;
+    for (const DirectiveEdit& edit : edits) {
+        uint32_t found = NginxConfig::kNoDirective;
+        for (uint32_t index : config.FindByName(edit.name)) {
+            if (config.At(index).parent == NginxConfig::kNoDirective) {
+                found = index;
+                break;
+            }
+        }
+
+        std::string directive = edit.name + (edit.args.empty() ? "" : " " + edit.args) + ";";
+        if (found != NginxConfig::kNoDirective) {
+            Splice splice;
+            splice.file = config.At(found).file;
+            if (!LocateDirective(config, found, &splice.begin, &splice.end)) {
+                if (error) *error = "无法定位指令 " + edit.name + " (" + config.Files()[splice.file] + ")";
+                return false;
+            }
+            splice.text = directive;
+            splices.push_back(splice);
+            // 后续插入的指令放在这一行之后，不打断行尾注释
+            const MappedFile& file = config.FileContent(splice.file);
+            const void* lineEnd = memchr(file.Data() + splice.end, '\n', file.Size() - splice.end);
+            anchorFile = splice.file;
+            anchor = lineEnd ? (size_t)((const char*)lineEnd - file.Data()) + 1 : file.Size();
+            anchorIndent = IndentOf(file.Data(), splice.begin);
+            continue;
+        }
+
+        const MappedFile& file = config.FileContent(anchorFile);
+        const char* newline = NewlineOf(file.Data(), file.Size());
+        Splice splice;
+        splice.file = anchorFile;
+        splice.begin = anchor;
+        splice.end = anchor;
+        splice.text = anchorIndent + directive + newline;
+        if (anchor > 0 && file.Data()[anchor - 1] != '\n') splice.text = newline + splice.text;
+        splices.push_back(splice);
+    }
+
+    // 按文件生成新内容；同一位置的多处插入保持编辑顺序
+    std::vector<std::pair<std::string, std::string>> originals;
+    std::vector<std::pair<std::string, std::string>> outputs;
+    for (uint32_t file = 0; file < config.Files().size(); ++file) {
+        std::vector<const Splice*> mine;
+        for (const Splice& splice : splices) {
+            if (splice.file == file) mine.push_back(&splice);
+        }
+        if (mine.empty()) continue;
+        std::stable_sort(mine.begin(), mine.end(),
+                         [](const Splice* a, const Splice* b) { return a->begin < b->begin; });
+
+        const MappedFile& content = config.FileContent(file);
+        std::string original(content.Data() ? content.Data() : "", content.Size());
+        std::string text;
+        text.reserve(original.size() + 256);
+        size_t cursor = 0;
+        for (const Splice* splice : mine) {
+            text.append(original, cursor, splice->begin - cursor);
+            text += splice->text;
+            cursor = splice->end;
+        }
+        text.append(original, cursor, std::string::npos);
+        if (text != original) {
+            originals.emplace_back(config.Files()[file], original);
+            outputs.emplace_back(config.Files()[file], text);
+        }
+    }
+    // 写回前解除映射，Windows 上被映射的文件无法被替换
+    config.Clear();
+
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        if (!WriteFileAtomically(outputs[i].first, outputs[i].second, error)) {
+            // 已写入的文件恢复原样，保持配置整体一致
+            for (size_t j = 0; j < i; ++j) WriteFileAtomically(originals[j].first, originals[j].second, nullptr);
+            return false;
+        }
+    }
+    if (backup) backup->files = originals;
+    return true;
+}
+
+bool RestoreConf(const ConfBackup& backup, std::string* error) {
+    bool ok = true;
+    for (const auto& file : backup.files) {
+        ok = WriteFileAtomically(file.first, file.second, error) && ok;
+    }
+    return ok;
+}
@@ -0,0 +1,32 @@
+// nginx-manager/src/conf_edit.h
+// nginx 配置改写 - 原地替换或插入 main 上下文的指令，原子写回并可恢复原内容
+
+#ifndef CONF_EDIT_H
+#define CONF_EDIT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// 一条要设置的 main 上下文指令，args 为参数原文（如 "4" 或 "0001 0010"）
+struct DirectiveEdit {
+    std::string name;
+    std::string args;
+};
+
+// 改写前的文件内容，用于校验失败后恢复
+struct ConfBackup {
+    std::vector<std::pair<std::string, std::string>> files;   // (路径, 原内容)
+};
+
+// 设置 main 上下文（顶层）的指令：
+// 已存在时只替换名称到分号之间的部分，保留缩进与行尾注释，指令位于 include 的文件中时改写该文件；
+// 不存在时插入到前一条编辑的指令之后，第一条则插入到主配置文件开头。
+// 所有改动先在内存中完成，再逐个文件原子写回；backup 可为空。
+bool SetMainDirectives(const std::string& confPath, const std::vector<DirectiveEdit>& edits, ConfBackup* backup,
+                       std::string* error);
+
+// 恢复 SetMainDirectives 改写前的内容
+bool RestoreConf(const ConfBackup& backup, std::string* error);
+
+#endif // CONF_EDIT_H
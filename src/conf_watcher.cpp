@@ -0,0 +1,530 @@
+// nginx-manager/src/conf_watcher.cpp
+// 配置监视 - 监视 conf 目录与 include 引用的目录 (inotify / ReadDirectoryChangesW)，连续的修改防抖合并为一次变更后回调
+
+#include "conf_watcher.h"
+#include "config_cache.h"
+#include "file_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const size_t kMaxDirectories = 256;   // 递归展开 conf 目录时的上限，防止误把大目录树当作配置目录
+
+// ---------------------------------------------------------------------------
+// 路径
+
+// path 位于 directory 之下（不含 directory 本身）
+static bool IsUnder(const std::string& path, const std::string& directory) {
+    return path.size() > directory.size() && path.compare(0, directory.size(), directory) == 0 &&
+           IsPathSeparator(path[directory.size()]);
+}
+
+// 编辑器保存时产生的临时文件（vim 的 .swp / 4913、emacs 的 .# 与 ~ 备份等），不列入变化的文件
+static bool IsEditorTempFile(const std::string& name) {
+    auto endsWith = [&name](const char* suffix) {
+        size_t length = strlen(suffix);
+        return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+    };
+    return name.empty() || name == "4913" || name.compare(0, 2, ".#") == 0 || endsWith("~") || endsWith(".swp") ||
+           endsWith(".swx") || endsWith(".tmp");
+}
+
+namespace {
+
+struct WatchDirectory {
+    std::string path;
+    bool recursive = false;
+};
+
+} // namespace
+
+// 需要监视的目录：主配置文件所在目录（含子目录），以及 include 到的该目录以外的文件、通配符所在的目录
+static std::vector<WatchDirectory> WatchDirectories(const std::string& confPath, const NginxConfig* config) {
+    std::vector<WatchDirectory> directories;
+    std::string root = DirectoryOf(confPath);
+    directories.push_back({root, true});
+    auto add = [&directories, &root](const std::string& directory) {
+        if (directory.empty() || directory == root || IsUnder(directory, root)) return;
+        for (const WatchDirectory& existing : directories) {
+            if (existing.path == directory) return;
+        }
+        directories.push_back({directory, false});
+    };
+    if (!config) return directories;
+
+    const std::vector<std::string>& files = config->Files();
+    for (size_t i = 1; i < files.size(); ++i) add(DirectoryOf(files[i]));
+    // 通配符尚未匹配到文件时，新建的文件也要能被发现
+    for (uint32_t index : config->FindByName("include")) {
+        if (config->At(index).argCount == 0) continue;
+        std::string pattern(config->Arg(index, 0));
+        if (!IsAbsolutePath(pattern)) pattern = config->ConfPrefix() + "/" + pattern;
+        std::string directory = DirectoryOf(pattern);
+        if (directory.find_first_of("*?[") != std::string::npos) continue;
+        add(directory);
+    }
+    return directories;
+}
+
+// ---------------------------------------------------------------------------
+// 平台相关的目录监视
+
+class ConfigWatcher::Notifier {
+public:
+    // 一个事件对应的文件路径；path 为空表示事件队列溢出
+    typedef std::function<void(const std::string& path)> EventSink;
+
+    Notifier() {}
+    ~Notifier() { Close(); }
+
+    bool Open(std::string* error);
+    void Close();
+    // 可在任意线程调用
+    void Wake();
+    // 以 directories 替换监视的目录集合，返回实际监视的目录数
+    uint32_t Watch(const std::vector<WatchDirectory>& directories);
+    // 等待事件，最多 timeoutMs（负数表示一直等），被唤醒、超时或处理完一批事件后返回
+    void Wait(int timeoutMs, const EventSink& sink);
+
+private:
+#ifdef _WIN32
+    struct Directory {
+        std::string path;
+        bool recursive = false;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped = {};
+        bool armed = false;
+        DWORD buffer[4096];          // FILE_NOTIFY_INFORMATION 需要 4 字节对齐
+    };
+
+    bool Arm(Directory& directory);
+    void Release(Directory& directory);
+
+    HANDLE m_wake = NULL;
+    std::vector<std::unique_ptr<Directory>> m_directories;
+#else
+    void AddTree(const std::string& path, std::map<std::string, bool>* paths);
+
+    int m_inotify = -1;
+    int m_wakeFd = -1;
+    std::map<int, std::string> m_watches;    // 监视描述符 -> 目录
+#endif
+};
+
+#ifdef _WIN32
+
+static const DWORD kNotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                   FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE |
+                                   FILE_NOTIFY_CHANGE_CREATION;
+
+bool ConfigWatcher::Notifier::Open(std::string* error) {
+    m_wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!m_wake) {
+        *error = "无法创建唤醒事件";
+        return false;
+    }
+    return true;
+}
+
+void ConfigWatcher::Notifier::Close() {
+    for (auto& directory : m_directories) Release(*directory);
+    m_directories.clear();
+    if (m_wake) CloseHandle(m_wake);
+    m_wake = NULL;
+}
+
+void ConfigWatcher::Notifier::Wake() {
+    if (m_wake) SetEvent(m_wake);
+}
+
+bool ConfigWatcher::Notifier::Arm(Directory& directory) {
+    ResetEvent(directory.overlapped.hEvent);
+    directory.armed = ReadDirectoryChangesW(directory.handle, directory.buffer, sizeof(directory.buffer),
+                                            directory.recursive ? TRUE : FALSE, kNotifyFilter, NULL,
+                                            &directory.overlapped, NULL) != FALSE;
+    return directory.armed;
+}
+
+void ConfigWatcher::Notifier::Release(Directory& directory) {
+    if (directory.handle != INVALID_HANDLE_VALUE) {
+        // 取消未完成的读取并等它结束，之后缓冲区才能释放
+        if (directory.armed) {
+            DWORD bytes = 0;
+            CancelIoEx(directory.handle, &directory.overlapped);
+            GetOverlappedResult(directory.handle, &directory.overlapped, &bytes, TRUE);
+        }
+        CloseHandle(directory.handle);
+        directory.handle = INVALID_HANDLE_VALUE;
+    }
+    if (directory.overlapped.hEvent) CloseHandle(directory.overlapped.hEvent);
+    directory.overlapped.hEvent = NULL;
+    directory.armed = false;
+}
+
+uint32_t ConfigWatcher::Notifier::Watch(const std::vector<WatchDirectory>& directories) {
+    // 路径与方式都未变的目录保留原来的句柄，不丢失两次 Watch 之间的事件
+    std::vector<std::unique_ptr<Directory>> kept;
+    for (auto& directory : m_directories) {
+        bool wanted = false;
+        for (const WatchDirectory& target : directories) {
+            wanted = wanted || (target.path == directory->path && target.recursive == directory->recursive);
+        }
+        if (wanted && directory->armed) {
+            kept.push_back(std::move(directory));
+        } else {
+            Release(*directory);
+        }
+    }
+    m_directories.swap(kept);
+
+    // 每个目录一个事件对象，加上唤醒事件不能超过 WaitForMultipleObjects 的上限
+    for (const WatchDirectory& target : directories) {
+        if (m_directories.size() >= MAXIMUM_WAIT_OBJECTS - 1) break;
+        bool exists = false;
+        for (const auto& directory : m_directories) exists = exists || directory->path == target.path;
+        if (exists) continue;
+
+        std::unique_ptr<Directory> directory(new Directory());
+        directory->path = target.path;
+        directory->recursive = target.recursive;
+        directory->handle = CreateFileW(Utf8ToWide(target.path).c_str(), FILE_LIST_DIRECTORY,
+                                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                                        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        if (directory->handle == INVALID_HANDLE_VALUE) continue;
+        directory->overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (!directory->overlapped.hEvent || !Arm(*directory)) {
+            Release(*directory);
+            continue;
+        }
+        m_directories.push_back(std::move(directory));
+    }
+    return (uint32_t)m_directories.size();
+}
+
+void ConfigWatcher::Notifier::Wait(int timeoutMs, const EventSink& sink) {
+    HANDLE handles[MAXIMUM_WAIT_OBJECTS];
+    DWORD count = 0;
+    handles[count++] = m_wake;
+    for (const auto& directory : m_directories) {
+        if (directory->armed) handles[count++] = directory->overlapped.hEvent;
+    }
+    DWORD result = WaitForMultipleObjects(count, handles, FALSE, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs);
+    if (result < WAIT_OBJECT_0 + 1 || result >= WAIT_OBJECT_0 + count) return;
+
+    // 同时就绪的目录逐个检查，不只处理第一个
+    for (auto& directory : m_directories) {
+        if (!directory->armed || WaitForSingleObject(directory->overlapped.hEvent, 0) != WAIT_OBJECT_0) continue;
+        DWORD bytes = 0;
+        directory->armed = false;
+        if (!GetOverlappedResult(directory->handle, &directory->overlapped, &bytes, FALSE) || bytes == 0) {
+            // 缓冲区不够容纳这段时间的全部事件，或目录已被删除
+            sink(std::string());
+        } else {
+            const char* data = reinterpret_cast<const char*>(directory->buffer);
+            for (DWORD offset = 0;;) {
+                const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data + offset);
+                std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                sink(directory->path + "\\" + WideToUtf8(name));
+                if (info->NextEntryOffset == 0) break;
+                offset += info->NextEntryOffset;
+            }
+        }
+        // 目录已不存在时重新武装失败，下一次 Watch 会重新打开
+        Arm(*directory);
+    }
+}
+
+#else
+
+static const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+bool ConfigWatcher::Notifier::Open(std::string* error) {
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_inotify < 0 || m_wakeFd < 0) {
+        *error = std::string("无法创建 inotify: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void ConfigWatcher::Notifier::Close() {
+    if (m_inotify >= 0) close(m_inotify);
+    if (m_wakeFd >= 0) close(m_wakeFd);
+    m_inotify = m_wakeFd = -1;
+    m_watches.clear();
+}
+
+void ConfigWatcher::Notifier::Wake() {
+    uint64_t one = 1;
+    if (m_wakeFd >= 0 && write(m_wakeFd, &one, sizeof(one)) < 0) {
+        // 计数器已满时同样会唤醒，忽略
+    }
+}
+
+// inotify 不支持递归监视，逐个加入子目录
+void ConfigWatcher::Notifier::AddTree(const std::string& path, std::map<std::string, bool>* paths) {
+    if (paths->size() >= kMaxDirectories || !paths->emplace(path, true).second) return;
+    DIR* dir = opendir(path.c_str());
+    if (!dir) return;
+    while (dirent* entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        std::string child = path + "/" + entry->d_name;
+        bool isDirectory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat st;
+            isDirectory = stat(child.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        }
+        if (isDirectory) AddTree(child, paths);
+    }
+    closedir(dir);
+}
+
+uint32_t ConfigWatcher::Notifier::Watch(const std::vector<WatchDirectory>& directories) {
+    std::map<std::string, bool> paths;
+    for (const WatchDirectory& directory : directories) {
+        if (directory.recursive) {
+            AddTree(directory.path, &paths);
+        } else if (paths.size() < kMaxDirectories) {
+            paths.emplace(directory.path, true);
+        }
+    }
+
+    // 同一目录再次加入时 inotify 返回原来的描述符，只需移除不再需要的
+    std::map<int, std::string> watches;
+    for (const auto& path : paths) {
+        int wd = inotify_add_watch(m_inotify, path.first.c_str(), kWatchMask);
+        if (wd >= 0) watches[wd] = path.first;
+    }
+    for (const auto& watch : m_watches) {
+        if (watches.find(watch.first) == watches.end()) inotify_rm_watch(m_inotify, watch.first);
+    }
+    m_watches.swap(watches);
+    return (uint32_t)m_watches.size();
+}
+
+void ConfigWatcher::Notifier::Wait(int timeoutMs, const EventSink& sink) {
+    pollfd fds[2] = {};
+    fds[0].fd = m_wakeFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_inotify;
+    fds[1].events = POLLIN;
+    if (poll(fds, 2, timeoutMs) <= 0) return;
+    if (fds[0].revents & POLLIN) {
+        uint64_t value;
+        if (read(m_wakeFd, &value, sizeof(value)) < 0) {
+            // 非阻塞读取，已被其他唤醒清零时忽略
+        }
+    }
+    if (!(fds[1].revents & POLLIN)) return;
+
+    alignas(inotify_event) char buffer[16384];
+    while (true) {
+        ssize_t length = read(m_inotify, buffer, sizeof(buffer));
+        if (length <= 0) break;
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += (ssize_t)(sizeof(inotify_event) + event->len);
+            if (event->mask & IN_Q_OVERFLOW) {
+                sink(std::string());
+                continue;
+            }
+            auto watch = m_watches.find(event->wd);
+            if (watch == m_watches.end()) continue;
+            if (event->mask & IN_IGNORED) {
+                // 目录被删除或已移除监视
+                m_watches.erase(watch);
+                continue;
+            }
+            sink(event->len > 0 ? watch->second + "/" + event->name : watch->second);
+        }
+    }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// ConfigWatcher
+
+ConfigWatcher::~ConfigWatcher() {
+    Stop();
+}
+
+void ConfigWatcher::SetHandler(ChangeHandler handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_handler = handler;
+}
+
+void ConfigWatcher::SetOptions(const ConfigWatchOptions& options) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options = options;
+}
+
+void ConfigWatcher::Start(const std::string& confPath) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_worker.joinable() && confPath == m_confPath) return;
+        if (!m_worker.joinable() && !m_options.enabled) return;
+    }
+    Stop();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats = ConfigWatchStats();
+    m_stopping = false;
+    m_confPath = confPath;
+    if (m_options.enabled) m_worker = std::thread(&ConfigWatcher::Run, this, confPath);
+}
+
+void ConfigWatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    Wake();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+void ConfigWatcher::Wake() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_notifier) m_notifier->Wake();
+}
+
+ConfigWatchStats ConfigWatcher::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void ConfigWatcher::Run(std::string confPath) {
+    TraceSetThreadName("conf-watcher");
+    Notifier notifier;
+    std::string error;
+    if (!notifier.Open(&error)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.error = error;
+        return;
+    }
+    ConfigWatchOptions options;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_notifier = &notifier;
+        options = m_options;
+        m_stats.running = true;
+    }
+
+    // 指纹只用于判断防抖后内容是否真的变了，不含 nginx 可执行文件
+    NginxConfig config;
+    std::string parseError;
+    bool loaded = config.Load(confPath, &parseError);
+    uint64_t fingerprint = loaded ? ConfigFingerprint(config, std::string()) : 0;
+    uint32_t directories = notifier.Watch(WatchDirectories(confPath, loaded ? &config : nullptr));
+    config.Clear();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.directories = directories;
+    }
+
+    ConfigChange change;
+    bool pending = false;
+    uint64_t lastEvent = 0;
+    uint32_t events = 0;
+    uint32_t overflows = 0;
+    Notifier::EventSink sink = [&](const std::string& path) {
+        uint64_t now = MonotonicMicros();
+        if (!pending) {
+            pending = true;
+            change.firstMicros = now;
+        }
+        lastEvent = now;
+        ++change.events;
+        ++events;
+        if (path.empty()) {
+            change.overflow = true;
+            ++overflows;
+            return;
+        }
+        if (IsEditorTempFile(BaseName(path))) return;
+        if (std::find(change.files.begin(), change.files.end(), path) != change.files.end()) return;
+        if (change.files.size() < ConfigChange::kMaxFiles) {
+            change.files.push_back(path);
+        } else {
+            change.overflow = true;
+        }
+    };
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) break;
+            m_stats.events += events;
+            m_stats.overflows += overflows;
+        }
+        events = overflows = 0;
+
+        uint64_t due = pending ? std::min(lastEvent + options.debounceMs * 1000ull,
+                                          change.firstMicros + options.maxDelayMs * 1000ull)
+                               : UINT64_MAX;
+        uint64_t now = MonotonicMicros();
+        if (now < due) {
+            int timeoutMs = due == UINT64_MAX ? -1 : (int)((due - now + 999) / 1000);
+            notifier.Wait(timeoutMs, sink);
+            continue;
+        }
+
+        // 防抖结束：重新解析配置，内容未变时忽略；include 可能已变化，同时更新监视的目录
+        change.settledMicros = now;
+        loaded = config.Load(confPath, &parseError);
+        uint64_t next = loaded ? ConfigFingerprint(config, std::string()) : 0;
+        directories = notifier.Watch(WatchDirectories(confPath, loaded ? &config : nullptr));
+        config.Clear();
+        bool changed = !loaded || next != fingerprint;
+        fingerprint = next;
+        if (!loaded) change.parseError = parseError;
+
+        ChangeHandler handler;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stats.directories = directories;
+            ++(changed ? m_stats.changes : m_stats.ignored);
+            handler = m_handler;
+        }
+        if (changed && handler) handler(change);
+        change = ConfigChange();
+        pending = false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_notifier = nullptr;
+    m_stats.running = false;
+}
+
+std::string FormatConfigChange(const ConfigChange& change) {
+    std::string text;
+    for (size_t i = 0; i < change.files.size() && i < 3; ++i) {
+        if (i > 0) text += "、";
+        text += BaseName(change.files[i]);
+    }
+    if (change.files.size() > 3 || (change.overflow && !change.files.empty())) {
+        text += " 等 " + std::to_string(change.files.size()) + (change.overflow ? "+" : "") + " 个文件";
+    } else if (text.empty()) {
+        text = change.overflow ? "事件过多，未能确定哪些文件" : "配置目录";
+    }
+    char suffix[96];
+    snprintf(suffix, sizeof(suffix), " (%u 个事件, 防抖 %.0f ms)", change.events,
+             (change.settledMicros - change.firstMicros) / 1000.0);
+    return text + suffix;
+}
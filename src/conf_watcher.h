@@ -0,0 +1,86 @@
+// nginx-manager/src/conf_watcher.h
+// 配置监视 - 监视 conf 目录与 include 引用的目录 (inotify / ReadDirectoryChangesW)，连续的修改防抖合并为一次变更后回调
+
+#ifndef CONF_WATCHER_H
+#define CONF_WATCHER_H
+
+#include "nginx_conf.h"
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ConfigWatchOptions {
+    bool enabled = true;
+    uint32_t debounceMs = 300;       // 最后一次修改后保持这么久没有新的修改才算一次变更
+    uint32_t maxDelayMs = 5000;      // 持续写入时，距第一次修改最迟这么久也要处理一次
+};
+
+// 防抖合并后的一次配置变更
+struct ConfigChange {
+    std::vector<std::string> files;  // 变化的文件（去重，至多 kMaxFiles 个）
+    uint32_t events = 0;             // 合并的文件系统事件数
+    bool overflow = false;           // 事件队列溢出或文件过多，files 不完整
+    uint64_t firstMicros = 0;        // 第一个事件的时刻（MonotonicMicros），即保存配置的时刻
+    uint64_t settledMicros = 0;      // 防抖结束的时刻
+    std::string parseError;          // 变更后的配置无法解析时的原因（nginx -t 会给出完整诊断）
+
+    static const size_t kMaxFiles = 16;
+};
+
+struct ConfigWatchStats {
+    bool running = false;
+    std::string error;               // 无法开始监视的原因
+    uint32_t directories = 0;        // 正在监视的目录数
+    uint64_t events = 0;
+    uint64_t changes = 0;            // 回调的变更数
+    uint64_t ignored = 0;            // 防抖后内容未变（编辑器临时文件、touch 等）而忽略的
+    uint64_t overflows = 0;
+};
+
+// 配置监视
+// 监视主配置文件所在目录（含子目录），以及配置中 include 到的、位于该目录以外的文件和通配符所在目录。
+// 文件系统事件按 debounceMs 防抖合并，结束后重新解析配置：
+// 配置指纹（include 展开后的内容与证书等外部文件）与上次相同时忽略，否则回调一次，并按新的 include 更新监视的目录。
+// 回调在监视线程中进行，不要在其中执行耗时的操作（应转交操作队列）。
+class ConfigWatcher {
+public:
+    typedef std::function<void(const ConfigChange& change)> ChangeHandler;
+
+    ConfigWatcher() {}
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // 在 Start 之前调用
+    void SetHandler(ChangeHandler handler);
+    void SetOptions(const ConfigWatchOptions& options);
+
+    // 开始监视 confPath 及其 include，路径未变时为空操作；options.enabled 为 false 时不监视
+    void Start(const std::string& confPath);
+    void Stop();
+
+    ConfigWatchStats Stats() const;
+
+private:
+    class Notifier;                  // 平台相关的目录监视，只在监视线程中存在
+
+    void Run(std::string confPath);
+    void Wake();
+
+    std::thread m_worker;
+    mutable std::mutex m_mutex;
+    std::string m_confPath;
+    ConfigWatchOptions m_options;
+    ChangeHandler m_handler;
+    bool m_stopping = false;
+    Notifier* m_notifier = nullptr;  // 监视线程运行期间有效，Wake 通过它唤醒等待
+    ConfigWatchStats m_stats;
+};
+
+// 变更的一行说明（UTF-8），如 "nginx.conf、a.conf (3 个事件, 防抖 300 ms)"
+std::string FormatConfigChange(const ConfigChange& change);
+
+#endif // CONF_WATCHER_H
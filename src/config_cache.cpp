@@ -0,0 +1,119 @@
+// nginx-manager/src/config_cache.cpp
+// 配置校验缓存 - 以配置内容哈希为键缓存 nginx -t 的结论，配置未变时不再重复校验
+
+#include "config_cache.h"
+#include "content_hash.h"
+#include "file_util.h"
+#include "nginx_control.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+// nginx -t 会读取但不属于 include 树的外部文件，只取大小与修改时间
+static const char* const kExternalFileDirectives[] = {
+    "ssl_certificate", "ssl_certificate_key", "ssl_trusted_certificate",
+    "ssl_client_certificate", "ssl_crl", "ssl_dhparam", "ssl_stapling_file",
+    "ssl_password_file", "ssl_session_ticket_key", "auth_basic_user_file",
+    "proxy_ssl_certificate", "proxy_ssl_certificate_key", "proxy_ssl_trusted_certificate",
+};
+
+// 文件大小与修改时间，不存在时均为 0
+static void AddFileIdentity(ContentHasher* hasher, const std::string& path) {
+    uint64_t size = 0;
+    uint64_t mtime = 0;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExW(Utf8ToWide(path).c_str(), GetFileExInfoStandard, &data)) {
+        size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+        mtime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    }
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+        size = (uint64_t)st.st_size;
+        mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + (uint64_t)st.st_mtim.tv_nsec;
+    }
+#endif
+    hasher->Add(path);
+    hasher->Add(size);
+    hasher->Add(mtime);
+}
+
+uint64_t ConfigFingerprint(const NginxConfig& config, const std::string& binaryPath) {
+    TraceSpan span(TRACE_CONFIG, "config-fingerprint");
+    ContentHasher hasher;
+
+    const std::vector<std::string>& files = config.Files();
+    hasher.Add((uint64_t)files.size());
+    for (uint32_t i = 0; i < (uint32_t)files.size(); ++i) {
+        const MappedFile& content = config.FileContent(i);
+        hasher.Add(files[i]);
+        hasher.AddBytes(content.Data(), content.Size());
+    }
+
+    for (const char* name : kExternalFileDirectives) {
+        for (uint32_t index : config.FindByName(name)) {
+            if (config.At(index).argCount == 0) continue;
+            std::string_view arg = config.Arg(index, 0);
+            // 含变量的路径在请求时才确定，nginx -t 不会读取
+            if (arg.find('$') != std::string_view::npos || arg.compare(0, 5, "data:") == 0) continue;
+            std::string path = IsAbsolutePath(arg) ? std::string(arg) : config.ConfPrefix() + "/" + std::string(arg);
+            AddFileIdentity(&hasher, path);
+        }
+    }
+
+    AddFileIdentity(&hasher, binaryPath);
+    return hasher.Digest();
+}
+
+ValidationVerdict ValidationCache::Validate(const std::string& prefix, const std::string& confPath,
+                                            NginxConfig* config) {
+    ValidationVerdict verdict;
+
+    uint64_t begin = MonotonicMicros();
+    std::string parseError;
+    verdict.parsed = config->Load(confPath, &parseError);
+    if (verdict.parsed) {
+        verdict.fingerprint = ConfigFingerprint(*config, NginxBinaryPath(prefix));
+    }
+    verdict.hashMicros = MonotonicMicros() - begin;
+
+    if (verdict.parsed) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            if (m_entries[i].fingerprint != verdict.fingerprint) continue;
+            Entry entry = std::move(m_entries[i]);
+            m_entries.erase(m_entries.begin() + i);
+            verdict.ok = true;
+            verdict.output = entry.output;
+            verdict.cached = true;
+            m_entries.push_back(std::move(entry));
+            return verdict;
+        }
+    }
+
+    // 未命中：运行 nginx -t。解析失败时同样交给 nginx 给出权威诊断，但结论不缓存
+    std::vector<std::string> args;
+    args.push_back("-t");
+    int exitCode = 1;
+    begin = MonotonicMicros();
+    bool finished = RunNginxCommand(prefix, args, 30000, &exitCode, &verdict.output);
+    verdict.testMicros = MonotonicMicros() - begin;
+    if (TraceEnabled()) TraceRecord(TRACE_PROCESS, "nginx -t", begin, begin + verdict.testMicros);
+    verdict.ok = finished && exitCode == 0;
+    if (!finished && verdict.output.empty()) verdict.output = "nginx -t 执行失败或超时";
+
+    // 只缓存通过的结论：失败可能来自配置以外的环境（日志 / pid 目录缺失、权限、端口暂时被占用），
+    // 用户修正后指纹不变，缓存的失败会一直沿用；超时等异常结束同样不代表配置本身的结论
+    if (verdict.parsed && verdict.ok) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_entries.size() >= m_capacity && !m_entries.empty()) m_entries.erase(m_entries.begin());
+        Entry entry;
+        entry.fingerprint = verdict.fingerprint;
+        entry.output = verdict.output;
+        m_entries.push_back(std::move(entry));
+    }
+    return verdict;
+}
@@ -0,0 +1,45 @@
+// nginx-manager/src/config_cache.h
+// 配置校验缓存 - 以配置内容哈希为键缓存 nginx -t 的结论，配置未变时不再重复校验
+
+#ifndef CONFIG_CACHE_H
+#define CONFIG_CACHE_H
+
+#include "nginx_conf.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 一次校验的结论
+struct ValidationVerdict {
+    bool ok = false;
+    bool cached = false;             // 结论来自缓存，未运行 nginx -t
+    bool parsed = false;             // 配置已由 NginxConfig 成功解析（否则无法计算指纹，不缓存）
+    uint64_t fingerprint = 0;
+    uint64_t hashMicros = 0;         // 解析配置并计算指纹的耗时
+    uint64_t testMicros = 0;         // nginx -t 耗时，命中缓存时为 0
+    std::string output;              // nginx -t 的诊断输出
+};
+
+// 计算配置指纹：include 展开后每个文件的路径与内容、证书等外部文件的大小与修改时间、nginx 可执行文件的标识
+uint64_t ConfigFingerprint(const NginxConfig& config, const std::string& binaryPath);
+
+// nginx -t 结论缓存，最近使用的若干条指纹各保留一份通过的结论（失败不缓存，每次重新校验），线程安全
+class ValidationCache {
+public:
+    explicit ValidationCache(size_t capacity = 8) : m_capacity(capacity) {}
+
+    // 解析 confPath 到 config（供调用方继续使用），指纹命中则直接返回缓存结论，否则运行 nginx -t
+    ValidationVerdict Validate(const std::string& prefix, const std::string& confPath, NginxConfig* config);
+
+private:
+    struct Entry {
+        uint64_t fingerprint = 0;
+        std::string output;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;    // 按最近使用排序，末尾最新
+    size_t m_capacity;
+};
+
+#endif // CONFIG_CACHE_H
@@ -0,0 +1,33 @@
+// nginx-manager/src/content_hash.h
+// 内容哈希 - 64 位 xxHash (XXH64)，用于配置指纹等需要快速比较大块内容的场合
+
+#ifndef CONTENT_HASH_H
+#define CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 计算一段内存的 XXH64 值
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t HashString(std::string_view text, uint64_t seed = 0) {
+    return HashBytes(text.data(), text.size(), seed);
+}
+
+// 逐项累积多个值，顺序不同结果不同
+class ContentHasher {
+public:
+    explicit ContentHasher(uint64_t seed = 0) : m_state(seed) {}
+
+    void Add(uint64_t value) { m_state = HashBytes(&value, sizeof(value), m_state); }
+    void Add(std::string_view text) { Add(text.size()); m_state = HashString(text, m_state); }
+    void AddBytes(const void* data, size_t size) { Add((uint64_t)size); m_state = HashBytes(data, size, m_state); }
+
+    uint64_t Digest() const { return m_state; }
+
+private:
+    uint64_t m_state;
+};
+
+#endif // CONTENT_HASH_H
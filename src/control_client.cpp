@@ -0,0 +1,149 @@
+// nginx-manager/src/control_client.cpp
+// 控制通道客户端 - 连接无界面模式的控制端点，发送请求并等待响应
+
+#include "control_client.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+bool ControlClient::Connect(const std::string& endpoint, uint32_t timeoutMs, std::string* error) {
+    Close();
+    m_reader = ControlFrameReader();
+#ifdef _WIN32
+    std::wstring name = Utf8ToWide(endpoint);
+    uint64_t deadline = MonotonicMicros() + (uint64_t)timeoutMs * 1000;
+    for (;;) {
+        m_pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        if (m_pipe != INVALID_HANDLE_VALUE) return true;
+        DWORD code = GetLastError();
+        uint64_t now = MonotonicMicros();
+        // 所有监听实例都刚被占用：等服务端补上新的实例
+        if (code != ERROR_PIPE_BUSY || now >= deadline) {
+            if (error) {
+                *error = code == ERROR_FILE_NOT_FOUND ? "控制端点不存在（无界面模式未运行？）: " + endpoint
+                                                      : "无法连接控制端点: " + endpoint + " (错误 " + std::to_string(code) + ")";
+            }
+            return false;
+        }
+        WaitNamedPipeW(name.c_str(), (DWORD)((deadline - now) / 1000 + 1));
+    }
+#else
+    (void)timeoutMs;
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (endpoint.empty() || endpoint.size() >= sizeof(address.sun_path)) {
+        if (error) *error = "控制套接字路径无效: " + endpoint;
+        return false;
+    }
+    memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0 || connect(m_fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        int code = errno;
+        if (error) {
+            *error = (code == ENOENT || code == ECONNREFUSED) ? "控制端点不存在（无界面模式未运行？）: " + endpoint
+                                                             : "无法连接控制端点: " + endpoint + " (" + strerror(code) + ")";
+        }
+        Close();
+        return false;
+    }
+    return true;
+#endif
+}
+
+void ControlClient::Close() {
+#ifdef _WIN32
+    if (m_pipe != INVALID_HANDLE_VALUE) CloseHandle(m_pipe);
+    m_pipe = INVALID_HANDLE_VALUE;
+#else
+    if (m_fd >= 0) close(m_fd);
+    m_fd = -1;
+#endif
+}
+
+bool ControlClient::IsConnected() const {
+#ifdef _WIN32
+    return m_pipe != INVALID_HANDLE_VALUE;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+bool ControlClient::WriteAll(const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD written = 0;
+        if (!WriteFile(m_pipe, data, (DWORD)size, &written, NULL)) return false;
+#else
+        ssize_t written = send(m_fd, data, size, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+#endif
+        data += written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+bool ControlClient::ReadSome() {
+    char buffer[16 * 1024];
+#ifdef _WIN32
+    DWORD got = 0;
+    if (!ReadFile(m_pipe, buffer, sizeof(buffer), &got, NULL) || got == 0) return false;
+#else
+    ssize_t got;
+    do {
+        got = read(m_fd, buffer, sizeof(buffer));
+    } while (got < 0 && errno == EINTR);
+    if (got <= 0) return false;
+#endif
+    m_reader.Feed(buffer, (size_t)got);
+    return true;
+}
+
+bool ControlClient::Send(uint32_t id, uint8_t command, const std::string& payload, std::string* error) {
+    if (!IsConnected()) {
+        if (error) *error = "未连接";
+        return false;
+    }
+    m_sendBuffer.clear();
+    AppendControlFrame(&m_sendBuffer, id, command, payload);
+    if (!WriteAll(m_sendBuffer.data(), m_sendBuffer.size())) {
+        if (error) *error = "发送请求失败，连接已断开";
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool ControlClient::Receive(ControlFrame* response, std::string* error) {
+    while (!m_reader.Next(response)) {
+        if (m_reader.Failed()) {
+            if (error) *error = "响应格式错误";
+            Close();
+            return false;
+        }
+        if (!IsConnected() || !ReadSome()) {
+            if (error) *error = "连接已断开";
+            Close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ControlClient::Call(uint8_t command, const std::string& payload, ControlFrame* response, std::string* error) {
+    uint32_t id = m_nextId++;
+    if (!Send(id, command, payload, error)) return false;
+    // 之前用 Send 发出的请求的响应可能先到，跳过
+    do {
+        if (!Receive(response, error)) return false;
+    } while (response->id != id);
+    return true;
+}
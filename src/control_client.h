@@ -0,0 +1,47 @@
+// nginx-manager/src/control_client.h
+// 控制通道客户端 - 连接无界面模式的控制端点，发送请求并等待响应
+
+#ifndef CONTROL_CLIENT_H
+#define CONTROL_CLIENT_H
+
+#include "control_protocol.h"
+#include "platform.h"
+#include <string>
+
+// 阻塞式客户端，一个连接可以连续发送多个请求
+class ControlClient {
+public:
+    ControlClient() {}
+    ~ControlClient() { Close(); }
+
+    ControlClient(const ControlClient&) = delete;
+    ControlClient& operator=(const ControlClient&) = delete;
+
+    // 连接控制端点；Windows 上所有管道实例都忙时最多等待 timeoutMs
+    bool Connect(const std::string& endpoint, uint32_t timeoutMs, std::string* error);
+    void Close();
+    bool IsConnected() const;
+
+    // 发送请求并等待同一 ID 的响应
+    bool Call(uint8_t command, const std::string& payload, ControlFrame* response, std::string* error);
+
+    // 只发送 / 只接收，用于连续发送多个请求后再依次读取响应
+    bool Send(uint32_t id, uint8_t command, const std::string& payload, std::string* error);
+    bool Receive(ControlFrame* response, std::string* error);
+
+private:
+    bool WriteAll(const char* data, size_t size);
+    // 读取可用数据，连接关闭或出错时返回 false
+    bool ReadSome();
+
+#ifdef _WIN32
+    HANDLE m_pipe = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+    ControlFrameReader m_reader;
+    std::string m_sendBuffer;
+    uint32_t m_nextId = 1;
+};
+
+#endif // CONTROL_CLIENT_H
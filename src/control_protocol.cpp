@@ -0,0 +1,140 @@
+// nginx-manager/src/control_protocol.cpp
+// 控制通道协议 - 长度前缀的请求/响应帧，用于无界面模式下的本地控制 (Unix 域套接字 / 命名管道)
+
+#include "control_protocol.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static const char* const kCommandNames[] = {
+    "", "ping", "status", "metrics", "start", "stop", "restart", "reload", "affinity", "apply-affinity", "rotate",
+    "loadtest", "compare", "upstreams", "logquery", "trace", "journal"
+};
+
+const char* ControlCommandName(int command) {
+    if (command <= 0 || command > CONTROL_JOURNAL) return "unknown";
+    return kCommandNames[command];
+}
+
+int ControlCommandFromName(const std::string& name) {
+    std::string lower = name;
+    for (char& c : lower) {
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    }
+    for (int command = CONTROL_PING; command <= CONTROL_JOURNAL; ++command) {
+        if (lower == kCommandNames[command]) return command;
+    }
+    return 0;
+}
+
+const char* ControlStatusName(int status) {
+    switch (status) {
+        case CONTROL_OK: return "ok";
+        case CONTROL_FAILED: return "failed";
+        case CONTROL_BAD_REQUEST: return "bad-request";
+        case CONTROL_CANCELLED: return "cancelled";
+        case CONTROL_UNAVAILABLE: return "unavailable";
+        default: return "unknown";
+    }
+}
+
+std::string DefaultControlEndpoint() {
+#ifdef _WIN32
+    return "\\\\.\\pipe\\nginx-manager";
+#else
+    const char* runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0] == '/') return std::string(runtime) + "/nginx-manager.sock";
+    return "/tmp/nginx-manager-" + std::to_string((unsigned)getuid()) + ".sock";
+#endif
+}
+
+static void PutU32(char* out, uint32_t value) {
+    out[0] = (char)(value & 0xFF);
+    out[1] = (char)((value >> 8) & 0xFF);
+    out[2] = (char)((value >> 16) & 0xFF);
+    out[3] = (char)((value >> 24) & 0xFF);
+}
+
+static uint32_t GetU32(const char* in) {
+    return (uint32_t)(uint8_t)in[0] | ((uint32_t)(uint8_t)in[1] << 8) |
+           ((uint32_t)(uint8_t)in[2] << 16) | ((uint32_t)(uint8_t)in[3] << 24);
+}
+
+void AppendControlFrame(std::string* out, uint32_t id, uint8_t code, const std::string& payload) {
+    char header[kControlHeaderSize];
+    PutU32(header, (uint32_t)(payload.size() + 5));
+    PutU32(header + 4, id);
+    header[8] = (char)code;
+    out->append(header, sizeof(header));
+    out->append(payload);
+}
+
+void ControlFrameReader::Feed(const char* data, size_t size) {
+    if (m_offset > 0 && m_offset >= m_buffer.size() / 2) {
+        m_buffer.erase(0, m_offset);
+        m_offset = 0;
+    }
+    m_buffer.append(data, size);
+}
+
+bool ControlFrameReader::Next(ControlFrame* frame) {
+    if (m_failed || m_buffer.size() - m_offset < 4) return false;
+    const char* begin = m_buffer.data() + m_offset;
+    uint32_t length = GetU32(begin);
+    if (length < 5 || length > kControlMaxFrame) {
+        m_failed = true;
+        return false;
+    }
+    if (m_buffer.size() - m_offset < 4 + (size_t)length) return false;
+
+    frame->id = GetU32(begin + 4);
+    frame->code = (uint8_t)begin[8];
+    frame->payload.assign(begin + kControlHeaderSize, length - 5);
+    m_offset += 4 + length;
+    if (m_offset == m_buffer.size()) {
+        m_buffer.clear();
+        m_offset = 0;
+    }
+    return true;
+}
+
+void AppendField(std::string* payload, const char* key, const std::string& value) {
+    *payload += key;
+    *payload += '=';
+    for (char c : value) {
+        *payload += (c == '\n' || c == '\r') ? ' ' : c;
+    }
+    *payload += '\n';
+}
+
+void AppendField(std::string* payload, const char* key, uint64_t value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+    AppendField(payload, key, std::string(text));
+}
+
+void AppendField(std::string* payload, const char* key, double value) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.3f", value);
+    AppendField(payload, key, std::string(text));
+}
+
+std::vector<std::pair<std::string, std::string>> ParseFields(const std::string& payload) {
+    std::vector<std::pair<std::string, std::string>> fields;
+    size_t begin = 0;
+    while (begin < payload.size()) {
+        size_t end = payload.find('\n', begin);
+        if (end == std::string::npos) end = payload.size();
+        size_t equals = payload.find('=', begin);
+        if (equals != std::string::npos && equals < end) {
+            fields.emplace_back(payload.substr(begin, equals - begin), payload.substr(equals + 1, end - equals - 1));
+        }
+        begin = end + 1;
+    }
+    return fields;
+}
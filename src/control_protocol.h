@@ -0,0 +1,87 @@
+// nginx-manager/src/control_protocol.h
+// 控制通道协议 - 长度前缀的请求/响应帧，用于无界面模式下的本地控制 (Unix 域套接字 / 命名管道)
+
+#ifndef CONTROL_PROTOCOL_H
+#define CONTROL_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 帧格式（整数均为小端）:
+//   u32 length    之后的字节数 (5 + payload)
+//   u32 id        请求 ID，响应原样带回；同一连接上可以连续发送多个请求，响应可能乱序返回
+//   u8  code      请求中为命令，响应中为状态
+//   payload       UTF-8 文本，"key=value" 每行一项
+const size_t kControlHeaderSize = 9;
+const uint32_t kControlMaxFrame = 1024 * 1024;
+
+enum ControlCommand {
+    CONTROL_PING = 1,
+    CONTROL_STATUS = 2,
+    CONTROL_METRICS = 3,
+    CONTROL_START = 4,
+    CONTROL_STOP = 5,
+    CONTROL_RESTART = 6,
+    CONTROL_RELOAD = 7,
+    CONTROL_AFFINITY = 8,            // CPU 拓扑、绑定计划与 worker 的实际绑定
+    CONTROL_APPLY_AFFINITY = 9,      // 写入绑定计划并重新加载；payload 可带 workers=<n>、smt=1
+    CONTROL_ROTATE = 10,             // 立即轮转所有非空日志
+    CONTROL_LOADTEST = 11,           // 对本机的 nginx 压测并按配置指纹保存结果；payload 可带 connections=、rate=、duration= 等
+    CONTROL_COMPARE = 12,            // 对比两份配置最近一次的压测结果；payload 可带 base=<指纹前缀> other=<指纹前缀>
+    CONTROL_UPSTREAMS = 13,          // upstream 健康检查结果，每个 upstream 及其 server 各一行
+    CONTROL_LOGQUERY = 14,           // 先导入新的日志归档，再对访问日志列存做聚合查询；payload 可带 from=、status=、group= 等
+    CONTROL_TRACE = 15,              // 各追踪区间的耗时统计；payload 可带 enable=0|1 开启 / 关闭追踪，export=<文件名.json>|1 导出 Chrome trace JSON 到 logs 目录
+    CONTROL_JOURNAL = 16             // 按时间查询持久化的操作日志；payload 可带 from=、to=、type=log|event|operation、limit=
+};
+
+enum ControlStatus {
+    CONTROL_OK = 0,
+    CONTROL_FAILED = 1,              // 操作已执行但失败（payload 中有 error）
+    CONTROL_BAD_REQUEST = 2,         // 未知命令或参数错误
+    CONTROL_CANCELLED = 3,           // 被后续的启动 / 停止 / 重启操作取代
+    CONTROL_UNAVAILABLE = 4          // 服务正在关闭
+};
+
+const char* ControlCommandName(int command);
+// 按名称查找命令（不区分大小写），未知时返回 0
+int ControlCommandFromName(const std::string& name);
+const char* ControlStatusName(int status);
+
+// 默认控制端点：Linux 为 $XDG_RUNTIME_DIR/nginx-manager.sock（或 /tmp/nginx-manager-<uid>.sock），
+// Windows 为 \\.\pipe\nginx-manager
+std::string DefaultControlEndpoint();
+
+struct ControlFrame {
+    uint32_t id = 0;
+    uint8_t code = 0;
+    std::string payload;
+};
+
+// 把一帧追加到发送缓冲
+void AppendControlFrame(std::string* out, uint32_t id, uint8_t code, const std::string& payload);
+
+// 增量解帧：读到多少喂多少，Next 依次取出完整的帧
+class ControlFrameReader {
+public:
+    void Feed(const char* data, size_t size);
+    // 取出下一帧；数据不足或帧长度非法时返回 false，后者同时置 Failed
+    bool Next(ControlFrame* frame);
+    bool Failed() const { return m_failed; }
+    size_t Buffered() const { return m_buffer.size() - m_offset; }
+
+private:
+    std::string m_buffer;
+    size_t m_offset = 0;             // 已取出的字节，攒到一定量才整体前移，避免每帧 erase
+    bool m_failed = false;
+};
+
+// payload 的 "key=value" 行
+void AppendField(std::string* payload, const char* key, const std::string& value);
+void AppendField(std::string* payload, const char* key, uint64_t value);
+void AppendField(std::string* payload, const char* key, double value);
+std::vector<std::pair<std::string, std::string>> ParseFields(const std::string& payload);
+
+#endif // CONTROL_PROTOCOL_H
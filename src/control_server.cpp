@@ -0,0 +1,706 @@
+// nginx-manager/src/control_server.cpp
+// 控制通道服务端 - 单线程事件循环 (epoll / 命名管道 + IOCP) 同时服务多个本地客户端
+
+#include "control_server.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// 客户端长期不读响应时，待发送数据超过这个量就断开连接
+static const size_t kMaxPendingOutput = 8 * 1024 * 1024;
+static const size_t kReadChunk = 64 * 1024;
+
+#ifdef _WIN32
+#ifndef PIPE_REJECT_REMOTE_CLIENTS
+#define PIPE_REJECT_REMOTE_CLIENTS 0x00000008
+#endif
+
+// 同时挂起的监听实例数，突发连接时不必等上一个连接建立完成
+static const int kListenInstances = 4;
+static const ULONG_PTR kWakeKey = 1;
+
+enum PipeOp { PIPE_OP_CONNECT, PIPE_OP_READ, PIPE_OP_WRITE };
+#else
+static const uint64_t kListenKey = 1;
+static const uint64_t kWakeKey = 2;
+#endif
+
+struct ControlServer::Connection {
+    uint64_t id = 0;
+    ControlFrameReader reader;
+    std::string out;                 // 待发送的响应
+    bool closing = false;
+#ifdef _WIN32
+    struct PipeIo {
+        OVERLAPPED overlapped;
+        PipeOp op;
+        Connection* owner;
+    };
+
+    HANDLE pipe = INVALID_HANDLE_VALUE;
+    PipeIo readIo;
+    PipeIo writeIo;
+    char readBuffer[kReadChunk];
+    std::string writing;             // 正在写出的数据，写完成前不能改动
+    bool connected = false;
+    bool readPending = false;
+    bool writePending = false;
+#else
+    int fd = -1;
+    size_t outOffset = 0;
+    bool wantWrite = false;
+#endif
+};
+
+ControlServer::ControlServer() {
+}
+
+ControlServer::~ControlServer() {
+    Stop();
+}
+
+ControlServerStats ControlServer::Stats() const {
+    ControlServerStats stats;
+    stats.accepted = m_accepted.load();
+    stats.open = m_open.load();
+    stats.requests = m_requests.load();
+    stats.responses = m_responses.load();
+    stats.protocolErrors = m_protocolErrors.load();
+    stats.dropped = m_dropped.load();
+    return stats;
+}
+
+ControlServer::Connection* ControlServer::Find(uint64_t id) {
+    auto it = m_connections.find(id);
+    return it == m_connections.end() ? nullptr : it->second.get();
+}
+
+void ControlServer::Respond(uint64_t connection, uint32_t id, uint8_t status, const std::string& payload) {
+    if (std::this_thread::get_id() == m_loopThread) {
+        Connection* conn = Find(connection);
+        if (!conn || conn->closing) {
+            ++m_dropped;
+            return;
+        }
+        // 先攒在连接的发送缓冲里，这一批请求处理完后统一写出
+        if (conn->out.empty()) m_dirty.push_back(connection);
+        AppendControlFrame(&conn->out, id, status, payload);
+        ++m_responses;
+        return;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_stopping) {
+            ++m_dropped;
+            return;
+        }
+        wake = m_queue.empty();
+        m_queue.push_back(Outgoing{connection, id, status, payload});
+    }
+    // 队列非空时事件循环已被唤醒过，会一并取走
+    if (!wake) return;
+#ifdef _WIN32
+    PostQueuedCompletionStatus(m_iocp, 0, kWakeKey, NULL);
+#else
+    uint64_t one = 1;
+    ssize_t written = write(m_wakeFd, &one, sizeof(one));
+    (void)written;
+#endif
+}
+
+void ControlServer::DrainQueue() {
+    std::vector<Outgoing> queue;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        queue.swap(m_queue);
+    }
+    for (const Outgoing& item : queue) {
+        Connection* conn = Find(item.connection);
+        if (!conn || conn->closing) {
+            ++m_dropped;
+            continue;
+        }
+        if (conn->out.empty()) m_dirty.push_back(item.connection);
+        AppendControlFrame(&conn->out, item.id, item.status, item.payload);
+        ++m_responses;
+    }
+}
+
+void ControlServer::Dispatch(Connection* conn) {
+    ControlFrame frame;
+    ControlRequest request;
+    request.connection = conn->id;
+    while (!conn->closing && conn->reader.Next(&frame)) {
+        ++m_requests;
+        request.id = frame.id;
+        request.command = frame.code;
+        request.payload.swap(frame.payload);
+        m_handler(request);
+    }
+    if (conn->reader.Failed()) {
+        ++m_protocolErrors;
+        CloseConnection(conn);
+    }
+}
+
+#ifdef _WIN32
+
+// ==================== Windows: 命名管道 + IOCP ====================
+
+bool ControlServer::Start(const std::string& endpoint, Handler handler, std::string* error) {
+    Stop();
+    m_endpoint = endpoint;
+    m_handler = handler;
+    m_pipeName = Utf8ToWide(endpoint);
+    m_stopping = false;
+
+    m_iocp = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!m_iocp) {
+        if (error) *error = "无法创建完成端口";
+        return false;
+    }
+    for (int i = 0; i < kListenInstances; ++i) {
+        if (!CreateListener(error)) {
+            for (Connection* listener : m_listeners) {
+                CloseHandle(listener->pipe);
+                delete listener;
+            }
+            m_listeners.clear();
+            CloseHandle(m_iocp);
+            m_iocp = NULL;
+            return false;
+        }
+    }
+    m_loop = std::thread(&ControlServer::Run, this);
+    return true;
+}
+
+bool ControlServer::CreateListener(std::string* error) {
+    // 第一个实例带 FILE_FLAG_FIRST_PIPE_INSTANCE，管道名已被其他进程占用时直接失败
+    DWORD openMode = PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED;
+    if (m_listeners.empty() && m_connections.empty()) openMode |= FILE_FLAG_FIRST_PIPE_INSTANCE;
+    HANDLE pipe = CreateNamedPipeW(m_pipeName.c_str(), openMode,
+                                   PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                   PIPE_UNLIMITED_INSTANCES, (DWORD)kReadChunk, (DWORD)kReadChunk, 0, NULL);
+    if (pipe == INVALID_HANDLE_VALUE) {
+        DWORD code = GetLastError();
+        if (error) {
+            *error = code == ERROR_ACCESS_DENIED ? "控制管道已被占用: " + m_endpoint
+                                                 : "无法创建控制管道: " + m_endpoint + " (错误 " + std::to_string(code) + ")";
+        }
+        return false;
+    }
+    if (!CreateIoCompletionPort(pipe, m_iocp, 0, 0)) {
+        CloseHandle(pipe);
+        if (error) *error = "无法关联完成端口";
+        return false;
+    }
+
+    Connection* conn = new Connection();
+    conn->pipe = pipe;
+    conn->readIo.op = PIPE_OP_CONNECT;
+    conn->readIo.owner = conn;
+    conn->writeIo.op = PIPE_OP_WRITE;
+    conn->writeIo.owner = conn;
+    ZeroMemory(&conn->readIo.overlapped, sizeof(OVERLAPPED));
+
+    if (ConnectNamedPipe(pipe, &conn->readIo.overlapped)) {
+        conn->readPending = true;
+    } else {
+        DWORD code = GetLastError();
+        if (code == ERROR_IO_PENDING) {
+            conn->readPending = true;
+        } else if (code == ERROR_PIPE_CONNECTED) {
+            // 客户端在 CreateNamedPipe 与 ConnectNamedPipe 之间已经连上，不会再有完成通知
+            m_listeners.push_back(conn);
+            OnConnected(conn);
+            return true;
+        } else {
+            CloseHandle(pipe);
+            delete conn;
+            if (error) *error = "无法等待控制管道连接 (错误 " + std::to_string(code) + ")";
+            return false;
+        }
+    }
+    m_listeners.push_back(conn);
+    return true;
+}
+
+void ControlServer::OnConnected(Connection* conn) {
+    for (size_t i = 0; i < m_listeners.size(); ++i) {
+        if (m_listeners[i] == conn) {
+            m_listeners[i] = m_listeners.back();
+            m_listeners.pop_back();
+            break;
+        }
+    }
+    conn->id = m_nextConnection++;
+    conn->connected = true;
+    m_connections[conn->id].reset(conn);
+    ++m_accepted;
+    ++m_open;
+
+    // 补上一个新的监听实例，失败时只要还有其他监听实例就不影响服务
+    if (!m_stopping) CreateListener(nullptr);
+    StartRead(conn);
+}
+
+void ControlServer::StartRead(Connection* conn) {
+    if (conn->closing || conn->readPending) return;
+    ZeroMemory(&conn->readIo.overlapped, sizeof(OVERLAPPED));
+    conn->readIo.op = PIPE_OP_READ;
+    // 同步完成时完成端口同样会收到通知，统一在 Run 中处理
+    if (ReadFile(conn->pipe, conn->readBuffer, (DWORD)kReadChunk, NULL, &conn->readIo.overlapped) ||
+        GetLastError() == ERROR_IO_PENDING) {
+        conn->readPending = true;
+    } else {
+        CloseConnection(conn);
+    }
+}
+
+void ControlServer::StartWrite(Connection* conn) {
+    if (conn->closing || conn->writePending || conn->out.empty()) return;
+    if (conn->out.size() > kMaxPendingOutput) {
+        CloseConnection(conn);
+        return;
+    }
+    conn->writing.swap(conn->out);
+    conn->out.clear();
+    ZeroMemory(&conn->writeIo.overlapped, sizeof(OVERLAPPED));
+    if (WriteFile(conn->pipe, conn->writing.data(), (DWORD)conn->writing.size(), NULL, &conn->writeIo.overlapped) ||
+        GetLastError() == ERROR_IO_PENDING) {
+        conn->writePending = true;
+    } else {
+        CloseConnection(conn);
+    }
+}
+
+void ControlServer::FlushDirty() {
+    std::vector<uint64_t> dirty;
+    dirty.swap(m_dirty);
+    for (uint64_t id : dirty) {
+        Connection* conn = Find(id);
+        if (!conn) continue;
+        StartWrite(conn);
+        ReleaseIfIdle(conn);
+    }
+}
+
+void ControlServer::CloseConnection(Connection* conn) {
+    if (conn->closing) return;
+    conn->closing = true;
+    // 关闭句柄让挂起的读写以失败完成，等它们都回来之后才能释放
+    CloseHandle(conn->pipe);
+    conn->pipe = INVALID_HANDLE_VALUE;
+    if (conn->connected) --m_open;
+}
+
+void ControlServer::ReleaseIfIdle(Connection* conn) {
+    if (!conn->closing || conn->readPending || conn->writePending) return;
+    if (conn->connected) {
+        m_connections.erase(conn->id);
+    } else {
+        for (size_t i = 0; i < m_listeners.size(); ++i) {
+            if (m_listeners[i] == conn) {
+                m_listeners[i] = m_listeners.back();
+                m_listeners.pop_back();
+                break;
+            }
+        }
+        delete conn;
+    }
+}
+
+void ControlServer::Run() {
+    TraceSetThreadName("control-server");
+    m_loopThread = std::this_thread::get_id();
+    for (;;) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = NULL;
+        BOOL ok = GetQueuedCompletionStatus(m_iocp, &bytes, &key, &overlapped, INFINITE);
+        if (!overlapped) {
+            if (!ok) break;
+            if (key == kWakeKey) {
+                if (m_stopping) break;
+                DrainQueue();
+                FlushDirty();
+            }
+            continue;
+        }
+
+        Connection::PipeIo* io = CONTAINING_RECORD(overlapped, Connection::PipeIo, overlapped);
+        Connection* conn = io->owner;
+        if (io->op == PIPE_OP_WRITE) {
+            conn->writePending = false;
+        } else {
+            conn->readPending = false;
+        }
+
+        if (!ok && !conn->closing) {
+            // 监听实例出错时补一个新的，避免监听实例越来越少
+            bool listener = !conn->connected;
+            CloseConnection(conn);
+            if (listener && !m_stopping) CreateListener(nullptr);
+        }
+        if (conn->closing) {
+            ReleaseIfIdle(conn);
+            FlushDirty();
+            continue;
+        }
+
+        switch (io->op) {
+            case PIPE_OP_CONNECT:
+                OnConnected(conn);
+                break;
+            case PIPE_OP_READ:
+                if (bytes > 0) {
+                    conn->reader.Feed(conn->readBuffer, bytes);
+                    Dispatch(conn);
+                }
+                StartRead(conn);
+                break;
+            case PIPE_OP_WRITE:
+                if (bytes < conn->writing.size()) {
+                    conn->out.insert(0, conn->writing, bytes, std::string::npos);
+                }
+                conn->writing.clear();
+                StartWrite(conn);
+                break;
+        }
+        // 关闭连接只关句柄，释放统一放在这里，避免处理过程中访问已释放的连接
+        ReleaseIfIdle(conn);
+        FlushDirty();
+    }
+    m_loopThread = std::thread::id();
+}
+
+void ControlServer::Stop() {
+    if (!m_loop.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopping = true;
+        m_dropped += m_queue.size();
+        m_queue.clear();
+    }
+    PostQueuedCompletionStatus(m_iocp, 0, kWakeKey, NULL);
+    m_loop.join();
+
+    // 关闭所有管道，再把挂起操作的完成通知收回来，之后才能释放 OVERLAPPED 所在的内存
+    std::vector<Connection*> all(m_listeners.begin(), m_listeners.end());
+    for (auto& item : m_connections) all.push_back(item.second.release());
+    m_connections.clear();
+    m_listeners.clear();
+    for (Connection* conn : all) {
+        if (conn->pipe != INVALID_HANDLE_VALUE) CloseHandle(conn->pipe);
+        conn->pipe = INVALID_HANDLE_VALUE;
+        conn->closing = true;
+    }
+    auto pending = [&all]() {
+        for (Connection* conn : all) {
+            if (conn->readPending || conn->writePending) return true;
+        }
+        return false;
+    };
+    uint64_t deadline = MonotonicMicros() + 2000000;
+    while (pending() && MonotonicMicros() < deadline) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = NULL;
+        GetQueuedCompletionStatus(m_iocp, &bytes, &key, &overlapped, 100);
+        if (!overlapped) continue;
+        Connection::PipeIo* io = CONTAINING_RECORD(overlapped, Connection::PipeIo, overlapped);
+        if (io->op == PIPE_OP_WRITE) {
+            io->owner->writePending = false;
+        } else {
+            io->owner->readPending = false;
+        }
+    }
+    // 超时仍未完成的操作说明内核还持有这块内存，宁可泄漏也不释放
+    for (Connection* conn : all) {
+        if (!conn->readPending && !conn->writePending) delete conn;
+    }
+    CloseHandle(m_iocp);
+    m_iocp = NULL;
+    m_open = 0;
+    m_dirty.clear();
+}
+
+#else
+
+// ==================== Linux: Unix 域套接字 + epoll ====================
+
+bool ControlServer::Start(const std::string& endpoint, Handler handler, std::string* error) {
+    Stop();
+    m_endpoint = endpoint;
+    m_handler = handler;
+    m_stopping = false;
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (endpoint.empty() || endpoint.size() >= sizeof(address.sun_path)) {
+        if (error) *error = "控制套接字路径无效: " + endpoint;
+        return false;
+    }
+    memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+
+    // 已有套接字文件时先试着连一下：连得上说明另一个实例在运行，连不上则是上次异常退出留下的
+    struct stat info;
+    if (lstat(endpoint.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            if (error) *error = "控制套接字路径已被其他文件占用: " + endpoint;
+            return false;
+        }
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool alive = probe >= 0 && connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (alive) {
+            if (error) *error = "控制套接字已被另一个实例占用: " + endpoint;
+            return false;
+        }
+        unlink(endpoint.c_str());
+    }
+
+    m_listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_listen < 0) {
+        if (error) *error = std::string("无法创建控制套接字: ") + strerror(errno);
+        return false;
+    }
+    // 只允许当前用户连接
+    mode_t oldMask = umask(0077);
+    int bound = bind(m_listen, (sockaddr*)&address, sizeof(address));
+    umask(oldMask);
+    if (bound != 0 || listen(m_listen, 128) != 0) {
+        if (error) *error = "无法监听控制套接字: " + endpoint + " (" + strerror(errno) + ")";
+        close(m_listen);
+        m_listen = -1;
+        return false;
+    }
+
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wakeFd < 0) {
+        if (error) *error = std::string("无法创建事件循环: ") + strerror(errno);
+        if (m_epoll >= 0) close(m_epoll);
+        if (m_wakeFd >= 0) close(m_wakeFd);
+        close(m_listen);
+        unlink(endpoint.c_str());
+        m_epoll = m_wakeFd = m_listen = -1;
+        return false;
+    }
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = kListenKey;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_listen, &event);
+    event.data.u64 = kWakeKey;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+    m_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    m_acceptPaused = false;
+
+    m_loop = std::thread(&ControlServer::Run, this);
+    return true;
+}
+
+void ControlServer::AcceptAll() {
+    for (;;) {
+        int fd = accept4(m_listen, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EMFILE && errno != ENFILE) return;   // EAGAIN 表示已取完
+            // 描述符耗尽：监听套接字是水平触发，连接留在队列里会让事件循环空转。
+            // 腾出预留的描述符接受这个连接并立即关闭，客户端会看到连接被断开而不是一直挂起
+            if (m_spareFd >= 0) {
+                close(m_spareFd);
+                m_spareFd = -1;
+                int dropped = accept4(m_listen, NULL, NULL, SOCK_CLOEXEC);
+                if (dropped >= 0) close(dropped);
+                m_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                if (dropped >= 0) continue;
+            }
+            // 没有预留描述符可用：暂停监听，等已有连接关闭释放出描述符后再恢复
+            epoll_event event;
+            memset(&event, 0, sizeof(event));
+            event.data.u64 = kListenKey;
+            epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_listen, &event);
+            m_acceptPaused = true;
+            return;
+        }
+        std::unique_ptr<Connection> conn(new Connection());
+        conn->id = m_nextConnection++;
+        conn->fd = fd;
+
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = conn->id;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            continue;
+        }
+        ++m_accepted;
+        ++m_open;
+        m_connections[conn->id] = std::move(conn);
+    }
+}
+
+void ControlServer::ReadConnection(Connection* conn) {
+    char buffer[kReadChunk];
+    for (;;) {
+        ssize_t got = read(conn->fd, buffer, sizeof(buffer));
+        if (got > 0) {
+            conn->reader.Feed(buffer, (size_t)got);
+            if ((size_t)got < sizeof(buffer)) break;
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        // 对端关闭或出错：已读到的请求不再处理，还没发出的响应也随之丢弃
+        CloseConnection(conn);
+        return;
+    }
+    Dispatch(conn);
+}
+
+void ControlServer::UpdateInterest(Connection* conn, bool wantWrite) {
+    if (conn->wantWrite == wantWrite) return;
+    conn->wantWrite = wantWrite;
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? (uint32_t)EPOLLOUT : 0u);
+    event.data.u64 = conn->id;
+    epoll_ctl(m_epoll, EPOLL_CTL_MOD, conn->fd, &event);
+}
+
+void ControlServer::FlushConnection(Connection* conn) {
+    while (conn->outOffset < conn->out.size()) {
+        ssize_t sent = send(conn->fd, conn->out.data() + conn->outOffset, conn->out.size() - conn->outOffset,
+                            MSG_NOSIGNAL);
+        if (sent > 0) {
+            conn->outOffset += (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // 对端暂时读不过来：等可写事件，积压过多则断开
+            if (conn->out.size() - conn->outOffset > kMaxPendingOutput) {
+                CloseConnection(conn);
+                return;
+            }
+            UpdateInterest(conn, true);
+            return;
+        }
+        CloseConnection(conn);
+        return;
+    }
+    conn->out.clear();
+    conn->outOffset = 0;
+    UpdateInterest(conn, false);
+}
+
+void ControlServer::FlushDirty() {
+    std::vector<uint64_t> dirty;
+    dirty.swap(m_dirty);
+    for (uint64_t id : dirty) {
+        Connection* conn = Find(id);
+        if (conn && !conn->closing && !conn->wantWrite) FlushConnection(conn);
+    }
+    // 关闭的连接在这一轮事件处理完之后统一释放
+    for (uint64_t id : m_closed) m_connections.erase(id);
+    m_closed.clear();
+}
+
+void ControlServer::CloseConnection(Connection* conn) {
+    if (conn->closing) return;
+    conn->closing = true;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    conn->fd = -1;
+    --m_open;
+    m_closed.push_back(conn->id);
+    if (m_acceptPaused) {
+        if (m_spareFd < 0) m_spareFd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u64 = kListenKey;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, m_listen, &event);
+        m_acceptPaused = false;
+    }
+}
+
+void ControlServer::Run() {
+    TraceSetThreadName("control-server");
+    m_loopThread = std::this_thread::get_id();
+    epoll_event events[64];
+    while (!m_stopping) {
+        int count = epoll_wait(m_epoll, events, 64, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            uint64_t key = events[i].data.u64;
+            if (key == kListenKey) {
+                AcceptAll();
+                continue;
+            }
+            if (key == kWakeKey) {
+                uint64_t value;
+                ssize_t got = read(m_wakeFd, &value, sizeof(value));
+                (void)got;
+                DrainQueue();
+                continue;
+            }
+            Connection* conn = Find(key);
+            if (!conn || conn->closing) continue;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) ReadConnection(conn);
+            if (!conn->closing && (events[i].events & EPOLLOUT)) FlushConnection(conn);
+        }
+        if (!m_dirty.empty() || !m_closed.empty()) FlushDirty();
+    }
+    m_loopThread = std::thread::id();
+}
+
+void ControlServer::Stop() {
+    if (!m_loop.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopping = true;
+        m_dropped += m_queue.size();
+        m_queue.clear();
+    }
+    uint64_t one = 1;
+    ssize_t written = write(m_wakeFd, &one, sizeof(one));
+    (void)written;
+    m_loop.join();
+
+    for (auto& item : m_connections) {
+        if (item.second->fd >= 0) close(item.second->fd);
+    }
+    m_connections.clear();
+    m_dirty.clear();
+    m_closed.clear();
+    m_open = 0;
+    close(m_listen);
+    close(m_wakeFd);
+    close(m_epoll);
+    if (m_spareFd >= 0) close(m_spareFd);
+    m_listen = m_wakeFd = m_epoll = m_spareFd = -1;
+    unlink(m_endpoint.c_str());
+}
+
+#endif
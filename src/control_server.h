@@ -0,0 +1,123 @@
+// nginx-manager/src/control_server.h
+// 控制通道服务端 - 单线程事件循环 (epoll / 命名管道 + IOCP) 同时服务多个本地客户端
+
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include "control_protocol.h"
+#include "platform.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 收到的一个请求
+struct ControlRequest {
+    uint64_t connection = 0;         // 回复时原样传给 Respond
+    uint32_t id = 0;
+    uint8_t command = 0;
+    std::string payload;
+};
+
+struct ControlServerStats {
+    uint64_t accepted = 0;
+    uint64_t open = 0;
+    uint64_t requests = 0;
+    uint64_t responses = 0;
+    uint64_t protocolErrors = 0;     // 非法帧导致断开的连接数
+    uint64_t dropped = 0;            // 连接已断开而丢弃的响应数
+};
+
+// 控制通道服务端
+// - 所有连接由一个事件循环线程处理：Linux 上为 Unix 域套接字 + epoll，Windows 上为命名管道 + IOCP
+// - 每收到一个完整的帧就在事件循环线程中调用 handler；handler 必须很快返回：
+//   能立即回答的请求直接调用 Respond，耗时的操作交给其他线程，完成后再从那个线程调用 Respond
+// - 同一连接可以连续发送多个请求，一批请求的响应合并为一次写入
+class ControlServer {
+public:
+    typedef std::function<void(const ControlRequest& request)> Handler;
+
+    ControlServer();
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // 在 endpoint（套接字路径 / 管道名）上开始监听；端点已被另一个进程占用时失败
+    bool Start(const std::string& endpoint, Handler handler, std::string* error);
+    void Stop();
+
+    // 回复请求，可在任意线程调用；连接已断开时丢弃
+    void Respond(uint64_t connection, uint32_t id, uint8_t status, const std::string& payload);
+
+    ControlServerStats Stats() const;
+    const std::string& Endpoint() const { return m_endpoint; }
+
+private:
+    struct Connection;
+    struct Outgoing {
+        uint64_t connection;
+        uint32_t id;
+        uint8_t status;
+        std::string payload;
+    };
+
+    void Run();
+    void Dispatch(Connection* connection);
+    void DrainQueue();
+    void FlushDirty();
+    void CloseConnection(Connection* connection);
+    Connection* Find(uint64_t id);
+
+#ifdef _WIN32
+    bool CreateListener(std::string* error);
+    void OnConnected(Connection* connection);
+    void StartRead(Connection* connection);
+    void StartWrite(Connection* connection);
+    void ReleaseIfIdle(Connection* connection);
+
+    HANDLE m_iocp = NULL;
+    std::wstring m_pipeName;
+    std::vector<Connection*> m_listeners;    // 等待客户端连接的管道实例
+#else
+    void AcceptAll();
+    void ReadConnection(Connection* connection);
+    void FlushConnection(Connection* connection);
+    void UpdateInterest(Connection* connection, bool wantWrite);
+
+    int m_epoll = -1;
+    int m_listen = -1;
+    int m_wakeFd = -1;
+    int m_spareFd = -1;                      // 预留的描述符，文件描述符耗尽时腾出来接受并立即关闭新连接
+    bool m_acceptPaused = false;             // 连预留描述符也用不上时暂停监听，直到有连接关闭
+    std::vector<uint64_t> m_closed;          // 本轮关闭、待释放的连接
+#endif
+
+    std::string m_endpoint;
+    Handler m_handler;
+    std::thread m_loop;
+    std::atomic<std::thread::id> m_loopThread{std::thread::id()};
+    std::atomic<bool> m_stopping{false};
+    uint64_t m_nextConnection = 16;          // 更小的值保留给监听与唤醒事件
+
+    // 以下只在事件循环线程中访问
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> m_connections;
+    std::vector<uint64_t> m_dirty;           // 有待发送响应的连接
+
+    // 其他线程的响应先放入队列，再唤醒事件循环
+    std::mutex m_queueMutex;
+    std::vector<Outgoing> m_queue;
+
+    std::atomic<uint64_t> m_accepted{0};
+    std::atomic<uint64_t> m_open{0};
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint64_t> m_responses{0};
+    std::atomic<uint64_t> m_protocolErrors{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+#endif // CONTROL_SERVER_H
@@ -0,0 +1,525 @@
+// nginx-manager/src/cpu_topology.cpp
+// CPU 拓扑 - 发现物理核心 / SMT 线程 / NUMA 节点 / L3 域，生成 worker_cpu_affinity 计划并校验 worker 的实际绑定
+
+#ifdef _WIN32
+#if !defined(_WIN32_WINNT) || _WIN32_WINNT < 0x0601
+#undef _WIN32_WINNT
+#define _WIN32_WINNT 0x0601          // GetLogicalProcessorInformationEx
+#endif
+#endif
+
+#include "cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <thread>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// nginx 掩码与亲和集合的上限（与 Linux 的 CPU_SETSIZE 一致）
+static const uint32_t kMaxCpus = 1024;
+
+// ---------------------------------------------------------------------------
+// 拓扑发现
+
+#ifndef _WIN32
+// 读取 sysfs 中的小文件并去掉行尾空白
+static bool ReadSysfs(const std::string& path, std::string* text) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char buffer[4096];
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (n < 0) return false;
+    text->assign(buffer, (size_t)n);
+    while (!text->empty() && (text->back() == '\n' || text->back() == ' ')) text->pop_back();
+    return true;
+}
+
+static long ReadSysfsNumber(const std::string& path, long fallback) {
+    std::string text;
+    if (!ReadSysfs(path, &text) || text.empty()) return fallback;
+    return strtol(text.c_str(), nullptr, 10);
+}
+
+// 解析 "0-3,8,10-11" 形式的 CPU 列表
+static bool ParseCpuList(const std::string& text, std::vector<uint32_t>* cpus) {
+    cpus->clear();
+    const char* p = text.c_str();
+    while (*p) {
+        char* end = nullptr;
+        unsigned long first = strtoul(p, &end, 10);
+        if (end == p) return false;
+        unsigned long last = first;
+        p = end;
+        if (*p == '-') {
+            last = strtoul(p + 1, &end, 10);
+            if (end == p + 1 || last < first) return false;
+            p = end;
+        }
+        for (unsigned long cpu = first; cpu <= last && cpu < kMaxCpus; ++cpu) cpus->push_back((uint32_t)cpu);
+        if (*p == ',') ++p;
+        else if (*p) return false;
+    }
+    return true;
+}
+#endif
+
+bool CpuTopology::Discover(std::string* error) {
+    m_cpus.clear();
+#ifdef _WIN32
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationAll, NULL, &length);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || length == 0) {
+        if (error) *error = "GetLogicalProcessorInformationEx 失败 (错误码 " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    std::vector<uint8_t> buffer(length);
+    if (!GetLogicalProcessorInformationEx(RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)buffer.data(),
+                                          &length)) {
+        if (error) *error = "GetLogicalProcessorInformationEx 失败 (错误码 " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+
+    // 以 CPU 编号为下标收集，记录按关系类型分别给出各自覆盖的 CPU 掩码
+    std::vector<LogicalCpu> byId;
+    std::vector<bool> present;
+    auto forEachCpu = [&](const GROUP_AFFINITY& affinity, auto&& fn) {
+        for (uint32_t bit = 0; bit < 64; ++bit) {
+            if (!(affinity.Mask & ((KAFFINITY)1 << bit))) continue;
+            uint32_t id = (uint32_t)affinity.Group * 64 + bit;
+            if (id >= kMaxCpus) continue;
+            if (byId.size() <= id) {
+                byId.resize(id + 1);
+                present.resize(id + 1, false);
+            }
+            byId[id].id = id;
+            fn(byId[id], id);
+        }
+    };
+    uint32_t cores = 0;
+    uint32_t packages = 0;
+    uint32_t l3Domains = 0;
+    for (DWORD offset = 0; offset < length;) {
+        auto info = (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX)(buffer.data() + offset);
+        switch (info->Relationship) {
+            case RelationProcessorCore: {
+                uint32_t thread = 0;
+                forEachCpu(info->Processor.GroupMask[0], [&](LogicalCpu& cpu, uint32_t id) {
+                    cpu.core = cores;
+                    cpu.thread = thread++;
+                    present[id] = true;
+                });
+                ++cores;
+                break;
+            }
+            case RelationProcessorPackage:
+                for (WORD g = 0; g < info->Processor.GroupCount; ++g) {
+                    forEachCpu(info->Processor.GroupMask[g], [&](LogicalCpu& cpu, uint32_t) { cpu.package = packages; });
+                }
+                ++packages;
+                break;
+            case RelationNumaNode: {
+                uint32_t node = info->NumaNode.NodeNumber;
+                forEachCpu(info->NumaNode.GroupMask, [&](LogicalCpu& cpu, uint32_t) { cpu.node = node; });
+                break;
+            }
+            case RelationCache:
+                if (info->Cache.Level == 3) {
+                    forEachCpu(info->Cache.GroupMask, [&](LogicalCpu& cpu, uint32_t) { cpu.l3 = l3Domains; });
+                    ++l3Domains;
+                }
+                break;
+            default:
+                break;
+        }
+        if (info->Size == 0) break;
+        offset += info->Size;
+    }
+
+    // 本进程的亲和掩码只描述当前处理器组，多组主机上其他组视为可用
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    bool masked = GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) != 0;
+    for (uint32_t id = 0; id < byId.size(); ++id) {
+        if (!present[id]) continue;
+        if (masked && id < 64) byId[id].allowed = (processMask & ((DWORD_PTR)1 << id)) != 0;
+        m_cpus.push_back(byId[id]);
+    }
+#else
+    const std::string root = "/sys/devices/system/cpu/";
+    std::vector<uint32_t> online;
+    std::string text;
+    if (!ReadSysfs(root + "online", &text) || !ParseCpuList(text, &online) || online.empty()) {
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        if (count <= 0) {
+            if (error) *error = "无法读取 " + root + "online";
+            return false;
+        }
+        online.clear();
+        for (long cpu = 0; cpu < count && cpu < (long)kMaxCpus; ++cpu) online.push_back((uint32_t)cpu);
+    }
+
+    cpu_set_t allowedSet;
+    CPU_ZERO(&allowedSet);
+    bool masked = sched_getaffinity(0, sizeof(allowedSet), &allowedSet) == 0;
+
+    // 原始编号 → 连续编号；同一 L3 域以 shared_cpu_list 的内容区分
+    std::map<long, uint32_t> packageIds;
+    std::map<std::pair<long, std::pair<long, long>>, uint32_t> coreIds;
+    std::map<std::string, uint32_t> l3Ids;
+    std::map<uint32_t, uint32_t> threadsPerCore;
+    for (uint32_t id : online) {
+        std::string base = root + "cpu" + std::to_string(id) + "/";
+        LogicalCpu cpu;
+        cpu.id = id;
+        cpu.allowed = !masked || CPU_ISSET(id, &allowedSet);
+
+        long package = std::max(0L, ReadSysfsNumber(base + "topology/physical_package_id", 0));
+        long die = std::max(0L, ReadSysfsNumber(base + "topology/die_id", 0));
+        long core = ReadSysfsNumber(base + "topology/core_id", (long)id);
+        cpu.package = packageIds.emplace(package, (uint32_t)packageIds.size()).first->second;
+        cpu.core = coreIds.emplace(std::make_pair(package, std::make_pair(die, core)), (uint32_t)coreIds.size())
+                       .first->second;
+        cpu.thread = threadsPerCore[cpu.core]++;
+
+        std::string l3Key = "package" + std::to_string(package);
+        for (int index = 0; index < 16; ++index) {
+            std::string cache = base + "cache/index" + std::to_string(index) + "/";
+            long level = ReadSysfsNumber(cache + "level", -1);
+            if (level < 0) break;
+            if (level == 3 && ReadSysfs(cache + "shared_cpu_list", &text)) {
+                l3Key = text;
+                break;
+            }
+        }
+        cpu.l3 = l3Ids.emplace(l3Key, (uint32_t)l3Ids.size()).first->second;
+        m_cpus.push_back(cpu);
+    }
+
+    // NUMA 节点：/sys/devices/system/node/nodeN/cpulist，不存在时全部视为节点 0
+    DIR* nodes = opendir("/sys/devices/system/node");
+    if (nodes) {
+        std::vector<uint32_t> cpus;
+        while (dirent* entry = readdir(nodes)) {
+            unsigned node = 0;
+            char tail = 0;
+            if (sscanf(entry->d_name, "node%u%c", &node, &tail) != 1) continue;
+            if (!ReadSysfs(std::string("/sys/devices/system/node/") + entry->d_name + "/cpulist", &text) ||
+                !ParseCpuList(text, &cpus)) {
+                continue;
+            }
+            for (LogicalCpu& cpu : m_cpus) {
+                if (std::binary_search(cpus.begin(), cpus.end(), cpu.id)) cpu.node = node;
+            }
+        }
+        closedir(nodes);
+    }
+#endif
+    if (m_cpus.empty()) {
+        if (error) *error = "未发现任何 CPU";
+        return false;
+    }
+    Finish();
+    return true;
+}
+
+void CpuTopology::Finish() {
+    std::sort(m_cpus.begin(), m_cpus.end(), [](const LogicalCpu& a, const LogicalCpu& b) { return a.id < b.id; });
+    std::vector<uint32_t> cores, packages, nodes, l3;
+    for (const LogicalCpu& cpu : m_cpus) {
+        cores.push_back(cpu.core);
+        packages.push_back(cpu.package);
+        nodes.push_back(cpu.node);
+        l3.push_back(cpu.l3);
+    }
+    auto distinct = [](std::vector<uint32_t>& values) {
+        std::sort(values.begin(), values.end());
+        return (uint32_t)(std::unique(values.begin(), values.end()) - values.begin());
+    };
+    m_cores = distinct(cores);
+    m_packages = distinct(packages);
+    m_nodes = distinct(nodes);
+    m_l3Domains = distinct(l3);
+}
+
+uint32_t CpuTopology::AllowedCount() const {
+    uint32_t count = 0;
+    for (const LogicalCpu& cpu : m_cpus) {
+        if (cpu.allowed) ++count;
+    }
+    return count;
+}
+
+const LogicalCpu* CpuTopology::Find(uint32_t id) const {
+    auto it = std::lower_bound(m_cpus.begin(), m_cpus.end(), id,
+                               [](const LogicalCpu& cpu, uint32_t value) { return cpu.id < value; });
+    return it != m_cpus.end() && it->id == id ? &*it : nullptr;
+}
+
+std::string CpuTopology::Summary() const {
+    char text[192];
+    snprintf(text, sizeof(text), "%u 插槽 · %u NUMA 节点 · %u 个 L3 域 · %u 核 %zu 线程", m_packages, m_nodes,
+             m_l3Domains, m_cores, m_cpus.size());
+    std::string summary = text;
+    uint32_t allowed = AllowedCount();
+    if (allowed < m_cpus.size()) summary += " (本进程可用 " + std::to_string(allowed) + " 个)";
+    return summary;
+}
+
+// ---------------------------------------------------------------------------
+// 绑定计划
+
+// 轮流从各 NUMA 节点取 CPU，节点内再轮流从各 L3 域取（cpus 已按编号升序）
+static std::vector<uint32_t> Interleave(const CpuTopology& topology, const std::vector<uint32_t>& cpus) {
+    std::map<uint32_t, std::map<uint32_t, std::vector<uint32_t>>> buckets;   // node → l3 → cpus
+    for (uint32_t id : cpus) {
+        const LogicalCpu* cpu = topology.Find(id);
+        buckets[cpu->node][cpu->l3].push_back(id);
+    }
+
+    struct NodeCursor {
+        std::vector<std::vector<uint32_t>*> domains;
+        std::vector<size_t> next;
+        size_t turn = 0;
+    };
+    std::vector<NodeCursor> nodes;
+    for (auto& node : buckets) {
+        NodeCursor cursor;
+        for (auto& domain : node.second) cursor.domains.push_back(&domain.second);
+        cursor.next.assign(cursor.domains.size(), 0);
+        nodes.push_back(cursor);
+    }
+
+    std::vector<uint32_t> order;
+    while (order.size() < cpus.size()) {
+        for (NodeCursor& node : nodes) {
+            for (size_t tried = 0; tried < node.domains.size(); ++tried) {
+                size_t d = node.turn++ % node.domains.size();
+                if (node.next[d] < node.domains[d]->size()) {
+                    order.push_back((*node.domains[d])[node.next[d]++]);
+                    break;
+                }
+            }
+        }
+    }
+    return order;
+}
+
+AffinityPlan PlanWorkerAffinity(const CpuTopology& topology, const AffinityOptions& options) {
+    // 每个核心中第一个可用的线程作为该核心的主线程
+    std::vector<uint32_t> primary;
+    std::vector<uint32_t> secondary;
+    std::vector<bool> coreTaken(topology.Cores() + 1, false);
+    uint32_t width = 1;
+    for (const LogicalCpu& cpu : topology.Cpus()) {
+        width = std::max(width, cpu.id + 1);
+        if (!cpu.allowed) continue;
+        if (cpu.core >= coreTaken.size()) coreTaken.resize(cpu.core + 1, false);
+        if (!coreTaken[cpu.core]) {
+            coreTaken[cpu.core] = true;
+            primary.push_back(cpu.id);
+        } else {
+            secondary.push_back(cpu.id);
+        }
+    }
+
+    AffinityPlan plan;
+    plan.cpus = Interleave(topology, primary);
+    if (options.useSmt) {
+        std::vector<uint32_t> rest = Interleave(topology, secondary);
+        plan.cpus.insert(plan.cpus.end(), rest.begin(), rest.end());
+    }
+    if (options.maxWorkers > 0 && plan.cpus.size() > options.maxWorkers) plan.cpus.resize(options.maxWorkers);
+
+    plan.workerProcesses = std::to_string(plan.cpus.size());
+    for (size_t i = 0; i < plan.cpus.size(); ++i) {
+        if (i > 0) plan.cpuAffinity += ' ';
+        plan.cpuAffinity += AffinityMask(plan.cpus[i], width);
+    }
+    return plan;
+}
+
+std::string AffinityMask(uint32_t cpu, uint32_t width) {
+    width = std::max(width, cpu + 1);
+    std::string mask(width, '0');
+    mask[width - 1 - cpu] = '1';
+    return mask;
+}
+
+std::string FormatCpuList(const std::vector<uint32_t>& cpus) {
+    std::string text;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!text.empty()) text += ',';
+        text += std::to_string(cpus[i]);
+        if (j > i) text += '-' + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return text;
+}
+
+// ---------------------------------------------------------------------------
+// 校验
+
+bool ReadProcessAffinity(ProcessId pid, std::vector<uint32_t>* cpus) {
+    cpus->clear();
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return false;
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    bool ok = GetProcessAffinityMask(process, &processMask, &systemMask) != 0;
+    CloseHandle(process);
+    if (!ok) return false;
+    for (uint32_t bit = 0; bit < sizeof(DWORD_PTR) * 8; ++bit) {
+        if (processMask & ((DWORD_PTR)1 << bit)) cpus->push_back(bit);
+    }
+    return true;
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity((pid_t)pid, sizeof(set), &set) != 0) return false;
+    for (uint32_t cpu = 0; cpu < CPU_SETSIZE && cpu < kMaxCpus; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus->push_back(cpu);
+    }
+    return true;
+#endif
+}
+
+// 解析一个二进制掩码（最右边为 CPU 0）
+static bool ParseAffinityMask(std::string_view text, std::vector<uint32_t>* cpus) {
+    cpus->clear();
+    if (text.empty() || text.size() > kMaxCpus) return false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[text.size() - 1 - i];
+        if (c == '1') cpus->push_back((uint32_t)i);
+        else if (c != '0') return false;
+    }
+    return true;
+}
+
+// main 上下文中名为 name 的第一条指令
+static uint32_t FindMainDirective(const NginxConfig& config, std::string_view name) {
+    for (uint32_t index : config.FindByName(name)) {
+        if (config.At(index).parent == NginxConfig::kNoDirective) return index;
+    }
+    return NginxConfig::kNoDirective;
+}
+
+AffinityCheck CheckWorkerAffinity(const NginxConfig& config, const CpuTopology& topology,
+                                  const std::vector<ProcessId>& workerPids) {
+    AffinityCheck check;
+    check.runningWorkers = (uint32_t)workerPids.size();
+
+    uint32_t processes = FindMainDirective(config, "worker_processes");
+    check.expectedWorkers = 1;
+    if (processes != NginxConfig::kNoDirective && config.At(processes).argCount > 0) {
+        std::string_view value = config.Arg(processes, 0);
+        check.expectedWorkers = value == "auto" ? std::max(1u, topology.AllowedCount())
+                                                : (uint32_t)strtoul(std::string(value).c_str(), nullptr, 10);
+    }
+
+    uint32_t affinity = FindMainDirective(config, "worker_cpu_affinity");
+    if (affinity == NginxConfig::kNoDirective || config.At(affinity).argCount == 0) {
+        check.ok = true;
+        return check;
+    }
+    check.configured = true;
+
+    // 按 nginx 的规则展开每个 worker 的期望绑定
+    const ConfDirective& directive = config.At(affinity);
+    bool automatic = config.Arg(directive, 0) == "auto";
+    std::vector<std::vector<uint32_t>> masks;
+    for (uint32_t i = automatic ? 1 : 0; i < directive.argCount; ++i) {
+        std::vector<uint32_t> cpus;
+        if (!ParseAffinityMask(config.Arg(directive, i), &cpus) || cpus.empty()) {
+            check.problems.push_back("无法解析 worker_cpu_affinity 掩码 " + std::string(config.Arg(directive, i)));
+            return check;
+        }
+        masks.push_back(cpus);
+    }
+    std::vector<std::vector<uint32_t>> expected(check.expectedWorkers);
+    for (uint32_t worker = 0; worker < check.expectedWorkers; ++worker) {
+        if (automatic) {
+            // auto：第 n 个 worker 绑定掩码（缺省为全部 CPU）中的第 n 个 CPU，超出时循环
+            uint32_t cpu = masks.empty() ? worker % kMaxCpus : masks[0][worker % masks[0].size()];
+            expected[worker].push_back(cpu);
+        } else {
+            expected[worker] = masks[std::min<size_t>(worker, masks.size() - 1)];
+        }
+    }
+
+    std::vector<bool> used(expected.size(), false);
+    std::vector<uint32_t> actual;
+    for (ProcessId pid : workerPids) {
+        if (!ReadProcessAffinity(pid, &actual)) {
+            check.problems.push_back("无法读取 worker " + std::to_string(pid) + " 的 CPU 亲和");
+            continue;
+        }
+        bool found = false;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (!used[i] && expected[i] == actual) {
+                used[i] = true;
+                found = true;
+                break;
+            }
+        }
+        if (found) {
+            ++check.matched;
+        } else {
+            check.problems.push_back("worker " + std::to_string(pid) + " 绑定在 CPU " + FormatCpuList(actual) +
+                                     "，不在计划中");
+        }
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (!used[i]) check.problems.push_back("没有 worker 绑定到 CPU " + FormatCpuList(expected[i]));
+    }
+    if (check.runningWorkers != check.expectedWorkers) {
+        check.problems.push_back("运行中的 worker 为 " + std::to_string(check.runningWorkers) + " 个，配置为 " +
+                                 std::to_string(check.expectedWorkers) + " 个");
+    }
+    check.ok = check.problems.empty();
+    return check;
+}
+
+AffinityCheck VerifyWorkerAffinity(const NginxConfig& config, ProcessTable* table,
+                                   const std::vector<ProcessId>& exclude, uint32_t timeoutMs) {
+    AffinityCheck check;
+    if (FindMainDirective(config, "worker_cpu_affinity") == NginxConfig::kNoDirective) {
+        check.ok = true;
+        return check;
+    }
+    CpuTopology topology;
+    std::string error;
+    if (!topology.Discover(&error)) {
+        check.configured = true;
+        check.problems.push_back("无法获取 CPU 拓扑: " + error);
+        return check;
+    }
+
+    uint64_t deadline = MonotonicMicros() + (uint64_t)timeoutMs * 1000;
+    std::vector<ProcessId> workers;
+    for (;;) {
+        table->Refresh();
+        workers.clear();
+        for (ProcessId pid : table->WorkerPids()) {
+            // cache manager / loader 不受 worker_cpu_affinity 约束
+            if (std::find(exclude.begin(), exclude.end(), pid) == exclude.end() && IsWorkerProcess(pid)) {
+                workers.push_back(pid);
+            }
+        }
+        check = CheckWorkerAffinity(config, topology, workers);
+        if (check.ok || check.runningWorkers >= check.expectedWorkers || MonotonicMicros() >= deadline) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return check;
+}
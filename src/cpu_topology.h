@@ -0,0 +1,98 @@
+// nginx-manager/src/cpu_topology.h
+// CPU 拓扑 - 发现物理核心 / SMT 线程 / NUMA 节点 / L3 域，生成 worker_cpu_affinity 计划并校验 worker 的实际绑定
+
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include "platform.h"
+#include "nginx_conf.h"
+#include "process_table.h"
+#include <string>
+#include <vector>
+
+// 一个逻辑 CPU（硬件线程）
+struct LogicalCpu {
+    uint32_t id = 0;                 // Linux: cpuN 的 N；Windows: 处理器组 * 64 + 组内编号，与 nginx 掩码位一致
+    uint32_t core = 0;               // 物理核心，全机从 0 连续编号
+    uint32_t thread = 0;             // 在所属核心中的序号，0 为第一个线程
+    uint32_t package = 0;            // 物理封装（插槽），从 0 连续编号
+    uint32_t node = 0;               // NUMA 节点
+    uint32_t l3 = 0;                 // 共享同一块 L3 的 CPU 为一个域，从 0 连续编号
+    bool allowed = true;             // 在本进程可用的 CPU 集合内（容器 / cpuset 限制）
+};
+
+// 主机 CPU 拓扑（按 id 升序）
+class CpuTopology {
+public:
+    // Linux 读取 /sys/devices/system/cpu 与 /sys/devices/system/node；
+    // Windows 使用 GetLogicalProcessorInformationEx
+    bool Discover(std::string* error);
+
+    const std::vector<LogicalCpu>& Cpus() const { return m_cpus; }
+    uint32_t Cores() const { return m_cores; }
+    uint32_t Packages() const { return m_packages; }
+    uint32_t Nodes() const { return m_nodes; }
+    uint32_t L3Domains() const { return m_l3Domains; }
+    uint32_t AllowedCount() const;
+    const LogicalCpu* Find(uint32_t id) const;
+
+    // 形如 "2 插槽 · 2 NUMA 节点 · 4 个 L3 域 · 32 核 64 线程"
+    std::string Summary() const;
+
+private:
+    void Finish();
+
+    std::vector<LogicalCpu> m_cpus;
+    uint32_t m_cores = 0;
+    uint32_t m_packages = 0;
+    uint32_t m_nodes = 0;
+    uint32_t m_l3Domains = 0;
+};
+
+struct AffinityOptions {
+    uint32_t maxWorkers = 0;         // 0 表示每个可用物理核心一个 worker
+    bool useSmt = false;             // 物理核心用完后继续使用同核的其他线程
+};
+
+// worker_processes / worker_cpu_affinity 计划：worker i 绑定到 cpus[i]
+struct AffinityPlan {
+    std::vector<uint32_t> cpus;
+    std::string workerProcesses;     // worker_processes 的参数
+    std::string cpuAffinity;         // worker_cpu_affinity 的参数，每个 worker 一个二进制掩码
+};
+
+// 每个 worker 独占一个物理核心的第一个线程；worker 少于核心时轮流取自不同 NUMA 节点、
+// 节点内再轮流取自不同 L3 域，使负载与缓存压力均匀分布；启用 SMT 时同核的其他线程排在最后
+AffinityPlan PlanWorkerAffinity(const CpuTopology& topology, const AffinityOptions& options);
+
+// nginx 的掩码格式：最右边一位为 CPU 0
+std::string AffinityMask(uint32_t cpu, uint32_t width);
+// CPU 列表的紧凑写法，如 "0-3,8"
+std::string FormatCpuList(const std::vector<uint32_t>& cpus);
+
+// 读取进程当前允许运行的 CPU（升序）
+bool ReadProcessAffinity(ProcessId pid, std::vector<uint32_t>* cpus);
+
+// 运行中的 worker 与配置中 worker_cpu_affinity 的比对结果
+struct AffinityCheck {
+    bool configured = false;         // 配置中有 worker_cpu_affinity
+    bool ok = false;
+    uint32_t expectedWorkers = 0;
+    uint32_t runningWorkers = 0;
+    uint32_t matched = 0;
+    std::vector<std::string> problems;   // 每条不一致一行（UTF-8）
+};
+
+// 按 nginx 的规则展开配置中的 worker_processes / worker_cpu_affinity（掩码少于 worker 时沿用最后一个，
+// auto 时第 i 个 worker 绑定掩码中的第 i 个 CPU），再与每个 worker 的实际绑定逐一配对。
+// worker 的序号无法从外部得知，因此按集合配对：每个期望的绑定恰好对应一个 worker 即为一致。
+AffinityCheck CheckWorkerAffinity(const NginxConfig& config, const CpuTopology& topology,
+                                  const std::vector<ProcessId>& workerPids);
+
+// 启动 / 重载后的校验：配置中没有 worker_cpu_affinity 时直接返回（configured 为 false），
+// 否则发现拓扑并比对 table 中除 exclude（重载前的旧 worker）以外的 worker；
+// 刚启动时 worker 可能尚未全部创建，数量不足时在 timeoutMs 内重试
+AffinityCheck VerifyWorkerAffinity(const NginxConfig& config, ProcessTable* table,
+                                   const std::vector<ProcessId>& exclude, uint32_t timeoutMs);
+
+#endif // CPU_TOPOLOGY_H
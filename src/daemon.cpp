@@ -0,0 +1,1354 @@
+// nginx-manager/src/daemon.cpp
+// 无界面模式 - 通过本地控制通道（Unix 域套接字 / 命名管道）接受启动、停止、重载与状态查询
+
+#include "daemon.h"
+#include "access_log.h"
+#include "config_cache.h"
+#include "control_server.h"
+#include "cpu_topology.h"
+#include "file_util.h"
+#include "journal.h"
+#include "load_history.h"
+#include "log_rotator.h"
+#include "log_store.h"
+#include "nginx_control.h"
+#include "nginx_service.h"
+#include "stub_status.h"
+#include "process_sampler.h"
+#include "supervisor.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+
+#ifndef _WIN32
+#include <csignal>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// 状态查询直接读缓存的进程表，缓存最多这么旧；每秒上千次查询也只扫描少数几次进程列表
+static const uint64_t kStatusMaxAgeMicros = 100000;
+// 保留最近完成的操作结果：请求合并到一个恰好刚完成的操作时，仍能拿到它的结果
+static const size_t kRecentResults = 64;
+
+// 启动 / 停止 / 重启 / 自动恢复互相取代，与图形界面一致
+static const int kServiceGroup = 1;
+// 崩溃监护请求的自动恢复，与控制命令共用操作队列，不会出现在控制通道上
+static const int kRecoverOperation = 100;
+// 配置监视发现修改后提交：校验并重新加载
+static const int kConfigChangeOperation = 101;
+
+static const char* OperationName(int kind) {
+    if (kind == kRecoverOperation) return "recover";
+    if (kind == kConfigChangeOperation) return "conf-reload";
+    return ControlCommandName(kind);
+}
+
+static std::mutex g_shutdownMutex;
+static std::condition_variable g_shutdownWake;
+static bool g_shutdownRequested = false;
+
+void RequestDaemonShutdown() {
+    {
+        std::lock_guard<std::mutex> lock(g_shutdownMutex);
+        g_shutdownRequested = true;
+    }
+    g_shutdownWake.notify_all();
+}
+
+#ifdef _WIN32
+static BOOL WINAPI OnConsoleControl(DWORD type) {
+    (void)type;
+    RequestDaemonShutdown();
+    return TRUE;
+}
+#endif
+
+bool ParseDaemonArgs(const std::vector<std::string>& args, DaemonOptions* options, std::string* error) {
+    static const char* const kNumericArgs[] = {
+        "--rotate-size", "--rotate-hours", "--rotate-keep", "--rotate-keep-mb", "--compress-mbps",
+        "--health-interval", "--health-timeout", "--conf-debounce"
+    };
+    const int numericCount = (int)(sizeof(kNumericArgs) / sizeof(kNumericArgs[0]));
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        std::string* target = nullptr;
+        int numeric = -1;
+        for (int k = 0; k < numericCount; ++k) {
+            if (arg == kNumericArgs[k]) numeric = k;
+        }
+        if (numeric >= 0) {
+            char* end = nullptr;
+            unsigned long long value = i + 1 < args.size() ? strtoull(args[i + 1].c_str(), &end, 10) : 0;
+            if (i + 1 >= args.size() || end == args[i + 1].c_str() || *end != '\0') {
+                if (error) *error = "参数需要一个非负整数: " + arg;
+                return false;
+            }
+            ++i;
+            LogRotationPolicy& rotation = options->rotation;
+            switch (numeric) {
+                case 0: rotation.maxBytes = value << 20; break;
+                case 1: rotation.maxAgeSeconds = (uint32_t)(value * 3600); break;
+                case 2: rotation.keepFiles = (uint32_t)value; break;
+                case 3: rotation.keepBytes = value << 20; break;
+                case 4: rotation.compressBytesPerSec = value << 20; break;
+                case 5: options->health.intervalMs = (uint32_t)(value * 1000); break;
+                case 6: options->health.timeoutMs = (uint32_t)value; break;
+                case 7: options->confWatch.debounceMs = (uint32_t)value; break;
+            }
+            continue;
+        }
+        if (arg == "--prefix" || arg == "-p") {
+            target = &options->prefix;
+        } else if (arg == "--endpoint") {
+            target = &options->endpoint;
+        } else if (arg == "--journal") {
+            target = &options->journalDir;
+        } else if (arg == "--health-path") {
+            target = &options->health.httpPath;
+        } else if (arg == "--quiet") {
+            options->quiet = true;
+            continue;
+        } else if (arg == "--no-auto-restart") {
+            options->autoRestart = false;
+            continue;
+        } else if (arg == "--no-rotate") {
+            options->rotation.enabled = false;
+            continue;
+        } else if (arg == "--no-compress") {
+            options->rotation.compress = false;
+            continue;
+        } else if (arg == "--no-health-check") {
+            options->health.enabled = false;
+            continue;
+        } else if (arg == "--no-log-store") {
+            options->logStore = false;
+            continue;
+        } else if (arg == "--no-conf-watch") {
+            options->confWatch.enabled = false;
+            continue;
+        } else if (arg == "--trace") {
+            options->trace = true;
+            continue;
+        } else if (arg == "--daemon") {
+            // ngTool.exe 以此进入无界面模式，已由调用方处理
+            continue;
+        } else {
+            if (error) *error = "未知参数: " + arg;
+            return false;
+        }
+        if (i + 1 >= args.size()) {
+            if (error) *error = "参数缺少取值: " + arg;
+            return false;
+        }
+        *target = args[++i];
+    }
+    return true;
+}
+
+namespace {
+
+// 守护进程状态：控制通道、服务操作队列与指标采集
+class Daemon {
+public:
+    explicit Daemon(const DaemonOptions& options)
+        : m_options(options),
+          m_service(options.prefix),
+          m_queue([this](const OperationResult& result) { OnOperationComplete(result); }) {}
+
+    bool Start(std::string* error);
+    void Stop();
+
+private:
+    struct Waiter {
+        uint64_t connection;
+        uint32_t requestId;
+    };
+
+    struct Finished {
+        bool cancelled = false;
+        ServiceOutcome outcome;
+    };
+
+    void OnRequest(const ControlRequest& request);
+    void SubmitServiceOperation(const ControlRequest& request);
+    void RunServiceOperation(OperationContext& context, int command, const std::string& payload);
+    void OnOperationComplete(const OperationResult& result);
+    void Reply(const Waiter& waiter, const Finished& finished);
+    void OnSupervisorEvent(const SupervisorEvent& event);
+    void OnLogRotationEvent(const LogRotationEvent& event);
+    void OnHealthEvent(const HealthEvent& event);
+    void OnConfigChange(const ConfigChange& change);
+    ServiceOutcome ApplyConfigChange(OperationContext& context);
+    std::string StatusPayload();
+    std::string UpstreamsPayload();
+    std::string TracePayload(const std::string& request, uint8_t* status);
+    std::string JournalPayload(const std::string& request, uint8_t* status);
+    std::string MetricsPayload();
+    bool PlanAffinity(const std::string& payload, CpuTopology* topology, AffinityPlan* plan, std::string* error);
+    std::string AffinityPayload(const std::string& request, uint8_t* status);
+    void StartLoadTest(const ControlRequest& request);
+    void RunLoadTest(Waiter waiter, LoadTestOptions options, uint64_t configHash);
+    std::string ComparePayload(const std::string& request, uint8_t* status);
+    void StartQuery(const ControlRequest& request);
+    void QueryLoop();
+    void StartLogQuery(const ControlRequest& request);
+    void LogStoreLoop();
+    std::string LogQueryPayload(const LogQuery& query, uint8_t* status);
+    void Log(LogSeverity severity, const std::string& text);
+
+    DaemonOptions m_options;
+    NginxService m_service;          // 只在操作队列线程中使用
+    OperationQueue m_queue;
+    ControlServer m_server;
+    Journal m_journal;
+    AccessLogMonitor m_accessLog;
+    StubStatusPoller m_stubStatus;
+    ProcessSampler m_processSampler;
+    Supervisor m_supervisor;
+    LogRotator m_logRotator;
+    HealthProber m_healthProber;
+    ConfigWatcher m_confWatcher;
+    uint64_t m_startMicros = 0;
+
+    // 尚未处理的配置修改；处理前又有新的修改时合并，编辑到生效的耗时从最早的一次算起
+    std::mutex m_confChangeMutex;
+    ConfigChange m_confChange;
+
+    // 同一时间只运行一次压测，在独立线程中执行，不占用操作队列
+    std::thread m_loadTest;
+    std::atomic<bool> m_loadTestRunning{false};
+    std::atomic<bool> m_loadTestCancel{false};
+
+    // 需要读写文件的查询（追踪统计与导出、CPU 拓扑与绑定检查）在查询线程中依次执行，不阻塞控制通道的事件循环
+    std::thread m_queryThread;
+    std::mutex m_queryMutex;
+    std::condition_variable m_queryWake;
+    std::deque<ControlRequest> m_queries;
+    bool m_queryStopping = false;
+
+    // 访问日志列存：导入与查询都在同一个线程中排队执行，查询前先导入新的归档
+    std::unique_ptr<LogStore> m_logStore;
+    std::thread m_logStoreThread;
+    std::mutex m_logStoreMutex;
+    std::condition_variable m_logStoreWake;
+    std::deque<std::pair<Waiter, LogQuery>> m_logQueries;
+    bool m_logStoreIngest = true;    // 有新的归档待导入（启动时先导入一次已有的归档）
+    bool m_logStoreStopping = false;
+    std::atomic<bool> m_logStoreCancel{false};
+
+    // 等待操作结果的请求，按操作 ID 归组（合并的请求共享一个操作）
+    std::mutex m_waitMutex;
+    std::map<uint64_t, std::vector<Waiter>> m_waiters;
+    std::map<uint64_t, ServiceOutcome> m_outcomes;
+    std::map<uint64_t, Finished> m_recent;
+
+    // 状态缓存，只在控制通道的事件循环线程中访问
+    ProcessTable m_statusTable;
+    uint64_t m_statusMicros = 0;
+    std::atomic<bool> m_statusStale{true};
+
+    std::mutex m_logMutex;
+};
+
+void Daemon::Log(LogSeverity severity, const std::string& text) {
+    int64_t utc = UtcTimeMicros();
+    if (m_journal.IsOpen()) m_journal.Append(JOURNAL_LOG, (uint8_t)severity, 0, text, utc);
+    if (m_options.quiet) return;
+
+    time_t seconds = (time_t)((utc + LocalOffsetMicros()) / 1000000);
+    struct tm parts;
+#ifdef _WIN32
+    gmtime_s(&parts, &seconds);
+#else
+    gmtime_r(&seconds, &parts);
+#endif
+    std::lock_guard<std::mutex> lock(m_logMutex);
+    fprintf(stderr, "[%02d:%02d:%02d] %s\n", parts.tm_hour, parts.tm_min, parts.tm_sec, text.c_str());
+    fflush(stderr);
+}
+
+bool Daemon::Start(std::string* error) {
+    m_startMicros = MonotonicMicros();
+    if (!m_options.journalDir.empty()) {
+        std::string journalError;
+        if (!m_journal.Open(m_options.journalDir, &journalError)) {
+            Log(LOG_WARNING, "操作日志无法持久化: " + journalError);
+        }
+    }
+
+    m_service.SetLogSink([this](LogSeverity severity, const std::string& text) { Log(severity, text); });
+    m_statusTable.SetPrefix(m_options.prefix);
+    if (m_options.trace) TraceEnable(true);
+    m_queue.SetKindNames(OperationName);
+    m_queue.Start();
+
+    std::string supervisorError;
+    m_supervisor.SetEnabled(m_options.autoRestart);
+    if (!m_supervisor.Start([this](const SupervisorEvent& event) { OnSupervisorEvent(event); }, &supervisorError)) {
+        Log(LOG_WARNING, "崩溃监护无法启动，nginx 意外退出后不会自动重启: " + supervisorError);
+    }
+    // 守护进程启动前已在运行的 nginx 同样纳入监护
+    m_statusTable.Refresh();
+    if (m_statusTable.MasterPid()) m_supervisor.Watch(m_statusTable.MasterPid(), m_service.PidFile());
+
+    std::string endpoint = m_options.endpoint.empty() ? DefaultControlEndpoint() : m_options.endpoint;
+    if (!m_server.Start(endpoint, [this](const ControlRequest& request) { OnRequest(request); }, error)) {
+        m_queue.Stop();
+        m_journal.Close();
+        return false;
+    }
+
+    m_accessLog.Start(m_options.prefix, m_service.ConfPath());
+    m_stubStatus.Start(m_service.ConfPath());
+    m_processSampler.Start(m_options.prefix);
+    // 通知 nginx 重新打开日志使用独立的进程表，不经过操作队列，排队中的操作不会推迟轮转
+    m_logRotator.SetHandlers([this](std::string* reopenError) { return m_service.ReopenLogs(reopenError); },
+                             [this](const LogRotationEvent& event) { OnLogRotationEvent(event); });
+    m_logRotator.SetPolicy(m_options.rotation);
+    m_logRotator.Start(m_options.prefix, m_service.ConfPath());
+    m_healthProber.SetHandler([this](const HealthEvent& event) { OnHealthEvent(event); });
+    m_healthProber.SetOptions(m_options.health);
+    m_healthProber.Start(m_service.ConfPath());
+    m_confWatcher.SetHandler([this](const ConfigChange& change) { OnConfigChange(change); });
+    m_confWatcher.SetOptions(m_options.confWatch);
+    m_confWatcher.Start(m_service.ConfPath());
+    if (m_options.logStore) {
+        m_logStore.reset(new LogStore(m_service.PrefixPath("logs/store")));
+        m_logStoreThread = std::thread(&Daemon::LogStoreLoop, this);
+    }
+    m_queryThread = std::thread(&Daemon::QueryLoop, this);
+    Log(LOG_INFO, "无界面模式已启动: " + m_options.prefix + " (控制端点 " + endpoint + ")");
+    return true;
+}
+
+void Daemon::Stop() {
+    // 先停控制通道与配置监视，排队中的操作随后以取消结束（响应已无处可发）
+    m_server.Stop();
+    m_confWatcher.Stop();
+    m_supervisor.Stop();
+    m_queue.Stop();
+    m_loadTestCancel = true;
+    if (m_loadTest.joinable()) m_loadTest.join();
+    if (m_queryThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_queryMutex);
+            m_queryStopping = true;
+        }
+        m_queryWake.notify_all();
+        m_queryThread.join();
+    }
+    if (m_logStoreThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_logStoreMutex);
+            m_logStoreStopping = true;
+        }
+        m_logStoreCancel = true;
+        m_logStoreWake.notify_all();
+        m_logStoreThread.join();
+    }
+    m_stubStatus.Stop();
+    m_processSampler.Stop();
+    m_logRotator.Stop();
+    m_healthProber.Stop();
+    m_accessLog.Stop();
+    ControlServerStats stats = m_server.Stats();
+    char text[256];
+    snprintf(text, sizeof(text), "无界面模式已退出 (共处理 %llu 个请求, %llu 个连接)",
+             (unsigned long long)stats.requests, (unsigned long long)stats.accepted);
+    Log(LOG_INFO, text);
+    m_journal.Close();
+}
+
+// 控制通道事件循环线程中调用：查询类请求直接回答，服务操作交给操作队列
+void Daemon::OnRequest(const ControlRequest& request) {
+    switch (request.command) {
+        case CONTROL_PING: {
+            std::string payload;
+            AppendField(&payload, "pong", std::string("1"));
+            m_server.Respond(request.connection, request.id, CONTROL_OK, payload);
+            break;
+        }
+        case CONTROL_STATUS:
+            m_server.Respond(request.connection, request.id, CONTROL_OK, StatusPayload());
+            break;
+        case CONTROL_METRICS:
+            m_server.Respond(request.connection, request.id, CONTROL_OK, MetricsPayload());
+            break;
+        case CONTROL_START:
+        case CONTROL_STOP:
+        case CONTROL_RESTART:
+        case CONTROL_RELOAD:
+        case CONTROL_APPLY_AFFINITY:
+            SubmitServiceOperation(request);
+            break;
+        case CONTROL_AFFINITY:
+        case CONTROL_TRACE:
+        case CONTROL_JOURNAL:
+            StartQuery(request);
+            break;
+        case CONTROL_ROTATE: {
+            m_logRotator.RotateNow();
+            std::string payload;
+            AppendField(&payload, "scheduled", std::string("1"));
+            for (const std::string& file : m_logRotator.Files()) AppendField(&payload, "file", file);
+            m_server.Respond(request.connection, request.id, CONTROL_OK, payload);
+            break;
+        }
+        case CONTROL_UPSTREAMS:
+            m_server.Respond(request.connection, request.id, CONTROL_OK, UpstreamsPayload());
+            break;
+        case CONTROL_LOADTEST:
+            StartLoadTest(request);
+            break;
+        case CONTROL_LOGQUERY:
+            StartLogQuery(request);
+            break;
+        case CONTROL_COMPARE: {
+            uint8_t status = CONTROL_OK;
+            std::string payload = ComparePayload(request.payload, &status);
+            m_server.Respond(request.connection, request.id, status, payload);
+            break;
+        }
+        default: {
+            std::string payload;
+            AppendField(&payload, "error", "未知命令 " + std::to_string(request.command));
+            m_server.Respond(request.connection, request.id, CONTROL_BAD_REQUEST, payload);
+            break;
+        }
+    }
+}
+
+std::string Daemon::StatusPayload() {
+    uint64_t now = MonotonicMicros();
+    if (m_statusStale.exchange(false) || now - m_statusMicros > kStatusMaxAgeMicros) {
+        m_statusTable.Refresh();
+        m_statusMicros = now;
+    }
+
+    std::string payload;
+    payload.reserve(256);
+    ProcessId master = m_statusTable.MasterPid();
+    AppendField(&payload, "state", std::string(master != 0 ? "running" : "stopped"));
+    AppendField(&payload, "prefix", m_options.prefix);
+    AppendField(&payload, "master_pid", (uint64_t)master);
+    AppendField(&payload, "workers", (uint64_t)m_statusTable.WorkerPids().size());
+    AppendField(&payload, "busy", (uint64_t)(m_queue.IsBusy() ? 1 : 0));
+    AppendField(&payload, "supervisor", std::string(SupervisorStateName(m_supervisor.State())));
+    AppendField(&payload, "uptime_s", (uint64_t)((now - m_startMicros) / 1000000));
+    AppendField(&payload, "snapshot_age_ms", (double)(now - m_statusMicros) / 1000.0);
+    return payload;
+}
+
+std::string Daemon::MetricsPayload() {
+    std::string payload;
+    payload.reserve(768);
+
+    StubStatusSnapshot stub = m_stubStatus.Snapshot();
+    AppendField(&payload, "stub_status", std::string(stub.available ? "available" : stub.configured ? "unreachable"
+                                                                                                    : "not-configured"));
+    if (stub.available) {
+        AppendField(&payload, "active", stub.latest.active);
+        AppendField(&payload, "reading", stub.latest.reading);
+        AppendField(&payload, "writing", stub.latest.writing);
+        AppendField(&payload, "waiting", stub.latest.waiting);
+        AppendField(&payload, "requests_total", stub.latest.requests);
+        AppendField(&payload, "requests_per_sec", stub.requestsPerSec);
+    }
+
+    TrafficSnapshot traffic = m_accessLog.Snapshot(10);
+    AppendField(&payload, "log_requests_per_sec", traffic.requestsPerSec);
+    AppendField(&payload, "log_bytes_per_sec", traffic.bytesPerSec);
+    static const char* const kClassKeys[kStatusClasses] = {
+        "log_other", "log_1xx", "log_2xx", "log_3xx", "log_4xx", "log_5xx"
+    };
+    for (int i = 1; i < kStatusClasses; ++i) {
+        AppendField(&payload, kClassKeys[i], traffic.windowClasses[i]);
+    }
+    AppendField(&payload, "log_total_requests", traffic.totalRequests);
+
+    // master 与各 worker 最近一秒的资源占用，未就绪（刚启动或未运行）时不输出
+    ProcessUsageSnapshot usage;
+    m_processSampler.Snapshot(&usage);
+    if (usage.ready) {
+        AppendField(&payload, "cpu_percent", usage.total.cpuPercent);
+        AppendField(&payload, "rss_bytes", usage.total.rssBytes);
+        if (usage.total.handlesKnown) AppendField(&payload, "handles", (uint64_t)usage.total.handles);
+        if (usage.total.switchesKnown) AppendField(&payload, "switches_per_sec", usage.total.switchesPerSec);
+        AppendField(&payload, "sample_us", usage.sampleMicros);
+        for (const ProcessUsage& process : usage.processes) {
+            std::string base = "process_" + std::to_string(process.pid) + "_";
+            AppendField(&payload, (base + "role").c_str(), std::string(process.master ? "master" : "worker"));
+            AppendField(&payload, (base + "cpu_percent").c_str(), process.cpuPercent);
+            AppendField(&payload, (base + "rss_bytes").c_str(), process.rssBytes);
+            if (process.handlesKnown) AppendField(&payload, (base + "handles").c_str(), (uint64_t)process.handles);
+            if (process.switchesKnown) {
+                AppendField(&payload, (base + "switches_per_sec").c_str(), process.switchesPerSec);
+                AppendField(&payload, (base + "involuntary_per_sec").c_str(), process.involuntaryPerSec);
+            }
+        }
+    }
+
+    LogRotationStats rotation = m_logRotator.Stats();
+    AppendField(&payload, "rotate_count", rotation.rotations);
+    AppendField(&payload, "rotate_failures", rotation.rotateFailures);
+    AppendField(&payload, "rotate_last_ms", (double)rotation.lastRotateMicros / 1000.0);
+    AppendField(&payload, "compress_count", rotation.compressed);
+    AppendField(&payload, "compress_failures", rotation.compressFailures);
+    AppendField(&payload, "compress_pending", (uint64_t)rotation.pending);
+    AppendField(&payload, "compress_in_bytes", rotation.bytesIn);
+    AppendField(&payload, "compress_out_bytes", rotation.bytesOut);
+    AppendField(&payload, "compress_mb_per_sec",
+                rotation.compressMicros > 0 ? rotation.bytesIn / 1048576.0 / (rotation.compressMicros / 1e6) : 0.0);
+    AppendField(&payload, "archives_pruned", rotation.pruned);
+
+    ConfigWatchStats watch = m_confWatcher.Stats();
+    if (watch.running) {
+        AppendField(&payload, "conf_watch_dirs", (uint64_t)watch.directories);
+        AppendField(&payload, "conf_changes", watch.changes);
+        AppendField(&payload, "conf_changes_ignored", watch.ignored);
+    }
+
+    HealthSnapshot health = m_healthProber.Snapshot();
+    if (health.running) {
+        AppendField(&payload, "upstream_targets", (uint64_t)health.targets);
+        AppendField(&payload, "upstream_up", (uint64_t)health.up);
+        AppendField(&payload, "upstream_down", (uint64_t)health.down);
+        AppendField(&payload, "upstream_probes", health.probes);
+    }
+
+    ControlServerStats control = m_server.Stats();
+    AppendField(&payload, "control_connections", control.open);
+    AppendField(&payload, "control_requests", control.requests);
+    AppendField(&payload, "pending_operations", (uint64_t)m_queue.PendingCount());
+    return payload;
+}
+
+// 每个 upstream 一行汇总，其后每个 server 一行：
+//   upstream=<名称> <可用> <不可用> <未知> <未探测>
+//   server=<名称> <地址> <up|down|unknown> <延迟 ms> [失败原因]
+std::string Daemon::UpstreamsPayload() {
+    HealthSnapshot health = m_healthProber.Snapshot();
+    std::string payload;
+    AppendField(&payload, "running", (uint64_t)(health.running ? 1 : 0));
+    if (!health.error.empty()) AppendField(&payload, "error", health.error);
+    AppendField(&payload, "targets", (uint64_t)health.targets);
+    AppendField(&payload, "up", (uint64_t)health.up);
+    AppendField(&payload, "down", (uint64_t)health.down);
+    AppendField(&payload, "unknown", (uint64_t)health.unknown);
+    AppendField(&payload, "probes", health.probes);
+    AppendField(&payload, "loop_ms", health.loopMicros / 1000.0);
+    char text[128];
+    for (const UpstreamStatus& upstream : health.upstreams) {
+        snprintf(text, sizeof(text), " %u %u %u %u", upstream.up, upstream.down, upstream.unknown, upstream.skipped);
+        AppendField(&payload, "upstream", upstream.name + text);
+        for (const UpstreamServerStatus& server : upstream.servers) {
+            snprintf(text, sizeof(text), " %s %.2f", UpstreamHealthName(server.health),
+                     server.health == UPSTREAM_UP ? server.latencyMicros / 1000.0 : 0.0);
+            std::string line = upstream.name + " " + server.address + text;
+            if (server.backup) line += " backup";
+            if (!server.error.empty()) line += " " + server.error;
+            AppendField(&payload, "server", line);
+        }
+    }
+    return payload;
+}
+
+// 控制通道线程中调用：排给查询线程执行，完成时回复
+void Daemon::StartQuery(const ControlRequest& request) {
+    {
+        std::lock_guard<std::mutex> lock(m_queryMutex);
+        m_queries.push_back(request);
+    }
+    m_queryWake.notify_all();
+}
+
+// 查询线程
+void Daemon::QueryLoop() {
+    TraceSetThreadName("daemon-query");
+    for (;;) {
+        ControlRequest request;
+        {
+            std::unique_lock<std::mutex> lock(m_queryMutex);
+            m_queryWake.wait(lock, [this]() { return m_queryStopping || !m_queries.empty(); });
+            if (m_queryStopping) break;
+            request = std::move(m_queries.front());
+            m_queries.pop_front();
+        }
+        uint8_t status = CONTROL_OK;
+        std::string payload;
+        switch (request.command) {
+            case CONTROL_TRACE: payload = TracePayload(request.payload, &status); break;
+            case CONTROL_JOURNAL: payload = JournalPayload(request.payload, &status); break;
+            default: payload = AffinityPayload(request.payload, &status); break;
+        }
+        m_server.Respond(request.connection, request.id, status, payload);
+    }
+}
+
+// 导出文件只能写在 <prefix>/logs 下：export=<文件名>.json，不允许带目录，免得控制端借此覆盖任意文件
+static bool TraceExportName(const std::string& name, std::string* error) {
+    bool plain = !name.empty() && name[0] != '.' && name.size() > 5 &&
+                 name.compare(name.size() - 5, 5, ".json") == 0;
+    for (char c : name) {
+        if (IsPathSeparator(c) || c == ':') plain = false;
+    }
+    if (!plain && error) *error = "导出文件名无效: " + name + " (只能是 logs 目录下的 .json 文件名)";
+    return plain;
+}
+
+// 按请求中的 enable=0|1 开关追踪、export=<文件名>|1 导出 Chrome trace JSON 到 logs 目录，再列出各区间的耗时统计：
+// span=<类别> <次数> <总计ms> <p50> <p90> <p99> <max> <标签>
+std::string Daemon::TracePayload(const std::string& request, uint8_t* status) {
+    std::string exportPath;
+    std::string exportError;
+    for (const auto& field : ParseFields(request)) {
+        if (field.first == "enable") {
+            TraceEnable(field.second != "0");
+        } else if (field.first == "export") {
+            std::string logs = m_service.PrefixPath("logs");
+            if (field.second == "1") {
+                exportPath = TraceExportPath(logs);
+            } else if (TraceExportName(field.second, &exportError)) {
+                exportPath = JoinPath(logs, field.second);
+            }
+        }
+    }
+
+    std::string payload;
+    TraceSummary summary = CollectTraceSummary();
+    AppendField(&payload, "enabled", (uint64_t)(summary.enabled ? 1 : 0));
+    AppendField(&payload, "threads", (uint64_t)summary.threads);
+    AppendField(&payload, "spans", summary.spans);
+    AppendField(&payload, "retained", summary.retained);
+    if (summary.overflowLabels) AppendField(&payload, "overflow_labels", summary.overflowLabels);
+    char text[160];
+    for (const TraceStat& stat : summary.stats) {
+        snprintf(text, sizeof(text), "%s %llu %.3f %.3f %.3f %.3f %.3f ", TraceKindName(stat.kind),
+                 (unsigned long long)stat.count, stat.totalMicros / 1000.0, stat.p50Micros / 1000.0,
+                 stat.p90Micros / 1000.0, stat.p99Micros / 1000.0, stat.maxMicros / 1000.0);
+        AppendField(&payload, "span", text + stat.label);
+    }
+
+    if (!exportError.empty()) {
+        AppendField(&payload, "error", exportError);
+        *status = CONTROL_BAD_REQUEST;
+    } else if (!exportPath.empty()) {
+        size_t exported = 0;
+        std::string error;
+        if (ExportChromeTrace(exportPath, &exported, &error)) {
+            AppendField(&payload, "exported", (uint64_t)exported);
+            AppendField(&payload, "file", exportPath);
+        } else {
+            AppendField(&payload, "error", error);
+            *status = CONTROL_FAILED;
+        }
+    }
+    return payload;
+}
+
+// 按请求中的 from= / to=（写法同 logquery，默认最近 24 小时）、type=log|event|operation、limit=<条数>
+// 查询持久化的操作日志，每条一行：record=<本地时间> <类型> <级别> <数值ms> <文本>
+std::string Daemon::JournalPayload(const std::string& request, uint8_t* status) {
+    static const char* const kTypeNames[] = { "", "log", "event", "operation" };
+    static const char* const kSeverityNames[] = { "detail", "plain", "info", "success", "warning", "error" };
+    static const size_t kMaxRecords = 5000;
+    static const size_t kMaxPayload = 512 * 1024;    // 控制帧上限为 1MB，留出余量
+
+    std::string payload;
+    if (!m_journal.IsOpen()) {
+        AppendField(&payload, "error", std::string("操作日志未持久化 (未指定 --journal)"));
+        *status = CONTROL_FAILED;
+        return payload;
+    }
+    int64_t now = UtcTimeMicros() / 1000000;
+    int64_t fromSecond = now - 86400;
+    int64_t toSecond = INT64_MAX / 1000000;
+    uint32_t typeMask = kJournalAllTypes;
+    size_t limit = 100;
+    for (const auto& field : ParseFields(request)) {
+        bool ok = true;
+        if (field.first == "from") {
+            ok = ParseQueryTime(field.second, now, &fromSecond);
+        } else if (field.first == "to") {
+            ok = ParseQueryTime(field.second, now, &toSecond);
+        } else if (field.first == "type") {
+            typeMask = 0;
+            for (int type = JOURNAL_LOG; type <= JOURNAL_OPERATION; ++type) {
+                if (field.second == kTypeNames[type]) typeMask = JournalMask((JournalType)type);
+            }
+            ok = typeMask != 0;
+        } else if (field.first == "limit") {
+            limit = std::min((size_t)strtoul(field.second.c_str(), nullptr, 10), kMaxRecords);
+        }
+        if (!ok) {
+            AppendField(&payload, "error", "查询参数无效: " + field.first + "=" + field.second);
+            *status = CONTROL_BAD_REQUEST;
+            return payload;
+        }
+    }
+
+    std::vector<JournalRecord> records;
+    m_journal.Query(fromSecond * 1000000, toSecond * 1000000, typeMask, limit, &records);
+    AppendField(&payload, "records", (uint64_t)records.size());
+    int64_t offset = LocalOffsetMicros();
+    char text[96];
+    for (const JournalRecord& record : records) {
+        if (payload.size() > kMaxPayload) {
+            AppendField(&payload, "truncated", std::string("1"));
+            break;
+        }
+        time_t seconds = (time_t)((record.timeMicros + offset) / 1000000);
+        struct tm parts;
+#ifdef _WIN32
+        gmtime_s(&parts, &seconds);
+#else
+        gmtime_r(&seconds, &parts);
+#endif
+        snprintf(text, sizeof(text), "%04d-%02d-%02dT%02d:%02d:%02d %s %s %.1f ", parts.tm_year + 1900,
+                 parts.tm_mon + 1, parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec,
+                 record.type <= JOURNAL_OPERATION ? kTypeNames[record.type] : "unknown",
+                 record.severity <= LOG_ERROR ? kSeverityNames[record.severity] : "plain", record.value / 1000.0);
+        AppendField(&payload, "record", text + record.text);
+    }
+    return payload;
+}
+
+// 按请求中的 workers=<n>、smt=1 生成绑定计划
+bool Daemon::PlanAffinity(const std::string& payload, CpuTopology* topology, AffinityPlan* plan, std::string* error) {
+    AffinityOptions options;
+    for (const auto& field : ParseFields(payload)) {
+        if (field.first == "workers") {
+            options.maxWorkers = (uint32_t)strtoul(field.second.c_str(), nullptr, 10);
+        } else if (field.first == "smt") {
+            options.useSmt = field.second == "1";
+        }
+    }
+    if (!topology->Discover(error)) return false;
+    *plan = PlanWorkerAffinity(*topology, options);
+    if (plan->cpus.empty()) {
+        if (error) *error = "没有可用于绑定的 CPU";
+        return false;
+    }
+    return true;
+}
+
+std::string Daemon::AffinityPayload(const std::string& request, uint8_t* status) {
+    std::string payload;
+    CpuTopology topology;
+    AffinityPlan plan;
+    std::string error;
+    if (!PlanAffinity(request, &topology, &plan, &error)) {
+        AppendField(&payload, "error", error);
+        *status = CONTROL_FAILED;
+        return payload;
+    }
+    AppendField(&payload, "topology", topology.Summary());
+    AppendField(&payload, "packages", (uint64_t)topology.Packages());
+    AppendField(&payload, "numa_nodes", (uint64_t)topology.Nodes());
+    AppendField(&payload, "l3_domains", (uint64_t)topology.L3Domains());
+    AppendField(&payload, "cores", (uint64_t)topology.Cores());
+    AppendField(&payload, "threads", (uint64_t)topology.Cpus().size());
+    AppendField(&payload, "allowed", (uint64_t)topology.AllowedCount());
+    AppendField(&payload, "plan_worker_processes", plan.workerProcesses);
+    AppendField(&payload, "plan_cpus", FormatCpuList(plan.cpus));
+    AppendField(&payload, "plan_cpu_affinity", plan.cpuAffinity);
+
+    // 当前配置与运行中 worker 的比对
+    NginxConfig config;
+    if (!config.Load(m_service.ConfPath(), &error)) {
+        AppendField(&payload, "check", "配置解析失败: " + error);
+        return payload;
+    }
+    // 状态缓存只属于事件循环线程，这里单独扫描一次
+    ProcessTable table;
+    table.SetPrefix(m_options.prefix);
+    table.Refresh();
+    if (table.MasterPid() == 0) {
+        AppendField(&payload, "check", std::string("not-running"));
+        return payload;
+    }
+    AffinityCheck check = CheckWorkerAffinity(config, topology, table.WorkerPids());
+    AppendField(&payload, "check", std::string(!check.configured ? "not-configured" : check.ok ? "match" : "mismatch"));
+    AppendField(&payload, "workers_expected", (uint64_t)check.expectedWorkers);
+    AppendField(&payload, "workers_running", (uint64_t)check.runningWorkers);
+    AppendField(&payload, "workers_matched", (uint64_t)check.matched);
+    for (const std::string& problem : check.problems) AppendField(&payload, "problem", problem);
+    return payload;
+}
+
+// 控制通道线程中调用：确定目标与配置指纹后在独立线程中压测，完成时回复
+void Daemon::StartLoadTest(const ControlRequest& request) {
+    Waiter waiter{request.connection, request.id};
+    auto fail = [this, &waiter](uint8_t status, const std::string& error) {
+        std::string payload;
+        AppendField(&payload, "error", error);
+        m_server.Respond(waiter.connection, waiter.requestId, status, payload);
+    };
+    if (m_loadTestRunning) {
+        fail(CONTROL_FAILED, "已有压测正在进行");
+        return;
+    }
+
+    m_statusTable.Refresh();
+    m_statusMicros = MonotonicMicros();
+    if (m_statusTable.MasterPid() == 0) {
+        fail(CONTROL_FAILED, "nginx 未运行");
+        return;
+    }
+    // 目标默认取配置中的第一个 http server，参数可逐项覆盖
+    NginxConfig config;
+    std::string error;
+    if (!config.Load(m_service.ConfPath(), &error)) {
+        fail(CONTROL_FAILED, "配置解析失败: " + error);
+        return;
+    }
+    LoadTestOptions options;
+    bool hostGiven = false;
+    for (const auto& field : ParseFields(request.payload)) {
+        if (field.first == "host") hostGiven = true;
+    }
+    if (!FindLoadTestTarget(config, &options, &error) && !hostGiven) {
+        fail(CONTROL_FAILED, error);
+        return;
+    }
+    for (const auto& field : ParseFields(request.payload)) {
+        uint32_t number = (uint32_t)strtoul(field.second.c_str(), nullptr, 10);
+        if (field.first == "connections") {
+            options.connections = number;
+        } else if (field.first == "threads") {
+            options.threads = number;
+        } else if (field.first == "rate") {
+            options.requestsPerSec = number;
+        } else if (field.first == "duration") {
+            options.durationMs = number * 1000;
+        } else if (field.first == "warmup") {
+            options.warmupMs = number * 1000;
+        } else if (field.first == "timeout_ms") {
+            options.timeoutMs = number;
+        } else if (field.first == "path") {
+            options.path = field.second;
+        } else if (field.first == "port") {
+            options.port = (uint16_t)number;
+        } else if (field.first == "host") {
+            options.host = field.second;
+            options.hostHeader.clear();
+        }
+    }
+    if (options.connections == 0 || options.connections > 10000 || options.durationMs == 0 || options.port == 0) {
+        fail(CONTROL_BAD_REQUEST, "参数无效: 连接数需在 1~10000 之间，时长与端口不能为 0");
+        return;
+    }
+    if (!IsLoopbackHost(options.host)) {
+        fail(CONTROL_BAD_REQUEST, options.host + " 不是本机回环地址，压测只允许访问本机");
+        return;
+    }
+    uint64_t configHash = ConfigFingerprint(config, NginxBinaryPath(m_options.prefix));
+
+    if (m_loadTest.joinable()) m_loadTest.join();
+    m_loadTestRunning = true;
+    m_loadTest = std::thread([this, waiter, options, configHash]() { RunLoadTest(waiter, options, configHash); });
+}
+
+// 压测线程中执行
+void Daemon::RunLoadTest(Waiter waiter, LoadTestOptions options, uint64_t configHash) {
+    char text[256];
+    snprintf(text, sizeof(text), "开始压测 %s:%u%s (%u 连接, %s, %u 秒)", options.host.c_str(),
+             (unsigned)options.port, options.path.c_str(), options.connections,
+             options.requestsPerSec ? (std::to_string(options.requestsPerSec) + " 请求/秒").c_str() : "不限速",
+             options.durationMs / 1000);
+    Log(LOG_INFO, text);
+
+    LoadTestResult result;
+    std::string error;
+    std::string payload;
+    if (!::RunLoadTest(options, &m_loadTestCancel, &result, &error)) {
+        Log(LOG_ERROR, "✗ 压测失败: " + error);
+        AppendField(&payload, "error", error);
+        m_server.Respond(waiter.connection, waiter.requestId, CONTROL_FAILED, payload);
+        m_loadTestRunning = false;
+        return;
+    }
+
+    LoadTestRecord record = MakeLoadTestRecord(configHash, options, result);
+    LoadTestHistory history(m_service.PrefixPath("logs/loadtest"));
+    std::string saveError;
+    if (!history.Append(record, &saveError)) Log(LOG_WARNING, "压测结果无法保存: " + saveError);
+    Log(result.Errors() ? LOG_WARNING : LOG_SUCCESS, "✓ 压测完成: " + FormatLoadTestSummary(result));
+    if (m_journal.IsOpen()) {
+        m_journal.Append(JOURNAL_EVENT, (uint8_t)(result.Errors() ? LOG_WARNING : LOG_SUCCESS), (int64_t)record.p99,
+                         "loadtest", UtcTimeMicros());
+    }
+
+    AppendField(&payload, "config", FormatConfigHash(configHash));
+    AppendField(&payload, "target", record.target);
+    AppendField(&payload, "connections", (uint64_t)options.connections);
+    AppendField(&payload, "threads", (uint64_t)options.threads);
+    AppendField(&payload, "rate", (uint64_t)options.requestsPerSec);
+    AppendField(&payload, "duration_s", result.measuredMicros / 1e6);
+    AppendField(&payload, "requests", result.requests);
+    AppendField(&payload, "rps", result.RequestsPerSec());
+    AppendField(&payload, "p50_ms", record.p50 / 1000.0);
+    AppendField(&payload, "p90_ms", record.p90 / 1000.0);
+    AppendField(&payload, "p99_ms", record.p99 / 1000.0);
+    AppendField(&payload, "p999_ms", record.p999 / 1000.0);
+    AppendField(&payload, "max_ms", record.max / 1000.0);
+    AppendField(&payload, "mean_ms", record.mean / 1000.0);
+    AppendField(&payload, "non2xx", record.non2xx);
+    AppendField(&payload, "timeouts", result.timeouts);
+    AppendField(&payload, "connect_errors", result.connectErrors);
+    AppendField(&payload, "read_errors", result.readErrors);
+    AppendField(&payload, "reconnects", result.reconnects);
+    if (options.requestsPerSec) AppendField(&payload, "backlog_max", result.backlogMax);
+    if (m_loadTestCancel) AppendField(&payload, "cancelled", std::string("1"));
+    m_server.Respond(waiter.connection, waiter.requestId, CONTROL_OK, payload);
+    m_loadTestRunning = false;
+}
+
+// 默认对比最近两份配置（base 为较早的一份）；每项输出 "左 右 变化"
+std::string Daemon::ComparePayload(const std::string& request, uint8_t* status) {
+    std::string baseKey = "~1";
+    std::string otherKey;
+    for (const auto& field : ParseFields(request)) {
+        if (field.first == "base") baseKey = field.second;
+        if (field.first == "other") otherKey = field.second;
+    }
+    LoadTestHistory history(m_service.PrefixPath("logs/loadtest"));
+    LoadTestRecord base;
+    LoadTestRecord other;
+    std::string error;
+    std::string payload;
+    if (!history.Find(baseKey, &base, &error) || !history.Find(otherKey, &other, &error)) {
+        *status = CONTROL_FAILED;
+        AppendField(&payload, "error", error);
+        return payload;
+    }
+
+    auto row = [&payload](const char* key, double left, double right, bool percent) {
+        char text[96];
+        if (percent && left > 0) {
+            snprintf(text, sizeof(text), "%.3f %.3f %+.1f%%", left, right, (right - left) * 100.0 / left);
+        } else {
+            snprintf(text, sizeof(text), "%.3f %.3f", left, right);
+        }
+        AppendField(&payload, key, std::string(text));
+    };
+    AppendField(&payload, "base", FormatConfigHash(base.configHash));
+    AppendField(&payload, "other", FormatConfigHash(other.configHash));
+    AppendField(&payload, "base_run", FormatLoadTestRecord(base));
+    AppendField(&payload, "other_run", FormatLoadTestRecord(other));
+    row("rps", base.throughput, other.throughput, true);
+    row("p50_ms", base.p50 / 1000.0, other.p50 / 1000.0, true);
+    row("p90_ms", base.p90 / 1000.0, other.p90 / 1000.0, true);
+    row("p99_ms", base.p99 / 1000.0, other.p99 / 1000.0, true);
+    row("p999_ms", base.p999 / 1000.0, other.p999 / 1000.0, true);
+    row("max_ms", base.max / 1000.0, other.max / 1000.0, true);
+    AppendField(&payload, "errors", std::to_string(base.errors) + " " + std::to_string(other.errors));
+    AppendField(&payload, "non2xx", std::to_string(base.non2xx) + " " + std::to_string(other.non2xx));
+    if (base.target != other.target || base.connections != other.connections ||
+        base.requestsPerSec != other.requestsPerSec) {
+        AppendField(&payload, "warning", std::string("两次压测的目标或负载参数不同，结果不能直接比较"));
+    }
+    return payload;
+}
+
+// 控制通道线程中调用：解析查询后交给列存线程，导入完成、查询结束时回复
+void Daemon::StartLogQuery(const ControlRequest& request) {
+    std::string payload;
+    if (!m_logStore) {
+        AppendField(&payload, "error", std::string("访问日志列存未启用 (--no-log-store)"));
+        m_server.Respond(request.connection, request.id, CONTROL_FAILED, payload);
+        return;
+    }
+    LogQuery query;
+    std::string error;
+    if (!ParseLogQuery(ParseFields(request.payload), UtcTimeMicros() / 1000000, &query, &error)) {
+        AppendField(&payload, "error", error);
+        m_server.Respond(request.connection, request.id, CONTROL_BAD_REQUEST, payload);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_logStoreMutex);
+        m_logQueries.emplace_back(Waiter{request.connection, request.id}, query);
+    }
+    m_logStoreWake.notify_all();
+}
+
+// 列存线程：等待轮转事件或查询；有查询时先把新的归档导入，再依次回答
+void Daemon::LogStoreLoop() {
+    for (;;) {
+        std::deque<std::pair<Waiter, LogQuery>> queries;
+        bool ingest = false;
+        {
+            std::unique_lock<std::mutex> lock(m_logStoreMutex);
+            m_logStoreWake.wait(lock, [this]() {
+                return m_logStoreStopping || m_logStoreIngest || !m_logQueries.empty();
+            });
+            if (m_logStoreStopping) break;
+            queries.swap(m_logQueries);
+            // 查询前总是补一次导入：明文归档要静置一分钟，轮转事件时可能还没有导入
+            ingest = m_logStoreIngest || !queries.empty();
+            m_logStoreIngest = false;
+        }
+        if (ingest) {
+            LogIngestStats stats = m_logStore->IngestArchives(
+                CollectAccessLogSources(m_options.prefix, m_service.ConfPath()), &m_logStoreCancel);
+            if (stats.files > 0 || stats.failed > 0) {
+                Log(stats.failed ? LOG_WARNING : LOG_DETAIL, "访问日志列存: " + FormatLogIngestStats(stats));
+            }
+        }
+        for (const auto& entry : queries) {
+            uint8_t status = CONTROL_OK;
+            std::string payload = LogQueryPayload(entry.second, &status);
+            m_server.Respond(entry.first.connection, entry.first.requestId, status, payload);
+        }
+    }
+    // 关闭时仍在排队的查询不再回答（控制通道已先停止）
+}
+
+// 每个分组一行 "count bytes mean_ms p50_ms p90_ms p99_ms max_ms key"，键放在最后（可能含空格）
+std::string Daemon::LogQueryPayload(const LogQuery& query, uint8_t* status) {
+    LogQueryResult result = m_logStore->Query(query);
+    std::string payload;
+    if (!result.error.empty()) {
+        *status = CONTROL_FAILED;
+        AppendField(&payload, "error", result.error);
+        return payload;
+    }
+    AppendField(&payload, "segments", std::to_string(result.segmentsScanned) + "/" + std::to_string(result.segments));
+    AppendField(&payload, "rows", result.totalRows);
+    AppendField(&payload, "scanned_rows", result.scannedRows);
+    AppendField(&payload, "matched_rows", result.matchedRows);
+    AppendField(&payload, "scanned_mb", result.scannedBytes / 1048576.0);
+    AppendField(&payload, "threads", (uint64_t)result.threads);
+    AppendField(&payload, "query_ms", result.micros / 1000.0);
+    AppendField(&payload, "groups", result.groupCount);
+    AppendField(&payload, "columns", std::string("count bytes mean_ms p50_ms p90_ms p99_ms max_ms key"));
+    char text[160];
+    for (const LogQueryGroup& group : result.groups) {
+        snprintf(text, sizeof(text), "%llu %llu %.1f %u %u %u %u ", (unsigned long long)group.count,
+                 (unsigned long long)group.bytes, group.meanMs, group.p50Ms, group.p90Ms, group.p99Ms, group.maxMs);
+        AppendField(&payload, "group", text + group.key);
+    }
+    return payload;
+}
+
+void Daemon::SubmitServiceOperation(const ControlRequest& request) {
+    int command = request.command;
+    int group = (command == CONTROL_RELOAD || command == CONTROL_APPLY_AFFINITY) ? 0 : kServiceGroup;
+    std::string payload = request.payload;
+    uint64_t id = m_queue.Submit(command, group, [this, command, payload](OperationContext& context) {
+        RunServiceOperation(context, command, payload);
+    });
+
+    Waiter waiter{request.connection, request.id};
+    Finished finished;
+    {
+        std::lock_guard<std::mutex> lock(m_waitMutex);
+        auto recent = m_recent.find(id);
+        if (recent == m_recent.end()) {
+            m_waiters[id].push_back(waiter);
+            return;
+        }
+        // 合并到的操作在 Submit 返回后已经完成
+        finished = recent->second;
+    }
+    Reply(waiter, finished);
+}
+
+// 操作队列线程中执行
+void Daemon::RunServiceOperation(OperationContext& context, int command, const std::string& payload) {
+    ServiceOutcome outcome;
+    // 主动停止 / 强制重启前先解除监护，否则结束进程会被当作崩溃
+    switch (command) {
+        case CONTROL_START: outcome = m_service.Start(context); break;
+        case CONTROL_STOP: m_supervisor.Unwatch(); outcome = m_service.Stop(context); break;
+        case CONTROL_RESTART: m_supervisor.Unwatch(); outcome = m_service.Restart(context, true); break;
+        case CONTROL_RELOAD: outcome = m_service.Reload(context); break;
+        case CONTROL_APPLY_AFFINITY: {
+            // 拓扑读取 /sys，与绑定一起在操作队列中执行
+            CpuTopology topology;
+            AffinityPlan plan;
+            if (!PlanAffinity(payload, &topology, &plan, &outcome.detail)) break;
+            outcome = m_service.ApplyCpuAffinity(context, plan);
+            break;
+        }
+        case kRecoverOperation: outcome = m_service.Recover(context); break;
+        case kConfigChangeOperation: outcome = ApplyConfigChange(context); break;
+    }
+    if (command == kRecoverOperation) {
+        // 被取代时由 OnOperationComplete 处理
+        if (outcome.ok && outcome.masterPid) {
+            m_supervisor.RestartSucceeded(outcome.masterPid, m_service.PidFile());
+        } else if (!context.IsCancelled()) {
+            m_supervisor.RestartFailed(outcome.detail.empty() ? "启动失败" : outcome.detail);
+        }
+    } else if (command != CONTROL_STOP) {
+        // 新启动的 master 开始监护；重启校验失败时原来的 master 仍在运行，重新纳入监护
+        ProcessId master = m_service.MasterPid();
+        if (master) m_supervisor.Watch(master, m_service.PidFile());
+    }
+    if (outcome.changed) {
+        m_accessLog.Rediscover();
+        m_stubStatus.Rediscover();
+        m_processSampler.Rescan();
+        m_logRotator.Rescan();
+        m_healthProber.Rediscover();
+        if (m_journal.IsOpen()) {
+            m_journal.Append(JOURNAL_EVENT, (uint8_t)(outcome.ok ? LOG_SUCCESS : LOG_ERROR),
+                             (int64_t)outcome.latencyMicros, OperationName(command), UtcTimeMicros());
+        }
+    }
+    m_statusStale = true;
+
+    std::lock_guard<std::mutex> lock(m_waitMutex);
+    m_outcomes[context.Id()] = outcome;
+}
+
+// 操作完成（工作线程）或被取代（提交线程）时调用
+void Daemon::OnOperationComplete(const OperationResult& result) {
+    if (!result.cancelled && m_journal.IsOpen()) {
+        m_journal.Append(JOURNAL_OPERATION, (uint8_t)LOG_INFO, (int64_t)result.runMicros,
+                         OperationName(result.kind), UtcTimeMicros());
+    }
+    // 自动恢复被控制命令取代：交由该命令决定是否监护
+    if (result.cancelled && result.kind == kRecoverOperation) {
+        m_supervisor.Unwatch();
+    }
+
+    std::vector<Waiter> waiters;
+    Finished finished;
+    finished.cancelled = result.cancelled;
+    {
+        std::lock_guard<std::mutex> lock(m_waitMutex);
+        auto outcome = m_outcomes.find(result.id);
+        if (outcome != m_outcomes.end()) {
+            finished.outcome = outcome->second;
+            m_outcomes.erase(outcome);
+        }
+        auto it = m_waiters.find(result.id);
+        if (it != m_waiters.end()) {
+            waiters.swap(it->second);
+            m_waiters.erase(it);
+        }
+        m_recent[result.id] = finished;
+        while (m_recent.size() > kRecentResults) m_recent.erase(m_recent.begin());
+    }
+    for (const Waiter& waiter : waiters) {
+        Reply(waiter, finished);
+    }
+}
+
+void Daemon::Reply(const Waiter& waiter, const Finished& finished) {
+    std::string payload;
+    uint8_t status;
+    if (finished.cancelled) {
+        status = CONTROL_CANCELLED;
+        AppendField(&payload, "error", std::string("已被后续操作取代"));
+    } else {
+        status = finished.outcome.ok ? CONTROL_OK : CONTROL_FAILED;
+        AppendField(&payload, "changed", (uint64_t)(finished.outcome.changed ? 1 : 0));
+        AppendField(&payload, "latency_ms", finished.outcome.latencyMicros / 1000.0);
+        if (!finished.outcome.detail.empty()) {
+            AppendField(&payload, finished.outcome.ok ? "detail" : "error", finished.outcome.detail);
+        }
+    }
+    m_server.Respond(waiter.connection, waiter.requestId, status, payload);
+}
+
+// 日志轮转线程中调用
+void Daemon::OnLogRotationEvent(const LogRotationEvent& event) {
+    bool failed = event.type == LOG_ROTATE_FAILED || event.type == LOG_COMPRESS_FAILED;
+    Log(failed ? LOG_ERROR : event.type == LOG_PRUNED ? LOG_DETAIL : LOG_SUCCESS, FormatLogRotationEvent(event));
+    if ((event.type == LOG_ROTATED || event.type == LOG_ROTATE_FAILED) && m_journal.IsOpen()) {
+        m_journal.Append(JOURNAL_EVENT, (uint8_t)(failed ? LOG_ERROR : LOG_SUCCESS), (int64_t)event.micros, "rotate",
+                         UtcTimeMicros());
+    }
+    // 新的归档交给列存线程导入；压缩后的 .lz4 与原归档同名，不会重复导入
+    if (m_logStore && (event.type == LOG_ROTATED || event.type == LOG_COMPRESSED)) {
+        {
+            std::lock_guard<std::mutex> lock(m_logStoreMutex);
+            m_logStoreIngest = true;
+        }
+        m_logStoreWake.notify_all();
+    }
+}
+
+// 配置监视线程中调用：合并到尚未处理的修改中，校验与重新加载交给操作队列（同类操作排队时自动合并）
+void Daemon::OnConfigChange(const ConfigChange& change) {
+    Log(LOG_INFO, "检测到配置修改: " + FormatConfigChange(change));
+    {
+        std::lock_guard<std::mutex> lock(m_confChangeMutex);
+        if (m_confChange.firstMicros == 0) {
+            m_confChange = change;
+        } else {
+            m_confChange.events += change.events;
+            m_confChange.settledMicros = change.settledMicros;
+        }
+    }
+    m_queue.Submit(kConfigChangeOperation, 0, [this](OperationContext& context) {
+        RunServiceOperation(context, kConfigChangeOperation, std::string());
+    });
+}
+
+// 操作队列线程中执行：生效后记录从保存配置到新 worker 接管的耗时（同时作为该操作在操作日志中的耗时）
+ServiceOutcome Daemon::ApplyConfigChange(OperationContext& context) {
+    ConfigChange change;
+    {
+        std::lock_guard<std::mutex> lock(m_confChangeMutex);
+        change = m_confChange;
+        m_confChange = ConfigChange();
+    }
+    uint64_t begin = MonotonicMicros();
+    ServiceOutcome outcome = m_service.ApplyConfigChange(context);
+    if (!outcome.changed || !outcome.ok || change.firstMicros == 0) return outcome;
+
+    uint64_t live = MonotonicMicros();
+    char text[256];
+    snprintf(text, sizeof(text),
+             "✓ 配置修改已生效: 保存到新 worker 接管 %.1f ms (防抖 %.1f ms, 排队 %.1f ms, 校验与重新加载 %.1f ms)",
+             (live - change.firstMicros) / 1000.0, (change.settledMicros - change.firstMicros) / 1000.0,
+             (begin - change.settledMicros) / 1000.0, (live - begin) / 1000.0);
+    Log(LOG_SUCCESS, text);
+    outcome.latencyMicros = live - change.firstMicros;
+    return outcome;
+}
+
+// 健康检查线程中调用：只记录状态变化，探测结果由 upstreams 命令查询
+void Daemon::OnHealthEvent(const HealthEvent& event) {
+    Log(event.health == UPSTREAM_UP ? LOG_SUCCESS : LOG_ERROR, FormatHealthEvent(event));
+    if (m_journal.IsOpen()) {
+        m_journal.Append(JOURNAL_EVENT, (uint8_t)(event.health == UPSTREAM_UP ? LOG_SUCCESS : LOG_ERROR), 0,
+                         event.health == UPSTREAM_UP ? "upstream-up" : "upstream-down", UtcTimeMicros());
+    }
+}
+
+// 崩溃监护线程中调用：记录退出原因与恢复耗时，需要重启时提交自动恢复
+void Daemon::OnSupervisorEvent(const SupervisorEvent& event) {
+    char exitText[32] = "退出码未知";
+    if (event.exitCodeKnown) snprintf(exitText, sizeof(exitText), "退出码 %d", event.exitCode);
+
+    char text[512];
+    const char* name = nullptr;
+    bool ok = false;
+    uint64_t latencyMicros = 0;
+    switch (event.type) {
+        case SUPERVISOR_EXITED:
+            latencyMicros = event.uptimeMicros;
+            if (event.clean) {
+                snprintf(text, sizeof(text), "Nginx 已退出 (master PID %u, %s)", (unsigned)event.pid,
+                         event.exitCodeKnown ? exitText : "已删除 pid 文件");
+                Log(LOG_INFO, text);
+                name = "exit";
+                ok = true;
+            } else {
+                int length = snprintf(text, sizeof(text), "✗ Nginx 意外退出 (master PID %u, %s, 运行 %.1f 秒)",
+                                      (unsigned)event.pid, exitText, event.uptimeMicros / 1000000.0);
+                if (event.delayMs > 0 && length > 0 && (size_t)length < sizeof(text)) {
+                    snprintf(text + length, sizeof(text) - length, "，%.1f 秒后第 %u 次自动重启",
+                             event.delayMs / 1000.0, event.attempt);
+                }
+                Log(LOG_ERROR, text);
+                name = "crash";
+            }
+            m_statusStale = true;
+            break;
+
+        case SUPERVISOR_RESTART:
+            m_queue.Submit(kRecoverOperation, kServiceGroup, [this](OperationContext& context) {
+                RunServiceOperation(context, kRecoverOperation, std::string());
+            });
+            break;
+
+        case SUPERVISOR_RECOVERED:
+            snprintf(text, sizeof(text), "✓ Nginx 已自动恢复 (master PID %u, 第 %u 次重启, 停机 %.1f ms)",
+                     (unsigned)event.pid, event.attempt, event.downtimeMicros / 1000.0);
+            Log(LOG_SUCCESS, text);
+            name = "recover";
+            ok = true;
+            latencyMicros = event.downtimeMicros;
+            break;
+
+        case SUPERVISOR_RESTART_FAILED:
+            snprintf(text, sizeof(text), "✗ 第 %u 次自动重启失败: %s", event.attempt, event.reason.c_str());
+            Log(LOG_ERROR, text);
+            name = "recover";
+            break;
+
+        case SUPERVISOR_CRASH_LOOP:
+            snprintf(text, sizeof(text), "✗ Nginx 在短时间内退出 %u 次，判定为崩溃循环，已停止自动重启",
+                     event.recentCrashes);
+            Log(LOG_ERROR, text);
+            name = "crash-loop";
+            break;
+    }
+    if (name && m_journal.IsOpen()) {
+        m_journal.Append(JOURNAL_EVENT, (uint8_t)(ok ? LOG_SUCCESS : LOG_ERROR), (int64_t)latencyMicros, name,
+                         UtcTimeMicros());
+    }
+}
+
+} // namespace
+
+int RunDaemon(const DaemonOptions& options) {
+    if (options.prefix.empty()) {
+        fprintf(stderr, "未指定 nginx 路径 (--prefix)\n");
+        return 2;
+    }
+    TraceSetThreadName("daemon");
+    {
+        std::lock_guard<std::mutex> lock(g_shutdownMutex);
+        g_shutdownRequested = false;
+    }
+
+#ifdef _WIN32
+    SetConsoleCtrlHandler(OnConsoleControl, TRUE);
+#else
+    // 在创建任何线程之前屏蔽退出信号，由专门的线程 sigwait 接收，其他线程不会被信号打断
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigset_t previous;
+    pthread_sigmask(SIG_BLOCK, &signals, &previous);
+    signal(SIGPIPE, SIG_IGN);
+    std::thread signalThread([signals]() {
+        int received = 0;
+        sigwait(&signals, &received);
+        RequestDaemonShutdown();
+    });
+#endif
+
+    int exitCode = 0;
+    {
+        Daemon daemon(options);
+        std::string error;
+        if (daemon.Start(&error)) {
+            std::unique_lock<std::mutex> lock(g_shutdownMutex);
+            g_shutdownWake.wait(lock, []() { return g_shutdownRequested; });
+            lock.unlock();
+            daemon.Stop();
+        } else {
+            fprintf(stderr, "无法启动控制通道: %s\n", error.c_str());
+            exitCode = 1;
+        }
+    }
+
+#ifdef _WIN32
+    SetConsoleCtrlHandler(OnConsoleControl, FALSE);
+#else
+    // 由 RequestDaemonShutdown 退出时信号线程仍在等待，给它发一个信号让它返回
+    pthread_kill(signalThread.native_handle(), SIGTERM);
+    signalThread.join();
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+#endif
+    return exitCode;
+}
@@ -0,0 +1,40 @@
+// nginx-manager/src/daemon.h
+// 无界面模式 - 通过本地控制通道（Unix 域套接字 / 命名管道）接受启动、停止、重载与状态查询
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include "conf_watcher.h"
+#include "health_prober.h"
+#include "log_rotator.h"
+#include <string>
+#include <vector>
+
+struct DaemonOptions {
+    std::string prefix;              // nginx 安装目录（-p）
+    std::string endpoint;            // 控制端点，为空时使用 DefaultControlEndpoint()
+    std::string journalDir;          // 操作日志目录，为空时不持久化
+    bool quiet = false;              // 不在标准错误输出日志
+    bool autoRestart = true;         // nginx 意外退出后自动重启（--no-auto-restart 关闭）
+    LogRotationPolicy rotation;      // 日志轮转与压缩
+    HealthCheckOptions health;       // upstream 健康检查
+    bool logStore = true;            // 轮转后的 access 日志导入列存，供 logquery 查询（--no-log-store 关闭）
+    ConfigWatchOptions confWatch;    // 配置修改后自动校验并重新加载（--no-conf-watch 关闭）
+    bool trace = false;              // 启动时即开启追踪（--trace），运行中也可用 ngctl trace enable=1 开启
+};
+
+// 解析命令行参数：--prefix <dir> --endpoint <path> --journal <dir> --quiet --no-auto-restart，
+// 日志轮转：--rotate-size <MB> --rotate-hours <小时> --rotate-keep <个数> --rotate-keep-mb <MB>
+// --compress-mbps <MB/s> --no-rotate --no-compress（数值为 0 表示不限 / 不按该条件轮转），
+// upstream 健康检查：--health-interval <秒> --health-timeout <毫秒> --health-path <路径> --no-health-check，
+// 访问日志列存：--no-log-store，配置监视：--conf-debounce <毫秒> --no-conf-watch，追踪：--trace，
+// --daemon 原样忽略；未知参数、参数缺值或数值无效时返回 false
+bool ParseDaemonArgs(const std::vector<std::string>& args, DaemonOptions* options, std::string* error);
+
+// 运行守护进程直到收到 Ctrl+C / SIGTERM / SIGINT 或 RequestDaemonShutdown，返回进程退出码
+int RunDaemon(const DaemonOptions& options);
+
+// 请求 RunDaemon 退出，可在任意线程调用
+void RequestDaemonShutdown();
+
+#endif // DAEMON_H
@@ -0,0 +1,20 @@
+// nginx-manager/src/daemon_main.cpp
+// 无界面模式入口（Linux）- nginx-manager-daemon --prefix <dir> [--endpoint <path>] [--journal <dir>] [--quiet]
+
+#include "daemon.h"
+#include <cstdio>
+
+int main(int argc, char** argv) {
+    DaemonOptions options;
+    std::string error;
+    if (!ParseDaemonArgs(std::vector<std::string>(argv + 1, argv + argc), &options, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    if (options.prefix.empty()) {
+        fprintf(stderr, "用法: %s --prefix <nginx 目录> [--endpoint <套接字路径>] [--journal <目录>] [--quiet]\n",
+                argv[0]);
+        return 2;
+    }
+    return RunDaemon(options);
+}
@@ -0,0 +1,225 @@
+// nginx-manager/src/file_util.cpp
+// 文件公共操作 - 各核心模块共用的文件与路径辅助，路径均为 UTF-8（Windows 下转为宽字符 API）
+
+#include "file_util.h"
+#include "trace.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+FILE* OpenFile(const std::string& path, const char* mode) {
+#ifdef _WIN32
+    return _wfopen(Utf8ToWide(path).c_str(), Utf8ToWide(mode).c_str());
+#else
+    return fopen(path.c_str(), mode);
+#endif
+}
+
+bool MakeDirectory(const std::string& path) {
+#ifdef _WIN32
+    return CreateDirectoryW(Utf8ToWide(path).c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+bool RemoveFile(const std::string& path) {
+#ifdef _WIN32
+    return _wremove(Utf8ToWide(path).c_str()) == 0;
+#else
+    return remove(path.c_str()) == 0;
+#endif
+}
+
+bool RenameFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExW(Utf8ToWide(from).c_str(), Utf8ToWide(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+#ifdef _WIN32
+// 符号链接 / 联接指向的最终路径；目标不存在时原样返回
+static std::wstring ResolveFinalPath(const std::wstring& path) {
+    HANDLE file = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (file == INVALID_HANDLE_VALUE) return path;
+    wchar_t buffer[MAX_PATH * 4];
+    DWORD length = GetFinalPathNameByHandleW(file, buffer, (DWORD)(sizeof(buffer) / sizeof(buffer[0])),
+                                             FILE_NAME_NORMALIZED | VOLUME_NAME_DOS);
+    CloseHandle(file);
+    if (length == 0 || length >= sizeof(buffer) / sizeof(buffer[0])) return path;
+    std::wstring resolved(buffer, length);
+    // 去掉 \\?\ 前缀（\\?\UNC\server\share 还原为 \\server\share）
+    if (resolved.compare(0, 8, L"\\\\?\\UNC\\") == 0) return L"\\" + resolved.substr(7);
+    if (resolved.compare(0, 4, L"\\\\?\\") == 0) return resolved.substr(4);
+    return resolved;
+}
+#endif
+
+bool WriteFileAtomically(const std::string& path, const std::string& text, std::string* error) {
+    TraceSpan span(TRACE_CONFIG, "file-write", (int64_t)text.size());
+#ifdef _WIN32
+    std::wstring target = ResolveFinalPath(Utf8ToWide(path));
+    std::wstring wideTemp = target + L".tmp";
+    HANDLE file = CreateFileW(wideTemp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        if (error) *error = "无法创建临时文件: " + WideToUtf8(wideTemp);
+        return false;
+    }
+    DWORD written = 0;
+    bool ok = WriteFile(file, text.data(), (DWORD)text.size(), &written, NULL) && written == text.size() &&
+              FlushFileBuffers(file);
+    CloseHandle(file);
+    if (ok) {
+        // ReplaceFileW 让新文件沿用原文件的 ACL、属性与创建时间；目标不存在时直接改名
+        if (GetFileAttributesW(target.c_str()) != INVALID_FILE_ATTRIBUTES) {
+            ok = ReplaceFileW(target.c_str(), wideTemp.c_str(), NULL, REPLACE_FILE_IGNORE_MERGE_ERRORS, NULL, NULL) != 0;
+        } else {
+            ok = MoveFileExW(wideTemp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        }
+    }
+    if (!ok) {
+        DeleteFileW(wideTemp.c_str());
+        if (error) *error = "无法写入文件: " + path;
+    }
+    return ok;
+#else
+    // 符号链接（如 sites-enabled 指向 sites-available）改写其指向的文件，而不是把链接换成普通文件
+    std::string target = path;
+    if (char* resolved = realpath(path.c_str(), nullptr)) {
+        target = resolved;
+        free(resolved);
+    }
+    std::string temp = target + ".tmp";
+
+    struct stat original;
+    bool exists = stat(target.c_str(), &original) == 0;
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, exists ? 0600 : 0644);
+    if (fd < 0) {
+        if (error) *error = "无法创建临时文件: " + temp + " (" + strerror(errno) + ")";
+        return false;
+    }
+    bool ok = true;
+    if (exists) {
+        // 先设属主再设权限（chown 会清除 setuid / setgid 位）。非 root 时不能改属主，至少保留所属组
+        if (fchown(fd, original.st_uid, original.st_gid) != 0 && fchown(fd, (uid_t)-1, original.st_gid) != 0) {
+            // 组也无法保留（当前用户不在该组）时仍然写入，新文件归当前用户所有
+        }
+        ok = fchmod(fd, original.st_mode & 07777) == 0;
+    }
+    size_t done = 0;
+    while (ok && done < text.size()) {
+        ssize_t n = write(fd, text.data() + done, text.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = false;
+            break;
+        }
+        done += (size_t)n;
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    ok = ok && rename(temp.c_str(), target.c_str()) == 0;
+    if (!ok) {
+        if (error) *error = "无法写入文件: " + path + " (" + strerror(errno) + ")";
+        unlink(temp.c_str());
+    }
+    return ok;
+#endif
+}
+
+bool StatFile(const std::string& path, uint64_t* size, int64_t* ageSeconds) {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExW(Utf8ToWide(path).c_str(), GetFileExInfoStandard, &data)) return false;
+    if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) return false;
+    *size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    if (ageSeconds) {
+        FILETIME now;
+        GetSystemTimeAsFileTime(&now);
+        uint64_t modified = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+        uint64_t current = ((uint64_t)now.dwHighDateTime << 32) | now.dwLowDateTime;
+        *ageSeconds = current > modified ? (int64_t)((current - modified) / 10000000) : 0;
+    }
+    return true;
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    *size = (uint64_t)st.st_size;
+    if (ageSeconds) *ageSeconds = (int64_t)time(nullptr) - (int64_t)st.st_mtime;
+    return true;
+#endif
+}
+
+std::vector<std::string> ListDirectory(const std::string& directory) {
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW(Utf8ToWide(directory + "\\*").c_str(), &data);
+    if (find == INVALID_HANDLE_VALUE) return names;
+    do {
+        if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && data.cFileName[0] != L'.') {
+            names.push_back(WideToUtf8(data.cFileName));
+        }
+    } while (FindNextFileW(find, &data));
+    FindClose(find);
+#else
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return names;
+    while (struct dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.' && entry->d_type != DT_DIR) names.push_back(entry->d_name);
+    }
+    closedir(dir);
+#endif
+    return names;
+}
+
+bool IsPathSeparator(char c) {
+#ifdef _WIN32
+    return c == '\\' || c == '/';
+#else
+    return c == '/';
+#endif
+}
+
+bool IsAbsolutePath(std::string_view path) {
+    if (path.empty()) return false;
+#ifdef _WIN32
+    return IsPathSeparator(path[0]) || (path.size() > 1 && path[1] == ':');
+#else
+    return path[0] == '/';
+#endif
+}
+
+std::string JoinPath(const std::string& directory, const std::string& name) {
+#ifdef _WIN32
+    return directory + "\\" + name;
+#else
+    return directory + "/" + name;
+#endif
+}
+
+std::string DirectoryOf(const std::string& path) {
+    size_t slash = path.size();
+    while (slash > 0 && !IsPathSeparator(path[slash - 1])) --slash;
+    if (slash == 0) return ".";
+    if (slash == 1) return path.substr(0, 1);
+    return path.substr(0, slash - 1);
+}
+
+std::string BaseName(const std::string& path) {
+    size_t slash = path.size();
+    while (slash > 0 && !IsPathSeparator(path[slash - 1])) --slash;
+    return path.substr(slash);
+}
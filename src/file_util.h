@@ -0,0 +1,48 @@
+// nginx-manager/src/file_util.h
+// 文件公共操作 - 各核心模块共用的文件与路径辅助，路径均为 UTF-8（Windows 下转为宽字符 API）
+
+#ifndef FILE_UTIL_H
+#define FILE_UTIL_H
+
+#include "platform.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+FILE* OpenFile(const std::string& path, const char* mode);
+
+// 创建一级目录，已存在也算成功
+bool MakeDirectory(const std::string& path);
+
+bool RemoveFile(const std::string& path);
+
+// 改名，目标已存在时覆盖
+bool RenameFile(const std::string& from, const std::string& to);
+
+// 写入同目录的临时文件后重命名覆盖目标，写入过程中断不会留下半个文件。
+// 目标为符号链接时改写链接指向的文件；已存在的文件保留原有的权限与属主（Windows 上为 ACL 与属性）
+bool WriteFileAtomically(const std::string& path, const std::string& text, std::string* error);
+
+// 普通文件存在时返回 true 并给出大小与距最后修改的秒数（ageSeconds 可为空）
+bool StatFile(const std::string& path, uint64_t* size, int64_t* ageSeconds = nullptr);
+
+// 目录中的普通文件名（不含子目录与 . 开头的名称），顺序不定
+std::vector<std::string> ListDirectory(const std::string& directory);
+
+// 路径分隔符：Linux 上只有 '/'，Windows 上 '/' 与 '\\' 均可
+bool IsPathSeparator(char c);
+
+// 绝对路径：Linux 上以 '/' 开头；Windows 上以分隔符开头或带盘符
+bool IsAbsolutePath(std::string_view path);
+
+std::string JoinPath(const std::string& directory, const std::string& name);
+
+// 所在目录：没有目录部分时为 "."，根目录下的文件为 "/"
+std::string DirectoryOf(const std::string& path);
+
+// 文件名部分
+std::string BaseName(const std::string& path);
+
+#endif // FILE_UTIL_H
@@ -0,0 +1,953 @@
+// nginx-manager/src/health_prober.cpp
+// upstream 健康检查 - 从配置枚举 upstream 的 server，单线程事件循环 (epoll / IOCP) 并发探测，超时由时间轮管理
+
+#include "health_prober.h"
+#include "socket_util.h"
+#include "timer_wheel.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <mswsock.h>
+#else
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+// 时间轮刻度 10ms、1024 槽：一圈约 10 秒，常用的探测间隔与超时都落在一圈之内
+static const uint64_t kTickMicros = 10000;
+static const size_t kWheelSlots = 1024;
+static const uint64_t kRediscoverMicros = 30 * 1000000ull;   // 配置解析失败后重新读取的间隔
+static const size_t kRecvBufferSize = 512;                   // 只需要状态行
+static const size_t kMaxStatusLine = 256;
+
+// ---------------------------------------------------------------------------
+// 配置
+
+const char* UpstreamHealthName(UpstreamHealth health) {
+    switch (health) {
+        case UPSTREAM_UP: return "up";
+        case UPSTREAM_DOWN: return "down";
+        default: return "unknown";
+    }
+}
+
+static bool ParsePort(std::string_view text, uint16_t* port) {
+    if (text.empty() || text.size() > 5) return false;
+    uint32_t value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (uint32_t)(c - '0');
+    }
+    if (value == 0 || value > 65535) return false;
+    *port = (uint16_t)value;
+    return true;
+}
+
+bool ParseUpstreamAddress(std::string_view value, std::string* host, uint16_t* port) {
+    if (value.empty() || value.compare(0, 5, "unix:") == 0) return false;
+    uint16_t parsedPort = 80;
+    std::string_view parsedHost;
+    if (value[0] == '[') {
+        size_t close = value.find(']');
+        if (close == std::string_view::npos || close == 1) return false;
+        parsedHost = value.substr(1, close - 1);
+        std::string_view rest = value.substr(close + 1);
+        if (!rest.empty() && (rest[0] != ':' || !ParsePort(rest.substr(1), &parsedPort))) return false;
+    } else {
+        size_t colon = value.find(':');
+        // 不带方括号的 IPv6 地址在 nginx 中同样无效
+        if (colon != std::string_view::npos && value.find(':', colon + 1) != std::string_view::npos) return false;
+        parsedHost = value.substr(0, colon);
+        if (colon != std::string_view::npos && !ParsePort(value.substr(colon + 1), &parsedPort)) return false;
+    }
+    if (parsedHost.empty()) return false;
+    *host = std::string(parsedHost);
+    *port = parsedPort;
+    return true;
+}
+
+void CollectUpstreamServers(const NginxConfig& config, std::vector<UpstreamServer>* servers,
+                            std::vector<std::pair<std::string, uint32_t>>* skipped) {
+    servers->clear();
+    if (skipped) skipped->clear();
+    for (uint32_t index : config.FindByName("upstream")) {
+        const ConfDirective& upstream = config.At(index);
+        if (!upstream.isBlock || upstream.argCount == 0) continue;
+        std::string name(config.Arg(upstream, 0));
+
+        bool stream = false;
+        for (uint32_t parent = upstream.parent; parent != NginxConfig::kNoDirective; parent = config.At(parent).parent) {
+            if (config.At(parent).name == "stream") stream = true;
+        }
+
+        uint32_t skippedCount = 0;
+        for (uint32_t child = config.FirstChild(index); child != NginxConfig::kNoDirective;
+             child = config.NextSibling(child)) {
+            const ConfDirective& c = config.At(child);
+            if (c.name != "server" || c.argCount == 0) continue;
+            UpstreamServer server;
+            bool down = false;
+            for (uint32_t i = 1; i < c.argCount; ++i) {
+                if (config.Arg(c, i) == "down") down = true;
+                if (config.Arg(c, i) == "backup") server.backup = true;
+            }
+            if (down || !ParseUpstreamAddress(config.Arg(c, 0), &server.host, &server.port)) {
+                ++skippedCount;
+                continue;
+            }
+            server.upstream = name;
+            server.address = std::string(config.Arg(c, 0));
+            server.stream = stream;
+            servers->push_back(server);
+        }
+        if (skipped && skippedCount > 0) skipped->push_back(std::make_pair(name, skippedCount));
+    }
+}
+
+std::string FormatHealthEvent(const HealthEvent& event) {
+    std::string text;
+    if (event.health == UPSTREAM_UP) {
+        text = "✓ upstream " + event.upstreams + " 的 " + event.address + " 已恢复";
+    } else {
+        text = "✗ upstream " + event.upstreams + " 的 " + event.address + " 不可用";
+        if (!event.error.empty()) text += ": " + event.error;
+    }
+    return text;
+}
+
+// ---------------------------------------------------------------------------
+// 探测
+
+static std::string SocketErrorText(int error) {
+#ifdef _WIN32
+    switch (error) {
+        case WSAECONNREFUSED:
+        case ERROR_CONNECTION_REFUSED: return "连接被拒绝";
+        case WSAENETUNREACH:
+        case WSAEHOSTUNREACH:
+        case ERROR_NETWORK_UNREACHABLE:
+        case ERROR_HOST_UNREACHABLE: return "网络不可达";
+        case WSAETIMEDOUT:
+        case ERROR_SEM_TIMEOUT: return "连接超时";
+        case WSAECONNRESET:
+        case WSAECONNABORTED: return "连接被重置";
+        default: return "套接字错误 " + std::to_string(error);
+    }
+#else
+    switch (error) {
+        case ECONNREFUSED: return "连接被拒绝";
+        case ENETUNREACH:
+        case EHOSTUNREACH: return "网络不可达";
+        case ETIMEDOUT: return "连接超时";
+        case ECONNRESET: return "连接被重置";
+        default: return strerror(error);
+    }
+#endif
+}
+
+static int LastSocketError() {
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+// "HTTP/1.1 200 OK" 中的状态码，格式不对时返回 0
+static int StatusCode(std::string_view line) {
+    if (line.compare(0, 5, "HTTP/") != 0) return 0;
+    size_t space = line.find(' ');
+    if (space == std::string_view::npos || space + 4 > line.size()) return 0;
+    int code = 0;
+    for (size_t i = space + 1; i < space + 4; ++i) {
+        if (line[i] < '0' || line[i] > '9') return 0;
+        code = code * 10 + (line[i] - '0');
+    }
+    return code;
+}
+
+// list 为 ", " 分隔的名称列表
+static bool ListContains(std::string_view list, std::string_view name) {
+    while (!list.empty()) {
+        size_t comma = list.find(", ");
+        if (list.substr(0, comma) == name) return true;
+        if (comma == std::string_view::npos) break;
+        list.remove_prefix(comma + 2);
+    }
+    return false;
+}
+
+#ifdef _WIN32
+// 一次探测的重叠操作（ConnectEx，之后复用于 WSARecv）；探测结束时若操作尚未完成，由完成包到达时释放
+struct ProbeOp {
+    OVERLAPPED overlapped;
+    WSABUF buffer;
+    uint32_t target = 0;
+    bool orphaned = false;
+    char data[kRecvBufferSize];
+};
+
+static const ULONG_PTR kWakeKey = 1;
+#else
+static const uint64_t kWakeData = UINT64_MAX;
+#endif
+
+class HealthProber::Loop {
+public:
+    explicit Loop(HealthProber* owner) : m_owner(owner), m_wheel(kTickMicros, kWheelSlots) {}
+    ~Loop() { Close(); }
+
+    bool Open(std::string* error);
+    void Close();
+    // 可在任意线程调用
+    void Wake();
+
+    // 重新枚举 upstream 并安排探测；配置解析失败时保留原有的探测地址并返回 false
+    bool Discover(const std::string& confPath, const HealthCheckOptions& options);
+    void Reconfigure(const HealthCheckOptions& options);
+    // 等待套接字事件或最近的定时器，最迟在 limit 时返回
+    void RunOnce(uint64_t limit);
+
+private:
+    enum Phase { PHASE_IDLE, PHASE_CONNECTING, PHASE_READING };
+
+    struct Target {
+        std::string key;             // host:port，去重依据
+        std::string host;
+        uint16_t port = 0;
+        std::string upstreams;
+        bool httpCapable = false;    // 至少被一个 http {} 中的 upstream 使用
+        bool http = false;
+        std::string request;
+        sockaddr_storage address;
+        int addressLength = 0;       // 0 表示解析失败
+        std::string resolveError;
+
+        Phase phase = PHASE_IDLE;
+        SocketHandle socket = kInvalidSocket;
+        uint32_t seq = 0;
+        uint64_t startedAt = 0;
+        std::string head;            // 已收到的响应开头
+        uint32_t consecutiveFailures = 0;
+        bool dirty = false;
+        TargetResult result;
+#ifdef _WIN32
+        ProbeOp* op = nullptr;
+#endif
+    };
+
+    void Apply(const HealthCheckOptions& options);
+    void ScheduleAll(uint64_t now);
+    void AbortAll();
+    void StartProbe(uint32_t index, uint64_t now);
+    void OnConnected(uint32_t index, int error, uint64_t now);
+    void OnData(uint32_t index, const char* data, size_t size, uint64_t now);
+    void Finish(uint32_t index, bool ok, const std::string& error, uint64_t now);
+    void Release(Target& target);
+    void Wait(int timeoutMs);
+    void Publish();
+
+    HealthProber* m_owner;
+    TimerWheel m_wheel;
+    HealthCheckOptions m_options;
+    std::vector<Target> m_targets;
+    std::vector<uint32_t> m_expired;
+    std::vector<uint32_t> m_dirty;
+    std::vector<HealthEvent> m_events;
+    uint32_t m_inFlight = 0;
+    uint64_t m_probes = 0;
+    uint64_t m_loopMicros = 0;
+#ifdef _WIN32
+    HANDLE m_port = NULL;
+    size_t m_orphans = 0;
+    LPFN_CONNECTEX m_connectEx = nullptr;
+#else
+    int m_poll = -1;
+    int m_wakeFd = -1;
+#endif
+};
+
+bool HealthProber::Loop::Open(std::string* error) {
+    if (!InitSockets()) {
+        *error = "套接字库初始化失败";
+        return false;
+    }
+#ifdef _WIN32
+    m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!m_port) {
+        *error = "无法创建完成端口";
+        return false;
+    }
+    // ConnectEx 是扩展函数，需要通过任意一个 TCP 套接字取得指针
+    SocketHandle s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    GUID guid = WSAID_CONNECTEX;
+    DWORD bytes = 0;
+    if (s == kInvalidSocket || WSAIoctl(s, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid), &m_connectEx,
+                                        sizeof(m_connectEx), &bytes, NULL, NULL) != 0) {
+        m_connectEx = nullptr;
+    }
+    CloseSocket(s);
+    if (!m_connectEx) {
+        *error = "无法取得 ConnectEx";
+        return false;
+    }
+#else
+    m_poll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_poll < 0 || m_wakeFd < 0) {
+        *error = std::string("无法创建 epoll: ") + strerror(errno);
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeData;
+    epoll_ctl(m_poll, EPOLL_CTL_ADD, m_wakeFd, &event);
+#endif
+    return true;
+}
+
+void HealthProber::Loop::Close() {
+    AbortAll();
+#ifdef _WIN32
+    if (m_port) {
+        // 关闭套接字会取消未完成的操作，等完成包到齐后才能释放
+        OVERLAPPED_ENTRY entries[64];
+        uint64_t deadline = MonotonicMicros() + 1000000;
+        while (m_orphans > 0 && MonotonicMicros() < deadline) {
+            ULONG count = 0;
+            if (!GetQueuedCompletionStatusEx(m_port, entries, 64, &count, 100, FALSE)) continue;
+            for (ULONG i = 0; i < count; ++i) {
+                if (!entries[i].lpOverlapped) continue;
+                delete CONTAINING_RECORD(entries[i].lpOverlapped, ProbeOp, overlapped);
+                --m_orphans;
+            }
+        }
+        CloseHandle(m_port);
+        m_port = NULL;
+    }
+#else
+    if (m_wakeFd >= 0) close(m_wakeFd);
+    if (m_poll >= 0) close(m_poll);
+    m_wakeFd = m_poll = -1;
+#endif
+}
+
+void HealthProber::Loop::Wake() {
+#ifdef _WIN32
+    if (m_port) PostQueuedCompletionStatus(m_port, 0, kWakeKey, NULL);
+#else
+    uint64_t one = 1;
+    if (m_wakeFd >= 0 && write(m_wakeFd, &one, sizeof(one)) < 0) {
+        // 计数已满说明唤醒尚未被处理，无需重复
+    }
+#endif
+}
+
+bool HealthProber::Loop::Discover(const std::string& confPath, const HealthCheckOptions& options) {
+    m_options = options;
+    NginxConfig config;
+    std::string error;
+    std::vector<UpstreamServer> servers;
+    std::vector<std::pair<std::string, uint32_t>> skipped;
+    if (options.enabled) {
+        if (!config.Load(confPath, &error)) {
+            std::lock_guard<std::mutex> lock(m_owner->m_mutex);
+            m_owner->m_error = error;
+            return false;
+        }
+        CollectUpstreamServers(config, &servers, &skipped);
+    }
+
+    // 同一地址的健康状态在重新枚举后保留
+    std::unordered_map<std::string, size_t> previous;
+    for (size_t i = 0; i < m_targets.size(); ++i) previous[m_targets[i].key] = i;
+    AbortAll();
+
+    std::vector<Target> targets;
+    std::unordered_map<std::string, uint32_t> byKey;
+    std::vector<UpstreamStatus> upstreams;
+    std::unordered_map<std::string, uint32_t> upstreamIndex;
+    std::vector<ServerEntry> entries;
+    auto upstreamOf = [&](const std::string& name, bool stream) {
+        auto found = upstreamIndex.find(name);
+        if (found != upstreamIndex.end()) return found->second;
+        UpstreamStatus status;
+        status.name = name;
+        status.stream = stream;
+        upstreams.push_back(status);
+        return upstreamIndex[name] = (uint32_t)(upstreams.size() - 1);
+    };
+
+    for (const UpstreamServer& server : servers) {
+        std::string host = server.host.find(':') != std::string::npos ? "[" + server.host + "]" : server.host;
+        std::string key = host + ":" + std::to_string(server.port);
+        auto found = byKey.find(key);
+        uint32_t index;
+        if (found == byKey.end()) {
+            index = (uint32_t)targets.size();
+            byKey[key] = index;
+            targets.emplace_back();
+            Target& target = targets.back();
+            target.key = key;
+            target.host = server.host;
+            target.port = server.port;
+            target.request = "GET " + options.httpPath + " HTTP/1.1\r\nHost: " +
+                             (server.port == 80 ? host : key) +
+                             "\r\nConnection: close\r\nUser-Agent: nginx-manager-health\r\nAccept: */*\r\n\r\n";
+            auto old = previous.find(key);
+            if (old != previous.end()) {
+                target.result = m_targets[old->second].result;
+                target.consecutiveFailures = m_targets[old->second].consecutiveFailures;
+            }
+
+            // 主机名只在发现时解析一次，探测路径上没有阻塞调用
+            addrinfo hints = {};
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_NUMERICSERV;
+            addrinfo* result = NULL;
+            std::string service = std::to_string(server.port);
+            memset(&target.address, 0, sizeof(target.address));
+            if (getaddrinfo(server.host.c_str(), service.c_str(), &hints, &result) == 0 && result &&
+                result->ai_addrlen <= sizeof(target.address)) {
+                memcpy(&target.address, result->ai_addr, result->ai_addrlen);
+                target.addressLength = (int)result->ai_addrlen;
+            } else {
+                target.resolveError = "无法解析地址 " + server.host;
+            }
+            if (result) freeaddrinfo(result);
+        } else {
+            index = found->second;
+        }
+
+        Target& target = targets[index];
+        if (!server.stream) target.httpCapable = true;
+        if (!ListContains(target.upstreams, server.upstream)) {
+            if (!target.upstreams.empty()) target.upstreams += ", ";
+            target.upstreams += server.upstream;
+        }
+
+        ServerEntry entry;
+        entry.upstream = upstreamOf(server.upstream, server.stream);
+        entry.target = index;
+        entry.address = server.address;
+        entry.backup = server.backup;
+        entries.push_back(entry);
+    }
+    for (const auto& pair : skipped) upstreams[upstreamOf(pair.first, false)].skipped = pair.second;
+
+    m_targets.swap(targets);
+    Apply(options);
+
+    std::lock_guard<std::mutex> lock(m_owner->m_mutex);
+    m_owner->m_upstreams.swap(upstreams);
+    m_owner->m_servers.swap(entries);
+    m_owner->m_results.resize(m_targets.size());
+    for (size_t i = 0; i < m_targets.size(); ++i) m_owner->m_results[i] = m_targets[i].result;
+    m_owner->m_inFlight = 0;
+    m_owner->m_error.clear();
+    return true;
+}
+
+void HealthProber::Loop::Reconfigure(const HealthCheckOptions& options) {
+    AbortAll();
+    std::string previousPath = m_options.httpPath;
+    m_options = options;
+    if (options.httpPath != previousPath) {
+        for (Target& target : m_targets) {
+            size_t end = target.request.find(" HTTP/1.1\r\n");
+            target.request = "GET " + options.httpPath + target.request.substr(end);
+        }
+    }
+    Apply(options);
+}
+
+void HealthProber::Loop::Apply(const HealthCheckOptions& options) {
+    for (Target& target : m_targets) target.http = target.httpCapable && !options.httpPath.empty();
+    ScheduleAll(MonotonicMicros());
+}
+
+void HealthProber::Loop::ScheduleAll(uint64_t now) {
+    m_wheel.Reset(m_targets.size(), now);
+    if (!m_options.enabled || m_targets.empty()) return;
+    // 首轮探测在一个间隔内均匀错开，之后各自按间隔重复，避免所有连接同时发出
+    uint64_t interval = (uint64_t)std::max<uint32_t>(m_options.intervalMs, 1) * 1000;
+    for (size_t i = 0; i < m_targets.size(); ++i) {
+        m_wheel.Schedule((uint32_t)i, now + interval * i / m_targets.size());
+    }
+}
+
+void HealthProber::Loop::AbortAll() {
+    for (Target& target : m_targets) Release(target);
+    m_inFlight = 0;
+}
+
+void HealthProber::Loop::Release(Target& target) {
+    if (target.phase == PHASE_IDLE) return;
+#ifdef _WIN32
+    if (target.op) {
+        // 未完成的 ConnectEx / WSARecv 在套接字关闭后以失败完成，届时释放
+        target.op->orphaned = true;
+        ++m_orphans;
+        target.op = nullptr;
+    }
+#else
+    epoll_ctl(m_poll, EPOLL_CTL_DEL, target.socket, NULL);
+#endif
+    CloseSocket(target.socket);
+    target.socket = kInvalidSocket;
+    target.phase = PHASE_IDLE;
+    target.head.clear();
+    --m_inFlight;
+}
+
+void HealthProber::Loop::StartProbe(uint32_t index, uint64_t now) {
+    Target& target = m_targets[index];
+    if (m_inFlight >= std::max<uint32_t>(m_options.maxInFlight, 1)) {
+        // 同时进行的探测已达上限，推迟一个刻度
+        m_wheel.Schedule(index, now + kTickMicros);
+        return;
+    }
+    target.startedAt = now;
+    if (target.addressLength == 0) {
+        Finish(index, false, target.resolveError, now);
+        return;
+    }
+
+    const sockaddr* address = (const sockaddr*)&target.address;
+    SocketHandle s = socket(address->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalidSocket || !SetNonBlocking(s)) {
+        std::string error = SocketErrorText(LastSocketError());
+        CloseSocket(s);
+        Finish(index, false, error, now);
+        return;
+    }
+    target.socket = s;
+    target.phase = PHASE_CONNECTING;
+    target.seq++;
+    ++m_inFlight;
+    m_wheel.Schedule(index, now + (uint64_t)m_options.timeoutMs * 1000);
+
+#ifdef _WIN32
+    // ConnectEx 要求套接字已绑定
+    sockaddr_storage local = {};
+    local.ss_family = address->sa_family;
+    int localLength = address->sa_family == AF_INET6 ? (int)sizeof(sockaddr_in6) : (int)sizeof(sockaddr_in);
+    if (bind(s, (const sockaddr*)&local, localLength) != 0 ||
+        CreateIoCompletionPort((HANDLE)s, m_port, 0, 0) != m_port) {
+        Finish(index, false, SocketErrorText(LastSocketError()), now);
+        return;
+    }
+    ProbeOp* op = new ProbeOp();
+    op->target = index;
+    target.op = op;
+    if (!m_connectEx(s, address, target.addressLength, NULL, 0, NULL, &op->overlapped) &&
+        WSAGetLastError() != ERROR_IO_PENDING) {
+        target.op = nullptr;
+        delete op;
+        Finish(index, false, SocketErrorText(LastSocketError()), now);
+    }
+#else
+    if (connect(s, address, (socklen_t)target.addressLength) == 0) {
+        OnConnected(index, 0, now);
+        return;
+    }
+    if (!SocketWouldBlock()) {
+        Finish(index, false, SocketErrorText(LastSocketError()), now);
+        return;
+    }
+    epoll_event event = {};
+    event.events = EPOLLOUT;
+    event.data.u64 = (uint64_t)index | ((uint64_t)target.seq << 32);
+    if (epoll_ctl(m_poll, EPOLL_CTL_ADD, s, &event) != 0) {
+        Finish(index, false, std::string("epoll_ctl: ") + strerror(errno), now);
+    }
+#endif
+}
+
+void HealthProber::Loop::OnConnected(uint32_t index, int error, uint64_t now) {
+    Target& target = m_targets[index];
+    if (error != 0) {
+        Finish(index, false, SocketErrorText(error), now);
+        return;
+    }
+    if (!target.http) {
+        Finish(index, true, std::string(), now);
+        return;
+    }
+
+    // 请求只有几十字节，刚建立的连接发送缓冲总能一次放下
+#ifdef _WIN32
+    int sent = send(target.socket, target.request.data(), (int)target.request.size(), 0);
+#else
+    int sent = (int)send(target.socket, target.request.data(), target.request.size(), MSG_NOSIGNAL);
+#endif
+    if (sent != (int)target.request.size()) {
+        Finish(index, false, sent < 0 ? SocketErrorText(LastSocketError()) : "请求未能一次发出", now);
+        return;
+    }
+    target.phase = PHASE_READING;
+
+#ifdef _WIN32
+    ProbeOp* op = new ProbeOp();
+    op->target = index;
+    op->buffer.buf = op->data;
+    op->buffer.len = (ULONG)sizeof(op->data);
+    target.op = op;
+    DWORD flags = 0;
+    if (WSARecv(target.socket, &op->buffer, 1, NULL, &flags, &op->overlapped, NULL) == SOCKET_ERROR &&
+        WSAGetLastError() != WSA_IO_PENDING) {
+        target.op = nullptr;
+        delete op;
+        Finish(index, false, SocketErrorText(LastSocketError()), now);
+    }
+#else
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = (uint64_t)index | ((uint64_t)target.seq << 32);
+    if (epoll_ctl(m_poll, EPOLL_CTL_MOD, target.socket, &event) != 0) {
+        // connect 立即成功时套接字尚未注册
+        if (errno != ENOENT || epoll_ctl(m_poll, EPOLL_CTL_ADD, target.socket, &event) != 0) {
+            Finish(index, false, std::string("epoll_ctl: ") + strerror(errno), now);
+        }
+    }
+#endif
+}
+
+void HealthProber::Loop::OnData(uint32_t index, const char* data, size_t size, uint64_t now) {
+    Target& target = m_targets[index];
+    if (size == 0) {
+        Finish(index, false, "连接被关闭（未收到响应）", now);
+        return;
+    }
+    target.head.append(data, std::min(size, kMaxStatusLine - std::min(target.head.size(), kMaxStatusLine)));
+    size_t end = target.head.find('\n');
+    if (end == std::string::npos) {
+        if (target.head.size() >= kMaxStatusLine) Finish(index, false, "响应格式错误", now);
+        return;
+    }
+    int code = StatusCode(std::string_view(target.head).substr(0, end));
+    if (code == 0) {
+        Finish(index, false, "响应格式错误", now);
+    } else if (code >= 200 && code < 400) {
+        Finish(index, true, std::string(), now);
+    } else {
+        Finish(index, false, "HTTP " + std::to_string(code), now);
+    }
+}
+
+void HealthProber::Loop::Finish(uint32_t index, bool ok, const std::string& error, uint64_t now) {
+    Target& target = m_targets[index];
+    Release(target);
+    ++m_probes;
+
+    TargetResult& result = target.result;
+    UpstreamHealth before = result.health;
+    result.checks++;
+    if (ok) {
+        target.consecutiveFailures = 0;
+        result.health = UPSTREAM_UP;
+        result.latencyMicros = now - target.startedAt;
+        result.error.clear();
+    } else {
+        target.consecutiveFailures++;
+        result.failures++;
+        result.error = error;
+        if (target.consecutiveFailures >= std::max<uint32_t>(m_options.failThreshold, 1)) result.health = UPSTREAM_DOWN;
+    }
+    if (!target.dirty) {
+        target.dirty = true;
+        m_dirty.push_back(index);
+    }
+    // 新地址首次探测成功不算状态变化
+    if (result.health != before && !(before == UPSTREAM_UNKNOWN && result.health == UPSTREAM_UP)) {
+        HealthEvent event;
+        event.upstreams = target.upstreams;
+        event.address = target.key;
+        event.health = result.health;
+        event.error = result.error;
+        m_events.push_back(event);
+    }
+
+    // 按开始时刻计间隔，探测耗时不会让周期越拉越长
+    uint64_t next = target.startedAt + (uint64_t)std::max<uint32_t>(m_options.intervalMs, 1) * 1000;
+    m_wheel.Schedule(index, next > now ? next : now);
+}
+
+void HealthProber::Loop::Wait(int timeoutMs) {
+#ifdef _WIN32
+    OVERLAPPED_ENTRY entries[64];
+    ULONG count = 0;
+    if (!GetQueuedCompletionStatusEx(m_port, entries, 64, &count, timeoutMs < 0 ? INFINITE : (DWORD)timeoutMs, FALSE)) {
+        return;
+    }
+    uint64_t now = MonotonicMicros();
+    for (ULONG i = 0; i < count; ++i) {
+        if (!entries[i].lpOverlapped) continue;   // Wake
+        ProbeOp* op = CONTAINING_RECORD(entries[i].lpOverlapped, ProbeOp, overlapped);
+        if (op->orphaned) {
+            delete op;
+            --m_orphans;
+            continue;
+        }
+        uint32_t index = op->target;
+        Target& target = m_targets[index];
+        target.op = nullptr;
+        int error = 0;
+        DWORD bytes = 0, flags = 0;
+        if (!WSAGetOverlappedResult(target.socket, &op->overlapped, &bytes, FALSE, &flags)) error = WSAGetLastError();
+        if (target.phase == PHASE_CONNECTING) {
+            if (error == 0) setsockopt(target.socket, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, NULL, 0);
+            delete op;
+            OnConnected(index, error, now);
+        } else if (error != 0) {
+            delete op;
+            Finish(index, false, SocketErrorText(error), now);
+        } else {
+            OnData(index, op->data, bytes, now);
+            if (m_targets[index].phase == PHASE_READING) {
+                // 状态行还没收全，继续接收
+                memset(&op->overlapped, 0, sizeof(op->overlapped));
+                target.op = op;
+                flags = 0;
+                if (WSARecv(target.socket, &op->buffer, 1, NULL, &flags, &op->overlapped, NULL) == SOCKET_ERROR &&
+                    WSAGetLastError() != WSA_IO_PENDING) {
+                    target.op = nullptr;
+                    delete op;
+                    Finish(index, false, SocketErrorText(LastSocketError()), now);
+                }
+            } else {
+                delete op;
+            }
+        }
+    }
+#else
+    epoll_event events[128];
+    int count = epoll_wait(m_poll, events, 128, timeoutMs);
+    uint64_t now = MonotonicMicros();
+    char buffer[kRecvBufferSize];
+    for (int i = 0; i < count; ++i) {
+        if (events[i].data.u64 == kWakeData) {
+            uint64_t value;
+            while (read(m_wakeFd, &value, sizeof(value)) > 0) {}
+            continue;
+        }
+        uint32_t index = (uint32_t)events[i].data.u64;
+        uint32_t seq = (uint32_t)(events[i].data.u64 >> 32);
+        // 同一批事件中探测可能已结束（重新枚举、超时），序号不符的事件属于已关闭的套接字
+        if (index >= m_targets.size() || m_targets[index].seq != seq) continue;
+        Target& target = m_targets[index];
+        if (target.phase == PHASE_CONNECTING) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(target.socket, SOL_SOCKET, SO_ERROR, &error, &length);
+            OnConnected(index, error, now);
+        } else if (target.phase == PHASE_READING) {
+            ssize_t n = recv(target.socket, buffer, sizeof(buffer), 0);
+            if (n >= 0) {
+                OnData(index, buffer, (size_t)n, now);
+            } else if (!SocketWouldBlock() && errno != EINTR) {
+                Finish(index, false, SocketErrorText(errno), now);
+            }
+        }
+    }
+#endif
+}
+
+void HealthProber::Loop::RunOnce(uint64_t limit) {
+    uint64_t now = MonotonicMicros();
+    uint64_t wake = std::min(m_wheel.NextWake(), limit);
+    int timeoutMs = -1;
+    if (wake != UINT64_MAX) timeoutMs = wake <= now ? 0 : (int)std::min<uint64_t>((wake - now + 999) / 1000, 60000);
+    Wait(timeoutMs);
+
+    uint64_t begin = MonotonicMicros();
+    m_expired.clear();
+    m_wheel.Advance(begin, &m_expired);
+    for (uint32_t index : m_expired) {
+        Target& target = m_targets[index];
+        if (target.phase == PHASE_CONNECTING) {
+            Finish(index, false, "连接超时", begin);
+        } else if (target.phase == PHASE_READING) {
+            Finish(index, false, "响应超时", begin);
+        } else {
+            StartProbe(index, begin);
+        }
+    }
+    Publish();
+    m_loopMicros += MonotonicMicros() - begin;
+}
+
+void HealthProber::Loop::Publish() {
+    {
+        std::lock_guard<std::mutex> lock(m_owner->m_mutex);
+        for (uint32_t index : m_dirty) {
+            m_targets[index].dirty = false;
+            if (index < m_owner->m_results.size()) m_owner->m_results[index] = m_targets[index].result;
+        }
+        m_owner->m_inFlight = m_inFlight;
+        m_owner->m_probes = m_probes;
+        m_owner->m_loopMicros = m_loopMicros;
+    }
+    m_dirty.clear();
+    if (m_owner->m_handler) {
+        for (const HealthEvent& event : m_events) m_owner->m_handler(event);
+    }
+    m_events.clear();
+}
+
+// ---------------------------------------------------------------------------
+// HealthProber
+
+HealthProber::~HealthProber() {
+    Stop();
+}
+
+void HealthProber::SetOptions(const HealthCheckOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_options = options;
+        m_reconfigure = true;
+    }
+    Wake();
+}
+
+HealthCheckOptions HealthProber::Options() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_options;
+}
+
+void HealthProber::Start(const std::string& confPath) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_worker.joinable() && confPath == m_confPath) return;
+    }
+    Stop();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_upstreams.clear();
+    m_servers.clear();
+    m_results.clear();
+    m_inFlight = 0;
+    m_probes = 0;
+    m_loopMicros = 0;
+    m_error.clear();
+    m_stopping = false;
+    m_rediscover = false;
+    m_reconfigure = false;
+    m_confPath = confPath;
+    m_worker = std::thread(&HealthProber::Run, this, confPath);
+}
+
+void HealthProber::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    Wake();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+void HealthProber::Rediscover() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rediscover = true;
+    }
+    Wake();
+}
+
+void HealthProber::Wake() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_loop) m_loop->Wake();
+}
+
+HealthSnapshot HealthProber::Snapshot() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    HealthSnapshot snapshot;
+    snapshot.running = m_loop != nullptr && m_options.enabled;
+    snapshot.upstreams = m_upstreams;
+    for (const ServerEntry& entry : m_servers) {
+        const TargetResult& result = m_results[entry.target];
+        UpstreamStatus& upstream = snapshot.upstreams[entry.upstream];
+        UpstreamServerStatus server;
+        server.address = entry.address;
+        server.backup = entry.backup;
+        server.health = result.health;
+        server.latencyMicros = result.latencyMicros;
+        server.checks = result.checks;
+        server.failures = result.failures;
+        server.error = result.error;
+        upstream.servers.push_back(server);
+        if (result.health == UPSTREAM_UP) {
+            upstream.up++;
+        } else if (result.health == UPSTREAM_DOWN) {
+            upstream.down++;
+        } else {
+            upstream.unknown++;
+        }
+    }
+    snapshot.targets = (uint32_t)m_results.size();
+    for (const TargetResult& result : m_results) {
+        if (result.health == UPSTREAM_UP) {
+            snapshot.up++;
+        } else if (result.health == UPSTREAM_DOWN) {
+            snapshot.down++;
+        } else {
+            snapshot.unknown++;
+        }
+    }
+    snapshot.inFlight = m_inFlight;
+    snapshot.probes = m_probes;
+    snapshot.loopMicros = m_loopMicros;
+    snapshot.error = m_error;
+    return snapshot;
+}
+
+void HealthProber::Run(std::string confPath) {
+    TraceSetThreadName("health-prober");
+    Loop loop(this);
+    std::string error;
+    if (!loop.Open(&error)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_error = error;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loop = &loop;
+    }
+
+    bool discover = true;
+    uint64_t nextDiscovery = UINT64_MAX;
+    while (true) {
+        bool reconfigure;
+        HealthCheckOptions options;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) break;
+            discover = discover || m_rediscover;
+            reconfigure = m_reconfigure;
+            m_rediscover = m_reconfigure = false;
+            options = m_options;
+        }
+
+        if (discover || MonotonicMicros() >= nextDiscovery) {
+            // 配置解析失败（编辑中途）时保留原有的探测地址，稍后重试
+            nextDiscovery = loop.Discover(confPath, options) ? UINT64_MAX : MonotonicMicros() + kRediscoverMicros;
+            discover = false;
+        } else if (reconfigure) {
+            loop.Reconfigure(options);
+        }
+        loop.RunOnce(nextDiscovery);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_loop = nullptr;
+}
@@ -0,0 +1,168 @@
+// nginx-manager/src/health_prober.h
+// upstream 健康检查 - 从配置枚举 upstream 的 server，单线程事件循环 (epoll / IOCP) 并发探测，超时由时间轮管理
+
+#ifndef HEALTH_PROBER_H
+#define HEALTH_PROBER_H
+
+#include "nginx_conf.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct HealthCheckOptions {
+    bool enabled = true;
+    uint32_t intervalMs = 5000;      // 每个 server 的探测间隔，各 server 的探测均匀错开
+    uint32_t timeoutMs = 2000;       // 单次探测（连接 + HTTP 状态行）的超时
+    std::string httpPath;            // 非空时连接后请求该路径，2xx / 3xx 为健康；stream 中的 upstream 只检查连接
+    uint32_t failThreshold = 2;      // 连续失败这么多次才判为不可用，一次成功即恢复
+    uint32_t maxInFlight = 512;      // 同时进行的探测上限（每个占用一个套接字）
+};
+
+enum UpstreamHealth {
+    UPSTREAM_UNKNOWN,                // 尚未完成探测，或失败次数未达到阈值的新 server
+    UPSTREAM_UP,
+    UPSTREAM_DOWN
+};
+
+const char* UpstreamHealthName(UpstreamHealth health);
+
+// 配置中 upstream 块里的一条 server
+struct UpstreamServer {
+    std::string upstream;            // upstream 名
+    std::string address;             // 配置中的写法，如 "10.0.0.5:8080"、"backend.local"
+    std::string host;                // 解析出的主机名 / IP（IPv6 不带方括号）
+    uint16_t port = 80;
+    bool backup = false;
+    bool stream = false;             // 位于 stream {} 中（只做 TCP 检查）
+};
+
+// 解析 upstream server 的地址参数：host[:port]、[ipv6][:port]，省略端口时为 80；unix: 套接字返回 false
+bool ParseUpstreamAddress(std::string_view value, std::string* host, uint16_t* port);
+
+// 收集配置（含 include）中所有 upstream 的 server；unix: 套接字、带 down 参数的 server 与无法解析的地址
+// 不返回，只计入 skipped（按 upstream 名统计，可为 nullptr）
+void CollectUpstreamServers(const NginxConfig& config, std::vector<UpstreamServer>* servers,
+                            std::vector<std::pair<std::string, uint32_t>>* skipped);
+
+struct UpstreamServerStatus {
+    std::string address;
+    bool backup = false;
+    UpstreamHealth health = UPSTREAM_UNKNOWN;
+    uint64_t latencyMicros = 0;      // 最近一次成功探测的耗时（连接，或连接 + HTTP 状态行）
+    uint64_t checks = 0;
+    uint64_t failures = 0;
+    std::string error;               // 最近一次失败的原因，成功后清空
+};
+
+struct UpstreamStatus {
+    std::string name;
+    bool stream = false;
+    uint32_t up = 0;
+    uint32_t down = 0;
+    uint32_t unknown = 0;
+    uint32_t skipped = 0;            // 未探测的 server（unix: 套接字、标记为 down）
+    std::vector<UpstreamServerStatus> servers;
+};
+
+struct HealthSnapshot {
+    bool running = false;            // 探测线程在运行且已启用
+    std::vector<UpstreamStatus> upstreams;
+    uint32_t targets = 0;            // 去重后的探测地址数（同一地址被多个 upstream 使用时只探测一次）
+    uint32_t up = 0;
+    uint32_t down = 0;
+    uint32_t unknown = 0;
+    uint32_t inFlight = 0;
+    uint64_t probes = 0;             // 累计完成的探测次数
+    uint64_t loopMicros = 0;         // 事件循环累计的处理时间（不含等待），用于估算探测开销
+    std::string error;               // 配置解析失败的原因
+};
+
+// 一个地址的健康状态发生变化（新地址首次探测成功不算）
+struct HealthEvent {
+    std::string upstreams;           // 使用该地址的 upstream，多个时以 ", " 分隔
+    std::string address;
+    UpstreamHealth health = UPSTREAM_UNKNOWN;
+    std::string error;
+};
+
+// 一行说明（UTF-8），恢复带 ✓、不可用带 ✗ 前缀
+std::string FormatHealthEvent(const HealthEvent& event);
+
+// upstream 健康检查
+// 单个后台线程按配置枚举 upstream 的 server（同一地址去重、主机名在发现时解析一次），
+// 以非阻塞连接并发探测全部地址：Linux 上是 epoll，Windows 上是 ConnectEx + 完成端口。
+// 每个地址的"下一次探测"与"本次超时"共用时间轮中的一个定时器，设置 / 取消均为 O(1)，
+// 线程只在有套接字事件或最近的定时器到期时醒来，探测几千个地址也只占用这一个线程。
+// 重新加载后调用 Rediscover，同一地址的状态会保留。事件在探测线程中回调，回调中不要调用会阻塞的操作。
+class HealthProber {
+public:
+    typedef std::function<void(const HealthEvent& event)> EventHandler;
+
+    HealthProber() {}
+    ~HealthProber();
+
+    HealthProber(const HealthProber&) = delete;
+    HealthProber& operator=(const HealthProber&) = delete;
+
+    // 在 Start 之前调用
+    void SetHandler(EventHandler handler) { m_handler = handler; }
+    // 随时可调用，生效时重新安排所有探测（保留已有的健康状态）
+    void SetOptions(const HealthCheckOptions& options);
+    HealthCheckOptions Options() const;
+
+    // 探测 confPath 配置中的 upstream，路径未变时为空操作
+    void Start(const std::string& confPath);
+    void Stop();
+    // 配置可能已变化（重新加载后调用），重新枚举 upstream
+    void Rediscover();
+
+    HealthSnapshot Snapshot() const;
+
+private:
+    class Loop;                      // 事件循环，只在探测线程中存在
+
+    // 一个探测地址最近的结果
+    struct TargetResult {
+        UpstreamHealth health = UPSTREAM_UNKNOWN;
+        uint64_t latencyMicros = 0;
+        uint64_t checks = 0;
+        uint64_t failures = 0;
+        std::string error;
+    };
+
+    // 快照中的一条 server：所属 upstream（m_upstreams 下标）与探测地址（m_results 下标）
+    struct ServerEntry {
+        uint32_t upstream = 0;
+        uint32_t target = 0;
+        std::string address;
+        bool backup = false;
+    };
+
+    void Run(std::string confPath);
+    void Wake();
+
+    std::thread m_worker;
+    mutable std::mutex m_mutex;
+    std::string m_confPath;
+    HealthCheckOptions m_options;
+    bool m_stopping = false;
+    bool m_rediscover = false;
+    bool m_reconfigure = false;
+    Loop* m_loop = nullptr;          // 探测线程运行期间有效，Wake 通过它唤醒等待
+    EventHandler m_handler;
+
+    // 以下由探测线程发布，Snapshot 据此组装
+    std::vector<UpstreamStatus> m_upstreams;     // 只有名称、类型与 skipped
+    std::vector<ServerEntry> m_servers;
+    std::vector<TargetResult> m_results;
+    uint32_t m_inFlight = 0;
+    uint64_t m_probes = 0;
+    uint64_t m_loopMicros = 0;
+    std::string m_error;
+};
+
+#endif // HEALTH_PROBER_H
@@ -0,0 +1,260 @@
+// nginx-manager/src/http_client.cpp
+// 最小 HTTP/1.1 客户端 - 保持长连接的 GET 请求，用于轮询 nginx 的状态页
+
+#include "http_client.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <errno.h>
+#endif
+
+#ifdef MSG_NOSIGNAL
+static const int kSendFlags = MSG_NOSIGNAL;  // 对端已关闭时返回 EPIPE，而不是触发 SIGPIPE
+#else
+static const int kSendFlags = 0;
+#endif
+
+static const size_t kMaxHeaderBytes = 16 * 1024;
+static const size_t kMaxBodyBytes = 4 * 1024 * 1024;
+
+bool EqualsIgnoreCase(const char* a, size_t length, const char* b) {
+    if (strlen(b) != length) return false;
+    for (size_t i = 0; i < length; ++i) {
+        char c = a[i];
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (c != b[i]) return false;
+    }
+    return true;
+}
+
+bool ContainsIgnoreCase(std::string_view text, const char* token) {
+    size_t length = strlen(token);
+    for (size_t i = 0; i + length <= text.size(); ++i) {
+        if (EqualsIgnoreCase(text.data() + i, length, token)) return true;
+    }
+    return false;
+}
+
+HttpClient::~HttpClient() {
+    Close();
+}
+
+void HttpClient::SetTarget(const std::string& host, uint16_t port, const std::string& hostHeader) {
+    std::string header = hostHeader.empty() ? host : hostHeader;
+    if (port != 80) header += ":" + std::to_string(port);
+    if (host == m_host && port == m_port && header == m_hostHeader) return;
+    Close();
+    m_host = host;
+    m_port = port;
+    m_hostHeader = header;
+}
+
+void HttpClient::Close() {
+    CloseSocket(m_socket);
+    m_socket = kInvalidSocket;
+    m_buffer.clear();
+    m_peerClosed = false;
+}
+
+bool HttpClient::Get(const std::string& path, uint32_t timeoutMs, HttpResponse* response, std::string* error) {
+    m_request.clear();
+    m_request += "GET ";
+    m_request += path;
+    m_request += " HTTP/1.1\r\nHost: ";
+    m_request += m_hostHeader;
+    m_request += "\r\nUser-Agent: nginx-manager\r\nAccept: */*\r\nConnection: keep-alive\r\n\r\n";
+
+    uint64_t deadline = MonotonicMicros() + (uint64_t)timeoutMs * 1000;
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool reused = IsConnected();
+        if (!reused) {
+            m_socket = ConnectTcp(m_host, m_port, timeoutMs, error);
+            if (m_socket == kInvalidSocket) return false;
+            ++m_connections;
+        }
+
+        bool nothingReceived = false;
+        if (Exchange(deadline, response, error, &nothingReceived)) {
+            if (!response->keepAlive) Close();
+            return true;
+        }
+        Close();
+        // 只有复用的连接在收到任何响应前就断开（服务端 keepalive_timeout 到期）才重试
+        if (!reused || !nothingReceived) return false;
+    }
+    return false;
+}
+
+bool HttpClient::FillBuffer(uint64_t deadline, std::string* error) {
+    char chunk[16 * 1024];
+    for (;;) {
+        uint64_t now = MonotonicMicros();
+        if (now >= deadline) {
+            if (error) *error = "请求超时";
+            return false;
+        }
+        int ready = WaitSocket(m_socket, false, (uint32_t)((deadline - now + 999) / 1000));
+        if (ready == 0) continue;
+        if (ready < 0) {
+            if (error) *error = "连接出错";
+            return false;
+        }
+
+        int n = recv(m_socket, chunk, (int)sizeof(chunk), 0);
+        if (n > 0) {
+            m_buffer.append(chunk, (size_t)n);
+            return true;
+        }
+        if (n == 0) {
+            m_peerClosed = true;
+            if (error) *error = "连接已被服务端关闭";
+            return false;
+        }
+        if (!SocketWouldBlock()) {
+            if (error) *error = "接收失败";
+            return false;
+        }
+    }
+}
+
+bool HttpClient::Exchange(uint64_t deadline, HttpResponse* response, std::string* error, bool* nothingReceived) {
+    *nothingReceived = true;
+    response->status = 0;
+    response->keepAlive = true;
+    response->body.clear();
+
+    size_t sent = 0;
+    while (sent < m_request.size()) {
+        int n = send(m_socket, m_request.data() + sent, (int)(m_request.size() - sent), kSendFlags);
+        if (n > 0) {
+            sent += (size_t)n;
+            continue;
+        }
+        uint64_t now = MonotonicMicros();
+        if (n < 0 && SocketWouldBlock() && now < deadline &&
+            WaitSocket(m_socket, true, (uint32_t)((deadline - now + 999) / 1000)) > 0) {
+            continue;
+        }
+        if (error) *error = "发送失败";
+        return false;
+    }
+
+    size_t headerEnd;
+    while ((headerEnd = m_buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (m_buffer.size() > kMaxHeaderBytes) {
+            if (error) *error = "响应头过大";
+            return false;
+        }
+        if (!FillBuffer(deadline, error)) return false;
+        *nothingReceived = false;
+    }
+    *nothingReceived = false;
+    return ReadBody(deadline, headerEnd, response, error);
+}
+
+bool HttpClient::ReadBody(uint64_t deadline, size_t headerEnd, HttpResponse* response, std::string* error) {
+    // 状态行：HTTP/1.x 200 OK
+    if (m_buffer.compare(0, 7, "HTTP/1.") != 0 || headerEnd < 12) {
+        if (error) *error = "无效的响应";
+        return false;
+    }
+    bool http10 = m_buffer[7] == '0';
+    response->status = atoi(m_buffer.c_str() + 9);
+    response->keepAlive = !http10;
+
+    bool chunked = false;
+    bool hasLength = false;
+    size_t contentLength = 0;
+    size_t lineStart = m_buffer.find("\r\n") + 2;
+    while (lineStart < headerEnd) {
+        size_t lineEnd = m_buffer.find("\r\n", lineStart);
+        size_t colon = m_buffer.find(':', lineStart);
+        if (colon != std::string::npos && colon < lineEnd) {
+            size_t valueStart = colon + 1;
+            while (valueStart < lineEnd && (m_buffer[valueStart] == ' ' || m_buffer[valueStart] == '\t')) ++valueStart;
+            std::string value = m_buffer.substr(valueStart, lineEnd - valueStart);
+            const char* name = m_buffer.data() + lineStart;
+            size_t nameLength = colon - lineStart;
+            if (EqualsIgnoreCase(name, nameLength, "content-length")) {
+                hasLength = true;
+                contentLength = (size_t)strtoull(value.c_str(), nullptr, 10);
+            } else if (EqualsIgnoreCase(name, nameLength, "transfer-encoding")) {
+                chunked = ContainsIgnoreCase(value, "chunked");
+            } else if (EqualsIgnoreCase(name, nameLength, "connection")) {
+                if (ContainsIgnoreCase(value, "close")) response->keepAlive = false;
+                else if (ContainsIgnoreCase(value, "keep-alive")) response->keepAlive = true;
+            }
+        }
+        lineStart = lineEnd + 2;
+    }
+
+    size_t position = headerEnd + 4;
+    bool noBody = (response->status >= 100 && response->status < 200) || response->status == 204 ||
+                  response->status == 304;
+    if (noBody) {
+        m_buffer.erase(0, position);
+        return true;
+    }
+
+    if (chunked) {
+        for (;;) {
+            size_t lineEnd;
+            while ((lineEnd = m_buffer.find("\r\n", position)) == std::string::npos) {
+                if (!FillBuffer(deadline, error)) return false;
+            }
+            size_t size = (size_t)strtoull(m_buffer.c_str() + position, nullptr, 16);
+            position = lineEnd + 2;
+            if (size == 0) {
+                // 末尾的 trailer 以空行结束
+                for (;;) {
+                    while ((lineEnd = m_buffer.find("\r\n", position)) == std::string::npos) {
+                        if (!FillBuffer(deadline, error)) return false;
+                    }
+                    bool empty = lineEnd == position;
+                    position = lineEnd + 2;
+                    if (empty) break;
+                }
+                break;
+            }
+            if (response->body.size() + size > kMaxBodyBytes) {
+                if (error) *error = "响应体过大";
+                return false;
+            }
+            while (m_buffer.size() < position + size + 2) {
+                if (!FillBuffer(deadline, error)) return false;
+            }
+            response->body.append(m_buffer, position, size);
+            position += size + 2;
+        }
+        m_buffer.erase(0, position);
+        return true;
+    }
+
+    if (hasLength) {
+        if (contentLength > kMaxBodyBytes) {
+            if (error) *error = "响应体过大";
+            return false;
+        }
+        while (m_buffer.size() < position + contentLength) {
+            if (!FillBuffer(deadline, error)) return false;
+        }
+        response->body.assign(m_buffer, position, contentLength);
+        m_buffer.erase(0, position + contentLength);
+        return true;
+    }
+
+    // 既无长度也非 chunked：读到连接关闭为止，之后不能复用
+    response->keepAlive = false;
+    while (!m_peerClosed) {
+        if (m_buffer.size() - position > kMaxBodyBytes) {
+            if (error) *error = "响应体过大";
+            return false;
+        }
+        if (!FillBuffer(deadline, error) && !m_peerClosed) return false;
+    }
+    response->body.assign(m_buffer, position, std::string::npos);
+    m_buffer.clear();
+    return true;
+}
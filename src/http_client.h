@@ -0,0 +1,61 @@
+// nginx-manager/src/http_client.h
+// 最小 HTTP/1.1 客户端 - 保持长连接的 GET 请求，用于轮询 nginx 的状态页
+
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include "socket_util.h"
+#include <string>
+#include <string_view>
+
+struct HttpResponse {
+    int status = 0;
+    bool keepAlive = true;           // 服务端是否允许复用连接
+    std::string body;
+};
+
+// 不区分大小写地比较 a[0, length) 与 b（b 须为小写），用于匹配头部名称
+bool EqualsIgnoreCase(const char* a, size_t length, const char* b);
+
+// text 中是否含有 token（token 须为小写，不区分大小写），用于匹配头部取值
+bool ContainsIgnoreCase(std::string_view text, const char* token);
+
+// 单连接 HTTP/1.1 客户端
+// 连接在多次请求间复用；复用的连接已被服务端关闭时自动重连一次。
+// 只支持 Content-Length、chunked 与 "读到连接关闭" 三种响应体格式。非线程安全。
+class HttpClient {
+public:
+    HttpClient() {}
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    // 设置目标地址，hostHeader 为空时使用 host；目标变化时断开现有连接
+    void SetTarget(const std::string& host, uint16_t port, const std::string& hostHeader);
+
+    // 发送 GET 请求并读取完整响应，timeoutMs 为整个请求的时限
+    bool Get(const std::string& path, uint32_t timeoutMs, HttpResponse* response, std::string* error);
+
+    void Close();
+    bool IsConnected() const { return m_socket != kInvalidSocket; }
+
+    // 累计建立的连接数，用于确认长连接确实被复用
+    uint64_t Connections() const { return m_connections; }
+
+private:
+    bool Exchange(uint64_t deadline, HttpResponse* response, std::string* error, bool* nothingReceived);
+    bool FillBuffer(uint64_t deadline, std::string* error);
+    bool ReadBody(uint64_t deadline, size_t headerEnd, HttpResponse* response, std::string* error);
+
+    SocketHandle m_socket = kInvalidSocket;
+    std::string m_host;
+    uint16_t m_port = 0;
+    std::string m_hostHeader;
+    std::string m_request;
+    std::string m_buffer;            // 已接收但尚未解析的数据
+    bool m_peerClosed = false;
+    uint64_t m_connections = 0;
+};
+
+#endif // HTTP_CLIENT_H
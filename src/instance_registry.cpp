@@ -0,0 +1,219 @@
+// nginx-manager/src/instance_registry.cpp
+// 多实例登记表 - 按安装前缀区分同一主机上的多个 nginx，一次扫描更新所有实例的状态
+
+#include "instance_registry.h"
+
+const char* InstanceStateName(InstanceState state) {
+    switch (state) {
+        case INSTANCE_STOPPED: return "stopped";
+        case INSTANCE_RUNNING: return "running";
+        case INSTANCE_NO_WORKERS: return "no-workers";
+        default: return "unknown";
+    }
+}
+
+InstanceRegistry::~InstanceRegistry() {
+    for (auto& item : m_masters) {
+        ReleaseMaster(&item.second);
+    }
+}
+
+uint32_t InstanceRegistry::Add(const std::string& prefix, const std::string& confPath) {
+    if (prefix.empty()) return 0;
+    std::string normalized = NormalizePrefix(prefix);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto existing = m_byPrefix.find(normalized);
+    if (existing != m_byPrefix.end()) {
+        InstanceInfo& info = m_instances[existing->second];
+        info.confPath = confPath;
+        return info.id;
+    }
+
+    InstanceInfo info;
+    info.id = m_nextId++;
+    info.prefix = prefix;
+    info.confPath = confPath;
+    info.sinceMicros = MonotonicMicros();
+    size_t index = m_instances.size();
+    m_instances.push_back(info);
+    m_normalized.push_back(normalized);
+    m_byId[info.id] = index;
+    m_byPrefix[normalized] = index;
+    return info.id;
+}
+
+bool InstanceRegistry::Remove(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_byId.find(id);
+    if (found == m_byId.end()) return false;
+
+    // 与末尾元素交换后弹出，其余实例的下标只有被移动的那个需要更新
+    size_t index = found->second;
+    size_t last = m_instances.size() - 1;
+    m_byPrefix.erase(m_normalized[index]);
+    m_byId.erase(found);
+    if (index != last) {
+        m_instances[index] = std::move(m_instances[last]);
+        m_normalized[index] = std::move(m_normalized[last]);
+        m_byId[m_instances[index].id] = index;
+        m_byPrefix[m_normalized[index]] = index;
+    }
+    m_instances.pop_back();
+    m_normalized.pop_back();
+    return true;
+}
+
+void InstanceRegistry::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_instances.clear();
+    m_normalized.clear();
+    m_byId.clear();
+    m_byPrefix.clear();
+}
+
+bool InstanceRegistry::Get(uint32_t id, InstanceInfo* info) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_byId.find(id);
+    if (found == m_byId.end()) return false;
+    *info = m_instances[found->second];
+    return true;
+}
+
+bool InstanceRegistry::FindByPrefix(const std::string& prefix, InstanceInfo* info) const {
+    std::string normalized = NormalizePrefix(prefix);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_byPrefix.find(normalized);
+    if (found == m_byPrefix.end()) return false;
+    *info = m_instances[found->second];
+    return true;
+}
+
+std::vector<InstanceInfo> InstanceRegistry::List() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_instances;
+}
+
+size_t InstanceRegistry::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_instances.size();
+}
+
+bool InstanceRegistry::IsSameMaster(const MasterIdentity& identity, const ProcessEntry& entry) const {
+#ifdef _WIN32
+    // 持有句柄期间 PID 不会被复用；没有句柄（无权限打开）时每轮重新解析
+    (void)entry;
+    return identity.handle && WaitForSingleObject(identity.handle, 0) == WAIT_TIMEOUT;
+#else
+    return identity.startTime == entry.startTime;
+#endif
+}
+
+void InstanceRegistry::ReleaseMaster(MasterIdentity* identity) {
+#ifdef _WIN32
+    if (identity->handle) {
+        CloseHandle(identity->handle);
+        identity->handle = NULL;
+    }
+#else
+    (void)identity;
+#endif
+}
+
+bool InstanceRegistry::Probe(std::vector<uint32_t>* changed, InstanceProbeStats* stats) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (changed) changed->clear();
+
+    InstanceProbeStats local;
+    uint64_t begin = MonotonicMicros();
+    if (!ScanNginxProcesses(&m_scan)) return false;
+    uint64_t scanned = MonotonicMicros();
+    ++m_generation;
+
+    m_nginxPids.clear();
+    for (size_t i = 0; i < m_scan.size(); ++i) {
+        m_nginxPids[m_scan[i].pid] = i;
+    }
+    m_masterOwner.clear();
+    m_observed.assign(m_instances.size(), Observation());
+
+    // 1. master：父进程不是 nginx 的进程，按缓存的前缀找到所属实例
+    for (const ProcessEntry& entry : m_scan) {
+        if (m_nginxPids.count(entry.parentPid)) continue;
+        ++local.masters;
+
+        auto known = m_masters.find(entry.pid);
+        if (known != m_masters.end() && !IsSameMaster(known->second, entry)) {
+            ReleaseMaster(&known->second);
+            m_masters.erase(known);
+            known = m_masters.end();
+        }
+        if (known == m_masters.end()) {
+            MasterIdentity identity;
+            identity.startTime = entry.startTime;
+#ifdef _WIN32
+            identity.handle = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, entry.pid);
+#endif
+            std::string prefix;
+            if (ResolveProcessPrefix(entry.pid, &prefix)) identity.prefix = NormalizePrefix(prefix);
+            ++local.resolved;
+            known = m_masters.emplace(entry.pid, identity).first;
+        }
+        known->second.generation = m_generation;
+
+        auto owner = m_byPrefix.find(known->second.prefix);
+        if (owner == m_byPrefix.end()) continue;
+        Observation& observed = m_observed[owner->second];
+        // 同一前缀有多个 master 时优先保留上一轮的 master，避免 PID 来回跳动
+        if (observed.masters++ == 0 || entry.pid == m_instances[owner->second].masterPid) {
+            observed.masterPid = entry.pid;
+        }
+        m_masterOwner[entry.pid] = owner->second;
+    }
+
+    // 2. worker（以及 cache manager 等子进程）：按父进程归属
+    for (const ProcessEntry& entry : m_scan) {
+        auto owner = m_masterOwner.find(entry.parentPid);
+        if (owner != m_masterOwner.end() && m_observed[owner->second].masterPid == entry.parentPid) {
+            ++m_observed[owner->second].workers;
+        }
+    }
+
+    // 3. 丢弃本轮未出现的 master
+    for (auto it = m_masters.begin(); it != m_masters.end();) {
+        if (it->second.generation != m_generation) {
+            ReleaseMaster(&it->second);
+            it = m_masters.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // 4. 更新实例状态
+    uint64_t now = MonotonicMicros();
+    for (size_t i = 0; i < m_instances.size(); ++i) {
+        InstanceInfo& info = m_instances[i];
+        const Observation& observed = m_observed[i];
+        InstanceState state = INSTANCE_STOPPED;
+        if (observed.masterPid) state = observed.workers ? INSTANCE_RUNNING : INSTANCE_NO_WORKERS;
+
+        if (state != info.state || observed.masterPid != info.masterPid) {
+            if (state != info.state) info.sinceMicros = now;
+            info.state = state;
+            info.masterPid = observed.masterPid;
+            ++local.changed;
+            if (changed) changed->push_back(info.id);
+        }
+        info.workerCount = observed.workers;
+        info.masterCount = observed.masters;
+    }
+
+    if (stats) {
+        local.instances = m_instances.size();
+        local.processes = m_scan.size();
+        local.scanMicros = scanned - begin;
+        local.matchMicros = MonotonicMicros() - scanned;
+        *stats = local;
+    }
+    return true;
+}
@@ -0,0 +1,107 @@
+// nginx-manager/src/instance_registry.h
+// 多实例登记表 - 按安装前缀区分同一主机上的多个 nginx，一次扫描更新所有实例的状态
+
+#ifndef INSTANCE_REGISTRY_H
+#define INSTANCE_REGISTRY_H
+
+#include "process_table.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum InstanceState {
+    INSTANCE_UNKNOWN,                // 尚未探测
+    INSTANCE_STOPPED,
+    INSTANCE_RUNNING,
+    INSTANCE_NO_WORKERS              // master 存在但没有 worker（启动中、退出中或 worker 全部崩溃）
+};
+
+const char* InstanceStateName(InstanceState state);
+
+// 一个 nginx 实例
+struct InstanceInfo {
+    uint32_t id = 0;                 // 登记时分配，移除前保持不变
+    std::string prefix;              // 登记时的原始前缀
+    std::string confPath;            // 为空时为 <prefix>/conf/nginx.conf
+    InstanceState state = INSTANCE_UNKNOWN;
+    ProcessId masterPid = 0;
+    uint32_t workerCount = 0;
+    uint32_t masterCount = 0;        // 大于 1 表示同一前缀有多个 master（例如热升级过程中）
+    uint64_t sinceMicros = 0;        // 进入当前状态的时刻 (MonotonicMicros)
+};
+
+// 一次探测的统计
+struct InstanceProbeStats {
+    size_t instances = 0;
+    size_t processes = 0;            // 本次扫描到的 nginx 进程数
+    size_t masters = 0;
+    size_t resolved = 0;             // 本次新解析前缀的 master 数（其余命中缓存）
+    size_t changed = 0;
+    uint64_t scanMicros = 0;         // 扫描进程表的耗时
+    uint64_t matchMicros = 0;        // 把进程归属到实例的耗时
+};
+
+// 实例登记表
+// Probe 每个周期只扫描一次进程表，然后用哈希表把 master 按前缀、worker 按父进程归属到实例，
+// 耗时与 "进程数 + 实例数" 成正比，与实例数的乘积无关。
+// master 的前缀解析（打开进程、读取映像路径或命令行）按 master 身份缓存，
+// 每个 master 在其生命周期内只解析一次；身份由 PID 加启动时间 (Linux) 或持有的进程句柄 (Windows) 确定。
+// 所有方法线程安全。
+class InstanceRegistry {
+public:
+    InstanceRegistry() {}
+    ~InstanceRegistry();
+
+    InstanceRegistry(const InstanceRegistry&) = delete;
+    InstanceRegistry& operator=(const InstanceRegistry&) = delete;
+
+    // 登记实例，返回实例 ID；前缀已登记时返回已有实例的 ID（并更新配置路径）
+    uint32_t Add(const std::string& prefix, const std::string& confPath);
+    bool Remove(uint32_t id);
+    void Clear();
+
+    bool Get(uint32_t id, InstanceInfo* info) const;
+    bool FindByPrefix(const std::string& prefix, InstanceInfo* info) const;
+    std::vector<InstanceInfo> List() const;
+    size_t Size() const;
+
+    // 扫描一次进程表并更新所有实例，changed 返回状态发生变化的实例 ID
+    bool Probe(std::vector<uint32_t>* changed, InstanceProbeStats* stats);
+
+private:
+    // 已识别的 master 进程
+    struct MasterIdentity {
+        std::string prefix;          // 规范化后的前缀，解析失败时为空
+        uint64_t startTime = 0;
+        uint64_t generation = 0;     // 最近一次在扫描中出现的探测轮次
+#ifdef _WIN32
+        HANDLE handle = NULL;
+#endif
+    };
+
+    bool IsSameMaster(const MasterIdentity& identity, const ProcessEntry& entry) const;
+    void ReleaseMaster(MasterIdentity* identity);
+
+    mutable std::mutex m_mutex;
+    std::vector<InstanceInfo> m_instances;
+    std::unordered_map<uint32_t, size_t> m_byId;             // id -> m_instances 下标
+    std::unordered_map<std::string, size_t> m_byPrefix;      // 规范化前缀 -> m_instances 下标
+    std::vector<std::string> m_normalized;                   // 与 m_instances 一一对应
+    uint32_t m_nextId = 1;
+
+    // 探测过程中复用的缓冲，避免每个周期重新分配
+    std::unordered_map<ProcessId, MasterIdentity> m_masters;
+    std::vector<ProcessEntry> m_scan;
+    std::unordered_map<ProcessId, size_t> m_nginxPids;       // PID -> m_scan 下标
+    std::unordered_map<ProcessId, size_t> m_masterOwner;     // master PID -> m_instances 下标
+    struct Observation {
+        ProcessId masterPid = 0;
+        uint32_t masters = 0;
+        uint32_t workers = 0;
+    };
+    std::vector<Observation> m_observed;                     // 与 m_instances 一一对应
+    uint64_t m_generation = 0;
+};
+
+#endif // INSTANCE_REGISTRY_H
@@ -0,0 +1,631 @@
+// nginx-manager/src/journal.cpp
+// 操作日志持久化 - 追加写入的二进制分段文件 + 稀疏时间索引，按时间 / 序号直接定位
+
+#include "journal.h"
+#include "content_hash.h"
+#include "file_util.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// 文件格式（小端）：
+//   分段头 16 字节：'NGJ1'、版本 (uint32)、保留 8 字节
+//   记录：负载长度 (uint32)、校验 (uint32, XXH64 低 32 位)、负载
+//   负载：时间 (int64)、序号 (uint64)、数值 (int64)、类型 (uint8)、级别 (uint8)、UTF-8 文本
+//   索引项：时间 (int64)、序号 (uint64)、记录偏移 (uint64)
+static const char kMagic[4] = { 'N', 'G', 'J', '1' };
+static const uint32_t kVersion = 1;
+static const uint64_t kHeaderSize = 16;
+static const size_t kRecordHeader = 8;
+static const size_t kPayloadFixed = 26;
+static const size_t kMaxTextBytes = 60000;
+static const size_t kIndexEntrySize = 24;
+
+// ---------------------------------------------------------------------------
+// 文件操作（路径均为 UTF-8）
+
+static bool SeekTo(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static uint64_t SizeOf(FILE* file) {
+#ifdef _WIN32
+    if (_fseeki64(file, 0, SEEK_END) != 0) return 0;
+    return (uint64_t)_ftelli64(file);
+#else
+    if (fseeko(file, 0, SEEK_END) != 0) return 0;
+    return (uint64_t)ftello(file);
+#endif
+}
+
+static bool TruncateTo(const std::string& path, uint64_t size) {
+    FILE* file = OpenFile(path, "r+b");
+    if (!file) return false;
+#ifdef _WIN32
+    bool ok = _chsize_s(_fileno(file), (__int64)size) == 0;
+#else
+    bool ok = ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+    fclose(file);
+    return ok;
+}
+
+// 列出目录中 seg-*.jnl 文件的主文件名（不含扩展名）
+static std::vector<std::string> ListSegments(const std::string& directory) {
+    std::vector<std::string> names;
+    for (const std::string& name : ListDirectory(directory)) {
+        if (name.size() > 8 && name.compare(0, 4, "seg-") == 0 && name.compare(name.size() - 4, 4, ".jnl") == 0) {
+            names.push_back(name.substr(0, name.size() - 4));
+        }
+    }
+    return names;
+}
+
+// "seg-<16 位十六进制序号>-<16 位十六进制时间>"
+static bool ParseSegmentName(const std::string& name, uint64_t* firstSequence, int64_t* firstTime) {
+    unsigned long long sequence = 0;
+    unsigned long long time = 0;
+    if (name.size() != 37 || sscanf(name.c_str(), "seg-%16llx-%16llx", &sequence, &time) != 2) return false;
+    *firstSequence = sequence;
+    *firstTime = (int64_t)time;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 记录编解码
+
+static void AppendRecord(std::vector<char>* out, const JournalRecord& record, std::string_view text) {
+    uint32_t payloadSize = (uint32_t)(kPayloadFixed + text.size());
+    size_t begin = out->size();
+    out->resize(begin + kRecordHeader + payloadSize);
+    char* p = out->data() + begin;
+
+    char* payload = p + kRecordHeader;
+    memcpy(payload, &record.timeMicros, 8);
+    memcpy(payload + 8, &record.sequence, 8);
+    memcpy(payload + 16, &record.value, 8);
+    payload[24] = (char)record.type;
+    payload[25] = (char)record.severity;
+    if (!text.empty()) memcpy(payload + kPayloadFixed, text.data(), text.size());
+
+    uint32_t checksum = (uint32_t)HashBytes(payload, payloadSize);
+    memcpy(p, &payloadSize, 4);
+    memcpy(p + 4, &checksum, 4);
+}
+
+// 解析 data 开头的一条记录；数据不完整或校验失败返回 false
+static bool ParseRecord(const char* data, size_t available, JournalRecord* record, size_t* consumed,
+                        bool withText) {
+    if (available < kRecordHeader) return false;
+    uint32_t payloadSize;
+    uint32_t checksum;
+    memcpy(&payloadSize, data, 4);
+    memcpy(&checksum, data + 4, 4);
+    if (payloadSize < kPayloadFixed || payloadSize > kPayloadFixed + kMaxTextBytes) return false;
+    if (available - kRecordHeader < payloadSize) return false;
+
+    const char* payload = data + kRecordHeader;
+    if ((uint32_t)HashBytes(payload, payloadSize) != checksum) return false;
+
+    memcpy(&record->timeMicros, payload, 8);
+    memcpy(&record->sequence, payload + 8, 8);
+    memcpy(&record->value, payload + 16, 8);
+    record->type = (uint8_t)payload[24];
+    record->severity = (uint8_t)payload[25];
+    if (withText) record->text.assign(payload + kPayloadFixed, payloadSize - kPayloadFixed);
+    *consumed = kRecordHeader + payloadSize;
+    return true;
+}
+
+static bool ReadRange(FILE* file, uint64_t begin, uint64_t end, std::vector<char>* buffer) {
+    buffer->resize((size_t)(end - begin));
+    if (buffer->empty()) return true;
+    if (!SeekTo(file, begin)) return false;
+    return fread(buffer->data(), 1, buffer->size(), file) == buffer->size();
+}
+
+// ---------------------------------------------------------------------------
+// Journal
+
+Journal::~Journal() {
+    Close();
+}
+
+std::string Journal::SegmentPath(const Segment& segment) const {
+    return m_directory + "/" + segment.name + ".jnl";
+}
+
+std::string Journal::IndexPath(const Segment& segment) const {
+    return m_directory + "/" + segment.name + ".idx";
+}
+
+bool Journal::IsOpen() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+uint64_t Journal::NextSequence() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextSequence;
+}
+
+size_t Journal::SegmentCount() const {
+    std::lock_guard<std::mutex> files(m_fileMutex);
+    return m_segments.size();
+}
+
+bool Journal::Open(const std::string& directory, std::string* error) {
+    Close();
+    std::lock_guard<std::mutex> files(m_fileMutex);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!MakeDirectory(directory)) {
+        if (error) *error = "无法创建日志目录: " + directory;
+        return false;
+    }
+    m_directory = directory;
+
+    for (const std::string& name : ListSegments(directory)) {
+        Segment segment;
+        if (!ParseSegmentName(name, &segment.firstSequence, &segment.firstTime)) continue;
+        segment.name = name;
+        StatFile(SegmentPath(segment), &segment.bytes);
+        m_segments.push_back(segment);
+    }
+    std::sort(m_segments.begin(), m_segments.end(), [](const Segment& a, const Segment& b) {
+        return a.firstSequence < b.firstSequence;
+    });
+
+    m_nextSequence = 1;
+    m_lastTime = 0;
+    if (!RecoverTail(error) || (!m_segments.empty() && !OpenActive())) {
+        if (error && error->empty()) *error = "无法打开日志分段";
+        CloseActive();
+        m_segments.clear();
+        m_directory.clear();
+        return false;
+    }
+    m_writtenSequence = m_nextSequence;
+    PruneSegments();
+    m_open = true;
+    m_stopping = false;
+    m_worker = std::thread(&Journal::Run, this);
+    return true;
+}
+
+void Journal::Close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = false;
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+
+    std::lock_guard<std::mutex> files(m_fileMutex);
+    WritePending();
+    CloseActive();
+    m_segments.clear();
+    m_directory.clear();
+}
+
+// 后台写入线程：有排队的记录就成批写入，关闭时写完剩余的记录再退出
+void Journal::Run() {
+    TraceSetThreadName("journal");
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+            if (m_stopping && m_pending.empty()) return;
+        }
+        std::lock_guard<std::mutex> files(m_fileMutex);
+        WritePending();
+    }
+}
+
+// 已封存分段的总大小超过保留上限时从最旧的分段开始删除，活动分段总是保留
+void Journal::PruneSegments() {
+    if (m_retainBytes == 0) return;
+    uint64_t total = 0;
+    for (size_t i = 0; i + 1 < m_segments.size(); ++i) total += m_segments[i].bytes;
+    size_t removed = 0;
+    while (removed + 1 < m_segments.size() && total > m_retainBytes) {
+        const Segment& segment = m_segments[removed];
+        RemoveFile(SegmentPath(segment));
+        RemoveFile(IndexPath(segment));
+        total -= segment.bytes;
+        ++removed;
+    }
+    m_segments.erase(m_segments.begin(), m_segments.begin() + removed);
+}
+
+bool Journal::LoadIndex(Segment* segment) {
+    if (segment->indexLoaded) return true;
+    segment->index.clear();
+
+    FILE* file = OpenFile(IndexPath(*segment), "rb");
+    if (file) {
+        std::vector<char> data;
+        uint64_t size = SizeOf(file);
+        size -= size % kIndexEntrySize;
+        if (ReadRange(file, 0, size, &data)) {
+            for (size_t offset = 0; offset < data.size(); offset += kIndexEntrySize) {
+                IndexEntry entry;
+                memcpy(&entry.timeMicros, data.data() + offset, 8);
+                memcpy(&entry.sequence, data.data() + offset + 8, 8);
+                memcpy(&entry.offset, data.data() + offset + 16, 8);
+                // 索引必须严格递增，否则视为损坏并丢弃其后的部分
+                if (!segment->index.empty() && entry.offset <= segment->index.back().offset) break;
+                segment->index.push_back(entry);
+            }
+        }
+        fclose(file);
+    }
+
+    // 索引缺失时至少保证分段开头可定位
+    if (segment->index.empty() || segment->index.front().offset != kHeaderSize) {
+        IndexEntry first = { segment->firstTime, segment->firstSequence, kHeaderSize };
+        segment->index.insert(segment->index.begin(), first);
+    }
+    segment->indexLoaded = true;
+    return true;
+}
+
+// 校验最后一个分段的尾部：截掉不完整的记录、补齐缺失的索引，并恢复下一个序号
+bool Journal::RecoverTail(std::string* error) {
+    while (!m_segments.empty()) {
+        Segment& segment = m_segments.back();
+        std::string path = SegmentPath(segment);
+        FILE* file = OpenFile(path, "rb");
+        if (!file) {
+            if (error) *error = "无法读取日志分段: " + path;
+            return false;
+        }
+
+        uint64_t size = SizeOf(file);
+        char header[kHeaderSize] = {};
+        bool headerOk = size >= kHeaderSize && SeekTo(file, 0) && fread(header, 1, kHeaderSize, file) == kHeaderSize &&
+                        memcmp(header, kMagic, 4) == 0;
+        if (!headerOk) {
+            // 无法识别的分段改名保留，不参与读写
+            fclose(file);
+            RenameFile(path, path + ".corrupt");
+            RemoveFile(IndexPath(segment));
+            m_segments.pop_back();
+            continue;
+        }
+
+        LoadIndex(&segment);
+        while (segment.index.size() > 1 && segment.index.back().offset >= size) segment.index.pop_back();
+
+        // 从最后一个索引项开始扫描；该处的记录本身已损坏时退回前一个索引项
+        std::vector<IndexEntry> rebuilt;
+        uint64_t validEnd = kHeaderSize;
+        size_t records = 0;
+        std::vector<char> data;
+        while (!segment.index.empty()) {
+            uint64_t scanFrom = segment.index.back().offset;
+            if (!ReadRange(file, scanFrom, size, &data)) {
+                fclose(file);
+                if (error) *error = "无法读取日志分段: " + path;
+                return false;
+            }
+
+            rebuilt.assign(segment.index.begin(), segment.index.end() - 1);
+            uint64_t lastIndexed = 0;
+            validEnd = scanFrom;
+            JournalRecord record;
+            size_t position = 0;
+            size_t consumed = 0;
+            while (ParseRecord(data.data() + position, data.size() - position, &record, &consumed, false)) {
+                uint64_t offset = scanFrom + position;
+                if (lastIndexed == 0 || offset - lastIndexed >= kIndexInterval) {
+                    IndexEntry entry = { record.timeMicros, record.sequence, offset };
+                    rebuilt.push_back(entry);
+                    lastIndexed = offset;
+                }
+                m_nextSequence = record.sequence + 1;
+                m_lastTime = record.timeMicros;
+                position += consumed;
+                validEnd = offset + consumed;
+                ++records;
+            }
+            if (records > 0 || segment.index.size() == 1) break;
+            segment.index.pop_back();
+        }
+        fclose(file);
+
+        if (records == 0) {
+            // 空分段（创建后尚未写入即退出），删除后检查前一个分段
+            RemoveFile(path);
+            RemoveFile(IndexPath(segment));
+            m_segments.pop_back();
+            continue;
+        }
+
+        if (validEnd < size) TruncateTo(path, validEnd);
+
+        // 重写索引文件（只有尾部发生变化时才需要，但索引很小，直接重写更简单）
+        segment.index = rebuilt;
+        FILE* indexFile = OpenFile(IndexPath(segment), "wb");
+        if (indexFile) {
+            for (const IndexEntry& entry : segment.index) {
+                char raw[kIndexEntrySize];
+                memcpy(raw, &entry.timeMicros, 8);
+                memcpy(raw + 8, &entry.sequence, 8);
+                memcpy(raw + 16, &entry.offset, 8);
+                fwrite(raw, 1, kIndexEntrySize, indexFile);
+            }
+            fclose(indexFile);
+        }
+
+        m_activeSize = validEnd;
+        m_lastIndexedOffset = segment.index.back().offset;
+        return true;
+    }
+    return true;
+}
+
+bool Journal::OpenActive() {
+    const Segment& segment = m_segments.back();
+    m_active = OpenFile(SegmentPath(segment), "ab");
+    m_activeIndex = OpenFile(IndexPath(segment), "ab");
+    if (!m_active || !m_activeIndex) {
+        CloseActive();
+        return false;
+    }
+    // 无缓冲：每批记录对应一次 write，写入线程返回时记录已交给操作系统
+    setvbuf(m_active, NULL, _IONBF, 0);
+    setvbuf(m_activeIndex, NULL, _IONBF, 0);
+    return true;
+}
+
+void Journal::CloseActive() {
+    if (m_active) {
+        fclose(m_active);
+        m_active = nullptr;
+    }
+    if (m_activeIndex) {
+        fclose(m_activeIndex);
+        m_activeIndex = nullptr;
+    }
+}
+
+bool Journal::StartSegment(uint64_t firstSequence, int64_t firstTime) {
+    CloseActive();
+    if (!m_segments.empty()) m_segments.back().bytes = m_activeSize;
+
+    Segment segment;
+    char name[64];
+    snprintf(name, sizeof(name), "seg-%016llx-%016llx", (unsigned long long)firstSequence,
+             (unsigned long long)firstTime);
+    segment.name = name;
+    segment.firstSequence = firstSequence;
+    segment.firstTime = firstTime;
+    segment.indexLoaded = true;
+
+    FILE* file = OpenFile(SegmentPath(segment), "wb");
+    if (!file) return false;
+    char header[kHeaderSize] = {};
+    memcpy(header, kMagic, 4);
+    memcpy(header + 4, &kVersion, 4);
+    bool ok = fwrite(header, 1, kHeaderSize, file) == kHeaderSize;
+    fclose(file);
+    FILE* index = OpenFile(IndexPath(segment), "wb");
+    if (index) fclose(index);
+    if (!ok || !index) return false;
+
+    m_segments.push_back(segment);
+    m_activeSize = kHeaderSize;
+    m_lastIndexedOffset = 0;
+    PruneSegments();
+    return OpenActive();
+}
+
+bool Journal::Append(JournalType type, uint8_t severity, int64_t value, std::string_view text,
+                     int64_t timeMicros, uint64_t* sequence) {
+    if (text.size() > kMaxTextBytes) text = text.substr(0, kMaxTextBytes);
+
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_open || m_pending.size() >= kMaxPendingRecords) return false;
+
+        // 时间不递减，时钟回拨期间沿用上一条记录的时间，索引因此始终有序
+        if (timeMicros < m_lastTime) timeMicros = m_lastTime;
+
+        wake = m_pending.empty();
+        m_pending.emplace_back();
+        JournalRecord& record = m_pending.back();
+        record.sequence = m_nextSequence++;
+        record.timeMicros = timeMicros;
+        record.value = value;
+        record.type = (uint8_t)type;
+        record.severity = severity;
+        record.text.assign(text.data(), text.size());
+        m_lastTime = timeMicros;
+        if (sequence) *sequence = record.sequence;
+    }
+    if (wake) m_wake.notify_one();
+    return true;
+}
+
+// 在持有 m_fileMutex 时调用：把排队的记录编码后写入活动分段，需要换分段时先写出已攒下的部分
+void Journal::WritePending() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.empty()) return;
+        m_writing.swap(m_pending);
+    }
+    uint64_t batchStart = m_activeSize;
+    for (const JournalRecord& record : m_writing) {
+        uint64_t recordSize = kRecordHeader + kPayloadFixed + record.text.size();
+        bool roll = m_active && m_activeSize > kHeaderSize && m_activeSize + recordSize > m_segmentLimit;
+        if (!m_active || roll) {
+            FlushBatch(batchStart);
+            // 无法创建分段时丢弃这条记录，下一条再试
+            if (!StartSegment(record.sequence, record.timeMicros)) continue;
+            batchStart = m_activeSize;
+        }
+
+        uint64_t offset = m_activeSize;
+        AppendRecord(&m_writeBuffer, record, record.text);
+        m_activeSize += recordSize;
+        if (m_lastIndexedOffset == 0 || offset - m_lastIndexedOffset >= kIndexInterval) {
+            IndexEntry entry = { record.timeMicros, record.sequence, offset };
+            char raw[kIndexEntrySize];
+            memcpy(raw, &entry.timeMicros, 8);
+            memcpy(raw + 8, &entry.sequence, 8);
+            memcpy(raw + 16, &entry.offset, 8);
+            m_indexBuffer.insert(m_indexBuffer.end(), raw, raw + kIndexEntrySize);
+            Segment& segment = m_segments.back();
+            if (segment.index.empty() || segment.index.back().offset < offset) segment.index.push_back(entry);
+            m_lastIndexedOffset = offset;
+        }
+        m_writtenSequence = record.sequence + 1;
+    }
+    FlushBatch(batchStart);
+    m_writing.clear();
+}
+
+// 把攒下的记录一次写入活动分段，再追加对应的索引项
+bool Journal::FlushBatch(uint64_t batchStart) {
+    if (m_writeBuffer.empty()) return true;
+    bool ok = m_active && fwrite(m_writeBuffer.data(), 1, m_writeBuffer.size(), m_active) == m_writeBuffer.size();
+    if (ok) {
+        // 索引写入失败不影响记录本身，下次打开时会从记录重建
+        if (!m_indexBuffer.empty()) fwrite(m_indexBuffer.data(), 1, m_indexBuffer.size(), m_activeIndex);
+    } else {
+        // 写入失败（如磁盘已满）：截掉可能写了一半的记录并丢弃这一批，下次写入时另起分段
+        CloseActive();
+        TruncateTo(SegmentPath(m_segments.back()), batchStart);
+        m_activeSize = batchStart;
+        std::vector<IndexEntry>& index = m_segments.back().index;
+        while (index.size() > 1 && index.back().offset >= batchStart) index.pop_back();
+    }
+    m_writeBuffer.clear();
+    m_indexBuffer.clear();
+    return ok;
+}
+
+uint64_t Journal::SegmentEnd(size_t segment) {
+    if (segment + 1 == m_segments.size() && m_active) return m_activeSize;
+    FILE* file = OpenFile(SegmentPath(m_segments[segment]), "rb");
+    if (!file) return kHeaderSize;
+    uint64_t size = SizeOf(file);
+    fclose(file);
+    return size;
+}
+
+uint64_t Journal::SegmentEndSequence(size_t segment) const {
+    return segment + 1 < m_segments.size() ? m_segments[segment + 1].firstSequence : m_writtenSequence;
+}
+
+// 读取分段中第 block 个索引项覆盖的全部记录
+bool Journal::ReadBlock(size_t segment, size_t block, uint32_t typeMask, std::vector<JournalRecord>* records) {
+    records->clear();
+    Segment& seg = m_segments[segment];
+    uint64_t begin = seg.index[block].offset;
+    uint64_t end = block + 1 < seg.index.size() ? seg.index[block + 1].offset : SegmentEnd(segment);
+    if (end <= begin) return true;
+
+    FILE* file = OpenFile(SegmentPath(seg), "rb");
+    if (!file) return false;
+    std::vector<char> data;
+    bool ok = ReadRange(file, begin, end, &data);
+    fclose(file);
+    if (!ok) return false;
+
+    size_t position = 0;
+    size_t consumed = 0;
+    JournalRecord record;
+    while (ParseRecord(data.data() + position, data.size() - position, &record, &consumed, true)) {
+        if (typeMask & (1u << record.type)) records->push_back(record);
+        position += consumed;
+    }
+    return true;
+}
+
+size_t Journal::Query(int64_t fromMicros, int64_t toMicros, uint32_t typeMask, size_t limit,
+                      std::vector<JournalRecord>* records) {
+    records->clear();
+    std::lock_guard<std::mutex> files(m_fileMutex);
+    WritePending();
+    if (m_segments.empty() || limit == 0) return 0;
+
+    // 分段按时间有序：从最后一个首条时间不晚于 from 的分段开始
+    size_t first = 0;
+    for (size_t i = 0; i < m_segments.size(); ++i) {
+        if (m_segments[i].firstTime <= fromMicros) first = i;
+        else break;
+    }
+
+    std::vector<JournalRecord> block;
+    for (size_t s = first; s < m_segments.size(); ++s) {
+        if (m_segments[s].firstTime >= toMicros) break;
+        LoadIndex(&m_segments[s]);
+        const std::vector<IndexEntry>& index = m_segments[s].index;
+
+        // 索引项之前的记录时间都不晚于该项，因此从最后一个早于 from 的索引项开始即可
+        size_t startBlock = 0;
+        for (size_t b = 0; b < index.size() && index[b].timeMicros < fromMicros; ++b) startBlock = b;
+
+        for (size_t b = startBlock; b < index.size(); ++b) {
+            if (index[b].timeMicros >= toMicros) return records->size();
+            ReadBlock(s, b, typeMask, &block);
+            for (JournalRecord& record : block) {
+                if (record.timeMicros < fromMicros) continue;
+                if (record.timeMicros >= toMicros) return records->size();
+                records->push_back(std::move(record));
+                if (records->size() >= limit) return records->size();
+            }
+        }
+    }
+    return records->size();
+}
+
+size_t Journal::ReadBefore(uint64_t beforeSequence, uint64_t afterSequence, uint32_t typeMask, size_t count,
+                           std::vector<JournalRecord>* records) {
+    records->clear();
+    std::lock_guard<std::mutex> files(m_fileMutex);
+    WritePending();
+    if (count == 0) return 0;
+
+    std::vector<JournalRecord> block;
+    for (size_t s = m_segments.size(); s-- > 0;) {
+        if (m_segments[s].firstSequence >= beforeSequence) continue;
+        if (SegmentEndSequence(s) <= afterSequence + 1) break;
+        LoadIndex(&m_segments[s]);
+        const std::vector<IndexEntry>& index = m_segments[s].index;
+
+        size_t lastBlock = 0;
+        for (size_t b = 0; b < index.size() && index[b].sequence < beforeSequence; ++b) lastBlock = b;
+
+        for (size_t b = lastBlock + 1; b-- > 0;) {
+            ReadBlock(s, b, typeMask, &block);
+            for (size_t i = block.size(); i-- > 0;) {
+                if (block[i].sequence >= beforeSequence) continue;
+                if (block[i].sequence <= afterSequence) break;
+                records->push_back(std::move(block[i]));
+                if (records->size() >= count) break;
+            }
+            if (records->size() >= count || index[b].sequence <= afterSequence + 1) {
+                std::reverse(records->begin(), records->end());
+                return records->size();
+            }
+        }
+    }
+    std::reverse(records->begin(), records->end());
+    return records->size();
+}
@@ -0,0 +1,137 @@
+// nginx-manager/src/journal.h
+// 操作日志持久化 - 追加写入的二进制分段文件 + 稀疏时间索引，按时间 / 序号直接定位
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "platform.h"
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 记录类型
+enum JournalType {
+    JOURNAL_LOG = 1,                 // 操作日志面板中的一行
+    JOURNAL_EVENT = 2,               // 服务事件（启动 / 停止 / 重载等），value 为耗时（微秒）
+    JOURNAL_OPERATION = 3            // 后台操作完成，value 为执行耗时（微秒）
+};
+
+// 类型过滤掩码
+inline uint32_t JournalMask(JournalType type) { return 1u << type; }
+const uint32_t kJournalAllTypes = 0xFFFFFFFFu;
+
+struct JournalRecord {
+    uint64_t sequence = 0;
+    int64_t timeMicros = 0;          // UTC 微秒；写入时保证不递减
+    int64_t value = 0;
+    uint8_t type = 0;
+    uint8_t severity = 0;
+    std::string text;                // UTF-8
+};
+
+// 追加写入的操作日志
+// 目录中每个分段为一对文件：seg-<首条序号>-<首条时间>.jnl（记录）与同名 .idx（稀疏索引）。
+// 每写入约 64KB 记录追加一条索引 (时间, 序号, 偏移)，查询先按文件名选分段、再按索引定位，
+// 打开时只读取最后一个分段的尾部用于恢复（截掉写了一半的记录）。
+// Append 只在内存中排队并分配序号，后台线程把排队的记录成批写入（每批一次写入），调用方不等待磁盘；
+// 已封存分段的总大小超过保留上限时删除最旧的分段。所有方法线程安全。
+class Journal {
+public:
+    static constexpr uint64_t kDefaultSegmentBytes = 8ull * 1024 * 1024;
+    static constexpr uint64_t kDefaultRetainBytes = 64ull * 1024 * 1024;
+    static constexpr uint64_t kIndexInterval = 64 * 1024;
+    static constexpr size_t kMaxPendingRecords = 65536;
+
+    Journal() {}
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    bool Open(const std::string& directory, std::string* error);
+    void Close();
+    bool IsOpen() const;
+
+    // 追加一条记录：分配序号后交给后台线程写入；未打开或排队过多（磁盘长时间阻塞）时返回 false。
+    // sequence 返回分配的序号
+    bool Append(JournalType type, uint8_t severity, int64_t value, std::string_view text, int64_t timeMicros,
+                uint64_t* sequence = nullptr);
+
+    // 按时间顺序返回 [fromMicros, toMicros) 内的记录，最多 limit 条（先写完排队中的记录）
+    size_t Query(int64_t fromMicros, int64_t toMicros, uint32_t typeMask, size_t limit,
+                 std::vector<JournalRecord>* records);
+
+    // 返回序号在 (afterSequence, beforeSequence) 内最新的 count 条记录（按序号升序），用于向前翻页
+    size_t ReadBefore(uint64_t beforeSequence, uint64_t afterSequence, uint32_t typeMask, size_t count,
+                      std::vector<JournalRecord>* records);
+
+    // 在 Open 之前调用
+    void SetSegmentLimit(uint64_t bytes) { m_segmentLimit = bytes; }
+    // 已封存分段的总大小上限，0 表示不限；在 Open 之前调用
+    void SetRetention(uint64_t bytes) { m_retainBytes = bytes; }
+    uint64_t NextSequence() const;
+    size_t SegmentCount() const;
+
+private:
+    struct IndexEntry {
+        int64_t timeMicros;
+        uint64_t sequence;
+        uint64_t offset;
+    };
+
+    struct Segment {
+        std::string name;            // 不含扩展名
+        uint64_t firstSequence = 0;
+        int64_t firstTime = 0;
+        uint64_t bytes = 0;          // 已封存分段的文件大小，活动分段不使用
+        bool indexLoaded = false;
+        std::vector<IndexEntry> index;
+    };
+
+    void Run();
+    void WritePending();
+    bool FlushBatch(uint64_t batchStart);
+    void PruneSegments();
+    bool LoadIndex(Segment* segment);
+    uint64_t SegmentEnd(size_t segment);
+    uint64_t SegmentEndSequence(size_t segment) const;
+    bool RecoverTail(std::string* error);
+    bool StartSegment(uint64_t firstSequence, int64_t firstTime);
+    bool OpenActive();
+    void CloseActive();
+    bool ReadBlock(size_t segment, size_t block, uint32_t typeMask, std::vector<JournalRecord>* records);
+
+    std::string SegmentPath(const Segment& segment) const;
+    std::string IndexPath(const Segment& segment) const;
+
+    // m_mutex 只保护排队与序号分配，Append 不会因为磁盘写入而等待
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_worker;
+    bool m_open = false;
+    bool m_stopping = false;
+    std::vector<JournalRecord> m_pending;    // 已分配序号、待写入的记录
+    uint64_t m_nextSequence = 1;
+    int64_t m_lastTime = 0;
+
+    // 以下由 m_fileMutex 保护（后台写入与查询互斥；需要两把锁时先取 m_fileMutex）
+    mutable std::mutex m_fileMutex;
+    std::string m_directory;
+    std::vector<Segment> m_segments; // 按首条序号升序，最后一个为活动分段
+    FILE* m_active = nullptr;
+    FILE* m_activeIndex = nullptr;
+    uint64_t m_activeSize = 0;
+    uint64_t m_lastIndexedOffset = 0;
+    uint64_t m_writtenSequence = 1;  // 已写入的最后一条记录的下一个序号
+    uint64_t m_segmentLimit = kDefaultSegmentBytes;
+    uint64_t m_retainBytes = kDefaultRetainBytes;
+    std::vector<JournalRecord> m_writing;
+    std::vector<char> m_writeBuffer;
+    std::vector<char> m_indexBuffer;
+};
+
+#endif // JOURNAL_H
@@ -0,0 +1,168 @@
+// nginx-manager/src/line_scan.cpp
+// 换行符扫描 - AVX2 / SSE2 向量化查找 '\n'，不支持时退化为按字长扫描
+
+#include "line_scan.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINE_SCAN_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC / Clang 需要为 AVX2 函数单独开启指令集，其余代码仍按基线编译
+#if defined(LINE_SCAN_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LINE_SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define LINE_SCAN_AVX2_TARGET
+#endif
+
+static inline unsigned CountTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(value);
+#endif
+}
+
+const char* FindNewlineScalar(const char* begin, const char* end) {
+    // 一次比较 8 字节：(x - 0x01..) & ~x & 0x80.. 非零说明其中有 0 字节
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t highs = 0x8080808080808080ull;
+    const uint64_t pattern = ones * (unsigned char)'\n';
+    const char* p = begin;
+    while (p + 8 <= end) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        uint64_t x = word ^ pattern;
+        if ((x - ones) & ~x & highs) break;
+        p += 8;
+    }
+    while (p < end && *p != '\n') ++p;
+    return p;
+}
+
+#ifdef LINE_SCAN_X86
+
+const char* FindNewlineSse2(const char* begin, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    const char* p = begin;
+    while (p + 16 <= end) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline));
+        if (mask) return p + CountTrailingZeros(mask);
+        p += 16;
+    }
+    while (p < end && *p != '\n') ++p;
+    return p;
+}
+
+LINE_SCAN_AVX2_TARGET
+static const char* FindNewlineAvx2Impl(const char* begin, const char* end) {
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    // 每轮 64 字节，两次比较合并后只做一次分支
+    while (p + 64 <= end) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        __m256i hitA = _mm256_cmpeq_epi8(a, newline);
+        __m256i hitB = _mm256_cmpeq_epi8(b, newline);
+        if (!_mm256_testz_si256(_mm256_or_si256(hitA, hitB), _mm256_or_si256(hitA, hitB))) {
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(hitA);
+            if (mask) return p + CountTrailingZeros(mask);
+            return p + 32 + CountTrailingZeros((uint32_t)_mm256_movemask_epi8(hitB));
+        }
+        p += 64;
+    }
+    while (p + 32 <= end) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline));
+        if (mask) return p + CountTrailingZeros(mask);
+        p += 32;
+    }
+    while (p < end && *p != '\n') ++p;
+    return p;
+}
+
+static bool CpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // OSXSAVE + AVX，且操作系统保存了 YMM 寄存器
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool HasAvx2() {
+    static const bool supported = CpuHasAvx2();
+    return supported;
+}
+
+const char* FindNewlineAvx2(const char* begin, const char* end) {
+    return HasAvx2() ? FindNewlineAvx2Impl(begin, end) : FindNewlineSse2(begin, end);
+}
+
+#else
+
+const char* FindNewlineSse2(const char* begin, const char* end) {
+    return FindNewlineScalar(begin, end);
+}
+
+const char* FindNewlineAvx2(const char* begin, const char* end) {
+    return FindNewlineScalar(begin, end);
+}
+
+static bool HasAvx2() {
+    return false;
+}
+
+#endif
+
+typedef const char* (*FindNewlineFunc)(const char*, const char*);
+
+static FindNewlineFunc SelectImplementation() {
+#ifdef LINE_SCAN_X86
+    return HasAvx2() ? FindNewlineAvx2Impl : FindNewlineSse2;
+#else
+    return FindNewlineScalar;
+#endif
+}
+
+static const char* ResolveAndFind(const char* begin, const char* end);
+
+// 初值为解析函数（常量初始化），首次调用后替换为选定的实现
+static std::atomic<FindNewlineFunc> g_findNewline(ResolveAndFind);
+
+static const char* ResolveAndFind(const char* begin, const char* end) {
+    FindNewlineFunc func = SelectImplementation();
+    g_findNewline.store(func, std::memory_order_relaxed);
+    return func(begin, end);
+}
+
+const char* FindNewline(const char* begin, const char* end) {
+    return g_findNewline.load(std::memory_order_relaxed)(begin, end);
+}
+
+const char* NewlineScanLevel() {
+#ifdef LINE_SCAN_X86
+    return HasAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,21 @@
+// nginx-manager/src/line_scan.h
+// 换行符扫描 - AVX2 / SSE2 向量化查找 '\n'，不支持时退化为按字长扫描
+
+#ifndef LINE_SCAN_H
+#define LINE_SCAN_H
+
+#include <cstddef>
+
+// 在 [begin, end) 中查找第一个 '\n'，未找到返回 end
+// 首次调用时按 CPU 能力选择实现，此后为一次间接调用
+const char* FindNewline(const char* begin, const char* end);
+
+// 指定实现，供基准测试对比
+const char* FindNewlineScalar(const char* begin, const char* end);
+const char* FindNewlineSse2(const char* begin, const char* end);   // 平台不支持时等同标量实现
+const char* FindNewlineAvx2(const char* begin, const char* end);   // CPU 不支持时等同 SSE2 实现
+
+// 当前使用的实现名称："AVX2" / "SSE2" / "scalar"
+const char* NewlineScanLevel();
+
+#endif // LINE_SCAN_H
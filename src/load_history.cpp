@@ -0,0 +1,283 @@
+// nginx-manager/src/load_history.cpp
+// 压测记录 - 按配置指纹分文件保存每次压测的摘要，用于对比两份配置的吞吐与延迟
+
+#include "load_history.h"
+#include "file_util.h"
+#include "log_model.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+// 目录中形如 <16 位十六进制>.txt 的记录文件对应的指纹
+static std::vector<uint64_t> ListConfigs(const std::string& directory) {
+    std::vector<std::string> names = ListDirectory(directory);
+    std::vector<uint64_t> hashes;
+    for (const std::string& name : names) {
+        unsigned long long hash = 0;
+        if (name.size() == 20 && name.compare(16, 4, ".txt") == 0 &&
+            name.find_first_not_of("0123456789abcdef") == 16 && sscanf(name.c_str(), "%16llx", &hash) == 1) {
+            hashes.push_back(hash);
+        }
+    }
+    return hashes;
+}
+
+static bool ParseRecord(const std::string& line, LoadTestRecord* record) {
+    size_t pos = 0;
+    bool hasHash = false;
+    while (pos < line.size()) {
+        size_t end = line.find('\t', pos);
+        if (end == std::string::npos) end = line.size();
+        std::string field = line.substr(pos, end - pos);
+        pos = end + 1;
+        size_t equals = field.find('=');
+        if (equals == std::string::npos) continue;
+        std::string key = field.substr(0, equals);
+        const char* value = field.c_str() + equals + 1;
+        if (key == "config") {
+            record->configHash = strtoull(value, nullptr, 16);
+            hasHash = true;
+        } else if (key == "time") {
+            record->timeSeconds = strtoll(value, nullptr, 10);
+        } else if (key == "target") {
+            record->target = value;
+        } else if (key == "connections") {
+            record->connections = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (key == "threads") {
+            record->threads = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (key == "rate") {
+            record->requestsPerSec = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (key == "duration_ms") {
+            record->durationMs = (uint32_t)strtoul(value, nullptr, 10);
+        } else if (key == "requests") {
+            record->requests = strtoull(value, nullptr, 10);
+        } else if (key == "rps") {
+            record->throughput = strtod(value, nullptr);
+        } else if (key == "p50_us") {
+            record->p50 = strtoull(value, nullptr, 10);
+        } else if (key == "p90_us") {
+            record->p90 = strtoull(value, nullptr, 10);
+        } else if (key == "p99_us") {
+            record->p99 = strtoull(value, nullptr, 10);
+        } else if (key == "p999_us") {
+            record->p999 = strtoull(value, nullptr, 10);
+        } else if (key == "max_us") {
+            record->max = strtoull(value, nullptr, 10);
+        } else if (key == "mean_us") {
+            record->mean = strtod(value, nullptr);
+        } else if (key == "errors") {
+            record->errors = strtoull(value, nullptr, 10);
+        } else if (key == "non2xx") {
+            record->non2xx = strtoull(value, nullptr, 10);
+        }
+    }
+    return hasHash;
+}
+
+LoadTestRecord MakeLoadTestRecord(uint64_t configHash, const LoadTestOptions& options, const LoadTestResult& result) {
+    LoadTestRecord record;
+    record.configHash = configHash;
+    record.timeSeconds = UtcTimeMicros() / 1000000;
+    record.target = options.host + ":" + std::to_string(options.port) + options.path;
+    record.connections = options.connections;
+    record.threads = options.threads;
+    record.requestsPerSec = options.requestsPerSec;
+    record.durationMs = (uint32_t)(result.measuredMicros / 1000);
+    record.requests = result.requests;
+    record.throughput = result.RequestsPerSec();
+    record.p50 = result.latency.ValueAtPercentile(50);
+    record.p90 = result.latency.ValueAtPercentile(90);
+    record.p99 = result.latency.ValueAtPercentile(99);
+    record.p999 = result.latency.ValueAtPercentile(99.9);
+    record.max = result.latency.Max();
+    record.mean = result.latency.Mean();
+    record.errors = result.Errors();
+    record.non2xx = result.requests - result.statusClasses[2];
+    return record;
+}
+
+std::string FormatConfigHash(uint64_t hash) {
+    char text[20];
+    snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+    return text;
+}
+
+bool LoadTestHistory::Append(const LoadTestRecord& record, std::string* error) {
+    if (!MakeDirectory(m_directory)) {
+        if (error) *error = "无法创建目录 " + m_directory;
+        return false;
+    }
+    std::string path = m_directory + "/" + FormatConfigHash(record.configHash) + ".txt";
+    char line[768];
+    snprintf(line, sizeof(line),
+             "config=%s\ttime=%lld\ttarget=%s\tconnections=%u\tthreads=%u\trate=%u\tduration_ms=%u\trequests=%llu\t"
+             "rps=%.1f\tp50_us=%llu\tp90_us=%llu\tp99_us=%llu\tp999_us=%llu\tmax_us=%llu\tmean_us=%.1f\t"
+             "errors=%llu\tnon2xx=%llu\n",
+             FormatConfigHash(record.configHash).c_str(), (long long)record.timeSeconds, record.target.c_str(),
+             record.connections, record.threads, record.requestsPerSec, record.durationMs,
+             (unsigned long long)record.requests, record.throughput, (unsigned long long)record.p50,
+             (unsigned long long)record.p90, (unsigned long long)record.p99, (unsigned long long)record.p999,
+             (unsigned long long)record.max, record.mean, (unsigned long long)record.errors,
+             (unsigned long long)record.non2xx);
+    FILE* file = OpenFile(path, "ab");
+    if (!file) {
+        if (error) *error = "无法写入 " + path;
+        return false;
+    }
+    bool ok = fputs(line, file) >= 0;
+    ok = fclose(file) == 0 && ok;
+    if (!ok && error) *error = "写入 " + path + " 失败";
+    return ok;
+}
+
+std::vector<LoadTestRecord> LoadTestHistory::Load(uint64_t configHash) const {
+    std::vector<LoadTestRecord> records;
+    FILE* file = OpenFile(m_directory + "/" + FormatConfigHash(configHash) + ".txt", "rb");
+    if (!file) return records;
+    std::string line;
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        line += buffer;
+        if (line.empty() || line.back() != '\n') continue;
+        line.pop_back();
+        LoadTestRecord record;
+        if (ParseRecord(line, &record)) records.push_back(record);
+        line.clear();
+    }
+    fclose(file);
+    std::stable_sort(records.begin(), records.end(), [](const LoadTestRecord& a, const LoadTestRecord& b) {
+        return a.timeSeconds < b.timeSeconds;
+    });
+    return records;
+}
+
+std::vector<LoadTestRecord> LoadTestHistory::Latest() const {
+    std::vector<LoadTestRecord> latest;
+    for (uint64_t hash : ListConfigs(m_directory)) {
+        std::vector<LoadTestRecord> records = Load(hash);
+        if (!records.empty()) latest.push_back(records.back());
+    }
+    std::sort(latest.begin(), latest.end(), [](const LoadTestRecord& a, const LoadTestRecord& b) {
+        return a.timeSeconds > b.timeSeconds;
+    });
+    return latest;
+}
+
+bool LoadTestHistory::Find(const std::string& key, LoadTestRecord* record, std::string* error) const {
+    std::vector<LoadTestRecord> latest = Latest();
+    if (key.empty() || key[0] == '~') {
+        size_t rank = key.empty() ? 0 : (size_t)strtoul(key.c_str() + 1, nullptr, 10);
+        if (rank >= latest.size()) {
+            if (error) *error = latest.empty() ? "还没有压测记录" : "压测记录只有 " + std::to_string(latest.size()) + " 份配置";
+            return false;
+        }
+        *record = latest[rank];
+        return true;
+    }
+    if (key.size() < 4) {
+        if (error) *error = "配置指纹至少需要 4 位: " + key;
+        return false;
+    }
+    const LoadTestRecord* found = nullptr;
+    for (const LoadTestRecord& candidate : latest) {
+        if (FormatConfigHash(candidate.configHash).compare(0, key.size(), key) != 0) continue;
+        if (found) {
+            if (error) *error = "指纹前缀 " + key + " 对应多份配置";
+            return false;
+        }
+        found = &candidate;
+    }
+    if (!found) {
+        if (error) *error = "没有配置指纹为 " + key + " 的压测记录";
+        return false;
+    }
+    *record = *found;
+    return true;
+}
+
+static std::string FormatLocalTime(int64_t utcSeconds) {
+    time_t seconds = (time_t)(utcSeconds + LocalOffsetMicros() / 1000000);
+    struct tm parts;
+#ifdef _WIN32
+    gmtime_s(&parts, &seconds);
+#else
+    gmtime_r(&seconds, &parts);
+#endif
+    char text[64];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d", parts.tm_year + 1900, parts.tm_mon + 1,
+             parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec);
+    return text;
+}
+
+std::string FormatLoadTestRecord(const LoadTestRecord& record) {
+    char text[384];
+    snprintf(text, sizeof(text),
+             "%s  %s  %s  %u 连接%s  %.0f req/s  p50 %.2fms p99 %.2fms p99.9 %.2fms max %.2fms  错误 %llu",
+             FormatConfigHash(record.configHash).c_str(), FormatLocalTime(record.timeSeconds).c_str(),
+             record.target.c_str(), record.connections,
+             record.requestsPerSec ? (" 限速 " + std::to_string(record.requestsPerSec) + "/s").c_str() : "",
+             record.throughput, record.p50 / 1000.0, record.p99 / 1000.0, record.p999 / 1000.0, record.max / 1000.0,
+             (unsigned long long)record.errors);
+    return text;
+}
+
+// 按终端显示宽度右侧补空格：三字节及以上的 UTF-8 字符（中文）占两列
+static std::string PadRight(const std::string& text, size_t columns) {
+    size_t width = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char ch = (unsigned char)text[i];
+        if ((ch & 0xC0) == 0x80) continue;
+        width += ch >= 0xE0 ? 2 : 1;
+    }
+    return width >= columns ? text + " " : text + std::string(columns - width, ' ');
+}
+
+std::string FormatLoadTestComparison(const LoadTestRecord& base, const LoadTestRecord& other) {
+    std::string out;
+    auto row = [&out](const std::string& label, const std::string& left, const std::string& right,
+                      const std::string& change) {
+        out += PadRight(label, 14) + PadRight(left, 22) + PadRight(right, 22) + change + "\n";
+    };
+    // 吞吐越高越好，延迟与错误越低越好；变化为右列相对左列
+    auto change = [](double left, double right) -> std::string {
+        if (left <= 0) return right > 0 ? "新增" : "";
+        char text[32];
+        snprintf(text, sizeof(text), "%+.1f%%", (right - left) * 100.0 / left);
+        return text;
+    };
+    auto millis = [](uint64_t micros) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.3f", micros / 1000.0);
+        return std::string(text);
+    };
+
+    row("配置指纹", FormatConfigHash(base.configHash), FormatConfigHash(other.configHash), "变化");
+    row("时间", FormatLocalTime(base.timeSeconds), FormatLocalTime(other.timeSeconds), "");
+    row("目标", base.target, other.target, "");
+    auto load = [](const LoadTestRecord& record) {
+        std::string text = std::to_string(record.connections) + " 连接";
+        if (record.requestsPerSec) text += " " + std::to_string(record.requestsPerSec) + "/s";
+        return text;
+    };
+    row("负载", load(base), load(other), "");
+    char left[32];
+    char right[32];
+    snprintf(left, sizeof(left), "%.0f", base.throughput);
+    snprintf(right, sizeof(right), "%.0f", other.throughput);
+    row("吞吐 req/s", left, right, change(base.throughput, other.throughput));
+    row("p50 ms", millis(base.p50), millis(other.p50), change((double)base.p50, (double)other.p50));
+    row("p90 ms", millis(base.p90), millis(other.p90), change((double)base.p90, (double)other.p90));
+    row("p99 ms", millis(base.p99), millis(other.p99), change((double)base.p99, (double)other.p99));
+    row("p99.9 ms", millis(base.p999), millis(other.p999), change((double)base.p999, (double)other.p999));
+    row("max ms", millis(base.max), millis(other.max), change((double)base.max, (double)other.max));
+    row("错误", std::to_string(base.errors), std::to_string(other.errors), "");
+    row("非 2xx", std::to_string(base.non2xx), std::to_string(other.non2xx), "");
+    if (base.target != other.target || base.connections != other.connections ||
+        base.requestsPerSec != other.requestsPerSec) {
+        out += "注意: 两次压测的目标或负载参数不同，结果不能直接比较\n";
+    }
+    return out;
+}
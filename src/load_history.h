@@ -0,0 +1,61 @@
+// nginx-manager/src/load_history.h
+// 压测记录 - 按配置指纹分文件保存每次压测的摘要，用于对比两份配置的吞吐与延迟
+
+#ifndef LOAD_HISTORY_H
+#define LOAD_HISTORY_H
+
+#include "load_test.h"
+#include <string>
+#include <vector>
+
+// 一次压测的摘要
+struct LoadTestRecord {
+    uint64_t configHash = 0;         // ConfigFingerprint，nginx 未运行或配置无法解析时为 0
+    int64_t timeSeconds = 0;         // UTC 秒
+    std::string target;              // host:port/path
+    uint32_t connections = 0;
+    uint32_t threads = 0;
+    uint32_t requestsPerSec = 0;     // 目标速率，0 为不限速
+    uint32_t durationMs = 0;
+    uint64_t requests = 0;
+    double throughput = 0;           // 实际完成的请求/秒
+    uint64_t p50 = 0;                // 以下延迟单位均为微秒
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+    double mean = 0;
+    uint64_t errors = 0;
+    uint64_t non2xx = 0;             // 非 2xx 响应（已计入 requests）
+};
+
+LoadTestRecord MakeLoadTestRecord(uint64_t configHash, const LoadTestOptions& options, const LoadTestResult& result);
+
+// 16 位十六进制
+std::string FormatConfigHash(uint64_t hash);
+
+// 压测记录目录：每个配置指纹一个文本文件 <指纹>.txt，每次压测追加一行 "key=value" 以制表符分隔
+class LoadTestHistory {
+public:
+    explicit LoadTestHistory(const std::string& directory) : m_directory(directory) {}
+
+    bool Append(const LoadTestRecord& record, std::string* error);
+
+    // 一份配置的全部记录，按时间先后
+    std::vector<LoadTestRecord> Load(uint64_t configHash) const;
+    // 每份配置最近一次的记录，最新的在前
+    std::vector<LoadTestRecord> Latest() const;
+    // 按指纹前缀（至少 4 位）查找最近一次的记录；前缀为空时取所有配置中最近的一次，"~1" 取次近的一份配置
+    bool Find(const std::string& key, LoadTestRecord* record, std::string* error) const;
+
+private:
+    std::string m_directory;
+};
+
+// 一条记录的单行摘要
+std::string FormatLoadTestRecord(const LoadTestRecord& record);
+
+// 两份配置并排对比（多行，UTF-8），右列附相对左列的变化百分比
+std::string FormatLoadTestComparison(const LoadTestRecord& base, const LoadTestRecord& other);
+
+#endif // LOAD_HISTORY_H
@@ -0,0 +1,869 @@
+// nginx-manager/src/load_test.cpp
+// 压测 - 事件驱动的 HTTP/1.1 长连接负载生成器 (epoll / IOCP)，延迟记入 HDR 直方图，只允许本机地址
+
+#include "load_test.h"
+#include "http_client.h"
+#include "socket_util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+static const size_t kRecvBufferSize = 64 * 1024;
+static const size_t kMaxHeadBytes = 64 * 1024;
+static const size_t kMaxLineBytes = 4096;
+// 重新建立连接失败后的重试间隔
+static const uint64_t kRetryMicros = 100000;
+// 检查超时与重连的间隔
+static const uint64_t kMaintenanceMicros = 20000;
+#ifdef _WIN32
+// 限速模式下距下一个请求不到这么久时不再进入等待而是轮询：Windows 默认计时器精度约 15.6ms
+static const uint64_t kSpinMicros = 16000;
+#else
+static const uint64_t kSpinMicros = 1000;
+#endif
+
+// ---------------------------------------------------------------------------
+// LatencyHistogram
+
+LatencyHistogram::LatencyHistogram()
+    : m_counts(((size_t)2 << (kSubBucketBits - 1)) + kMagnitudes * ((size_t)1 << (kSubBucketBits - 1)), 0) {
+}
+
+// 小于 2^11 的值直接作为下标；更大的值按最高位所在的量级 m 右移 m 位，落在 [1024, 2048) 内
+size_t LatencyHistogram::IndexOf(uint64_t value) {
+    const uint64_t linear = 1ull << kSubBucketBits;
+    const uint64_t half = linear >> 1;
+    if (value < linear) return (size_t)value;
+    unsigned width = 0;
+    for (uint64_t v = value; v; v >>= 1) ++width;
+    unsigned magnitude = width - kSubBucketBits;
+    if (magnitude > kMagnitudes) return (size_t)(linear + kMagnitudes * half - 1);
+    return (size_t)(linear + (magnitude - 1) * half + ((value >> magnitude) - half));
+}
+
+uint64_t LatencyHistogram::HighestEquivalent(size_t index) {
+    const uint64_t linear = 1ull << kSubBucketBits;
+    const uint64_t half = linear >> 1;
+    if (index < linear) return index;
+    unsigned magnitude = (unsigned)((index - linear) / half) + 1;
+    uint64_t sub = (index - linear) % half + half;
+    return ((sub + 1) << magnitude) - 1;
+}
+
+void LatencyHistogram::Record(uint64_t micros) {
+    m_counts[IndexOf(micros)]++;
+    if (m_count == 0 || micros < m_min) m_min = micros;
+    if (micros > m_max) m_max = micros;
+    m_count++;
+    m_sum += micros;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+    if (other.m_count == 0) return;
+    for (size_t i = 0; i < m_counts.size(); ++i) m_counts[i] += other.m_counts[i];
+    if (m_count == 0 || other.m_min < m_min) m_min = other.m_min;
+    if (other.m_max > m_max) m_max = other.m_max;
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+}
+
+void LatencyHistogram::Reset() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_count = 0;
+    m_sum = 0;
+    m_min = 0;
+    m_max = 0;
+}
+
+uint64_t LatencyHistogram::ValueAtPercentile(double percentile) const {
+    if (m_count == 0) return 0;
+    if (percentile >= 100) return m_max;
+    uint64_t target = (uint64_t)(percentile / 100.0 * (double)m_count + 0.5);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < m_counts.size(); ++i) {
+        seen += m_counts[i];
+        if (seen >= target) return std::min(HighestEquivalent(i), m_max);
+    }
+    return m_max;
+}
+
+// ---------------------------------------------------------------------------
+// 目标地址
+
+bool IsLoopbackHost(const std::string& host) {
+    if (host.empty() || !InitSockets()) return false;
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = NULL;
+    if (getaddrinfo(host.c_str(), NULL, &hints, &result) != 0 || !result) return false;
+    bool loopback = true;
+    for (addrinfo* entry = result; entry; entry = entry->ai_next) {
+        if (entry->ai_family == AF_INET) {
+            const uint8_t* bytes = (const uint8_t*)&((const sockaddr_in*)entry->ai_addr)->sin_addr;
+            if (bytes[0] != 127) loopback = false;
+        } else if (entry->ai_family == AF_INET6) {
+            const uint8_t* bytes = (const uint8_t*)&((const sockaddr_in6*)entry->ai_addr)->sin6_addr;
+            static const uint8_t kLoopback6[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+            static const uint8_t kMapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF };
+            bool mapped = memcmp(bytes, kMapped, 12) == 0 && bytes[12] == 127;
+            if (memcmp(bytes, kLoopback6, 16) != 0 && !mapped) loopback = false;
+        } else {
+            loopback = false;
+        }
+    }
+    freeaddrinfo(result);
+    return loopback;
+}
+
+bool FindLoadTestTarget(const NginxConfig& config, LoadTestOptions* options, std::string* error) {
+    std::string remoteHost;          // 第一个监听非回环地址的 server，全部不可用时用于提示
+    for (uint32_t server : config.FindByName("server")) {
+        const ConfDirective& directive = config.At(server);
+        // 只看 http 中的 server，stream / mail 中的同名块跳过
+        if (!directive.isBlock || directive.parent == NginxConfig::kNoDirective ||
+            config.At(directive.parent).name != "http") {
+            continue;
+        }
+
+        ListenEndpoint listen;
+        if (!FindPlainListen(config, server, &listen)) continue;
+        std::string host = listen.host.empty() ? "127.0.0.1" : listen.host;
+        if (!IsLoopbackHost(host)) {
+            if (remoteHost.empty()) remoteHost = host;
+            continue;
+        }
+        options->host = host;
+        options->port = listen.port;
+        options->hostHeader = ServerHostName(config, server);
+        return true;
+    }
+    if (error) {
+        if (!remoteHost.empty()) {
+            *error = "监听地址 " + remoteHost + " 不是本机回环地址，压测只允许访问本机";
+        } else {
+            *error = "配置中没有可用于压测的 http server (需要一个非 ssl 的 listen)";
+        }
+    }
+    return false;
+}
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// 响应解析
+
+// 增量解析一个响应：状态行与头部，Content-Length / chunked / 读到连接关闭三种响应体
+// 响应体只计字节数，不保存
+class ResponseParser {
+public:
+    enum Result { NEED_MORE, COMPLETE, MALFORMED };
+
+    void Reset() {
+        m_state = STATE_HEAD;
+        m_head.clear();
+        m_line.clear();
+        m_remaining = 0;
+        m_status = 0;
+        m_keepAlive = true;
+        m_bodyBytes = 0;
+        m_received = 0;
+    }
+
+    Result Feed(const char* data, size_t size);
+    // 连接已关闭：只有 "读到关闭" 的响应体可以就此完成
+    Result Finish() {
+        if (m_state != STATE_UNTIL_CLOSE) return MALFORMED;
+        m_state = STATE_DONE;
+        return COMPLETE;
+    }
+
+    int Status() const { return m_status; }
+    bool KeepAlive() const { return m_keepAlive; }
+    uint64_t BodyBytes() const { return m_bodyBytes; }
+    bool Started() const { return m_received > 0; }
+
+private:
+    enum State {
+        STATE_HEAD, STATE_LENGTH, STATE_CHUNK_SIZE, STATE_CHUNK_DATA, STATE_CHUNK_END, STATE_TRAILERS,
+        STATE_UNTIL_CLOSE, STATE_DONE
+    };
+
+    Result ParseHead();
+    // 累积一行（不含 CRLF），读到换行时返回 true
+    bool ReadLine(const char** cursor, const char* end);
+
+    State m_state = STATE_HEAD;
+    std::string m_head;
+    std::string m_line;
+    uint64_t m_remaining = 0;
+    int m_status = 0;
+    bool m_keepAlive = true;
+    uint64_t m_bodyBytes = 0;
+    uint64_t m_received = 0;
+};
+
+bool ResponseParser::ReadLine(const char** cursor, const char* end) {
+    const char* p = *cursor;
+    const char* newline = (const char*)memchr(p, '\n', (size_t)(end - p));
+    if (!newline) {
+        m_line.append(p, (size_t)(end - p));
+        *cursor = end;
+        return false;
+    }
+    m_line.append(p, (size_t)(newline - p));
+    if (!m_line.empty() && m_line.back() == '\r') m_line.pop_back();
+    *cursor = newline + 1;
+    return true;
+}
+
+ResponseParser::Result ResponseParser::ParseHead() {
+    std::string_view head(m_head);
+    // HTTP/1.x 状态码
+    if (head.size() < 12 || head.compare(0, 7, "HTTP/1.") != 0 || head[8] != ' ') return MALFORMED;
+    if (head[9] < '1' || head[9] > '5' || head[10] < '0' || head[10] > '9' || head[11] < '0' || head[11] > '9') {
+        return MALFORMED;
+    }
+    m_status = (head[9] - '0') * 100 + (head[10] - '0') * 10 + (head[11] - '0');
+    m_keepAlive = head[7] != '0';
+
+    bool chunked = false;
+    bool hasLength = false;
+    uint64_t length = 0;
+    size_t pos = head.find("\r\n") + 2;
+    while (pos < head.size()) {
+        size_t lineEnd = head.find("\r\n", pos);
+        if (lineEnd == std::string_view::npos || lineEnd == pos) break;
+        std::string_view line = head.substr(pos, lineEnd - pos);
+        pos = lineEnd + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && (value[0] == ' ' || value[0] == '\t')) value.remove_prefix(1);
+        if (EqualsIgnoreCase(name.data(), name.size(), "content-length")) {
+            length = 0;
+            for (char ch : value) {
+                if (ch < '0' || ch > '9') break;
+                length = length * 10 + (uint64_t)(ch - '0');
+            }
+            hasLength = true;
+        } else if (EqualsIgnoreCase(name.data(), name.size(), "transfer-encoding")) {
+            chunked = ContainsIgnoreCase(value, "chunked");
+        } else if (EqualsIgnoreCase(name.data(), name.size(), "connection")) {
+            if (ContainsIgnoreCase(value, "close")) m_keepAlive = false;
+            if (ContainsIgnoreCase(value, "keep-alive")) m_keepAlive = true;
+        }
+    }
+
+    if (m_status < 200 || m_status == 204 || m_status == 304) {
+        m_state = STATE_DONE;
+    } else if (chunked) {
+        m_state = STATE_CHUNK_SIZE;
+    } else if (hasLength) {
+        m_remaining = length;
+        m_state = length ? STATE_LENGTH : STATE_DONE;
+    } else {
+        m_state = STATE_UNTIL_CLOSE;
+        m_keepAlive = false;
+    }
+    return m_state == STATE_DONE ? COMPLETE : NEED_MORE;
+}
+
+ResponseParser::Result ResponseParser::Feed(const char* data, size_t size) {
+    m_received += size;
+    const char* p = data;
+    const char* end = data + size;
+    while (p < end) {
+        switch (m_state) {
+            case STATE_HEAD: {
+                // 头部通常在一次接收中到齐
+                size_t before = m_head.size();
+                m_head.append(p, (size_t)(end - p));
+                size_t found = m_head.find("\r\n\r\n", before >= 3 ? before - 3 : 0);
+                if (found == std::string::npos) return m_head.size() > kMaxHeadBytes ? MALFORMED : NEED_MORE;
+                size_t headEnd = found + 4;
+                p = end - (m_head.size() - headEnd);
+                m_head.resize(headEnd);
+                Result result = ParseHead();
+                if (result != NEED_MORE) return result;
+                break;
+            }
+            case STATE_LENGTH: {
+                size_t n = (size_t)std::min<uint64_t>((uint64_t)(end - p), m_remaining);
+                p += n;
+                m_remaining -= n;
+                m_bodyBytes += n;
+                if (m_remaining == 0) m_state = STATE_DONE;
+                break;
+            }
+            case STATE_CHUNK_SIZE: {
+                if (!ReadLine(&p, end)) return m_line.size() > kMaxLineBytes ? MALFORMED : NEED_MORE;
+                uint64_t chunk = 0;
+                size_t digits = 0;
+                for (char ch : m_line) {
+                    int digit = ch >= '0' && ch <= '9' ? ch - '0' : ch >= 'a' && ch <= 'f' ? ch - 'a' + 10
+                                : ch >= 'A' && ch <= 'F' ? ch - 'A' + 10 : -1;
+                    if (digit < 0) break;
+                    chunk = chunk * 16 + (uint64_t)digit;
+                    ++digits;
+                }
+                m_line.clear();
+                if (digits == 0 || digits > 15) return MALFORMED;
+                m_remaining = chunk;
+                m_state = chunk ? STATE_CHUNK_DATA : STATE_TRAILERS;
+                break;
+            }
+            case STATE_CHUNK_DATA: {
+                size_t n = (size_t)std::min<uint64_t>((uint64_t)(end - p), m_remaining);
+                p += n;
+                m_remaining -= n;
+                m_bodyBytes += n;
+                if (m_remaining == 0) m_state = STATE_CHUNK_END;
+                break;
+            }
+            case STATE_CHUNK_END:
+                if (!ReadLine(&p, end)) return m_line.size() > 2 ? MALFORMED : NEED_MORE;
+                if (!m_line.empty()) return MALFORMED;
+                m_state = STATE_CHUNK_SIZE;
+                break;
+            case STATE_TRAILERS:
+                if (!ReadLine(&p, end)) return m_line.size() > kMaxLineBytes ? MALFORMED : NEED_MORE;
+                if (m_line.empty()) m_state = STATE_DONE;
+                m_line.clear();
+                break;
+            case STATE_UNTIL_CLOSE:
+                m_bodyBytes += (uint64_t)(end - p);
+                p = end;
+                break;
+            case STATE_DONE:
+                // 没有流水线请求，多余的数据直接丢弃
+                return COMPLETE;
+        }
+    }
+    return m_state == STATE_DONE ? COMPLETE : NEED_MORE;
+}
+
+// ---------------------------------------------------------------------------
+// 事件循环
+
+#ifdef _WIN32
+// 一个连接上的重叠接收；连接关闭时若接收尚未完成，由完成包到达时释放
+struct RecvOp {
+    OVERLAPPED overlapped;
+    WSABUF buffer;
+    size_t connection = 0;
+    bool pending = false;
+    bool orphaned = false;
+    char data[kRecvBufferSize];
+};
+#endif
+
+struct Connection {
+    SocketHandle socket = kInvalidSocket;
+    bool busy = false;               // 有请求在等待响应
+    bool reused = false;             // 已在这个连接上完成过请求
+    uint64_t intendedMicros = 0;     // 当前请求应当发出的时刻
+    uint64_t deadline = 0;
+    uint64_t retryAt = 0;            // 连接失败后下一次重试的时刻
+    ResponseParser parser;
+#ifdef _WIN32
+    RecvOp* recv = nullptr;
+#endif
+};
+
+// 一个事件循环线程：负责一组连接，结果只在本线程内累计，结束后由调用方合并
+class LoadWorker {
+public:
+    LoadWorker(const LoadTestOptions& options, uint32_t connections, double intervalMicros,
+               const std::atomic<bool>* cancel)
+        : m_options(options),
+          m_connections(connections),
+          m_intervalMicros(intervalMicros),
+          m_cancel(cancel) {
+        m_request = "GET " + options.path + " HTTP/1.1\r\nHost: " +
+                    (options.hostHeader.empty() ? options.host : options.hostHeader) +
+                    "\r\nUser-Agent: nginx-manager-loadtest\r\nAccept: */*\r\n\r\n";
+    }
+
+    ~LoadWorker() { Close(); }
+
+    // 建立全部连接；一个都连不上时返回 false
+    bool Open(std::string* error);
+    // 所有线程的连接都建立后再确定时间表，建连的耗时不计入压测
+    void Schedule(double firstSend, uint64_t measureBegin, uint64_t measureEnd) {
+        m_nextSend = firstSend;
+        m_measureBegin = measureBegin;
+        m_measureEnd = measureEnd;
+        m_stopSending = measureEnd;
+    }
+    void Run();
+
+    LoadTestResult& Result() { return m_result; }
+    uint64_t StoppedMicros() const { return m_stoppedMicros; }
+
+private:
+    void Close();
+    bool Connect(size_t index, std::string* error);
+    void Disconnect(size_t index);
+    bool Send(size_t index, uint64_t intended, uint64_t now);
+    bool Arm(size_t index);
+    void Wait(uint64_t timeoutMicros);
+    void OnData(size_t index, const char* data, size_t size);
+    void OnClosed(size_t index, bool failed);
+    void Complete(size_t index);
+    void Fail(size_t index, uint64_t* counter);
+    void Dispatch(uint64_t now);
+    void Maintain(uint64_t now);
+    bool Counted(uint64_t intended) const { return intended >= m_measureBegin && intended < m_stopSending; }
+
+    const LoadTestOptions& m_options;
+    std::vector<Connection> m_connections;
+    std::vector<size_t> m_idle;      // 已连接且空闲的连接
+    std::string m_request;
+    double m_intervalMicros;         // 0 表示不限速
+    double m_nextSend = 0;
+    uint64_t m_measureBegin = 0;
+    uint64_t m_measureEnd = 0;
+    uint64_t m_stopSending = 0;      // 不再发出新请求的时刻（提前取消时早于 m_measureEnd）
+    uint64_t m_stoppedMicros = 0;
+    const std::atomic<bool>* m_cancel;
+    size_t m_busy = 0;
+    LoadTestResult m_result;
+#ifdef _WIN32
+    HANDLE m_port = NULL;
+    size_t m_orphans = 0;            // 连接已关闭、等待完成包的接收
+#else
+    int m_poll = -1;
+    std::vector<char> m_buffer;
+#endif
+};
+
+bool LoadWorker::Open(std::string* error) {
+#ifdef _WIN32
+    m_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!m_port) {
+        if (error) *error = "无法创建完成端口";
+        return false;
+    }
+#else
+    m_poll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_poll < 0) {
+        if (error) *error = std::string("无法创建 epoll: ") + strerror(errno);
+        return false;
+    }
+    m_buffer.resize(kRecvBufferSize);
+#endif
+    size_t connected = 0;
+    std::string lastError;
+    for (size_t i = 0; i < m_connections.size(); ++i) {
+        if (Connect(i, &lastError)) ++connected;
+    }
+    if (connected == 0 && !m_connections.empty()) {
+        if (error) *error = lastError;
+        return false;
+    }
+    return true;
+}
+
+void LoadWorker::Close() {
+    for (size_t i = 0; i < m_connections.size(); ++i) Disconnect(i);
+#ifdef _WIN32
+    if (m_port) {
+        // 关闭套接字会取消未完成的接收，等完成包到齐后才能释放缓冲
+        OVERLAPPED_ENTRY entries[64];
+        uint64_t deadline = MonotonicMicros() + 1000000;
+        while (m_orphans > 0 && MonotonicMicros() < deadline) {
+            ULONG count = 0;
+            if (!GetQueuedCompletionStatusEx(m_port, entries, 64, &count, 100, FALSE)) continue;
+            for (ULONG i = 0; i < count; ++i) {
+                delete CONTAINING_RECORD(entries[i].lpOverlapped, RecvOp, overlapped);
+                --m_orphans;
+            }
+        }
+        CloseHandle(m_port);
+        m_port = NULL;
+    }
+#else
+    if (m_poll >= 0) close(m_poll);
+    m_poll = -1;
+#endif
+}
+
+bool LoadWorker::Connect(size_t index, std::string* error) {
+    Connection& connection = m_connections[index];
+    connection.socket = ConnectTcp(m_options.host, m_options.port, m_options.timeoutMs, error);
+    if (connection.socket == kInvalidSocket) {
+        connection.retryAt = MonotonicMicros() + kRetryMicros;
+        return false;
+    }
+#ifdef _WIN32
+    if (CreateIoCompletionPort((HANDLE)connection.socket, m_port, 0, 0) != m_port) {
+        CloseSocket(connection.socket);
+        connection.socket = kInvalidSocket;
+        connection.retryAt = MonotonicMicros() + kRetryMicros;
+        if (error) *error = "无法关联完成端口";
+        return false;
+    }
+    // 同步完成的接收同样投递完成包，统一在 Wait 中处理
+    connection.recv = new RecvOp();
+    connection.recv->connection = index;
+#else
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = index;
+    if (epoll_ctl(m_poll, EPOLL_CTL_ADD, connection.socket, &event) != 0) {
+        CloseSocket(connection.socket);
+        connection.socket = kInvalidSocket;
+        connection.retryAt = MonotonicMicros() + kRetryMicros;
+        if (error) *error = std::string("epoll_ctl: ") + strerror(errno);
+        return false;
+    }
+#endif
+    connection.reused = false;
+    connection.busy = false;
+    m_idle.push_back(index);
+    return true;
+}
+
+void LoadWorker::Disconnect(size_t index) {
+    Connection& connection = m_connections[index];
+    if (connection.socket == kInvalidSocket) return;
+    if (connection.busy) {
+        connection.busy = false;
+        --m_busy;
+    } else {
+        m_idle.erase(std::remove(m_idle.begin(), m_idle.end(), index), m_idle.end());
+    }
+#ifdef _WIN32
+    if (connection.recv->pending) {
+        connection.recv->orphaned = true;
+        ++m_orphans;
+    } else {
+        delete connection.recv;
+    }
+    connection.recv = nullptr;
+#else
+    epoll_ctl(m_poll, EPOLL_CTL_DEL, connection.socket, NULL);
+#endif
+    CloseSocket(connection.socket);
+    connection.socket = kInvalidSocket;
+}
+
+bool LoadWorker::Send(size_t index, uint64_t intended, uint64_t now) {
+    Connection& connection = m_connections[index];
+    connection.busy = true;
+    connection.intendedMicros = intended;
+    connection.deadline = now + (uint64_t)m_options.timeoutMs * 1000;
+    connection.parser.Reset();
+    ++m_busy;
+
+    // 请求只有几十字节，套接字发送缓冲总能一次放下；放不下时短暂等待
+    size_t sent = 0;
+    while (sent < m_request.size()) {
+#ifdef _WIN32
+        int n = send(connection.socket, m_request.data() + sent, (int)(m_request.size() - sent), 0);
+#else
+        int n = (int)send(connection.socket, m_request.data() + sent, m_request.size() - sent, MSG_NOSIGNAL);
+#endif
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && SocketWouldBlock() && WaitSocket(connection.socket, true, m_options.timeoutMs) > 0) {
+            continue;
+        } else {
+            OnClosed(index, true);
+            return false;
+        }
+    }
+    if (!Arm(index)) {
+        OnClosed(index, true);
+        return false;
+    }
+    return true;
+}
+
+bool LoadWorker::Arm(size_t index) {
+#ifdef _WIN32
+    RecvOp* op = m_connections[index].recv;
+    if (op->pending) return true;
+    memset(&op->overlapped, 0, sizeof(op->overlapped));
+    op->buffer.buf = op->data;
+    op->buffer.len = (ULONG)sizeof(op->data);
+    DWORD flags = 0;
+    if (WSARecv(m_connections[index].socket, &op->buffer, 1, NULL, &flags, &op->overlapped, NULL) == SOCKET_ERROR &&
+        WSAGetLastError() != WSA_IO_PENDING) {
+        return false;
+    }
+    op->pending = true;
+    return true;
+#else
+    // 连接注册时已监听可读事件（水平触发）
+    (void)index;
+    return true;
+#endif
+}
+
+void LoadWorker::Wait(uint64_t timeoutMicros) {
+    int timeoutMs = (int)(timeoutMicros / 1000);
+#ifdef _WIN32
+    OVERLAPPED_ENTRY entries[64];
+    ULONG count = 0;
+    if (!GetQueuedCompletionStatusEx(m_port, entries, 64, &count, (DWORD)timeoutMs, FALSE)) return;
+    for (ULONG i = 0; i < count; ++i) {
+        RecvOp* op = CONTAINING_RECORD(entries[i].lpOverlapped, RecvOp, overlapped);
+        op->pending = false;
+        if (op->orphaned) {
+            delete op;
+            --m_orphans;
+            continue;
+        }
+        size_t index = op->connection;
+        // OVERLAPPED.Internal 为 NTSTATUS，非 0 表示接收失败（连接被重置等）
+        if (entries[i].lpOverlapped->Internal != 0) {
+            OnClosed(index, true);
+        } else if (entries[i].dwNumberOfBytesTransferred == 0) {
+            OnClosed(index, false);
+        } else {
+            OnData(index, op->data, entries[i].dwNumberOfBytesTransferred);
+            Connection& connection = m_connections[index];
+            if (connection.socket != kInvalidSocket && connection.busy && connection.recv == op && !Arm(index)) {
+                OnClosed(index, true);
+            }
+        }
+    }
+#else
+    epoll_event events[64];
+    int count = epoll_wait(m_poll, events, 64, timeoutMs);
+    for (int i = 0; i < count; ++i) {
+        size_t index = (size_t)events[i].data.u64;
+        SocketHandle socket = m_connections[index].socket;
+        // 同一批事件中连接可能已被关闭并重新建立，读新连接最多得到 EAGAIN
+        while (m_connections[index].socket == socket && socket != kInvalidSocket) {
+            ssize_t n = recv(socket, m_buffer.data(), m_buffer.size(), 0);
+            if (n > 0) {
+                OnData(index, m_buffer.data(), (size_t)n);
+                if ((size_t)n < m_buffer.size()) break;
+            } else if (n == 0) {
+                OnClosed(index, false);
+            } else if (errno == EINTR) {
+                continue;
+            } else {
+                if (!SocketWouldBlock()) OnClosed(index, true);
+                break;
+            }
+        }
+    }
+#endif
+}
+
+void LoadWorker::OnData(size_t index, const char* data, size_t size) {
+    Connection& connection = m_connections[index];
+    if (!connection.busy) {
+        // 空闲连接上不应有数据
+        Fail(index, &m_result.readErrors);
+        return;
+    }
+    ResponseParser::Result result = connection.parser.Feed(data, size);
+    if (result == ResponseParser::COMPLETE) {
+        Complete(index);
+    } else if (result == ResponseParser::MALFORMED) {
+        Fail(index, &m_result.readErrors);
+    }
+}
+
+// 连接被对端关闭 (failed 为 false) 或出错
+void LoadWorker::OnClosed(size_t index, bool failed) {
+    Connection& connection = m_connections[index];
+    if (!connection.busy) {
+        // 空闲的长连接被服务端关闭（keepalive_timeout），重新建立即可
+        Disconnect(index);
+        m_result.reconnects++;
+        Connect(index, nullptr);
+        return;
+    }
+    if (!failed && connection.parser.Finish() == ResponseParser::COMPLETE) {
+        Complete(index);
+        return;
+    }
+    if (connection.reused && !connection.parser.Started()) {
+        // 请求发出时服务端恰好关闭了这个长连接：换一个连接重发，延迟仍从原来的时刻算起
+        uint64_t intended = connection.intendedMicros;
+        Disconnect(index);
+        m_result.reconnects++;
+        if (Connect(index, nullptr)) {
+            m_idle.pop_back();
+            Send(index, intended, MonotonicMicros());
+            return;
+        }
+        if (Counted(intended)) m_result.connectErrors++;
+        return;
+    }
+    Fail(index, &m_result.readErrors);
+}
+
+void LoadWorker::Complete(size_t index) {
+    Connection& connection = m_connections[index];
+    uint64_t now = MonotonicMicros();
+    if (Counted(connection.intendedMicros)) {
+        int status = connection.parser.Status();
+        m_result.requests++;
+        m_result.statusClasses[status >= 100 && status < 600 ? status / 100 : 0]++;
+        m_result.bodyBytes += connection.parser.BodyBytes();
+        m_result.latency.Record(now - connection.intendedMicros);
+    }
+    connection.busy = false;
+    connection.reused = true;
+    --m_busy;
+    if (connection.parser.KeepAlive()) {
+        m_idle.push_back(index);
+        return;
+    }
+    Disconnect(index);
+    m_result.reconnects++;
+    Connect(index, nullptr);
+}
+
+void LoadWorker::Fail(size_t index, uint64_t* counter) {
+    Connection& connection = m_connections[index];
+    if (connection.busy && Counted(connection.intendedMicros)) (*counter)++;
+    Disconnect(index);
+    connection.retryAt = MonotonicMicros();
+}
+
+void LoadWorker::Dispatch(uint64_t now) {
+    if (now >= m_stopSending) return;
+    if (m_intervalMicros <= 0) {
+        // 不限速：每个空闲连接立即发出下一个请求
+        while (!m_idle.empty()) {
+            size_t index = m_idle.back();
+            m_idle.pop_back();
+            Send(index, now, now);
+        }
+        return;
+    }
+    // 限速：按计划时刻依次发出，连接全忙时请求排队，计划时刻不变
+    while (m_nextSend <= (double)now && m_nextSend < (double)m_stopSending && !m_idle.empty()) {
+        size_t index = m_idle.back();
+        m_idle.pop_back();
+        uint64_t intended = (uint64_t)m_nextSend;
+        m_nextSend += m_intervalMicros;
+        Send(index, intended, now);
+    }
+    if (m_nextSend <= (double)now) {
+        uint64_t backlog = (uint64_t)(((double)now - m_nextSend) / m_intervalMicros) + 1;
+        if (backlog > m_result.backlogMax) m_result.backlogMax = backlog;
+    }
+}
+
+// 超时的请求记为错误并断开连接；断开的连接到了重试时刻重新建立
+void LoadWorker::Maintain(uint64_t now) {
+    for (size_t i = 0; i < m_connections.size(); ++i) {
+        Connection& connection = m_connections[i];
+        if (connection.busy && now >= connection.deadline) {
+            Fail(i, &m_result.timeouts);
+        }
+        if (connection.socket == kInvalidSocket && now >= connection.retryAt && now < m_stopSending) {
+            if (!Connect(i, nullptr) && now >= m_measureBegin) m_result.connectErrors++;
+        }
+    }
+}
+
+void LoadWorker::Run() {
+    uint64_t nextMaintenance = 0;
+    for (;;) {
+        uint64_t now = MonotonicMicros();
+        if (m_stoppedMicros == 0 && (now >= m_measureEnd || (m_cancel && m_cancel->load()))) {
+            m_stopSending = std::min(now, m_measureEnd);
+            m_stoppedMicros = m_stopSending;
+        }
+        // 停止发送后等待在途请求完成（最长一个超时时长）
+        if (m_stoppedMicros != 0 && m_busy == 0) break;
+        if (now >= nextMaintenance) {
+            Maintain(now);
+            nextMaintenance = now + kMaintenanceMicros;
+        }
+        Dispatch(now);
+
+        uint64_t wait = nextMaintenance > now ? nextMaintenance - now : 0;
+        if (m_intervalMicros > 0 && m_stoppedMicros == 0 && !m_idle.empty()) {
+            uint64_t untilSend = m_nextSend > (double)now ? (uint64_t)(m_nextSend - (double)now) : 0;
+            // 计时器精度不够时改为轮询，否则请求会成批晚发
+            wait = untilSend <= kSpinMicros ? 0 : std::min(wait, untilSend - kSpinMicros);
+        }
+        Wait(wait);
+    }
+}
+
+} // namespace
+
+bool RunLoadTest(const LoadTestOptions& options, const std::atomic<bool>* cancel, LoadTestResult* result,
+                 std::string* error) {
+    if (!IsLoopbackHost(options.host)) {
+        if (error) *error = options.host + " 不是本机回环地址，压测只允许访问本机";
+        return false;
+    }
+    if (options.path.empty() || options.path[0] != '/') {
+        if (error) *error = "请求路径必须以 / 开头";
+        return false;
+    }
+    uint32_t threads = std::max(1u, std::min(options.threads, std::max(1u, options.connections)));
+    uint32_t connections = std::max(options.connections, threads);
+
+    // 每个线程分得一部分连接与速率，各线程的发送时刻错开
+    double interval = options.requestsPerSec ? 1e6 * threads / options.requestsPerSec : 0;
+    std::vector<std::unique_ptr<LoadWorker>> workers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        uint32_t share = connections / threads + (t < connections % threads ? 1 : 0);
+        workers.emplace_back(new LoadWorker(options, share, interval, cancel));
+        if (!workers.back()->Open(error)) return false;
+    }
+    uint64_t start = MonotonicMicros() + 10000;
+    uint64_t measureBegin = start + (uint64_t)options.warmupMs * 1000;
+    uint64_t measureEnd = measureBegin + (uint64_t)options.durationMs * 1000;
+    for (uint32_t t = 0; t < threads; ++t) {
+        workers[t]->Schedule((double)start + interval * t / threads, measureBegin, measureEnd);
+    }
+
+    std::vector<std::thread> running;
+    for (size_t t = 1; t < workers.size(); ++t) running.emplace_back(&LoadWorker::Run, workers[t].get());
+    workers[0]->Run();
+    for (std::thread& thread : running) thread.join();
+
+    *result = LoadTestResult();
+    uint64_t stopped = 0;
+    for (const auto& worker : workers) {
+        const LoadTestResult& part = worker->Result();
+        result->requests += part.requests;
+        for (int i = 0; i < 6; ++i) result->statusClasses[i] += part.statusClasses[i];
+        result->timeouts += part.timeouts;
+        result->connectErrors += part.connectErrors;
+        result->readErrors += part.readErrors;
+        result->reconnects += part.reconnects;
+        result->bodyBytes += part.bodyBytes;
+        result->backlogMax = std::max(result->backlogMax, part.backlogMax);
+        result->latency.Merge(part.latency);
+        stopped = std::max(stopped, worker->StoppedMicros());
+    }
+    result->measuredMicros = stopped > measureBegin ? stopped - measureBegin : 0;
+    return true;
+}
+
+std::string FormatLoadTestSummary(const LoadTestResult& result) {
+    const LatencyHistogram& latency = result.latency;
+    char text[256];
+    snprintf(text, sizeof(text), "%.0f req/s, p50 %.2fms p99 %.2fms p99.9 %.2fms max %.2fms, 错误 %llu",
+             result.RequestsPerSec(), latency.ValueAtPercentile(50) / 1000.0, latency.ValueAtPercentile(99) / 1000.0,
+             latency.ValueAtPercentile(99.9) / 1000.0, latency.Max() / 1000.0, (unsigned long long)result.Errors());
+    return text;
+}
@@ -0,0 +1,88 @@
+// nginx-manager/src/load_test.h
+// 压测 - 事件驱动的 HTTP/1.1 长连接负载生成器 (epoll / IOCP)，延迟记入 HDR 直方图，只允许本机地址
+
+#ifndef LOAD_TEST_H
+#define LOAD_TEST_H
+
+#include "nginx_conf.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// 延迟直方图（HDR 风格的对数-线性分桶，单位微秒）
+// 小于 2048 的值每个一桶；更大的值每翻一倍再分 1024 桶，相对误差不超过 0.1%。
+// 可记录到约 2^38 微秒（3 天），更大的值计入最后一桶；内存固定为约 230KB。
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void Record(uint64_t micros);
+    void Merge(const LatencyHistogram& other);
+    void Reset();
+
+    uint64_t Count() const { return m_count; }
+    uint64_t Min() const { return m_count ? m_min : 0; }
+    uint64_t Max() const { return m_max; }
+    double Mean() const { return m_count ? (double)m_sum / m_count : 0; }
+    // percentile 取 0~100；返回所在桶的上界（不超过 Max）
+    uint64_t ValueAtPercentile(double percentile) const;
+
+private:
+    static const unsigned kSubBucketBits = 11;
+    static const size_t kMagnitudes = 27;
+
+    static size_t IndexOf(uint64_t value);
+    static uint64_t HighestEquivalent(size_t index);
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = 0;
+    uint64_t m_max = 0;
+};
+
+struct LoadTestOptions {
+    std::string host = "127.0.0.1"; // 只能是本机地址
+    uint16_t port = 80;
+    std::string hostHeader;          // 为空时使用 host
+    std::string path = "/";
+    uint32_t connections = 16;       // 长连接总数，平均分给各线程
+    uint32_t threads = 1;            // 事件循环线程数
+    uint32_t requestsPerSec = 0;     // 目标速率；0 表示不限速，每个连接收到响应后立即发下一个请求
+    uint32_t durationMs = 10000;     // 计入结果的时长（不含预热）
+    uint32_t warmupMs = 1000;        // 预热期间的请求不计入结果
+    uint32_t timeoutMs = 5000;       // 单个请求的超时
+};
+
+struct LoadTestResult {
+    uint64_t requests = 0;           // 计入结果的完成请求（含非 2xx 响应）
+    uint64_t statusClasses[6] = {};  // 按状态码首位计数，0 为无法识别
+    uint64_t timeouts = 0;
+    uint64_t connectErrors = 0;
+    uint64_t readErrors = 0;         // 连接被重置、响应格式错误等
+    uint64_t reconnects = 0;         // 服务端关闭长连接后重新建立（不算错误）
+    uint64_t bodyBytes = 0;
+    uint64_t measuredMicros = 0;     // 实际计入结果的时长
+    uint64_t backlogMax = 0;         // 限速模式下排队等待空闲连接的最大请求数
+    LatencyHistogram latency;
+
+    uint64_t Errors() const { return timeouts + connectErrors + readErrors; }
+    double RequestsPerSec() const { return measuredMicros ? requests * 1e6 / measuredMicros : 0; }
+};
+
+// 是否为本机回环地址（127.0.0.0/8、::1、localhost）；按解析结果判断，所有地址都必须是回环地址
+bool IsLoopbackHost(const std::string& host);
+
+// 在配置中选择压测目标：第一个非 ssl 的 server 的 listen 地址（通配地址换成 127.0.0.1）与 server_name，
+// 监听地址不是本机回环地址时返回 false
+bool FindLoadTestTarget(const NginxConfig& config, LoadTestOptions* options, std::string* error);
+
+// 运行一次压测，阻塞到结束；cancel 置位时提前结束（已完成的部分仍写入 result）
+// 限速模式下延迟从请求 "应当发出" 的时刻算起，连接全忙时排队的时间也计入延迟，避免协同遗漏
+bool RunLoadTest(const LoadTestOptions& options, const std::atomic<bool>* cancel, LoadTestResult* result,
+                 std::string* error);
+
+// 结果摘要，如 "12034 req/s, p50 0.41ms p99 1.20ms p99.9 3.10ms max 8.02ms, 错误 0"
+std::string FormatLoadTestSummary(const LoadTestResult& result);
+
+#endif // LOAD_TEST_H
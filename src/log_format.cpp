@@ -0,0 +1,490 @@
+// nginx-manager/src/log_format.cpp
+// 日志格式 - 把 log_format 指令编译成专用的行解析程序：按字面分隔符定位字段，数字与时间就地换算，字段不复制
+
+#include "log_format.h"
+#include "nginx_conf.h"
+
+#include <cstring>
+
+// nginx 内置的 combined 格式
+static const char* const kCombinedFormat =
+    "$remote_addr - $remote_user [$time_local] \"$request\" $status $body_bytes_sent \"$http_referer\" "
+    "\"$http_user_agent\"";
+
+// 每一步的取值方式
+enum StepOp : uint8_t {
+    OP_END,                          // 只有字面文本，之后应当是行尾
+    OP_STOP,                         // 只有字面文本，之后的字段都不需要
+    OP_TEXT,                         // 跳过到下一段字面文本
+    OP_NUMBER,                       // 跳过数字（之后紧跟另一个变量时使用）
+    OP_TIME_LOCAL,                   // 定长 26 字节
+    OP_TIME_ISO8601,                 // 定长 25 字节
+    OP_MSEC,
+    OP_REQUEST,                      // "GET /path?query HTTP/1.1"
+    OP_METHOD,
+    OP_URI,
+    OP_REQUEST_URI,                  // 带查询串的路径
+    OP_HOST,
+    OP_STATUS,
+    OP_BYTES,
+    OP_REQUEST_TIME
+};
+
+static inline bool IsDigit(char ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+static inline int TwoDigits(const char* p) {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+static int MonthIndex(const char* p) {
+    switch (p[0]) {
+    case 'J': return p[1] == 'a' ? 1 : (p[2] == 'n' ? 6 : 7);
+    case 'F': return 2;
+    case 'M': return p[2] == 'r' ? 3 : 5;
+    case 'A': return p[1] == 'p' ? 4 : 8;
+    case 'S': return 9;
+    case 'O': return 10;
+    case 'N': return 11;
+    case 'D': return 12;
+    default: return 0;
+    }
+}
+
+// 公历日期到 1970-01-01 起的天数
+static int64_t DaysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;
+    int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// "10/Oct/2000:13:55:36 -0700" 换算为 UTC 秒
+static bool ParseTimeLocal(const char* p, int64_t* second) {
+    if (p[2] != '/' || p[6] != '/' || p[11] != ':' || p[14] != ':' || p[17] != ':' || p[20] != ' ') return false;
+    int month = MonthIndex(p + 3);
+    if (month == 0) return false;
+    int day = TwoDigits(p);
+    int year = TwoDigits(p + 7) * 100 + TwoDigits(p + 9);
+    int hour = TwoDigits(p + 12);
+    int minute = TwoDigits(p + 15);
+    int sec = TwoDigits(p + 18);
+    int offset = TwoDigits(p + 22) * 3600 + TwoDigits(p + 24) * 60;
+    if (p[21] == '-') offset = -offset;
+    *second = DaysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + sec - offset;
+    return true;
+}
+
+// "2000-10-10T13:55:36-07:00" 换算为 UTC 秒
+static bool ParseTimeIso8601(const char* p, int64_t* second) {
+    if (p[4] != '-' || p[7] != '-' || p[10] != 'T' || p[13] != ':' || p[16] != ':' || p[22] != ':' ||
+        (p[19] != '+' && p[19] != '-')) {
+        return false;
+    }
+    int year = TwoDigits(p) * 100 + TwoDigits(p + 2);
+    int month = TwoDigits(p + 5);
+    if (month < 1 || month > 12) return false;
+    int offset = TwoDigits(p + 20) * 3600 + TwoDigits(p + 23) * 60;
+    if (p[19] == '-') offset = -offset;
+    *second = DaysFromCivil(year, month, TwoDigits(p + 8)) * 86400 + TwoDigits(p + 11) * 3600 +
+              TwoDigits(p + 14) * 60 + TwoDigits(p + 17) - offset;
+    return true;
+}
+
+// 十进制整数；"-"（变量为空）按 0 处理。返回其后的位置，不是数字时返回 nullptr
+static inline const char* ParseUnsigned(const char* p, const char* end, uint64_t* value) {
+    if (p < end && *p == '-') {
+        *value = 0;
+        return p + 1;
+    }
+    if (p >= end || !IsDigit(*p)) return nullptr;
+    uint64_t result = 0;
+    while (p < end && IsDigit(*p)) result = result * 10 + (uint64_t)(*p++ - '0');
+    *value = result;
+    return p;
+}
+
+// "秒.毫秒" 形式的 $request_time / $msec，小数部分按毫秒取前三位
+static inline const char* ParseMillis(const char* p, const char* end, uint64_t* millis) {
+    uint64_t seconds = 0;
+    p = ParseUnsigned(p, end, &seconds);
+    if (!p) return nullptr;
+    uint64_t fraction = 0;
+    if (p < end && *p == '.') {
+        ++p;
+        int digits = 0;
+        while (p < end && IsDigit(*p)) {
+            if (digits++ < 3) fraction = fraction * 10 + (uint64_t)(*p - '0');
+            ++p;
+        }
+        for (; digits < 3; ++digits) fraction *= 10;
+    }
+    *millis = seconds * 1000 + fraction;
+    return p;
+}
+
+// ---------------------------------------------------------------------------
+// 编译
+
+namespace {
+
+// 变量在格式中的取值方式与可提供的字段；rank 越小越优先（同一字段有多个来源时）
+struct VariableInfo {
+    const char* name;
+    StepOp op;
+    uint8_t field;
+    uint8_t rank;
+};
+
+const VariableInfo kVariables[] = {
+    { "time_local", OP_TIME_LOCAL, LOG_FIELD_TIME, 0 },
+    { "time_iso8601", OP_TIME_ISO8601, LOG_FIELD_TIME, 1 },
+    { "msec", OP_MSEC, LOG_FIELD_TIME, 2 },
+    { "request", OP_REQUEST, LOG_FIELD_METHOD | LOG_FIELD_URI, 0 },
+    { "request_method", OP_METHOD, LOG_FIELD_METHOD, 1 },
+    { "request_uri", OP_REQUEST_URI, LOG_FIELD_URI, 1 },
+    { "uri", OP_URI, LOG_FIELD_URI, 2 },
+    { "document_uri", OP_URI, LOG_FIELD_URI, 3 },
+    { "host", OP_HOST, LOG_FIELD_HOST, 0 },
+    { "http_host", OP_HOST, LOG_FIELD_HOST, 1 },
+    { "server_name", OP_HOST, LOG_FIELD_HOST, 2 },
+    { "status", OP_STATUS, LOG_FIELD_STATUS, 0 },
+    { "body_bytes_sent", OP_BYTES, LOG_FIELD_BYTES, 0 },
+    { "bytes_sent", OP_BYTES, LOG_FIELD_BYTES, 1 },
+    { "request_time", OP_REQUEST_TIME, LOG_FIELD_REQUEST_TIME, 0 },
+    // 以下只用于跳过：取值总是数字，之后可以紧跟另一个变量
+    { "request_length", OP_NUMBER, 0, 0 },
+    { "connection", OP_NUMBER, 0, 0 },
+    { "connection_requests", OP_NUMBER, 0, 0 },
+    { "pid", OP_NUMBER, 0, 0 },
+    { "server_port", OP_NUMBER, 0, 0 },
+    { "remote_port", OP_NUMBER, 0, 0 },
+};
+
+const VariableInfo* FindVariable(const std::string& name) {
+    for (const VariableInfo& info : kVariables) {
+        if (name == info.name) return &info;
+    }
+    return nullptr;
+}
+
+// 不写入任何字段时的取值方式
+StepOp SkipOp(StepOp op) {
+    switch (op) {
+    case OP_TIME_LOCAL:
+    case OP_TIME_ISO8601:
+        return op;                   // 定长，直接跳过
+    case OP_MSEC:
+    case OP_STATUS:
+    case OP_BYTES:
+    case OP_REQUEST_TIME:
+    case OP_NUMBER:
+        return OP_NUMBER;
+    default:
+        return OP_TEXT;
+    }
+}
+
+// 取值长度不依赖后面的字面文本（之后可以紧跟另一个变量）
+bool SelfDelimiting(StepOp op) {
+    return SkipOp(op) != OP_TEXT;
+}
+
+} // namespace
+
+LogFormat::LogFormat() {
+    std::string error;
+    Compile("combined", kCombinedFormat, LOG_ESCAPE_DEFAULT, &error);
+}
+
+bool LogFormat::Compile(const std::string& name, const std::string& text, LogFormatEscape escape,
+                        std::string* error) {
+    struct Parsed {
+        std::string literal;         // 变量之前的字面文本
+        std::string variable;
+    };
+    std::vector<Parsed> parts(1);
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '$') {
+            parts.back().literal += text[i];
+            continue;
+        }
+        // $name 或 ${name}
+        size_t begin = i + 1;
+        bool braced = begin < text.size() && text[begin] == '{';
+        if (braced) ++begin;
+        size_t end = begin;
+        while (end < text.size() && (IsDigit(text[end]) || text[end] == '_' ||
+                                     (text[end] >= 'a' && text[end] <= 'z') || (text[end] >= 'A' && text[end] <= 'Z'))) {
+            ++end;
+        }
+        if (end == begin || (braced && (end >= text.size() || text[end] != '}'))) {
+            if (error) *error = "变量名无效: " + text.substr(i, end - i + 1);
+            return false;
+        }
+        parts.back().variable = text.substr(begin, end - begin);
+        parts.emplace_back();
+        i = braced ? end : end - 1;
+    }
+
+    // 各字段选定一个来源
+    std::vector<const VariableInfo*> infos(parts.size() - 1);
+    uint8_t best[8];
+    memset(best, 0xFF, sizeof(best));
+    for (size_t i = 0; i + 1 < parts.size(); ++i) {
+        infos[i] = FindVariable(parts[i].variable);
+        if (!infos[i]) continue;
+        for (int bit = 0; bit < 7; ++bit) {
+            if ((infos[i]->field & (1 << bit)) && infos[i]->rank < best[bit]) best[bit] = infos[i]->rank;
+        }
+    }
+
+    std::vector<Step> steps;
+    std::string literals;
+    uint32_t fields = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        Step step;
+        step.literal = (uint32_t)literals.size();
+        step.literalLength = (uint32_t)parts[i].literal.size();
+        literals += parts[i].literal;
+        if (i + 1 == parts.size()) {
+            step.op = OP_END;
+            steps.push_back(step);
+            break;
+        }
+        const VariableInfo* info = infos[i];
+        StepOp op = info ? info->op : OP_TEXT;
+        uint8_t field = 0;
+        for (int bit = 0; info && bit < 7; ++bit) {
+            if ((info->field & (1 << bit)) && info->rank == best[bit] && !(fields & (1u << bit))) {
+                field |= (uint8_t)(1 << bit);
+            }
+        }
+        fields |= field;
+        step.op = (uint8_t)(field ? op : SkipOp(op));
+        step.field = field;
+        // 长度不定的变量之后必须有字面文本作为边界（行尾的变量除外）
+        if (parts[i + 1].literal.empty() && i + 2 < parts.size() && !SelfDelimiting(op)) {
+            if (error) *error = "$" + parts[i].variable + " 与 $" + parts[i + 1].variable + " 之间没有分隔符，无法确定字段边界";
+            return false;
+        }
+        steps.push_back(step);
+    }
+    // 每个变量之后的字面文本就是下一步的字面文本
+    for (size_t i = 0; i + 1 < steps.size(); ++i) {
+        steps[i].next = steps[i + 1].literal;
+        steps[i].nextLength = steps[i + 1].literalLength;
+    }
+
+    m_name = name;
+    m_text = text;
+    m_literals.swap(literals);
+    m_steps.swap(steps);
+    m_escape = escape;
+    m_fields = fields;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 解析
+
+LogFormatParser::LogFormatParser(const LogFormat& format, uint32_t fields)
+    : m_steps(format.m_steps), m_literals(format.m_literals), m_json(format.m_escape == LOG_ESCAPE_JSON) {
+    // 不需要的字段改为跳过，最后一个需要的字段之后只核对紧随其后的字面文本
+    size_t last = 0;
+    bool any = false;
+    for (size_t i = 0; i < m_steps.size(); ++i) {
+        LogFormat::Step& step = m_steps[i];
+        if (step.op == OP_END) break;
+        step.field &= (uint8_t)fields;
+        if (step.field == 0) step.op = SkipOp((StepOp)step.op);
+        if (step.field != 0) {
+            last = i;
+            any = true;
+        }
+    }
+    size_t keep = any ? last + 2 : 1;
+    if (keep < m_steps.size()) {
+        m_steps.resize(keep);
+        m_steps.back().op = OP_STOP;
+    }
+}
+
+// 字符串变量的结尾：下一段字面文本出现的位置；JSON 转义时跳过 \ 之后的字符
+const char* LogFormatParser::FieldEnd(const char* p, const char* end, const LogFormat::Step& step) const {
+    if (step.nextLength == 0) return end;
+    const char* next = m_literals.data() + step.next;
+    const char* q = p;
+    for (;;) {
+        q = static_cast<const char*>(memchr(q, next[0], (size_t)(end - q)));
+        if (!q) return nullptr;
+        if (m_json) {
+            size_t backslashes = 0;
+            while (q - backslashes > p && q[-1 - (ptrdiff_t)backslashes] == '\\') ++backslashes;
+            if (backslashes % 2 == 1) {
+                ++q;
+                continue;
+            }
+        }
+        if ((size_t)(end - q) >= step.nextLength && memcmp(q, next, step.nextLength) == 0) return q;
+        ++q;
+    }
+}
+
+bool LogFormatParser::Parse(const char* line, size_t length, AccessLogEntry* entry) {
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) --length;
+    const char* p = line;
+    const char* end = line + length;
+    *entry = AccessLogEntry();
+
+    for (const LogFormat::Step& step : m_steps) {
+        if (step.literalLength != 0) {
+            if ((size_t)(end - p) < step.literalLength ||
+                memcmp(p, m_literals.data() + step.literal, step.literalLength) != 0) {
+                return false;
+            }
+            p += step.literalLength;
+        }
+
+        uint64_t value = 0;
+        const char* fieldEnd;
+        switch (step.op) {
+        case OP_END:
+            return p == end;
+        case OP_STOP:
+            return true;
+
+        case OP_TEXT:
+            p = FieldEnd(p, end, step);
+            if (!p) return false;
+            break;
+        case OP_NUMBER:
+            if (step.nextLength != 0) {
+                p = FieldEnd(p, end, step);
+                if (!p) return false;
+            } else {
+                while (p < end && (IsDigit(*p) || *p == '.' || *p == '-')) ++p;
+            }
+            break;
+
+        // 同一秒内的时间戳只换算一次
+        case OP_TIME_LOCAL:
+        case OP_TIME_ISO8601: {
+            size_t width = step.op == OP_TIME_LOCAL ? 26 : 25;
+            if ((size_t)(end - p) < width) return false;
+            if (step.field) {
+                if (memcmp(p, m_lastStamp, width) != 0) {
+                    int64_t second;
+                    if (!(step.op == OP_TIME_LOCAL ? ParseTimeLocal(p, &second) : ParseTimeIso8601(p, &second))) {
+                        return false;
+                    }
+                    memcpy(m_lastStamp, p, width);
+                    m_lastSecond = second;
+                }
+                entry->second = m_lastSecond;
+            }
+            p += width;
+            break;
+        }
+        case OP_MSEC:
+            p = ParseMillis(p, end, &value);
+            if (!p) return false;
+            entry->second = (int64_t)(value / 1000);
+            break;
+
+        case OP_REQUEST: {
+            fieldEnd = FieldEnd(p, end, step);
+            if (!fieldEnd) return false;
+            // 格式不对的请求行（如 "-"）整体作为方法，路径为空
+            const char* space = static_cast<const char*>(memchr(p, ' ', (size_t)(fieldEnd - p)));
+            if (!space) {
+                if (step.field & LOG_FIELD_METHOD) entry->method = std::string_view(p, (size_t)(fieldEnd - p));
+            } else {
+                if (step.field & LOG_FIELD_METHOD) entry->method = std::string_view(p, (size_t)(space - p));
+                if (step.field & LOG_FIELD_URI) {
+                    const char* uri = space + 1;
+                    const char* uriEnd = uri;
+                    while (uriEnd < fieldEnd && *uriEnd != ' ' && *uriEnd != '?') ++uriEnd;
+                    entry->uri = std::string_view(uri, (size_t)(uriEnd - uri));
+                }
+            }
+            p = fieldEnd;
+            break;
+        }
+        case OP_METHOD:
+        case OP_URI:
+        case OP_REQUEST_URI:
+        case OP_HOST: {
+            fieldEnd = FieldEnd(p, end, step);
+            if (!fieldEnd) return false;
+            std::string_view text(p, (size_t)(fieldEnd - p));
+            if (step.op == OP_METHOD) {
+                entry->method = text;
+            } else if (step.op == OP_HOST) {
+                entry->host = text;
+            } else {
+                entry->uri = step.op == OP_URI ? text : text.substr(0, text.find('?'));
+            }
+            p = fieldEnd;
+            break;
+        }
+
+        case OP_STATUS:
+            if (end - p < 3 || !IsDigit(p[0]) || !IsDigit(p[1]) || !IsDigit(p[2])) return false;
+            entry->status = (p[0] - '0') * 100 + (p[1] - '0') * 10 + (p[2] - '0');
+            p += 3;
+            break;
+        case OP_BYTES:
+            p = ParseUnsigned(p, end, &entry->bytes);
+            if (!p) return false;
+            break;
+        case OP_REQUEST_TIME:
+            p = ParseMillis(p, end, &value);
+            if (!p) return false;
+            entry->requestMs = value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+            break;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// LogFormatSet
+
+LogFormatSet::LogFormatSet() {
+    m_formats["combined"] = LogFormat();
+}
+
+void LogFormatSet::Load(const NginxConfig& config, std::vector<std::string>* errors) {
+    for (uint32_t index : config.FindByName("log_format")) {
+        const ConfDirective& directive = config.At(index);
+        if (directive.argCount < 2) continue;
+        std::string name(config.Arg(index, 0));
+        uint32_t first = 1;
+        LogFormatEscape escape = LOG_ESCAPE_DEFAULT;
+        std::string_view option = config.Arg(index, 1);
+        if (option.compare(0, 7, "escape=") == 0) {
+            escape = option == "escape=json" ? LOG_ESCAPE_JSON : option == "escape=none" ? LOG_ESCAPE_NONE
+                                                                                           : LOG_ESCAPE_DEFAULT;
+            first = 2;
+        }
+        // 多个参数直接拼接（nginx 的写法是每行一段引号字符串）
+        std::string text;
+        for (uint32_t i = first; i < directive.argCount; ++i) text += config.Arg(index, i);
+        LogFormat format;
+        std::string error;
+        if (!format.Compile(name, text, escape, &error)) {
+            if (errors) errors->push_back("log_format " + name + ": " + error);
+            continue;
+        }
+        m_formats[name] = format;
+    }
+}
+
+const LogFormat* LogFormatSet::Find(const std::string& name) const {
+    auto found = m_formats.find(name);
+    return found == m_formats.end() ? nullptr : &found->second;
+}
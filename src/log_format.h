@@ -0,0 +1,114 @@
+// nginx-manager/src/log_format.h
+// 日志格式 - 把 log_format 指令编译成专用的行解析程序：按字面分隔符定位字段，数字与时间就地换算，字段不复制
+
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class NginxConfig;
+
+// 一条访问记录中能识别的字段，字符串指向原始行；格式中没有的字段保持默认值
+struct AccessLogEntry {
+    int64_t second = 0;              // $time_local / $time_iso8601 / $msec 换算成的 UTC 秒
+    std::string_view method;
+    std::string_view uri;            // 请求路径，不含查询串
+    std::string_view host;           // $host，没有时依次取 $http_host、$server_name
+    int status = 0;
+    uint64_t bytes = 0;              // $body_bytes_sent，没有时取 $bytes_sent
+    uint32_t requestMs = 0;          // $request_time（毫秒）
+};
+
+// 解析器需要的字段（位掩码）：不需要的字段只跳过，最后一个需要的字段之后的部分不再解析
+enum LogField {
+    LOG_FIELD_TIME = 1 << 0,
+    LOG_FIELD_METHOD = 1 << 1,
+    LOG_FIELD_URI = 1 << 2,
+    LOG_FIELD_HOST = 1 << 3,
+    LOG_FIELD_STATUS = 1 << 4,
+    LOG_FIELD_BYTES = 1 << 5,
+    LOG_FIELD_REQUEST_TIME = 1 << 6,
+    LOG_FIELD_ALL = (1 << 7) - 1
+};
+
+// log_format 的 escape= 参数，决定字段值中如何出现分隔符
+enum LogFormatEscape {
+    LOG_ESCAPE_DEFAULT,              // " 与控制字符写作 \xXX，值中不会出现引号
+    LOG_ESCAPE_JSON,                 // " 写作 \"，查找分隔符时跳过转义
+    LOG_ESCAPE_NONE
+};
+
+// 编译后的 log_format：格式串拆成若干步，每步是"一段字面文本 + 一个变量"，
+// 变量按类型选定取值方式（定长时间、就地换算的数字、扫描到下一段字面文本的字符串）。
+// 同一字段有多个来源时（如 $host 与 $http_host）在编译时选定一个，其余只跳过。
+class LogFormat {
+public:
+    // 默认为内置的 combined
+    LogFormat();
+
+    // text 为 log_format 各参数拼接后的格式串；两个变量之间没有字面文本且前一个变量长度不定时无法定位边界，返回 false
+    bool Compile(const std::string& name, const std::string& text, LogFormatEscape escape, std::string* error);
+
+    const std::string& Name() const { return m_name; }
+    const std::string& Text() const { return m_text; }
+    // 格式中能取到的字段（LogField 位掩码）
+    uint32_t Fields() const { return m_fields; }
+
+private:
+    friend class LogFormatParser;
+
+    struct Step {
+        uint32_t literal = 0;        // 变量之前的字面文本在 m_literals 中的位置
+        uint32_t literalLength = 0;
+        uint32_t next = 0;           // 变量之后的字面文本，字符串变量扫描到它为止；长度为 0 表示到行尾
+        uint32_t nextLength = 0;
+        uint8_t op = 0;
+        uint8_t field = 0;           // 该步写入的 LogField，只跳过时为 0
+    };
+
+    std::string m_name;
+    std::string m_text;
+    std::string m_literals;
+    std::vector<Step> m_steps;       // 最后一步只有字面文本
+    LogFormatEscape m_escape = LOG_ESCAPE_DEFAULT;
+    uint32_t m_fields = 0;
+};
+
+// 按编译好的格式逐行解析；保存最近一次的时间戳换算结果，每个线程各用一个
+class LogFormatParser {
+public:
+    explicit LogFormatParser(const LogFormat& format, uint32_t fields = LOG_FIELD_ALL);
+
+    // 行尾的 \r\n 可有可无；与格式不符时返回 false
+    bool Parse(const char* line, size_t length, AccessLogEntry* entry);
+
+private:
+    const char* FieldEnd(const char* p, const char* end, const LogFormat::Step& step) const;
+
+    std::vector<LogFormat::Step> m_steps;
+    std::string m_literals;
+    bool m_json = false;
+    char m_lastStamp[26] = {};       // "10/Oct/2000:13:55:36 -0700" 或 "2000-10-10T13:55:36-07:00"
+    int64_t m_lastSecond = 0;
+};
+
+// 配置中的所有 log_format，另含内置的 combined（配置中同名定义优先）
+class LogFormatSet {
+public:
+    LogFormatSet();
+
+    // 编译失败的格式不加入，原因追加到 errors（形如 "log_format main: 原因"）
+    void Load(const NginxConfig& config, std::vector<std::string>* errors);
+    // 未定义时返回 nullptr
+    const LogFormat* Find(const std::string& name) const;
+
+private:
+    std::map<std::string, LogFormat> m_formats;
+};
+
+#endif // LOG_FORMAT_H
@@ -0,0 +1,167 @@
+// nginx-manager/src/log_model.cpp
+// 日志模型 - 固定容量的环形日志记录，消息文本驻留去重，内存占用不随运行时间增长
+
+#include "log_model.h"
+
+#include <chrono>
+#include <ctime>
+
+int64_t UtcTimeMicros() {
+    using namespace std::chrono;
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+int64_t LocalOffsetMicros() {
+#ifdef _WIN32
+    // FILETIME 差值即时区与夏令时偏移
+    FILETIME utcTime;
+    FILETIME localTime;
+    GetSystemTimeAsFileTime(&utcTime);
+    FileTimeToLocalFileTime(&utcTime, &localTime);
+    int64_t utcTicks = ((int64_t)utcTime.dwHighDateTime << 32) | utcTime.dwLowDateTime;
+    int64_t localTicks = ((int64_t)localTime.dwHighDateTime << 32) | localTime.dwLowDateTime;
+    return (localTicks - utcTicks) / 10;
+#else
+    time_t now = time(nullptr);
+    struct tm local;
+    localtime_r(&now, &local);
+    return (int64_t)local.tm_gmtoff * 1000000;
+#endif
+}
+
+int64_t LocalTimeMicros() {
+    return UtcTimeMicros() + LocalOffsetMicros();
+}
+
+LogModel::LogModel(size_t capacity)
+    : m_capacity(capacity == 0 ? 1 : capacity),
+      m_ring(m_capacity) {
+    m_strings.reserve(m_capacity);
+    m_freeStrings.reserve(m_capacity);
+    m_lookup.reserve(m_capacity);
+}
+
+uint32_t LogModel::Intern(std::string_view text) {
+    auto it = m_lookup.find(text);
+    if (it != m_lookup.end()) {
+        ++m_strings[it->second].refs;
+        return it->second;
+    }
+
+    uint32_t id;
+    if (!m_freeStrings.empty()) {
+        id = m_freeStrings.back();
+        m_freeStrings.pop_back();
+    } else {
+        id = (uint32_t)m_strings.size();
+        m_strings.emplace_back();
+    }
+    Interned& entry = m_strings[id];
+    entry.text.assign(text.data(), text.size());
+    entry.refs = 1;
+    m_lookup.emplace(std::string_view(entry.text), id);
+    return id;
+}
+
+void LogModel::Release(uint32_t id) {
+    Interned& entry = m_strings[id];
+    if (--entry.refs != 0) return;
+    m_lookup.erase(std::string_view(entry.text));
+    // 保留已分配的容量，槽位复用时不必重新分配
+    entry.text.clear();
+    m_freeStrings.push_back(id);
+}
+
+// 按 UTF-8 字符边界截断
+static std::string_view TruncateUtf8(std::string_view text, size_t maxBytes) {
+    if (text.size() <= maxBytes) return text;
+    size_t cut = maxBytes;
+    while (cut > 0 && ((unsigned char)text[cut] & 0xC0) == 0x80) --cut;
+    return text.substr(0, cut);
+}
+
+uint64_t LogModel::Append(LogSeverity severity, std::string_view message, int64_t timeMicros, uint64_t origin) {
+    message = TruncateUtf8(message, kMaxMessageBytes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t slot;
+    if (m_size == m_capacity) {
+        // 先淘汰再驻留，驻留字符串数永远不超过容量
+        slot = m_head;
+        Release(m_ring[slot].message);
+        m_head = (m_head + 1) % m_capacity;
+        ++m_evicted;
+    } else {
+        slot = (m_head + m_size) % m_capacity;
+        ++m_size;
+    }
+
+    LogRecord& record = m_ring[slot];
+    record.sequence = m_nextSequence++;
+    record.timeMicros = timeMicros;
+    record.severity = severity;
+    record.origin = origin;
+    record.message = Intern(message);
+    return record.sequence;
+}
+
+void LogModel::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_size; ++i) {
+        Release(m_ring[(m_head + i) % m_capacity].message);
+    }
+    m_evicted += m_size;
+    m_head = 0;
+    m_size = 0;
+}
+
+size_t LogModel::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+uint64_t LogModel::FirstSequence() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextSequence - m_size;
+}
+
+uint64_t LogModel::NextSequence() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextSequence;
+}
+
+uint64_t LogModel::Evicted() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_evicted;
+}
+
+size_t LogModel::InternedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lookup.size();
+}
+
+bool LogModel::Get(size_t index, LogRecord* record, std::string* text) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (index >= m_size) return false;
+    const LogRecord& source = m_ring[(m_head + index) % m_capacity];
+    if (record) *record = source;
+    if (text) *text = m_strings[source.message].text;
+    return true;
+}
+
+size_t LogModel::GetRange(size_t index, size_t count, std::vector<LogRecord>* records,
+                          std::vector<std::string>* texts) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (index >= m_size) count = 0;
+    else if (count > m_size - index) count = m_size - index;
+
+    if (records) records->resize(count);
+    if (texts) texts->resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const LogRecord& source = m_ring[(m_head + index + i) % m_capacity];
+        if (records) (*records)[i] = source;
+        // assign 复用调用方已有的容量，逐帧绘制时不再分配
+        if (texts) (*texts)[i].assign(m_strings[source.message].text);
+    }
+    return count;
+}
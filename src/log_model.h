@@ -0,0 +1,94 @@
+// nginx-manager/src/log_model.h
+// 日志模型 - 固定容量的环形日志记录，消息文本驻留去重，内存占用不随运行时间增长
+
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+#include "platform.h"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 日志级别，界面按级别选择颜色
+enum LogSeverity {
+    LOG_DETAIL = 0,                  // 次要信息（灰色）
+    LOG_PLAIN,                       // 普通文本（黑色）
+    LOG_INFO,                        // 操作进度（蓝色）
+    LOG_SUCCESS,                     // 成功（绿色）
+    LOG_WARNING,                     // 警告（橙色）
+    LOG_ERROR                        // 失败（红色）
+};
+
+// 一条日志记录
+struct LogRecord {
+    uint64_t sequence = 0;           // 全局递增序号，被淘汰后也不会复用
+    int64_t timeMicros = 0;          // 本地时间，自 1970-01-01 起的微秒数
+    uint32_t message = 0;            // 驻留字符串编号
+    LogSeverity severity = LOG_PLAIN;
+    uint64_t origin = 0;             // 对应的日志持久化记录序号，未写入时为 0
+};
+
+// 固定容量的环形日志，写满后淘汰最旧的记录
+// 相同的消息文本只保存一份（按引用计数回收），单条消息超过 kMaxMessageBytes 时截断。
+// 所有方法线程安全，后台线程可直接追加。
+class LogModel {
+public:
+    static const size_t kMaxMessageBytes = 1024;
+
+    explicit LogModel(size_t capacity = 5000);
+
+    LogModel(const LogModel&) = delete;
+    LogModel& operator=(const LogModel&) = delete;
+
+    // 追加一条 UTF-8 消息，返回其序号
+    uint64_t Append(LogSeverity severity, std::string_view message, int64_t timeMicros, uint64_t origin = 0);
+    void Clear();
+
+    size_t Capacity() const { return m_capacity; }
+    size_t Size() const;
+    uint64_t FirstSequence() const;  // 现存最旧记录的序号
+    uint64_t NextSequence() const;   // 下一条记录将使用的序号
+    uint64_t Evicted() const;        // 累计被淘汰的记录数
+    size_t InternedCount() const;    // 当前驻留的不同消息数
+
+    // 取从最旧记录起第 index 条（0 <= index < Size()），text 为消息文本的副本
+    bool Get(size_t index, LogRecord* record, std::string* text) const;
+
+    // 一次取出 [index, index + count) 范围内的记录，供界面绘制可见区域
+    size_t GetRange(size_t index, size_t count, std::vector<LogRecord>* records,
+                    std::vector<std::string>* texts) const;
+
+private:
+    struct Interned {
+        std::string text;
+        uint32_t refs = 0;
+    };
+
+    uint32_t Intern(std::string_view text);
+    void Release(uint32_t id);
+
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    std::vector<LogRecord> m_ring;
+    size_t m_head = 0;               // 最旧记录所在位置
+    size_t m_size = 0;
+    uint64_t m_nextSequence = 1;
+    uint64_t m_evicted = 0;
+
+    std::vector<Interned> m_strings; // 预留 capacity 个槽位，扩容不会发生，键中的 string_view 始终有效
+    std::vector<uint32_t> m_freeStrings;
+    std::unordered_map<std::string_view, uint32_t> m_lookup;
+};
+
+// UTC 时间（微秒），自 1970-01-01 起
+int64_t UtcTimeMicros();
+
+// 本地时间（微秒），用作日志时间戳
+int64_t LocalTimeMicros();
+
+// 当前时区（含夏令时）相对 UTC 的偏移（微秒）
+int64_t LocalOffsetMicros();
+
+#endif // LOG_MODEL_H
@@ -0,0 +1,730 @@
+// nginx-manager/src/log_rotator.cpp
+// 日志轮转 - 按大小 / 时间改名并通知 nginx 重新打开日志，低优先级后台线程以固定内存压缩为 .lz4 并按保留策略清理
+
+#include "log_rotator.h"
+#include "file_util.h"
+#include "lz4_frame.h"
+#include "nginx_conf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// ---------------------------------------------------------------------------
+// 文件操作（路径均为 UTF-8）
+
+// 改名，目标已存在时失败
+static bool RenameNoReplace(const std::string& from, const std::string& to, std::string* error) {
+#ifdef _WIN32
+    // nginx 以 FILE_SHARE_DELETE 打开日志，写入中的文件也可以改名
+    if (MoveFileExW(Utf8ToWide(from).c_str(), Utf8ToWide(to).c_str(), MOVEFILE_WRITE_THROUGH)) return true;
+    if (error) *error = "无法改名 " + from + " (错误 " + std::to_string(GetLastError()) + ")";
+    return false;
+#else
+    uint64_t size = 0;
+    if (StatFile(to, &size)) {
+        if (error) *error = "目标已存在: " + to;
+        return false;
+    }
+    if (rename(from.c_str(), to.c_str()) == 0) return true;
+    if (error) *error = "无法改名 " + from + " (" + strerror(errno) + ")";
+    return false;
+#endif
+}
+
+// 把写入的内容刷到磁盘，之后才能删除原文件
+static bool SyncFile(FILE* file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// 归档命名：<日志文件名>.<YYYYMMDD-HHMMSS>[-N][.lz4]，同一秒内多次轮转时追加 -N
+
+static std::string ArchiveStamp(time_t now) {
+    struct tm parts;
+#ifdef _WIN32
+    localtime_s(&parts, &now);
+#else
+    localtime_r(&now, &parts);
+#endif
+    char text[32];
+    snprintf(text, sizeof(text), "%04d%02d%02d-%02d%02d%02d", parts.tm_year + 1900, parts.tm_mon + 1,
+             parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec);
+    return text;
+}
+
+struct ArchiveName {
+    std::string name;
+    std::string stamp;
+    uint32_t sequence = 0;
+    bool compressed = false;
+    uint64_t size = 0;
+};
+
+static bool ParseArchiveName(const std::string& baseName, const std::string& name, ArchiveName* archive) {
+    if (name.size() < baseName.size() + 16 || name.compare(0, baseName.size(), baseName) != 0 ||
+        name[baseName.size()] != '.') {
+        return false;
+    }
+    const char* p = name.c_str() + baseName.size() + 1;
+    for (int i = 0; i < 15; ++i) {
+        if (i == 8 ? p[i] != '-' : (p[i] < '0' || p[i] > '9')) return false;
+    }
+    archive->name = name;
+    archive->stamp.assign(p, 15);
+    archive->sequence = 0;
+    archive->compressed = false;
+    p += 15;
+    if (*p == '-') {
+        ++p;
+        if (*p < '0' || *p > '9') return false;
+        while (*p >= '0' && *p <= '9') archive->sequence = archive->sequence * 10 + (uint32_t)(*p++ - '0');
+    }
+    if (strcmp(p, ".lz4") == 0) {
+        archive->compressed = true;
+        return true;
+    }
+    return *p == '\0';
+}
+
+// 目录中属于某个日志的归档，按时间从新到旧排列
+static std::vector<ArchiveName> ListArchives(const std::string& path) {
+    std::string directory = DirectoryOf(path);
+    std::string baseName = BaseName(path);
+    std::vector<ArchiveName> archives;
+    for (const std::string& name : ListDirectory(directory)) {
+        ArchiveName archive;
+        if (!ParseArchiveName(baseName, name, &archive)) continue;
+        StatFile(JoinPath(directory, name), &archive.size);
+        archives.push_back(archive);
+    }
+    std::sort(archives.begin(), archives.end(), [](const ArchiveName& a, const ArchiveName& b) {
+        if (a.stamp != b.stamp) return a.stamp > b.stamp;
+        return a.sequence > b.sequence;
+    });
+    return archives;
+}
+
+static std::string UniqueArchivePath(const std::string& path, const std::string& stamp) {
+    std::string candidate = path + "." + stamp;
+    uint64_t size = 0;
+    for (uint32_t sequence = 1;; ++sequence) {
+        if (!StatFile(candidate, &size) && !StatFile(candidate + ".lz4", &size)) return candidate;
+        candidate = path + "." + stamp + "-" + std::to_string(sequence);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 配置中的日志文件
+
+static std::string ResolveLogPath(const std::string& prefix, std::string path) {
+#ifdef _WIN32
+    std::replace(path.begin(), path.end(), '/', '\\');
+#endif
+    if (IsAbsolutePath(path)) return path;
+    if (prefix.empty() || IsPathSeparator(prefix.back())) return prefix + path;
+    return JoinPath(prefix, path);
+}
+
+// 默认日志加上配置中 directives 指令的文件目标；formats 不为空时同时给出 access_log 的格式名（默认 combined）
+static std::vector<std::string> CollectConfiguredFiles(const std::string& prefix, const NginxConfig* config,
+                                                       std::initializer_list<const char*> defaults,
+                                                       std::initializer_list<const char*> directives,
+                                                       std::vector<std::string>* formats = nullptr) {
+    std::vector<std::string> files;
+    for (const char* path : defaults) files.push_back(ResolveLogPath(prefix, path));
+    if (formats) formats->assign(files.size(), "combined");
+    std::vector<bool> configured(files.size(), false);   // 同一文件出现多次时格式以第一次为准
+
+    for (const char* directive : directives) {
+        if (!config) break;
+        for (uint32_t index : config->FindByName(directive)) {
+            if (config->At(index).argCount == 0) continue;
+            std::string target(config->Arg(index, 0));
+            if (target == "off" || target == "stderr" || target.compare(0, 7, "syslog:") == 0 ||
+                target.compare(0, 7, "memory:") == 0 || target.find('$') != std::string::npos) {
+                continue;
+            }
+            std::string path = ResolveLogPath(prefix, target);
+            std::string format = config->At(index).argCount > 1 ? std::string(config->Arg(index, 1)) : "combined";
+            size_t position = (size_t)(std::find(files.begin(), files.end(), path) - files.begin());
+            if (position == files.size()) {
+                files.push_back(path);
+                configured.push_back(true);
+                if (formats) formats->push_back(format);
+            } else if (!configured[position]) {
+                configured[position] = true;
+                if (formats) (*formats)[position] = format;
+            }
+        }
+    }
+    return files;
+}
+
+std::vector<std::string> CollectLogFiles(const std::string& prefix, const std::string& confPath) {
+    NginxConfig config;
+    std::string error;
+    bool loaded = config.Load(confPath, &error);
+    return CollectConfiguredFiles(prefix, loaded ? &config : nullptr, { "logs/access.log", "logs/error.log" },
+                                  { "access_log", "error_log" });
+}
+
+std::vector<AccessLogSource> CollectAccessLogSources(const std::string& prefix, const std::string& confPath) {
+    NginxConfig config;
+    std::string error;
+    bool loaded = config.Load(confPath, &error);
+    LogFormatSet formats;
+    std::vector<std::string> formatErrors;
+    if (loaded) formats.Load(config, &formatErrors);
+
+    std::vector<std::string> names;
+    std::vector<std::string> files = CollectConfiguredFiles(prefix, loaded ? &config : nullptr, { "logs/access.log" },
+                                                            { "access_log" }, &names);
+    std::vector<AccessLogSource> sources(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        sources[i].path = files[i];
+        const LogFormat* format = formats.Find(names[i]);
+        if (format) {
+            sources[i].format = *format;
+            continue;
+        }
+        // 未定义，或定义了但无法编译
+        sources[i].error = "log_format " + names[i] + " 未定义";
+        std::string prefixText = "log_format " + names[i] + ":";
+        for (const std::string& formatError : formatErrors) {
+            if (formatError.compare(0, prefixText.size(), prefixText) == 0) sources[i].error = formatError;
+        }
+    }
+    return sources;
+}
+
+std::vector<std::string> ListLogArchives(const std::string& path) {
+    std::string directory = DirectoryOf(path);
+    std::string baseName = BaseName(path);
+    std::vector<ArchiveName> archives = ListArchives(path);
+    std::vector<std::string> paths;
+    for (auto it = archives.rbegin(); it != archives.rend(); ++it) paths.push_back(JoinPath(directory, it->name));
+    return paths;
+}
+
+std::string FormatLogRotationEvent(const LogRotationEvent& event) {
+    char text[512];
+    switch (event.type) {
+        case LOG_ROTATED:
+            snprintf(text, sizeof(text), "✓ 日志已轮转: %s → %s (%.1f MB, 改名并通知 nginx 耗时 %.1f ms)",
+                     BaseName(event.path).c_str(), BaseName(event.archive).c_str(), event.bytes / 1048576.0,
+                     event.micros / 1000.0);
+            break;
+        case LOG_ROTATE_FAILED:
+            snprintf(text, sizeof(text), "✗ 日志轮转失败 (%s): %s", event.path.c_str(), event.error.c_str());
+            break;
+        case LOG_COMPRESSED:
+            snprintf(text, sizeof(text), "✓ 已压缩 %s (%.1f MB → %.1f MB, %.1f%%, 耗时 %.2f 秒)",
+                     BaseName(event.archive).c_str(), event.bytes / 1048576.0, event.outputBytes / 1048576.0,
+                     event.bytes > 0 ? event.outputBytes * 100.0 / event.bytes : 0.0, event.micros / 1000000.0);
+            break;
+        case LOG_COMPRESS_FAILED:
+            snprintf(text, sizeof(text), "✗ 压缩归档失败 (%s): %s", event.archive.c_str(), event.error.c_str());
+            break;
+        case LOG_PRUNED:
+            snprintf(text, sizeof(text), "已按保留策略删除 %u 个 %s 的旧归档", event.removed,
+                     BaseName(event.path).c_str());
+            break;
+    }
+    return text;
+}
+
+// ---------------------------------------------------------------------------
+// 压缩
+
+bool CompressFileLz4(const std::string& source, const std::string& target, uint64_t bytesPerSec,
+                     const std::atomic<bool>* cancel, uint64_t* inBytes, uint64_t* outBytes, std::string* error) {
+    FILE* in = OpenFile(source, "rb");
+    if (!in) {
+        if (error) *error = "无法打开 " + source;
+        return false;
+    }
+    FILE* out = OpenFile(target, "wb");
+    if (!out) {
+        fclose(in);
+        if (error) *error = "无法创建 " + target;
+        return false;
+    }
+
+    // 编码器含 64KB 哈希表，放在堆上；输入与输出各一块，总量固定
+    std::unique_ptr<Lz4FrameEncoder> encoder(new Lz4FrameEncoder());
+    std::vector<uint8_t> input(Lz4FrameEncoder::kBlockSize);
+    std::vector<uint8_t> output(Lz4FrameEncoder::kMaxBlockOutput);
+
+    uint64_t begin = MonotonicMicros();
+    uint64_t read = 0;
+    uint64_t written = 0;
+    bool ok = true;
+    size_t size = encoder->Header(output.data());
+    ok = fwrite(output.data(), 1, size, out) == size;
+    written += size;
+    while (ok) {
+        size_t count = fread(input.data(), 1, input.size(), in);
+        if (count == 0) break;
+        size = encoder->EncodeBlock(input.data(), count, output.data());
+        ok = fwrite(output.data(), 1, size, out) == size;
+        read += count;
+        written += size;
+
+        // 按读取量限速：提前完成的部分睡眠补足，每次最多睡 100ms 以便及时响应取消
+        if (bytesPerSec > 0) {
+            uint64_t expected = begin + read * 1000000 / bytesPerSec;
+            for (uint64_t now = MonotonicMicros(); ok && now < expected; now = MonotonicMicros()) {
+                if (cancel && cancel->load()) break;
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min<uint64_t>(expected - now, 100000)));
+            }
+        }
+        if (cancel && cancel->load()) {
+            if (error) *error = "已取消";
+            fclose(in);
+            fclose(out);
+            return false;
+        }
+    }
+    bool readFailed = ferror(in) != 0;
+    fclose(in);
+    if (ok && !readFailed) {
+        size = encoder->Trailer(output.data());
+        ok = fwrite(output.data(), 1, size, out) == size && SyncFile(out);
+        written += size;
+    }
+    ok = fclose(out) == 0 && ok;
+    if (readFailed || !ok) {
+        if (error) *error = readFailed ? "读取失败: " + source : "写入失败: " + target;
+        return false;
+    }
+    if (inBytes) *inBytes = read;
+    if (outBytes) *outBytes = written;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// LogRotator
+
+LogRotator::~LogRotator() {
+    Stop();
+}
+
+void LogRotator::SetHandlers(ReopenHandler reopen, EventHandler handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reopen = reopen;
+    m_handler = handler;
+}
+
+void LogRotator::SetPolicy(const LogRotationPolicy& policy) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_policy = policy;
+        if (m_policy.checkIntervalMs < 100) m_policy.checkIntervalMs = 100;
+    }
+    m_wake.notify_all();
+}
+
+LogRotationPolicy LogRotator::Policy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_policy;
+}
+
+void LogRotator::Start(const std::string& prefix, const std::string& confPath) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_monitor.joinable() && prefix == m_prefix && confPath == m_confPath) return;
+    }
+    Stop();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = false;
+    m_rescan = true;
+    m_rotateNow = false;
+    m_prefix = prefix;
+    m_confPath = confPath;
+    m_files.clear();
+    m_rotatedAt.clear();
+    m_pending.clear();
+    m_monitor = std::thread(&LogRotator::RunMonitor, this);
+    m_compressor = std::thread(&LogRotator::RunCompressor, this);
+}
+
+void LogRotator::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_compressWake.notify_all();
+    if (m_monitor.joinable()) m_monitor.join();
+    if (m_compressor.joinable()) m_compressor.join();
+}
+
+void LogRotator::Rescan() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rescan = true;
+    }
+    m_wake.notify_all();
+}
+
+void LogRotator::RotateNow() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rotateNow = true;
+    }
+    m_wake.notify_all();
+}
+
+LogRotationStats LogRotator::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    LogRotationStats stats = m_stats;
+    stats.pending = (uint32_t)m_pending.size() + (m_compressing ? 1 : 0);
+    return stats;
+}
+
+std::vector<std::string> LogRotator::Files() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_files;
+}
+
+void LogRotator::Emit(const LogRotationEvent& event) {
+    if (m_handler) m_handler(event);
+}
+
+void LogRotator::RunMonitor() {
+    bool first = true;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        if (m_rescan) {
+            m_rescan = false;
+            std::string prefix = m_prefix;
+            std::string confPath = m_confPath;
+            lock.unlock();
+            std::vector<std::string> files = CollectLogFiles(prefix, confPath);
+            if (first) EnqueueLeftovers(files);
+            first = false;
+            lock.lock();
+            int64_t now = (int64_t)time(nullptr);
+            for (const std::string& file : files) m_rotatedAt.emplace(file, now);
+            m_files = files;
+        }
+
+        LogRotationPolicy policy = m_policy;
+        bool force = m_rotateNow;
+        m_rotateNow = false;
+        std::vector<std::string> files = m_files;
+        std::vector<int64_t> rotatedAt;
+        for (const std::string& file : files) rotatedAt.push_back(m_rotatedAt[file]);
+        lock.unlock();
+
+        int64_t now = (int64_t)time(nullptr);
+        std::vector<std::string> due;
+        std::vector<std::string> idle;
+        for (size_t i = 0; i < files.size(); ++i) {
+            uint64_t size = 0;
+            if (!StatFile(files[i], &size)) continue;
+            if (size == 0) {
+                idle.push_back(files[i]);   // 空文件不轮转，按时间轮转的计时从有内容时开始
+                continue;
+            }
+            bool bySize = policy.maxBytes > 0 && size >= policy.maxBytes;
+            bool byAge = policy.maxAgeSeconds > 0 && now - rotatedAt[i] >= (int64_t)policy.maxAgeSeconds;
+            if (force || (policy.enabled && (bySize || byAge))) due.push_back(files[i]);
+        }
+        if (!due.empty()) RotateFiles(due);
+
+        lock.lock();
+        for (const std::string& file : idle) m_rotatedAt[file] = now;
+        m_wake.wait_for(lock, std::chrono::milliseconds(policy.checkIntervalMs),
+                        [this]() { return m_stopping || m_rescan || m_rotateNow; });
+    }
+}
+
+void LogRotator::RotateFiles(const std::vector<std::string>& files) {
+    uint64_t begin = MonotonicMicros();
+    std::string stamp = ArchiveStamp(time(nullptr));
+
+    struct Moved {
+        std::string path;
+        std::string archive;
+        uint64_t size;
+    };
+    std::vector<Moved> moved;
+    for (const std::string& path : files) {
+        Moved item;
+        item.path = path;
+        item.size = 0;
+        StatFile(path, &item.size);
+        item.archive = UniqueArchivePath(path, stamp);
+        LogRotationEvent event;
+        if (!RenameNoReplace(path, item.archive, &event.error)) {
+            event.type = LOG_ROTATE_FAILED;
+            event.path = path;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_stats.rotateFailures;
+            }
+            Emit(event);
+            continue;
+        }
+        moved.push_back(item);
+    }
+    if (moved.empty()) return;
+
+    // 所有文件改名后只通知一次；通知失败时 nginx 仍在写改名后的文件，改回原名保持原状
+    std::string error;
+    bool reopened = !m_reopen || m_reopen(&error);
+    uint64_t micros = MonotonicMicros() - begin;
+    if (!reopened) {
+        for (const Moved& item : moved) {
+            LogRotationEvent event;
+            event.type = LOG_ROTATE_FAILED;
+            event.path = item.path;
+            event.error = "通知 nginx 重新打开日志失败: " + error;
+            std::string restoreError;
+            if (!RenameNoReplace(item.archive, item.path, &restoreError)) event.error += "；" + restoreError;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_stats.rotateFailures;
+            }
+            Emit(event);
+        }
+        return;
+    }
+
+    int64_t now = (int64_t)time(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.rotations += moved.size();
+        m_stats.lastRotateMicros = micros;
+        for (const Moved& item : moved) {
+            m_rotatedAt[item.path] = now;
+            PendingArchive pending;
+            pending.path = item.path;
+            pending.archive = item.archive;
+            pending.size = item.size;
+            pending.dueMicros = MonotonicMicros() + (uint64_t)m_policy.settleMs * 1000;
+            m_pending.push_back(pending);
+        }
+    }
+    m_compressWake.notify_all();
+
+    for (const Moved& item : moved) {
+        LogRotationEvent event;
+        event.type = LOG_ROTATED;
+        event.path = item.path;
+        event.archive = item.archive;
+        event.bytes = item.size;
+        event.micros = micros;
+        Emit(event);
+    }
+}
+
+void LogRotator::EnqueueLeftovers(const std::vector<std::string>& files) {
+    uint64_t now = MonotonicMicros();
+    std::vector<PendingArchive> leftovers;
+    for (const std::string& path : files) {
+        std::string directory = DirectoryOf(path);
+        std::string baseName = BaseName(path);
+        for (const std::string& name : ListDirectory(directory)) {
+            // 上次退出时未完成的压缩
+            ArchiveName archive;
+            if (name.size() > 8 && name.compare(name.size() - 8, 8, ".lz4.tmp") == 0 &&
+                ParseArchiveName(baseName, name.substr(0, name.size() - 8), &archive)) {
+                RemoveFile(JoinPath(directory, name));
+            }
+        }
+        for (const ArchiveName& archive : ListArchives(path)) {
+            if (archive.compressed) continue;
+            PendingArchive pending;
+            pending.path = path;
+            pending.archive = JoinPath(directory, archive.name);
+            pending.size = archive.size;
+            pending.dueMicros = now;
+            leftovers.push_back(pending);
+        }
+    }
+    if (leftovers.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.insert(m_pending.end(), leftovers.begin(), leftovers.end());
+    }
+    m_compressWake.notify_all();
+}
+
+void LogRotator::RunCompressor() {
+    // 压缩只是为了节省磁盘，不应与 nginx 争抢 CPU 与磁盘
+#ifdef _WIN32
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#else
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    setpriority(PRIO_PROCESS, (id_t)tid, 19);
+#ifdef SYS_ioprio_set
+    const int kIoprioWhoProcess = 1;
+    const int kIoprioClassIdle = 3;
+    syscall(SYS_ioprio_set, kIoprioWhoProcess, (int)tid, kIoprioClassIdle << 13);
+#endif
+#endif
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        if (m_pending.empty()) {
+            m_compressWake.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+            continue;
+        }
+        auto next = std::min_element(m_pending.begin(), m_pending.end(),
+                                     [](const PendingArchive& a, const PendingArchive& b) {
+                                         return a.dueMicros < b.dueMicros;
+                                     });
+        uint64_t now = MonotonicMicros();
+        if (next->dueMicros > now) {
+            m_compressWake.wait_for(lock, std::chrono::microseconds(next->dueMicros - now));
+            continue;
+        }
+        PendingArchive item = *next;
+        m_pending.erase(next);
+        LogRotationPolicy policy = m_policy;
+        m_compressing = true;
+        lock.unlock();
+
+        // 文件仍在增长说明还有 worker 未重新打开日志，等它停止增长
+        uint64_t size = 0;
+        bool exists = StatFile(item.archive, &size);
+        if (exists && size != item.size) {
+            item.size = size;
+            item.dueMicros = MonotonicMicros() + (uint64_t)policy.settleMs * 1000;
+            lock.lock();
+            m_pending.push_back(item);
+            m_compressing = false;
+            continue;
+        }
+        if (exists) CompressArchive(item, policy);
+
+        lock.lock();
+        m_compressing = false;
+    }
+}
+
+void LogRotator::CompressArchive(const PendingArchive& item, const LogRotationPolicy& policy) {
+    if (!policy.compress) {
+        Prune(item.path, policy);
+        return;
+    }
+
+    std::string target = item.archive + ".lz4";
+    std::string temp = target + ".tmp";
+    uint64_t begin = MonotonicMicros();
+    uint64_t inBytes = 0;
+    uint64_t outBytes = 0;
+    LogRotationEvent event;
+    event.path = item.path;
+    event.archive = target;
+    bool ok = CompressFileLz4(item.archive, temp, policy.compressBytesPerSec, &m_stopping, &inBytes, &outBytes,
+                              &event.error);
+    if (!ok) {
+        RemoveFile(temp);
+        if (m_stopping) return;     // 未压缩的归档留到下次启动时处理
+        event.type = LOG_COMPRESS_FAILED;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.compressFailures;
+        }
+        Emit(event);
+        return;
+    }
+
+    // 压缩期间仍有写入时丢弃结果，稍后重新压缩
+    uint64_t size = 0;
+    if (StatFile(item.archive, &size) && size != inBytes) {
+        RemoveFile(temp);
+        PendingArchive retry = item;
+        retry.size = size;
+        retry.dueMicros = MonotonicMicros() + (uint64_t)policy.settleMs * 1000;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.push_back(retry);
+        return;
+    }
+    if (!RenameNoReplace(temp, target, &event.error)) {
+        RemoveFile(temp);
+        event.type = LOG_COMPRESS_FAILED;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.compressFailures;
+        }
+        Emit(event);
+        return;
+    }
+    RemoveFile(item.archive);
+
+    event.type = LOG_COMPRESSED;
+    event.bytes = inBytes;
+    event.outputBytes = outBytes;
+    event.micros = MonotonicMicros() - begin;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_stats.compressed;
+        m_stats.bytesIn += inBytes;
+        m_stats.bytesOut += outBytes;
+        m_stats.compressMicros += event.micros;
+    }
+    Emit(event);
+    Prune(item.path, policy);
+}
+
+void LogRotator::Prune(const std::string& path, const LogRotationPolicy& policy) {
+    if (policy.keepFiles == 0 && policy.keepBytes == 0) return;
+
+    std::string directory = DirectoryOf(path);
+    std::string baseName = BaseName(path);
+    std::vector<std::string> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const PendingArchive& item : m_pending) pending.push_back(item.archive);
+    }
+
+    uint32_t kept = 0;
+    uint64_t keptBytes = 0;
+    uint32_t removed = 0;
+    for (const ArchiveName& archive : ListArchives(path)) {
+        std::string full = JoinPath(directory, archive.name);
+        if (std::find(pending.begin(), pending.end(), full) != pending.end()) continue;   // 尚待压缩
+        ++kept;
+        keptBytes += archive.size;
+        // 最新的一个归档总是保留
+        bool overCount = policy.keepFiles > 0 && kept > policy.keepFiles;
+        bool overBytes = policy.keepBytes > 0 && keptBytes > policy.keepBytes && kept > 1;
+        if (overCount || overBytes) {
+            RemoveFile(full);
+            ++removed;
+        }
+    }
+    if (removed == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.pruned += removed;
+    }
+    LogRotationEvent event;
+    event.type = LOG_PRUNED;
+    event.path = path;
+    event.removed = removed;
+    Emit(event);
+}
@@ -0,0 +1,161 @@
+// nginx-manager/src/log_rotator.h
+// 日志轮转 - 按大小 / 时间改名并通知 nginx 重新打开日志，低优先级后台线程以固定内存压缩为 .lz4 并按保留策略清理
+
+#ifndef LOG_ROTATOR_H
+#define LOG_ROTATOR_H
+
+#include "log_format.h"
+#include "platform.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LogRotationPolicy {
+    bool enabled = true;
+    uint64_t maxBytes = 256ull << 20;    // 文件达到这个大小即轮转，0 表示不按大小
+    uint32_t maxAgeSeconds = 0;          // 距上次轮转超过这个时长即轮转（空文件除外），0 表示不按时间
+    uint32_t keepFiles = 14;             // 每个日志保留的归档数，0 表示不限
+    uint64_t keepBytes = 0;              // 每个日志的归档总大小上限，0 表示不限
+    bool compress = true;
+    uint64_t compressBytesPerSec = 32ull << 20;   // 压缩读取速率上限，0 表示不限
+    uint32_t checkIntervalMs = 1000;     // 检查文件大小的间隔
+    uint32_t settleMs = 2000;            // 改名后文件大小保持不变这么久才开始压缩（等待 worker 重新打开日志）
+};
+
+enum LogRotationEventType {
+    LOG_ROTATED,                     // 已改名并通知 nginx 重新打开
+    LOG_ROTATE_FAILED,               // 改名或通知失败（通知失败时已改回原名）
+    LOG_COMPRESSED,
+    LOG_COMPRESS_FAILED,
+    LOG_PRUNED                       // 按保留策略删除了旧归档
+};
+
+struct LogRotationEvent {
+    LogRotationEventType type = LOG_ROTATED;
+    std::string path;                // 日志文件
+    std::string archive;             // ROTATED / COMPRESSED: 归档文件
+    uint64_t bytes = 0;              // ROTATED: 轮转时的大小；COMPRESSED: 原始大小
+    uint64_t outputBytes = 0;        // COMPRESSED: 压缩后大小
+    uint64_t micros = 0;             // ROTATED: 改名到通知完成；COMPRESSED: 压缩耗时
+    uint32_t removed = 0;            // PRUNED: 删除的归档数
+    std::string error;
+};
+
+struct LogRotationStats {
+    uint64_t rotations = 0;
+    uint64_t rotateFailures = 0;
+    uint64_t compressed = 0;
+    uint64_t compressFailures = 0;
+    uint64_t bytesIn = 0;            // 已压缩的原始字节
+    uint64_t bytesOut = 0;
+    uint64_t compressMicros = 0;     // 压缩累计耗时（含限速等待）
+    uint64_t pruned = 0;
+    uint32_t pending = 0;            // 等待压缩的归档
+    uint64_t lastRotateMicros = 0;   // 最近一次改名到通知完成的耗时
+};
+
+// 日志轮转
+// 监视线程每 checkIntervalMs 检查一次配置中各日志文件（access_log / error_log，相对路径以安装目录为基准）
+// 的大小，达到阈值的文件改名为 <日志>.<YYYYMMDD-HHMMSS>，同一轮中改名的所有文件只通知一次 nginx。
+// nginx 在收到通知前继续写入改名后的文件（句柄不变），之后写入新文件，请求日志不会中断或丢失。
+// 压缩线程以最低 CPU / IO 优先级运行，等改名后的文件不再增长后压缩为 <归档>.lz4（先写 .tmp 再改名），
+// 每次只占用约 200KB 内存；压缩完成后按 keepFiles / keepBytes 删除最旧的归档。
+// 启动时遗留的未压缩归档（上次退出时尚未压缩）会重新排队，残留的 .tmp 会被删除。
+// 事件在后台线程中回调，回调中不要调用会阻塞的操作。
+class LogRotator {
+public:
+    // 通知 nginx 重新打开日志；nginx 未运行时应直接返回 true
+    typedef std::function<bool(std::string* error)> ReopenHandler;
+    typedef std::function<void(const LogRotationEvent& event)> EventHandler;
+
+    LogRotator() {}
+    ~LogRotator();
+
+    LogRotator(const LogRotator&) = delete;
+    LogRotator& operator=(const LogRotator&) = delete;
+
+    // 在 Start 之前调用
+    void SetHandlers(ReopenHandler reopen, EventHandler handler);
+    // 随时可调用，下一次检查起生效
+    void SetPolicy(const LogRotationPolicy& policy);
+    LogRotationPolicy Policy() const;
+
+    // 开始监视 prefix 下由 confPath 配置的日志，参数未变时为空操作
+    void Start(const std::string& prefix, const std::string& confPath);
+    void Stop();
+    // 配置可能已变化（重新加载后调用），下一次检查前重新收集日志文件
+    void Rescan();
+    // 下一次检查时轮转所有非空日志，不论是否达到阈值
+    void RotateNow();
+
+    LogRotationStats Stats() const;
+    std::vector<std::string> Files() const;
+
+private:
+    struct PendingArchive {
+        std::string path;            // 日志文件
+        std::string archive;
+        uint64_t size = 0;           // 上次观察到的大小
+        uint64_t dueMicros = 0;      // 下一次检查的时刻
+    };
+
+    void RunMonitor();
+    void RunCompressor();
+    void RotateFiles(const std::vector<std::string>& files);
+    void EnqueueLeftovers(const std::vector<std::string>& files);
+    void CompressArchive(const PendingArchive& item, const LogRotationPolicy& policy);
+    void Prune(const std::string& path, const LogRotationPolicy& policy);
+    void Emit(const LogRotationEvent& event);
+
+    std::thread m_monitor;
+    std::thread m_compressor;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;          // 唤醒监视线程
+    std::condition_variable m_compressWake;  // 唤醒压缩线程
+    std::atomic<bool> m_stopping{false};
+    bool m_rescan = false;
+    bool m_rotateNow = false;
+    std::string m_prefix;
+    std::string m_confPath;
+    LogRotationPolicy m_policy;
+    ReopenHandler m_reopen;
+    EventHandler m_handler;
+    std::vector<std::string> m_files;
+    std::map<std::string, int64_t> m_rotatedAt;  // 日志文件 -> 上次轮转（或开始监视）的 UTC 秒
+    std::deque<PendingArchive> m_pending;
+    bool m_compressing = false;      // 压缩线程正在处理一个归档
+    LogRotationStats m_stats;
+};
+
+// 事件的一行说明（UTF-8），成功带 ✓、失败带 ✗ 前缀
+std::string FormatLogRotationEvent(const LogRotationEvent& event);
+
+// 收集配置中写入本地文件的 access_log / error_log（去重，含 nginx 默认的 logs/access.log 与 logs/error.log），
+// 路径中带变量的、off / syslog / stderr / memory 等非文件目标被忽略
+std::vector<std::string> CollectLogFiles(const std::string& prefix, const std::string& confPath);
+
+// 一个 access 日志文件及其 log_format
+struct AccessLogSource {
+    std::string path;
+    LogFormat format;
+    std::string error;               // 格式未定义或无法编译（此时 format 为 combined，解析结果不可信）
+};
+
+// 同上，只收集 access_log 及其格式（第一项总是默认的 logs/access.log；未写格式时为 combined）
+std::vector<AccessLogSource> CollectAccessLogSources(const std::string& prefix, const std::string& confPath);
+
+// 日志 path 现有的归档（<日志>.<时间戳>[-N][.lz4]）的完整路径，按时间从旧到新排列
+std::vector<std::string> ListLogArchives(const std::string& path);
+
+// 把 source 压缩为 LZ4 帧写入 target；bytesPerSec 为读取速率上限（0 不限），cancel 置位时中止
+// 成功时 inBytes / outBytes 为原始与压缩后大小
+bool CompressFileLz4(const std::string& source, const std::string& target, uint64_t bytesPerSec,
+                     const std::atomic<bool>* cancel, uint64_t* inBytes, uint64_t* outBytes, std::string* error);
+
+#endif // LOG_ROTATOR_H
@@ -0,0 +1,1247 @@
+// nginx-manager/src/log_store.cpp
+// 访问日志列存 - 轮转后的 access 日志导入为列式分段（字典 / 差分编码 + 分段区间索引），查询按核心数并行过滤与分组聚合
+
+#include "log_store.h"
+#include "file_util.h"
+#include "line_scan.h"
+#include "log_format.h"
+#include "log_model.h"
+#include "log_rotator.h"
+#include "lz4_frame.h"
+#include "nginx_conf.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static bool EndsWith(const std::string& text, const char* suffix) {
+    size_t length = strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+// 已导入文件的标识：归档压缩前后（有无 .lz4）视为同一文件
+static std::string IngestKey(const std::string& path) {
+    std::string name = BaseName(path);
+    if (EndsWith(name, ".lz4")) name.resize(name.size() - 4);
+    return name;
+}
+
+// ---------------------------------------------------------------------------
+// 分段格式（小端）：
+//   SegmentHeader | 各列数据 ...
+// 字典区：uint32 count 个结束偏移，其后是各项内容依次相接；编码区：每行 width 字节的字典下标。
+// 时间列：每行一个 LEB128 变长整数，为相对前一行（首行相对 minSecond）的 zigzag 差分，只能顺序解码。
+// 位压缩列（响应字节、耗时）：每行 width 位，位宽取分段内的最大值所需，可按行随机读取，
+// 因此被过滤掉的行不必解码；末尾补 8 字节，按 64 位读取时不会越界。
+
+static const uint32_t kSegmentMagic = 0x53434C4E;   // "NLCS"
+static const uint16_t kSegmentVersion = 1;
+static const char* kSegmentSuffix = ".seg";
+static const char* kManifestName = "ingested.txt";
+
+enum SegmentColumn {
+    COLUMN_TIME,
+    COLUMN_STATUS,
+    COLUMN_METHOD,
+    COLUMN_HOST,
+    COLUMN_URI,
+    COLUMN_BYTES,
+    COLUMN_REQUEST_MS,
+    COLUMN_COUNT
+};
+
+struct ColumnInfo {
+    uint64_t offset;                 // 编码区 / 变长或位压缩数据
+    uint64_t size;
+    uint64_t dictOffset;             // 以下只用于字典列
+    uint32_t dictSize;
+    uint32_t dictCount;
+    uint32_t width;                  // 字典列：下标的字节数 1 / 2 / 4；位压缩列：每行的位数；时间列为 0
+    uint32_t reserved;
+};
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t columns;
+    uint32_t rows;
+    uint32_t checksum;               // 整个头部（本字段置 0）的 XXH32
+    int64_t minSecond;               // 以下为区间索引
+    int64_t maxSecond;
+    uint16_t minStatus;
+    uint16_t maxStatus;
+    uint32_t maxRequestMs;
+    uint64_t totalBytes;
+    ColumnInfo column[COLUMN_COUNT];
+};
+
+static_assert(sizeof(ColumnInfo) == 40, "ColumnInfo 布局");
+static_assert(sizeof(SegmentHeader) == 48 + 40 * COLUMN_COUNT, "SegmentHeader 布局");
+
+static uint32_t HeaderChecksum(SegmentHeader header) {
+    header.checksum = 0;
+    return HashBytes32(&header, sizeof(header));
+}
+
+static inline void PutVarint(std::string* out, uint64_t value) {
+    while (value >= 0x80) {
+        out->push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out->push_back((char)value);
+}
+
+// 越过 end 时返回 nullptr（数据损坏）
+static inline const uint8_t* GetVarint(const uint8_t* p, const uint8_t* end, uint64_t* value) {
+    if (p < end && *p < 0x80) {
+        *value = *p;
+        return p + 1;
+    }
+    uint64_t result = 0;
+    for (uint32_t shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            *value = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// 位压缩列的最大位宽，保证一次 64 位读取总能取到整个值
+static const uint32_t kMaxPackedBits = 56;
+
+static inline uint32_t BitWidth(uint64_t value) {
+    uint32_t bits = 0;
+    while (bits < 64 && (value >> bits)) ++bits;
+    return bits;
+}
+
+static size_t PackedSize(uint32_t rows, uint32_t bits) {
+    return ((size_t)rows * bits + 7) / 8 + 8;
+}
+
+static void PackBits(const std::vector<uint64_t>& values, uint32_t bits, std::string* out) {
+    size_t begin = out->size();
+    out->resize(begin + PackedSize((uint32_t)values.size(), bits), 0);
+    uint8_t* base = (uint8_t*)&(*out)[begin];
+    uint64_t bit = 0;
+    for (uint64_t value : values) {
+        uint64_t word;
+        memcpy(&word, base + bit / 8, 8);
+        word |= value << (bit & 7);
+        memcpy(base + bit / 8, &word, 8);
+        bit += bits;
+    }
+}
+
+static inline uint64_t UnpackBits(const uint8_t* base, uint32_t bits, uint64_t mask, uint32_t row) {
+    uint64_t bit = (uint64_t)row * bits;
+    uint64_t word;
+    memcpy(&word, base + bit / 8, 8);
+    return (word >> (bit & 7)) & mask;
+}
+
+static inline uint64_t ZigZag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t UnZigZag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// 字典下标列：宽度在分段内固定，按宽度实例化，循环内没有分支
+template <typename Code>
+static inline uint32_t CodeAt(const uint8_t* codes, uint32_t row) {
+    Code code;
+    memcpy(&code, codes + (size_t)row * sizeof(Code), sizeof(Code));
+    return code;
+}
+
+// 只保留 rows 中编码满足 match 的行，返回保留的行数
+template <typename Code>
+static uint32_t FilterRows(const uint8_t* codes, const uint8_t* match, uint32_t count, uint32_t* rows, uint32_t n) {
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t row = rows[i];
+        uint32_t code = CodeAt<Code>(codes, row);
+        rows[kept] = row;
+        kept += code < count && match[code];
+    }
+    return kept;
+}
+
+template <typename Code>
+static void GatherCodes(const uint8_t* codes, const uint32_t* rows, uint32_t n, uint32_t* out) {
+    for (uint32_t i = 0; i < n; ++i) out[i] = CodeAt<Code>(codes, rows[i]);
+}
+
+// ---------------------------------------------------------------------------
+// 分段写入
+
+// 分段内的字典：值存放在 deque 中（元素地址不变），索引以 string_view 引用它们，查找时不分配内存
+class SegmentDictionary {
+public:
+    uint32_t Code(std::string_view value) {
+        auto found = m_index.find(value);
+        if (found != m_index.end()) return found->second;
+        uint32_t code = (uint32_t)m_values.size();
+        m_values.emplace_back(value);
+        m_index.emplace(std::string_view(m_values.back()), code);
+        return code;
+    }
+
+    void Clear() {
+        m_index.clear();
+        m_values.clear();
+    }
+
+    uint32_t Size() const { return (uint32_t)m_values.size(); }
+
+    // 写出字典区，返回写入的字节数
+    uint32_t Write(std::string* out) const {
+        size_t begin = out->size();
+        uint32_t end = 0;
+        for (const std::string& value : m_values) {
+            end += (uint32_t)value.size();
+            out->append((const char*)&end, 4);
+        }
+        for (const std::string& value : m_values) out->append(value);
+        return (uint32_t)(out->size() - begin);
+    }
+
+private:
+    std::deque<std::string> m_values;
+    std::unordered_map<std::string_view, uint32_t> m_index;
+};
+
+class SegmentBuilder {
+public:
+    SegmentBuilder() { Clear(); }
+
+    void Add(const AccessLogEntry& entry) {
+        char status[4] = { (char)('0' + entry.status / 100 % 10), (char)('0' + entry.status / 10 % 10),
+                           (char)('0' + entry.status % 10), 0 };
+        m_seconds.push_back(entry.second);
+        m_codes[0].push_back(m_dictionaries[0].Code(std::string_view(status, 3)));
+        m_codes[1].push_back(m_dictionaries[1].Code(entry.method));
+        m_codes[2].push_back(m_dictionaries[2].Code(entry.host));
+        m_codes[3].push_back(m_dictionaries[3].Code(entry.uri));
+        m_packed[0].push_back(std::min<uint64_t>(entry.bytes, (1ull << kMaxPackedBits) - 1));
+        m_packed[1].push_back(entry.requestMs);
+
+        m_header.minSecond = std::min(m_header.minSecond, entry.second);
+        m_header.maxSecond = std::max(m_header.maxSecond, entry.second);
+        m_header.minStatus = std::min(m_header.minStatus, (uint16_t)entry.status);
+        m_header.maxStatus = std::max(m_header.maxStatus, (uint16_t)entry.status);
+        m_header.maxRequestMs = std::max(m_header.maxRequestMs, entry.requestMs);
+        m_header.totalBytes += entry.bytes;
+        ++m_header.rows;
+    }
+
+    uint32_t Rows() const { return m_header.rows; }
+
+    void Clear() {
+        memset(&m_header, 0, sizeof(m_header));
+        m_header.minSecond = INT64_MAX;
+        m_header.maxSecond = INT64_MIN;
+        m_header.minStatus = UINT16_MAX;
+        m_seconds.clear();
+        for (int i = 0; i < 4; ++i) {
+            m_dictionaries[i].Clear();
+            m_codes[i].clear();
+        }
+        m_packed[0].clear();
+        m_packed[1].clear();
+    }
+
+    // 写出分段文件（先写 .tmp 再改名），返回文件大小，失败时返回 0
+    uint64_t Write(const std::string& path, std::string* error) {
+        std::string body;
+        body.reserve(m_header.rows * 12);
+        SegmentHeader header = m_header;
+        header.magic = kSegmentMagic;
+        header.version = kSegmentVersion;
+        header.columns = COLUMN_COUNT;
+
+        auto place = [&body](ColumnInfo* column, size_t begin) {
+            column->offset = sizeof(SegmentHeader) + begin;
+            column->size = body.size() - begin;
+        };
+
+        size_t begin = body.size();
+        int64_t previous = header.minSecond;
+        for (int64_t second : m_seconds) {
+            PutVarint(&body, ZigZag(second - previous));
+            previous = second;
+        }
+        place(&header.column[COLUMN_TIME], begin);
+
+        static const SegmentColumn kDictionaryColumns[4] = { COLUMN_STATUS, COLUMN_METHOD, COLUMN_HOST, COLUMN_URI };
+        for (int i = 0; i < 4; ++i) {
+            ColumnInfo& column = header.column[kDictionaryColumns[i]];
+            column.dictOffset = sizeof(SegmentHeader) + body.size();
+            column.dictCount = m_dictionaries[i].Size();
+            column.dictSize = m_dictionaries[i].Write(&body);
+            column.width = column.dictCount <= 0x100 ? 1 : column.dictCount <= 0x10000 ? 2 : 4;
+            begin = body.size();
+            body.resize(begin + (size_t)column.width * m_codes[i].size());
+            char* out = &body[begin];
+            for (uint32_t code : m_codes[i]) {
+                memcpy(out, &code, column.width);   // 小端：低位字节在前
+                out += column.width;
+            }
+            place(&column, begin);
+        }
+
+        static const SegmentColumn kPackedColumns[2] = { COLUMN_BYTES, COLUMN_REQUEST_MS };
+        for (int i = 0; i < 2; ++i) {
+            ColumnInfo& column = header.column[kPackedColumns[i]];
+            uint64_t maxValue = 0;
+            for (uint64_t value : m_packed[i]) maxValue = std::max(maxValue, value);
+            column.width = BitWidth(maxValue);
+            begin = body.size();
+            PackBits(m_packed[i], column.width, &body);
+            place(&column, begin);
+        }
+        header.checksum = HeaderChecksum(header);
+
+        std::string temp = path + ".tmp";
+        FILE* file = OpenFile(temp, "wb");
+        if (!file) {
+            if (error) *error = "无法创建 " + temp;
+            return 0;
+        }
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(body.data(), 1, body.size(), file) == body.size();
+        ok = fclose(file) == 0 && ok;
+        if (!ok || !RenameFile(temp, path)) {
+            RemoveFile(temp);
+            if (error) *error = "无法写入 " + path;
+            return 0;
+        }
+        return sizeof(header) + body.size();
+    }
+
+private:
+    SegmentHeader m_header;
+    std::vector<int64_t> m_seconds;
+    SegmentDictionary m_dictionaries[4];    // 状态码、方法、Host、路径
+    std::vector<uint32_t> m_codes[4];
+    std::vector<uint64_t> m_packed[2];      // 响应字节、耗时
+};
+
+// ---------------------------------------------------------------------------
+// 分段读取
+
+class SegmentView {
+public:
+    bool Open(const std::string& path) {
+        if (!m_file.Open(path) || m_file.Size() < sizeof(SegmentHeader)) return false;
+        memcpy(&m_header, m_file.Data(), sizeof(m_header));
+        if (m_header.magic != kSegmentMagic || m_header.version != kSegmentVersion ||
+            m_header.columns != COLUMN_COUNT || m_header.checksum != HeaderChecksum(m_header)) {
+            return false;
+        }
+        uint64_t size = m_file.Size();
+        for (int i = 0; i < COLUMN_COUNT; ++i) {
+            const ColumnInfo& column = m_header.column[i];
+            if (column.offset > size || column.size > size - column.offset) return false;
+            if (i == COLUMN_BYTES || i == COLUMN_REQUEST_MS) {
+                if (column.width > kMaxPackedBits || column.size != PackedSize(m_header.rows, column.width)) return false;
+                continue;
+            }
+            if (column.width == 0) continue;
+            if (column.dictOffset > size || column.dictSize > size - column.dictOffset ||
+                column.dictSize < (uint64_t)column.dictCount * 4 ||
+                column.size != (uint64_t)column.width * m_header.rows) {
+                return false;
+            }
+            // 结束偏移须递增且不越过字典区
+            const uint8_t* ends = Bytes() + column.dictOffset;
+            uint32_t limit = column.dictSize - column.dictCount * 4;
+            uint32_t previous = 0;
+            for (uint32_t code = 0; code < column.dictCount; ++code) {
+                uint32_t end;
+                memcpy(&end, ends + code * 4, 4);
+                if (end < previous || end > limit) return false;
+                previous = end;
+            }
+        }
+        return true;
+    }
+
+    const SegmentHeader& Header() const { return m_header; }
+
+    const uint8_t* Column(SegmentColumn column) const { return Bytes() + m_header.column[column].offset; }
+
+    std::string_view Entry(SegmentColumn column, uint32_t code) const {
+        const ColumnInfo& info = m_header.column[column];
+        const uint8_t* ends = Bytes() + info.dictOffset;
+        const char* values = (const char*)ends + info.dictCount * 4;
+        uint32_t begin = 0;
+        uint32_t end;
+        if (code > 0) memcpy(&begin, ends + (code - 1) * 4, 4);
+        memcpy(&end, ends + code * 4, 4);
+        return std::string_view(values + begin, end - begin);
+    }
+
+private:
+    const uint8_t* Bytes() const { return (const uint8_t*)m_file.Data(); }
+
+    MappedFile m_file;
+    SegmentHeader m_header;
+};
+
+// ---------------------------------------------------------------------------
+// 聚合
+
+// 对数分桶：16 以下每个整数一桶，之后每个 2 的幂区间分 8 桶，桶宽不超过下界的 1/8；
+// 超过 2^22 ms（约 70 分钟）的归入最后一桶
+static const uint32_t kLatencyBuckets = 16 + 18 * 8;
+
+// 最高的置位位（value 不为 0）
+static inline uint32_t HighestBit(uint32_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, value);
+    return (uint32_t)index;
+#else
+    return 31 - (uint32_t)__builtin_clz(value);
+#endif
+}
+
+static inline uint32_t LatencyBucket(uint32_t ms) {
+    if (ms < 16) return ms;
+    if (ms >= (1u << 22)) return kLatencyBuckets - 1;
+    uint32_t msb = HighestBit(ms);
+    return 16 + (msb - 4) * 8 + ((ms >> (msb - 3)) & 7);
+}
+
+// 桶的中点
+static uint32_t BucketValue(uint32_t bucket) {
+    if (bucket < 16) return bucket;
+    uint32_t octave = (bucket - 16) / 8 + 4;
+    uint32_t sub = (bucket - 16) % 8;
+    uint64_t low = (uint64_t)(8 + sub) << (octave - 3);
+    uint64_t width = 1ull << (octave - 3);
+    return (uint32_t)std::min<uint64_t>(low + width / 2, UINT32_MAX);
+}
+
+// 一个分组的累计值。请求数很少的分组（多见于路径分组的长尾）直接保存各次耗时，
+// 超过 kInlineSamples 次才分配直方图，分组再多内存也只与分组数成正比
+struct GroupAccumulator {
+    static const uint32_t kInlineSamples = 28;
+
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t sumMs = 0;
+    uint32_t maxMs = 0;
+    uint32_t samples[kInlineSamples] = {};
+    std::unique_ptr<uint32_t[]> histogram;
+
+    void Add(uint64_t requestBytes, uint32_t ms) {
+        if (!histogram && count >= kInlineSamples) Spill();
+        if (histogram) {
+            ++histogram[LatencyBucket(ms)];
+        } else {
+            samples[count] = ms;
+        }
+        ++count;
+        bytes += requestBytes;
+        sumMs += ms;
+        maxMs = std::max(maxMs, ms);
+    }
+
+    void Merge(const GroupAccumulator& other) {
+        if (!histogram && count + other.count > kInlineSamples) Spill();
+        if (histogram) {
+            if (other.histogram) {
+                for (uint32_t i = 0; i < kLatencyBuckets; ++i) histogram[i] += other.histogram[i];
+            } else {
+                for (uint64_t i = 0; i < other.count; ++i) ++histogram[LatencyBucket(other.samples[i])];
+            }
+        } else {
+            for (uint64_t i = 0; i < other.count; ++i) samples[count + i] = other.samples[i];
+        }
+        count += other.count;
+        bytes += other.bytes;
+        sumMs += other.sumMs;
+        maxMs = std::max(maxMs, other.maxMs);
+    }
+
+    uint32_t Percentile(double percentile) const {
+        if (count == 0) return 0;
+        uint64_t rank = (uint64_t)(percentile / 100.0 * (double)count + 0.999999);
+        if (rank == 0) rank = 1;
+        if (!histogram) {
+            // 至多 kInlineSamples 个，插入排序
+            uint32_t sorted[kInlineSamples];
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t j = i;
+                for (; j > 0 && sorted[j - 1] > samples[i]; --j) sorted[j] = sorted[j - 1];
+                sorted[j] = samples[i];
+            }
+            return sorted[rank - 1];
+        }
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < kLatencyBuckets; ++i) {
+            seen += histogram[i];
+            if (seen >= rank) return std::min(BucketValue(i), maxMs);
+        }
+        return maxMs;
+    }
+
+private:
+    void Spill() {
+        histogram.reset(new uint32_t[kLatencyBuckets]());
+        for (uint64_t i = 0; i < count; ++i) ++histogram[LatencyBucket(samples[i])];
+    }
+};
+
+// 一个查询线程的分组表
+struct Aggregator {
+    std::unordered_map<std::string, uint32_t> index;
+    std::vector<std::string> keys;
+    std::vector<GroupAccumulator> groups;
+
+    uint32_t Slot(std::string_view key) {
+        auto found = index.find(std::string(key));
+        if (found != index.end()) return found->second;
+        uint32_t slot = (uint32_t)keys.size();
+        keys.emplace_back(key);
+        groups.emplace_back();
+        index.emplace(keys.back(), slot);
+        return slot;
+    }
+};
+
+static bool IsTimeGroup(LogGroupBy groupBy) {
+    return groupBy == LOG_GROUP_MINUTE || groupBy == LOG_GROUP_HOUR || groupBy == LOG_GROUP_DAY;
+}
+
+static int64_t TimeBucketSeconds(LogGroupBy groupBy) {
+    return groupBy == LOG_GROUP_MINUTE ? 60 : groupBy == LOG_GROUP_HOUR ? 3600 : 86400;
+}
+
+static SegmentColumn GroupColumn(LogGroupBy groupBy) {
+    switch (groupBy) {
+    case LOG_GROUP_URI: return COLUMN_URI;
+    case LOG_GROUP_STATUS: return COLUMN_STATUS;
+    case LOG_GROUP_METHOD: return COLUMN_METHOD;
+    case LOG_GROUP_HOST: return COLUMN_HOST;
+    default: return COLUMN_COUNT;
+    }
+}
+
+// 对字典逐项求值；filter 为空时返回空表（不过滤）。prefix 为 true 时按前缀匹配
+static std::vector<uint8_t> MatchDictionary(const SegmentView& segment, SegmentColumn column, const std::string& filter,
+                                            bool prefix) {
+    std::vector<uint8_t> match;
+    if (filter.empty()) return match;
+    uint32_t count = segment.Header().column[column].dictCount;
+    match.resize(count);
+    for (uint32_t code = 0; code < count; ++code) {
+        std::string_view value = segment.Entry(column, code);
+        match[code] = prefix ? value.compare(0, filter.size(), filter) == 0 && value.size() >= filter.size()
+                             : value == filter;
+    }
+    return match;
+}
+
+struct ScanCounters {
+    uint64_t scannedRows = 0;
+    uint64_t matchedRows = 0;
+    uint64_t scannedBytes = 0;
+    uint32_t segmentsScanned = 0;
+};
+
+struct CodeColumn {
+    const uint8_t* codes = nullptr;  // 为空表示本次查询不读取该列
+    uint32_t width = 0;
+    uint32_t count = 0;
+
+    uint32_t Filter(const uint8_t* match, uint32_t* rows, uint32_t n) const {
+        switch (width) {
+        case 1: return FilterRows<uint8_t>(codes, match, count, rows, n);
+        case 2: return FilterRows<uint16_t>(codes, match, count, rows, n);
+        default: return FilterRows<uint32_t>(codes, match, count, rows, n);
+        }
+    }
+
+    void Gather(const uint32_t* rows, uint32_t n, uint32_t* out) const {
+        switch (width) {
+        case 1: GatherCodes<uint8_t>(codes, rows, n, out); break;
+        case 2: GatherCodes<uint16_t>(codes, rows, n, out); break;
+        default: GatherCodes<uint32_t>(codes, rows, n, out); break;
+        }
+    }
+};
+
+// 每次处理的行数：各列依次对同一块行求值，选中的行号放在选择向量中
+static const uint32_t kBlockRows = 1024;
+
+// 扫描一个分段，匹配的行累加到 aggregator；区间索引排除时直接返回
+static void ScanSegment(const SegmentView& segment, const LogQuery& query, int64_t localOffset,
+                        Aggregator* aggregator, ScanCounters* counters) {
+    const SegmentHeader& header = segment.Header();
+    if (header.rows == 0 || header.maxSecond < query.fromSecond || header.minSecond >= query.toSecond ||
+        header.maxStatus < query.statusMin || header.minStatus > query.statusMax) {
+        return;
+    }
+
+    // 字典列的过滤条件先对字典求值；没有任何一项满足时整段排除
+    std::vector<uint8_t> statusMatch(header.column[COLUMN_STATUS].dictCount);
+    bool anyStatus = false;
+    for (uint32_t code = 0; code < statusMatch.size(); ++code) {
+        int status = atoi(std::string(segment.Entry(COLUMN_STATUS, code)).c_str());
+        statusMatch[code] = status >= query.statusMin && status <= query.statusMax;
+        anyStatus = anyStatus || statusMatch[code];
+    }
+    bool allStatus = std::find(statusMatch.begin(), statusMatch.end(), 0) == statusMatch.end();
+    std::vector<uint8_t> methodMatch = MatchDictionary(segment, COLUMN_METHOD, query.method, false);
+    std::vector<uint8_t> hostMatch = MatchDictionary(segment, COLUMN_HOST, query.host, false);
+    std::vector<uint8_t> uriMatch = MatchDictionary(segment, COLUMN_URI, query.uriPrefix, true);
+    auto none = [](const std::vector<uint8_t>& match, const std::string& filter) {
+        return !filter.empty() && std::find(match.begin(), match.end(), 1) == match.end();
+    };
+    if (!anyStatus || none(methodMatch, query.method) || none(hostMatch, query.host) ||
+        none(uriMatch, query.uriPrefix)) {
+        return;
+    }
+
+    ++counters->segmentsScanned;
+    counters->scannedRows += header.rows;
+
+    // 分段完全落在时间范围内时不必按时间过滤，再不按时间分组就不必解码时间列
+    bool timeGroup = IsTimeGroup(query.groupBy);
+    bool timeFilter = header.minSecond < query.fromSecond || header.maxSecond >= query.toSecond;
+    bool needTime = timeGroup || timeFilter;
+    SegmentColumn groupColumn = GroupColumn(query.groupBy);
+
+    auto codeColumn = [&](SegmentColumn column, bool used) {
+        CodeColumn result;
+        if (!used) return result;
+        result.codes = segment.Column(column);
+        result.width = header.column[column].width;
+        result.count = header.column[column].dictCount;
+        counters->scannedBytes += header.column[column].size;
+        return result;
+    };
+    CodeColumn status = codeColumn(COLUMN_STATUS, !allStatus || groupColumn == COLUMN_STATUS);
+    CodeColumn method = codeColumn(COLUMN_METHOD, !methodMatch.empty() || groupColumn == COLUMN_METHOD);
+    CodeColumn host = codeColumn(COLUMN_HOST, !hostMatch.empty() || groupColumn == COLUMN_HOST);
+    CodeColumn uri = codeColumn(COLUMN_URI, !uriMatch.empty() || groupColumn == COLUMN_URI);
+    CodeColumn group = groupColumn == COLUMN_STATUS ? status : groupColumn == COLUMN_METHOD ? method
+                     : groupColumn == COLUMN_HOST ? host : groupColumn == COLUMN_URI ? uri : CodeColumn();
+    if (needTime) counters->scannedBytes += header.column[COLUMN_TIME].size;
+    counters->scannedBytes += header.column[COLUMN_BYTES].size + header.column[COLUMN_REQUEST_MS].size;
+
+    const uint8_t* timeIn = segment.Column(COLUMN_TIME);
+    const uint8_t* timeEnd = timeIn + header.column[COLUMN_TIME].size;
+    const uint8_t* bytesColumn = segment.Column(COLUMN_BYTES);
+    uint32_t bytesBits = header.column[COLUMN_BYTES].width;
+    uint64_t bytesMask = bytesBits ? ~0ull >> (64 - bytesBits) : 0;
+    const uint8_t* msColumn = segment.Column(COLUMN_REQUEST_MS);
+    uint32_t msBits = header.column[COLUMN_REQUEST_MS].width;
+    uint64_t msMask = msBits ? ~0ull >> (64 - msBits) : 0;
+    auto add = [&](GroupAccumulator& accumulator, uint32_t row) {
+        accumulator.Add(UnpackBits(bytesColumn, bytesBits, bytesMask, row),
+                        (uint32_t)UnpackBits(msColumn, msBits, msMask, row));
+    };
+
+    // 分组键按字典下标缓存：每个不同的值在每个分段中只查一次哈希表
+    const uint32_t kNoSlot = UINT32_MAX;
+    std::vector<uint32_t> slots(group.count, kNoSlot);
+    uint32_t fixedSlot = groupColumn == COLUMN_COUNT && !timeGroup ? aggregator->Slot("全部") : kNoSlot;
+    int64_t bucketSeconds = timeGroup ? TimeBucketSeconds(query.groupBy) : 1;
+    int64_t lastBucket = INT64_MIN;
+    uint32_t lastBucketSlot = kNoSlot;
+
+    int64_t seconds[kBlockRows];
+    uint32_t selected[kBlockRows];
+    uint32_t codes[kBlockRows];
+    int64_t second = header.minSecond;
+    uint64_t matched = 0;
+    for (uint32_t start = 0; start < header.rows; start += kBlockRows) {
+        uint32_t n = std::min(kBlockRows, header.rows - start);
+        if (needTime) {
+            for (uint32_t i = 0; i < n; ++i) {
+                uint64_t delta;
+                timeIn = GetVarint(timeIn, timeEnd, &delta);
+                if (!timeIn) {
+                    counters->matchedRows += matched;
+                    return;          // 数据损坏，只统计之前的行
+                }
+                second += UnZigZag(delta);
+                seconds[i] = second;
+            }
+        }
+        uint32_t count = 0;
+        if (timeFilter) {
+            for (uint32_t i = 0; i < n; ++i) {
+                selected[count] = start + i;
+                count += seconds[i] >= query.fromSecond && seconds[i] < query.toSecond;
+            }
+        } else {
+            for (uint32_t i = 0; i < n; ++i) selected[i] = start + i;
+            count = n;
+        }
+        if (!allStatus) count = status.Filter(statusMatch.data(), selected, count);
+        if (!methodMatch.empty()) count = method.Filter(methodMatch.data(), selected, count);
+        if (!hostMatch.empty()) count = host.Filter(hostMatch.data(), selected, count);
+        if (!uriMatch.empty()) count = uri.Filter(uriMatch.data(), selected, count);
+        if (count == 0) continue;
+
+        if (group.codes) {
+            group.Gather(selected, count, codes);
+            for (uint32_t i = 0; i < count; ++i) {
+                uint32_t code = codes[i];
+                if (code >= group.count) continue;
+                uint32_t slot = slots[code];
+                if (slot == kNoSlot) slot = slots[code] = aggregator->Slot(segment.Entry(groupColumn, code));
+                add(aggregator->groups[slot], selected[i]);
+                ++matched;
+            }
+        } else if (timeGroup) {
+            for (uint32_t i = 0; i < count; ++i) {
+                // 按本地时间对齐的桶，键为桶起点的 UTC 秒
+                int64_t local = seconds[selected[i] - start] + localOffset;
+                int64_t bucket = (local >= 0 ? local / bucketSeconds : (local - bucketSeconds + 1) / bucketSeconds) *
+                                 bucketSeconds - localOffset;
+                if (bucket != lastBucket) {
+                    lastBucket = bucket;
+                    lastBucketSlot = aggregator->Slot(std::to_string(bucket));
+                }
+                add(aggregator->groups[lastBucketSlot], selected[i]);
+            }
+            matched += count;
+        } else {
+            GroupAccumulator& accumulator = aggregator->groups[fixedSlot];
+            for (uint32_t i = 0; i < count; ++i) add(accumulator, selected[i]);
+            matched += count;
+        }
+    }
+    counters->matchedRows += matched;
+}
+
+static std::string FormatLocalTime(int64_t utcSeconds, LogGroupBy groupBy) {
+    time_t seconds = (time_t)(utcSeconds + LocalOffsetMicros() / 1000000);
+    struct tm parts;
+#ifdef _WIN32
+    gmtime_s(&parts, &seconds);
+#else
+    gmtime_r(&seconds, &parts);
+#endif
+    char text[64];
+    if (groupBy == LOG_GROUP_DAY) {
+        snprintf(text, sizeof(text), "%04d-%02d-%02d", parts.tm_year + 1900, parts.tm_mon + 1, parts.tm_mday);
+    } else {
+        snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d", parts.tm_year + 1900, parts.tm_mon + 1,
+                 parts.tm_mday, parts.tm_hour, parts.tm_min);
+    }
+    return text;
+}
+
+LogQueryResult LogStore::Query(const LogQuery& query) const {
+    uint64_t begin = MonotonicMicros();
+    LogQueryResult result;
+    std::vector<std::string> segments = ListSegments();
+    result.segments = (uint32_t)segments.size();
+
+    uint32_t threads = query.threads ? query.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max(1u, std::min<uint32_t>(threads, (uint32_t)segments.size()));
+    result.threads = threads;
+    int64_t localOffset = LocalOffsetMicros() / 1000000;
+
+    std::vector<Aggregator> aggregators(threads);
+    std::vector<ScanCounters> counters(threads);
+    std::vector<uint64_t> totalRows(threads, 0);
+    std::vector<std::string> errors(threads);
+    std::atomic<size_t> next{0};
+    auto worker = [&](uint32_t index) {
+        SegmentView segment;
+        for (size_t i = next++; i < segments.size(); i = next++) {
+            if (!segment.Open(segments[i])) {
+                errors[index] = "分段损坏或无法读取: " + segments[i];
+                continue;
+            }
+            totalRows[index] += segment.Header().rows;
+            ScanSegment(segment, query, localOffset, &aggregators[index], &counters[index]);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (uint32_t i = 1; i < threads; ++i) pool.emplace_back(worker, i);
+    worker(0);
+    for (std::thread& thread : pool) thread.join();
+
+    // 各线程的分组表合并到第一个
+    Aggregator& merged = aggregators[0];
+    for (uint32_t i = 0; i < threads; ++i) {
+        if (i > 0) {
+            for (size_t slot = 0; slot < aggregators[i].keys.size(); ++slot) {
+                merged.groups[merged.Slot(aggregators[i].keys[slot])].Merge(aggregators[i].groups[slot]);
+            }
+        }
+        result.matchedRows += counters[i].matchedRows;
+        result.scannedRows += counters[i].scannedRows;
+        result.scannedBytes += counters[i].scannedBytes;
+        result.segmentsScanned += counters[i].segmentsScanned;
+        result.totalRows += totalRows[i];
+        if (!errors[i].empty()) result.error = errors[i];
+    }
+
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < merged.keys.size(); ++i) {
+        if (merged.groups[i].count > 0) order.push_back(i);
+    }
+    LogOrderBy orderBy = query.orderBy;
+    auto keyLess = [&merged, &query](uint32_t a, uint32_t b) {
+        if (IsTimeGroup(query.groupBy)) return atoll(merged.keys[a].c_str()) < atoll(merged.keys[b].c_str());
+        return merged.keys[a] < merged.keys[b];
+    };
+    std::vector<uint32_t> p50(merged.keys.size()), p99(merged.keys.size());
+    if (orderBy == LOG_ORDER_P50 || orderBy == LOG_ORDER_P99) {
+        for (uint32_t i : order) {
+            p50[i] = merged.groups[i].Percentile(50);
+            p99[i] = merged.groups[i].Percentile(99);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const GroupAccumulator& x = merged.groups[a];
+        const GroupAccumulator& y = merged.groups[b];
+        switch (orderBy) {
+        case LOG_ORDER_BYTES:
+            if (x.bytes != y.bytes) return x.bytes > y.bytes;
+            break;
+        case LOG_ORDER_P50:
+            if (p50[a] != p50[b]) return p50[a] > p50[b];
+            break;
+        case LOG_ORDER_P99:
+            if (p99[a] != p99[b]) return p99[a] > p99[b];
+            break;
+        case LOG_ORDER_KEY:
+            return keyLess(a, b);
+        default:
+            break;
+        }
+        if (x.count != y.count) return x.count > y.count;
+        return keyLess(a, b);
+    });
+
+    result.groupCount = order.size();
+    if (query.limit > 0 && order.size() > query.limit) order.resize(query.limit);
+    for (uint32_t i : order) {
+        const GroupAccumulator& accumulator = merged.groups[i];
+        LogQueryGroup group;
+        group.key = IsTimeGroup(query.groupBy) ? FormatLocalTime(atoll(merged.keys[i].c_str()), query.groupBy)
+                                               : merged.keys[i];
+        group.count = accumulator.count;
+        group.bytes = accumulator.bytes;
+        group.meanMs = accumulator.count ? (double)accumulator.sumMs / accumulator.count : 0;
+        group.p50Ms = accumulator.Percentile(50);
+        group.p90Ms = accumulator.Percentile(90);
+        group.p99Ms = accumulator.Percentile(99);
+        group.maxMs = accumulator.maxMs;
+        result.groups.push_back(group);
+    }
+    result.micros = MonotonicMicros() - begin;
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// 导入
+
+std::vector<std::string> LogStore::ListSegments() const {
+    std::vector<std::string> segments;
+    for (const std::string& name : ListDirectory(m_directory)) {
+        if (EndsWith(name, kSegmentSuffix)) segments.push_back(JoinPath(m_directory, name));
+    }
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+std::vector<std::string> LogStore::LoadManifest() const {
+    std::vector<std::string> keys;
+    FILE* file = OpenFile(JoinPath(m_directory, kManifestName), "rb");
+    if (!file) return keys;
+    char line[1024];
+    while (fgets(line, sizeof(line), file)) {
+        char* tab = strchr(line, '\t');
+        if (tab) keys.emplace_back(line, tab);
+    }
+    fclose(file);
+    return keys;
+}
+
+bool LogStore::IngestFile(const std::string& path, const LogFormat& format, LogIngestStats* stats,
+                          const std::atomic<bool>* cancel) {
+    std::lock_guard<std::mutex> lock(m_ingestMutex);
+    uint64_t begin = MonotonicMicros();
+    std::string key = IngestKey(path);
+    auto fail = [stats](const std::string& error) {
+        ++stats->failed;
+        stats->error = error;
+        return false;
+    };
+    std::vector<std::string> manifest = LoadManifest();
+    if (std::find(manifest.begin(), manifest.end(), key) != manifest.end()) {
+        ++stats->skipped;
+        return true;
+    }
+    if (!MakeDirectory(m_directory)) return fail("无法创建目录 " + m_directory);
+
+    // 上次中断留下的分段
+    std::string segmentPrefix = key + ".";
+    for (const std::string& name : ListDirectory(m_directory)) {
+        if (name.compare(0, segmentPrefix.size(), segmentPrefix) == 0 &&
+            (EndsWith(name, kSegmentSuffix) || EndsWith(name, ".tmp"))) {
+            RemoveFile(JoinPath(m_directory, name));
+        }
+    }
+
+    MappedFile file;
+    if (!file.Open(path)) return fail("无法读取 " + path);
+
+    SegmentBuilder builder;
+    LogFormatParser parser(format);
+    AccessLogEntry entry;
+    std::string carry;               // 跨块的半行
+    uint32_t written = 0;
+    uint64_t lines = 0;
+    uint64_t rows = 0;
+    uint64_t inputBytes = 0;
+    uint64_t storedBytes = 0;
+    std::string error;
+    auto flush = [&]() {
+        if (builder.Rows() == 0) return true;
+        char suffix[32];
+        snprintf(suffix, sizeof(suffix), "%04u", written);
+        uint64_t size = builder.Write(JoinPath(m_directory, segmentPrefix + suffix + kSegmentSuffix), &error);
+        if (size == 0) return false;
+        ++written;
+        rows += builder.Rows();
+        storedBytes += size;
+        builder.Clear();
+        return true;
+    };
+    auto addLine = [&](const char* line, size_t length) {
+        ++lines;
+        if (parser.Parse(line, length, &entry)) builder.Add(entry);
+        return builder.Rows() < kSegmentRows || flush();
+    };
+    auto consume = [&](const char* data, size_t size) {
+        if (cancel && *cancel) return false;
+        inputBytes += size;
+        const char* end = data + size;
+        const char* p = data;
+        if (!carry.empty()) {
+            const char* newline = FindNewline(p, end);
+            carry.append(p, (size_t)(newline - p));
+            if (newline == end) return true;
+            if (!addLine(carry.data(), carry.size())) return false;
+            carry.clear();
+            p = newline + 1;
+        }
+        while (p < end) {
+            const char* newline = FindNewline(p, end);
+            if (newline == end) {
+                carry.assign(p, (size_t)(end - p));
+                break;
+            }
+            if (newline > p && !addLine(p, (size_t)(newline - p))) return false;
+            p = newline + 1;
+        }
+        return true;
+    };
+
+    bool ok;
+    if (EndsWith(path, ".lz4")) {
+        std::string decodeError;
+        ok = Lz4DecodeFrameBlocks((const uint8_t*)file.Data(), file.Size(), consume, &decodeError);
+        if (!ok && error.empty()) error = decodeError;
+    } else {
+        // 明文按 1MB 一块处理，以便及时响应取消
+        ok = true;
+        for (size_t offset = 0; ok && offset < file.Size(); offset += 1 << 20) {
+            ok = consume(file.Data() + offset, std::min<size_t>(1 << 20, file.Size() - offset));
+        }
+    }
+    if (ok && !carry.empty()) ok = addLine(carry.data(), carry.size());
+    if (ok) ok = flush();
+    if (cancel && *cancel) return false;
+    if (!ok) return fail(path + ": " + error);
+
+    FILE* list = OpenFile(JoinPath(m_directory, kManifestName), "ab");
+    if (!list) return fail("无法写入 " + JoinPath(m_directory, kManifestName));
+    fprintf(list, "%s\t%llu\t%u\n", key.c_str(), (unsigned long long)rows, written);
+    fclose(list);
+
+    ++stats->files;
+    stats->lines += lines;
+    stats->rows += rows;
+    stats->segments += written;
+    stats->inputBytes += inputBytes;
+    stats->storedBytes += storedBytes;
+    stats->micros += MonotonicMicros() - begin;
+    return true;
+}
+
+LogIngestStats LogStore::IngestArchives(const std::vector<AccessLogSource>& sources, const std::atomic<bool>* cancel) {
+    LogIngestStats stats;
+    std::vector<std::string> manifest = LoadManifest();
+    std::unordered_set<std::string> ingested(manifest.begin(), manifest.end());
+    for (const AccessLogSource& source : sources) {
+        for (const std::string& archive : ListLogArchives(source.path)) {
+            if (cancel && *cancel) return stats;
+            std::string key = IngestKey(archive);
+            if (ingested.count(key)) continue;
+            // 格式不明时不导入，修正配置后仍可导入
+            if (!source.error.empty()) {
+                ++stats.failed;
+                stats.error = source.path + ": " + source.error;
+                continue;
+            }
+            // 刚改名的明文归档可能还有 worker 在写入（尚未重新打开日志），等它一分钟内不再变化
+            uint64_t size = 0;
+            int64_t age = 0;
+            if (!EndsWith(archive, ".lz4") && (!StatFile(archive, &size, &age) || age < 60)) continue;
+            if (IngestFile(archive, source.format, &stats, cancel)) ingested.insert(key);
+        }
+    }
+    return stats;
+}
+
+LogStoreInfo LogStore::Info() const {
+    LogStoreInfo info;
+    for (const std::string& path : ListSegments()) {
+        SegmentView segment;
+        if (!segment.Open(path)) continue;
+        const SegmentHeader& header = segment.Header();
+        if (info.segments == 0 || header.minSecond < info.minSecond) info.minSecond = header.minSecond;
+        if (info.segments == 0 || header.maxSecond > info.maxSecond) info.maxSecond = header.maxSecond;
+        ++info.segments;
+        info.rows += header.rows;
+        uint64_t size = 0;
+        int64_t age = 0;
+        if (StatFile(path, &size, &age)) info.bytes += size;
+    }
+    info.ingestedFiles = (uint32_t)LoadManifest().size();
+    return info;
+}
+
+std::string FormatLogIngestStats(const LogIngestStats& stats) {
+    char text[384];
+    double seconds = stats.micros / 1e6;
+    snprintf(text, sizeof(text), "导入 %u 个日志归档: %llu 行 (%llu 行无法解析), %u 个分段, %.1f MB → %.1f MB, %.1f 秒 (%.0f 万行/秒)",
+             stats.files, (unsigned long long)stats.rows, (unsigned long long)(stats.lines - stats.rows),
+             stats.segments, stats.inputBytes / 1048576.0, stats.storedBytes / 1048576.0, seconds,
+             seconds > 0 ? stats.lines / seconds / 10000.0 : 0.0);
+    std::string line = text;
+    if (stats.failed) line += "，" + std::to_string(stats.failed) + " 个失败: " + stats.error;
+    return line;
+}
+
+// ---------------------------------------------------------------------------
+// 查询参数与结果
+
+// -24h / -30m / -7d / -90s 或本地时间 2026-10-17[T08:30[:00]]
+bool ParseQueryTime(const std::string& value, int64_t now, int64_t* second) {
+    if (value.size() >= 3 && value[0] == '-') {
+        char* end = nullptr;
+        long long amount = strtoll(value.c_str() + 1, &end, 10);
+        if (amount < 0 || end == value.c_str() + 1 || end[0] == '\0' || end[1] != '\0') return false;
+        int64_t unit = *end == 's' ? 1 : *end == 'm' ? 60 : *end == 'h' ? 3600 : *end == 'd' ? 86400 : 0;
+        if (unit == 0) return false;
+        *second = now - amount * unit;
+        return true;
+    }
+    struct tm parts = {};
+    int consumed = 0;
+    if (sscanf(value.c_str(), "%4d-%2d-%2d%n", &parts.tm_year, &parts.tm_mon, &parts.tm_mday, &consumed) != 3) {
+        return false;
+    }
+    const char* rest = value.c_str() + consumed;
+    if (*rest == 'T' || *rest == '_') {
+        int more = 0;
+        if (sscanf(rest + 1, "%2d:%2d%n", &parts.tm_hour, &parts.tm_min, &more) != 2) return false;
+        rest += 1 + more;
+        if (*rest == ':') {
+            if (sscanf(rest + 1, "%2d%n", &parts.tm_sec, &more) != 1) return false;
+            rest += 1 + more;
+        }
+    }
+    if (*rest != '\0') return false;
+    parts.tm_year -= 1900;
+    parts.tm_mon -= 1;
+    parts.tm_isdst = -1;
+    time_t local = mktime(&parts);
+    if (local == (time_t)-1) return false;
+    *second = (int64_t)local;
+    return true;
+}
+
+// 404 / 5xx / 400-499
+static bool ParseStatusSpec(const std::string& value, int* low, int* high) {
+    if (value.size() == 3 && isdigit((unsigned char)value[0]) && value[1] == 'x' && value[2] == 'x') {
+        *low = (value[0] - '0') * 100;
+        *high = *low + 99;
+        return true;
+    }
+    char* end = nullptr;
+    long first = strtol(value.c_str(), &end, 10);
+    if (end == value.c_str() || first < 0 || first > 999) return false;
+    long last = first;
+    if (*end == '-') {
+        const char* second = end + 1;
+        last = strtol(second, &end, 10);
+        if (end == second || last < first || last > 999) return false;
+    }
+    if (*end != '\0') return false;
+    *low = (int)first;
+    *high = (int)last;
+    return true;
+}
+
+bool ParseLogQuery(const std::vector<std::pair<std::string, std::string>>& fields, int64_t now, LogQuery* query,
+                   std::string* error) {
+    static const char* kGroups[] = { "none", "uri", "status", "method", "host", "minute", "hour", "day" };
+    static const char* kOrders[] = { "count", "bytes", "p50", "p99", "key" };
+    bool orderGiven = false;
+    for (const auto& field : fields) {
+        const std::string& key = field.first;
+        const std::string& value = field.second;
+        bool ok = true;
+        if (key == "from") {
+            ok = ParseQueryTime(value, now, &query->fromSecond);
+        } else if (key == "to") {
+            ok = ParseQueryTime(value, now, &query->toSecond);
+        } else if (key == "status") {
+            ok = ParseStatusSpec(value, &query->statusMin, &query->statusMax);
+        } else if (key == "method") {
+            query->method = value;
+        } else if (key == "host") {
+            query->host = value;
+        } else if (key == "uri") {
+            query->uriPrefix = value;
+        } else if (key == "group") {
+            ok = false;
+            for (int i = 0; i < (int)(sizeof(kGroups) / sizeof(kGroups[0])); ++i) {
+                if (value == kGroups[i]) {
+                    query->groupBy = (LogGroupBy)i;
+                    ok = true;
+                }
+            }
+        } else if (key == "order") {
+            ok = false;
+            orderGiven = true;
+            for (int i = 0; i < (int)(sizeof(kOrders) / sizeof(kOrders[0])); ++i) {
+                if (value == kOrders[i]) {
+                    query->orderBy = (LogOrderBy)i;
+                    ok = true;
+                }
+            }
+        } else if (key == "limit") {
+            query->limit = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        } else if (key == "threads") {
+            query->threads = (uint32_t)strtoul(value.c_str(), nullptr, 10);
+        } else {
+            if (error) *error = "未知的查询参数 " + key;
+            return false;
+        }
+        if (!ok) {
+            if (error) *error = "查询参数无效: " + key + "=" + value;
+            return false;
+        }
+    }
+    // 时间分组默认按时间先后
+    if (!orderGiven && IsTimeGroup(query->groupBy)) query->orderBy = LOG_ORDER_KEY;
+    if (query->fromSecond >= query->toSecond) {
+        if (error) *error = "查询参数无效: from 须早于 to";
+        return false;
+    }
+    return true;
+}
+
+bool ParseLogQueryText(const std::string& text, int64_t now, LogQuery* query, std::string* error) {
+    std::vector<std::pair<std::string, std::string>> fields;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        while (pos < text.size() && isspace((unsigned char)text[pos])) ++pos;
+        size_t end = pos;
+        while (end < text.size() && !isspace((unsigned char)text[end])) ++end;
+        if (end == pos) break;
+        std::string token = text.substr(pos, end - pos);
+        size_t equals = token.find('=');
+        if (equals == std::string::npos) {
+            if (error) *error = "查询参数应为 key=value: " + token;
+            return false;
+        }
+        fields.emplace_back(token.substr(0, equals), token.substr(equals + 1));
+        pos = end;
+    }
+    return ParseLogQuery(fields, now, query, error);
+}
+
+// 终端显示宽度：三字节及以上的 UTF-8 字符（中文）占两列
+static size_t DisplayWidth(const std::string& text) {
+    size_t width = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        unsigned char ch = (unsigned char)text[i];
+        if ((ch & 0xC0) == 0x80) continue;
+        width += ch >= 0xE0 ? 2 : 1;
+    }
+    return width;
+}
+
+static std::string PadRight(const std::string& text, size_t columns) {
+    size_t width = DisplayWidth(text);
+    return width >= columns ? text + " " : text + std::string(columns - width, ' ');
+}
+
+static std::string PadLeft(const std::string& text, size_t columns) {
+    size_t width = DisplayWidth(text);
+    return width >= columns ? " " + text : std::string(columns - width, ' ') + text;
+}
+
+std::string FormatLogQueryResult(const LogQuery& query, const LogQueryResult& result) {
+    static const char* kKeyTitles[] = { "", "路径", "状态码", "方法", "Host", "分钟", "小时", "日期" };
+    char text[512];
+    double seconds = result.micros / 1e6;
+    snprintf(text, sizeof(text),
+             "扫描 %u / %u 个分段 (%.1f MB): %llu / %llu 行, 匹配 %llu 行, %llu 个分组, %u 线程, %.1f ms (%.0f 万行/秒)\n",
+             result.segmentsScanned, result.segments, result.scannedBytes / 1048576.0,
+             (unsigned long long)result.scannedRows, (unsigned long long)result.totalRows,
+             (unsigned long long)result.matchedRows, (unsigned long long)result.groupCount, result.threads,
+             result.micros / 1000.0, seconds > 0 ? result.scannedRows / seconds / 10000.0 : 0.0);
+    std::string out = text;
+    if (result.groups.empty()) return out;
+
+    size_t keyWidth = 8;
+    for (const LogQueryGroup& group : result.groups) keyWidth = std::max(keyWidth, std::min<size_t>(group.key.size(), 60));
+    out += PadRight(query.groupBy == LOG_GROUP_NONE ? "" : kKeyTitles[query.groupBy], keyWidth + 2);
+    out += PadLeft("请求", 12) + PadLeft("占比", 8) + PadLeft("MB", 11) + PadLeft("平均ms", 10) + PadLeft("p50", 8) +
+           PadLeft("p90", 8) + PadLeft("p99", 8) + PadLeft("max", 8) + "\n";
+    for (const LogQueryGroup& group : result.groups) {
+        out += PadRight(group.key.empty() ? "-" : group.key, keyWidth + 2);
+        snprintf(text, sizeof(text), "%12llu %6.2f%% %10.1f %9.1f %7u %7u %7u %7u\n", (unsigned long long)group.count,
+                 result.matchedRows ? group.count * 100.0 / result.matchedRows : 0.0, group.bytes / 1048576.0,
+                 group.meanMs, group.p50Ms, group.p90Ms, group.p99Ms, group.maxMs);
+        out += text;
+    }
+    return out;
+}
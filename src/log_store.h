@@ -0,0 +1,151 @@
+// nginx-manager/src/log_store.h
+// 访问日志列存 - 轮转后的 access 日志导入为列式分段（字典 / 差分编码 + 分段区间索引），查询按核心数并行过滤与分组聚合
+
+#ifndef LOG_STORE_H
+#define LOG_STORE_H
+
+#include "log_rotator.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct LogIngestStats {
+    uint32_t files = 0;              // 本次导入的文件
+    uint32_t skipped = 0;            // 已导入过而跳过的文件
+    uint32_t failed = 0;
+    uint64_t lines = 0;
+    uint64_t rows = 0;               // 解析成功、写入分段的行
+    uint32_t segments = 0;
+    uint64_t inputBytes = 0;         // 日志原文（解压后）字节
+    uint64_t storedBytes = 0;        // 写入的分段字节
+    uint64_t micros = 0;
+    std::string error;               // 最近一个失败文件的原因
+};
+
+enum LogGroupBy {
+    LOG_GROUP_NONE,                  // 不分组，只有一行合计
+    LOG_GROUP_URI,
+    LOG_GROUP_STATUS,
+    LOG_GROUP_METHOD,
+    LOG_GROUP_HOST,
+    LOG_GROUP_MINUTE,                // 以下按本地时间分桶
+    LOG_GROUP_HOUR,
+    LOG_GROUP_DAY
+};
+
+enum LogOrderBy {
+    LOG_ORDER_COUNT,                 // 以下均为降序
+    LOG_ORDER_BYTES,
+    LOG_ORDER_P50,
+    LOG_ORDER_P99,
+    LOG_ORDER_KEY                    // 按分组键升序（时间分组默认如此）
+};
+
+struct LogQuery {
+    int64_t fromSecond = INT64_MIN;  // [from, to)，UTC 秒
+    int64_t toSecond = INT64_MAX;
+    int statusMin = 0;
+    int statusMax = 999;
+    std::string method;              // 以下为空表示不过滤；method / host 精确匹配，uri 为前缀匹配
+    std::string host;
+    std::string uriPrefix;
+    LogGroupBy groupBy = LOG_GROUP_URI;
+    LogOrderBy orderBy = LOG_ORDER_COUNT;
+    uint32_t limit = 20;             // 0 表示不限
+    uint32_t threads = 0;            // 0 表示硬件线程数
+};
+
+// 由 "key=value" 字段组装查询，未出现的字段保持默认：
+//   from= / to=     -24h、-30m、-7d（相对 now）或本地时间 2026-10-17、2026-10-17T08:30[:00]
+//   status=         404、5xx、400-499
+//   method= host= uri=（路径前缀）
+//   group=          none | uri | status | method | host | minute | hour | day
+//   order=          count | bytes | p50 | p99 | key
+//   limit= threads=
+bool ParseLogQuery(const std::vector<std::pair<std::string, std::string>>& fields, int64_t now, LogQuery* query,
+                   std::string* error);
+
+// 同上，字段以空白分隔写在一行中，如 "from=-24h status=5xx group=uri order=p99"
+bool ParseLogQueryText(const std::string& text, int64_t now, LogQuery* query, std::string* error);
+
+// 查询时间：-24h、-30m、-7d、-90s（相对 now，UTC 秒）或本地时间 2026-10-17[T08:30[:00]]
+bool ParseQueryTime(const std::string& value, int64_t now, int64_t* second);
+
+struct LogQueryGroup {
+    std::string key;
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    double meanMs = 0;               // 以下为 $request_time；日志格式中没有时均为 0
+    uint32_t p50Ms = 0;              // 分位数来自对数分桶直方图，相对误差不超过约 6%（16ms 以下精确）
+    uint32_t p90Ms = 0;
+    uint32_t p99Ms = 0;
+    uint32_t maxMs = 0;
+};
+
+struct LogQueryResult {
+    std::vector<LogQueryGroup> groups;   // 排序并截断到 limit 之后
+    uint64_t groupCount = 0;         // 截断前的分组数
+    uint64_t matchedRows = 0;
+    uint64_t scannedRows = 0;        // 未被区间索引排除的分段的总行数
+    uint64_t totalRows = 0;
+    uint32_t segments = 0;
+    uint32_t segmentsScanned = 0;
+    uint64_t scannedBytes = 0;       // 实际读取的列数据
+    uint32_t threads = 0;
+    uint64_t micros = 0;
+    std::string error;
+};
+
+// 查询结果的多行表格（UTF-8），首行为扫描统计
+std::string FormatLogQueryResult(const LogQuery& query, const LogQueryResult& result);
+
+struct LogStoreInfo {
+    uint32_t segments = 0;
+    uint64_t rows = 0;
+    uint64_t bytes = 0;              // 分段文件总大小
+    int64_t minSecond = 0;           // 没有数据时为 0
+    int64_t maxSecond = 0;
+    uint32_t ingestedFiles = 0;
+};
+
+// 访问日志列存
+// 每个导入的日志文件切成若干分段文件（每段至多 kSegmentRows 行），分段内按列存放：
+// 时间为相对前一行的 zigzag 变长差分；状态码、方法、Host、路径为分段内字典 + 定宽编码（字典不超过 256 项时 1 字节）；
+// 响应字节与 $request_time 按分段内最大值的位宽紧密排列。分段头记录时间、状态码、耗时的最小 / 最大值，查询先据此整段排除，
+// 过滤条件先对字典逐项求值，再按块对编码逐列求值得到选中行。查询线程从原子计数器领取分段，映射文件只读取用到的列，
+// 各线程分别聚合后合并。
+// 已导入的文件（按去掉 .lz4 的文件名）记录在目录下的 ingested.txt，同一归档压缩前后只导入一次；
+// 分段先写 .tmp 再改名，导入中断后重新导入时先删除该文件的残留分段。
+class LogStore {
+public:
+    static const uint32_t kSegmentRows = 1u << 20;
+
+    explicit LogStore(const std::string& directory) : m_directory(directory) {}
+
+    const std::string& Directory() const { return m_directory; }
+
+    // 按 format 导入一个日志文件（明文或 .lz4 归档），已导入过时跳过；与格式不符的行不导入；
+    // cancel 置位时中止，已写出的分段会在重新导入时清除
+    bool IngestFile(const std::string& path, const LogFormat& format, LogIngestStats* stats,
+                    const std::atomic<bool>* cancel);
+    // 导入各日志尚未导入的归档（不含仍在写入的日志本身），从旧到新；格式不明的日志计入 failed
+    LogIngestStats IngestArchives(const std::vector<AccessLogSource>& sources, const std::atomic<bool>* cancel);
+
+    LogQueryResult Query(const LogQuery& query) const;
+    LogStoreInfo Info() const;
+
+private:
+    std::vector<std::string> ListSegments() const;
+    std::vector<std::string> LoadManifest() const;
+
+    std::string m_directory;
+    std::mutex m_ingestMutex;        // 同一进程内的导入串行执行
+};
+
+// 导入结果的一行说明（UTF-8）
+std::string FormatLogIngestStats(const LogIngestStats& stats);
+
+#endif // LOG_STORE_H
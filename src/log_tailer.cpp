@@ -0,0 +1,233 @@
+// nginx-manager/src/log_tailer.cpp
+// 日志跟随 - 持续读取追加写入的日志文件，识别改名轮转与截断
+
+#include "log_tailer.h"
+#include "line_scan.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LogTailer::LogTailer(size_t bufferSize)
+    : m_buffer(bufferSize < 4096 ? 4096 : bufferSize) {
+}
+
+LogTailer::~LogTailer() {
+    Close();
+}
+
+bool LogTailer::Open(const std::string& path, bool fromStart) {
+    Close();
+    m_path = path;
+    // 文件尚不存在时，之后出现的内容都是新写入的
+    m_fromStart = !OpenFile(fromStart) || fromStart;
+    return !m_path.empty();
+}
+
+void LogTailer::Close() {
+    CloseFile();
+    m_pending = 0;
+    m_skipping = false;
+    m_offset = 0;
+}
+
+bool LogTailer::IsOpen() const {
+#ifdef _WIN32
+    return m_file != INVALID_HANDLE_VALUE;
+#else
+    return m_fd >= 0;
+#endif
+}
+
+#ifdef _WIN32
+
+bool LogTailer::OpenFile(bool fromStart) {
+    // 允许 nginx 继续写入，也允许其他程序改名 / 删除该文件进行轮转
+    m_file = CreateFileW(Utf8ToWide(m_path).c_str(), GENERIC_READ,
+                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) return false;
+
+    m_pending = 0;
+    m_skipping = false;
+    m_offset = 0;
+    if (!fromStart) {
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(m_file, &size)) m_offset = (uint64_t)size.QuadPart;
+    }
+    return true;
+}
+
+void LogTailer::CloseFile() {
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+}
+
+static bool IdentityOfHandle(HANDLE file, uint64_t* volume, uint64_t* index, uint64_t* size) {
+    BY_HANDLE_FILE_INFORMATION info;
+    if (!GetFileInformationByHandle(file, &info)) return false;
+    *volume = info.dwVolumeSerialNumber;
+    *index = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    *size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    return true;
+}
+
+bool LogTailer::IdentityOfOpenFile(FileIdentity* identity) const {
+    return IdentityOfHandle(m_file, &identity->volume, &identity->index, &identity->size);
+}
+
+bool LogTailer::IdentityOfPath(FileIdentity* identity) const {
+    // 只查询属性，不需要读权限
+    HANDLE file = CreateFileW(Utf8ToWide(m_path).c_str(), 0,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    bool ok = IdentityOfHandle(file, &identity->volume, &identity->index, &identity->size);
+    CloseHandle(file);
+    return ok;
+}
+
+#else
+
+bool LogTailer::OpenFile(bool fromStart) {
+    m_fd = open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_fd < 0) return false;
+
+    m_pending = 0;
+    m_skipping = false;
+    m_offset = 0;
+    struct stat st;
+    if (!fromStart && fstat(m_fd, &st) == 0) m_offset = (uint64_t)st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return true;
+}
+
+void LogTailer::CloseFile() {
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool LogTailer::IdentityOfOpenFile(FileIdentity* identity) const {
+    struct stat st;
+    if (fstat(m_fd, &st) != 0) return false;
+    identity->volume = (uint64_t)st.st_dev;
+    identity->index = (uint64_t)st.st_ino;
+    identity->size = (uint64_t)st.st_size;
+    return true;
+}
+
+bool LogTailer::IdentityOfPath(FileIdentity* identity) const {
+    struct stat st;
+    if (stat(m_path.c_str(), &st) != 0) return false;
+    identity->volume = (uint64_t)st.st_dev;
+    identity->index = (uint64_t)st.st_ino;
+    identity->size = (uint64_t)st.st_size;
+    return true;
+}
+
+#endif
+
+// 把缓冲区中完整的行交给 handler，剩余的半行移到缓冲区开头
+size_t LogTailer::DeliverLines(const LineHandler& handler) {
+    size_t lines = 0;
+    const char* begin = m_buffer.data();
+    const char* end = begin + m_pending;
+    const char* line = begin;
+
+    for (;;) {
+        const char* newline = FindNewline(line, end);
+        if (newline == end) break;
+        if (m_skipping) {
+            m_skipping = false;
+        } else {
+            size_t length = (size_t)(newline - line);
+            if (length > 0 && newline[-1] == '\r') --length;
+            handler(line, length);
+            ++lines;
+        }
+        line = newline + 1;
+    }
+
+    size_t rest = (size_t)(end - line);
+    if (rest == m_buffer.size()) {
+        // 整个缓冲区都没有行尾：丢弃这一行，跳过直到下一个 '\n'
+        if (!m_skipping) ++m_droppedLines;
+        m_skipping = true;
+        rest = 0;
+    } else if (rest > 0 && line != begin) {
+        memmove(m_buffer.data(), line, rest);
+    }
+    m_pending = rest;
+    return lines;
+}
+
+size_t LogTailer::ReadAvailable(const LineHandler& handler) {
+    size_t lines = 0;
+    for (;;) {
+        char* target = m_buffer.data() + m_pending;
+        size_t room = m_buffer.size() - m_pending;
+        size_t got = 0;
+#ifdef _WIN32
+        OVERLAPPED position = {};
+        position.Offset = (DWORD)(m_offset & 0xFFFFFFFFu);
+        position.OffsetHigh = (DWORD)(m_offset >> 32);
+        DWORD read = 0;
+        if (!ReadFile(m_file, target, (DWORD)room, &read, &position)) break;
+        got = read;
+#else
+        ssize_t read = pread(m_fd, target, room, (off_t)m_offset);
+        if (read < 0 && errno == EINTR) continue;
+        if (read <= 0) break;
+        got = (size_t)read;
+#endif
+        if (got == 0) break;
+        m_offset += got;
+        m_bytesRead += got;
+        m_pending += got;
+        lines += DeliverLines(handler);
+    }
+    return lines;
+}
+
+size_t LogTailer::Poll(const LineHandler& handler) {
+    if (m_path.empty()) return 0;
+
+    if (!IsOpen()) {
+        // 首次打开遵循调用方的选择；轮转后重新出现的文件一定从头读
+        if (!OpenFile(m_fromStart)) return 0;
+    }
+
+    size_t lines = ReadAvailable(handler);
+
+    FileIdentity current;
+    FileIdentity onDisk;
+    if (!IdentityOfOpenFile(&current)) return lines;
+
+    if (current.size < m_offset) {
+        // copytruncate 式轮转：同一个文件被截短
+        m_offset = 0;
+        m_pending = 0;
+        m_skipping = false;
+        ++m_rotations;
+        lines += ReadAvailable(handler);
+    } else if (IdentityOfPath(&onDisk) && (onDisk.volume != current.volume || onDisk.index != current.index)) {
+        // 原路径已是新文件：旧文件已读到末尾，残留的半行不会再被补全
+        if (m_pending > 0 || m_skipping) ++m_droppedLines;
+        CloseFile();
+        ++m_rotations;
+        m_fromStart = true;
+        if (OpenFile(true)) lines += ReadAvailable(handler);
+    }
+    return lines;
+}
@@ -0,0 +1,69 @@
+// nginx-manager/src/log_tailer.h
+// 日志跟随 - 持续读取追加写入的日志文件，识别改名轮转与截断
+
+#ifndef LOG_TAILER_H
+#define LOG_TAILER_H
+
+#include "platform.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// 跟随一个日志文件，按行回调新追加的内容
+// 文件被改名轮转（原路径出现新文件）时先读完旧文件再切换到新文件；被截断时从头开始。
+class LogTailer {
+public:
+    typedef std::function<void(const char* line, size_t length)> LineHandler;
+
+    explicit LogTailer(size_t bufferSize = 256 * 1024);
+    ~LogTailer();
+
+    LogTailer(const LogTailer&) = delete;
+    LogTailer& operator=(const LogTailer&) = delete;
+
+    // fromStart 为 false 时从当前文件末尾开始，只处理之后追加的行
+    // 文件暂不存在也返回 true，之后每次 Poll 会重试打开
+    bool Open(const std::string& path, bool fromStart);
+    void Close();
+
+    // 读取目前可读的全部内容并逐行回调（不含行尾 '\n'），返回本次回调的行数
+    size_t Poll(const LineHandler& handler);
+
+    bool IsOpen() const;
+    const std::string& Path() const { return m_path; }
+    uint64_t Offset() const { return m_offset; }
+    uint64_t BytesRead() const { return m_bytesRead; }
+    uint64_t Rotations() const { return m_rotations; }
+    uint64_t DroppedLines() const { return m_droppedLines; }   // 超过缓冲区长度而被丢弃的行
+
+private:
+    struct FileIdentity {
+        uint64_t volume = 0;
+        uint64_t index = 0;
+        uint64_t size = 0;
+    };
+
+    bool OpenFile(bool fromStart);
+    void CloseFile();
+    bool IdentityOfOpenFile(FileIdentity* identity) const;
+    bool IdentityOfPath(FileIdentity* identity) const;
+    size_t ReadAvailable(const LineHandler& handler);
+    size_t DeliverLines(const LineHandler& handler);
+
+    std::string m_path;
+    bool m_fromStart = false;
+    std::vector<char> m_buffer;
+    size_t m_pending = 0;            // 缓冲区开头尚未遇到行尾的字节数
+    bool m_skipping = false;         // 正在跳过一条超长行的剩余部分
+    uint64_t m_offset = 0;           // 下一次读取的文件偏移
+    uint64_t m_bytesRead = 0;
+    uint64_t m_rotations = 0;
+    uint64_t m_droppedLines = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+#else
+    int m_fd = -1;
+#endif
+};
+
+#endif // LOG_TAILER_H
@@ -0,0 +1,495 @@
+// nginx-manager/src/log_view.cpp
+// 日志面板 - 自绘的虚拟化列表，只绘制可见行，数据来自 LogModel
+
+#include "log_view.h"
+#include "trace.h"
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+
+static const wchar_t* const kLogViewClass = L"NginxManagerLogView";
+
+// 模型有新记录，请求刷新滚动条并重绘
+#define WM_LOGVIEW_REFRESH     (WM_USER + 1)
+
+static const int kMargin = 8;
+static const size_t kHistoryPage = 200;          // 每次向前加载的历史记录条数
+static const size_t kMaxHistoryRows = 50000;     // 历史记录最多保留的行数
+
+// 视图中的行依次为：从持久化日志加载的历史记录（history），以及模型中的记录
+struct LogViewState {
+    LogModel* model = nullptr;
+    HFONT font = NULL;
+    int lineHeight = 16;
+    int stampWidth = 0;              // "[00:00:00] " 的宽度
+    int historyStampWidth = 0;       // "[00-00 00:00:00] " 的宽度
+    int visibleRows = 1;
+    uint64_t topSequence = 0;        // 首个可见行的序号，旧记录被淘汰时视图不会跳动
+    bool topInHistory = false;       // 首个可见行位于历史记录中，此时以 topHistory 定位
+    size_t topHistory = 0;
+    bool followTail = true;          // 位于底部时自动跟随新记录
+    std::atomic<bool> refreshPending{false};
+
+    // 历史记录：向上滚动越过模型中最旧的记录时按页加载，回到底部时释放
+    LogHistorySource historySource = nullptr;
+    std::vector<LogRecord> history;
+    std::vector<std::string> historyTexts;
+    bool historyExhausted = false;
+
+    // 绘制用的缓冲，跨帧复用
+    HDC bufferDC = NULL;
+    HBITMAP bufferBitmap = NULL;
+    HGDIOBJ oldBitmap = NULL;
+    int bufferWidth = 0;
+    int bufferHeight = 0;
+    std::vector<LogRecord> records;
+    std::vector<std::string> texts;
+    std::wstring wide;
+};
+
+COLORREF LogSeverityColor(LogSeverity severity) {
+    switch (severity) {
+    case LOG_DETAIL: return RGB(128, 128, 128);  // 灰色
+    case LOG_INFO: return RGB(0, 100, 200);      // 蓝色
+    case LOG_SUCCESS: return RGB(34, 139, 34);   // 绿色
+    case LOG_WARNING: return RGB(255, 140, 0);   // 橙色
+    case LOG_ERROR: return RGB(220, 20, 60);     // 红色
+    default: return RGB(0, 0, 0);                // 黑色
+    }
+}
+
+static LogViewState* StateOf(HWND hwnd) {
+    return (LogViewState*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+}
+
+static void ReleaseBuffer(LogViewState* state) {
+    if (state->bufferDC) {
+        SelectObject(state->bufferDC, state->oldBitmap);
+        DeleteObject(state->bufferBitmap);
+        DeleteDC(state->bufferDC);
+        state->bufferDC = NULL;
+        state->bufferBitmap = NULL;
+    }
+    state->bufferWidth = 0;
+    state->bufferHeight = 0;
+}
+
+static void UpdateMetrics(HWND hwnd, LogViewState* state) {
+    HDC hdc = GetDC(hwnd);
+    HGDIOBJ old = SelectObject(hdc, state->font ? (HGDIOBJ)state->font : GetStockObject(DEFAULT_GUI_FONT));
+    TEXTMETRICW tm;
+    GetTextMetricsW(hdc, &tm);
+    state->lineHeight = tm.tmHeight + tm.tmExternalLeading + 2;
+    SIZE size;
+    GetTextExtentPoint32W(hdc, L"[00:00:00] ", 11, &size);
+    state->stampWidth = size.cx;
+    GetTextExtentPoint32W(hdc, L"[00-00 00:00:00] ", 17, &size);
+    state->historyStampWidth = size.cx;
+    SelectObject(hdc, old);
+    ReleaseDC(hwnd, hdc);
+
+    RECT client;
+    GetClientRect(hwnd, &client);
+    state->visibleRows = (client.bottom - client.top) / state->lineHeight;
+    if (state->visibleRows < 1) state->visibleRows = 1;
+}
+
+// 时间戳文本；历史记录可能跨天，带上日期
+static int FormatStamp(int64_t timeMicros, bool withDate, wchar_t* stamp, size_t length) {
+    int64_t secondOfDay = (timeMicros / 1000000) % 86400;
+    int hour = (int)(secondOfDay / 3600);
+    int minute = (int)(secondOfDay / 60 % 60);
+    int second = (int)(secondOfDay % 60);
+    if (!withDate) return swprintf(stamp, length, L"[%02d:%02d:%02d] ", hour, minute, second);
+
+    time_t seconds = (time_t)(timeMicros / 1000000);
+    struct tm date = {};
+#ifdef _WIN32
+    gmtime_s(&date, &seconds);
+#else
+    gmtime_r(&seconds, &date);
+#endif
+    return swprintf(stamp, length, L"[%02d-%02d %02d:%02d:%02d] ", date.tm_mon + 1, date.tm_mday, hour, minute,
+                    second);
+}
+
+// 模型中最旧记录对应的持久化序号；模型为空时历史记录即全部记录
+static uint64_t ModelFirstOrigin(LogViewState* state) {
+    if (state->model->Size() == 0) return UINT64_MAX;
+    LogRecord record;
+    if (!state->model->Get(0, &record, nullptr)) return UINT64_MAX;
+    return record.origin;
+}
+
+static void ClearHistory(LogViewState* state) {
+    std::vector<LogRecord>().swap(state->history);
+    std::vector<std::string>().swap(state->historyTexts);
+    state->historyExhausted = false;
+    state->topInHistory = false;
+}
+
+// 只保留最新的 kMaxHistoryRows 条历史记录
+static void TrimHistory(LogViewState* state) {
+    if (state->history.size() <= kMaxHistoryRows) return;
+    size_t drop = state->history.size() - kMaxHistoryRows;
+    state->history.erase(state->history.begin(), state->history.begin() + drop);
+    state->historyTexts.erase(state->historyTexts.begin(), state->historyTexts.begin() + drop);
+    state->topHistory = state->topHistory > drop ? state->topHistory - drop : 0;
+    state->historyExhausted = true;
+}
+
+// 向前加载一页历史记录，返回加载的条数
+static size_t LoadOlderHistory(LogViewState* state) {
+    if (!state->historySource || state->historyExhausted || state->history.size() >= kMaxHistoryRows) return 0;
+    uint64_t before = state->history.empty() ? ModelFirstOrigin(state) : state->history.front().origin;
+    std::vector<LogRecord> records;
+    std::vector<std::string> texts;
+    size_t count = before > 1 ? state->historySource(before, 0, kHistoryPage, &records, &texts) : 0;
+    if (count == 0) {
+        state->historyExhausted = true;
+        return 0;
+    }
+    state->history.insert(state->history.begin(), records.begin(), records.begin() + count);
+    state->historyTexts.insert(state->historyTexts.begin(), texts.begin(), texts.begin() + count);
+    if (state->topInHistory) state->topHistory += count;
+    return count;
+}
+
+// 历史记录显示期间模型淘汰了旧记录：把两者之间缺失的记录补进历史记录，保证行连续
+static void FillHistoryGap(LogViewState* state) {
+    if (state->history.empty() || !state->historySource) return;
+    uint64_t first = ModelFirstOrigin(state);
+    uint64_t last = state->history.back().origin;
+    if (first == 0 || first == UINT64_MAX || first <= last + 1) return;
+
+    std::vector<LogRecord> records;
+    std::vector<std::string> texts;
+    size_t count = state->historySource(first, last, kMaxHistoryRows, &records, &texts);
+    state->history.insert(state->history.end(), records.begin(), records.begin() + count);
+    state->historyTexts.insert(state->historyTexts.end(), texts.begin(), texts.begin() + count);
+    TrimHistory(state);
+}
+
+// 当前首个可见行在全部行（历史 + 模型）中的下标
+static size_t TopIndex(LogViewState* state, size_t size, uint64_t firstSequence) {
+    size_t total = state->history.size() + size;
+    size_t maxTop = total > (size_t)state->visibleRows ? total - state->visibleRows : 0;
+    if (state->followTail) return maxTop;
+    size_t top;
+    if (state->topInHistory) {
+        top = state->topHistory;
+    } else {
+        top = state->history.size() +
+              (state->topSequence > firstSequence ? (size_t)(state->topSequence - firstSequence) : 0);
+    }
+    return top > maxTop ? maxTop : top;
+}
+
+static void SetTop(LogViewState* state, size_t top, uint64_t firstSequence) {
+    state->topInHistory = top < state->history.size();
+    if (state->topInHistory) {
+        state->topHistory = top;
+    } else {
+        state->topSequence = firstSequence + (top - state->history.size());
+    }
+}
+
+static void UpdateScrollBar(HWND hwnd, LogViewState* state) {
+    size_t size = state->model->Size();
+    uint64_t first = state->model->FirstSequence();
+    size_t top = TopIndex(state, size, first);
+    SetTop(state, top, first);
+
+    size_t total = state->history.size() + size;
+    SCROLLINFO si = {};
+    si.cbSize = sizeof(si);
+    si.fMask = SIF_RANGE | SIF_PAGE | SIF_POS;
+    si.nMin = 0;
+    si.nMax = total > 0 ? (int)total - 1 : 0;
+    si.nPage = (UINT)state->visibleRows;
+    si.nPos = (int)top;
+    SetScrollInfo(hwnd, SB_VERT, &si, TRUE);
+}
+
+static void ScrollTo(HWND hwnd, LogViewState* state, long long top) {
+    // 越过最顶部时从持久化日志加载更早的记录
+    while (top < 0) {
+        size_t loaded = LoadOlderHistory(state);
+        if (loaded == 0) break;
+        top += (long long)loaded;
+    }
+
+    size_t size = state->model->Size();
+    size_t total = state->history.size() + size;
+    long long maxTop = total > (size_t)state->visibleRows ? (long long)(total - state->visibleRows) : 0;
+    if (top < 0) top = 0;
+    if (top > maxTop) top = maxTop;
+    state->followTail = top >= maxTop;
+    if (state->followTail && !state->history.empty() && (size_t)maxTop >= state->history.size()) {
+        // 回到底部、历史记录已不在可见范围内时释放
+        ClearHistory(state);
+    } else {
+        SetTop(state, (size_t)top, state->model->FirstSequence());
+    }
+    UpdateScrollBar(hwnd, state);
+    InvalidateRect(hwnd, NULL, FALSE);
+}
+
+static void Utf8ToWideInto(const std::string& text, std::wstring* wide) {
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), NULL, 0);
+    wide->resize(length > 0 ? (size_t)length : 0);
+    if (length > 0) MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &(*wide)[0], length);
+}
+
+static void Paint(HWND hwnd, LogViewState* state) {
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hwnd, &ps);
+
+    RECT client;
+    GetClientRect(hwnd, &client);
+    int width = client.right - client.left;
+    int height = client.bottom - client.top;
+    if (width <= 0 || height <= 0) {
+        EndPaint(hwnd, &ps);
+        return;
+    }
+
+    // 在内存位图中绘制后一次性复制，避免闪烁
+    if (!state->bufferDC || state->bufferWidth < width || state->bufferHeight < height) {
+        ReleaseBuffer(state);
+        state->bufferDC = CreateCompatibleDC(hdc);
+        state->bufferBitmap = CreateCompatibleBitmap(hdc, width, height);
+        state->oldBitmap = SelectObject(state->bufferDC, state->bufferBitmap);
+        state->bufferWidth = width;
+        state->bufferHeight = height;
+    }
+    HDC dc = state->bufferDC;
+
+    HBRUSH background = (HBRUSH)GetStockObject(WHITE_BRUSH);
+    FillRect(dc, &client, background);
+    HGDIOBJ oldFont = SelectObject(dc, state->font ? (HGDIOBJ)state->font : GetStockObject(DEFAULT_GUI_FONT));
+    SetBkMode(dc, TRANSPARENT);
+
+    // 只取可见范围内的记录：先是历史记录，其余从模型中取
+    size_t size = state->model->Size();
+    size_t top = TopIndex(state, size, state->model->FirstSequence());
+    size_t rows = (size_t)state->visibleRows + 1;
+    size_t historyRows = 0;
+    if (top < state->history.size()) {
+        historyRows = state->history.size() - top;
+        if (historyRows > rows) historyRows = rows;
+    }
+    size_t modelTop = top + historyRows - state->history.size();
+    size_t count = state->model->GetRange(modelTop, rows - historyRows, &state->records, &state->texts);
+
+    int firstRow = ps.rcPaint.top / state->lineHeight;
+    int lastRow = ps.rcPaint.bottom / state->lineHeight;
+    for (size_t i = 0; i < historyRows + count; ++i) {
+        int row = (int)i;
+        if (row < firstRow || row > lastRow) continue;
+        bool fromHistory = i < historyRows;
+        const LogRecord& record = fromHistory ? state->history[top + i] : state->records[i - historyRows];
+        const std::string& text = fromHistory ? state->historyTexts[top + i] : state->texts[i - historyRows];
+        int y = row * state->lineHeight + 1;
+
+        wchar_t stamp[24];
+        int stampLength = FormatStamp(record.timeMicros, fromHistory, stamp, 24);
+        RECT clip = { kMargin, y, width - kMargin, y + state->lineHeight };
+        SetTextColor(dc, RGB(128, 128, 128));
+        ExtTextOutW(dc, kMargin, y, ETO_CLIPPED, &clip, stamp, (UINT)stampLength, NULL);
+
+        Utf8ToWideInto(text, &state->wide);
+        SetTextColor(dc, LogSeverityColor(record.severity));
+        int textX = kMargin + (fromHistory ? state->historyStampWidth : state->stampWidth);
+        ExtTextOutW(dc, textX, y, ETO_CLIPPED, &clip, state->wide.c_str(), (UINT)state->wide.size(), NULL);
+    }
+
+    SelectObject(dc, oldFont);
+    BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left,
+           ps.rcPaint.bottom - ps.rcPaint.top, dc, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+    EndPaint(hwnd, &ps);
+}
+
+// 把全部日志（含已加载的历史记录）以纯文本复制到剪贴板
+static void CopyAll(HWND hwnd, LogViewState* state) {
+    std::wstring all;
+    std::vector<LogRecord> records;
+    std::vector<std::string> texts;
+    size_t count = state->model->GetRange(0, state->model->Size(), &records, &texts);
+    std::wstring wide;
+    wchar_t stamp[24];
+    for (size_t i = 0; i < state->history.size(); ++i) {
+        FormatStamp(state->history[i].timeMicros, true, stamp, 24);
+        Utf8ToWideInto(state->historyTexts[i], &wide);
+        all += stamp;
+        all += wide;
+        all += L"\r\n";
+    }
+    for (size_t i = 0; i < count; ++i) {
+        FormatStamp(records[i].timeMicros, false, stamp, 24);
+        Utf8ToWideInto(texts[i], &wide);
+        all += stamp;
+        all += wide;
+        all += L"\r\n";
+    }
+
+    if (!OpenClipboard(hwnd)) return;
+    EmptyClipboard();
+    HGLOBAL memory = GlobalAlloc(GMEM_MOVEABLE, (all.size() + 1) * sizeof(wchar_t));
+    if (memory) {
+        memcpy(GlobalLock(memory), all.c_str(), (all.size() + 1) * sizeof(wchar_t));
+        GlobalUnlock(memory);
+        if (!SetClipboardData(CF_UNICODETEXT, memory)) GlobalFree(memory);
+    }
+    CloseClipboard();
+}
+
+static LRESULT CALLBACK LogViewProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    LogViewState* state = StateOf(hwnd);
+
+    switch (uMsg) {
+        case WM_NCCREATE: {
+            CREATESTRUCTW* create = (CREATESTRUCTW*)lParam;
+            LogViewState* newState = new LogViewState();
+            newState->model = (LogModel*)create->lpCreateParams;
+            SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)newState);
+            break;
+        }
+
+        case WM_CREATE:
+            UpdateMetrics(hwnd, state);
+            UpdateScrollBar(hwnd, state);
+            return 0;
+
+        case WM_NCDESTROY:
+            if (state) {
+                ReleaseBuffer(state);
+                delete state;
+                SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+            }
+            break;
+
+        case WM_SETFONT:
+            state->font = (HFONT)wParam;
+            UpdateMetrics(hwnd, state);
+            UpdateScrollBar(hwnd, state);
+            if (LOWORD(lParam)) InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+
+        case WM_GETFONT:
+            return (LRESULT)state->font;
+
+        case WM_SIZE:
+            UpdateMetrics(hwnd, state);
+            UpdateScrollBar(hwnd, state);
+            InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+
+        case WM_LOGVIEW_REFRESH:
+            // 先清除标记再读取模型，读取之后的追加会再次触发刷新
+            state->refreshPending.store(false);
+            FillHistoryGap(state);
+            UpdateScrollBar(hwnd, state);
+            InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+
+        case WM_ERASEBKGND:
+            return 1;
+
+        case WM_PAINT: {
+            TraceSpan span(TRACE_PAINT, "log-view");
+            Paint(hwnd, state);
+            return 0;
+        }
+
+        case WM_VSCROLL: {
+            size_t top = TopIndex(state, state->model->Size(), state->model->FirstSequence());
+            long long total = (long long)(state->history.size() + state->model->Size());
+            long long target = (long long)top;
+            switch (LOWORD(wParam)) {
+                case SB_LINEUP: target -= 1; break;
+                case SB_LINEDOWN: target += 1; break;
+                case SB_PAGEUP: target -= state->visibleRows; break;
+                case SB_PAGEDOWN: target += state->visibleRows; break;
+                case SB_TOP: target = 0; break;
+                case SB_BOTTOM: target = total; break;
+                case SB_THUMBTRACK:
+                case SB_THUMBPOSITION: {
+                    SCROLLINFO si = {};
+                    si.cbSize = sizeof(si);
+                    si.fMask = SIF_TRACKPOS;
+                    GetScrollInfo(hwnd, SB_VERT, &si);
+                    target = si.nTrackPos;
+                    break;
+                }
+                default: return 0;
+            }
+            ScrollTo(hwnd, state, target);
+            return 0;
+        }
+
+        case WM_MOUSEWHEEL: {
+            UINT lines = 3;
+            SystemParametersInfoW(SPI_GETWHEELSCROLLLINES, 0, &lines, 0);
+            int delta = GET_WHEEL_DELTA_WPARAM(wParam);
+            size_t top = TopIndex(state, state->model->Size(), state->model->FirstSequence());
+            ScrollTo(hwnd, state, (long long)top - (long long)delta * (int)lines / WHEEL_DELTA);
+            return 0;
+        }
+
+        case WM_LBUTTONDOWN:
+            SetFocus(hwnd);
+            return 0;
+
+        case WM_KEYDOWN: {
+            size_t top = TopIndex(state, state->model->Size(), state->model->FirstSequence());
+            long long total = (long long)(state->history.size() + state->model->Size());
+            switch (wParam) {
+                case VK_UP: ScrollTo(hwnd, state, (long long)top - 1); return 0;
+                case VK_DOWN: ScrollTo(hwnd, state, (long long)top + 1); return 0;
+                case VK_PRIOR: ScrollTo(hwnd, state, (long long)top - state->visibleRows); return 0;
+                case VK_NEXT: ScrollTo(hwnd, state, (long long)top + state->visibleRows); return 0;
+                case VK_HOME: ScrollTo(hwnd, state, 0); return 0;
+                case VK_END: ScrollTo(hwnd, state, total); return 0;
+                case 'C':
+                    if (GetKeyState(VK_CONTROL) < 0) CopyAll(hwnd, state);
+                    return 0;
+            }
+            break;
+        }
+    }
+    return DefWindowProcW(hwnd, uMsg, wParam, lParam);
+}
+
+bool RegisterLogViewClass(HINSTANCE instance) {
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = LogViewProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = kLogViewClass;
+    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+    wc.hbrBackground = NULL;
+    return RegisterClassW(&wc) != 0;
+}
+
+HWND CreateLogView(HWND parent, int id, int x, int y, int width, int height, LogModel* model) {
+    return CreateWindowExW(0, kLogViewClass, L"", WS_CHILD | WS_VISIBLE | WS_BORDER | WS_VSCROLL | WS_TABSTOP,
+                           x, y, width, height, parent, (HMENU)(INT_PTR)id, GetModuleHandle(NULL), model);
+}
+
+void LogViewSetHistorySource(HWND view, LogHistorySource source) {
+    LogViewState* state = view ? StateOf(view) : nullptr;
+    if (!state) return;
+    state->historySource = source;
+    state->historyExhausted = false;
+}
+
+void LogViewNotify(HWND view) {
+    if (!view) return;
+    LogViewState* state = StateOf(view);
+    if (!state) return;
+    // 已有待处理的刷新时不再投递，多次追加合并为一次重绘
+    if (!state->refreshPending.exchange(true)) {
+        if (!PostMessageW(view, WM_LOGVIEW_REFRESH, 0, 0)) state->refreshPending.store(false);
+    }
+}
@@ -0,0 +1,29 @@
+// nginx-manager/src/log_view.h
+// 日志面板 - 自绘的虚拟化列表，只绘制可见行，数据来自 LogModel
+
+#ifndef LOG_VIEW_H
+#define LOG_VIEW_H
+
+#include "log_model.h"
+
+// 注册日志面板窗口类，创建面板前调用一次
+bool RegisterLogViewClass(HINSTANCE instance);
+
+// 创建日志面板，model 的生命周期必须长于面板
+HWND CreateLogView(HWND parent, int id, int x, int y, int width, int height, LogModel* model);
+
+// 历史记录来源：返回 origin 在 (afterOrigin, beforeOrigin) 内最新的至多 count 条记录（按 origin 升序），
+// records 的 timeMicros 为本地时间、origin 为持久化序号，texts 与 records 一一对应
+typedef size_t (*LogHistorySource)(uint64_t beforeOrigin, uint64_t afterOrigin, size_t count,
+                                   std::vector<LogRecord>* records, std::vector<std::string>* texts);
+
+// 设置历史记录来源；向上滚动越过模型中最旧的记录时按页加载更早的记录
+void LogViewSetHistorySource(HWND view, LogHistorySource source);
+
+// 通知面板模型有新记录，可在任意线程调用；重绘前的多次通知只会触发一次刷新
+void LogViewNotify(HWND view);
+
+// 各日志级别的显示颜色
+COLORREF LogSeverityColor(LogSeverity severity);
+
+#endif // LOG_VIEW_H
@@ -0,0 +1,356 @@
+// nginx-manager/src/lz4_frame.cpp
+// LZ4 帧格式 - 固定内存的分块压缩（64KB 独立块 + XXH32 内容校验），输出可直接用 lz4 -d 解压
+
+#include "lz4_frame.h"
+
+#include <cstring>
+
+// 帧格式（小端）：
+//   魔数 0x184D2204、FLG、BD、头部校验 (XXH32(FLG BD) 的第 2 字节)
+//   块：长度 (uint32，最高位为 1 表示未压缩)、内容；长度为 0 的块表示结束
+//   结束后为内容校验 XXH32 (uint32)
+static const uint32_t kMagic = 0x184D2204;
+static const uint8_t kFlagVersion = 0x40;
+static const uint8_t kFlagBlockIndependent = 0x20;
+static const uint8_t kFlagBlockChecksum = 0x10;
+static const uint8_t kFlagContentSize = 0x08;
+static const uint8_t kFlagContentChecksum = 0x04;
+static const uint8_t kFlagDictId = 0x01;
+static const uint8_t kBlockMax64K = 0x40;
+static const uint32_t kUncompressedBit = 0x80000000u;
+
+// LZ4 块格式的约束：匹配至少 4 字节，最后 5 字节必须是字面量，最后一个匹配至少在块尾 12 字节之前开始
+static const size_t kMinMatch = 4;
+static const size_t kLastLiterals = 5;
+static const size_t kMatchFindLimit = 12;
+static const size_t kMaxOffset = 65535;
+
+static const uint32_t kPrime1 = 2654435761u;
+static const uint32_t kPrime2 = 2246822519u;
+static const uint32_t kPrime3 = 3266489917u;
+static const uint32_t kPrime4 = 668265263u;
+static const uint32_t kPrime5 = 374761393u;
+
+static inline uint32_t Read32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;                    // 只用于比较与哈希，不关心字节序
+}
+
+static inline uint32_t ReadLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void WriteLE32(uint8_t* p, uint32_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+    p[2] = (uint8_t)(value >> 16);
+    p[3] = (uint8_t)(value >> 24);
+}
+
+static inline uint32_t Rotl32(uint32_t value, int bits) {
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static inline uint32_t Round32(uint32_t acc, uint32_t lane) {
+    return Rotl32(acc + lane * kPrime2, 13) * kPrime1;
+}
+
+// ---------------------------------------------------------------------------
+// XXH32
+
+void Xxh32::Reset(uint32_t seed) {
+    m_seed = seed;
+    m_v[0] = seed + kPrime1 + kPrime2;
+    m_v[1] = seed + kPrime2;
+    m_v[2] = seed;
+    m_v[3] = seed - kPrime1;
+    m_total = 0;
+    m_pendingSize = 0;
+}
+
+void Xxh32::Update(const void* data, size_t size) {
+    const uint8_t* p = (const uint8_t*)data;
+    m_total += size;
+    if (m_pendingSize + size < 16) {
+        memcpy(m_pending + m_pendingSize, p, size);
+        m_pendingSize += size;
+        return;
+    }
+    if (m_pendingSize > 0) {
+        size_t fill = 16 - m_pendingSize;
+        memcpy(m_pending + m_pendingSize, p, fill);
+        for (int i = 0; i < 4; ++i) m_v[i] = Round32(m_v[i], ReadLE32(m_pending + i * 4));
+        p += fill;
+        size -= fill;
+        m_pendingSize = 0;
+    }
+    while (size >= 16) {
+        for (int i = 0; i < 4; ++i) m_v[i] = Round32(m_v[i], ReadLE32(p + i * 4));
+        p += 16;
+        size -= 16;
+    }
+    memcpy(m_pending, p, size);
+    m_pendingSize = size;
+}
+
+uint32_t Xxh32::Digest() const {
+    uint32_t h;
+    if (m_total >= 16) {
+        h = Rotl32(m_v[0], 1) + Rotl32(m_v[1], 7) + Rotl32(m_v[2], 12) + Rotl32(m_v[3], 18);
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += (uint32_t)m_total;
+
+    const uint8_t* p = m_pending;
+    size_t size = m_pendingSize;
+    while (size >= 4) {
+        h = Rotl32(h + ReadLE32(p) * kPrime3, 17) * kPrime4;
+        p += 4;
+        size -= 4;
+    }
+    while (size > 0) {
+        h = Rotl32(h + *p * kPrime5, 11) * kPrime1;
+        ++p;
+        --size;
+    }
+    h ^= h >> 15;
+    h *= kPrime2;
+    h ^= h >> 13;
+    h *= kPrime3;
+    h ^= h >> 16;
+    return h;
+}
+
+uint32_t HashBytes32(const void* data, size_t size, uint32_t seed) {
+    Xxh32 hasher(seed);
+    hasher.Update(data, size);
+    return hasher.Digest();
+}
+
+// ---------------------------------------------------------------------------
+// 编码
+
+size_t Lz4FrameEncoder::Header(uint8_t* out) {
+    m_checksum.Reset(0);
+    WriteLE32(out, kMagic);
+    out[4] = kFlagVersion | kFlagBlockIndependent | kFlagContentChecksum;
+    out[5] = kBlockMax64K;
+    out[6] = (uint8_t)(HashBytes32(out + 4, 2) >> 8);
+    return kHeaderSize;
+}
+
+size_t Lz4FrameEncoder::EncodeBlock(const uint8_t* data, size_t size, uint8_t* out) {
+    if (size == 0) return 0;
+    if (size > kBlockSize) size = kBlockSize;
+    m_checksum.Update(data, size);
+
+    // 压缩结果必须比原文小，否则原样存放
+    size_t compressed = CompressBlock(data, size, out + 4, size - 1);
+    if (compressed > 0) {
+        WriteLE32(out, (uint32_t)compressed);
+        return 4 + compressed;
+    }
+    WriteLE32(out, (uint32_t)size | kUncompressedBit);
+    memcpy(out + 4, data, size);
+    return 4 + size;
+}
+
+size_t Lz4FrameEncoder::Trailer(uint8_t* out) {
+    WriteLE32(out, 0);
+    WriteLE32(out + 4, m_checksum.Digest());
+    return kTrailerSize;
+}
+
+// 写一个序列的字面量部分与匹配长度；空间不足时返回 nullptr
+static uint8_t* EmitSequence(uint8_t* op, uint8_t* end, const uint8_t* literals, size_t literalLength,
+                             size_t offset, size_t matchLength) {
+    size_t need = 1 + literalLength + literalLength / 255 + 1;
+    if (matchLength > 0) need += 2 + (matchLength - kMinMatch) / 255 + 1;
+    if ((size_t)(end - op) < need) return nullptr;
+
+    uint8_t* token = op++;
+    if (literalLength >= 15) {
+        *token = 15 << 4;
+        size_t rest = literalLength - 15;
+        for (; rest >= 255; rest -= 255) *op++ = 255;
+        *op++ = (uint8_t)rest;
+    } else {
+        *token = (uint8_t)(literalLength << 4);
+    }
+    memcpy(op, literals, literalLength);
+    op += literalLength;
+    if (matchLength == 0) return op;  // 块尾只有字面量的最后一个序列
+
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t code = matchLength - kMinMatch;
+    if (code >= 15) {
+        *token |= 15;
+        size_t rest = code - 15;
+        for (; rest >= 255; rest -= 255) *op++ = 255;
+        *op++ = (uint8_t)rest;
+    } else {
+        *token |= (uint8_t)code;
+    }
+    return op;
+}
+
+// 贪心匹配：每个位置查一次哈希表，连续失配时逐渐加大步长，对日志这类文本与已压缩数据都保持高吞吐
+size_t Lz4FrameEncoder::CompressBlock(const uint8_t* src, size_t size, uint8_t* out, size_t limit) {
+    uint8_t* op = out;
+    uint8_t* end = out + limit;
+    size_t anchor = 0;
+
+    if (size > kMatchFindLimit) {
+        memset(m_table, 0, sizeof(m_table));
+        const size_t matchStartLimit = size - kMatchFindLimit;   // 匹配起点不超过这里
+        const size_t matchEndLimit = size - kLastLiterals;       // 匹配终点不超过这里
+        size_t ip = 0;
+        uint32_t misses = 0;
+        while (ip <= matchStartLimit) {
+            uint32_t hash = (Read32(src + ip) * kPrime1) >> (32 - kHashLog);
+            uint32_t candidate = m_table[hash];
+            m_table[hash] = (uint32_t)ip + 1;
+            if (candidate == 0 || ip - (candidate - 1) > kMaxOffset || Read32(src + candidate - 1) != Read32(src + ip)) {
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+            misses = 0;
+
+            size_t ref = candidate - 1;
+            // 向前延伸到上一个序列的结尾
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                --ip;
+                --ref;
+            }
+            size_t length = kMinMatch;
+            while (ip + length < matchEndLimit && src[ip + length] == src[ref + length]) ++length;
+
+            op = EmitSequence(op, end, src + anchor, ip - anchor, ip - ref, length);
+            if (!op) return 0;
+            ip += length;
+            anchor = ip;
+            // 匹配内部的一个位置也记入哈希表，提高下一次命中的机会
+            if (ip - 2 <= matchStartLimit) {
+                m_table[(Read32(src + ip - 2) * kPrime1) >> (32 - kHashLog)] = (uint32_t)(ip - 2) + 1;
+            }
+        }
+    }
+
+    op = EmitSequence(op, end, src + anchor, size - anchor, 0, 0);
+    return op ? (size_t)(op - out) : 0;
+}
+
+// ---------------------------------------------------------------------------
+// 解码
+
+static bool DecodeBlock(const uint8_t* ip, size_t size, std::string* out) {
+    const uint8_t* end = ip + size;
+    while (ip < end) {
+        uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            uint8_t byte;
+            do {
+                if (ip >= end) return false;
+                byte = *ip++;
+                literalLength += byte;
+            } while (byte == 255);
+        }
+        if ((size_t)(end - ip) < literalLength) return false;
+        out->append((const char*)ip, literalLength);
+        ip += literalLength;
+        if (ip == end) return true;  // 最后一个序列没有匹配部分
+
+        if (end - ip < 2) return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t matchLength = (token & 15);
+        if (matchLength == 15) {
+            uint8_t byte;
+            do {
+                if (ip >= end) return false;
+                byte = *ip++;
+                matchLength += byte;
+            } while (byte == 255);
+        }
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > out->size()) return false;
+        // 匹配可能与自身重叠（offset 小于长度），逐字节复制
+        size_t from = out->size() - offset;
+        for (size_t i = 0; i < matchLength; ++i) out->push_back((*out)[from + i]);
+    }
+    return true;
+}
+
+bool Lz4DecodeFrameBlocks(const uint8_t* data, size_t size, const Lz4BlockSink& sink, std::string* error) {
+    if (size < Lz4FrameEncoder::kHeaderSize || ReadLE32(data) != kMagic) {
+        if (error) *error = "不是 LZ4 帧";
+        return false;
+    }
+    uint8_t flags = data[4];
+    if ((flags & 0xC0) != kFlagVersion || (flags & kFlagDictId)) {
+        if (error) *error = "不支持的 LZ4 帧参数";
+        return false;
+    }
+    size_t headerSize = 7 + ((flags & kFlagContentSize) ? 8 : 0);
+    if (size < headerSize || (uint8_t)(HashBytes32(data + 4, headerSize - 5) >> 8) != data[headerSize - 1]) {
+        if (error) *error = "LZ4 帧头校验失败";
+        return false;
+    }
+
+    // 独立块每块解压到清空的缓冲；非独立块的匹配可引用之前的内容，只能一直追加
+    bool independent = (flags & kFlagBlockIndependent) != 0;
+    std::string buffer;
+    buffer.reserve(Lz4FrameEncoder::kBlockSize);
+    Xxh32 checksum;
+    size_t pos = headerSize;
+    for (;;) {
+        if (size - pos < 4) {
+            if (error) *error = "LZ4 帧被截断";
+            return false;
+        }
+        uint32_t blockSize = ReadLE32(data + pos);
+        pos += 4;
+        if (blockSize == 0) break;
+        bool raw = (blockSize & kUncompressedBit) != 0;
+        blockSize &= ~kUncompressedBit;
+        size_t checksumSize = (flags & kFlagBlockChecksum) ? 4 : 0;
+        if (size - pos < blockSize + checksumSize) {
+            if (error) *error = "LZ4 帧被截断";
+            return false;
+        }
+        if (independent) buffer.clear();
+        size_t blockStart = buffer.size();
+        if (raw) {
+            buffer.append((const char*)data + pos, blockSize);
+        } else if (!DecodeBlock(data + pos, blockSize, &buffer)) {
+            if (error) *error = "LZ4 块数据损坏";
+            return false;
+        }
+        pos += blockSize + checksumSize;
+        checksum.Update(buffer.data() + blockStart, buffer.size() - blockStart);
+        if (!sink(buffer.data() + blockStart, buffer.size() - blockStart)) {
+            if (error) *error = "已取消";
+            return false;
+        }
+    }
+
+    if (flags & kFlagContentChecksum) {
+        if (size - pos < 4 || ReadLE32(data + pos) != checksum.Digest()) {
+            if (error) *error = "LZ4 内容校验失败";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Lz4DecodeFrame(const uint8_t* data, size_t size, std::string* out, std::string* error) {
+    out->clear();
+    return Lz4DecodeFrameBlocks(data, size, [out](const char* block, size_t length) {
+        out->append(block, length);
+        return true;
+    }, error);
+}
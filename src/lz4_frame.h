@@ -0,0 +1,72 @@
+// nginx-manager/src/lz4_frame.h
+// LZ4 帧格式 - 固定内存的分块压缩（64KB 独立块 + XXH32 内容校验），输出可直接用 lz4 -d 解压
+
+#ifndef LZ4_FRAME_H
+#define LZ4_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// 流式 XXH32，LZ4 帧的头部与内容校验使用
+class Xxh32 {
+public:
+    explicit Xxh32(uint32_t seed = 0) { Reset(seed); }
+
+    void Reset(uint32_t seed = 0);
+    void Update(const void* data, size_t size);
+    uint32_t Digest() const;
+
+private:
+    uint32_t m_v[4];
+    uint32_t m_seed = 0;
+    uint64_t m_total = 0;
+    uint8_t m_pending[16];
+    size_t m_pendingSize = 0;
+};
+
+uint32_t HashBytes32(const void* data, size_t size, uint32_t seed = 0);
+
+// LZ4 帧编码器
+// 用法：Header 写帧头，之后每次最多 kBlockSize 字节交给 EncodeBlock，最后 Trailer 写结束标记与校验。
+// 每块独立压缩（不引用前一块），压缩后不比原文小的块原样存放，因此输出缓冲固定为 kMaxBlockOutput。
+// 除对象本身（约 64KB 哈希表）外不分配内存。
+class Lz4FrameEncoder {
+public:
+    static constexpr size_t kBlockSize = 64 * 1024;
+    static constexpr size_t kHeaderSize = 7;
+    static constexpr size_t kTrailerSize = 8;
+    static constexpr size_t kMaxBlockOutput = 4 + kBlockSize;   // 块长度前缀 + 块内容
+
+    Lz4FrameEncoder() {}
+
+    Lz4FrameEncoder(const Lz4FrameEncoder&) = delete;
+    Lz4FrameEncoder& operator=(const Lz4FrameEncoder&) = delete;
+
+    // 开始新的一帧，返回写入 out 的字节数（kHeaderSize）
+    size_t Header(uint8_t* out);
+    // 压缩一块（size 不超过 kBlockSize），返回写入 out 的字节数
+    size_t EncodeBlock(const uint8_t* data, size_t size, uint8_t* out);
+    // 结束当前帧，返回写入 out 的字节数（kTrailerSize）
+    size_t Trailer(uint8_t* out);
+
+private:
+    static const uint32_t kHashLog = 14;
+
+    // LZ4 块格式压缩，输出超过 limit 时放弃并返回 0
+    size_t CompressBlock(const uint8_t* src, size_t size, uint8_t* out, size_t limit);
+
+    uint32_t m_table[1u << kHashLog];    // 哈希 -> 块内位置 + 1，0 表示空
+    Xxh32 m_checksum;
+};
+
+// 解压一整帧（供校验与基准使用）；校验和不符时返回 false
+bool Lz4DecodeFrame(const uint8_t* data, size_t size, std::string* out, std::string* error);
+
+// 逐块解压：每解出一块即交给 sink（独立块帧只占用一块的缓冲），sink 返回 false 时中止；
+// 内容校验在全部块之后进行，因此校验失败前 sink 可能已收到内容
+typedef std::function<bool(const char* data, size_t size)> Lz4BlockSink;
+bool Lz4DecodeFrameBlocks(const uint8_t* data, size_t size, const Lz4BlockSink& sink, std::string* error);
+
+#endif // LZ4_FRAME_H
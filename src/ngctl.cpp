@@ -0,0 +1,76 @@
+// nginx-manager/src/ngctl.cpp
+// 命令行控制工具 - 向无界面模式发送服务控制、状态查询、CPU 绑定、日志轮转、压测、upstream 健康检查、访问日志查询、追踪与操作日志查询请求
+
+#include "control_client.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static void PrintUsage() {
+    fprintf(stderr,
+            "用法: ngctl [--endpoint <端点>] <命令> [key=value ...]\n"
+            "命令: ping | status | metrics | start | stop | restart | reload | affinity | apply-affinity | rotate\n"
+            "      loadtest | compare | upstreams | logquery | trace | journal\n"
+            "      affinity / apply-affinity 可带 workers=<数量> smt=1\n"
+            "      loadtest 可带 connections=<连接数> threads=<线程数> rate=<请求/秒> duration=<秒> warmup=<秒>\n"
+            "               path=<路径> port=<端口> host=<本机地址>\n"
+            "      compare 可带 base=<配置指纹前缀> other=<配置指纹前缀>，默认对比最近两份配置\n"
+            "      logquery 可带 from=<-24h|2026-10-17T08:00> to=<同上> status=<404|5xx|400-499> method=<方法>\n"
+            "               host=<Host> uri=<路径前缀> group=<none|uri|status|method|host|minute|hour|day>\n"
+            "               order=<count|bytes|p50|p99|key> limit=<行数> threads=<线程数>\n"
+            "      trace 可带 enable=<1|0> 开启 / 关闭追踪，export=<文件名.json|1> 导出 Chrome trace JSON 到 logs 目录 (1 为默认文件名)\n"
+            "      journal 可带 from=<-1h|2026-10-17T08:00> to=<同上> type=<log|event|operation> limit=<条数>\n"
+            "默认端点: %s\n",
+            DefaultControlEndpoint().c_str());
+}
+
+int main(int argc, char** argv) {
+#ifdef _WIN32
+    SetConsoleOutputCP(CP_UTF8);
+#endif
+    std::string endpoint = DefaultControlEndpoint();
+    std::string commandName;
+    std::string payload;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--endpoint") == 0 && i + 1 < argc) {
+            endpoint = argv[++i];
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            PrintUsage();
+            return 0;
+        } else if (commandName.empty()) {
+            commandName = argv[i];
+        } else if (strchr(argv[i], '=') != nullptr) {
+            // 命令参数原样作为 payload 的 key=value 行
+            payload += argv[i];
+            payload += '\n';
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    int command = ControlCommandFromName(commandName);
+    if (command == 0) {
+        PrintUsage();
+        return 2;
+    }
+
+    ControlClient client;
+    std::string error;
+    if (!client.Connect(endpoint, 5000, &error)) {
+        fprintf(stderr, "✗ %s\n", error.c_str());
+        return 2;
+    }
+    ControlFrame response;
+    if (!client.Call((uint8_t)command, payload, &response, &error)) {
+        fprintf(stderr, "✗ %s\n", error.c_str());
+        return 2;
+    }
+
+    fwrite(response.payload.data(), 1, response.payload.size(), stdout);
+    if (response.code != CONTROL_OK) {
+        fprintf(stderr, "✗ %s: %s\n", ControlCommandName(command), ControlStatusName(response.code));
+        return 1;
+    }
+    return 0;
+}
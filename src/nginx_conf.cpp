@@ -0,0 +1,590 @@
+// nginx-manager/src/nginx_conf.cpp
+// nginx 配置解析 - 内存映射读取、展开 include、按指令名 / server_name / listen 建立索引
+
+#include "nginx_conf.h"
+#include "file_util.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+
+// include 的最大嵌套深度，防止互相包含造成无限递归
+static const int kMaxIncludeDepth = 32;
+
+
+// ---------------------------------------------------------------------------
+// MappedFile
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+    Close();
+#ifdef _WIN32
+    m_file = CreateFileW(Utf8ToWide(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                         NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(m_file, &size)) {
+        Close();
+        return false;
+    }
+    m_size = (size_t)size.QuadPart;
+    if (m_size == 0) return true;             // 空文件无法映射，按空内容处理
+
+    m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!m_mapping) {
+        Close();
+        return false;
+    }
+    m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!m_data) {
+        Close();
+        return false;
+    }
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    m_size = (size_t)st.st_size;
+    if (m_size > 0) {
+        void* addr = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            m_size = 0;
+            return false;
+        }
+        madvise(addr, m_size, MADV_SEQUENTIAL);
+        m_data = (const char*)addr;
+    }
+    close(fd);                                // 映射建立后即可关闭描述符
+    return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if (m_data) munmap((void*)m_data, m_size);
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// ---------------------------------------------------------------------------
+// listen 地址
+
+bool ParseListenAddress(std::string_view value, ListenEndpoint* endpoint) {
+    if (value.empty() || value.substr(0, 5) == "unix:") return false;
+
+    std::string_view host;
+    std::string_view port;
+    if (value[0] == '[') {
+        size_t close = value.find(']');
+        if (close == std::string_view::npos) return false;
+        host = value.substr(1, close - 1);
+        if (close + 1 < value.size() && value[close + 1] == ':') port = value.substr(close + 2);
+    } else {
+        size_t colon = value.rfind(':');
+        if (colon != std::string_view::npos) {
+            host = value.substr(0, colon);
+            port = value.substr(colon + 1);
+        } else if (value.find_first_not_of("0123456789") == std::string_view::npos) {
+            port = value;
+        } else {
+            host = value;
+        }
+    }
+
+    int portNumber = 80;
+    if (!port.empty()) {
+        portNumber = 0;
+        for (char ch : port) {
+            if (ch < '0' || ch > '9' || portNumber > 65535) return false;
+            portNumber = portNumber * 10 + (ch - '0');
+        }
+    }
+    if (portNumber <= 0 || portNumber > 65535) return false;
+
+    if (host == "*" || host == "0.0.0.0") host = std::string_view();
+    endpoint->host = host == "::" ? std::string("::1") : std::string(host);
+    endpoint->port = (uint16_t)portNumber;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// 路径辅助
+
+// 展开通配符，返回按名称排序的文件列表（与 nginx 在 Linux 上使用 glob 的行为一致）
+static bool ExpandPattern(const std::string& pattern, std::vector<std::string>* paths) {
+    bool hasWildcard = pattern.find_first_of("*?[") != std::string::npos;
+    if (!hasWildcard) {
+        paths->push_back(pattern);
+        return true;
+    }
+
+#ifdef _WIN32
+    std::string dir = DirectoryOf(pattern);
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileW(Utf8ToWide(pattern).c_str(), &fd);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return GetLastError() == ERROR_FILE_NOT_FOUND;
+    }
+    size_t first = paths->size();
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        paths->push_back(dir + "\\" + WideToUtf8(fd.cFileName));
+    } while (FindNextFileW(hFind, &fd));
+    FindClose(hFind);
+    std::sort(paths->begin() + first, paths->end());
+    return true;
+#else
+    glob_t matches = glob_t();
+    int rc = glob(pattern.c_str(), 0, NULL, &matches);
+    if (rc == 0) {
+        for (size_t i = 0; i < matches.gl_pathc; ++i) {
+            paths->push_back(matches.gl_pathv[i]);
+        }
+    }
+    // 出错时 glob 也可能已分配了部分结果，总是释放
+    globfree(&matches);
+    return rc == 0 || rc == GLOB_NOMATCH;     // 通配符没有匹配到文件不是错误
+#endif
+}
+
+// 处理引号参数中的转义：\" \' \\ \t \r \n
+static std::string Unescape(std::string_view raw) {
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char ch = raw[i];
+        if (ch == '\\' && i + 1 < raw.size()) {
+            char next = raw[i + 1];
+            switch (next) {
+                case '"': case '\'': case '\\': out += next; ++i; continue;
+                case 't': out += '\t'; ++i; continue;
+                case 'r': out += '\r'; ++i; continue;
+                case 'n': out += '\n'; ++i; continue;
+                default: break;
+            }
+        }
+        out += ch;
+    }
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// FlatIndex
+
+static uint64_t HashKey(std::string_view key) {
+    // FNV-1a
+    uint64_t hash = 1469598103934665603ull;
+    for (unsigned char ch : key) {
+        hash ^= ch;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void FlatIndex::Add(std::string_view key, uint32_t value) {
+    m_pending.emplace_back(key, value);
+}
+
+void FlatIndex::Clear() {
+    m_pending.clear();
+    m_slots.clear();
+    m_values.clear();
+    m_keyCount = 0;
+}
+
+void FlatIndex::Build() {
+    size_t capacity = 16;
+    while (capacity < m_pending.size() * 2) capacity <<= 1;
+    m_slots.assign(capacity, Slot());
+    m_keyCount = 0;
+
+    // 第一遍：为每个 key 分配槽位并计数，记录每条记录落在哪个槽
+    std::vector<uint32_t> slotOf(m_pending.size());
+    const size_t mask = capacity - 1;
+    for (size_t i = 0; i < m_pending.size(); ++i) {
+        uint64_t hash = HashKey(m_pending[i].first);
+        size_t pos = (size_t)hash & mask;
+        while (m_slots[pos].count != 0 && (m_slots[pos].hash != hash || m_slots[pos].key != m_pending[i].first)) {
+            pos = (pos + 1) & mask;
+        }
+        Slot& slot = m_slots[pos];
+        if (slot.count == 0) {
+            slot.key = m_pending[i].first;
+            slot.hash = hash;
+            ++m_keyCount;
+        }
+        ++slot.count;
+        slotOf[i] = (uint32_t)pos;
+    }
+
+    // 第二遍：前缀和确定每个 key 在连续数组中的起点
+    uint32_t offset = 0;
+    for (Slot& slot : m_slots) {
+        slot.first = offset;
+        offset += slot.count;
+        slot.count = 0;
+    }
+
+    // 第三遍：按插入顺序填充
+    m_values.resize(m_pending.size());
+    for (size_t i = 0; i < m_pending.size(); ++i) {
+        Slot& slot = m_slots[slotOf[i]];
+        m_values[slot.first + slot.count++] = m_pending[i].second;
+    }
+
+    m_pending.clear();
+    m_pending.shrink_to_fit();
+}
+
+const FlatIndex::Slot* FlatIndex::Lookup(std::string_view key, uint64_t hash) const {
+    if (m_slots.empty()) return nullptr;
+    const size_t mask = m_slots.size() - 1;
+    size_t pos = (size_t)hash & mask;
+    while (m_slots[pos].count != 0) {
+        if (m_slots[pos].hash == hash && m_slots[pos].key == key) return &m_slots[pos];
+        pos = (pos + 1) & mask;
+    }
+    return nullptr;
+}
+
+IndexRange FlatIndex::Find(std::string_view key) const {
+    const Slot* slot = Lookup(key, HashKey(key));
+    if (!slot) return IndexRange();
+    const uint32_t* first = m_values.data() + slot->first;
+    return IndexRange(first, first + slot->count);
+}
+
+// ---------------------------------------------------------------------------
+// NginxConfig
+
+void NginxConfig::Clear() {
+    m_directives.clear();
+    m_args.clear();
+    m_unescaped.clear();
+    m_mapped.clear();
+    m_files.clear();
+    m_byName.Clear();
+    m_byServerName.Clear();
+    m_byPort.clear();
+    m_endpoints.clear();
+    m_rootFirst = kNoDirective;
+    m_rootLast = kNoDirective;
+    m_confPrefix.clear();
+    m_totalBytes = 0;
+}
+
+bool NginxConfig::Load(const std::string& mainPath, std::string* error) {
+    TraceSpan span(TRACE_CONFIG, "config-parse");
+    Clear();
+    m_confPrefix = DirectoryOf(mainPath);
+
+    std::unique_ptr<MappedFile> mapped(new MappedFile());
+    if (!mapped->Open(mainPath)) {
+        if (error) *error = mainPath + ": 无法打开配置文件";
+        return false;
+    }
+    m_totalBytes += mapped->Size();
+    m_mapped.push_back(std::move(mapped));
+    m_files.push_back(mainPath);
+
+    std::string localError;
+    if (!ParseFile(0, kNoDirective, 0, &localError)) {
+        if (error) *error = localError;
+        return false;
+    }
+    BuildIndexes();
+    return true;
+}
+
+uint32_t NginxConfig::AddDirective(std::string_view name, uint32_t firstArg, uint32_t argCount, uint32_t parent,
+                                   uint32_t file, uint32_t line, bool isBlock) {
+    uint32_t index = (uint32_t)m_directives.size();
+    ConfDirective directive;
+    directive.name = name;
+    directive.firstArg = firstArg;
+    directive.argCount = argCount;
+    directive.parent = parent;
+    directive.firstChild = kNoDirective;
+    directive.lastChild = kNoDirective;
+    directive.nextSibling = kNoDirective;
+    directive.file = file;
+    directive.line = line;
+    directive.isBlock = isBlock;
+    m_directives.push_back(directive);
+
+    uint32_t* first = parent == kNoDirective ? &m_rootFirst : &m_directives[parent].firstChild;
+    uint32_t* last = parent == kNoDirective ? &m_rootLast : &m_directives[parent].lastChild;
+    if (*first == kNoDirective) {
+        *first = index;
+    } else {
+        m_directives[*last].nextSibling = index;
+    }
+    *last = index;
+    return index;
+}
+
+bool NginxConfig::IncludeFiles(std::string_view pattern, uint32_t parent, int depth, uint32_t file, uint32_t line,
+                               std::string* error) {
+    if (depth >= kMaxIncludeDepth) {
+        *error = m_files[file] + ":" + std::to_string(line) + ": include 嵌套过深";
+        return false;
+    }
+
+    std::string fullPattern = IsAbsolutePath(pattern) ? std::string(pattern)
+                                                      : m_confPrefix + "/" + std::string(pattern);
+    std::vector<std::string> paths;
+    if (!ExpandPattern(fullPattern, &paths)) {
+        *error = m_files[file] + ":" + std::to_string(line) + ": 无法展开 include \"" + fullPattern + "\"";
+        return false;
+    }
+
+    for (const std::string& path : paths) {
+        std::unique_ptr<MappedFile> mapped(new MappedFile());
+        if (!mapped->Open(path)) {
+            *error = m_files[file] + ":" + std::to_string(line) + ": 无法打开 include 文件 \"" + path + "\"";
+            return false;
+        }
+        uint32_t included = (uint32_t)m_files.size();
+        m_totalBytes += mapped->Size();
+        m_mapped.push_back(std::move(mapped));
+        m_files.push_back(path);
+        if (!ParseFile(included, parent, depth + 1, error)) return false;
+    }
+    return true;
+}
+
+// 单遍扫描：词法分析与建树同时进行，参数直接以 string_view 指向映射内存
+bool NginxConfig::ParseFile(uint32_t file, uint32_t parent, int depth, std::string* error) {
+    const MappedFile& content = *m_mapped[file];
+    const char* p = content.Data();
+    const char* end = p + content.Size();
+    uint32_t line = 1;
+    uint32_t statementLine = 1;
+    uint32_t current = parent;
+    uint32_t statementArgs = (uint32_t)m_args.size();   // 当前语句第一个词在 m_args 中的位置
+    std::vector<uint32_t> openBlocks;
+
+    auto fail = [&](const char* message) {
+        *error = m_files[file] + ":" + std::to_string(line) + ": " + message;
+        return false;
+    };
+
+    while (p < end) {
+        char ch = *p;
+        if (ch == '\n') {
+            ++line;
+            ++p;
+            continue;
+        }
+        if (ch == ' ' || ch == '\t' || ch == '\r') {
+            ++p;
+            continue;
+        }
+        if (ch == '#') {
+            while (p < end && *p != '\n') ++p;
+            continue;
+        }
+
+        if (ch == ';' || ch == '{') {
+            uint32_t words = (uint32_t)m_args.size() - statementArgs;
+            if (words == 0) return fail(ch == ';' ? "意外的 \";\"" : "意外的 \"{\"");
+
+            std::string_view name = m_args[statementArgs];
+            uint32_t index = AddDirective(name, statementArgs + 1, words - 1, current, file, statementLine, ch == '{');
+            ++p;
+
+            if (ch == '{') {
+                openBlocks.push_back(current);
+                current = index;
+            } else if (name == "include") {
+                if (words != 2) return fail("include 指令参数个数错误");
+                if (!IncludeFiles(m_args[statementArgs + 1], current, depth, file, statementLine, error)) return false;
+            }
+            statementArgs = (uint32_t)m_args.size();
+            continue;
+        }
+
+        if (ch == '}') {
+            if (m_args.size() != statementArgs) return fail("意外的 \"}\"，缺少 \";\"");
+            if (openBlocks.empty()) return fail("意外的 \"}\"");
+            current = openBlocks.back();
+            openBlocks.pop_back();
+            ++p;
+            continue;
+        }
+
+        // 普通词或引号字符串
+        if (m_args.size() == statementArgs) statementLine = line;
+        if (ch == '"' || ch == '\'') {
+            char quote = ch;
+            const char* start = ++p;
+            bool escaped = false;
+            while (p < end && *p != quote) {
+                if (*p == '\\' && p + 1 < end) {
+                    escaped = true;
+                    ++p;
+                }
+                if (*p == '\n') ++line;
+                ++p;
+            }
+            if (p >= end) return fail("意外的文件结尾，缺少引号");
+
+            std::string_view raw(start, (size_t)(p - start));
+            if (escaped) {
+                m_unescaped.emplace_back(new std::string(Unescape(raw)));
+                m_args.push_back(*m_unescaped.back());
+            } else {
+                m_args.push_back(raw);
+            }
+            ++p;
+        } else {
+            const char* start = p;
+            while (p < end) {
+                char c = *p;
+                if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ';' || c == '{' || c == '}') break;
+                if (c == '$' && p + 1 < end && p[1] == '{') {
+                    // ${var} 形式的变量，其中的花括号不是块分隔符
+                    p += 2;
+                    while (p < end && *p != '}') ++p;
+                    if (p < end) ++p;
+                    continue;
+                }
+                if (c == '\\' && p + 1 < end) {
+                    if (p[1] == '\n') ++line;
+                    p += 2;
+                    continue;
+                }
+                ++p;
+            }
+            m_args.push_back(std::string_view(start, (size_t)(p - start)));
+        }
+    }
+
+    if (m_args.size() != statementArgs) return fail("意外的文件结尾，缺少 \";\"");
+    if (!openBlocks.empty()) return fail("意外的文件结尾，缺少 \"}\"");
+    return true;
+}
+
+void NginxConfig::BuildIndexes() {
+    for (uint32_t i = 0; i < (uint32_t)m_directives.size(); ++i) {
+        m_byName.Add(m_directives[i].name, i);
+    }
+    m_byName.Build();
+
+    auto isServerBlock = [this](uint32_t index) {
+        return index != kNoDirective && m_directives[index].isBlock && m_directives[index].name == "server";
+    };
+
+    for (uint32_t index : m_byName.Find("server_name")) {
+        const ConfDirective& directive = m_directives[index];
+        if (!isServerBlock(directive.parent)) continue;
+        for (uint32_t i = 0; i < directive.argCount; ++i) {
+            m_byServerName.Add(Arg(directive, i), directive.parent);
+        }
+    }
+    m_byServerName.Build();
+
+    for (uint32_t index : m_byName.Find("listen")) {
+        const ConfDirective& directive = m_directives[index];
+        ListenEndpoint endpoint;
+        if (!isServerBlock(directive.parent) || directive.argCount == 0 ||
+            !ParseListenAddress(Arg(directive, 0), &endpoint)) {
+            continue;
+        }
+        // stream 的 udp 与 HTTP/3 的 quic 监听 UDP 端口
+        bool datagram = false;
+        for (uint32_t i = 1; i < directive.argCount; ++i) {
+            if (Arg(directive, i) == "udp" || Arg(directive, i) == "quic") datagram = true;
+        }
+        if (datagram) continue;
+        std::vector<uint32_t>& servers = m_byPort[endpoint.port];
+        if (servers.empty() || std::none_of(m_endpoints.begin(), m_endpoints.end(), [&](const ListenEndpoint& ep) {
+                return ep.port == endpoint.port && ep.host == endpoint.host;
+            })) {
+            m_endpoints.push_back(endpoint);
+        }
+        // 同一个 server 在同一端口上可能有多条 listen（如 IPv4 与 IPv6），只记录一次
+        if (std::find(servers.begin(), servers.end(), directive.parent) == servers.end()) {
+            servers.push_back(directive.parent);
+        }
+    }
+}
+
+uint32_t NginxConfig::FindChild(uint32_t index, std::string_view name) const {
+    uint32_t child = index == kNoDirective ? m_rootFirst : m_directives[index].firstChild;
+    for (; child != kNoDirective; child = m_directives[child].nextSibling) {
+        if (m_directives[child].name == name) return child;
+    }
+    return kNoDirective;
+}
+
+IndexRange NginxConfig::ServersByPort(uint16_t port) const {
+    auto it = m_byPort.find(port);
+    if (it == m_byPort.end()) return IndexRange();
+    return IndexRange(it->second.data(), it->second.data() + it->second.size());
+}
+
+// ---------------------------------------------------------------------------
+// server 块辅助
+
+bool FindPlainListen(const NginxConfig& config, uint32_t server, ListenEndpoint* listen) {
+    bool sslOnly = false;
+    for (uint32_t child = config.FirstChild(server); child != NginxConfig::kNoDirective;
+         child = config.NextSibling(child)) {
+        const ConfDirective& c = config.At(child);
+        if (c.name != "listen" || c.argCount == 0) continue;
+        bool ssl = false;
+        for (uint32_t i = 1; i < c.argCount; ++i) {
+            if (config.Arg(c, i) == "ssl" || config.Arg(c, i) == "quic") ssl = true;
+        }
+        ListenEndpoint candidate;
+        if (!ParseListenAddress(config.Arg(c, 0), &candidate)) continue;
+        if (ssl) {
+            sslOnly = true;
+            continue;
+        }
+        *listen = candidate;
+        return true;
+    }
+    if (sslOnly) return false;
+    *listen = ListenEndpoint();
+    listen->port = 80;
+    return true;
+}
+
+std::string ServerHostName(const NginxConfig& config, uint32_t server) {
+    uint32_t serverName = config.FindChild(server, "server_name");
+    if (serverName == NginxConfig::kNoDirective) return std::string();
+    for (uint32_t i = 0; i < config.At(serverName).argCount; ++i) {
+        std::string_view name = config.Arg(serverName, i);
+        if (name.empty() || name == "_" || name.find_first_of("*~") != std::string_view::npos) continue;
+        return std::string(name);
+    }
+    return std::string();
+}
@@ -0,0 +1,181 @@
+// nginx-manager/src/nginx_conf.h
+// nginx 配置解析 - 内存映射读取、展开 include、按指令名 / server_name / listen 建立索引
+
+#ifndef NGINX_CONF_H
+#define NGINX_CONF_H
+
+#include "platform.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 只读内存映射文件
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const char* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = NULL;
+#endif
+};
+
+// 配置中的一个 listen 地址
+struct ListenEndpoint {
+    std::string host;                // 空表示通配地址，探测时使用 127.0.0.1
+    uint16_t port = 0;
+};
+
+// 解析 listen 指令参数，如 "80"、"127.0.0.1:8080"、"[::1]:443"；unix 套接字返回 false
+bool ParseListenAddress(std::string_view value, ListenEndpoint* endpoint);
+
+// 索引查询结果：指向索引内部连续数组的一段下标
+class IndexRange {
+public:
+    IndexRange() {}
+    IndexRange(const uint32_t* first, const uint32_t* last) : m_first(first), m_last(last) {}
+
+    const uint32_t* begin() const { return m_first; }
+    const uint32_t* end() const { return m_last; }
+    size_t size() const { return (size_t)(m_last - m_first); }
+    bool empty() const { return m_first == m_last; }
+    uint32_t operator[](size_t i) const { return m_first[i]; }
+
+private:
+    const uint32_t* m_first = nullptr;
+    const uint32_t* m_last = nullptr;
+};
+
+// 只读的字符串多值索引
+// 构建期只追加 (key, value)，Build 时用开放寻址表统计每个 key 的数量，
+// 再把所有 value 按 key 排布到一个连续数组中，整个索引只有几次大块分配。
+class FlatIndex {
+public:
+    void Add(std::string_view key, uint32_t value);
+    void Build();
+    void Clear();
+    IndexRange Find(std::string_view key) const;
+    size_t KeyCount() const { return m_keyCount; }
+
+private:
+    struct Slot {
+        std::string_view key;
+        uint64_t hash = 0;
+        uint32_t first = 0;
+        uint32_t count = 0;              // 0 表示空槽
+    };
+
+    const Slot* Lookup(std::string_view key, uint64_t hash) const;
+
+    std::vector<std::pair<std::string_view, uint32_t>> m_pending;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_values;
+    size_t m_keyCount = 0;
+};
+
+// 语法树中的一条指令；子指令通过 firstChild / nextSibling 串联
+struct ConfDirective {
+    std::string_view name;
+    uint32_t firstArg = 0;           // 在参数数组中的起始下标
+    uint32_t argCount = 0;
+    uint32_t parent = 0;             // 所在块指令，顶层为 kNoDirective
+    uint32_t firstChild = 0;
+    uint32_t lastChild = 0;
+    uint32_t nextSibling = 0;
+    uint32_t file = 0;               // 所在文件下标
+    uint32_t line = 0;
+    bool isBlock = false;
+};
+
+// nginx 配置
+// 所有字符串均为指向映射内存的 string_view，只有带转义的引号参数才会复制，
+// 因此对象存活期间映射文件始终保持打开。
+class NginxConfig {
+public:
+    static const uint32_t kNoDirective = 0xFFFFFFFFu;
+
+    NginxConfig() {}
+
+    NginxConfig(const NginxConfig&) = delete;
+    NginxConfig& operator=(const NginxConfig&) = delete;
+
+    // 解析主配置文件及其 include 的所有文件，失败时 error 形如 "file:line: 原因"
+    bool Load(const std::string& mainPath, std::string* error);
+    void Clear();
+
+    const std::vector<ConfDirective>& Directives() const { return m_directives; }
+    const ConfDirective& At(uint32_t index) const { return m_directives[index]; }
+    std::string_view Arg(const ConfDirective& directive, uint32_t i) const { return m_args[directive.firstArg + i]; }
+    std::string_view Arg(uint32_t index, uint32_t i) const { return Arg(m_directives[index], i); }
+
+    // 顶层第一条指令；遍历子指令：for (c = FirstChild(p); c != kNoDirective; c = NextSibling(c))
+    uint32_t FirstRoot() const { return m_rootFirst; }
+    uint32_t FirstChild(uint32_t index) const { return m_directives[index].firstChild; }
+    uint32_t NextSibling(uint32_t index) const { return m_directives[index].nextSibling; }
+
+    // 在 index 的直接子指令中查找第一条名为 name 的指令
+    uint32_t FindChild(uint32_t index, std::string_view name) const;
+
+    // 索引查询，未找到时返回空区间
+    IndexRange FindByName(std::string_view name) const { return m_byName.Find(name); }
+    IndexRange ServersByName(std::string_view serverName) const { return m_byServerName.Find(serverName); }
+    IndexRange ServersByPort(uint16_t port) const;
+
+    // 所有 TCP listen 地址（已去重）；带 udp / quic 参数的 listen 无法用连接探测，不包括在内
+    const std::vector<ListenEndpoint>& ListenEndpoints() const { return m_endpoints; }
+
+    // 解析涉及的所有文件（第 0 个为主配置文件）
+    const std::vector<std::string>& Files() const { return m_files; }
+    const MappedFile& FileContent(uint32_t file) const { return *m_mapped[file]; }
+
+    // 配置根目录（主配置文件所在目录），相对路径的 include 以此为基准
+    const std::string& ConfPrefix() const { return m_confPrefix; }
+    size_t TotalBytes() const { return m_totalBytes; }
+
+private:
+    bool ParseFile(uint32_t file, uint32_t parent, int depth, std::string* error);
+    bool IncludeFiles(std::string_view pattern, uint32_t parent, int depth, uint32_t file, uint32_t line,
+                      std::string* error);
+    uint32_t AddDirective(std::string_view name, uint32_t firstArg, uint32_t argCount, uint32_t parent,
+                          uint32_t file, uint32_t line, bool isBlock);
+    void BuildIndexes();
+
+    std::vector<ConfDirective> m_directives;
+    std::vector<std::string_view> m_args;
+    std::vector<std::unique_ptr<MappedFile>> m_mapped;
+    std::vector<std::string> m_files;
+    std::vector<std::unique_ptr<std::string>> m_unescaped;   // 带转义的参数需要复制一份
+    uint32_t m_rootFirst = kNoDirective;
+    uint32_t m_rootLast = kNoDirective;
+    std::string m_confPrefix;
+    size_t m_totalBytes = 0;
+
+    FlatIndex m_byName;
+    FlatIndex m_byServerName;
+    std::unordered_map<uint16_t, std::vector<uint32_t>> m_byPort;
+    std::vector<ListenEndpoint> m_endpoints;
+};
+
+// server 块中第一个明文（非 ssl / quic）的 listen 地址，server 未写 listen 时为 nginx 默认的 80 端口；
+// 只有 ssl listen 时返回 false
+bool FindPlainListen(const NginxConfig& config, uint32_t server, ListenEndpoint* listen);
+
+// server_name 中第一个确切的名称（跳过 "_"、通配符与正则），用作请求的 Host 头；没有时为空
+std::string ServerHostName(const NginxConfig& config, uint32_t server);
+
+#endif // NGINX_CONF_H
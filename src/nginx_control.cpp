@@ -0,0 +1,413 @@
+// nginx-manager/src/nginx_control.cpp
+// nginx 进程控制 - 直接创建 nginx 进程并持有其句柄 (Windows) / pidfd (Linux)
+
+#include "nginx_control.h"
+#include "trace.h"
+
+#include <algorithm>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+#ifdef _WIN32
+// 按 CommandLineToArgvW 的规则为参数加引号
+static std::wstring QuoteArgument(const std::wstring& arg) {
+    if (!arg.empty() && arg.find_first_of(L" \t\"") == std::wstring::npos) return arg;
+
+    std::wstring quoted = L"\"";
+    size_t backslashes = 0;
+    for (wchar_t ch : arg) {
+        if (ch == L'\\') {
+            ++backslashes;
+        } else if (ch == L'"') {
+            quoted.append(backslashes * 2 + 1, L'\\');
+            quoted += ch;
+            backslashes = 0;
+        } else {
+            quoted.append(backslashes, L'\\');
+            quoted += ch;
+            backslashes = 0;
+        }
+    }
+    quoted.append(backslashes * 2, L'\\');
+    quoted += L'"';
+    return quoted;
+}
+#else
+static int OpenPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+#endif
+
+#ifdef _WIN32
+static std::wstring BuildCommandLine(const std::string& binary, const std::vector<std::string>& args) {
+    std::wstring cmdLine = QuoteArgument(Utf8ToWide(binary));
+    for (const std::string& arg : args) {
+        cmdLine += L" " + QuoteArgument(Utf8ToWide(arg));
+    }
+    return cmdLine;
+}
+#else
+// 构造 argv，通过 -p 指定 prefix，避免依赖当前工作目录
+static std::vector<std::string> BuildArgStrings(const std::string& binary, const std::string& prefix,
+                                                const std::vector<std::string>& args) {
+    std::string prefixArg = prefix;
+    if (prefixArg.empty() || prefixArg.back() != '/') prefixArg += '/';
+
+    std::vector<std::string> argStrings;
+    argStrings.push_back(binary);
+    argStrings.push_back("-p");
+    argStrings.push_back(prefixArg);
+    argStrings.insert(argStrings.end(), args.begin(), args.end());
+    return argStrings;
+}
+
+static std::vector<char*> BuildArgv(std::vector<std::string>& argStrings) {
+    std::vector<char*> argv;
+    for (std::string& arg : argStrings) argv.push_back(&arg[0]);
+    argv.push_back(NULL);
+    return argv;
+}
+#endif
+
+std::string NginxBinaryPath(const std::string& prefix) {
+#ifdef _WIN32
+    return prefix + "\\nginx.exe";
+#else
+    std::string sbin = prefix + "/sbin/nginx";
+    struct stat st;
+    if (stat(sbin.c_str(), &st) == 0) return sbin;
+    return prefix + "/nginx";
+#endif
+}
+
+bool SpawnNginx(const std::string& prefix, const std::vector<std::string>& args,
+                SpawnedProcess* process, std::string* error) {
+    TraceSpan span(TRACE_PROCESS, "spawn");
+    *process = SpawnedProcess();
+    std::string binary = NginxBinaryPath(prefix);
+
+#ifdef _WIN32
+    std::wstring exePath = Utf8ToWide(binary);
+    std::wstring cmdLine = BuildCommandLine(binary, args);
+    std::wstring workDir = Utf8ToWide(prefix);
+
+    STARTUPINFOW si = {};
+    PROCESS_INFORMATION pi = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+
+    process->spawnMicros = MonotonicMicros();
+    if (!CreateProcessW(exePath.c_str(), &cmdLine[0], NULL, NULL, FALSE, CREATE_NO_WINDOW,
+                        NULL, workDir.c_str(), &si, &pi)) {
+        if (error) *error = "CreateProcess 失败，错误码 " + std::to_string(GetLastError());
+        return false;
+    }
+    CloseHandle(pi.hThread);
+    process->pid = pi.dwProcessId;
+    process->handle = pi.hProcess;
+    return true;
+#else
+    std::vector<std::string> argStrings = BuildArgStrings(binary, prefix, args);
+    std::vector<char*> argv = BuildArgv(argStrings);
+
+    // 调用方可能屏蔽或忽略了信号（无界面模式由专门的线程 sigwait 退出信号），这些设置会被子进程继承，
+    // nginx 收到 TERM / QUIT 时就不会退出；新进程一律使用空的信号掩码和默认处理方式
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    sigaddset(&signals, SIGPIPE);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGQUIT);
+    sigaddset(&signals, SIGHUP);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    process->spawnMicros = MonotonicMicros();
+    pid_t pid = 0;
+    int rc = posix_spawn(&pid, binary.c_str(), NULL, &attr, argv.data(), environ);
+    posix_spawnattr_destroy(&attr);
+    if (rc != 0) {
+        if (error) *error = std::string("posix_spawn 失败: ") + strerror(rc);
+        return false;
+    }
+    process->pid = (ProcessId)pid;
+    process->pidfd = OpenPidfd(pid);
+    return true;
+#endif
+}
+
+bool PollSpawnedExit(SpawnedProcess* process) {
+    if (process->exited) return true;
+    if (!process->pid) return false;
+
+#ifdef _WIN32
+    if (!process->handle || WaitForSingleObject(process->handle, 0) != WAIT_OBJECT_0) return false;
+    DWORD exitCode = 0;
+    GetExitCodeProcess(process->handle, &exitCode);
+    process->exitCode = (int)exitCode;
+#else
+    int status = 0;
+    pid_t rc = waitpid((pid_t)process->pid, &status, WNOHANG);
+    if (rc == 0) return false;
+    if (rc < 0) {
+        process->exitCode = -1;
+    } else if (WIFEXITED(status)) {
+        process->exitCode = WEXITSTATUS(status);
+    } else {
+        process->exitCode = 128 + (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    }
+#endif
+    process->exited = true;
+    return true;
+}
+
+void CloseSpawnedProcess(SpawnedProcess* process) {
+#ifdef _WIN32
+    if (process->handle) {
+        CloseHandle(process->handle);
+        process->handle = NULL;
+    }
+#else
+    if (process->pidfd >= 0) {
+        close(process->pidfd);
+        process->pidfd = -1;
+    }
+    // 仍在前台运行的子进程 (daemon off) 退出后仍需调用 PollSpawnedExit 回收
+#endif
+}
+
+#ifndef _WIN32
+// 运行 argStrings 描述的命令并收集 stdout/stderr 输出，超时后强制结束
+static bool RunArgv(std::vector<std::string>& argStrings, uint32_t timeoutMs, int* exitCode, std::string* output) {
+    const uint64_t deadline = MonotonicMicros() + (uint64_t)timeoutMs * 1000;
+    if (output) output->clear();
+    char buffer[4096];
+    std::vector<char*> argv = BuildArgv(argStrings);
+
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDERR_FILENO);
+
+    pid_t pid = 0;
+    int rc = posix_spawn(&pid, argv[0], &actions, NULL, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    if (rc != 0) {
+        close(fds[0]);
+        if (output) *output = std::string("posix_spawn 失败: ") + strerror(rc);
+        return false;
+    }
+
+    // 读到 EOF 说明子进程（及其继承了管道的后代）已关闭输出
+    bool timedOut = false;
+    for (;;) {
+        uint64_t now = MonotonicMicros();
+        if (now >= deadline) {
+            timedOut = true;
+            break;
+        }
+        pollfd pfd = { fds[0], POLLIN, 0 };
+        int ready = poll(&pfd, 1, (int)((deadline - now + 999) / 1000));
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready <= 0) continue;
+        ssize_t n = read(fds[0], buffer, sizeof(buffer));
+        if (n <= 0) break;
+        if (output) output->append(buffer, (size_t)n);
+    }
+    close(fds[0]);
+
+    if (timedOut) kill(pid, SIGKILL);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (exitCode) *exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    return !timedOut;
+}
+#endif
+
+bool RunNginxCommand(const std::string& prefix, const std::vector<std::string>& args, uint32_t timeoutMs,
+                     int* exitCode, std::string* output) {
+    std::string binary = NginxBinaryPath(prefix);
+
+#ifdef _WIN32
+    const uint64_t deadline = MonotonicMicros() + (uint64_t)timeoutMs * 1000;
+    if (output) output->clear();
+    char buffer[4096];
+
+    SECURITY_ATTRIBUTES sa = {};
+    sa.nLength = sizeof(sa);
+    sa.bInheritHandle = TRUE;
+    HANDLE readPipe = NULL;
+    HANDLE writePipe = NULL;
+    if (!CreatePipe(&readPipe, &writePipe, &sa, 0)) return false;
+    SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+    std::wstring exePath = Utf8ToWide(binary);
+    std::wstring cmdLine = BuildCommandLine(binary, args);
+    std::wstring workDir = Utf8ToWide(prefix);
+
+    STARTUPINFOW si = {};
+    PROCESS_INFORMATION pi = {};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
+    si.wShowWindow = SW_HIDE;
+    si.hStdOutput = writePipe;
+    si.hStdError = writePipe;
+
+    BOOL created = CreateProcessW(exePath.c_str(), &cmdLine[0], NULL, NULL, TRUE, CREATE_NO_WINDOW,
+                                  NULL, workDir.c_str(), &si, &pi);
+    CloseHandle(writePipe);
+    if (!created) {
+        CloseHandle(readPipe);
+        return false;
+    }
+    CloseHandle(pi.hThread);
+
+    // 边等待边读取输出，避免子进程因管道写满而阻塞
+    bool finished = false;
+    for (;;) {
+        DWORD available = 0;
+        while (PeekNamedPipe(readPipe, NULL, 0, NULL, &available, NULL) && available > 0) {
+            DWORD bytesRead = 0;
+            if (!ReadFile(readPipe, buffer, sizeof(buffer), &bytesRead, NULL) || bytesRead == 0) break;
+            if (output) output->append(buffer, bytesRead);
+        }
+        if (finished) break;
+
+        uint64_t now = MonotonicMicros();
+        DWORD waitMs = now >= deadline ? 0 : (DWORD)std::min<uint64_t>((deadline - now) / 1000, 10);
+        if (WaitForSingleObject(pi.hProcess, waitMs) == WAIT_OBJECT_0) {
+            finished = true;              // 再读取一次残留输出
+        } else if (now >= deadline) {
+            TerminateProcess(pi.hProcess, 1);
+            break;
+        }
+    }
+
+    DWORD code = 1;
+    GetExitCodeProcess(pi.hProcess, &code);
+    if (exitCode) *exitCode = (int)code;
+    CloseHandle(pi.hProcess);
+    CloseHandle(readPipe);
+    return finished;
+#else
+    std::vector<std::string> argStrings = BuildArgStrings(binary, prefix, args);
+    return RunArgv(argStrings, timeoutMs, exitCode, output);
+#endif
+}
+
+#ifndef _WIN32
+bool QueryCompiledPrefix(const std::string& binary, std::string* prefix) {
+    TraceSpan span(TRACE_PROCESS, "nginx -V");
+    std::vector<std::string> argStrings;
+    argStrings.push_back(binary);
+    argStrings.push_back("-V");
+    int exitCode = 1;
+    std::string output;
+    if (!RunArgv(argStrings, 5000, &exitCode, &output) || exitCode != 0) return false;
+
+    // "configure arguments: --prefix=/etc/nginx --sbin-path=..."；未指定 --prefix 时为 nginx 的默认值
+    size_t pos = output.find("--prefix=");
+    if (pos == std::string::npos) {
+        *prefix = "/usr/local/nginx";
+        return true;
+    }
+    pos += 9;
+    size_t end = output.find_first_of(" \t\r\n", pos);
+    *prefix = output.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    return !prefix->empty();
+}
+#endif
+
+bool TestNginxConfig(const std::string& prefix, std::string* output) {
+    TraceSpan span(TRACE_PROCESS, "nginx -t");
+    std::vector<std::string> args;
+    args.push_back("-t");
+    int exitCode = 1;
+    if (!RunNginxCommand(prefix, args, 30000, &exitCode, output)) {
+        if (output && output->empty()) *output = "nginx -t 执行失败或超时";
+        return false;
+    }
+    return exitCode == 0;
+}
+
+bool SignalNginx(const std::string& prefix, ProcessId masterPid, NginxSignal signal, std::string* error) {
+    TraceSpan span(TRACE_PROCESS, "signal", signal);
+#ifdef _WIN32
+    // Windows 版 nginx 没有 POSIX 信号，通过 nginx -s 经由 master 的事件对象通知
+    (void)masterPid;
+    static const char* names[] = { "reload", "reopen", "quit", "stop" };
+    std::vector<std::string> args;
+    args.push_back("-s");
+    args.push_back(names[signal]);
+
+    int exitCode = 1;
+    std::string output;
+    if (!RunNginxCommand(prefix, args, 10000, &exitCode, &output) || exitCode != 0) {
+        if (error) *error = output.empty() ? std::string("nginx -s ") + names[signal] + " 执行失败" : output;
+        return false;
+    }
+    return true;
+#else
+    (void)prefix;
+    static const int signals[] = { SIGHUP, SIGUSR1, SIGQUIT, SIGTERM };
+    if (!masterPid || kill((pid_t)masterPid, signals[signal]) != 0) {
+        if (error) *error = std::string("kill 失败: ") + strerror(masterPid ? errno : ESRCH);
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool KillProcesses(const std::vector<ProcessId>& pids, std::string* error) {
+    TraceSpan span(TRACE_PROCESS, "kill", (int64_t)pids.size());
+    bool ok = true;
+    for (ProcessId pid : pids) {
+#ifdef _WIN32
+        HANDLE process = OpenProcess(PROCESS_TERMINATE, FALSE, pid);
+        if (!process) {
+            // 进程已退出时 OpenProcess 返回 ERROR_INVALID_PARAMETER，不算失败
+            if (GetLastError() == ERROR_INVALID_PARAMETER) continue;
+            if (error) *error = "无法打开进程 " + std::to_string(pid);
+            ok = false;
+            continue;
+        }
+        if (!TerminateProcess(process, 1) && WaitForSingleObject(process, 0) != WAIT_OBJECT_0) {
+            if (error) *error = "无法结束进程 " + std::to_string(pid);
+            ok = false;
+        }
+        CloseHandle(process);
+#else
+        if (kill((pid_t)pid, SIGKILL) != 0 && errno != ESRCH) {
+            if (error) *error = "kill " + std::to_string(pid) + " 失败: " + strerror(errno);
+            ok = false;
+        }
+#endif
+    }
+    return ok;
+}
@@ -0,0 +1,64 @@
+// nginx-manager/src/nginx_control.h
+// nginx 进程控制 - 直接创建 nginx 进程并持有其句柄 (Windows) / pidfd (Linux)
+
+#ifndef NGINX_CONTROL_H
+#define NGINX_CONTROL_H
+
+#include "platform.h"
+#include <string>
+#include <vector>
+
+// 由管理器创建的 nginx 进程
+struct SpawnedProcess {
+    ProcessId pid = 0;
+    uint64_t spawnMicros = 0;        // 创建时刻 (MonotonicMicros)
+    bool exited = false;
+    int exitCode = 0;
+#ifdef _WIN32
+    HANDLE handle = NULL;
+#else
+    int pidfd = -1;                  // 内核不支持 pidfd 时为 -1，退化为 waitpid 轮询
+#endif
+};
+
+// nginx 可执行文件路径：Windows 为 <prefix>\nginx.exe，Linux 依次尝试 sbin/nginx 与 nginx
+std::string NginxBinaryPath(const std::string& prefix);
+
+// 以 prefix 为工作目录创建 nginx 进程，args 为附加命令行参数
+bool SpawnNginx(const std::string& prefix, const std::vector<std::string>& args,
+                SpawnedProcess* process, std::string* error);
+
+// 非阻塞检查进程是否已退出，退出时填写 exitCode
+bool PollSpawnedExit(SpawnedProcess* process);
+
+// 释放进程句柄 / pidfd（不会终止进程）
+void CloseSpawnedProcess(SpawnedProcess* process);
+
+// 运行一次性的 nginx 命令（如 -t、-s reload），等待其结束并收集 stdout/stderr 输出
+// 返回进程是否在超时前正常结束，exitCode 为其退出码
+bool RunNginxCommand(const std::string& prefix, const std::vector<std::string>& args, uint32_t timeoutMs,
+                     int* exitCode, std::string* output);
+
+#ifndef _WIN32
+// 运行 <binary> -V，取编译时的安装前缀 (configure 参数 --prefix=，未指定时为 /usr/local/nginx)
+bool QueryCompiledPrefix(const std::string& binary, std::string* prefix);
+#endif
+
+// 使用 nginx -t 校验配置，output 为 nginx 输出的诊断信息
+bool TestNginxConfig(const std::string& prefix, std::string* output);
+
+// 发给 master 进程的控制信号
+enum NginxSignal {
+    NGINX_SIGNAL_RELOAD,             // 重新加载配置 (-s reload / SIGHUP)
+    NGINX_SIGNAL_REOPEN,             // 重新打开日志 (-s reopen / SIGUSR1)
+    NGINX_SIGNAL_QUIT,               // 优雅退出 (-s quit / SIGQUIT)
+    NGINX_SIGNAL_STOP                // 快速退出 (-s stop / SIGTERM)
+};
+
+// 向 master 发送信号：Windows 上通过 nginx -s，Linux 上直接 kill(masterPid, ...)
+bool SignalNginx(const std::string& prefix, ProcessId masterPid, NginxSignal signal, std::string* error);
+
+// 强制结束指定进程 (TerminateProcess / SIGKILL)，已经退出的进程不算失败
+bool KillProcesses(const std::vector<ProcessId>& pids, std::string* error);
+
+#endif // NGINX_CONTROL_H
@@ -0,0 +1,408 @@
+// nginx-manager/src/nginx_service.cpp
+// nginx 服务控制 - 与界面无关的启动 / 停止 / 重启 / 重载流程，图形界面与无界面模式共用
+
+#include "nginx_service.h"
+#include "nginx_control.h"
+#include "conf_edit.h"
+#include "file_util.h"
+
+#include <cstdio>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#endif
+
+// 自动恢复时最多清理这么多组遗留进程（每组一次扫描 + 结束 + 等待）
+static const size_t kMaxLeftovers = 16;
+// 启动后等待 worker 全部创建再校验 CPU 绑定的最长时间
+static const uint32_t kAffinityWaitMs = 1000;
+
+NginxService::NginxService(const std::string& prefix) : m_prefix(prefix) {
+    m_table.SetPrefix(prefix);
+}
+
+void NginxService::SetPrefix(const std::string& prefix) {
+    if (prefix == m_prefix) return;
+    m_prefix = prefix;
+    m_table.SetPrefix(prefix);
+    m_liveFingerprint = 0;
+}
+
+std::string NginxService::PrefixPath(const std::string& relative) const {
+    std::string path = m_prefix;
+#ifdef _WIN32
+    const char separator = '\\';
+#else
+    const char separator = '/';
+#endif
+    if (!path.empty() && path.back() != '/' && path.back() != '\\') path += separator;
+    for (char c : relative) {
+        path += (c == '/') ? separator : c;
+    }
+    return path;
+}
+
+void NginxService::Log(LogSeverity severity, const std::string& text) {
+    if (m_log) m_log(severity, text);
+}
+
+bool NginxService::IsRunning() {
+    return m_table.IsRunning();
+}
+
+// 校验配置，config 为本次解析的配置，供后续构造就绪检测参数
+bool NginxService::Preflight(NginxConfig* config, ServiceOutcome* outcome) {
+    ValidationVerdict verdict = m_validationCache.Validate(m_prefix, ConfPath(), config);
+    m_checkedFingerprint = verdict.ok ? verdict.fingerprint : 0;
+
+    char text[256];
+    if (verdict.cached) {
+        snprintf(text, sizeof(text), "配置未变化，沿用上次校验结论 (指纹 %016llx, 计算耗时 %.1f ms)",
+                 (unsigned long long)verdict.fingerprint, verdict.hashMicros / 1000.0);
+        Log(LOG_DETAIL, text);
+    } else {
+        snprintf(text, sizeof(text), "已校验配置 (nginx -t 耗时 %.1f ms)", verdict.testMicros / 1000.0);
+        Log(LOG_INFO, text);
+    }
+
+    if (!verdict.ok) {
+        Log(LOG_ERROR, "✗ 配置校验失败");
+        if (!verdict.output.empty()) Log(LOG_ERROR, verdict.output);
+        outcome->configRejected = true;
+        outcome->detail = "配置校验失败: " + verdict.output;
+    }
+    return verdict.ok;
+}
+
+std::string NginxService::PidFilePath(const NginxConfig& config) const {
+    ConfigHints hints = ConfigHintsFrom(config);
+    if (hints.pidFile.empty()) return PrefixPath("logs/nginx.pid");
+    if (IsAbsolutePath(hints.pidFile)) return hints.pidFile;
+    return PrefixPath(hints.pidFile);
+}
+
+std::string NginxService::PidFile() const {
+    NginxConfig config;
+    std::string error;
+    if (!config.Load(ConfPath(), &error)) return PrefixPath("logs/nginx.pid");
+    return PidFilePath(config);
+}
+
+bool NginxService::LaunchAndWait(const NginxConfig& config, ReadinessResult* result) {
+    ConfigHints hints = ConfigHintsFrom(config);
+    ReadinessOptions options;
+    options.pidFile = PidFilePath(config);
+    options.stalePid = ReadPidFile(options.pidFile);
+    options.endpoints = hints.endpoints;
+
+    SpawnedProcess process;
+    std::string error;
+    if (!SpawnNginx(m_prefix, std::vector<std::string>(), &process, &error)) {
+        *result = ReadinessResult();
+        result->detail = error;
+        return false;
+    }
+    *result = WaitForStartReady(&process, options);
+    CloseSpawnedProcess(&process);
+    m_table.Invalidate();
+    return result->ready;
+}
+
+bool NginxService::KillAndWait(ReadinessResult* result) {
+    m_table.Refresh();
+    std::vector<ProcessId> pids;
+    for (const ProcessEntry& entry : m_table.Entries()) {
+        pids.push_back(entry.pid);
+    }
+
+    uint64_t begin = MonotonicMicros();
+    std::string error;
+    if (!KillProcesses(pids, &error)) Log(LOG_ERROR, "✗ " + error);
+    *result = WaitForProcessesGone(pids, begin, 5000);
+#ifndef _WIN32
+    // 前台运行 (daemon off) 的 master 是本进程的子进程，退出后需要回收，否则留下僵尸进程
+    for (ProcessId pid : pids) waitpid((pid_t)pid, NULL, WNOHANG);
+#endif
+    m_table.Invalidate();
+    return result->ready;
+}
+
+ServiceOutcome NginxService::Start(const OperationContext& context) {
+    ServiceOutcome outcome;
+    if (IsRunning()) {
+        Log(LOG_WARNING, "Nginx 已经在运行中");
+        outcome.ok = true;
+        outcome.detail = "已经在运行中";
+        outcome.masterPid = m_table.MasterPid();
+        return outcome;
+    }
+    if (context.IsCancelled()) return outcome;
+
+    NginxConfig config;
+    if (!Preflight(&config, &outcome) || context.IsCancelled()) return outcome;
+
+    Log(LOG_INFO, "正在启动 nginx...");
+    ReadinessResult ready;
+    outcome.changed = true;
+    outcome.ok = LaunchAndWait(config, &ready);
+    outcome.latencyMicros = ready.latencyMicros;
+    outcome.masterPid = ready.masterPid;
+
+    char text[512];
+    if (outcome.ok) {
+        m_liveFingerprint = m_checkedFingerprint;
+        snprintf(text, sizeof(text), "✓ Nginx 启动成功 (就绪耗时 %.1f ms)", ready.latencyMicros / 1000.0);
+        Log(LOG_SUCCESS, text);
+        CheckAffinity(config, std::vector<ProcessId>());
+    } else {
+        outcome.detail = ready.detail;
+        snprintf(text, sizeof(text), "✗ Nginx 启动失败: %s", ready.detail.c_str());
+        Log(LOG_ERROR, text);
+    }
+    return outcome;
+}
+
+ServiceOutcome NginxService::Stop(const OperationContext& context) {
+    ServiceOutcome outcome;
+    if (!IsRunning()) {
+        Log(LOG_WARNING, "Nginx 未运行");
+        outcome.ok = true;
+        outcome.detail = "未运行";
+        return outcome;
+    }
+    if (context.IsCancelled()) return outcome;
+
+    Log(LOG_INFO, "正在停止 nginx...");
+    ReadinessResult gone;
+    outcome.changed = true;
+    outcome.ok = KillAndWait(&gone);
+    outcome.latencyMicros = gone.latencyMicros;
+
+    char text[256];
+    if (outcome.ok) {
+        m_liveFingerprint = 0;
+        snprintf(text, sizeof(text), "✓ Nginx 停止成功 (退出耗时 %.1f ms)", gone.latencyMicros / 1000.0);
+        Log(LOG_SUCCESS, text);
+    } else {
+        snprintf(text, sizeof(text), "仍有 %zu 个进程未退出", gone.remaining);
+        outcome.detail = text;
+        Log(LOG_ERROR, "✗ Nginx 停止失败: " + outcome.detail);
+    }
+    return outcome;
+}
+
+ServiceOutcome NginxService::Restart(const OperationContext& context, bool hard) {
+    if (!hard && IsRunning()) return Reload(context);
+
+    ServiceOutcome outcome;
+    // 先校验再停止，避免结束正在运行的 nginx 后才发现新配置无法启动
+    NginxConfig config;
+    if (!Preflight(&config, &outcome)) {
+        Log(LOG_ERROR, "✗ 已取消重启，当前运行的 nginx 未受影响");
+        return outcome;
+    }
+    if (context.IsCancelled()) return outcome;
+
+    Log(LOG_INFO, "正在重启 nginx...");
+    ReadinessResult gone;
+    if (IsRunning()) KillAndWait(&gone);
+    // 停止阶段完成后如已被新的操作取代，则不再启动
+    if (context.IsCancelled()) return outcome;
+
+    ReadinessResult ready;
+    outcome.changed = true;
+    outcome.ok = LaunchAndWait(config, &ready);
+    outcome.latencyMicros = gone.latencyMicros + ready.latencyMicros;
+    outcome.masterPid = ready.masterPid;
+
+    char text[512];
+    if (outcome.ok) {
+        m_liveFingerprint = m_checkedFingerprint;
+        snprintf(text, sizeof(text), "✓ Nginx 重启成功 (退出耗时 %.1f ms, 就绪耗时 %.1f ms)",
+                 gone.latencyMicros / 1000.0, ready.latencyMicros / 1000.0);
+        Log(LOG_SUCCESS, text);
+        CheckAffinity(config, std::vector<ProcessId>());
+    } else {
+        outcome.detail = ready.detail;
+        snprintf(text, sizeof(text), "✗ Nginx 重启失败: %s", ready.detail.c_str());
+        Log(LOG_ERROR, text);
+    }
+    return outcome;
+}
+
+ServiceOutcome NginxService::Recover(const OperationContext& context) {
+    // master 被强制结束时 worker 不会随之退出，仍占用监听端口，新 master 会绑定失败。
+    // 失去父进程的 worker 在进程表中各自被当作一个 master，因此逐个结束直到不再有本实例的进程
+    size_t leftovers = 0;
+    while (IsRunning() && leftovers < kMaxLeftovers) {
+        if (context.IsCancelled()) return ServiceOutcome();
+        ReadinessResult gone;
+        KillAndWait(&gone);
+        ++leftovers;
+    }
+    if (leftovers > 0) {
+        char text[128];
+        snprintf(text, sizeof(text), "已清理崩溃遗留的 nginx 进程 (%zu 组)", leftovers);
+        Log(LOG_WARNING, text);
+    }
+    return Start(context);
+}
+
+ServiceOutcome NginxService::Reload(const OperationContext& context) {
+    ServiceOutcome outcome;
+    NginxConfig config;
+    if (!Preflight(&config, &outcome)) {
+        Log(LOG_ERROR, "✗ 已取消重新加载");
+        return outcome;
+    }
+    if (context.IsCancelled()) return outcome;
+
+    m_table.Refresh();
+    ProcessId masterPid = m_table.MasterPid();
+    if (masterPid == 0) {
+        outcome.detail = "nginx 未运行";
+        Log(LOG_ERROR, "✗ 无法重新加载: nginx 未运行");
+        return outcome;
+    }
+    std::vector<ProcessId> oldWorkers = m_table.WorkerPids();
+
+    uint64_t begin = MonotonicMicros();
+    std::string error;
+    if (!SignalNginx(m_prefix, masterPid, NGINX_SIGNAL_RELOAD, &error)) {
+        outcome.detail = error;
+        Log(LOG_ERROR, "✗ 发送重新加载信号失败: " + error);
+        return outcome;
+    }
+
+    ReadinessResult reload = WaitForWorkerGeneration(m_table, masterPid, oldWorkers,
+                                                      ConfigHintsFrom(config).workerProcesses, begin, 10000);
+    outcome.changed = true;
+    outcome.ok = reload.ready;
+    outcome.latencyMicros = reload.latencyMicros;
+
+    char text[512];
+    if (reload.ready) {
+        m_liveFingerprint = m_checkedFingerprint;
+        snprintf(text, sizeof(text), "✓ 配置已重新加载 (耗时 %.1f ms, 新 worker %zu 个, 旧 worker 仍在退出 %zu 个)",
+                 reload.latencyMicros / 1000.0, reload.newWorkers, reload.remaining);
+        Log(LOG_SUCCESS, text);
+        outcome.detail = CheckAffinity(config, oldWorkers);
+    } else {
+        outcome.detail = reload.detail;
+        snprintf(text, sizeof(text), "✗ 重新加载未完成: %s", reload.detail.c_str());
+        Log(LOG_ERROR, text);
+    }
+    return outcome;
+}
+
+ServiceOutcome NginxService::ApplyConfigChange(const OperationContext& context) {
+    ServiceOutcome outcome;
+    if (!IsRunning()) {
+        NginxConfig config;
+        outcome.ok = Preflight(&config, &outcome);
+        if (outcome.ok) {
+            outcome.detail = "nginx 未运行，启动后生效";
+            Log(LOG_SUCCESS, "✓ 配置校验通过 (nginx 未运行，启动后生效)");
+        }
+        return outcome;
+    }
+    if (m_liveFingerprint != 0) {
+        NginxConfig config;
+        std::string error;
+        if (config.Load(ConfPath(), &error) &&
+            ConfigFingerprint(config, NginxBinaryPath(m_prefix)) == m_liveFingerprint) {
+            outcome.ok = true;
+            outcome.detail = "与运行中的配置相同";
+            Log(LOG_DETAIL, "配置内容与运行中的 nginx 已加载的相同，无需重新加载");
+            return outcome;
+        }
+    }
+    return Reload(context);
+}
+
+bool NginxService::ReopenLogs(std::string* error) const {
+    ProcessTable table;
+    table.SetPrefix(m_prefix);
+    if (!table.Refresh()) {
+        // 找不到 master 而 pid 文件仍在时 nginx 可能仍在写日志（例如前缀未能识别），
+        // 报告失败让轮转把文件改回原名；pid 文件也不存在才说明确实未运行
+        std::string pidFile = PidFile();
+        uint64_t size = 0;
+        if (!StatFile(pidFile, &size)) return true;
+        if (error) *error = "未找到 master 进程 (pid 文件 " + pidFile + " 仍存在)";
+        return false;
+    }
+    return SignalNginx(m_prefix, table.MasterPid(), NGINX_SIGNAL_REOPEN, error);
+}
+
+ServiceOutcome NginxService::ApplyCpuAffinity(const OperationContext& context, const AffinityPlan& plan) {
+    ServiceOutcome outcome;
+    if (plan.cpus.empty()) {
+        outcome.detail = "没有可用于绑定的 CPU";
+        return outcome;
+    }
+
+    std::vector<DirectiveEdit> edits;
+    edits.push_back({"worker_processes", plan.workerProcesses});
+    edits.push_back({"worker_cpu_affinity", plan.cpuAffinity});
+    ConfBackup backup;
+    std::string error;
+    if (!SetMainDirectives(ConfPath(), edits, &backup, &error)) {
+        outcome.detail = error;
+        Log(LOG_ERROR, "✗ 无法写入 CPU 绑定计划: " + error);
+        return outcome;
+    }
+    Log(LOG_INFO, "已写入 worker_processes " + plan.workerProcesses + " 与 worker_cpu_affinity (CPU " +
+                      FormatCpuList(plan.cpus) + ")");
+
+    NginxConfig config;
+    if (!Preflight(&config, &outcome)) {
+        std::string restoreError;
+        if (RestoreConf(backup, &restoreError)) {
+            Log(LOG_WARNING, "已恢复原配置");
+        } else {
+            Log(LOG_ERROR, "✗ 恢复原配置失败: " + restoreError);
+        }
+        return outcome;
+    }
+    config.Clear();
+    if (context.IsCancelled()) return outcome;
+
+    if (!IsRunning()) {
+        outcome.ok = true;
+        outcome.changed = !backup.files.empty();
+        outcome.detail = "已写入配置，启动后生效";
+        return outcome;
+    }
+    outcome = Reload(context);
+    return outcome;
+}
+
+std::string NginxService::VerifyAffinity() {
+    NginxConfig config;
+    std::string error;
+    if (!IsRunning() || !config.Load(ConfPath(), &error)) return std::string();
+    return CheckAffinity(config, std::vector<ProcessId>());
+}
+
+std::string NginxService::CheckAffinity(const NginxConfig& config, const std::vector<ProcessId>& oldWorkers) {
+    AffinityCheck check = VerifyWorkerAffinity(config, &m_table, oldWorkers, kAffinityWaitMs);
+    if (!check.configured) return std::string();
+
+    char text[256];
+    if (check.ok) {
+        snprintf(text, sizeof(text), "worker CPU 绑定与配置一致 (%u 个)", check.matched);
+        Log(LOG_SUCCESS, std::string("✓ ") + text);
+        return text;
+    }
+    snprintf(text, sizeof(text), "worker CPU 绑定与配置不一致 (%u / %u 个一致)", check.matched,
+             check.expectedWorkers);
+    std::string summary = text;
+    for (size_t i = 0; i < check.problems.size() && i < 4; ++i) summary += (i == 0 ? ": " : "; ") + check.problems[i];
+    if (check.problems.size() > 4) summary += "; 另有 " + std::to_string(check.problems.size() - 4) + " 处";
+    Log(LOG_WARNING, "✗ " + summary);
+#ifdef _WIN32
+    if (check.matched == 0) Log(LOG_DETAIL, "Windows 版 nginx 不支持 worker_cpu_affinity，该指令只在 Linux / FreeBSD 上生效");
+#endif
+    return summary;
+}
@@ -0,0 +1,91 @@
+// nginx-manager/src/nginx_service.h
+// nginx 服务控制 - 与界面无关的启动 / 停止 / 重启 / 重载流程，图形界面与无界面模式共用
+
+#ifndef NGINX_SERVICE_H
+#define NGINX_SERVICE_H
+
+#include "config_cache.h"
+#include "cpu_topology.h"
+#include "log_model.h"
+#include "op_queue.h"
+#include "process_table.h"
+#include "readiness.h"
+#include <functional>
+#include <string>
+
+// 一次服务操作的结果
+struct ServiceOutcome {
+    bool ok = false;
+    bool changed = false;            // 实际执行了操作（已在运行时启动、未运行时停止均不算）
+    bool configRejected = false;     // nginx -t 未通过，操作未执行
+    uint64_t latencyMicros = 0;      // 就绪 / 退出 / 新 worker 接管的耗时
+    ProcessId masterPid = 0;         // 启动 / 重启后（或已在运行时）的 master，供崩溃监护使用
+    std::string detail;              // 失败原因或 nginx -t 输出
+};
+
+// 单个 nginx 实例的服务控制
+// 流程与图形界面一致：启动 / 重启前先校验配置（内容未变时沿用缓存结论），
+// 启动后等待就绪，停止只结束本实例的进程，重载确认新一代 worker 已接管。
+// 不是线程安全的，应始终在同一个工作线程（操作队列）中调用。
+class NginxService {
+public:
+    typedef std::function<void(LogSeverity severity, const std::string& text)> LogSink;
+
+    explicit NginxService(const std::string& prefix);
+
+    NginxService(const NginxService&) = delete;
+    NginxService& operator=(const NginxService&) = delete;
+
+    // 进度与结果日志（UTF-8），未设置时不输出
+    void SetLogSink(LogSink sink) { m_log = sink; }
+
+    const std::string& Prefix() const { return m_prefix; }
+    // 切换到另一个 nginx 安装目录（图形界面中修改路径后），路径未变时不做任何事
+    void SetPrefix(const std::string& prefix);
+    // prefix 下的文件路径，relative 使用 '/' 分隔，Windows 上转换为 '\'
+    std::string PrefixPath(const std::string& relative) const;
+    std::string ConfPath() const { return PrefixPath("conf/nginx.conf"); }
+    // 当前配置的 pid 文件（pid 指令，未配置或配置无法读取时为 logs/nginx.pid），交给崩溃监护区分正常退出
+    std::string PidFile() const;
+
+    bool IsRunning();
+    // 正在运行的 master，未运行时为 0
+    ProcessId MasterPid() { return IsRunning() ? m_table.MasterPid() : 0; }
+    ServiceOutcome Start(const OperationContext& context);
+    ServiceOutcome Stop(const OperationContext& context);
+    // hard 为 false 且正在运行时等同于 Reload
+    ServiceOutcome Restart(const OperationContext& context, bool hard);
+    ServiceOutcome Reload(const OperationContext& context);
+    // 配置文件被修改后调用（配置监视）：内容与运行中的 nginx 加载的相同（如本程序写入配置后已经重新加载）时
+    // 什么也不做；未运行时只校验；否则与 Reload 相同，校验通过后优雅地重新加载
+    ServiceOutcome ApplyConfigChange(const OperationContext& context);
+    // 崩溃监护的自动恢复：先清理崩溃的 master 遗留的 worker，再按启动流程拉起
+    ServiceOutcome Recover(const OperationContext& context);
+    // 把 CPU 绑定计划写入配置（main 上下文的 worker_processes / worker_cpu_affinity），
+    // nginx -t 不通过时恢复原配置；正在运行时重新加载并校验 worker 的实际绑定
+    ServiceOutcome ApplyCpuAffinity(const OperationContext& context, const AffinityPlan& plan);
+    // 核对运行中 worker 的实际 CPU 绑定并记录结果，返回一行摘要（未配置 worker_cpu_affinity 时为空）
+    std::string VerifyAffinity();
+    // 通知 master 重新打开日志（日志轮转使用）；找不到 master 时只有 pid 文件也不存在才视为未运行并返回 true，
+    // 否则返回 false 让轮转撤销改名；
+    // 使用独立的进程表，可在任意线程调用
+    bool ReopenLogs(std::string* error) const;
+
+private:
+    bool Preflight(NginxConfig* config, ServiceOutcome* outcome);
+    std::string PidFilePath(const NginxConfig& config) const;
+    bool LaunchAndWait(const NginxConfig& config, ReadinessResult* result);
+    bool KillAndWait(ReadinessResult* result);
+    // 配置了 worker_cpu_affinity 时校验 worker 的实际绑定并记录结果，返回一行摘要（未配置时为空）
+    std::string CheckAffinity(const NginxConfig& config, const std::vector<ProcessId>& oldWorkers);
+    void Log(LogSeverity severity, const std::string& text);
+
+    std::string m_prefix;
+    ProcessTable m_table;
+    ValidationCache m_validationCache;
+    uint64_t m_checkedFingerprint = 0;   // 最近一次校验通过的配置指纹
+    uint64_t m_liveFingerprint = 0;      // 运行中的 nginx 加载的配置指纹，由本对象启动 / 重新加载后记录，未知时为 0
+    LogSink m_log;
+};
+
+#endif // NGINX_SERVICE_H
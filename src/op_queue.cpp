@@ -0,0 +1,166 @@
+// nginx-manager/src/op_queue.cpp
+// 后台操作队列 - 在独立工作线程中串行执行服务操作，与界面无关
+
+#include "op_queue.h"
+#include "platform.h"
+#include "trace.h"
+
+#include <vector>
+
+OperationQueue::OperationQueue(CompletionHandler onComplete)
+    : m_onComplete(onComplete) {
+}
+
+OperationQueue::~OperationQueue() {
+    Stop();
+}
+
+void OperationQueue::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_worker.joinable()) return;
+    m_stopping = false;
+    m_worker = std::thread(&OperationQueue::WorkerLoop, this);
+}
+
+void OperationQueue::Stop() {
+    std::deque<Pending> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        dropped.swap(m_pending);
+        if (m_runningCancelled) m_runningCancelled->store(true);
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+
+    for (Pending& op : dropped) {
+        OperationResult result;
+        result.id = op.id;
+        result.kind = op.kind;
+        result.cancelled = true;
+        if (m_onComplete) m_onComplete(result);
+    }
+}
+
+uint64_t OperationQueue::Submit(int kind, int group, Task task) {
+    std::vector<Pending> superseded;
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // 合并：同类操作已在排队，用最新的任务替换它并沿用原 ID
+        for (Pending& op : m_pending) {
+            if (op.kind == kind) {
+                op.task = task;
+                return op.id;
+            }
+        }
+
+        // 取代：同组的旧操作不再有意义
+        if (group != 0) {
+            for (auto it = m_pending.begin(); it != m_pending.end();) {
+                if (it->group == group) {
+                    it->cancelled->store(true);
+                    superseded.push_back(std::move(*it));
+                    it = m_pending.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (m_running && m_runningGroup == group && m_runningCancelled) {
+                m_runningCancelled->store(true);
+            }
+        }
+
+        Pending op;
+        op.id = id = m_nextId++;
+        op.kind = kind;
+        op.group = group;
+        op.task = task;
+        op.submitMicros = MonotonicMicros();
+        op.cancelled = std::make_shared<std::atomic<bool>>(false);
+        m_pending.push_back(std::move(op));
+    }
+    m_wake.notify_one();
+
+    for (Pending& op : superseded) {
+        OperationResult result;
+        result.id = op.id;
+        result.kind = op.kind;
+        result.cancelled = true;
+        result.queuedMicros = MonotonicMicros() - op.submitMicros;
+        if (m_onComplete) m_onComplete(result);
+    }
+    return id;
+}
+
+void OperationQueue::Execute(Pending& op) {
+    OperationResult result;
+    result.id = op.id;
+    result.kind = op.kind;
+
+    uint64_t begin = MonotonicMicros();
+    result.queuedMicros = begin - op.submitMicros;
+
+    const char* name = m_kindNames ? m_kindNames(op.kind) : "operation";
+    if (TraceEnabled()) TraceRecord(TRACE_QUEUE, name, op.submitMicros, begin, op.kind);
+    {
+        TraceSpan span(TRACE_OPERATION, name, op.kind);
+        OperationContext context(op.id, op.kind, op.cancelled);
+        if (op.task) op.task(context);
+    }
+
+    result.runMicros = MonotonicMicros() - begin;
+    result.cancelled = op.cancelled->load();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+        m_runningGroup = 0;
+        m_runningCancelled.reset();
+    }
+    if (m_onComplete) m_onComplete(result);
+}
+
+bool OperationQueue::RunOne() {
+    Pending op;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.empty()) return false;
+        op = std::move(m_pending.front());
+        m_pending.pop_front();
+        m_running = true;
+        m_runningGroup = op.group;
+        m_runningCancelled = op.cancelled;
+    }
+    Execute(op);
+    return true;
+}
+
+void OperationQueue::WorkerLoop() {
+    TraceSetThreadName("op-queue");
+    for (;;) {
+        Pending op;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+            if (m_stopping) return;
+            op = std::move(m_pending.front());
+            m_pending.pop_front();
+            m_running = true;
+            m_runningGroup = op.group;
+            m_runningCancelled = op.cancelled;
+        }
+        Execute(op);
+    }
+}
+
+size_t OperationQueue::PendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pending.size();
+}
+
+bool OperationQueue::IsBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running || !m_pending.empty();
+}
@@ -0,0 +1,101 @@
+// nginx-manager/src/op_queue.h
+// 后台操作队列 - 在独立工作线程中串行执行服务操作，与界面无关
+
+#ifndef OP_QUEUE_H
+#define OP_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// 正在执行的操作通过上下文检查自己是否已被后续操作取代
+class OperationContext {
+public:
+    OperationContext(uint64_t id, int kind, std::shared_ptr<std::atomic<bool>> cancelled)
+        : m_id(id), m_kind(kind), m_cancelled(cancelled) {}
+
+    uint64_t Id() const { return m_id; }
+    int Kind() const { return m_kind; }
+    bool IsCancelled() const { return m_cancelled->load(std::memory_order_relaxed); }
+
+private:
+    uint64_t m_id;
+    int m_kind;
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+// 操作完成（或被取消）后的结果
+struct OperationResult {
+    uint64_t id = 0;
+    int kind = 0;
+    bool cancelled = false;          // 被后续操作取代，可能未执行或只执行了一部分
+    uint64_t queuedMicros = 0;       // 排队等待耗时
+    uint64_t runMicros = 0;          // 执行耗时
+};
+
+// 操作队列
+// - 同类 (kind 相同) 且尚未开始的操作会被合并，连续点击五次刷新只执行一次
+// - 同组 (group 非 0 且相同) 的新操作会取消排队中的旧操作，并通知正在执行的旧操作中止
+// - 完成回调在工作线程中调用，由调用方负责把结果转交界面线程
+class OperationQueue {
+public:
+    typedef std::function<void(OperationContext&)> Task;
+    typedef std::function<void(const OperationResult&)> CompletionHandler;
+    typedef const char* (*KindNameFunction)(int kind);
+
+    explicit OperationQueue(CompletionHandler onComplete);
+    ~OperationQueue();
+
+    OperationQueue(const OperationQueue&) = delete;
+    OperationQueue& operator=(const OperationQueue&) = delete;
+
+    // 操作 kind 的名称（返回静态字符串），用作追踪区间的标签；在 Start 之前调用
+    void SetKindNames(KindNameFunction names) { m_kindNames = names; }
+
+    // 启动 / 停止工作线程；Stop 会取消所有排队中的操作并等待当前操作结束
+    void Start();
+    void Stop();
+
+    // 提交操作，返回操作 ID（被合并时返回已排队操作的 ID）
+    uint64_t Submit(int kind, int group, Task task);
+
+    // 在调用线程中执行下一个排队的操作，队列为空时返回 false（不需要工作线程）
+    bool RunOne();
+
+    size_t PendingCount() const;
+    bool IsBusy() const;
+
+private:
+    struct Pending {
+        uint64_t id;
+        int kind;
+        int group;
+        Task task;
+        uint64_t submitMicros;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    void WorkerLoop();
+    void Execute(Pending& op);
+
+    CompletionHandler m_onComplete;
+    KindNameFunction m_kindNames = nullptr;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Pending> m_pending;
+    std::thread m_worker;
+    bool m_stopping = false;
+    uint64_t m_nextId = 1;
+
+    // 正在执行的操作
+    bool m_running = false;
+    int m_runningGroup = 0;
+    std::shared_ptr<std::atomic<bool>> m_runningCancelled;
+};
+
+#endif // OP_QUEUE_H
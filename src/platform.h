@@ -0,0 +1,51 @@
+// nginx-manager/src/platform.h
+// 平台公共定义 - Windows / Linux 共用的类型与辅助函数
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef UNICODE
+#define UNICODE
+#endif
+#ifndef _UNICODE
+#define _UNICODE
+#endif
+#include <windows.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+typedef uint32_t ProcessId;
+
+// 单调时钟（微秒），用于测量各类操作耗时
+inline uint64_t MonotonicMicros() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef _WIN32
+// UTF-8 与 UTF-16 互转，核心模块内部统一使用 UTF-8 路径
+inline std::wstring Utf8ToWide(const std::string& str) {
+    if (str.empty()) return std::wstring();
+    int size = MultiByteToWideChar(CP_UTF8, 0, str.data(), (int)str.size(), NULL, 0);
+    std::wstring out(size, 0);
+    MultiByteToWideChar(CP_UTF8, 0, str.data(), (int)str.size(), &out[0], size);
+    return out;
+}
+
+inline std::string WideToUtf8(const std::wstring& wstr) {
+    if (wstr.empty()) return std::string();
+    int size = WideCharToMultiByte(CP_UTF8, 0, wstr.data(), (int)wstr.size(), NULL, 0, NULL, NULL);
+    std::string out(size, 0);
+    WideCharToMultiByte(CP_UTF8, 0, wstr.data(), (int)wstr.size(), &out[0], size, NULL, NULL);
+    return out;
+}
+#endif
+
+#endif // PLATFORM_H
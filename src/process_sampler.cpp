@@ -0,0 +1,497 @@
+// nginx-manager/src/process_sampler.cpp
+// 进程资源采样 - master 与各 worker 的 CPU、内存、句柄数与上下文切换速率，描述符 / 句柄常驻，采样不分配内存
+
+#include "process_sampler.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#ifdef _WIN32
+#ifndef PSAPI_VERSION
+#define PSAPI_VERSION 2              // GetProcessMemoryInfo 直接使用 kernel32 中的 K32 版本，无需链接 psapi
+#endif
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// 进程集合的兜底重新扫描间隔（有进程退出或调用 Rescan 时会立即扫描）
+static const uint64_t kRescanMicros = 10000000;
+// 未运行时查找 master 的间隔
+static const uint64_t kIdleRescanMicros = 2000000;
+
+#ifdef _WIN32
+// NtQuerySystemInformation(SystemProcessInformation) 的输出布局，只用到线程的上下文切换计数。
+// 这是未公开的结构，按 ntdll 的实际布局定义，32 / 64 位由各字段的自然对齐区分
+namespace {
+
+const ULONG kSystemProcessInformation = 5;
+const LONG kStatusInfoLengthMismatch = (LONG)0xC0000004;
+
+typedef LONG (WINAPI* NtQuerySystemInformationFn)(ULONG, PVOID, ULONG, PULONG);
+
+struct SystemThreadInfo {
+    LARGE_INTEGER kernelTime;
+    LARGE_INTEGER userTime;
+    LARGE_INTEGER createTime;
+    ULONG waitTime;
+    PVOID startAddress;
+    HANDLE uniqueProcess;
+    HANDLE uniqueThread;
+    LONG priority;
+    LONG basePriority;
+    ULONG contextSwitches;
+    ULONG threadState;
+    ULONG waitReason;
+};
+
+struct SystemProcessInfo {
+    ULONG nextEntryOffset;
+    ULONG numberOfThreads;
+    LARGE_INTEGER workingSetPrivateSize;
+    ULONG hardFaultCount;
+    ULONG numberOfThreadsHighWatermark;
+    ULONGLONG cycleTime;
+    LARGE_INTEGER createTime;
+    LARGE_INTEGER userTime;
+    LARGE_INTEGER kernelTime;
+    USHORT imageNameLength;
+    USHORT imageNameMaximumLength;
+    PWSTR imageNameBuffer;
+    LONG basePriority;
+    HANDLE uniqueProcessId;
+    HANDLE inheritedFromUniqueProcessId;
+    ULONG handleCount;
+    ULONG sessionId;
+    ULONG_PTR uniqueProcessKey;
+    SIZE_T peakVirtualSize;
+    SIZE_T virtualSize;
+    ULONG pageFaultCount;
+    SIZE_T peakWorkingSetSize;
+    SIZE_T workingSetSize;
+    SIZE_T quotaPeakPagedPoolUsage;
+    SIZE_T quotaPagedPoolUsage;
+    SIZE_T quotaPeakNonPagedPoolUsage;
+    SIZE_T quotaNonPagedPoolUsage;
+    SIZE_T pagefileUsage;
+    SIZE_T peakPagefileUsage;
+    SIZE_T privatePageCount;
+    LARGE_INTEGER readOperationCount;
+    LARGE_INTEGER writeOperationCount;
+    LARGE_INTEGER otherOperationCount;
+    LARGE_INTEGER readTransferCount;
+    LARGE_INTEGER writeTransferCount;
+    LARGE_INTEGER otherTransferCount;
+    // 紧接着是 numberOfThreads 个 SystemThreadInfo
+};
+
+uint64_t FileTimeValue(const FILETIME& time) {
+    return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime;
+}
+
+} // namespace
+#else
+namespace {
+
+// 读取描述符的全部内容（从偏移 0 开始），末尾补 0；进程已退出时返回 -1。
+// /proc 文件一次 pread 即可读完，读到的比请求的少就说明到了末尾，不再多调用一次
+ssize_t ReadAt(int fd, char* buffer, size_t size) {
+    ssize_t total = 0;
+    while ((size_t)total < size - 1) {
+        size_t wanted = size - 1 - total;
+        ssize_t got = pread(fd, buffer + total, wanted, total);
+        if (got < 0) return -1;
+        total += got;
+        if ((size_t)got < wanted) break;
+    }
+    buffer[total] = '\0';
+    return total;
+}
+
+// 在 /proc/<pid>/status 中查找 "\n<key>:" 后的数值
+bool FindStatusValue(const char* text, const char* key, uint64_t* value) {
+    const char* found = strstr(text, key);
+    if (!found) return false;
+    *value = strtoull(found + strlen(key), nullptr, 10);
+    return true;
+}
+
+} // namespace
+#endif
+
+ProcessSampler::ProcessSampler() {
+#ifdef _WIN32
+    HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+    if (ntdll) m_queryFn = (void*)GetProcAddress(ntdll, "NtQuerySystemInformation");
+#else
+    m_ticksPerSecond = sysconf(_SC_CLK_TCK);
+    if (m_ticksPerSecond <= 0) m_ticksPerSecond = 100;
+    m_pageSize = sysconf(_SC_PAGESIZE);
+    if (m_pageSize <= 0) m_pageSize = 4096;
+#endif
+}
+
+ProcessSampler::~ProcessSampler() {
+    Stop();
+    for (Slot& slot : m_slots) CloseSlot(&slot);
+}
+
+void ProcessSampler::Start(const std::string& prefix) {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (m_worker.joinable() && prefix == m_prefix) return;
+    }
+    Stop();
+
+    {
+        std::lock_guard<std::mutex> lock(m_dataMutex);
+        m_snapshot = ProcessUsageSnapshot();
+    }
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    m_stopping = false;
+    m_rescan = false;
+    m_prefix = prefix;
+    m_worker = std::thread(&ProcessSampler::Run, this, prefix);
+}
+
+void ProcessSampler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+void ProcessSampler::Rescan() {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_rescan = true;
+    }
+    m_wake.notify_all();
+}
+
+void ProcessSampler::Snapshot(ProcessUsageSnapshot* snapshot) const {
+    std::lock_guard<std::mutex> lock(m_dataMutex);
+    snapshot->running = m_snapshot.running;
+    snapshot->ready = m_snapshot.ready;
+    snapshot->samples = m_snapshot.samples;
+    snapshot->sampleMicros = m_snapshot.sampleMicros;
+    snapshot->total = m_snapshot.total;
+    snapshot->processes.assign(m_snapshot.processes.begin(), m_snapshot.processes.end());
+}
+
+void ProcessSampler::SetProcesses(ProcessId masterPid, const std::vector<ProcessId>& workerPids) {
+    auto wanted = [&](ProcessId pid) {
+        return pid == masterPid || std::find(workerPids.begin(), workerPids.end(), pid) != workerPids.end();
+    };
+
+    // 关闭已不在集合中的进程，其余原地保留（描述符与上一次的计数都不变）
+    size_t kept = 0;
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        if (m_slots[i].alive && m_slots[i].pid != 0 && wanted(m_slots[i].pid)) {
+            if (kept != i) {
+                m_slots[kept] = m_slots[i];
+                m_slots[i] = Slot();
+            }
+            ++kept;
+        } else {
+            CloseSlot(&m_slots[i]);
+        }
+    }
+    m_slots.resize(kept);
+
+    auto add = [&](ProcessId pid, bool master) {
+        if (pid == 0) return;
+        for (Slot& slot : m_slots) {
+            if (slot.pid == pid) {
+                slot.master = master;
+                slot.usage.master = master;
+                return;
+            }
+        }
+        m_slots.push_back(Slot());
+        Slot& slot = m_slots.back();
+        slot.pid = pid;
+        slot.master = master;
+        slot.usage.pid = pid;
+        slot.usage.master = master;
+        OpenSlot(&slot);
+    };
+    add(masterPid, true);
+    for (ProcessId pid : workerPids) add(pid, false);
+
+    std::stable_partition(m_slots.begin(), m_slots.end(), [](const Slot& slot) { return slot.master; });
+}
+
+void ProcessSampler::OpenSlot(Slot* slot) {
+#ifdef _WIN32
+    // Windows 7 上 GetProcessMemoryInfo 还需要 PROCESS_VM_READ；打不开时退化为只取 CPU 时间
+    slot->process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ | SYNCHRONIZE, FALSE, slot->pid);
+    if (!slot->process) {
+        slot->process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | SYNCHRONIZE, FALSE, slot->pid);
+    }
+    slot->alive = slot->process != NULL;
+#else
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/stat", slot->pid);
+    slot->statFd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "/proc/%u/statm", slot->pid);
+    slot->statmFd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "/proc/%u/status", slot->pid);
+    slot->statusFd = open(path, O_RDONLY | O_CLOEXEC);
+    // worker 通常以其他用户运行，非 root 时打不开它的 fd 目录
+    snprintf(path, sizeof(path), "/proc/%u/fd", slot->pid);
+    slot->fdDirFd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    slot->alive = slot->statFd >= 0;
+#endif
+}
+
+void ProcessSampler::CloseSlot(Slot* slot) {
+#ifdef _WIN32
+    if (slot->process) CloseHandle(slot->process);
+    slot->process = NULL;
+#else
+    int* fds[] = { &slot->statFd, &slot->statmFd, &slot->statusFd, &slot->fdDirFd };
+    for (int* fd : fds) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+#endif
+}
+
+bool ProcessSampler::SampleOnce() {
+    uint64_t now = MonotonicMicros();
+#ifdef _WIN32
+    SampleContextSwitches();
+#endif
+    bool exited = false;
+    for (Slot& slot : m_slots) {
+        if (!slot.alive || !SampleSlot(&slot, now)) exited = true;
+    }
+    uint64_t cost = MonotonicMicros() - now;
+    bool running = !m_slots.empty() && m_slots.front().master && m_slots.front().alive;
+    std::lock_guard<std::mutex> lock(m_dataMutex);
+    PublishLocked(running, cost);
+    return exited;
+}
+
+// 采样一个进程，进程已退出时返回 false。速率以上一次采样为基准，第一次只记录计数
+bool ProcessSampler::SampleSlot(Slot* slot, uint64_t now) {
+    ProcessUsage& usage = slot->usage;
+    double elapsed = slot->primed ? (now - slot->sampledMicros) / 1000000.0 : 0;
+    uint64_t cpuTime = 0;
+    double cpuUnitsPerSecond = 0;
+
+#ifdef _WIN32
+    if (WaitForSingleObject(slot->process, 0) == WAIT_OBJECT_0) {
+        slot->alive = false;
+        return false;
+    }
+    FILETIME created, exitedAt, kernel, user;
+    if (!GetProcessTimes(slot->process, &created, &exitedAt, &kernel, &user)) return true;
+    cpuTime = FileTimeValue(kernel) + FileTimeValue(user);
+    cpuUnitsPerSecond = 10000000.0;
+    FILETIME current;
+    GetSystemTimeAsFileTime(&current);
+    if (FileTimeValue(current) > FileTimeValue(created)) {
+        usage.uptimeSeconds = (FileTimeValue(current) - FileTimeValue(created)) / 10000000;
+    }
+
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(slot->process, &memory, sizeof(memory))) usage.rssBytes = memory.WorkingSetSize;
+    DWORD handles = 0;
+    usage.handlesKnown = GetProcessHandleCount(slot->process, &handles) != FALSE;
+    usage.handles = handles;
+#else
+    char buffer[8192];
+    if (ReadAt(slot->statFd, buffer, sizeof(buffer)) <= 0) {
+        slot->alive = false;
+        return false;
+    }
+    // comm 可能含空格和括号，从最后一个 ')' 之后按空格数字段：其后第一个是第 3 字段 state，utime / stime 为第 14 / 15 字段
+    const char* field = strrchr(buffer, ')');
+    if (!field) return true;
+    ++field;
+    for (int index = 3; index < 14 && field; ++index) {
+        field = strchr(field + 1, ' ');
+    }
+    if (!field) return true;
+    char* end = nullptr;
+    uint64_t utime = strtoull(field + 1, &end, 10);
+    uint64_t stime = strtoull(end, nullptr, 10);
+    cpuTime = utime + stime;
+    cpuUnitsPerSecond = (double)m_ticksPerSecond;
+
+    // 第 22 字段 starttime 为开机后的时钟滴答数，与 CLOCK_BOOTTIME 相减即运行时长
+    const char* started = end;
+    for (int index = 16; index < 22 && started; ++index) {
+        started = strchr(started + 1, ' ');
+    }
+    timespec boot;
+    if (started && clock_gettime(CLOCK_BOOTTIME, &boot) == 0) {
+        uint64_t startSeconds = strtoull(started + 1, nullptr, 10) / (uint64_t)m_ticksPerSecond;
+        if ((uint64_t)boot.tv_sec > startSeconds) usage.uptimeSeconds = (uint64_t)boot.tv_sec - startSeconds;
+    }
+
+    if (slot->statmFd >= 0 && ReadAt(slot->statmFd, buffer, sizeof(buffer)) > 0) {
+        const char* resident = strchr(buffer, ' ');
+        if (resident) usage.rssBytes = strtoull(resident + 1, nullptr, 10) * (uint64_t)m_pageSize;
+    }
+
+    uint64_t voluntary = 0;
+    uint64_t involuntary = 0;
+    if (slot->statusFd >= 0 && ReadAt(slot->statusFd, buffer, sizeof(buffer)) > 0 &&
+        FindStatusValue(buffer, "\nvoluntary_ctxt_switches:", &voluntary) &&
+        FindStatusValue(buffer, "\nnonvoluntary_ctxt_switches:", &involuntary)) {
+        if (slot->primed && usage.switchesKnown && elapsed > 0) {
+            usage.switchesPerSec = (double)(voluntary + involuntary - slot->switches) / elapsed;
+            usage.involuntaryPerSec = (double)(involuntary - slot->involuntary) / elapsed;
+        }
+        usage.switchesKnown = true;
+        slot->switches = voluntary + involuntary;
+        slot->involuntary = involuntary;
+    }
+
+    if (slot->fdDirFd >= 0 && lseek(slot->fdDirFd, 0, SEEK_SET) == 0) {
+        uint32_t count = 0;
+        long got;
+        while ((got = syscall(SYS_getdents64, slot->fdDirFd, buffer, sizeof(buffer))) > 0) {
+            for (long offset = 0; offset < got;) {
+                const dirent64* entry = (const dirent64*)(buffer + offset);
+                if (entry->d_name[0] != '.') ++count;
+                offset += entry->d_reclen;
+            }
+        }
+        usage.handlesKnown = got == 0;
+        usage.handles = count;
+    }
+#endif
+
+    if (slot->primed && elapsed > 0 && cpuTime >= slot->cpuTime) {
+        usage.cpuPercent = (double)(cpuTime - slot->cpuTime) / cpuUnitsPerSecond / elapsed * 100.0;
+        slot->rated = true;
+    }
+    slot->cpuTime = cpuTime;
+    slot->sampledMicros = now;
+    slot->primed = true;
+    return true;
+}
+
+#ifdef _WIN32
+// 上下文切换计数只能从系统进程信息中按线程累加：一次调用取得全部进程，按 PID 对应到各个采样槽
+void ProcessSampler::SampleContextSwitches() {
+    if (!m_queryFn || m_slots.empty()) return;
+    NtQuerySystemInformationFn query = (NtQuerySystemInformationFn)m_queryFn;
+
+    if (m_systemInfo.empty()) m_systemInfo.resize(256 * 1024);
+    LONG status = 0;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        ULONG needed = 0;
+        status = query(kSystemProcessInformation, m_systemInfo.data(), (ULONG)m_systemInfo.size(), &needed);
+        if (status != kStatusInfoLengthMismatch) break;
+        // 进程数增长时才扩大，留出余量避免下一次又不够
+        m_systemInfo.resize(std::max<size_t>(needed, m_systemInfo.size()) + 64 * 1024);
+    }
+    if (status < 0) return;
+
+    uint64_t now = MonotonicMicros();
+    size_t matched = 0;
+    const uint8_t* cursor = m_systemInfo.data();
+    for (;;) {
+        const SystemProcessInfo* process = (const SystemProcessInfo*)cursor;
+        ProcessId pid = (ProcessId)(ULONG_PTR)process->uniqueProcessId;
+        for (Slot& slot : m_slots) {
+            if (slot.pid != pid) continue;
+            const SystemThreadInfo* threads = (const SystemThreadInfo*)(process + 1);
+            uint64_t switches = 0;
+            for (ULONG i = 0; i < process->numberOfThreads; ++i) switches += threads[i].contextSwitches;
+
+            double elapsed = slot.primed ? (now - slot.sampledMicros) / 1000000.0 : 0;
+            if (slot.primed && slot.usage.switchesKnown && elapsed > 0 && switches >= slot.switches) {
+                slot.usage.switchesPerSec = (double)(switches - slot.switches) / elapsed;
+            }
+            slot.usage.switchesKnown = true;
+            slot.switches = switches;
+            ++matched;
+            break;
+        }
+        if (matched == m_slots.size() || process->nextEntryOffset == 0) break;
+        cursor += process->nextEntryOffset;
+    }
+}
+#endif
+
+void ProcessSampler::PublishLocked(bool running, uint64_t sampleMicros) {
+    m_snapshot.running = running;
+    m_snapshot.sampleMicros = sampleMicros;
+    m_snapshot.samples++;
+
+    ProcessUsage total;
+    total.handlesKnown = !m_slots.empty();
+    total.switchesKnown = !m_slots.empty();
+    bool primed = !m_slots.empty();
+    size_t count = 0;
+    m_snapshot.processes.resize(m_slots.size());
+    for (const Slot& slot : m_slots) {
+        if (!slot.alive) continue;
+        const ProcessUsage& usage = slot.usage;
+        m_snapshot.processes[count++] = usage;
+        total.cpuPercent += usage.cpuPercent;
+        total.rssBytes += usage.rssBytes;
+        total.handles += usage.handles;
+        total.handlesKnown = total.handlesKnown && usage.handlesKnown;
+        total.switchesPerSec += usage.switchesPerSec;
+        total.involuntaryPerSec += usage.involuntaryPerSec;
+        total.switchesKnown = total.switchesKnown && usage.switchesKnown;
+        primed = primed && slot.rated;
+    }
+    m_snapshot.processes.resize(count);
+    m_snapshot.total = total;
+    m_snapshot.ready = running && primed;
+}
+
+void ProcessSampler::Run(std::string prefix) {
+    TraceSetThreadName("process-sampler");
+    m_table.SetPrefix(prefix);
+    bool rescan = true;
+    uint64_t nextRescan = 0;
+
+    std::unique_lock<std::mutex> control(m_controlMutex);
+    while (!m_stopping) {
+        rescan = rescan || m_rescan;
+        m_rescan = false;
+        uint32_t intervalMs = m_intervalMs;
+        control.unlock();
+
+        uint64_t now = MonotonicMicros();
+        if (rescan || now >= nextRescan) {
+            m_table.Refresh();
+            m_scratchPids.assign(m_table.WorkerPids().begin(), m_table.WorkerPids().end());
+            SetProcesses(m_table.MasterPid(), m_scratchPids);
+            nextRescan = now + (m_slots.empty() ? kIdleRescanMicros : kRescanMicros);
+            rescan = false;
+        }
+
+        // 有进程退出（worker 被重新拉起、重新加载后旧 worker 退出或 master 已停止）时下一轮重新扫描
+        rescan = SampleOnce();
+
+        control.lock();
+        m_wake.wait_for(control, std::chrono::milliseconds(intervalMs),
+                        [this]() { return m_stopping || m_rescan; });
+    }
+    control.unlock();
+
+    for (Slot& slot : m_slots) CloseSlot(&slot);
+    m_slots.clear();
+    std::lock_guard<std::mutex> lock(m_dataMutex);
+    m_snapshot.running = false;
+    m_snapshot.ready = false;
+}
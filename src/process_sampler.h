@@ -0,0 +1,121 @@
+// nginx-manager/src/process_sampler.h
+// 进程资源采样 - master 与各 worker 的 CPU、内存、句柄数与上下文切换速率，描述符 / 句柄常驻，采样不分配内存
+
+#ifndef PROCESS_SAMPLER_H
+#define PROCESS_SAMPLER_H
+
+#include "platform.h"
+#include "process_table.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 一个进程在最近一个采样周期内的资源占用
+struct ProcessUsage {
+    ProcessId pid = 0;
+    bool master = false;
+    double cpuPercent = 0;           // 以单个核心为 100%，多核并行时可超过 100
+    uint64_t rssBytes = 0;           // Linux: statm 常驻页；Windows: 工作集
+    uint32_t handles = 0;            // Windows: 句柄数；Linux: 打开的文件描述符数
+    bool handlesKnown = false;       // Linux 上无权读取其他用户进程的 /proc/<pid>/fd
+    double switchesPerSec = 0;       // 上下文切换速率（主动 + 被抢占）
+    double involuntaryPerSec = 0;    // 其中被抢占的部分，仅 Linux 区分
+    bool switchesKnown = false;
+    uint64_t uptimeSeconds = 0;      // 进程已运行的时长，取不到时为 0
+};
+
+struct ProcessUsageSnapshot {
+    bool running = false;
+    bool ready = false;              // 至少完成了两次采样，速率有效
+    uint64_t samples = 0;
+    uint64_t sampleMicros = 0;       // 最近一次采样本身的耗时
+    ProcessUsage total;              // 全部进程合计，pid 为 0
+    std::vector<ProcessUsage> processes;   // master 在前，其后为 worker
+};
+
+// 进程资源采样
+// 每个被采样的进程在加入时打开一次描述符（Linux: /proc/<pid>/stat、statm、status 与 fd 目录）
+// 或句柄（Windows），之后每次采样只做 pread / GetProcessTimes 等查询，不打开文件、不分配内存。
+// 进程集合只在有进程退出、调用 Rescan 或每 10 秒时通过进程表重新确定。
+class ProcessSampler {
+public:
+    ProcessSampler();
+    ~ProcessSampler();
+
+    ProcessSampler(const ProcessSampler&) = delete;
+    ProcessSampler& operator=(const ProcessSampler&) = delete;
+
+    // 在后台线程中采样指定前缀下的 nginx，前缀未变时为空操作
+    void Start(const std::string& prefix);
+    void Stop();
+    // 进程集合可能已变化（启动 / 重启 / 重新加载后调用），下一次采样前重新扫描进程表
+    void Rescan();
+    void SetInterval(uint32_t intervalMs) { m_intervalMs = intervalMs; }
+
+    // 复制最近一次采样结果，复用 snapshot->processes 已有的容量
+    void Snapshot(ProcessUsageSnapshot* snapshot) const;
+
+    // 以下供不启动后台线程时直接使用（基准程序），不可与 Start 同时使用
+    // 设置采样的进程集合：保留仍在集合中的进程，只为新进程打开描述符
+    void SetProcesses(ProcessId masterPid, const std::vector<ProcessId>& pids);
+    // 采样一次并发布结果，返回是否有进程已经退出
+    bool SampleOnce();
+
+private:
+    struct Slot {
+        ProcessId pid = 0;
+        bool master = false;
+        bool alive = true;
+        bool primed = false;         // 已有上一次的计数，可以计算速率
+        bool rated = false;          // 已算出过一次速率
+        uint64_t cpuTime = 0;        // 上一次的 CPU 时间（Linux: 时钟滴答；Windows: 100ns）
+        uint64_t switches = 0;
+        uint64_t involuntary = 0;
+        uint64_t sampledMicros = 0;
+        ProcessUsage usage;
+#ifdef _WIN32
+        HANDLE process = NULL;
+#else
+        int statFd = -1;
+        int statmFd = -1;
+        int statusFd = -1;
+        int fdDirFd = -1;
+#endif
+    };
+
+    void Run(std::string prefix);
+    void OpenSlot(Slot* slot);
+    void CloseSlot(Slot* slot);
+    bool SampleSlot(Slot* slot, uint64_t now);
+    void PublishLocked(bool running, uint64_t sampleMicros);
+#ifdef _WIN32
+    void SampleContextSwitches();
+#endif
+
+    // 只在采样线程中访问（或未启动线程时由调用方独占）
+    std::vector<Slot> m_slots;
+    std::vector<ProcessId> m_scratchPids;
+    ProcessTable m_table;
+#ifdef _WIN32
+    std::vector<uint8_t> m_systemInfo;   // NtQuerySystemInformation 的输出缓冲，只在不够大时扩大
+    void* m_queryFn = nullptr;
+#else
+    long m_ticksPerSecond = 100;
+    long m_pageSize = 4096;
+#endif
+
+    std::thread m_worker;
+    std::mutex m_controlMutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+    bool m_rescan = false;
+    std::string m_prefix;
+    uint32_t m_intervalMs = 1000;
+
+    mutable std::mutex m_dataMutex;
+    ProcessUsageSnapshot m_snapshot;
+};
+
+#endif // PROCESS_SAMPLER_H
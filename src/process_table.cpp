@@ -0,0 +1,377 @@
+// nginx-manager/src/process_table.cpp
+// 进程表 - 基于 Toolhelp 快照 (Windows) / /proc 扫描 (Linux) 的 nginx 进程清单
+
+#include "process_table.h"
+#include "nginx_control.h"
+#include "trace.h"
+
+#ifdef _WIN32
+#include <tlhelp32.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifndef _WIN32
+// 读取 /proc/<pid>/stat，解析进程名、父进程 PID 与启动时间
+// 进程名可能包含空格和括号，因此以最后一个 ')' 作为分隔
+static bool ReadProcStat(ProcessId pid, char* comm, size_t commSize,
+                         ProcessId* parentPid, unsigned long long* startTime) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    char buffer[512];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) return false;
+    buffer[n] = '\0';
+
+    char* lparen = strchr(buffer, '(');
+    char* rparen = strrchr(buffer, ')');
+    if (!lparen || !rparen || rparen < lparen) return false;
+
+    size_t len = std::min((size_t)(rparen - lparen - 1), commSize - 1);
+    memcpy(comm, lparen + 1, len);
+    comm[len] = '\0';
+
+    // ')' 之后依次为: state ppid pgrp session tty_nr tpgid flags minflt cminflt
+    // majflt cmajflt utime stime cutime cstime priority nice num_threads itrealvalue starttime
+    char* p = rparen + 2;
+    int field = 3;
+    unsigned long long value = 0;
+    while (*p && field <= 22) {
+        while (*p == ' ') ++p;
+        char* end = p;
+        if (field == 4 || field == 22) {
+            value = strtoull(p, &end, 10);
+            if (field == 4 && parentPid) *parentPid = (ProcessId)value;
+            if (field == 22 && startTime) *startTime = value;
+        } else {
+            while (*end && *end != ' ') ++end;
+        }
+        p = end;
+        ++field;
+    }
+    return field > 22;
+}
+#endif
+
+ProcessTable::ProcessTable() {
+}
+
+ProcessTable::~ProcessTable() {
+    ReleaseMaster();
+}
+
+void ProcessTable::ReleaseMaster() {
+#ifdef _WIN32
+    if (m_masterHandle) {
+        CloseHandle(m_masterHandle);
+        m_masterHandle = NULL;
+    }
+#else
+    m_masterStartTime = 0;
+#endif
+    m_masterPid = 0;
+    m_workerPids.clear();
+}
+
+void ProcessTable::Invalidate() {
+    ReleaseMaster();
+    m_entries.clear();
+}
+
+void ProcessTable::SetPrefix(const std::string& prefix) {
+    std::string normalized = prefix.empty() ? std::string() : NormalizePrefix(prefix);
+    if (normalized == m_prefix) return;
+    m_prefix = normalized;
+    Invalidate();
+}
+
+bool ScanNginxProcesses(std::vector<ProcessEntry>* entries) {
+    TraceSpan span(TRACE_PROBE, "process-scan");
+    entries->clear();
+
+#ifdef _WIN32
+    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (hSnapshot == INVALID_HANDLE_VALUE) return false;
+
+    PROCESSENTRY32W pe;
+    pe.dwSize = sizeof(pe);
+    if (Process32FirstW(hSnapshot, &pe)) {
+        do {
+            if (_wcsicmp(pe.szExeFile, L"nginx.exe") == 0) {
+                ProcessEntry entry;
+                entry.pid = pe.th32ProcessID;
+                entry.parentPid = pe.th32ParentProcessID;
+                entries->push_back(entry);
+            }
+        } while (Process32NextW(hSnapshot, &pe));
+    }
+    CloseHandle(hSnapshot);
+    return true;
+#else
+    DIR* dir = opendir("/proc");
+    if (!dir) return false;
+
+    struct dirent* de;
+    while ((de = readdir(dir)) != NULL) {
+        if (de->d_name[0] < '0' || de->d_name[0] > '9') continue;
+        ProcessId pid = (ProcessId)strtoul(de->d_name, NULL, 10);
+
+        char comm[32];
+        ProcessEntry entry;
+        unsigned long long startTime = 0;
+        if (ReadProcStat(pid, comm, sizeof(comm), &entry.parentPid, &startTime) && strcmp(comm, "nginx") == 0) {
+            entry.pid = pid;
+            entry.startTime = startTime;
+            entries->push_back(entry);
+        }
+    }
+    closedir(dir);
+    return true;
+#endif
+}
+
+bool FindPrefixArgument(const char* data, size_t length, std::string* prefix) {
+    std::vector<std::string> args;
+    size_t first = 0;
+    while (first < length && data[first] != '\0') ++first;
+    if (first >= 7 && memcmp(data, "nginx: ", 7) == 0) {
+        // 运行中的进程已被 setproctitle 改写：第一个字段是以空格连接的整个标题，其后以 '\0' 填充
+        for (size_t i = 7; i < first;) {
+            size_t end = i;
+            while (end < first && data[end] != ' ') ++end;
+            if (end > i) args.emplace_back(data + i, end - i);
+            i = end + 1;
+        }
+    } else {
+        // 未改写时参数以 '\0' 分隔
+        for (size_t i = 0; i < length;) {
+            size_t end = i;
+            while (end < length && data[end] != '\0') ++end;
+            args.emplace_back(data + i, end - i);
+            i = end + 1;
+        }
+    }
+
+    // -p 后的路径可以紧跟或作为下一个参数
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i].compare(0, 2, "-p") != 0) continue;
+        if (args[i].size() > 2) {
+            *prefix = args[i].substr(2);
+        } else if (i + 1 < args.size()) {
+            *prefix = args[i + 1];
+        }
+        return !prefix->empty();
+    }
+    return false;
+}
+
+#ifndef _WIN32
+static std::string ReadLink(const char* path) {
+    char buffer[4096];
+    ssize_t n = readlink(path, buffer, sizeof(buffer) - 1);
+    if (n <= 0) return std::string();
+    return std::string(buffer, (size_t)n);
+}
+
+// 可执行文件编译时的 --prefix，按路径缓存，每个 nginx 可执行文件只运行一次 -V
+static bool CompiledPrefix(const std::string& binary, std::string* prefix) {
+    static std::mutex mutex;
+    static std::map<std::string, std::string> cache;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(binary);
+        if (it != cache.end()) {
+            *prefix = it->second;
+            return !prefix->empty();
+        }
+    }
+    std::string compiled;
+    if (!QueryCompiledPrefix(binary, &compiled)) compiled.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    cache[binary] = compiled;
+    *prefix = compiled;
+    return !compiled.empty();
+}
+#endif
+
+bool ResolveProcessPrefix(ProcessId pid, std::string* prefix) {
+#ifdef _WIN32
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return false;
+    wchar_t path[MAX_PATH * 2];
+    DWORD length = MAX_PATH * 2;
+    BOOL ok = QueryFullProcessImageNameW(process, 0, path, &length);
+    CloseHandle(process);
+    if (!ok) return false;
+
+    std::wstring image(path, length);
+    size_t slash = image.find_last_of(L"\\/");
+    if (slash == std::wstring::npos) return false;
+    *prefix = WideToUtf8(image.substr(0, slash));
+    return true;
+#else
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/cmdline", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char buffer[4096];
+    ssize_t n = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (n <= 0) return false;
+
+    std::string explicitPrefix;
+    if (FindPrefixArgument(buffer, (size_t)n, &explicitPrefix)) {
+        if (explicitPrefix[0] != '/') {
+            // 相对路径以 master 的工作目录为基准
+            snprintf(path, sizeof(path), "/proc/%u/cwd", pid);
+            std::string cwd = ReadLink(path);
+            if (cwd.empty()) return false;
+            explicitPrefix = cwd + "/" + explicitPrefix;
+        }
+        *prefix = explicitPrefix;
+        return true;
+    }
+
+    // 未指定 -p 时 nginx 使用编译时的 --prefix；可执行文件被替换后链接带有 " (deleted)" 后缀
+    snprintf(path, sizeof(path), "/proc/%u/exe", pid);
+    std::string binary = ReadLink(path);
+    if (binary.size() > 10 && binary.compare(binary.size() - 10, 10, " (deleted)") == 0) binary.resize(binary.size() - 10);
+    if (binary.empty()) return false;
+    return CompiledPrefix(binary, prefix);
+#endif
+}
+
+bool IsWorkerProcess(ProcessId pid) {
+#ifdef _WIN32
+    (void)pid;
+    return true;
+#else
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%u/cmdline", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    static const char kTitle[] = "nginx: worker process";
+    char buffer[sizeof(kTitle)];
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    return n == (ssize_t)sizeof(kTitle) - 1 && memcmp(buffer, kTitle, sizeof(kTitle) - 1) == 0;
+#endif
+}
+
+std::string NormalizePrefix(const std::string& prefix) {
+    std::string normalized = prefix;
+#ifdef _WIN32
+    for (char& c : normalized) {
+        if (c == '/') c = '\\';
+    }
+    std::wstring wide = Utf8ToWide(normalized);
+    if (!wide.empty()) CharLowerBuffW(&wide[0], (DWORD)wide.size());
+    normalized = WideToUtf8(wide);
+    while (normalized.size() > 3 && normalized.back() == '\\') normalized.pop_back();
+#else
+    for (char& c : normalized) {
+        if (c == '\\') c = '/';
+    }
+    // 合并 "./" 与重复的 '/'，使 -p /opt/nginx/ 与 /opt/nginx 相同
+    std::string collapsed;
+    for (size_t i = 0; i < normalized.size(); ++i) {
+        if (normalized[i] == '/' && !collapsed.empty() && collapsed.back() == '/') continue;
+        if (normalized[i] == '.' && (i + 1 == normalized.size() || normalized[i + 1] == '/') &&
+            !collapsed.empty() && collapsed.back() == '/') {
+            ++i;
+            continue;
+        }
+        collapsed += normalized[i];
+    }
+    normalized = collapsed;
+    while (normalized.size() > 1 && normalized.back() == '/') normalized.pop_back();
+#endif
+    return normalized;
+}
+
+bool ProcessTable::ScanEntries() {
+    return ScanNginxProcesses(&m_entries);
+}
+
+bool ProcessTable::Refresh() {
+    uint64_t begin = MonotonicMicros();
+    ReleaseMaster();
+
+    bool ok = ScanEntries();
+    if (ok) {
+        // master 是父进程不属于 nginx 的那个进程，其余以它为父进程的是 worker
+        // 限定前缀时，只接受安装前缀与之相同的 master
+        for (const ProcessEntry& entry : m_entries) {
+            bool parentIsNginx = std::any_of(m_entries.begin(), m_entries.end(),
+                [&](const ProcessEntry& other) { return other.pid == entry.parentPid; });
+            if (parentIsNginx) continue;
+            if (!m_prefix.empty()) {
+                std::string prefix;
+                if (!ResolveProcessPrefix(entry.pid, &prefix) || NormalizePrefix(prefix) != m_prefix) continue;
+            }
+            m_masterPid = entry.pid;
+            break;
+        }
+
+        for (const ProcessEntry& entry : m_entries) {
+            if (m_masterPid && entry.parentPid == m_masterPid) {
+                m_workerPids.push_back(entry.pid);
+            }
+        }
+
+        if (!m_prefix.empty()) {
+            // 丢弃其他实例的进程，Entries() 只包含本实例的 master 与 worker
+            ProcessId master = m_masterPid;
+            m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&](const ProcessEntry& entry) {
+                return master == 0 || (entry.pid != master && entry.parentPid != master);
+            }), m_entries.end());
+        }
+
+        if (m_masterPid) {
+#ifdef _WIN32
+            // 无权限打开（例如以管理员身份运行的 nginx）时句柄为空，IsCachedMasterAlive 随之返回 false，
+            // 退化为每次扫描；master 与 worker 仍照常记录
+            m_masterHandle = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, m_masterPid);
+#else
+            for (const ProcessEntry& entry : m_entries) {
+                if (entry.pid == m_masterPid) m_masterStartTime = entry.startTime;
+            }
+#endif
+        }
+    }
+
+    m_lastScanMicros = MonotonicMicros() - begin;
+    return m_masterPid != 0;
+}
+
+bool ProcessTable::IsCachedMasterAlive() {
+    if (!m_masterPid) return false;
+
+#ifdef _WIN32
+    return m_masterHandle && WaitForSingleObject(m_masterHandle, 0) == WAIT_TIMEOUT;
+#else
+    char comm[32];
+    unsigned long long startTime = 0;
+    if (!ReadProcStat(m_masterPid, comm, sizeof(comm), NULL, &startTime)) return false;
+    return startTime == m_masterStartTime && strcmp(comm, "nginx") == 0;
+#endif
+}
+
+bool ProcessTable::IsRunning() {
+    TraceSpan span(TRACE_PROBE, "is-running");
+    if (IsCachedMasterAlive()) return true;
+    return Refresh();
+}
@@ -0,0 +1,85 @@
+// nginx-manager/src/process_table.h
+// 进程表 - 基于 Toolhelp 快照 (Windows) / /proc 扫描 (Linux) 的 nginx 进程清单
+
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include "platform.h"
+#include <string>
+#include <vector>
+
+// 进程表中的一条 nginx 进程记录
+struct ProcessEntry {
+    ProcessId pid = 0;
+    ProcessId parentPid = 0;
+    uint64_t startTime = 0;              // Linux: /proc/<pid>/stat 第 22 字段；Windows 上为 0
+};
+
+// 扫描系统进程表，只保留 nginx 进程（一次快照，不创建子进程）
+bool ScanNginxProcesses(std::vector<ProcessEntry>* entries);
+
+// 查询 nginx master 进程的安装前缀
+// Windows: 可执行文件所在目录；Linux: 命令行中的 -p 参数，未指定时取可执行文件编译时的 --prefix (nginx -V，按可执行文件缓存)
+bool ResolveProcessPrefix(ProcessId pid, std::string* prefix);
+
+// 从 /proc/<pid>/cmdline 的内容中取出 -p 参数
+// 既接受以 '\0' 分隔的原始参数，也接受运行中的 nginx 改写后的标题 "nginx: master process /usr/sbin/nginx -p /srv/a"
+bool FindPrefixArgument(const char* data, size_t length, std::string* prefix);
+
+// 是否为 nginx worker 进程：Linux 上按标题 "nginx: worker process" 判断，排除 cache manager / loader；
+// Windows 上无法读取标题，nginx 的子进程一律视为 worker
+bool IsWorkerProcess(ProcessId pid);
+
+// 规范化前缀以便比较：统一分隔符、去掉末尾分隔符，Windows 上不区分大小写
+std::string NormalizePrefix(const std::string& prefix);
+
+// nginx 进程清单
+// 缓存 master 与 worker 的 PID，"是否运行" 的判断优先校验缓存的 master，
+// 仅在缓存失效时才重新扫描整个进程表，不创建子进程（只有未指定 -p 的 master 首次出现时运行一次 nginx -V）。
+// 设置前缀后只认该前缀下的 master 及其子进程，同一主机上的其他 nginx 实例不受影响。
+class ProcessTable {
+public:
+    ProcessTable();
+    ~ProcessTable();
+
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    // 全量扫描进程表，重建 master/worker 缓存，返回是否找到 master
+    bool Refresh();
+
+    // 快速判断 nginx 是否运行：缓存的 master 仍存活时只需一次内核查询
+    bool IsRunning();
+
+    // 丢弃缓存，下次查询时强制全量扫描
+    void Invalidate();
+
+    // 限定实例前缀（空字符串表示不限定），前缀变化时丢弃缓存
+    void SetPrefix(const std::string& prefix);
+
+    ProcessId MasterPid() const { return m_masterPid; }
+    const std::vector<ProcessId>& WorkerPids() const { return m_workerPids; }
+    const std::vector<ProcessEntry>& Entries() const { return m_entries; }
+
+    // 最近一次全量扫描的耗时（微秒）
+    uint64_t LastScanMicros() const { return m_lastScanMicros; }
+
+private:
+    bool IsCachedMasterAlive();
+    void ReleaseMaster();
+    bool ScanEntries();
+
+    std::string m_prefix;                // 规范化后的前缀
+    ProcessId m_masterPid = 0;
+    std::vector<ProcessId> m_workerPids;
+    std::vector<ProcessEntry> m_entries;
+    uint64_t m_lastScanMicros = 0;
+
+#ifdef _WIN32
+    HANDLE m_masterHandle = NULL;        // 持有句柄以避免 PID 复用造成误判
+#else
+    unsigned long long m_masterStartTime = 0;  // /proc/<pid>/stat 第 22 字段，用于识别 PID 复用
+#endif
+};
+
+#endif // PROCESS_TABLE_H
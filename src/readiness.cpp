@@ -0,0 +1,353 @@
+// nginx-manager/src/readiness.cpp
+// 就绪检测 - 等待进程句柄、pid 文件与 listen 端口，取代固定时长的 Sleep
+
+#include "readiness.h"
+#include "file_util.h"
+#include "socket_util.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+// 事件等待的时间片：从 1ms 开始指数增长，上限 25ms
+static const uint32_t kMinSliceMs = 1;
+static const uint32_t kMaxSliceMs = 25;
+
+// nginx 展开 worker_processes auto 时使用的 CPU 数
+static size_t OnlineCpuCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return std::max<size_t>(info.dwNumberOfProcessors, 1);
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+#endif
+}
+
+ConfigHints ConfigHintsFrom(const NginxConfig& config) {
+    ConfigHints hints;
+    uint32_t processes = config.FindChild(NginxConfig::kNoDirective, "worker_processes");
+    if (processes != NginxConfig::kNoDirective && config.At(processes).argCount > 0) {
+        std::string value(config.Arg(processes, 0));
+        hints.workerProcesses = value == "auto" ? OnlineCpuCount()
+                                                : std::max<size_t>(strtoul(value.c_str(), nullptr, 10), 1);
+    }
+    uint32_t pid = config.FindChild(NginxConfig::kNoDirective, "pid");
+    if (pid != NginxConfig::kNoDirective && config.At(pid).argCount > 0) {
+        hints.pidFile = std::string(config.Arg(pid, 0));
+    }
+    hints.endpoints = config.ListenEndpoints();
+    return hints;
+}
+
+ConfigHints ScanConfigHints(const std::string& confPath) {
+    NginxConfig config;
+    std::string error;
+    if (!config.Load(confPath, &error)) {
+        ConfigHints hints;
+        hints.error = error;
+        return hints;
+    }
+    return ConfigHintsFrom(config);
+}
+
+ProcessId ReadPidFile(const std::string& path) {
+    std::ifstream file(path);
+    unsigned long pid = 0;
+    if (file >> pid) return (ProcessId)pid;
+    return 0;
+}
+
+bool ProbeEndpoint(const ListenEndpoint& endpoint, uint32_t timeoutMs) {
+    TraceSpan span(TRACE_PROBE, "probe-port", endpoint.port);
+    std::string host = endpoint.host.empty() ? "127.0.0.1" : endpoint.host;
+    SocketHandle s = ConnectTcp(host, endpoint.port, timeoutMs, nullptr);
+    if (s == kInvalidSocket) return false;
+    CloseSocket(s);
+    return true;
+}
+
+// 等待进程退出或 pid 目录发生变化，最多等待 sliceMs
+class ReadinessWaiter {
+public:
+    ReadinessWaiter(SpawnedProcess* process, const std::string& pidDir) : m_process(process) {
+#ifdef _WIN32
+        m_change = FindFirstChangeNotificationW(Utf8ToWide(pidDir).c_str(), FALSE,
+                                                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE);
+#else
+        m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotify >= 0) {
+            inotify_add_watch(m_inotify, pidDir.c_str(), IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_TO);
+        }
+#endif
+    }
+
+    ~ReadinessWaiter() {
+#ifdef _WIN32
+        if (m_change != INVALID_HANDLE_VALUE) FindCloseChangeNotification(m_change);
+#else
+        if (m_inotify >= 0) close(m_inotify);
+#endif
+    }
+
+    void Wait(uint32_t sliceMs) {
+#ifdef _WIN32
+        HANDLE handles[2];
+        DWORD count = 0;
+        if (!m_process->exited && m_process->handle) handles[count++] = m_process->handle;
+        if (m_change != INVALID_HANDLE_VALUE) handles[count++] = m_change;
+        if (count == 0) {
+            Sleep(sliceMs);
+            return;
+        }
+        DWORD rc = WaitForMultipleObjects(count, handles, FALSE, sliceMs);
+        if (rc >= WAIT_OBJECT_0 && rc < WAIT_OBJECT_0 + count && handles[rc - WAIT_OBJECT_0] == m_change) {
+            FindNextChangeNotification(m_change);
+        }
+#else
+        pollfd fds[2];
+        nfds_t count = 0;
+        if (!m_process->exited && m_process->pidfd >= 0) {
+            fds[count].fd = m_process->pidfd;
+            fds[count].events = POLLIN;
+            ++count;
+        }
+        if (m_inotify >= 0) {
+            fds[count].fd = m_inotify;
+            fds[count].events = POLLIN;
+            ++count;
+        }
+        if (poll(fds, count, (int)sliceMs) > 0 && m_inotify >= 0) {
+            char buffer[4096];
+            while (read(m_inotify, buffer, sizeof(buffer)) > 0) {
+            }
+        }
+#endif
+    }
+
+private:
+    SpawnedProcess* m_process;
+#ifdef _WIN32
+    HANDLE m_change = INVALID_HANDLE_VALUE;
+#else
+    int m_inotify = -1;
+#endif
+};
+
+ReadinessResult WaitForStartReady(SpawnedProcess* process, const ReadinessOptions& options) {
+    TraceSpan span(TRACE_WAIT, "wait-start");
+    ReadinessResult result;
+    const uint64_t deadline = process->spawnMicros + (uint64_t)options.timeoutMs * 1000;
+    std::vector<ListenEndpoint> pending = options.endpoints;
+    ReadinessWaiter waiter(process, DirectoryOf(options.pidFile));
+    uint32_t sliceMs = kMinSliceMs;
+
+    for (;;) {
+        if (PollSpawnedExit(process)) {
+#ifdef _WIN32
+            // Windows 版 nginx 的 master 即被创建的进程，它退出意味着启动失败
+            bool failed = true;
+#else
+            // Linux 上 nginx 默认以守护进程运行，父进程返回 0 表示已完成 fork
+            bool failed = process->exitCode != 0;
+#endif
+            if (failed) {
+                result.processExited = true;
+                result.exitCode = process->exitCode;
+                result.latencyMicros = MonotonicMicros() - process->spawnMicros;
+                result.detail = "nginx 进程已退出，退出码 " + std::to_string(process->exitCode);
+                return result;
+            }
+        }
+
+        if (!result.masterPid) {
+            ProcessId pid = ReadPidFile(options.pidFile);
+            if (pid && pid != options.stalePid) result.masterPid = pid;
+        }
+
+        if (result.masterPid) {
+            pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                         [](const ListenEndpoint& ep) { return ProbeEndpoint(ep, 5); }),
+                          pending.end());
+            if (pending.empty()) {
+                result.ready = true;
+                result.latencyMicros = MonotonicMicros() - process->spawnMicros;
+                return result;
+            }
+        }
+
+        uint64_t now = MonotonicMicros();
+        if (now >= deadline) break;
+        uint32_t leftMs = (uint32_t)((deadline - now + 999) / 1000);
+        waiter.Wait(std::min(sliceMs, leftMs));
+        sliceMs = std::min(sliceMs * 2, kMaxSliceMs);
+    }
+
+    result.latencyMicros = MonotonicMicros() - process->spawnMicros;
+    if (!result.masterPid) {
+        result.detail = "等待 pid 文件超时: " + options.pidFile;
+    } else {
+        result.detail = "端口未就绪:";
+        for (const ListenEndpoint& ep : pending) {
+            result.detail += " " + (ep.host.empty() ? std::string("*") : ep.host) + ":" + std::to_string(ep.port);
+        }
+    }
+    return result;
+}
+
+ReadinessResult WaitForProcessesGone(const std::vector<ProcessId>& pids, uint64_t beginMicros, uint32_t timeoutMs) {
+    TraceSpan span(TRACE_WAIT, "wait-exit", (int64_t)pids.size());
+    ReadinessResult result;
+    const uint64_t deadline = beginMicros + (uint64_t)timeoutMs * 1000;
+
+#ifdef _WIN32
+    std::vector<HANDLE> handles;
+    for (ProcessId pid : pids) {
+        HANDLE h = OpenProcess(SYNCHRONIZE, FALSE, pid);
+        if (h) handles.push_back(h);          // 打开失败说明进程已不存在
+    }
+
+    // WaitForMultipleObjects 一次最多等待 MAXIMUM_WAIT_OBJECTS 个句柄
+    for (size_t i = 0; i < handles.size(); i += MAXIMUM_WAIT_OBJECTS) {
+        DWORD count = (DWORD)std::min<size_t>(MAXIMUM_WAIT_OBJECTS, handles.size() - i);
+        uint64_t now = MonotonicMicros();
+        DWORD leftMs = now >= deadline ? 0 : (DWORD)((deadline - now + 999) / 1000);
+        WaitForMultipleObjects(count, &handles[i], TRUE, leftMs);
+    }
+    result.latencyMicros = MonotonicMicros() - beginMicros;
+
+    for (HANDLE h : handles) {
+        if (WaitForSingleObject(h, 0) == WAIT_TIMEOUT) ++result.remaining;
+        CloseHandle(h);
+    }
+#else
+    struct Target {
+        pid_t pid;
+        int pidfd;
+    };
+    std::vector<Target> targets;
+    for (ProcessId pid : pids) {
+        Target target;
+        target.pid = (pid_t)pid;
+#ifdef SYS_pidfd_open
+        target.pidfd = (int)syscall(SYS_pidfd_open, target.pid, 0);
+#else
+        target.pidfd = -1;
+#endif
+        if (target.pidfd < 0 && kill(target.pid, 0) != 0 && errno == ESRCH) continue;
+        targets.push_back(target);
+    }
+
+    uint32_t sliceMs = kMinSliceMs;
+    std::vector<pollfd> fds;
+    while (!targets.empty()) {
+        // pidfd 可读即进程已退出；无 pidfd 时退化为 kill(pid, 0) 检查
+        fds.clear();
+        bool needPolling = false;
+        for (const Target& target : targets) {
+            if (target.pidfd >= 0) {
+                pollfd fd = { target.pidfd, POLLIN, 0 };
+                fds.push_back(fd);
+            } else {
+                needPolling = true;
+            }
+        }
+
+        uint64_t now = MonotonicMicros();
+        if (now >= deadline) break;
+        int leftMs = (int)((deadline - now + 999) / 1000);
+        int waitMs = needPolling ? std::min<int>((int)sliceMs, leftMs) : leftMs;
+        poll(fds.data(), fds.size(), waitMs);
+        sliceMs = std::min(sliceMs * 2, kMaxSliceMs);
+
+        size_t fdIndex = 0;
+        for (size_t i = 0; i < targets.size();) {
+            bool gone;
+            if (targets[i].pidfd >= 0) {
+                gone = (fds[fdIndex++].revents & POLLIN) != 0;
+            } else {
+                gone = kill(targets[i].pid, 0) != 0 && errno == ESRCH;
+            }
+            if (gone) {
+                if (targets[i].pidfd >= 0) close(targets[i].pidfd);
+                targets.erase(targets.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+    }
+    result.latencyMicros = MonotonicMicros() - beginMicros;
+    result.remaining = targets.size();
+    for (const Target& target : targets) {
+        if (target.pidfd >= 0) close(target.pidfd);
+    }
+#endif
+
+    result.ready = result.remaining == 0;
+    if (!result.ready) result.detail = std::to_string(result.remaining) + " 个进程仍未退出";
+    return result;
+}
+
+ReadinessResult WaitForWorkerGeneration(ProcessTable& table, ProcessId masterPid,
+                                        const std::vector<ProcessId>& oldWorkers, size_t expectedWorkers,
+                                        uint64_t beginMicros, uint32_t timeoutMs) {
+    TraceSpan span(TRACE_WAIT, "wait-workers");
+    ReadinessResult result;
+    result.masterPid = masterPid;
+    const uint64_t deadline = beginMicros + (uint64_t)timeoutMs * 1000;
+    const size_t wanted = std::max<size_t>(expectedWorkers, 1);
+    uint32_t sliceMs = kMinSliceMs;
+
+    // 新进程的出现没有可等待的内核对象，按指数增长的时间片扫描进程表
+    for (;;) {
+        table.Refresh();
+        if (table.MasterPid() != masterPid) {
+            result.latencyMicros = MonotonicMicros() - beginMicros;
+            result.detail = table.MasterPid() ? "master 进程已变化" : "master 进程已退出";
+            return result;
+        }
+
+        result.newWorkers = 0;
+        result.remaining = 0;
+        for (const ProcessEntry& entry : table.Entries()) {
+            if (entry.parentPid != masterPid) continue;
+            if (std::find(oldWorkers.begin(), oldWorkers.end(), entry.pid) != oldWorkers.end()) {
+                ++result.remaining;
+            } else if (IsWorkerProcess(entry.pid)) {
+                // 刚 fork 出的子进程在改写标题前仍显示 master 的标题，下一轮再计入
+                ++result.newWorkers;
+            }
+        }
+
+        if (result.newWorkers >= wanted || (result.remaining == 0 && result.newWorkers > 0)) {
+            result.ready = true;
+            result.latencyMicros = MonotonicMicros() - beginMicros;
+            return result;
+        }
+
+        uint64_t now = MonotonicMicros();
+        if (now >= deadline) break;
+        uint32_t leftMs = (uint32_t)((deadline - now + 999) / 1000);
+#ifdef _WIN32
+        Sleep(std::min(sliceMs, leftMs));
+#else
+        usleep(std::min(sliceMs, leftMs) * 1000);
+#endif
+        sliceMs = std::min(sliceMs * 2, kMaxSliceMs);
+    }
+
+    result.latencyMicros = MonotonicMicros() - beginMicros;
+    result.detail = "等待新 worker 超时 (" + std::to_string(result.newWorkers) + "/" + std::to_string(wanted) + ")";
+    return result;
+}
@@ -0,0 +1,65 @@
+// nginx-manager/src/readiness.h
+// 就绪检测 - 等待进程句柄、pid 文件与 listen 端口，取代固定时长的 Sleep
+
+#ifndef READINESS_H
+#define READINESS_H
+
+#include "nginx_conf.h"
+#include "nginx_control.h"
+#include "process_table.h"
+#include <string>
+#include <vector>
+
+// 从配置中提取的就绪检测所需信息
+struct ConfigHints {
+    std::string pidFile;             // pid 指令，未配置时为空
+    std::vector<ListenEndpoint> endpoints;
+    size_t workerProcesses = 1;      // worker_processes，auto 为在线 CPU 数
+    std::string error;               // 配置解析失败时的错误信息
+};
+
+// 启动就绪检测参数
+struct ReadinessOptions {
+    std::string pidFile;             // 完整 pid 文件路径
+    ProcessId stalePid = 0;          // 启动前 pid 文件中残留的 PID，不能作为就绪依据
+    std::vector<ListenEndpoint> endpoints;
+    uint32_t timeoutMs = 10000;
+};
+
+// 就绪检测结果
+struct ReadinessResult {
+    bool ready = false;
+    bool processExited = false;      // 被创建的进程提前退出（通常是配置错误）
+    int exitCode = 0;
+    ProcessId masterPid = 0;
+    uint64_t latencyMicros = 0;      // 从创建进程 / 发出停止命令到结果确定的耗时
+    size_t remaining = 0;            // 停止检测：超时仍存活的进程数；重载检测：仍在退出的旧 worker 数
+    size_t newWorkers = 0;           // 重载检测：新一代 worker 数
+    std::string detail;
+};
+
+// 从已解析的配置中提取 listen、pid 与 worker_processes 指令
+ConfigHints ConfigHintsFrom(const NginxConfig& config);
+
+// 解析配置文件（含 include）并提取 listen、pid 与 worker_processes 指令
+ConfigHints ScanConfigHints(const std::string& confPath);
+
+// 读取 pid 文件，失败返回 0
+ProcessId ReadPidFile(const std::string& path);
+
+// 尝试连接 TCP 端口，连接被接受返回 true
+bool ProbeEndpoint(const ListenEndpoint& endpoint, uint32_t timeoutMs);
+
+// 等待新创建的 nginx 就绪：进程存活 + pid 文件写入 + 所有 listen 端口可连接
+ReadinessResult WaitForStartReady(SpawnedProcess* process, const ReadinessOptions& options);
+
+// 等待一组进程全部退出，beginMicros 为发出停止命令的时刻
+ReadinessResult WaitForProcessesGone(const std::vector<ProcessId>& pids, uint64_t beginMicros, uint32_t timeoutMs);
+
+// 重载后等待新一代 worker 取代旧 worker：master 不变，且新 worker 达到新配置的 worker_processes 个，
+// 或旧的子进程已全部退出且至少有一个新 worker（只计标题为 worker process 的进程，不含 cache manager / loader）
+ReadinessResult WaitForWorkerGeneration(ProcessTable& table, ProcessId masterPid,
+                                        const std::vector<ProcessId>& oldWorkers, size_t expectedWorkers,
+                                        uint64_t beginMicros, uint32_t timeoutMs);
+
+#endif // READINESS_H
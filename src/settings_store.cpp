@@ -0,0 +1,429 @@
+// nginx-manager/src/settings_store.cpp
+// 设置存储 - 启动时一次读入 INI 文件，修改只写内存，合并后在后台以 "临时文件 + 重命名" 原子落盘
+
+#include "settings_store.h"
+#include "file_util.h"
+#include "trace.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+static const char* const kNewline = "\r\n";
+#else
+static const char* const kNewline = "\n";
+#endif
+
+// ---------------------------------------------------------------------------
+// 编码
+
+static std::string ToLowerAscii(const std::string& text) {
+    std::string lower = text;
+    for (char& c : lower) {
+        if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    }
+    return lower;
+}
+
+static std::string Trim(const std::string& text) {
+    size_t begin = 0;
+    size_t end = text.size();
+    while (begin < end && (text[begin] == ' ' || text[begin] == '\t')) ++begin;
+    while (end > begin && (text[end - 1] == ' ' || text[end - 1] == '\t')) --end;
+    return text.substr(begin, end - begin);
+}
+
+static void AppendUtf8(uint32_t code, std::string* out) {
+    if (code < 0x80) {
+        *out += (char)code;
+    } else if (code < 0x800) {
+        *out += (char)(0xC0 | (code >> 6));
+        *out += (char)(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        *out += (char)(0xE0 | (code >> 12));
+        *out += (char)(0x80 | ((code >> 6) & 0x3F));
+        *out += (char)(0x80 | (code & 0x3F));
+    } else {
+        *out += (char)(0xF0 | (code >> 18));
+        *out += (char)(0x80 | ((code >> 12) & 0x3F));
+        *out += (char)(0x80 | ((code >> 6) & 0x3F));
+        *out += (char)(0x80 | (code & 0x3F));
+    }
+}
+
+// WritePrivateProfileStringW 写入的文件可能是带 BOM 的 UTF-16LE
+static std::string Utf16LeToUtf8(const char* data, size_t size) {
+    std::string out;
+    out.reserve(size);
+    for (size_t i = 0; i + 1 < size; i += 2) {
+        uint32_t unit = (uint8_t)data[i] | ((uint32_t)(uint8_t)data[i + 1] << 8);
+        if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < size) {
+            uint32_t low = (uint8_t)data[i + 2] | ((uint32_t)(uint8_t)data[i + 3] << 8);
+            if (low >= 0xDC00 && low < 0xE000) {
+                AppendUtf8(0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00), &out);
+                i += 2;
+                continue;
+            }
+        }
+        AppendUtf8(unit, &out);
+    }
+    return out;
+}
+
+#ifdef _WIN32
+static bool IsValidUtf8(const std::string& text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        uint8_t c = (uint8_t)text[i];
+        size_t extra = c < 0x80 ? 0 : (c >> 5) == 0x6 ? 1 : (c >> 4) == 0xE ? 2 : (c >> 3) == 0x1E ? 3 : 4;
+        if (extra == 4 || (extra > 0 && i + extra >= text.size())) return false;
+        for (size_t k = 1; k <= extra; ++k) {
+            if (((uint8_t)text[i + k] >> 6) != 0x2) return false;
+        }
+        i += extra + 1;
+    }
+    return true;
+}
+#endif
+
+static std::string DecodeFile(const std::string& bytes) {
+    if (bytes.size() >= 3 && (uint8_t)bytes[0] == 0xEF && (uint8_t)bytes[1] == 0xBB && (uint8_t)bytes[2] == 0xBF) {
+        return bytes.substr(3);
+    }
+    if (bytes.size() >= 2 && (uint8_t)bytes[0] == 0xFF && (uint8_t)bytes[1] == 0xFE) {
+        return Utf16LeToUtf8(bytes.data() + 2, bytes.size() - 2);
+    }
+#ifdef _WIN32
+    // 旧版本通过 WritePrivateProfileStringW 写入的是系统代码页 (ANSI)
+    if (!IsValidUtf8(bytes)) {
+        int size = MultiByteToWideChar(CP_ACP, 0, bytes.data(), (int)bytes.size(), NULL, 0);
+        std::wstring wide(size, 0);
+        MultiByteToWideChar(CP_ACP, 0, bytes.data(), (int)bytes.size(), &wide[0], size);
+        return WideToUtf8(wide);
+    }
+#endif
+    return bytes;
+}
+
+// ---------------------------------------------------------------------------
+// 文件操作（路径均为 UTF-8）
+
+static bool ReadWholeFile(const std::string& path, std::string* bytes, bool* missing) {
+    *missing = false;
+    bytes->clear();
+#ifdef _WIN32
+    FILE* file = _wfopen(Utf8ToWide(path).c_str(), L"rb");
+#else
+    FILE* file = fopen(path.c_str(), "rb");
+#endif
+    if (!file) {
+        *missing = errno == ENOENT;
+        return false;
+    }
+    char buffer[16 * 1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes->append(buffer, n);
+    }
+    bool ok = !ferror(file);
+    fclose(file);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// SettingsStore
+
+SettingsStore::~SettingsStore() {
+    Close();
+}
+
+bool SettingsStore::Open(const std::string& path, std::string* error) {
+    Close();
+
+    std::string bytes;
+    bool missing = false;
+    bool ok = ReadWholeFile(path, &bytes, &missing) || missing;
+    if (!ok && error) *error = "无法读取配置文件: " + path;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_path = path;
+        ParseLocked(DecodeFile(bytes));
+        m_version = 0;
+        m_savedVersion = 0;
+        m_stopping = false;
+    }
+    m_worker = std::thread(&SettingsStore::Run, this);
+    return ok;
+}
+
+void SettingsStore::Close() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+    Flush(nullptr);
+}
+
+void SettingsStore::SetDebounce(uint32_t debounceMs, uint32_t maxDelayMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_debounceMs = debounceMs;
+    m_maxDelayMs = maxDelayMs < debounceMs ? debounceMs : maxDelayMs;
+    m_wake.notify_all();
+}
+
+void SettingsStore::SetFlushHandler(FlushHandler handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onFlush = handler;
+}
+
+std::string SettingsStore::IndexKey(const std::string& section, const std::string& key) {
+    std::string index = ToLowerAscii(section);
+    index += '\0';
+    index += ToLowerAscii(key);
+    return index;
+}
+
+const SettingsStore::Entry* SettingsStore::FindLocked(const std::string& section, const std::string& key) const {
+    auto found = m_index.find(IndexKey(section, key));
+    if (found == m_index.end()) return nullptr;
+    return &m_sections[found->second.first].entries[found->second.second];
+}
+
+bool SettingsStore::Has(const std::string& section, const std::string& key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return FindLocked(section, key) != nullptr;
+}
+
+std::string SettingsStore::GetString(const std::string& section, const std::string& key,
+                                     const std::string& defaultValue) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Entry* entry = FindLocked(section, key);
+    return entry ? entry->value : defaultValue;
+}
+
+int SettingsStore::GetInt(const std::string& section, const std::string& key, int defaultValue) const {
+    std::string value = GetString(section, key, std::string());
+    const char* text = value.c_str();
+    char* end = nullptr;
+    long number = strtol(text, &end, 10);
+    return end == text ? defaultValue : (int)number;
+}
+
+void SettingsStore::SetString(const std::string& section, const std::string& key, const std::string& value) {
+    if (key.empty()) return;
+    // 值只能占一行
+    std::string clean = value;
+    for (char& c : clean) {
+        if (c == '\r' || c == '\n') c = ' ';
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string index = IndexKey(section, key);
+    auto found = m_index.find(index);
+    if (found != m_index.end()) {
+        Entry& entry = m_sections[found->second.first].entries[found->second.second];
+        if (entry.value == clean) return;
+        entry.value = clean;
+    } else {
+        size_t sectionIndex = m_sections.size();
+        std::string lowerSection = ToLowerAscii(section);
+        for (size_t i = 0; i < m_sections.size(); ++i) {
+            if (ToLowerAscii(m_sections[i].name) == lowerSection) {
+                sectionIndex = i;
+                break;
+            }
+        }
+        if (sectionIndex == m_sections.size()) {
+            // 新节与上一节之间空一行
+            if (!m_sections.empty()) {
+                std::vector<Entry>& previous = m_sections.back().entries;
+                if (!previous.empty() && !(previous.back().key.empty() && Trim(previous.back().value).empty())) {
+                    previous.push_back(Entry());
+                }
+            }
+            Section created;
+            created.name = section;
+            m_sections.push_back(created);
+        }
+
+        // 插在该节最后一个键之后，节末尾的空行与注释留在后面
+        std::vector<Entry>& entries = m_sections[sectionIndex].entries;
+        size_t position = entries.size();
+        while (position > 0 && entries[position - 1].key.empty()) --position;
+        Entry entry;
+        entry.key = key;
+        entry.value = clean;
+        entries.insert(entries.begin() + position, entry);
+        for (auto& item : m_index) {
+            if (item.second.first == sectionIndex && item.second.second >= position) ++item.second.second;
+        }
+        m_index[index] = std::make_pair(sectionIndex, position);
+    }
+
+    // 只有从 "无修改" 变为 "有修改" 时才需要唤醒后台线程；
+    // 之后的修改只会推迟落盘时刻，后台线程到期醒来时会重新计算
+    uint64_t now = MonotonicMicros();
+    bool wasClean = m_version == m_savedVersion;
+    if (wasClean) m_firstChangeMicros = now;
+    m_lastChangeMicros = now;
+    ++m_version;
+    ++m_stats.mutations;
+    if (wasClean) m_wake.notify_all();
+}
+
+void SettingsStore::SetInt(const std::string& section, const std::string& key, int value) {
+    SetString(section, key, std::to_string(value));
+}
+
+bool SettingsStore::IsDirty() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_version != m_savedVersion;
+}
+
+SettingsStoreStats SettingsStore::Stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string SettingsStore::Serialize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return SerializeLocked();
+}
+
+std::string SettingsStore::SerializeLocked() const {
+    std::string text;
+    for (const Section& section : m_sections) {
+        if (!section.name.empty()) {
+            text += '[';
+            text += section.name;
+            text += ']';
+            text += kNewline;
+        }
+        for (const Entry& entry : section.entries) {
+            if (!entry.key.empty()) {
+                text += entry.key;
+                text += '=';
+            }
+            text += entry.value;
+            text += kNewline;
+        }
+    }
+    return text;
+}
+
+void SettingsStore::ParseLocked(const std::string& text) {
+    m_sections.clear();
+    m_index.clear();
+    m_sections.push_back(Section());
+
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(begin, end - begin);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        begin = end + 1;
+
+        std::string trimmed = Trim(line);
+        if (trimmed.size() >= 2 && trimmed[0] == '[' && trimmed.find(']') != std::string::npos) {
+            Section section;
+            section.name = Trim(trimmed.substr(1, trimmed.find(']') - 1));
+            m_sections.push_back(section);
+            continue;
+        }
+
+        Entry entry;
+        size_t equals = trimmed.find('=');
+        if (trimmed.empty() || trimmed[0] == ';' || trimmed[0] == '#' || equals == std::string::npos ||
+            equals == 0) {
+            entry.value = line;  // 注释、空行与无法识别的行原样保留
+        } else {
+            entry.key = Trim(trimmed.substr(0, equals));
+            entry.value = Trim(trimmed.substr(equals + 1));
+            // 与 GetPrivateProfileString 一样去掉成对的引号
+            if (entry.value.size() >= 2 && entry.value[0] == '"' && entry.value.back() == '"') {
+                entry.value = entry.value.substr(1, entry.value.size() - 2);
+            }
+        }
+
+        Section& section = m_sections.back();
+        if (!entry.key.empty()) {
+            // 重复的键以第一个为准
+            m_index.emplace(IndexKey(section.name, entry.key),
+                            std::make_pair(m_sections.size() - 1, section.entries.size()));
+        }
+        section.entries.push_back(entry);
+    }
+}
+
+bool SettingsStore::WriteAtomically(const std::string& text, std::string* error) {
+    return WriteFileAtomically(m_path, text, error);
+}
+
+bool SettingsStore::Flush(std::string* error) {
+    TraceSpan span(TRACE_CONFIG, "settings-save");
+    // 持有文件锁期间序列化，保证较新的内容不会被较旧的内容覆盖
+    std::lock_guard<std::mutex> fileLock(m_fileMutex);
+    std::string text;
+    uint64_t version;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_version == m_savedVersion || m_path.empty()) return true;
+        version = m_version;
+        text = SerializeLocked();
+    }
+
+    uint64_t begin = MonotonicMicros();
+    bool ok = WriteAtomically(text, error);
+    uint64_t elapsed = MonotonicMicros() - begin;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (ok) {
+        if (version > m_savedVersion) m_savedVersion = version;
+        ++m_stats.flushes;
+        m_stats.lastFlushMicros = elapsed;
+    } else {
+        ++m_stats.failures;
+    }
+    return ok;
+}
+
+void SettingsStore::Run() {
+    TraceSetThreadName("settings");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stopping) {
+        if (m_version == m_savedVersion) {
+            // 没有待落盘的修改时无限等待，不占用 CPU
+            m_wake.wait(lock);
+            continue;
+        }
+
+        uint64_t now = MonotonicMicros();
+        uint64_t quietDue = m_lastChangeMicros + (uint64_t)m_debounceMs * 1000;
+        uint64_t latestDue = m_firstChangeMicros + (uint64_t)m_maxDelayMs * 1000;
+        uint64_t due = quietDue < latestDue ? quietDue : latestDue;
+        if (now < due) {
+            m_wake.wait_for(lock, std::chrono::microseconds(due - now));
+            continue;
+        }
+
+        FlushHandler handler = m_onFlush;
+        lock.unlock();
+        std::string error;
+        bool ok = Flush(&error);
+        if (handler) handler(ok, error);
+        lock.lock();
+
+        if (!ok) {
+            // 写入失败（磁盘满、文件被占用等）时推迟重试，避免空转
+            uint64_t retry = MonotonicMicros() + (uint64_t)m_maxDelayMs * 1000;
+            m_firstChangeMicros = retry;
+            m_lastChangeMicros = retry;
+        }
+    }
+}
@@ -0,0 +1,104 @@
+// nginx-manager/src/settings_store.h
+// 设置存储 - 启动时一次读入 INI 文件，修改只写内存，合并后在后台以 "临时文件 + 重命名" 原子落盘
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include "platform.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 落盘统计
+struct SettingsStoreStats {
+    uint64_t mutations = 0;          // 实际改变了值的写入次数
+    uint64_t flushes = 0;            // 成功落盘次数
+    uint64_t failures = 0;
+    uint64_t lastFlushMicros = 0;    // 最近一次落盘耗时
+};
+
+// INI 格式的设置存储
+// - 节名与键名不区分大小写（与 GetPrivateProfileString 一致），注释与未知的键原样保留
+// - Set 只修改内存并唤醒后台线程；最后一次修改后静默 debounce 毫秒才落盘，
+//   持续修改时最迟 maxDelay 毫秒落盘一次，避免每次按键都写文件
+// - 落盘先写 <path>.tmp 并刷到磁盘，再重命名覆盖原文件，中途崩溃不会留下半个文件
+// - 文件以 UTF-8 保存；读取时兼容 UTF-16 (带 BOM) 与 Windows 的 ANSI 编码
+// 所有方法线程安全。
+class SettingsStore {
+public:
+    typedef std::function<void(bool ok, const std::string& error)> FlushHandler;
+
+    SettingsStore() {}
+    ~SettingsStore();
+
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    // 读入文件并启动后台落盘线程；文件不存在不算失败
+    bool Open(const std::string& path, std::string* error);
+    // 停止后台线程，并把尚未落盘的修改同步写入
+    void Close();
+
+    void SetDebounce(uint32_t debounceMs, uint32_t maxDelayMs);
+    // 每次后台落盘后在后台线程中调用
+    void SetFlushHandler(FlushHandler handler);
+
+    bool Has(const std::string& section, const std::string& key) const;
+    std::string GetString(const std::string& section, const std::string& key, const std::string& defaultValue) const;
+    // 与 GetPrivateProfileInt 相同：取开头的整数部分，无法解析时返回默认值
+    int GetInt(const std::string& section, const std::string& key, int defaultValue) const;
+
+    void SetString(const std::string& section, const std::string& key, const std::string& value);
+    void SetInt(const std::string& section, const std::string& key, int value);
+
+    // 立即同步落盘（没有未落盘的修改时直接返回 true）
+    bool Flush(std::string* error);
+
+    bool IsDirty() const;
+    SettingsStoreStats Stats() const;
+
+    // 序列化为 INI 文本（即落盘的内容）
+    std::string Serialize() const;
+
+private:
+    struct Entry {
+        std::string key;             // 为空表示注释或空行，原样保存在 value 中
+        std::string value;
+    };
+    struct Section {
+        std::string name;            // 第一个节之前的内容放在名字为空的节中
+        std::vector<Entry> entries;
+    };
+
+    static std::string IndexKey(const std::string& section, const std::string& key);
+    const Entry* FindLocked(const std::string& section, const std::string& key) const;
+    std::string SerializeLocked() const;
+    void ParseLocked(const std::string& text);
+    bool WriteAtomically(const std::string& text, std::string* error);
+    void Run();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::thread m_worker;
+    bool m_stopping = false;
+
+    std::string m_path;
+    std::vector<Section> m_sections;
+    std::unordered_map<std::string, std::pair<size_t, size_t>> m_index;   // 节\0键 -> (节, 条目)
+    uint64_t m_version = 0;          // 每次修改加一
+    uint64_t m_savedVersion = 0;     // 已落盘的版本
+    uint64_t m_firstChangeMicros = 0;
+    uint64_t m_lastChangeMicros = 0;
+    uint32_t m_debounceMs = 500;
+    uint32_t m_maxDelayMs = 3000;
+    FlushHandler m_onFlush;
+    SettingsStoreStats m_stats;
+
+    std::mutex m_fileMutex;          // 后台落盘与同步 Flush 不能同时写临时文件
+};
+
+#endif // SETTINGS_STORE_H
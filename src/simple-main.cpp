@@ -7,12 +7,37 @@
 #include <windows.h>
 #include <string>
 #include <cstdio>
+#include <cstring>
 #include <fstream>
+#include <mutex>
+#include <atomic>
+#include <thread>
 #include <shellapi.h>
 #include <shlobj.h>
 #include <objbase.h>
-#include <richedit.h>
 #include "resource.h"
+#include "process_table.h"
+#include "nginx_service.h"
+#include "instance_registry.h"
+#include "op_queue.h"
+#include "config_cache.h"
+#include "access_log.h"
+#include "stub_status.h"
+#include "process_sampler.h"
+#include "cpu_topology.h"
+#include "log_rotator.h"
+#include "health_prober.h"
+#include "conf_watcher.h"
+#include "trace.h"
+#include "log_view.h"
+#include "status_view.h"
+#include "journal.h"
+#include "settings_store.h"
+#include "supervisor.h"
+#include "load_test.h"
+#include "load_history.h"
+#include "log_store.h"
+#include "daemon.h"
 
 #pragma comment(lib, "user32.lib")
 #pragma comment(lib, "gdi32.lib")
@@ -34,8 +59,17 @@ const wchar_t* CONFIG_FILE = L"nginx-manager.ini";
 #define ID_CONFIG_BUTTON    1006
 #define ID_REFRESH_BUTTON   1007
 #define ID_FONT_BUTTON      1008
-#define ID_STATUS_TEXT      1009
-#define ID_LOG_EDIT         1010
+#define ID_STATUS_VIEW      1009
+#define ID_LOG_VIEW         1010
+#define ID_HARD_RESTART_BUTTON 1011
+#define ID_AFFINITY_BUTTON  1013
+#define ID_LOADTEST_BUTTON  1014
+#define ID_LOGQUERY_BUTTON  1015
+#define ID_DIAGNOSTICS_BUTTON 1016
+
+// 定时器
+#define ID_TRAFFIC_TIMER    1
+#define ID_INSTANCE_TIMER   2
 
 // 字体设置对话框控件ID
 #define ID_NORMAL_FONT_EDIT    2001
@@ -45,6 +79,29 @@ const wchar_t* CONFIG_FILE = L"nginx-manager.ini";
 #define ID_CANCEL_FONT_BTN     2005
 #define ID_PREVIEW_BTN         2006
 
+// 自定义窗口消息（后台线程 -> 界面线程）
+#define WM_APP_STATUS          (WM_APP + 2)
+#define WM_APP_MESSAGEBOX      (WM_APP + 3)
+#define WM_APP_OP_DONE         (WM_APP + 4)
+
+// 后台操作类型
+enum ServiceOperation {
+    OP_START = 1,
+    OP_STOP,
+    OP_RESTART,
+    OP_HARD_RESTART,
+    OP_REFRESH,
+    OP_UPDATE_STATUS,
+    OP_PROBE_INSTANCES,
+    OP_RECOVER,
+    OP_APPLY_AFFINITY,
+    OP_CONF_CHANGE,
+    OP_EXPORT_TRACE
+};
+
+// 启动/停止/重启/自动恢复互相取代
+#define OP_GROUP_SERVICE       1
+
 // Global variables
 HWND g_hMainWnd = NULL;
 HWND g_hPathEdit = NULL;
@@ -52,10 +109,63 @@ HWND g_hStartBtn = NULL;
 HWND g_hStopBtn = NULL;
 HWND g_hRestartBtn = NULL;
 HWND g_hConfigBtn = NULL;
-HWND g_hStatusText = NULL;
-HWND g_hLogEdit = NULL;
+HWND g_hStatusView = NULL;
+HWND g_hLogView = NULL;
 
 std::wstring g_nginxPath;
+std::mutex g_nginxPathMutex;     // 界面线程写入 g_nginxPath 时加锁，后台线程通过 GetNginxPath 读取
+
+// 界面线程 ID，用于判断是否需要把界面更新投递回界面线程
+DWORD g_uiThreadId = 0;
+
+// 服务控制核心（与无界面模式共用），限定为当前路径下的实例；只在工作线程中调用
+NginxService g_service("");
+
+// 同一主机上额外登记的 nginx 实例（配置文件 [Instances] 节），每 5 秒统一探测一次
+InstanceRegistry g_instances;
+bool g_instancesProbed = false;  // 仅在工作线程访问
+
+// access.log 跟随与流量统计（独立后台线程）
+AccessLogMonitor g_accessLog;
+
+// stub_status 轮询（独立后台线程，长连接每秒采样一次）
+StubStatusPoller g_stubStatus;
+
+// master 与各 worker 的资源占用（独立后台线程，每秒采样一次）
+ProcessSampler g_processSampler;
+
+// 日志按大小 / 时间轮转，归档在低优先级线程中压缩（独立后台线程）
+LogRotator g_logRotator;
+
+// upstream 健康检查（独立后台线程，一个事件循环并发探测所有 server）
+HealthProber g_healthProber;
+
+// 配置监视：conf 目录与 include 的目录有修改时防抖合并，提交 OP_CONF_CHANGE 校验并重新加载（独立后台线程）
+ConfigWatcher g_confWatcher;
+std::mutex g_confChangeMutex;
+ConfigChange g_confChange;       // 尚未处理的修改，处理前又有新的修改时合并，耗时从最早的一次算起
+
+// 操作日志：固定容量的环形缓冲，日志面板只是它的视图
+LogModel g_logModel(5000);
+
+// 操作日志持久化（程序目录下的 journal 目录），面板向上滚动时从这里加载更早的记录
+Journal g_journal;
+
+// 程序设置（nginx-manager.ini）：启动时读入一次，修改由后台线程合并后原子落盘
+SettingsStore g_settings;
+
+// 崩溃监护：阻塞等待 master 退出，意外退出后按退避策略提交 OP_RECOVER
+Supervisor g_supervisor;
+
+// 压测（独立后台线程，同一时间只运行一次），结果按配置指纹保存在 <nginx>\logs\loadtest
+std::thread g_loadTestThread;
+std::atomic<bool> g_loadTestRunning{false};
+std::atomic<bool> g_loadTestCancel{false};
+
+// 访问日志查询（独立后台线程）：先把新的轮转归档导入 <nginx>\logs\store 下的列存，再聚合查询
+std::thread g_logQueryThread;
+std::atomic<bool> g_logQueryRunning{false};
+std::atomic<bool> g_logQueryCancel{false};
 
 // 状态颜色
 COLORREF g_statusColor = RGB(128, 128, 128); // 默认灰色
@@ -73,35 +183,107 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 void CreateControls(HWND hwnd);
 void LoadConfiguration();
 void SaveConfiguration();
-void StartNginx();
-void StopNginx();
-void RestartNginx();
+void StartNginx(const OperationContext& context);
+void StopNginx(const OperationContext& context);
+void RecoverNginx(const OperationContext& context);
+void RestartNginx(const OperationContext& context, bool hardRestart);
+void ApplyConfigChange(const OperationContext& context);
+void OnServiceLog(LogSeverity severity, const std::string& text);
+void RescanAfterServiceChange();
 void OpenConfig();
+void PlanCpuAffinity();
+void ApplyCpuAffinity(const OperationContext& context, const AffinityPlan& plan);
 void RefreshStatus();
 void BrowseForPath();
 void UpdateStatus();
 void AddLogMessage(const wchar_t* message);
 bool IsNginxRunning();
-void ExecuteCommand(const wchar_t* command);
+void SyncServicePrefix();
+void LoadInstances();
+void OnSettingsFlushed(bool ok, const std::string& error);
+void ProbeInstances();
+void UpdateDashboard();
 std::wstring StringToWString(const std::string& str);
 std::string WStringToString(const std::wstring& wstr);
 void SetButtonStyle(HWND hButton, COLORREF bgColor, COLORREF textColor);
 void ApplyModernStyling();
-void SetStatusColor(COLORREF color);
 void AddColoredLogMessage(const wchar_t* message, COLORREF color);
 void LoadFontConfiguration();
 void SaveFontConfiguration();
 void ShowFontSettings();
 void ApplyFontSettings();
 void RefreshAllFonts();
-void SetStatusTextSafe(const wchar_t* text);
 void UpdateFontPreview(HWND hDlg);
 INT_PTR CALLBACK FontSettingsDialogProc(HWND hDlg, UINT message, WPARAM wParam, LPARAM lParam);
+std::wstring GetNginxPath();
+void SetNginxPath(const std::wstring& path);
+bool IsUiThread();
+void SetStatus(const wchar_t* text, COLORREF color);
+void ShowMessageSafe(const wchar_t* text, const wchar_t* caption, UINT type);
+void SubmitOperation(ServiceOperation op);
+void OnOperationComplete(const OperationResult& result);
+void RecordServiceEvent(const char* name, bool ok, uint64_t latencyMicros);
+void OnSupervisorEvent(const SupervisorEvent& event);
+LogRotationPolicy LoadLogRotationPolicy();
+bool ReopenNginxLogs(std::string* error);
+void OnLogRotationEvent(const LogRotationEvent& event);
+HealthCheckOptions LoadHealthCheckOptions();
+void OnHealthEvent(const HealthEvent& event);
+ConfigWatchOptions LoadConfigWatchOptions();
+void OnConfigChange(const ConfigChange& change);
+LoadTestOptions LoadLoadTestOptions();
+void StartLoadTestUi();
+void RunLoadTestTask(LoadTestOptions options);
+void StartLogQueryUi();
+void RunLogQueryTask(std::string text);
+void AddLogTable(const std::string& table, COLORREF color);
+void ShowDiagnostics();
+void ExportTrace();
+const char* OperationKindName(int kind);
+int RunDaemonMode(const std::wstring& exeDir);
+size_t LoadLogHistory(uint64_t beforeOrigin, uint64_t afterOrigin, size_t count, std::vector<LogRecord>* records,
+                      std::vector<std::string>* texts);
+
+// 后台操作队列：所有服务操作在工作线程中执行，界面线程只负责提交
+OperationQueue g_opQueue(OnOperationComplete);
+
+// 后台线程投递给界面线程的状态 / 消息框内容
+struct UiPost {
+    std::wstring text;
+    std::wstring caption;
+    COLORREF color = 0;
+    UINT type = 0;
+};
 
 // Main program entry
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
     // Set console code page to UTF-8
     SetConsoleOutputCP(CP_UTF8);
+    g_uiThreadId = GetCurrentThreadId();
+
+    wchar_t exePath[MAX_PATH];
+    GetModuleFileNameW(NULL, exePath, MAX_PATH);
+    std::wstring exeDir = exePath;
+    size_t lastSlash = exeDir.find_last_of(L"\\");
+    exeDir = lastSlash != std::wstring::npos ? exeDir.substr(0, lastSlash + 1) : L"";
+
+    // 设置在创建窗口前读入（字体配置在 WM_CREATE 中使用）
+    std::string settingsError;
+    bool settingsOpened = g_settings.Open(WStringToString(exeDir + CONFIG_FILE), &settingsError);
+    g_settings.SetFlushHandler(OnSettingsFlushed);
+
+    // 无界面模式：不创建窗口，由控制通道接受命令
+    if (strstr(lpCmdLine, "--daemon")) {
+        return RunDaemonMode(exeDir);
+    }
+
+    // 追踪默认关闭，"诊断"按钮随时开启；[Diagnostics] Trace=1 时从启动开始记录
+    TraceSetThreadName("ui");
+    if (g_settings.GetInt("Diagnostics", "Trace", 0) != 0) TraceEnable(true);
+
+    // 先打开持久化日志，之后的所有日志都会写入
+    std::string journalError;
+    bool journalOpened = g_journal.Open(WStringToString(exeDir + L"journal"), &journalError);
 
     // Register window class
     WNDCLASSW wc = {};
@@ -115,7 +297,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         wc.hIcon = LoadIcon(NULL, IDI_APPLICATION); // 如果失败则使用默认图标
     }
 
-    if (!RegisterClassW(&wc)) {
+    if (!RegisterClassW(&wc) || !RegisterLogViewClass(hInstance) || !RegisterStatusViewClass(hInstance)) {
         MessageBoxW(NULL, L"窗口注册失败！", L"错误", MB_OK | MB_ICONERROR);
         return 1;
     }
@@ -124,7 +306,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     int screenWidth = GetSystemMetrics(SM_CXSCREEN);
     int screenHeight = GetSystemMetrics(SM_CYSCREEN);
     int windowWidth = 520;  // 减小宽度以适应新的紧凑布局
-    int windowHeight = 580; // 增加高度以适应两行按钮
+    int windowHeight = 600; // 增加高度以适应状态面板和两行按钮
     int x = (screenWidth - windowWidth) / 2;
     int y = (screenHeight - windowHeight) / 2;
 
@@ -143,9 +325,42 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     ShowWindow(g_hMainWnd, nCmdShow);
     UpdateWindow(g_hMainWnd);
 
+    g_service.SetLogSink(OnServiceLog);
+    g_opQueue.SetKindNames(OperationKindName);
+    g_opQueue.Start();
+    // 自动重启默认开启，可在配置文件 [Settings] AutoRestart=0 关闭（关闭后仍会记录意外退出）
+    g_supervisor.SetEnabled(g_settings.GetInt("Settings", "AutoRestart", 1) != 0);
+    std::string supervisorError;
+    bool supervisorStarted = g_supervisor.Start(OnSupervisorEvent, &supervisorError);
+    g_logRotator.SetHandlers(ReopenNginxLogs, OnLogRotationEvent);
+    g_logRotator.SetPolicy(LoadLogRotationPolicy());
+    g_healthProber.SetHandler(OnHealthEvent);
+    g_healthProber.SetOptions(LoadHealthCheckOptions());
+    g_confWatcher.SetHandler(OnConfigChange);
+    g_confWatcher.SetOptions(LoadConfigWatchOptions());
+
     LoadConfiguration();
     AddColoredLogMessage(L"Nginx 管理器已启动", RGB(0, 100, 200)); // 蓝色
-    UpdateStatus();
+    if (!journalOpened) {
+        std::wstring logMsg = L"操作日志无法持久化: " + StringToWString(journalError);
+        AddColoredLogMessage(logMsg.c_str(), RGB(255, 140, 0)); // 橙色
+    }
+    if (!settingsOpened) {
+        std::wstring logMsg = L"配置文件读取失败，使用默认设置: " + StringToWString(settingsError);
+        AddColoredLogMessage(logMsg.c_str(), RGB(255, 140, 0)); // 橙色
+    }
+    if (!supervisorStarted) {
+        std::wstring logMsg = L"崩溃监护无法启动，nginx 意外退出后不会自动重启: " + StringToWString(supervisorError);
+        AddColoredLogMessage(logMsg.c_str(), RGB(255, 140, 0)); // 橙色
+    }
+    SubmitOperation(OP_UPDATE_STATUS);
+
+    UpdateDashboard();
+    SetTimer(g_hMainWnd, ID_TRAFFIC_TIMER, 1000, NULL);
+    if (g_instances.Size() > 0) {
+        SubmitOperation(OP_PROBE_INSTANCES);
+        SetTimer(g_hMainWnd, ID_INSTANCE_TIMER, 5000, NULL);
+    }
 
     // Message loop
     MSG msg = {};
@@ -157,6 +372,42 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     return (int)msg.wParam;
 }
 
+// 无界面模式：ngTool.exe --daemon [--prefix <目录>] [--endpoint <管道名>] [--journal <目录>] [--quiet]
+// 未指定 --prefix 时使用配置文件中的 nginx 路径；操作日志单独存放，不与图形界面的日志混写
+int RunDaemonMode(const std::wstring& exeDir) {
+    // 从命令行启动时把输出接到该控制台（-mwindows 程序默认没有控制台）
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+
+    int argc = 0;
+    LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    std::vector<std::string> args;
+    for (int i = 1; argv && i < argc; ++i) {
+        args.push_back(WStringToString(argv[i]));
+    }
+    if (argv) LocalFree(argv);
+
+    DaemonOptions options;
+    options.prefix = g_settings.GetString("Settings", "NginxPath", "");
+    options.journalDir = WStringToString(exeDir + L"journal-daemon");
+    options.autoRestart = g_settings.GetInt("Settings", "AutoRestart", 1) != 0;
+    options.rotation = LoadLogRotationPolicy();
+    options.health = LoadHealthCheckOptions();
+    options.confWatch = LoadConfigWatchOptions();
+    options.trace = g_settings.GetInt("Diagnostics", "Trace", 0) != 0;
+    std::string error;
+    if (!ParseDaemonArgs(args, &options, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    int exitCode = RunDaemon(options);
+    g_settings.Close();
+    return exitCode;
+}
+
 // Window procedure
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     switch (uMsg) {
@@ -168,19 +419,34 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             WORD wmId = LOWORD(wParam);
             switch (wmId) {
                 case ID_START_BUTTON:
-                    StartNginx();
+                    SubmitOperation(OP_START);
                     break;
                 case ID_STOP_BUTTON:
-                    StopNginx();
+                    SubmitOperation(OP_STOP);
                     break;
                 case ID_RESTART_BUTTON:
-                    RestartNginx();
+                    SubmitOperation(OP_RESTART);
+                    break;
+                case ID_HARD_RESTART_BUTTON:
+                    SubmitOperation(OP_HARD_RESTART);
                     break;
                 case ID_CONFIG_BUTTON:
                     OpenConfig();
                     break;
+                case ID_AFFINITY_BUTTON:
+                    PlanCpuAffinity();
+                    break;
+                case ID_LOADTEST_BUTTON:
+                    StartLoadTestUi();
+                    break;
+                case ID_LOGQUERY_BUTTON:
+                    StartLogQueryUi();
+                    break;
+                case ID_DIAGNOSTICS_BUTTON:
+                    ShowDiagnostics();
+                    break;
                 case ID_REFRESH_BUTTON:
-                    RefreshStatus();
+                    SubmitOperation(OP_REFRESH);
                     break;
                 case ID_FONT_BUTTON:
                     ShowFontSettings();
@@ -192,7 +458,7 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                     if (HIWORD(wParam) == EN_CHANGE) {
                         wchar_t buffer[MAX_PATH];
                         GetWindowTextW(g_hPathEdit, buffer, MAX_PATH);
-                        g_nginxPath = buffer;
+                        SetNginxPath(buffer);
                         SaveConfiguration();
                     }
                     break;
@@ -200,18 +466,27 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
             return 0;
         }
 
-        case WM_CTLCOLORSTATIC: {
-            HDC hdc = (HDC)wParam;
-            HWND hControl = (HWND)lParam;
+        case WM_APP_STATUS: {
+            UiPost* post = (UiPost*)lParam;
+            SetStatus(post->text.c_str(), post->color);
+            delete post;
+            return 0;
+        }
 
-            if (hControl == g_hStatusText) {
-                SetTextColor(hdc, g_statusColor);
-                SetBkMode(hdc, TRANSPARENT);
-                return (LRESULT)GetStockObject(NULL_BRUSH);
-            }
-            break;
+        case WM_APP_MESSAGEBOX: {
+            UiPost* post = (UiPost*)lParam;
+            MessageBoxW(hwnd, post->text.c_str(), post->caption.c_str(), post->type);
+            delete post;
+            return 0;
         }
 
+        case WM_APP_OP_DONE:
+            // lParam 非 0 表示操作被后续操作取代
+            if (lParam && wParam != OP_UPDATE_STATUS && wParam != OP_PROBE_INSTANCES) {
+                AddColoredLogMessage(L"上一个操作已被新的操作取代", RGB(128, 128, 128)); // 灰色
+            }
+            return 0;
+
         case WM_SIZE: {
             RECT rect;
             GetClientRect(hwnd, &rect);
@@ -222,10 +497,10 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
                 // 重新调整控件位置和大小以适应新的窗口尺寸
                 SetWindowPos(g_hPathEdit, NULL, 20, 45, width - 120, 32, SWP_NOZORDER);
                 SetWindowPos(GetDlgItem(hwnd, ID_BROWSE_BUTTON), NULL, width - 90, 45, 80, 32, SWP_NOZORDER);
-                SetWindowPos(g_hStatusText, NULL, 110, 95, width - 130, 20, SWP_NOZORDER);
+                SetWindowPos(g_hStatusView, NULL, 20, 85, width - 40, 56, SWP_NOZORDER);
 
                 // 日志区域自适应大小
-                SetWindowPos(g_hLogEdit, NULL, 20, 215, width - 40, height - 235, SWP_NOZORDER);
+                SetWindowPos(g_hLogView, NULL, 20, 270, width - 40, height - 290, SWP_NOZORDER);
             }
             return 0;
         }
@@ -233,15 +508,44 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         case WM_GETMINMAXINFO: {
             LPMINMAXINFO lpMMI = (LPMINMAXINFO)lParam;
             lpMMI->ptMinTrackSize.x = 520; // 最小宽度 - 适应新的按钮布局
-            lpMMI->ptMinTrackSize.y = 580; // 最小高度 - 适应两行按钮
+            lpMMI->ptMinTrackSize.y = 600; // 最小高度 - 适应状态面板和两行按钮
             return 0;
         }
 
 
 
+        case WM_TIMER:
+            if (wParam == ID_TRAFFIC_TIMER) {
+                UpdateDashboard();
+                return 0;
+            }
+            if (wParam == ID_INSTANCE_TIMER) {
+                SubmitOperation(OP_PROBE_INSTANCES);
+                return 0;
+            }
+            break;
+
         case WM_DESTROY:
+            KillTimer(hwnd, ID_TRAFFIC_TIMER);
+            KillTimer(hwnd, ID_INSTANCE_TIMER);
+            g_accessLog.Stop();
+            g_stubStatus.Stop();
+            g_processSampler.Stop();
+            g_logRotator.Stop();
+            g_healthProber.Stop();
+            g_confWatcher.Stop();
+            g_supervisor.Stop();
+            g_loadTestCancel = true;
+            if (g_loadTestThread.joinable()) g_loadTestThread.join();
+            g_logQueryCancel = true;
+            if (g_logQueryThread.joinable()) g_logQueryThread.join();
+            g_opQueue.Stop();
+            g_hLogView = NULL;
+            g_hStatusView = NULL;
             SaveConfiguration();
             SaveFontConfiguration();
+            g_settings.Close();  // 同步写入尚未落盘的修改
+            g_journal.Close();
             PostQuitMessage(0);
             return 0;
     }
@@ -288,62 +592,77 @@ void CreateControls(HWND hwnd) {
                                    670, 45, 80, 32, hwnd, (HMENU)ID_BROWSE_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(hBrowseBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
-    // 状态显示区域
-    HWND hStatusLabel = CreateWindowW(L"STATIC", L"服务状态:",
-                                     WS_CHILD | WS_VISIBLE,
-                                     20, 95, 80, 20, hwnd, NULL, GetModuleHandle(NULL), NULL);
-    SendMessage(hStatusLabel, WM_SETFONT, (WPARAM)hNormalFont, TRUE);
-
-    g_hStatusText = CreateWindowW(L"STATIC", L"未知",
-                                 WS_CHILD | WS_VISIBLE | SS_LEFT | SS_NOPREFIX,
-                                 110, 95, 150, 20, hwnd, (HMENU)ID_STATUS_TEXT, GetModuleHandle(NULL), NULL);
-    SendMessage(g_hStatusText, WM_SETFONT, (WPARAM)hNormalFont, TRUE);
+    // 状态面板：状态、运行时长、流量与走势图，自绘并按显示器刷新率合并重绘
+    g_hStatusView = CreateStatusView(hwnd, ID_STATUS_VIEW, 20, 85, 740, 56);
+    SendMessage(g_hStatusView, WM_SETFONT, (WPARAM)hNormalFont, TRUE);
 
     // 控制按钮区域 - 优化布局为两行
     // 第一行：主要服务控制按钮
     g_hStartBtn = CreateWindowW(L"BUTTON", L"🚀 启动服务",
                                WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                               20, 130, 110, 35, hwnd, (HMENU)ID_START_BUTTON, GetModuleHandle(NULL), NULL);
+                               20, 150, 110, 35, hwnd, (HMENU)ID_START_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(g_hStartBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
     g_hStopBtn = CreateWindowW(L"BUTTON", L"⏹️ 停止服务",
                               WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                              140, 130, 110, 35, hwnd, (HMENU)ID_STOP_BUTTON, GetModuleHandle(NULL), NULL);
+                              140, 150, 110, 35, hwnd, (HMENU)ID_STOP_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(g_hStopBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
     g_hRestartBtn = CreateWindowW(L"BUTTON", L"🔄 重启服务",
                                  WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                                 260, 130, 110, 35, hwnd, (HMENU)ID_RESTART_BUTTON, GetModuleHandle(NULL), NULL);
+                                 260, 150, 110, 35, hwnd, (HMENU)ID_RESTART_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(g_hRestartBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
     HWND hRefreshBtn = CreateWindowW(L"BUTTON", L"🔍 刷新状态",
                                     WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                                    380, 130, 110, 35, hwnd, (HMENU)ID_REFRESH_BUTTON, GetModuleHandle(NULL), NULL);
+                                    380, 150, 110, 35, hwnd, (HMENU)ID_REFRESH_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(hRefreshBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
+    HWND hDiagnosticsBtn = CreateWindowW(L"BUTTON", L"⏱️ 诊断",
+                                        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                                        500, 150, 110, 35, hwnd, (HMENU)ID_DIAGNOSTICS_BUTTON, GetModuleHandle(NULL), NULL);
+    SendMessage(hDiagnosticsBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
+
     // 第二行：配置和工具按钮
     g_hConfigBtn = CreateWindowW(L"BUTTON", L"⚙️ 打开配置",
                                 WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                                20, 175, 110, 35, hwnd, (HMENU)ID_CONFIG_BUTTON, GetModuleHandle(NULL), NULL);
+                                20, 195, 110, 35, hwnd, (HMENU)ID_CONFIG_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(g_hConfigBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
     HWND hFontBtn = CreateWindowW(L"BUTTON", L"🎨 字体设置",
                                  WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
-                                 140, 175, 110, 35, hwnd, (HMENU)ID_FONT_BUTTON, GetModuleHandle(NULL), NULL);
+                                 140, 195, 110, 35, hwnd, (HMENU)ID_FONT_BUTTON, GetModuleHandle(NULL), NULL);
     SendMessage(hFontBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
 
+    HWND hHardRestartBtn = CreateWindowW(L"BUTTON", L"💥 强制重启",
+                                        WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                                        260, 195, 110, 35, hwnd, (HMENU)ID_HARD_RESTART_BUTTON, GetModuleHandle(NULL), NULL);
+    SendMessage(hHardRestartBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
+
+    HWND hAffinityBtn = CreateWindowW(L"BUTTON", L"🧭 CPU 绑定",
+                                     WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                                     380, 195, 110, 35, hwnd, (HMENU)ID_AFFINITY_BUTTON, GetModuleHandle(NULL), NULL);
+    SendMessage(hAffinityBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
+
+    HWND hLoadTestBtn = CreateWindowW(L"BUTTON", L"📊 压测",
+                                     WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                                     500, 195, 110, 35, hwnd, (HMENU)ID_LOADTEST_BUTTON, GetModuleHandle(NULL), NULL);
+    SendMessage(hLoadTestBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
+
+    HWND hLogQueryBtn = CreateWindowW(L"BUTTON", L"🔎 日志查询",
+                                     WS_CHILD | WS_VISIBLE | BS_PUSHBUTTON,
+                                     620, 195, 110, 35, hwnd, (HMENU)ID_LOGQUERY_BUTTON, GetModuleHandle(NULL), NULL);
+    SendMessage(hLogQueryBtn, WM_SETFONT, (WPARAM)hButtonFont, TRUE);
+
     // 日志区域 - 调整位置以适应两行按钮
     HWND hLogLabel = CreateWindowW(L"STATIC", L"操作日志:",
                                   WS_CHILD | WS_VISIBLE,
-                                  20, 225, 100, 20, hwnd, NULL, GetModuleHandle(NULL), NULL);
+                                  20, 245, 100, 20, hwnd, NULL, GetModuleHandle(NULL), NULL);
     SendMessage(hLogLabel, WM_SETFONT, (WPARAM)hNormalFont, TRUE);
 
-    // 加载 Rich Edit 库
-    LoadLibraryW(L"riched20.dll");
-
-    g_hLogEdit = CreateWindowW(RICHEDIT_CLASSW, L"",
-                              WS_CHILD | WS_VISIBLE | WS_BORDER | ES_MULTILINE | ES_AUTOVSCROLL | ES_READONLY | WS_VSCROLL,
-                              20, 250, 740, 285, hwnd, (HMENU)ID_LOG_EDIT, GetModuleHandle(NULL), NULL);
+    // 自绘日志面板：只绘制可见行，数据来自 g_logModel
+    g_hLogView = CreateLogView(hwnd, ID_LOG_VIEW, 20, 270, 740, 265, &g_logModel);
+    LogViewSetHistorySource(g_hLogView, LoadLogHistory);
 
     // 设置日志字体为等宽字体 - 使用配置值
     HFONT hLogFont = CreateFontW(
@@ -351,7 +670,7 @@ void CreateControls(HWND hwnd) {
         DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
         CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Consolas"
     );
-    SendMessage(g_hLogEdit, WM_SETFONT, (WPARAM)hLogFont, TRUE);
+    SendMessage(g_hLogView, WM_SETFONT, (WPARAM)hLogFont, TRUE);
 
     // 应用现代化样式
     ApplyModernStyling();
@@ -359,23 +678,10 @@ void CreateControls(HWND hwnd) {
 
 // 加载配置
 void LoadConfiguration() {
-    // 获取当前程序目录
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(NULL, exePath, MAX_PATH);
-    std::wstring configPath = exePath;
-    size_t lastSlash = configPath.find_last_of(L"\\");
-    if (lastSlash != std::wstring::npos) {
-        configPath = configPath.substr(0, lastSlash + 1) + CONFIG_FILE;
-    } else {
-        configPath = CONFIG_FILE;
-    }
+    std::wstring path = StringToWString(g_settings.GetString("Settings", "NginxPath", ""));
 
-    // 使用 Windows API 读取配置
-    wchar_t buffer[MAX_PATH];
-    DWORD result = GetPrivateProfileStringW(L"Settings", L"NginxPath", L"", buffer, MAX_PATH, configPath.c_str());
-
-    if (result > 0) {
-        g_nginxPath = buffer;
+    if (!path.empty()) {
+        SetNginxPath(path);
         if (g_hPathEdit) {
             SetWindowTextW(g_hPathEdit, g_nginxPath.c_str());
         }
@@ -384,28 +690,41 @@ void LoadConfiguration() {
     } else {
         AddColoredLogMessage(L"未找到配置文件，使用默认设置", RGB(128, 128, 128)); // 灰色
     }
+
+    LoadInstances();
+}
+
+// 读取额外登记的实例：[Instances] 节中的 Prefix1、Prefix2 ... 与可选的 Conf1、Conf2 ...
+void LoadInstances() {
+    for (int i = 1;; ++i) {
+        std::string index = std::to_string(i);
+        std::string prefix = g_settings.GetString("Instances", "Prefix" + index, "");
+        if (prefix.empty()) break;
+        g_instances.Add(prefix, g_settings.GetString("Instances", "Conf" + index, ""));
+    }
+
+    if (g_instances.Size() > 0) {
+        wchar_t logMsg[128];
+        swprintf(logMsg, 128, L"已登记 %zu 个附加实例", g_instances.Size());
+        AddColoredLogMessage(logMsg, RGB(0, 100, 200)); // 蓝色
+    }
 }
 
-// 保存配置
+// 保存配置：只修改内存中的设置，由后台线程在输入停顿后统一落盘（可在每次按键时调用）
 void SaveConfiguration() {
-    // 获取当前程序目录
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(NULL, exePath, MAX_PATH);
-    std::wstring configPath = exePath;
-    size_t lastSlash = configPath.find_last_of(L"\\");
-    if (lastSlash != std::wstring::npos) {
-        configPath = configPath.substr(0, lastSlash + 1) + CONFIG_FILE;
-    } else {
-        configPath = CONFIG_FILE;
-    }
+    g_settings.SetString("Settings", "NginxPath", WStringToString(GetNginxPath()));
+}
 
-    // 使用 Windows API 保存配置
-    BOOL result = WritePrivateProfileStringW(L"Settings", L"NginxPath", g_nginxPath.c_str(), configPath.c_str());
-    if (result) {
+// 设置落盘结果（后台线程中调用）：只在失败以及从失败中恢复时记录日志
+void OnSettingsFlushed(bool ok, const std::string& error) {
+    static bool failing = false;
+    if (!ok && !failing) {
+        std::wstring logMsg = L"✗ 配置保存失败: " + StringToWString(error);
+        AddColoredLogMessage(logMsg.c_str(), RGB(220, 20, 60)); // 红色
+    } else if (ok && failing) {
         AddColoredLogMessage(L"配置已保存", RGB(0, 100, 200)); // 蓝色
-    } else {
-        AddColoredLogMessage(L"配置保存失败", RGB(220, 20, 60)); // 红色
     }
+    failing = !ok;
 }
 
 // 打开配置文件
@@ -448,10 +767,113 @@ void OpenConfig() {
     }
 }
 
+// 规划 worker 的 CPU 绑定（界面线程）：发现拓扑并生成计划，确认后在后台写入 nginx.conf
+void PlanCpuAffinity() {
+    if (g_nginxPath.empty()) {
+        MessageBoxW(g_hMainWnd, L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
+        return;
+    }
+
+    CpuTopology topology;
+    std::string error;
+    if (!topology.Discover(&error)) {
+        std::wstring logMsg = L"✗ 无法获取 CPU 拓扑: " + StringToWString(error);
+        AddColoredLogMessage(logMsg.c_str(), RGB(220, 20, 60)); // 红色
+        return;
+    }
+    AffinityPlan plan = PlanWorkerAffinity(topology, AffinityOptions());
+    std::wstring logMsg = L"CPU 拓扑: " + StringToWString(topology.Summary());
+    AddColoredLogMessage(logMsg.c_str(), RGB(0, 100, 200)); // 蓝色
+    if (plan.cpus.empty()) {
+        AddColoredLogMessage(L"✗ 没有可用于绑定的 CPU", RGB(220, 20, 60)); // 红色
+        return;
+    }
+    logMsg = L"绑定计划: " + StringToWString(plan.workerProcesses) + L" 个 worker，依次绑定 CPU " +
+             StringToWString(FormatCpuList(plan.cpus)) + L" (每个物理核心一个，轮流分布在各 NUMA 节点与 L3 域)";
+    AddColoredLogMessage(logMsg.c_str(), RGB(128, 128, 128)); // 灰色
+
+    // 掩码较长时只在确认框中显示前几个
+    std::string masks = plan.cpuAffinity;
+    if (masks.size() > 200) masks = masks.substr(0, 200) + " ...";
+    std::wstring prompt = L"将在 nginx.conf 中写入:\n\nworker_processes " + StringToWString(plan.workerProcesses) +
+                          L";\nworker_cpu_affinity " + StringToWString(masks) +
+                          L";\n\n写入后会用 nginx -t 校验，不通过时自动恢复原内容；nginx 正在运行时随即重新加载。\n"
+                          L"注意: Windows 版 nginx 会忽略 worker_cpu_affinity，该计划用于 Linux 部署。\n\n是否写入并打开配置文件？";
+    if (MessageBoxW(g_hMainWnd, prompt.c_str(), L"CPU 绑定", MB_YESNO | MB_ICONQUESTION) != IDYES) return;
+
+    g_opQueue.Submit(OP_APPLY_AFFINITY, 0, [plan](OperationContext& context) { ApplyCpuAffinity(context, plan); });
+}
+
+// 写入 CPU 绑定计划（在后台线程中执行）：nginx -t 不通过时恢复原配置，
+// 正在运行时重新加载并核对 worker 的实际绑定，完成后打开配置文件
+void ApplyCpuAffinity(const OperationContext& context, const AffinityPlan& plan) {
+    SyncServicePrefix();
+    ServiceOutcome outcome = g_service.ApplyCpuAffinity(context, plan);
+    if (outcome.changed && g_service.IsRunning()) {
+        UpdateStatus();
+        RecordServiceEvent("reload", outcome.ok, outcome.latencyMicros);
+        RescanAfterServiceChange();
+    }
+    if (!outcome.ok || context.IsCancelled()) return;
+
+    if (!g_service.IsRunning()) {
+        AddColoredLogMessage(L"✓ CPU 绑定计划已写入配置，启动服务后生效", RGB(34, 139, 34)); // 绿色
+    }
+    // 沿用"打开配置"的流程，便于查看与调整写入的内容
+    PostMessageW(g_hMainWnd, WM_COMMAND, MAKEWPARAM(ID_CONFIG_BUTTON, BN_CLICKED), 0);
+}
+
 // 刷新状态
 void RefreshStatus() {
     UpdateStatus();
     AddColoredLogMessage(L"状态已刷新", RGB(0, 100, 200)); // 蓝色
+
+    // 运行中时列出 master 与各 worker 最近一秒的资源占用
+    ProcessUsageSnapshot usage;
+    g_processSampler.Snapshot(&usage);
+    if (!usage.ready) return;
+    for (const ProcessUsage& process : usage.processes) {
+        wchar_t handles[16] = L"-";
+        wchar_t switches[32] = L"-";
+        if (process.handlesKnown) swprintf(handles, 16, L"%u", process.handles);
+        if (process.switchesKnown) swprintf(switches, 32, L"%.0f/s", process.switchesPerSec);
+        wchar_t line[256];
+        swprintf(line, 256, L"  %ls PID %u: CPU %.1f%% · 内存 %.1f MB · 句柄 %ls · 上下文切换 %ls",
+                 process.master ? L"master" : L"worker", process.pid, process.cpuPercent,
+                 process.rssBytes / 1048576.0, handles, switches);
+        AddColoredLogMessage(line, RGB(128, 128, 128)); // 灰色
+    }
+
+    // 配置了 worker_cpu_affinity 时顺带核对各 worker 的实际绑定
+    g_service.VerifyAffinity();
+
+    // 各 upstream 的健康检查结果，不可用的 server 逐条列出原因
+    HealthSnapshot health = g_healthProber.Snapshot();
+    if (!health.running) return;
+    if (!health.error.empty()) {
+        std::wstring logMsg = L"upstream 健康检查: 配置解析失败: " + StringToWString(health.error);
+        AddColoredLogMessage(logMsg.c_str(), RGB(255, 140, 0)); // 橙色
+    }
+    for (const UpstreamStatus& upstream : health.upstreams) {
+        wchar_t line[512];
+        swprintf(line, 512, L"upstream %ls%ls: %u 可用 · %u 不可用 · %u 待探测%ls",
+                 StringToWString(upstream.name).c_str(), upstream.stream ? L" (stream)" : L"", upstream.up,
+                 upstream.down, upstream.unknown, upstream.skipped > 0 ? L" · 另有未探测的 server" : L"");
+        AddColoredLogMessage(line, upstream.down > 0 ? RGB(255, 140, 0) : RGB(0, 100, 200)); // 橙色 / 蓝色
+        for (const UpstreamServerStatus& server : upstream.servers) {
+            std::wstring address = StringToWString(server.address) + (server.backup ? L" (backup)" : L"");
+            if (server.health == UPSTREAM_UP) {
+                swprintf(line, 512, L"  ✓ %ls  %.1f ms", address.c_str(), server.latencyMicros / 1000.0);
+                AddColoredLogMessage(line, RGB(128, 128, 128)); // 灰色
+            } else if (server.health == UPSTREAM_DOWN) {
+                swprintf(line, 512, L"  ✗ %ls  %ls", address.c_str(), StringToWString(server.error).c_str());
+                AddColoredLogMessage(line, RGB(220, 20, 60)); // 红色
+            } else {
+                swprintf(line, 512, L"  ? %ls  尚未确定", address.c_str());
+                AddColoredLogMessage(line, RGB(128, 128, 128)); // 灰色
+            }
+        }
+    }
 }
 
 // 浏览文件夹
@@ -466,128 +888,215 @@ void BrowseForPath() {
     LPITEMIDLIST pidl = SHBrowseForFolderW(&bi);
     if (pidl) {
         if (SHGetPathFromIDListW(pidl, folderPath)) {
-            g_nginxPath = folderPath;
+            SetNginxPath(folderPath);
             SetWindowTextW(g_hPathEdit, g_nginxPath.c_str());
             SaveConfiguration();
             std::wstring logMsg = L"已设置 Nginx 路径: " + g_nginxPath;
             AddColoredLogMessage(logMsg.c_str(), RGB(0, 100, 200)); // 蓝色
-            UpdateStatus();
+            SubmitOperation(OP_UPDATE_STATUS);
         }
         CoTaskMemFree(pidl);
     }
 }
 
-// 启动 nginx
-void StartNginx() {
-    if (g_nginxPath.empty()) {
-        MessageBoxW(g_hMainWnd, L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
-        return;
-    }
+// 以下服务操作都交给 NginxService（与无界面模式同一套流程），
+// 这里只负责界面上的状态、提示框、崩溃监护与各采样线程的重新发现
 
-    if (IsNginxRunning()) {
-        AddColoredLogMessage(L"Nginx 已经在运行中", RGB(255, 140, 0)); // 橙色
+// 启动 nginx（在后台线程中执行）
+void StartNginx(const OperationContext& context) {
+    if (GetNginxPath().empty()) {
+        ShowMessageSafe(L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
         return;
     }
+    // 设置启动中状态（已在运行时 Start 只记录提示）
+    if (!IsNginxRunning()) SetStatus(L"启动中...", RGB(255, 140, 0)); // 橙色
 
-    // 设置启动中状态
-    SetStatusColor(RGB(255, 140, 0)); // 橙色
-    SetStatusTextSafe(L"启动中...");
+    ServiceOutcome outcome = g_service.Start(context);
+    if (outcome.ok && outcome.masterPid) g_supervisor.Watch(outcome.masterPid, g_service.PidFile());
+    UpdateStatus();
+    if (outcome.configRejected) {
+        ShowMessageSafe(L"nginx 配置校验失败，请查看日志中的错误信息", L"错误", MB_OK | MB_ICONERROR);
+    }
+    if (!outcome.changed) return;
 
-    AddColoredLogMessage(L"正在启动 nginx...", RGB(0, 100, 200)); // 蓝色
+    RecordServiceEvent("start", outcome.ok, outcome.latencyMicros);
+    RescanAfterServiceChange();
+    if (!outcome.ok) ShowMessageSafe(L"Nginx 启动失败，请检查配置和日志", L"错误", MB_OK | MB_ICONERROR);
+}
 
-    std::wstring command = L"cd /d \"" + g_nginxPath + L"\" && start /B nginx.exe";
-    ExecuteCommand(command.c_str());
+// 停止 nginx（在后台线程中执行）
+void StopNginx(const OperationContext& context) {
+    // 主动停止：先解除监护（也取消退避中的自动重启），否则结束进程会被当作崩溃
+    g_supervisor.Unwatch();
+    if (IsNginxRunning()) {
+        // 设置停止中状态
+        SetStatus(L"停止中...", RGB(255, 140, 0)); // 橙色
+    }
 
-    Sleep(2000);
+    ServiceOutcome outcome = g_service.Stop(context);
     UpdateStatus();
+    if (!outcome.changed) return;
 
-    if (IsNginxRunning()) {
-        AddColoredLogMessage(L"✓ Nginx 启动成功", RGB(34, 139, 34)); // 绿色
-    } else {
-        AddColoredLogMessage(L"✗ Nginx 启动失败", RGB(220, 20, 60)); // 红色
-        MessageBoxW(g_hMainWnd, L"Nginx 启动失败，请检查配置和日志", L"错误", MB_OK | MB_ICONERROR);
-    }
+    RecordServiceEvent("stop", outcome.ok, outcome.latencyMicros);
+    if (!outcome.ok) ShowMessageSafe(L"Nginx 停止失败，可能需要管理员权限", L"错误", MB_OK | MB_ICONERROR);
 }
 
-// 停止 nginx
-void StopNginx() {
-    if (!IsNginxRunning()) {
-        AddColoredLogMessage(L"Nginx 未运行", RGB(255, 140, 0)); // 橙色
+// 重启 nginx（在后台线程中执行）
+// 默认通过优雅重载完成，只有用户明确要求时才强制结束进程再冷启动
+void RestartNginx(const OperationContext& context, bool hardRestart) {
+    if (GetNginxPath().empty()) {
+        ShowMessageSafe(L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
         return;
     }
 
-    // 设置停止中状态
-    SetStatusColor(RGB(255, 140, 0)); // 橙色
-    SetStatusTextSafe(L"停止中...");
+    bool reload = !hardRestart && IsNginxRunning();
+    SetStatus(reload ? L"重新加载中..." : L"重启中...", RGB(255, 140, 0)); // 橙色
 
-    AddColoredLogMessage(L"正在停止 nginx...", RGB(0, 100, 200)); // 蓝色
-    ExecuteCommand(L"taskkill /F /IM nginx.exe");
-    Sleep(1000);
+    // 强制重启会结束正在运行的 master，先解除监护；校验失败时原来的 master 仍在运行，下面重新纳入监护
+    if (hardRestart) g_supervisor.Unwatch();
+    ServiceOutcome outcome = g_service.Restart(context, hardRestart);
+    ProcessId master = g_service.MasterPid();
+    if (master) g_supervisor.Watch(master, g_service.PidFile());
     UpdateStatus();
+    if (outcome.configRejected) {
+        ShowMessageSafe(L"nginx 配置校验失败，请查看日志中的错误信息", L"错误", MB_OK | MB_ICONERROR);
+    }
+    if (!outcome.changed) return;
 
-    if (!IsNginxRunning()) {
-        AddColoredLogMessage(L"✓ Nginx 停止成功", RGB(34, 139, 34)); // 绿色
-    } else {
-        AddColoredLogMessage(L"✗ Nginx 停止失败", RGB(220, 20, 60)); // 红色
-        MessageBoxW(g_hMainWnd, L"Nginx 停止失败，可能需要管理员权限", L"错误", MB_OK | MB_ICONERROR);
+    RecordServiceEvent(reload ? "reload" : hardRestart ? "hard-restart" : "restart", outcome.ok, outcome.latencyMicros);
+    RescanAfterServiceChange();
+    if (!outcome.ok && !reload) {
+        ShowMessageSafe(L"Nginx 重启失败，请检查配置和日志", L"错误", MB_OK | MB_ICONERROR);
     }
 }
 
-// 重启 nginx
-void RestartNginx() {
-    if (g_nginxPath.empty()) {
-        MessageBoxW(g_hMainWnd, L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
-        return;
+// 配置修改后自动校验并重新加载（在后台线程中执行）：不弹提示框，结果与保存到生效的耗时记录在日志中
+void ApplyConfigChange(const OperationContext& context) {
+    ConfigChange change;
+    {
+        std::lock_guard<std::mutex> lock(g_confChangeMutex);
+        change = g_confChange;
+        g_confChange = ConfigChange();
     }
-
-    // 设置重启中状态
-    SetStatusColor(RGB(255, 140, 0)); // 橙色
-    SetStatusTextSafe(L"重启中...");
-
-    AddColoredLogMessage(L"正在重启 nginx...", RGB(0, 100, 200)); // 蓝色
-
-    if (IsNginxRunning()) {
-        ExecuteCommand(L"taskkill /F /IM nginx.exe");
-        Sleep(1000);
+    if (GetNginxPath().empty()) return;
+    SyncServicePrefix();
+
+    uint64_t begin = MonotonicMicros();
+    ServiceOutcome outcome = g_service.ApplyConfigChange(context);
+    if (!outcome.changed) return;
+
+    uint64_t live = MonotonicMicros();
+    uint64_t latencyMicros = change.firstMicros ? live - change.firstMicros : outcome.latencyMicros;
+    if (outcome.ok && change.firstMicros) {
+        wchar_t logMsg[256];
+        swprintf(logMsg, 256, L"✓ 配置修改已生效: 保存到新 worker 接管 %.1f ms (防抖 %.1f ms, 排队 %.1f ms, 校验与重新加载 %.1f ms)",
+                 latencyMicros / 1000.0, (change.settledMicros - change.firstMicros) / 1000.0,
+                 (begin - change.settledMicros) / 1000.0, (live - begin) / 1000.0);
+        AddColoredLogMessage(logMsg, RGB(34, 139, 34)); // 绿色
     }
+    RecordServiceEvent("conf-reload", outcome.ok, latencyMicros);
+    UpdateStatus();
+    RescanAfterServiceChange();
+}
 
-    std::wstring command = L"cd /d \"" + g_nginxPath + L"\" && start /B nginx.exe";
-    ExecuteCommand(command.c_str());
-    Sleep(2000);
+// 自动恢复（在后台线程中执行）：崩溃监护退避结束后提交，结果回报给监护线程
+void RecoverNginx(const OperationContext& context) {
+    SetStatus(L"自动恢复中...", RGB(255, 140, 0)); // 橙色
 
+    ServiceOutcome outcome;
+    if (GetNginxPath().empty()) {
+        outcome.detail = "未设置 nginx 路径";
+    } else {
+        SyncServicePrefix();
+        outcome = g_service.Recover(context);
+    }
+    // 被取代时由 OnOperationComplete 处理
+    if (outcome.ok && outcome.masterPid) {
+        g_supervisor.RestartSucceeded(outcome.masterPid, g_service.PidFile());
+    } else if (!context.IsCancelled()) {
+        g_supervisor.RestartFailed(outcome.detail.empty() ? "启动失败" : outcome.detail);
+    }
     UpdateStatus();
+    if (outcome.changed) RescanAfterServiceChange();
+}
 
-    if (IsNginxRunning()) {
-        AddColoredLogMessage(L"✓ Nginx 重启成功", RGB(34, 139, 34)); // 绿色
-    } else {
-        AddColoredLogMessage(L"✗ Nginx 重启失败", RGB(220, 20, 60)); // 红色
-        MessageBoxW(g_hMainWnd, L"Nginx 重启失败，请检查配置和日志", L"错误", MB_OK | MB_ICONERROR);
+// NginxService 的进度与结果日志：按级别着色，nginx -t 等多行输出逐行缩进显示
+void OnServiceLog(LogSeverity severity, const std::string& text) {
+    COLORREF color = LogSeverityColor(severity);
+    if (text.find('\n') == std::string::npos) {
+        AddColoredLogMessage(StringToWString(text).c_str(), color);
+        return;
+    }
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(begin, end - begin);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) {
+            std::wstring wline = L"    " + StringToWString(line);
+            AddColoredLogMessage(wline.c_str(), color);
+        }
+        begin = end + 1;
     }
 }
 
+// 启动 / 停止 / 重启 / 重新加载后 master 与 worker 已更替，各采样线程重新查找
+void RescanAfterServiceChange() {
+    g_accessLog.Rediscover();
+    g_stubStatus.Rediscover();
+    g_processSampler.Rescan();
+    g_logRotator.Rescan();
+    g_healthProber.Rediscover();
+}
+
 // 更新状态
 void UpdateStatus() {
     bool isRunning = IsNginxRunning();
     std::wstring statusText;
 
+    // 本程序启动前已在运行、或由命令行启动的 nginx 也纳入监护
+    if (isRunning && g_supervisor.State() == SUPERVISOR_IDLE) {
+        g_supervisor.Watch(g_service.MasterPid(), g_service.PidFile());
+    }
+
+    COLORREF statusColor;
+
     if (isRunning) {
-        statusText = L"运行中        "; // 添加空格确保清除旧文本
-        SetStatusColor(RGB(34, 139, 34)); // 绿色
+        statusText = L"运行中";
+        statusColor = RGB(34, 139, 34); // 绿色
     } else {
-        statusText = L"已停止        "; // 添加空格确保清除旧文本
-        SetStatusColor(RGB(220, 20, 60)); // 红色
+        statusText = L"已停止";
+        statusColor = RGB(220, 20, 60); // 红色
     }
 
-    // 使用安全的状态文本设置函数
-    SetStatusTextSafe(statusText.c_str());
+    SetStatus(statusText.c_str(), statusColor);
 }
 
-// 设置状态颜色
-void SetStatusColor(COLORREF color) {
+// 设置状态文本和颜色，可在任意线程调用
+void SetStatus(const wchar_t* text, COLORREF color) {
+    if (!IsUiThread()) {
+        UiPost* post = new UiPost();
+        post->text = text;
+        post->color = color;
+        if (!PostMessageW(g_hMainWnd, WM_APP_STATUS, 0, (LPARAM)post)) delete post;
+        return;
+    }
     g_statusColor = color;
-    if (g_hStatusText) {
-        InvalidateRect(g_hStatusText, NULL, TRUE);
+    StatusViewSetState(g_hStatusView, text, color);
+}
+
+// 显示消息框，可在任意线程调用（后台线程中异步显示）
+void ShowMessageSafe(const wchar_t* text, const wchar_t* caption, UINT type) {
+    if (!IsUiThread()) {
+        UiPost* post = new UiPost();
+        post->text = text;
+        post->caption = caption;
+        post->type = type;
+        if (!PostMessageW(g_hMainWnd, WM_APP_MESSAGEBOX, 0, (LPARAM)post)) delete post;
+        return;
     }
+    MessageBoxW(g_hMainWnd, text, caption, type);
 }
 
 // 添加日志消息（默认黑色）
@@ -595,56 +1104,446 @@ void AddLogMessage(const wchar_t* message) {
     AddColoredLogMessage(message, RGB(0, 0, 0)); // 黑色
 }
 
-// 添加彩色日志消息
+// 日志颜色对应的级别（沿用各处调用传入的颜色约定）
+LogSeverity SeverityFromColor(COLORREF color) {
+    switch (color) {
+        case RGB(128, 128, 128): return LOG_DETAIL;
+        case RGB(0, 100, 200): return LOG_INFO;
+        case RGB(34, 139, 34): return LOG_SUCCESS;
+        case RGB(255, 140, 0): return LOG_WARNING;
+        case RGB(220, 20, 60): return LOG_ERROR;
+        default: return LOG_PLAIN;
+    }
+}
+
+// 添加彩色日志消息（任意线程）
+// 先追加到持久化日志，再写入环形日志模型，面板在下一次重绘时统一显示，多条日志合并为一次刷新
 void AddColoredLogMessage(const wchar_t* message, COLORREF color) {
-    SYSTEMTIME st;
-    GetLocalTime(&st);
+    LogSeverity severity = SeverityFromColor(color);
+    std::string text = WStringToString(message);
+    int64_t utc = UtcTimeMicros();
+    uint64_t origin = 0;
+    g_journal.Append(JOURNAL_LOG, (uint8_t)severity, 0, text, utc, &origin);
+    g_logModel.Append(severity, text, utc + LocalOffsetMicros(), origin);
+    LogViewNotify(g_hLogView);
+}
 
-    wchar_t timeStr[32];
-    swprintf(timeStr, 32, L"[%02d:%02d:%02d] ", st.wHour, st.wMinute, st.wSecond);
+// 记录服务事件（启动 / 停止 / 重启 / 重新加载）及其耗时，供日后按时间查询
+void RecordServiceEvent(const char* name, bool ok, uint64_t latencyMicros) {
+    g_journal.Append(JOURNAL_EVENT, (uint8_t)(ok ? LOG_SUCCESS : LOG_ERROR), (int64_t)latencyMicros, name,
+                     UtcTimeMicros());
+}
 
-    // 移动到文本末尾
-    SendMessage(g_hLogEdit, EM_SETSEL, -1, -1);
+// 配置监视，来自配置文件 [ConfigWatch] 节
+ConfigWatchOptions LoadConfigWatchOptions() {
+    ConfigWatchOptions options;
+    options.enabled = g_settings.GetInt("ConfigWatch", "Enabled", 1) != 0;
+    int debounce = g_settings.GetInt("ConfigWatch", "DebounceMs", 300);
+    options.debounceMs = debounce > 0 ? (uint32_t)debounce : 0;
+    return options;
+}
 
-    // 设置时间戳颜色（灰色）
-    CHARFORMAT2W cf;
-    ZeroMemory(&cf, sizeof(cf));
-    cf.cbSize = sizeof(cf);
-    cf.dwMask = CFM_COLOR;
-    cf.crTextColor = RGB(128, 128, 128);
-    SendMessage(g_hLogEdit, EM_SETCHARFORMAT, SCF_SELECTION, (LPARAM)&cf);
-    SendMessage(g_hLogEdit, EM_REPLACESEL, FALSE, (LPARAM)timeStr);
+// 配置目录有修改（配置监视线程中调用）：合并到尚未处理的修改中，同类操作排队时自动合并
+void OnConfigChange(const ConfigChange& change) {
+    std::wstring text = L"检测到配置修改: " + StringToWString(FormatConfigChange(change));
+    AddColoredLogMessage(text.c_str(), RGB(0, 100, 200)); // 蓝色
+    {
+        std::lock_guard<std::mutex> lock(g_confChangeMutex);
+        if (g_confChange.firstMicros == 0) {
+            g_confChange = change;
+        } else {
+            g_confChange.events += change.events;
+            g_confChange.settledMicros = change.settledMicros;
+        }
+    }
+    SubmitOperation(OP_CONF_CHANGE);
+}
 
-    // 设置消息颜色
-    cf.crTextColor = color;
-    SendMessage(g_hLogEdit, EM_SETCHARFORMAT, SCF_SELECTION, (LPARAM)&cf);
-    SendMessage(g_hLogEdit, EM_REPLACESEL, FALSE, (LPARAM)message);
+// 日志轮转策略，来自配置文件 [LogRotation] 节（大小以 MB 计，0 表示不限）
+LogRotationPolicy LoadLogRotationPolicy() {
+    // 负数按 0 处理
+    auto count = [](const char* key, int defaultValue) {
+        int value = g_settings.GetInt("LogRotation", key, defaultValue);
+        return value > 0 ? (uint32_t)value : 0u;
+    };
+    LogRotationPolicy policy;
+    policy.enabled = g_settings.GetInt("LogRotation", "Enabled", 1) != 0;
+    policy.maxBytes = (uint64_t)count("MaxSizeMB", 256) << 20;
+    policy.maxAgeSeconds = count("MaxAgeHours", 0) * 3600;
+    policy.keepFiles = count("KeepFiles", 14);
+    policy.keepBytes = (uint64_t)count("KeepMB", 0) << 20;
+    policy.compress = g_settings.GetInt("LogRotation", "Compress", 1) != 0;
+    policy.compressBytesPerSec = (uint64_t)count("CompressMBps", 32) << 20;
+    return policy;
+}
 
-    // 添加换行
-    SendMessage(g_hLogEdit, EM_REPLACESEL, FALSE, (LPARAM)L"\r\n");
+// upstream 健康检查参数，来自配置文件 [HealthCheck] 节（HttpPath 为空时只检查 TCP 连接）
+HealthCheckOptions LoadHealthCheckOptions() {
+    HealthCheckOptions options;
+    options.enabled = g_settings.GetInt("HealthCheck", "Enabled", 1) != 0;
+    int interval = g_settings.GetInt("HealthCheck", "IntervalSec", 5);
+    int timeout = g_settings.GetInt("HealthCheck", "TimeoutMs", 2000);
+    int threshold = g_settings.GetInt("HealthCheck", "FailThreshold", 2);
+    options.intervalMs = (uint32_t)(interval > 0 ? interval : 5) * 1000;
+    options.timeoutMs = timeout > 0 ? (uint32_t)timeout : 2000;
+    options.failThreshold = threshold > 0 ? (uint32_t)threshold : 1;
+    options.httpPath = g_settings.GetString("HealthCheck", "HttpPath", "");
+    return options;
+}
 
-    // 滚动到底部
-    SendMessage(g_hLogEdit, EM_SCROLLCARET, 0, 0);
+// upstream 的 server 健康状态变化（健康检查线程中调用）
+void OnHealthEvent(const HealthEvent& event) {
+    std::wstring text = StringToWString(FormatHealthEvent(event));
+    if (event.health == UPSTREAM_UP) {
+        AddColoredLogMessage(text.c_str(), RGB(34, 139, 34)); // 绿色
+    } else {
+        AddColoredLogMessage(text.c_str(), RGB(220, 20, 60)); // 红色
+    }
+    RecordServiceEvent(event.health == UPSTREAM_UP ? "upstream-up" : "upstream-down", event.health == UPSTREAM_UP, 0);
 }
 
-// 加载字体配置
-void LoadFontConfiguration() {
-    // 获取当前程序目录
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(NULL, exePath, MAX_PATH);
-    std::wstring configPath = exePath;
-    size_t lastSlash = configPath.find_last_of(L"\\");
-    if (lastSlash != std::wstring::npos) {
-        configPath = configPath.substr(0, lastSlash + 1) + CONFIG_FILE;
+// 通知当前路径下的 nginx 重新打开日志（轮转线程中调用），使用独立的进程表，不与操作队列争用
+bool ReopenNginxLogs(std::string* error) {
+    std::string prefix = WStringToString(GetNginxPath());
+    ProcessTable table;
+    table.SetPrefix(prefix);
+    table.Refresh();
+    if (table.MasterPid() == 0) return true;
+    return SignalNginx(prefix, table.MasterPid(), NGINX_SIGNAL_REOPEN, error);
+}
+
+// 日志轮转事件（轮转线程中调用）
+void OnLogRotationEvent(const LogRotationEvent& event) {
+    std::wstring text = StringToWString(FormatLogRotationEvent(event));
+    switch (event.type) {
+        case LOG_ROTATED:
+            AddColoredLogMessage(text.c_str(), RGB(34, 139, 34)); // 绿色
+            RecordServiceEvent("rotate", true, event.micros);
+            break;
+        case LOG_ROTATE_FAILED:
+            AddColoredLogMessage(text.c_str(), RGB(220, 20, 60)); // 红色
+            RecordServiceEvent("rotate", false, event.micros);
+            break;
+        case LOG_COMPRESSED:
+        case LOG_PRUNED:
+            AddColoredLogMessage(text.c_str(), RGB(128, 128, 128)); // 灰色
+            break;
+        case LOG_COMPRESS_FAILED:
+            AddColoredLogMessage(text.c_str(), RGB(255, 140, 0)); // 橙色
+            break;
+    }
+}
+
+// 压测参数，来自配置文件 [LoadTest] 节（时长以秒计；Port 为 0 时取配置中第一个 http server 的端口）
+LoadTestOptions LoadLoadTestOptions() {
+    // 负数按 0 处理
+    auto count = [](const char* key, int defaultValue) {
+        int value = g_settings.GetInt("LoadTest", key, defaultValue);
+        return value > 0 ? (uint32_t)value : 0u;
+    };
+    LoadTestOptions options;
+    options.connections = count("Connections", 16);
+    options.threads = count("Threads", 1);
+    options.requestsPerSec = count("Rate", 0);
+    options.durationMs = count("DurationSec", 10) * 1000;
+    options.warmupMs = count("WarmupSec", 1) * 1000;
+    options.path = g_settings.GetString("LoadTest", "Path", "/");
+    options.port = (uint16_t)count("Port", 0);
+    return options;
+}
+
+// 对本机的 nginx 压测（界面线程）：确认参数后在独立线程中运行
+void StartLoadTestUi() {
+    if (g_nginxPath.empty()) {
+        MessageBoxW(g_hMainWnd, L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
+        return;
+    }
+    if (g_loadTestRunning) {
+        AddColoredLogMessage(L"已有压测正在进行，请等待其结束", RGB(255, 140, 0)); // 橙色
+        return;
+    }
+    LoadTestOptions options = LoadLoadTestOptions();
+    if (options.connections == 0 || options.connections > 10000 || options.durationMs == 0) {
+        AddColoredLogMessage(L"✗ 压测参数无效: [LoadTest] 的 Connections 需在 1~10000 之间，DurationSec 不能为 0",
+                             RGB(220, 20, 60)); // 红色
+        return;
+    }
+
+    wchar_t rate[64] = L"不限速";
+    if (options.requestsPerSec) swprintf(rate, 64, L"%u 请求/秒", options.requestsPerSec);
+    wchar_t prompt[512];
+    swprintf(prompt, 512,
+             L"将对本机的 nginx 压测 %u 秒: %u 个长连接, %u 个线程, %ls, 路径 %ls\n\n"
+             L"压测期间 nginx 会满负荷运行，生产环境请选择低峰时段。\n"
+             L"参数可在 nginx-manager.ini 的 [LoadTest] 节修改。\n\n是否开始？",
+             options.durationMs / 1000, options.connections, options.threads, rate,
+             StringToWString(options.path).c_str());
+    if (MessageBoxW(g_hMainWnd, prompt, L"压测", MB_YESNO | MB_ICONQUESTION) != IDYES) return;
+
+    if (g_loadTestThread.joinable()) g_loadTestThread.join();
+    g_loadTestCancel = false;
+    g_loadTestRunning = true;
+    g_loadTestThread = std::thread(RunLoadTestTask, options);
+}
+
+// 压测线程：只访问本机回环地址；结果按配置指纹保存，并与最近一次其他配置的结果对比
+void RunLoadTestTask(LoadTestOptions options) {
+    auto finish = [](const std::wstring& error) {
+        if (!error.empty()) AddColoredLogMessage(error.c_str(), RGB(220, 20, 60)); // 红色
+        g_loadTestRunning = false;
+    };
+    std::string prefix = WStringToString(GetNginxPath());
+    // 使用独立的进程表，不与操作队列争用
+    ProcessTable table;
+    table.SetPrefix(prefix);
+    table.Refresh();
+    if (table.MasterPid() == 0) {
+        finish(L"✗ 压测失败: nginx 未运行");
+        return;
+    }
+    NginxConfig config;
+    std::string error;
+    if (!config.Load(prefix + "\\conf\\nginx.conf", &error)) {
+        finish(L"✗ 压测失败: 配置解析失败: " + StringToWString(error));
+        return;
+    }
+    uint16_t port = options.port;
+    if (!FindLoadTestTarget(config, &options, &error)) {
+        finish(L"✗ 压测失败: " + StringToWString(error));
+        return;
+    }
+    if (port) options.port = port;
+    uint64_t configHash = ConfigFingerprint(config, NginxBinaryPath(prefix));
+
+    wchar_t logMsg[256];
+    swprintf(logMsg, 256, L"开始压测 %ls:%u%ls (配置 %ls)", StringToWString(options.host).c_str(),
+             (unsigned)options.port, StringToWString(options.path).c_str(),
+             StringToWString(FormatConfigHash(configHash)).c_str());
+    AddColoredLogMessage(logMsg, RGB(0, 100, 200)); // 蓝色
+
+    LoadTestResult result;
+    if (!RunLoadTest(options, &g_loadTestCancel, &result, &error)) {
+        RecordServiceEvent("loadtest", false, 0);
+        finish(L"✗ 压测失败: " + StringToWString(error));
+        return;
+    }
+    if (g_loadTestCancel) {
+        finish(L"");
+        return;
+    }
+
+    LoadTestRecord record = MakeLoadTestRecord(configHash, options, result);
+    LoadTestHistory history(prefix + "\\logs\\loadtest");
+    // 保存前取出其他配置最近一次的结果用于对比
+    std::vector<LoadTestRecord> latest = history.Latest();
+    if (!history.Append(record, &error)) {
+        std::wstring text = L"压测结果无法保存: " + StringToWString(error);
+        AddColoredLogMessage(text.c_str(), RGB(255, 140, 0)); // 橙色
+    }
+    std::wstring summary = L"✓ 压测完成: " + StringToWString(FormatLoadTestSummary(result));
+    AddColoredLogMessage(summary.c_str(), result.Errors() ? RGB(255, 140, 0) : RGB(34, 139, 34)); // 有错误时橙色
+    RecordServiceEvent("loadtest", result.Errors() == 0, record.p99);
+
+    for (const LoadTestRecord& previous : latest) {
+        if (previous.configHash == configHash) continue;
+        std::string comparison = FormatLoadTestComparison(previous, record);
+        size_t begin = 0;
+        while (begin < comparison.size()) {
+            size_t end = comparison.find('\n', begin);
+            if (end == std::string::npos) end = comparison.size();
+            std::wstring line = L"    " + StringToWString(comparison.substr(begin, end - begin));
+            AddColoredLogMessage(line.c_str(), RGB(128, 128, 128)); // 灰色
+            begin = end + 1;
+        }
+        break;
+    }
+    finish(L"");
+}
+
+// 访问日志查询（界面线程）：查询条件来自配置文件 [LogStore] 节的 Query，写法同 ngctl logquery 的参数
+void StartLogQueryUi() {
+    if (g_nginxPath.empty()) {
+        MessageBoxW(g_hMainWnd, L"请先设置 nginx 路径", L"警告", MB_OK | MB_ICONWARNING);
+        return;
+    }
+    if (g_logQueryRunning) {
+        AddColoredLogMessage(L"上一次日志查询尚未结束", RGB(255, 140, 0)); // 橙色
+        return;
+    }
+    if (g_logQueryThread.joinable()) g_logQueryThread.join();
+    g_logQueryCancel = false;
+    g_logQueryRunning = true;
+    g_logQueryThread = std::thread(RunLogQueryTask,
+                                   g_settings.GetString("LogStore", "Query", "from=-24h group=uri limit=20"));
+}
+
+// 日志查询线程：导入尚未导入的归档（仍在写入的当前日志不导入），再查询并逐行输出结果表
+void RunLogQueryTask(std::string text) {
+    LogQuery query;
+    std::string error;
+    if (!ParseLogQueryText(text, UtcTimeMicros() / 1000000, &query, &error)) {
+        std::wstring logMsg = L"✗ 日志查询: " + StringToWString(error) + L" ([LogStore] Query)";
+        AddColoredLogMessage(logMsg.c_str(), RGB(220, 20, 60)); // 红色
+        g_logQueryRunning = false;
+        return;
+    }
+    std::string prefix = WStringToString(GetNginxPath());
+    LogStore store(prefix + "\\logs\\store");
+    LogIngestStats stats = store.IngestArchives(CollectAccessLogSources(prefix, prefix + "\\conf\\nginx.conf"),
+                                                &g_logQueryCancel);
+    if (g_logQueryCancel) {
+        g_logQueryRunning = false;
+        return;
+    }
+    if (stats.files > 0 || stats.failed > 0) {
+        std::wstring logMsg = L"访问日志列存: " + StringToWString(FormatLogIngestStats(stats));
+        AddColoredLogMessage(logMsg.c_str(), stats.failed ? RGB(255, 140, 0) : RGB(128, 128, 128));
+    }
+
+    LogQueryResult result = store.Query(query);
+    if (!result.error.empty()) {
+        std::wstring logMsg = L"✗ 日志查询失败: " + StringToWString(result.error);
+        AddColoredLogMessage(logMsg.c_str(), RGB(220, 20, 60)); // 红色
+        g_logQueryRunning = false;
+        return;
+    }
+    std::wstring title = L"🔎 日志查询: " + StringToWString(text);
+    AddColoredLogMessage(title.c_str(), RGB(0, 100, 200)); // 蓝色
+    AddLogTable(FormatLogQueryResult(query, result), RGB(128, 128, 128)); // 灰色
+    g_logQueryRunning = false;
+}
+
+// 多行表格（UTF-8）逐行缩进写入日志
+void AddLogTable(const std::string& table, COLORREF color) {
+    size_t begin = 0;
+    while (begin < table.size()) {
+        size_t end = table.find('\n', begin);
+        if (end == std::string::npos) end = table.size();
+        std::wstring line = L"    " + StringToWString(table.substr(begin, end - begin));
+        AddColoredLogMessage(line.c_str(), color);
+        begin = end + 1;
+    }
+}
+
+// 诊断（界面线程）：追踪关闭时开启；已开启时显示各环节耗时的直方图统计，并在后台导出 Chrome trace JSON
+void ShowDiagnostics() {
+    if (!TraceEnabled()) {
+        TraceEnable(true);
+        AddColoredLogMessage(L"⏱️ 追踪已开启：执行要分析的操作 (如重启服务) 后再次点击\"诊断\"查看各环节耗时",
+                             RGB(0, 100, 200)); // 蓝色
+        return;
+    }
+    AddColoredLogMessage(L"⏱️ 诊断: 各环节耗时 (ms)", RGB(0, 100, 200)); // 蓝色
+    AddLogTable(FormatTraceSummary(CollectTraceSummary()), RGB(128, 128, 128)); // 灰色
+    SubmitOperation(OP_EXPORT_TRACE);
+}
+
+// 导出追踪（在后台线程中执行）：写入 <nginx 目录>\logs\trace-<时间>.json
+void ExportTrace() {
+    std::wstring prefix = GetNginxPath();
+    if (prefix.empty()) {
+        AddColoredLogMessage(L"未设置 nginx 路径，追踪未导出", RGB(255, 140, 0)); // 橙色
+        return;
+    }
+    std::string path = TraceExportPath(WStringToString(prefix) + "\\logs");
+    size_t exported = 0;
+    std::string error;
+    if (ExportChromeTrace(path, &exported, &error)) {
+        std::wstring logMsg = L"✓ 已导出 " + std::to_wstring(exported) + L" 个区间: " + StringToWString(path) +
+                              L" (可在 chrome://tracing 或 ui.perfetto.dev 中打开)";
+        AddColoredLogMessage(logMsg.c_str(), RGB(34, 139, 34)); // 绿色
     } else {
-        configPath = CONFIG_FILE;
+        std::wstring logMsg = L"✗ 追踪导出失败: " + StringToWString(error);
+        AddColoredLogMessage(logMsg.c_str(), RGB(220, 20, 60)); // 红色
     }
+}
+
+// 崩溃监护事件（监护线程中调用）：记录退出原因与恢复耗时，需要重启时提交 OP_RECOVER
+void OnSupervisorEvent(const SupervisorEvent& event) {
+    wchar_t exitText[64] = L"退出码未知";
+    if (event.exitCodeKnown) swprintf(exitText, 64, L"退出码 %d", event.exitCode);
+
+    wchar_t logMsg[256];
+    switch (event.type) {
+        case SUPERVISOR_EXITED:
+            if (event.clean) {
+                swprintf(logMsg, 256, L"Nginx 已退出 (master PID %u, %ls)", event.pid,
+                         event.exitCodeKnown ? exitText : L"已删除 pid 文件");
+                AddColoredLogMessage(logMsg, RGB(128, 128, 128)); // 灰色
+                RecordServiceEvent("exit", true, event.uptimeMicros);
+            } else {
+                if (event.delayMs > 0) {
+                    swprintf(logMsg, 256, L"✗ Nginx 意外退出 (master PID %u, %ls, 运行 %.1f 秒)，%.1f 秒后第 %u 次自动重启",
+                             event.pid, exitText, event.uptimeMicros / 1000000.0, event.delayMs / 1000.0, event.attempt);
+                } else {
+                    swprintf(logMsg, 256, L"✗ Nginx 意外退出 (master PID %u, %ls, 运行 %.1f 秒)", event.pid, exitText,
+                             event.uptimeMicros / 1000000.0);
+                }
+                AddColoredLogMessage(logMsg, RGB(220, 20, 60)); // 红色
+                RecordServiceEvent("crash", false, event.uptimeMicros);
+            }
+            SubmitOperation(OP_UPDATE_STATUS);
+            break;
 
-    // 读取字体配置
-    g_fontConfig.titleSize = GetPrivateProfileIntW(L"Fonts", L"TitleSize", 24, configPath.c_str());
-    g_fontConfig.normalSize = GetPrivateProfileIntW(L"Fonts", L"NormalSize", 18, configPath.c_str());
-    g_fontConfig.buttonSize = GetPrivateProfileIntW(L"Fonts", L"ButtonSize", 16, configPath.c_str());
-    g_fontConfig.logSize = GetPrivateProfileIntW(L"Fonts", L"LogSize", 14, configPath.c_str());
+        case SUPERVISOR_RESTART:
+            SubmitOperation(OP_RECOVER);
+            break;
+
+        case SUPERVISOR_RECOVERED:
+            swprintf(logMsg, 256, L"✓ Nginx 已自动恢复 (master PID %u, 第 %u 次重启, 停机 %.1f ms)", event.pid,
+                     event.attempt, event.downtimeMicros / 1000.0);
+            AddColoredLogMessage(logMsg, RGB(34, 139, 34)); // 绿色
+            RecordServiceEvent("recover", true, event.downtimeMicros);
+            break;
+
+        case SUPERVISOR_RESTART_FAILED:
+            if (event.delayMs > 0) {
+                swprintf(logMsg, 256, L"✗ 第 %u 次自动重启失败: %ls，%.1f 秒后重试", event.attempt,
+                         StringToWString(event.reason).c_str(), event.delayMs / 1000.0);
+            } else {
+                swprintf(logMsg, 256, L"✗ 第 %u 次自动重启失败: %ls", event.attempt,
+                         StringToWString(event.reason).c_str());
+            }
+            AddColoredLogMessage(logMsg, RGB(220, 20, 60)); // 红色
+            RecordServiceEvent("recover", false, 0);
+            break;
+
+        case SUPERVISOR_CRASH_LOOP:
+            swprintf(logMsg, 256, L"✗ Nginx 在短时间内退出 %u 次，判定为崩溃循环，已停止自动重启，请检查配置和错误日志",
+                     event.recentCrashes);
+            AddColoredLogMessage(logMsg, RGB(220, 20, 60)); // 红色
+            RecordServiceEvent("crash-loop", false, 0);
+            SubmitOperation(OP_UPDATE_STATUS);
+            break;
+    }
+}
+
+// 日志面板的历史记录来源：从持久化日志中读取更早的日志行
+size_t LoadLogHistory(uint64_t beforeOrigin, uint64_t afterOrigin, size_t count, std::vector<LogRecord>* records,
+                      std::vector<std::string>* texts) {
+    std::vector<JournalRecord> found;
+    g_journal.ReadBefore(beforeOrigin, afterOrigin, JournalMask(JOURNAL_LOG), count, &found);
+
+    int64_t offset = LocalOffsetMicros();
+    records->resize(found.size());
+    texts->resize(found.size());
+    for (size_t i = 0; i < found.size(); ++i) {
+        LogRecord& record = (*records)[i];
+        record.sequence = 0;
+        record.timeMicros = found[i].timeMicros + offset;
+        record.severity = found[i].severity <= LOG_ERROR ? (LogSeverity)found[i].severity : LOG_PLAIN;
+        record.origin = found[i].sequence;
+        (*texts)[i] = std::move(found[i].text);
+    }
+    return found.size();
+}
+
+// 加载字体配置
+void LoadFontConfiguration() {
+    g_fontConfig.titleSize = g_settings.GetInt("Fonts", "TitleSize", 24);
+    g_fontConfig.normalSize = g_settings.GetInt("Fonts", "NormalSize", 18);
+    g_fontConfig.buttonSize = g_settings.GetInt("Fonts", "ButtonSize", 16);
+    g_fontConfig.logSize = g_settings.GetInt("Fonts", "LogSize", 14);
 
     // 验证字体大小范围
     if (g_fontConfig.titleSize < 12 || g_fontConfig.titleSize > 48) g_fontConfig.titleSize = 24;
@@ -653,79 +1552,204 @@ void LoadFontConfiguration() {
     if (g_fontConfig.logSize < 8 || g_fontConfig.logSize > 24) g_fontConfig.logSize = 14;
 }
 
-// 保存字体配置
+// 保存字体配置（与其他设置合并落盘）
 void SaveFontConfiguration() {
-    // 获取当前程序目录
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(NULL, exePath, MAX_PATH);
-    std::wstring configPath = exePath;
-    size_t lastSlash = configPath.find_last_of(L"\\");
-    if (lastSlash != std::wstring::npos) {
-        configPath = configPath.substr(0, lastSlash + 1) + CONFIG_FILE;
-    } else {
-        configPath = CONFIG_FILE;
-    }
-
-    // 保存字体配置
-    wchar_t buffer[16];
-    swprintf(buffer, 16, L"%d", g_fontConfig.titleSize);
-    WritePrivateProfileStringW(L"Fonts", L"TitleSize", buffer, configPath.c_str());
+    g_settings.SetInt("Fonts", "TitleSize", g_fontConfig.titleSize);
+    g_settings.SetInt("Fonts", "NormalSize", g_fontConfig.normalSize);
+    g_settings.SetInt("Fonts", "ButtonSize", g_fontConfig.buttonSize);
+    g_settings.SetInt("Fonts", "LogSize", g_fontConfig.logSize);
+}
 
-    swprintf(buffer, 16, L"%d", g_fontConfig.normalSize);
-    WritePrivateProfileStringW(L"Fonts", L"NormalSize", buffer, configPath.c_str());
+// 当前线程是否为界面线程
+bool IsUiThread() {
+    return GetCurrentThreadId() == g_uiThreadId;
+}
 
-    swprintf(buffer, 16, L"%d", g_fontConfig.buttonSize);
-    WritePrivateProfileStringW(L"Fonts", L"ButtonSize", buffer, configPath.c_str());
+// 读取 nginx 路径（后台线程使用）
+std::wstring GetNginxPath() {
+    std::lock_guard<std::mutex> lock(g_nginxPathMutex);
+    return g_nginxPath;
+}
 
-    swprintf(buffer, 16, L"%d", g_fontConfig.logSize);
-    WritePrivateProfileStringW(L"Fonts", L"LogSize", buffer, configPath.c_str());
+// 设置 nginx 路径（仅在界面线程调用）
+void SetNginxPath(const std::wstring& path) {
+    {
+        std::lock_guard<std::mutex> lock(g_nginxPathMutex);
+        if (g_nginxPath == path) return;
+        g_nginxPath = path;
+    }
+    // 换了实例，原来监护的 master 不再归本程序管理
+    g_supervisor.Unwatch();
 }
 
-// 检查 nginx 是否运行
-bool IsNginxRunning() {
-    STARTUPINFOW si = {};
-    PROCESS_INFORMATION pi = {};
-    si.cb = sizeof(si);
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
+// 提交后台操作，按钮处理函数立即返回，不阻塞消息循环
+void SubmitOperation(ServiceOperation op) {
+    switch (op) {
+        case OP_START:
+            g_opQueue.Submit(op, OP_GROUP_SERVICE, [](OperationContext& context) { StartNginx(context); });
+            break;
+        case OP_STOP:
+            g_opQueue.Submit(op, OP_GROUP_SERVICE, [](OperationContext& context) { StopNginx(context); });
+            break;
+        case OP_RESTART:
+            g_opQueue.Submit(op, OP_GROUP_SERVICE, [](OperationContext& context) { RestartNginx(context, false); });
+            break;
+        case OP_HARD_RESTART:
+            g_opQueue.Submit(op, OP_GROUP_SERVICE, [](OperationContext& context) { RestartNginx(context, true); });
+            break;
+        case OP_REFRESH:
+            g_opQueue.Submit(op, 0, [](OperationContext&) { RefreshStatus(); });
+            break;
+        case OP_UPDATE_STATUS:
+            g_opQueue.Submit(op, 0, [](OperationContext&) { UpdateStatus(); });
+            break;
+        case OP_PROBE_INSTANCES:
+            g_opQueue.Submit(op, 0, [](OperationContext&) { ProbeInstances(); });
+            break;
+        case OP_RECOVER:
+            g_opQueue.Submit(op, OP_GROUP_SERVICE, [](OperationContext& context) { RecoverNginx(context); });
+            break;
+        case OP_APPLY_AFFINITY:
+            break;                   // 需要携带计划，由 PlanCpuAffinity 直接提交
+        case OP_CONF_CHANGE:
+            g_opQueue.Submit(op, 0, [](OperationContext& context) { ApplyConfigChange(context); });
+            break;
+        case OP_EXPORT_TRACE:
+            g_opQueue.Submit(op, 0, [](OperationContext&) { ExportTrace(); });
+            break;
+    }
+}
 
-    wchar_t cmdLine[] = L"cmd /c tasklist | findstr /i nginx.exe";
+// 操作名称，用于操作日志与追踪
+const char* OperationKindName(int kind) {
+    static const char* const kNames[] = { "", "start", "stop", "restart", "hard-restart", "refresh",
+                                          "update-status", "probe-instances", "recover", "apply-affinity",
+                                          "conf-change", "export-trace" };
+    return kind > 0 && kind <= OP_EXPORT_TRACE ? kNames[kind] : "unknown";
+}
 
-    if (CreateProcessW(NULL, cmdLine, NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
-        WaitForSingleObject(pi.hProcess, 5000);
+// 操作完成回调（工作线程中调用），通过窗口消息通知界面线程
+void OnOperationComplete(const OperationResult& result) {
+    if (!result.cancelled && result.kind != OP_UPDATE_STATUS && result.kind != OP_PROBE_INSTANCES) {
+        g_journal.Append(JOURNAL_OPERATION, (uint8_t)LOG_INFO, (int64_t)result.runMicros, OperationKindName(result.kind),
+                         UtcTimeMicros());
+    }
+    // 自动恢复被用户的启动 / 停止 / 重启取代：交由该操作决定，运行中的 nginx 会在刷新状态时重新纳入监护
+    if (result.cancelled && result.kind == OP_RECOVER) {
+        g_supervisor.Unwatch();
+    }
+    if (g_hMainWnd) {
+        PostMessageW(g_hMainWnd, WM_APP_OP_DONE, (WPARAM)result.kind, (LPARAM)(result.cancelled ? 1 : 0));
+    }
+}
 
-        DWORD exitCode;
-        GetExitCodeProcess(pi.hProcess, &exitCode);
+// 刷新状态面板（界面线程定时调用）：运行时长、连接数与请求速率、资源占用，以及最近 10 秒的流量与状态码分布
+void UpdateDashboard() {
+    if (!g_hStatusView) return;
 
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
+    StatusMetrics metrics;
+    std::wstring prefix = GetNginxPath();
+    if (prefix.empty()) {
+        StatusViewSetMetrics(g_hStatusView, metrics);
+        return;
+    }
+    // 路径未变时为空操作，路径修改后自动切换到新的日志文件
+    g_accessLog.Start(WStringToString(prefix), WStringToString(prefix) + "\\conf\\nginx.conf");
+    g_stubStatus.Start(WStringToString(prefix) + "\\conf\\nginx.conf");
+    g_processSampler.Start(WStringToString(prefix));
+    g_logRotator.Start(WStringToString(prefix), WStringToString(prefix) + "\\conf\\nginx.conf");
+    g_healthProber.Start(WStringToString(prefix) + "\\conf\\nginx.conf");
+    g_confWatcher.Start(WStringToString(prefix) + "\\conf\\nginx.conf");
+
+    // 运行中时附带 stub_status 与资源采样；面板合并重绘，这里每次都提交
+    if (g_statusColor == RGB(34, 139, 34)) {
+        StubStatusSnapshot load = g_stubStatus.Snapshot();
+        metrics.loadAvailable = load.available;
+        metrics.connections = load.latest.active;
+        metrics.requestsPerSec = load.requestsPerSec;
+
+        ProcessUsageSnapshot usage;
+        g_processSampler.Snapshot(&usage);
+        metrics.usageReady = usage.ready;
+        metrics.cpuPercent = usage.total.cpuPercent;
+        metrics.rssBytes = usage.total.rssBytes;
+        if (!usage.processes.empty() && usage.processes.front().master) {
+            metrics.uptimeSeconds = usage.processes.front().uptimeSeconds;
+            metrics.uptimeKnown = metrics.uptimeSeconds > 0;
+        }
+    }
 
-        return (exitCode == 0);
+    TrafficSnapshot traffic = g_accessLog.Snapshot(10);
+    wchar_t text[256];
+    if (traffic.windowRequests == 0) {
+        swprintf(text, 256, L"流量: 最近 10 秒无请求 (累计 %llu 次)", (unsigned long long)traffic.totalRequests);
+    } else {
+        double total = (double)traffic.windowRequests;
+        swprintf(text, 256, L"流量: %.1f req/s · %.1f KB/s · 2xx %.1f%% · 4xx %.1f%% · 5xx %.1f%%",
+                 traffic.requestsPerSec, traffic.bytesPerSec / 1024.0,
+                 traffic.windowClasses[2] * 100.0 / total, traffic.windowClasses[4] * 100.0 / total,
+                 traffic.windowClasses[5] * 100.0 / total);
     }
+    metrics.traffic = text;
 
-    return false;
+    // 配置中有 upstream 时附带可用的探测地址数
+    HealthSnapshot health = g_healthProber.Snapshot();
+    if (health.running && health.targets > 0) {
+        swprintf(text, 256, L" · upstream %u/%u 可用", health.up, health.targets);
+        metrics.traffic += text;
+    }
+    StatusViewSetMetrics(g_hStatusView, metrics);
 }
 
-// 执行命令
-void ExecuteCommand(const wchar_t* command) {
-    STARTUPINFOW si = {};
-    PROCESS_INFORMATION pi = {};
-    si.cb = sizeof(si);
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
+// 检查 nginx 是否运行（仅在后台线程调用）
+bool IsNginxRunning() {
+    // 直接查询进程表，不再通过 cmd /c tasklist | findstr 创建子进程
+    SyncServicePrefix();
+    return g_service.IsRunning();
+}
 
-    size_t cmdLen = wcslen(command) + 10;
-    wchar_t* cmdLine = new wchar_t[cmdLen];
-    wcscpy(cmdLine, L"cmd /c ");
-    wcscat(cmdLine, command);
+// 服务控制只认当前路径下的 master，同一主机上其他路径的 nginx 不会被误判或误杀
+void SyncServicePrefix() {
+    g_service.SetPrefix(WStringToString(GetNginxPath()));
+}
 
-    if (CreateProcessW(NULL, cmdLine, NULL, NULL, FALSE, CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
-        WaitForSingleObject(pi.hProcess, 5000);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
+// 探测所有附加实例（后台线程）：一次扫描进程表，只记录状态发生变化的实例
+void ProbeInstances() {
+    std::vector<uint32_t> changed;
+    InstanceProbeStats stats;
+    if (!g_instances.Probe(&changed, &stats)) return;
+
+    if (!g_instancesProbed) {
+        g_instancesProbed = true;
+        size_t running = 0;
+        for (const InstanceInfo& info : g_instances.List()) {
+            if (info.state == INSTANCE_RUNNING) ++running;
+        }
+        wchar_t logMsg[256];
+        swprintf(logMsg, 256, L"附加实例: %zu 个运行中, %zu 个未运行 (扫描 %zu 个 nginx 进程耗时 %.1f ms)",
+                 running, stats.instances - running, stats.processes,
+                 (stats.scanMicros + stats.matchMicros) / 1000.0);
+        AddColoredLogMessage(logMsg, RGB(0, 100, 200)); // 蓝色
+        return;
     }
 
-    delete[] cmdLine;
+    for (uint32_t id : changed) {
+        InstanceInfo info;
+        if (!g_instances.Get(id, &info)) continue;
+        std::wstring prefix = StringToWString(info.prefix);
+        wchar_t logMsg[512];
+        if (info.state == INSTANCE_RUNNING) {
+            swprintf(logMsg, 512, L"✓ 实例 %ls 运行中 (master PID %u, %u 个 worker)", prefix.c_str(),
+                     info.masterPid, info.workerCount);
+            AddColoredLogMessage(logMsg, RGB(34, 139, 34)); // 绿色
+        } else if (info.state == INSTANCE_NO_WORKERS) {
+            swprintf(logMsg, 512, L"实例 %ls 没有 worker 进程 (master PID %u)", prefix.c_str(), info.masterPid);
+            AddColoredLogMessage(logMsg, RGB(255, 140, 0)); // 橙色
+        } else {
+            swprintf(logMsg, 512, L"✗ 实例 %ls 已停止", prefix.c_str());
+            AddColoredLogMessage(logMsg, RGB(220, 20, 60)); // 红色
+        }
+    }
 }
 
 // 字符串转换辅助函数
@@ -758,9 +1782,6 @@ void ApplyModernStyling() {
 
     // 设置输入框样式
     SendMessage(g_hPathEdit, EM_SETMARGINS, EC_LEFTMARGIN | EC_RIGHTMARGIN, MAKELONG(8, 8));
-
-    // 设置日志区域样式
-    SendMessage(g_hLogEdit, EM_SETMARGINS, EC_LEFTMARGIN | EC_RIGHTMARGIN, MAKELONG(8, 8));
 }
 
 // 设置按钮样式（简化版本，实际效果有限）
@@ -901,39 +1922,6 @@ INT_PTR CALLBACK FontSettingsDialogProc(HWND hDlg, UINT message, WPARAM wParam,
     return FALSE;
 }
 
-// 安全设置状态文本，避免重叠问题
-void SetStatusTextSafe(const wchar_t* text) {
-    if (!g_hStatusText || !text) return;
-
-    // 彻底清除并重绘状态文本以避免重叠
-    SetWindowTextW(g_hStatusText, L"");
-
-    // 获取控件区域并强制重绘背景
-    RECT rect;
-    GetClientRect(g_hStatusText, &rect);
-
-    // 使用父窗口的背景色填充控件区域
-    HDC hdc = GetDC(g_hStatusText);
-    HBRUSH hBrush = CreateSolidBrush(GetSysColor(COLOR_3DFACE));
-    FillRect(hdc, &rect, hBrush);
-    DeleteObject(hBrush);
-    ReleaseDC(g_hStatusText, hdc);
-
-    // 强制重绘控件
-    InvalidateRect(g_hStatusText, NULL, TRUE);
-    UpdateWindow(g_hStatusText);
-
-    // 短暂延迟确保重绘完成
-    Sleep(10);
-
-    // 设置新文本
-    SetWindowTextW(g_hStatusText, text);
-
-    // 再次强制重绘确保新文本正确显示
-    InvalidateRect(g_hStatusText, NULL, TRUE);
-    UpdateWindow(g_hStatusText);
-}
-
 // 更新字体预览
 void UpdateFontPreview(HWND hDlg) {
     static HFONT hPreviewNormalFont = NULL;
@@ -0,0 +1,130 @@
+// nginx-manager/src/socket_util.cpp
+// 套接字公共操作 - Winsock / BSD socket 的统一封装（非阻塞连接、超时等待）
+
+#include "socket_util.h"
+
+#ifdef _WIN32
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+bool InitSockets() {
+#ifdef _WIN32
+    static const bool initialized = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return initialized;
+#else
+    return true;
+#endif
+}
+
+void CloseSocket(SocketHandle s) {
+    if (s == kInvalidSocket) return;
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+bool SetNonBlocking(SocketHandle s) {
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    return ioctlsocket(s, FIONBIO, &nonBlocking) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+bool SocketWouldBlock() {
+#ifdef _WIN32
+    int error = WSAGetLastError();
+    return error == WSAEWOULDBLOCK || error == WSAEINPROGRESS;
+#else
+    return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS;
+#endif
+}
+
+int WaitSocket(SocketHandle s, bool forWrite, uint32_t timeoutMs) {
+#ifdef _WIN32
+    // Windows 的 fd_set 是句柄数组，不受描述符数值大小限制；WSAPoll 需要较新的 SDK 宏，这里沿用 select
+    fd_set readySet, errorSet;
+    FD_ZERO(&readySet);
+    FD_ZERO(&errorSet);
+    FD_SET(s, &readySet);
+    FD_SET(s, &errorSet);
+    timeval tv;
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    int rc = select(0, forWrite ? NULL : &readySet, forWrite ? &readySet : NULL, &errorSet, &tv);
+    if (rc < 0) return -1;
+    if (rc == 0) return 0;
+    return FD_ISSET(s, &readySet) ? 1 : -1;
+#else
+    pollfd pfd = {};
+    pfd.fd = s;
+    pfd.events = forWrite ? POLLOUT : POLLIN;
+    int rc;
+    do {
+        rc = poll(&pfd, 1, (int)timeoutMs);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) return -1;
+    if (rc == 0) return 0;
+    // 对端关闭 (POLLHUP) 视为可读，由随后的 recv 返回 0 区分
+    if ((pfd.revents & (POLLERR | POLLNVAL)) && !(pfd.revents & (POLLIN | POLLOUT))) return -1;
+    return 1;
+#endif
+}
+
+SocketHandle ConnectTcp(const std::string& host, uint16_t port, uint32_t timeoutMs, std::string* error) {
+    if (!InitSockets()) {
+        if (error) *error = "套接字库初始化失败";
+        return kInvalidSocket;
+    }
+
+    addrinfo hints = {};
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    addrinfo* result = NULL;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0 || !result) {
+        if (error) *error = "无法解析地址 " + host;
+        return kInvalidSocket;
+    }
+
+    SocketHandle s = socket(result->ai_family, SOCK_STREAM, IPPROTO_TCP);
+    bool connected = false;
+    if (s != kInvalidSocket && SetNonBlocking(s)) {
+        int rc = connect(s, result->ai_addr, (int)result->ai_addrlen);
+        if (rc == 0) {
+            connected = true;
+        } else if (SocketWouldBlock() && WaitSocket(s, true, timeoutMs) > 0) {
+            int soError = 0;
+            socklen_t len = sizeof(soError);
+            getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&soError, &len);
+            connected = soError == 0;
+        }
+    }
+    freeaddrinfo(result);
+
+    if (!connected) {
+        CloseSocket(s);
+        if (error) *error = "无法连接 " + host + ":" + service;
+        return kInvalidSocket;
+    }
+
+    // 请求都很小，关闭 Nagle 避免与对端的延迟确认叠加
+    int noDelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+    return s;
+}
@@ -0,0 +1,37 @@
+// nginx-manager/src/socket_util.h
+// 套接字公共操作 - Winsock / BSD socket 的统一封装（非阻塞连接、超时等待）
+
+#ifndef SOCKET_UTIL_H
+#define SOCKET_UTIL_H
+
+#include "platform.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET SocketHandle;
+const SocketHandle kInvalidSocket = INVALID_SOCKET;
+#else
+#include <sys/socket.h>
+typedef int SocketHandle;
+const SocketHandle kInvalidSocket = -1;
+#endif
+
+#include <string>
+
+// 初始化套接字库（Windows 下调用一次 WSAStartup），可重复调用
+bool InitSockets();
+
+void CloseSocket(SocketHandle s);
+bool SetNonBlocking(SocketHandle s);
+
+// 最近一次套接字调用失败是否只是暂时无法完成（EWOULDBLOCK / EINPROGRESS）
+bool SocketWouldBlock();
+
+// 等待套接字可读（forWrite 为 false）或可写：1 就绪，0 超时，-1 出错
+int WaitSocket(SocketHandle s, bool forWrite, uint32_t timeoutMs);
+
+// 非阻塞连接 host:port，成功返回已连接的非阻塞套接字，失败返回 kInvalidSocket
+SocketHandle ConnectTcp(const std::string& host, uint16_t port, uint32_t timeoutMs, std::string* error);
+
+#endif // SOCKET_UTIL_H
@@ -0,0 +1,413 @@
+// nginx-manager/src/status_view.cpp
+// 状态面板 - 自绘、双缓冲的服务状态仪表盘：状态、运行时长、流量与走势图一帧只绘制一次
+
+#include "status_view.h"
+#include "trace.h"
+
+#include <atomic>
+#include <cwchar>
+#include <mutex>
+
+static const wchar_t* const kStatusViewClass = L"NginxManagerStatusView";
+
+// 数据已更新，请求在下一帧重绘
+#define WM_STATUSVIEW_DIRTY    (WM_USER + 1)
+#define ID_FRAME_TIMER         1
+
+static const int kMargin = 8;
+static const int kCellWidth = 120;           // 每个走势图的宽度
+static const int kCellGap = 8;
+static const int kMinTextWidth = 200;        // 走势图挤占后左侧文字至少保留的宽度
+static const size_t kHistoryPoints = 60;     // 走势图显示最近 60 次采样
+
+static const COLORREF kCardColor = RGB(255, 255, 255);
+static const COLORREF kBorderColor = RGB(222, 226, 230);
+static const COLORREF kTextColor = RGB(33, 37, 41);
+static const COLORREF kDetailColor = RGB(128, 128, 128);
+
+// 固定长度的环形序列，负值表示该次采样未知
+struct Sparkline {
+    float values[kHistoryPoints];
+    size_t count = 0;
+    size_t next = 0;
+
+    void Add(float value) {
+        values[next] = value;
+        next = (next + 1) % kHistoryPoints;
+        if (count < kHistoryPoints) ++count;
+    }
+    // 第 i 个点，0 为最旧
+    float At(size_t i) const { return values[(next + kHistoryPoints - count + i) % kHistoryPoints]; }
+};
+
+enum SparklineKind { SPARK_CONNECTIONS, SPARK_REQUESTS, SPARK_CPU, SPARK_COUNT };
+
+static const COLORREF kSparkColors[SPARK_COUNT] = {
+    RGB(0, 100, 200),    // 连接：蓝色
+    RGB(34, 139, 34),    // 请求速率：绿色
+    RGB(255, 140, 0),    // CPU：橙色
+};
+
+// 面板数据：任意线程写入，界面线程在绘制时复制
+struct StatusViewData {
+    std::wstring stateText = L"未知";
+    COLORREF stateColor = RGB(128, 128, 128);
+    StatusMetrics metrics;
+    Sparkline series[SPARK_COUNT];
+};
+
+struct StatusViewState {
+    std::mutex mutex;
+    StatusViewData data;
+    std::atomic<bool> dirty{false};
+
+    // 以下只在界面线程访问
+    HFONT font = NULL;
+    int lineHeight = 16;
+    UINT frameMs = 16;               // 显示器一帧的时长，两次重绘至少间隔这么久
+    uint64_t lastPaintMicros = 0;
+    bool timerRunning = false;
+    HPEN pens[SPARK_COUNT] = {};
+    HPEN gridPen = NULL;
+
+    // 绘制用的缓冲，跨帧复用
+    HDC bufferDC = NULL;
+    HBITMAP bufferBitmap = NULL;
+    HGDIOBJ oldBitmap = NULL;
+    int bufferWidth = 0;
+    int bufferHeight = 0;
+    StatusViewData frame;            // 本帧使用的数据副本，字符串容量跨帧复用
+    POINT points[kHistoryPoints];
+};
+
+static StatusViewState* StateOf(HWND hwnd) {
+    return (StatusViewState*)GetWindowLongPtrW(hwnd, GWLP_USERDATA);
+}
+
+static void ReleaseBuffer(StatusViewState* state) {
+    if (state->bufferDC) {
+        SelectObject(state->bufferDC, state->oldBitmap);
+        DeleteObject(state->bufferBitmap);
+        DeleteDC(state->bufferDC);
+        state->bufferDC = NULL;
+        state->bufferBitmap = NULL;
+    }
+    state->bufferWidth = 0;
+    state->bufferHeight = 0;
+}
+
+static void UpdateMetrics(HWND hwnd, StatusViewState* state) {
+    HDC hdc = GetDC(hwnd);
+    HGDIOBJ old = SelectObject(hdc, state->font ? (HGDIOBJ)state->font : GetStockObject(DEFAULT_GUI_FONT));
+    TEXTMETRICW tm;
+    GetTextMetricsW(hdc, &tm);
+    state->lineHeight = tm.tmHeight + tm.tmExternalLeading + 2;
+    SelectObject(hdc, old);
+    ReleaseDC(hwnd, hdc);
+}
+
+// 显示器刷新率，取不到时按 60Hz
+static UINT FrameInterval() {
+    HDC screen = GetDC(NULL);
+    int hz = screen ? GetDeviceCaps(screen, VREFRESH) : 0;
+    if (screen) ReleaseDC(NULL, screen);
+    if (hz <= 1) hz = 60;
+    return (UINT)((1000 + hz - 1) / hz);
+}
+
+// 标记待重绘；已有待处理的通知时不再投递，多次更新合并为一次
+static void MarkDirty(HWND view, StatusViewState* state) {
+    if (!state->dirty.exchange(true)) {
+        if (!PostMessageW(view, WM_STATUSVIEW_DIRTY, 0, 0)) state->dirty.store(false);
+    }
+}
+
+static void FormatUptime(uint64_t seconds, wchar_t* text, size_t length) {
+    unsigned days = (unsigned)(seconds / 86400);
+    unsigned hours = (unsigned)(seconds / 3600 % 24);
+    unsigned minutes = (unsigned)(seconds / 60 % 60);
+    unsigned secs = (unsigned)(seconds % 60);
+    if (days > 0) {
+        swprintf(text, length, L"已运行 %u 天 %02u:%02u:%02u", days, hours, minutes, secs);
+    } else {
+        swprintf(text, length, L"已运行 %02u:%02u:%02u", hours, minutes, secs);
+    }
+}
+
+// 在 x 处输出一段文字，返回其后的横坐标
+static int DrawRun(HDC dc, int x, int y, const RECT& clip, const wchar_t* text, COLORREF color) {
+    int length = (int)wcslen(text);
+    SetTextColor(dc, color);
+    ExtTextOutW(dc, x, y, ETO_CLIPPED, &clip, text, (UINT)length, NULL);
+    SIZE size;
+    GetTextExtentPoint32W(dc, text, length, &size);
+    return x + size.cx;
+}
+
+// 一个走势图：上方为名称与最新值，下方为折线，纵轴按可见范围内的最大值缩放
+static void DrawSparkline(HDC dc, StatusViewState* state, const RECT& cell, const wchar_t* caption,
+                          const Sparkline& series, float floor, int kind) {
+    RECT captionClip = { cell.left, cell.top, cell.right, cell.top + state->lineHeight };
+    ExtTextOutW(dc, cell.left, cell.top, ETO_CLIPPED, &captionClip, caption, (UINT)wcslen(caption), NULL);
+
+    int top = cell.top + state->lineHeight;
+    int bottom = cell.bottom - 1;
+    int width = cell.right - cell.left;
+    if (bottom - top < 4 || width < 8) return;
+
+    HGDIOBJ oldPen = SelectObject(dc, state->gridPen);
+    MoveToEx(dc, cell.left, bottom, NULL);
+    LineTo(dc, cell.right, bottom);
+
+    float peak = floor;
+    for (size_t i = 0; i < series.count; ++i) {
+        if (series.At(i) > peak) peak = series.At(i);
+    }
+    // 最新的点在右边缘，不足 60 个时左侧留空；遇到未知的点折线断开
+    SelectObject(dc, state->pens[kind]);
+    int run = 0;
+    for (size_t i = 0; i < series.count; ++i) {
+        float value = series.At(i);
+        if (value < 0) {
+            if (run > 1) Polyline(dc, state->points, run);
+            run = 0;
+            continue;
+        }
+        size_t slot = kHistoryPoints - series.count + i;
+        state->points[run].x = cell.left + (int)(slot * (width - 1) / (kHistoryPoints - 1));
+        state->points[run].y = bottom - (int)(value / peak * (bottom - top));
+        ++run;
+    }
+    if (run > 1) Polyline(dc, state->points, run);
+    if (run == 1) SetPixel(dc, state->points[0].x, state->points[0].y, kSparkColors[kind]);
+    SelectObject(dc, oldPen);
+}
+
+static void Paint(HWND hwnd, StatusViewState* state) {
+    PAINTSTRUCT ps;
+    HDC hdc = BeginPaint(hwnd, &ps);
+    state->lastPaintMicros = MonotonicMicros();
+
+    RECT client;
+    GetClientRect(hwnd, &client);
+    int width = client.right - client.left;
+    int height = client.bottom - client.top;
+    if (width <= 0 || height <= 0) {
+        EndPaint(hwnd, &ps);
+        return;
+    }
+
+    // 在内存位图中绘制后一次性复制，避免闪烁
+    if (!state->bufferDC || state->bufferWidth < width || state->bufferHeight < height) {
+        ReleaseBuffer(state);
+        state->bufferDC = CreateCompatibleDC(hdc);
+        state->bufferBitmap = CreateCompatibleBitmap(hdc, width, height);
+        state->oldBitmap = SelectObject(state->bufferDC, state->bufferBitmap);
+        state->bufferWidth = width;
+        state->bufferHeight = height;
+    }
+    HDC dc = state->bufferDC;
+
+    // 只在复制数据时持锁，绘制期间的更新留到下一帧
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->frame = state->data;
+    }
+    const StatusViewData& data = state->frame;
+    const StatusMetrics& metrics = data.metrics;
+
+    HBRUSH card = CreateSolidBrush(kCardColor);
+    FillRect(dc, &client, card);
+    DeleteObject(card);
+    HBRUSH border = CreateSolidBrush(kBorderColor);
+    FrameRect(dc, &client, border);
+    DeleteObject(border);
+
+    HGDIOBJ oldFont = SelectObject(dc, state->font ? (HGDIOBJ)state->font : GetStockObject(DEFAULT_GUI_FONT));
+    SetBkMode(dc, TRANSPARENT);
+
+    // 右侧的走势图按宽度依次放下连接、请求速率与 CPU，放不下的省略
+    int cells = (width - 2 * kMargin - kMinTextWidth) / (kCellWidth + kCellGap);
+    if (cells < 0) cells = 0;
+    if (cells > SPARK_COUNT) cells = SPARK_COUNT;
+    int textRight = width - kMargin - cells * (kCellWidth + kCellGap);
+
+    // 第一行：状态、运行时长、内存；第二行：流量
+    int y = (height - 2 * state->lineHeight) / 2;
+    if (y < 2) y = 2;
+    RECT clip = { kMargin, y, textRight, y + state->lineHeight };
+    int x = DrawRun(dc, kMargin, y, clip, L"服务状态: ", kTextColor);
+    x = DrawRun(dc, x, y, clip, data.stateText.c_str(), data.stateColor);
+    wchar_t text[128];
+    if (metrics.uptimeKnown) {
+        wchar_t uptime[64];
+        FormatUptime(metrics.uptimeSeconds, uptime, 64);
+        swprintf(text, 128, L" · %ls", uptime);
+        x = DrawRun(dc, x, y, clip, text, kDetailColor);
+    }
+    if (metrics.usageReady) {
+        swprintf(text, 128, L" · 内存 %.0f MB", metrics.rssBytes / 1048576.0);
+        DrawRun(dc, x, y, clip, text, kDetailColor);
+    }
+
+    RECT trafficRect = { kMargin, y + state->lineHeight, textRight, y + 2 * state->lineHeight };
+    SetTextColor(dc, kDetailColor);
+    const wchar_t* traffic = metrics.traffic.empty() ? L"流量: -" : metrics.traffic.c_str();
+    DrawTextW(dc, traffic, -1, &trafficRect, DT_LEFT | DT_SINGLELINE | DT_NOPREFIX | DT_END_ELLIPSIS);
+
+    for (int i = 0; i < cells; ++i) {
+        RECT cell = { textRight + kCellGap + i * (kCellWidth + kCellGap), y,
+                      textRight + (i + 1) * (kCellWidth + kCellGap), y + 2 * state->lineHeight };
+        if (cell.bottom > height - 2) cell.bottom = height - 2;
+        float floor = 1;
+        switch (i) {
+            case SPARK_CONNECTIONS:
+                if (metrics.loadAvailable) {
+                    swprintf(text, 128, L"连接 %llu", (unsigned long long)metrics.connections);
+                } else {
+                    swprintf(text, 128, L"连接 -");
+                }
+                break;
+            case SPARK_REQUESTS:
+                if (metrics.loadAvailable) {
+                    swprintf(text, 128, L"req/s %.1f", metrics.requestsPerSec);
+                } else {
+                    swprintf(text, 128, L"req/s -");
+                }
+                break;
+            default:
+                if (metrics.usageReady) {
+                    swprintf(text, 128, L"CPU %.1f%%", metrics.cpuPercent);
+                } else {
+                    swprintf(text, 128, L"CPU -");
+                }
+                floor = 10;  // 低负载时不把 1% 的抖动放大成满格
+                break;
+        }
+        SetTextColor(dc, kDetailColor);
+        DrawSparkline(dc, state, cell, text, data.series[i], floor, i);
+    }
+
+    SelectObject(dc, oldFont);
+    BitBlt(hdc, ps.rcPaint.left, ps.rcPaint.top, ps.rcPaint.right - ps.rcPaint.left,
+           ps.rcPaint.bottom - ps.rcPaint.top, dc, ps.rcPaint.left, ps.rcPaint.top, SRCCOPY);
+    EndPaint(hwnd, &ps);
+}
+
+static LRESULT CALLBACK StatusViewProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
+    StatusViewState* state = StateOf(hwnd);
+
+    switch (uMsg) {
+        case WM_NCCREATE: {
+            StatusViewState* newState = new StatusViewState();
+            SetWindowLongPtrW(hwnd, GWLP_USERDATA, (LONG_PTR)newState);
+            break;
+        }
+
+        case WM_CREATE:
+            state->frameMs = FrameInterval();
+            for (int i = 0; i < SPARK_COUNT; ++i) state->pens[i] = CreatePen(PS_SOLID, 1, kSparkColors[i]);
+            state->gridPen = CreatePen(PS_SOLID, 1, kBorderColor);
+            UpdateMetrics(hwnd, state);
+            return 0;
+
+        case WM_NCDESTROY:
+            if (state) {
+                ReleaseBuffer(state);
+                for (HPEN pen : state->pens) DeleteObject(pen);
+                DeleteObject(state->gridPen);
+                delete state;
+                SetWindowLongPtrW(hwnd, GWLP_USERDATA, 0);
+            }
+            break;
+
+        case WM_SETFONT:
+            state->font = (HFONT)wParam;
+            UpdateMetrics(hwnd, state);
+            if (LOWORD(lParam)) InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+
+        case WM_GETFONT:
+            return (LRESULT)state->font;
+
+        case WM_SIZE:
+            InvalidateRect(hwnd, NULL, FALSE);
+            return 0;
+
+        case WM_STATUSVIEW_DIRTY: {
+            // 距上一帧已满一帧时立即重绘，否则等到这一帧结束；期间的更新都合并到那一次
+            if (state->timerRunning) return 0;
+            uint64_t elapsed = MonotonicMicros() - state->lastPaintMicros;
+            uint64_t frameMicros = (uint64_t)state->frameMs * 1000;
+            if (elapsed >= frameMicros) {
+                state->dirty.store(false);
+                InvalidateRect(hwnd, NULL, FALSE);
+            } else {
+                SetTimer(hwnd, ID_FRAME_TIMER, (UINT)((frameMicros - elapsed + 999) / 1000), NULL);
+                state->timerRunning = true;
+            }
+            return 0;
+        }
+
+        case WM_TIMER:
+            if (wParam == ID_FRAME_TIMER) {
+                KillTimer(hwnd, ID_FRAME_TIMER);
+                state->timerRunning = false;
+                // 先清除标记再绘制，绘制之后的更新会再次触发
+                state->dirty.store(false);
+                InvalidateRect(hwnd, NULL, FALSE);
+                return 0;
+            }
+            break;
+
+        case WM_ERASEBKGND:
+            return 1;
+
+        case WM_PAINT: {
+            TraceSpan span(TRACE_PAINT, "status-view");
+            Paint(hwnd, state);
+            return 0;
+        }
+    }
+    return DefWindowProcW(hwnd, uMsg, wParam, lParam);
+}
+
+bool RegisterStatusViewClass(HINSTANCE instance) {
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = StatusViewProc;
+    wc.hInstance = instance;
+    wc.lpszClassName = kStatusViewClass;
+    wc.hCursor = LoadCursor(NULL, IDC_ARROW);
+    wc.hbrBackground = NULL;
+    return RegisterClassW(&wc) != 0;
+}
+
+HWND CreateStatusView(HWND parent, int id, int x, int y, int width, int height) {
+    return CreateWindowExW(0, kStatusViewClass, L"", WS_CHILD | WS_VISIBLE, x, y, width, height, parent,
+                           (HMENU)(INT_PTR)id, GetModuleHandle(NULL), NULL);
+}
+
+void StatusViewSetState(HWND view, const wchar_t* text, COLORREF color) {
+    StatusViewState* state = view ? StateOf(view) : nullptr;
+    if (!state || !text) return;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->data.stateText == text && state->data.stateColor == color) return;
+        state->data.stateText = text;
+        state->data.stateColor = color;
+    }
+    MarkDirty(view, state);
+}
+
+void StatusViewSetMetrics(HWND view, const StatusMetrics& metrics) {
+    StatusViewState* state = view ? StateOf(view) : nullptr;
+    if (!state) return;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->data.metrics = metrics;
+        state->data.series[SPARK_CONNECTIONS].Add(metrics.loadAvailable ? (float)metrics.connections : -1.0f);
+        state->data.series[SPARK_REQUESTS].Add(metrics.loadAvailable ? (float)metrics.requestsPerSec : -1.0f);
+        state->data.series[SPARK_CPU].Add(metrics.usageReady ? (float)metrics.cpuPercent : -1.0f);
+    }
+    MarkDirty(view, state);
+}
@@ -0,0 +1,34 @@
+// nginx-manager/src/status_view.h
+// 状态面板 - 自绘、双缓冲的服务状态仪表盘：状态、运行时长、流量与走势图一帧只绘制一次
+
+#ifndef STATUS_VIEW_H
+#define STATUS_VIEW_H
+
+#include "platform.h"
+#include <string>
+
+// 一次指标采样（通常每秒一次），数值追加到面板的走势图
+struct StatusMetrics {
+    bool uptimeKnown = false;
+    uint64_t uptimeSeconds = 0;      // master 的运行时长
+    bool loadAvailable = false;      // stub_status 可用
+    uint64_t connections = 0;        // 活动连接数
+    double requestsPerSec = 0;
+    bool usageReady = false;         // 进程资源采样就绪
+    double cpuPercent = 0;           // master 与各 worker 合计
+    uint64_t rssBytes = 0;
+    std::wstring traffic;            // access.log 流量摘要，单独一行显示
+};
+
+// 注册状态面板窗口类，创建面板前调用一次
+bool RegisterStatusViewClass(HINSTANCE instance);
+
+HWND CreateStatusView(HWND parent, int id, int x, int y, int width, int height);
+
+// 以下更新可在任意线程调用：只修改数据并标记待重绘，
+// 面板按显示器刷新率定时合并重绘，更新再频繁也不会多绘制，界面线程不等待
+void StatusViewSetState(HWND view, const wchar_t* text, COLORREF color);
+// 追加一次采样；nginx 未运行时各项为未知，走势图在该处断开
+void StatusViewSetMetrics(HWND view, const StatusMetrics& metrics);
+
+#endif // STATUS_VIEW_H
@@ -0,0 +1,284 @@
+// nginx-manager/src/stub_status.cpp
+// stub_status 轮询 - 长连接采集连接数与请求总数，写入固定内存的多分辨率时间序列
+
+#include "stub_status.h"
+#include "trace.h"
+
+#include <chrono>
+#include <cstring>
+#include <ctime>
+
+static const uint32_t kRequestTimeoutMs = 2000;
+static const uint64_t kRediscoverMicros = 30 * 1000000ull;   // 找不到 stub_status 或响应异常时重新读取配置的间隔
+
+// ---------------------------------------------------------------------------
+// 解析
+
+// 在 text 中查找 label，读取其后的第一个无符号整数
+static bool NumberAfter(std::string_view text, std::string_view label, size_t* cursor, uint64_t* value) {
+    size_t pos = text.find(label, *cursor);
+    if (pos == std::string_view::npos) return false;
+    pos += label.size();
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\r' || text[pos] == '\n')) ++pos;
+    if (pos >= text.size() || text[pos] < '0' || text[pos] > '9') return false;
+    uint64_t number = 0;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') number = number * 10 + (uint64_t)(text[pos++] - '0');
+    *value = number;
+    *cursor = pos;
+    return true;
+}
+
+bool ParseStubStatus(std::string_view body, StubStatus* status) {
+    size_t cursor = 0;
+    StubStatus parsed;
+    if (!NumberAfter(body, "Active connections:", &cursor, &parsed.active)) return false;
+    if (!NumberAfter(body, "requests", &cursor, &parsed.accepts)) return false;
+    if (!NumberAfter(body, "", &cursor, &parsed.handled)) return false;
+    if (!NumberAfter(body, "", &cursor, &parsed.requests)) return false;
+    if (!NumberAfter(body, "Reading:", &cursor, &parsed.reading)) return false;
+    if (!NumberAfter(body, "Writing:", &cursor, &parsed.writing)) return false;
+    if (!NumberAfter(body, "Waiting:", &cursor, &parsed.waiting)) return false;
+    *status = parsed;
+    return true;
+}
+
+bool FindStubStatusEndpoint(const NginxConfig& config, StubStatusEndpoint* endpoint) {
+    for (uint32_t index : config.FindByName("stub_status")) {
+        const ConfDirective& directive = config.At(index);
+        if (directive.argCount > 0 && config.Arg(directive, 0) == "off") continue;
+
+        uint32_t location = directive.parent;
+        if (location == NginxConfig::kNoDirective || config.At(location).name != "location") continue;
+        const ConfDirective& locationDirective = config.At(location);
+        if (locationDirective.argCount == 0) continue;
+        std::string_view path = config.Arg(locationDirective, locationDirective.argCount - 1);
+        if (locationDirective.argCount >= 2 && config.Arg(locationDirective, 0)[0] == '~') continue;
+        if (path.empty() || path[0] == '~' || path[0] == '@') continue;
+
+        uint32_t server = config.At(location).parent;
+        while (server != NginxConfig::kNoDirective && config.At(server).name != "server") server = config.At(server).parent;
+        if (server == NginxConfig::kNoDirective) continue;
+
+        ListenEndpoint listen;
+        if (!FindPlainListen(config, server, &listen)) continue;
+
+        endpoint->host = listen.host.empty() ? "127.0.0.1" : listen.host;
+        endpoint->port = listen.port;
+        endpoint->path = std::string(path);
+        endpoint->hostHeader = ServerHostName(config, server);
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// LoadSeries
+
+LoadSeries::LoadSeries()
+    : m_seconds(kSecondPoints),
+      m_minutes(kMinutePoints) {
+}
+
+void LoadSeries::Reset() {
+    for (LoadPoint& point : m_seconds) point = LoadPoint();
+    for (LoadPoint& point : m_minutes) point = LoadPoint();
+    m_previous = StubStatus();
+    m_hasPrevious = false;
+    m_latestSecond = 0;
+}
+
+void LoadSeries::Accumulate(LoadPoint* point, int64_t start, const StubStatus& sample, uint64_t requests) {
+    // 环形槽位中是更早一轮的数据，直接覆盖
+    if (point->second != start) {
+        *point = LoadPoint();
+        point->second = start;
+    }
+    point->samples++;
+    if (sample.active > point->activeMax) point->activeMax = (uint32_t)sample.active;
+    point->activeSum += sample.active;
+    point->readingSum += sample.reading;
+    point->writingSum += sample.writing;
+    point->waitingSum += sample.waiting;
+    point->requests += requests;
+}
+
+void LoadSeries::Add(int64_t second, const StubStatus& sample) {
+    // 累计值变小说明 nginx 重启过，本次增量按从零开始计
+    uint64_t requests = 0;
+    if (m_hasPrevious) {
+        requests = sample.requests >= m_previous.requests ? sample.requests - m_previous.requests : sample.requests;
+    }
+
+    int64_t minute = second - second % 60;
+    Accumulate(&m_seconds[(size_t)((uint64_t)second % kSecondPoints)], second, sample, requests);
+    Accumulate(&m_minutes[(size_t)((uint64_t)(minute / 60) % kMinutePoints)], minute, sample, requests);
+
+    m_previous = sample;
+    m_hasPrevious = true;
+    m_latestSecond = second;
+}
+
+size_t LoadSeries::Query(int64_t fromSecond, int64_t toSecond, bool minutes, std::vector<LoadPoint>* points) const {
+    points->clear();
+    const std::vector<LoadPoint>& ring = minutes ? m_minutes : m_seconds;
+    int64_t step = minutes ? 60 : 1;
+    int64_t span = (int64_t)ring.size() * step;
+    if (toSecond - fromSecond > span) fromSecond = toSecond - span;
+
+    int64_t start = fromSecond - ((fromSecond % step) + step) % step;
+    for (int64_t t = start; t < toSecond; t += step) {
+        const LoadPoint& point = ring[(size_t)((uint64_t)(t / step) % ring.size())];
+        if (point.second == t) points->push_back(point);
+    }
+    return points->size();
+}
+
+double LoadSeries::RequestRate(int64_t nowSecond, uint32_t windowSeconds) const {
+    if (windowSeconds == 0) return 0;
+    if (windowSeconds > kSecondPoints) windowSeconds = (uint32_t)kSecondPoints;
+    uint64_t total = 0;
+    for (int64_t t = nowSecond - (int64_t)windowSeconds + 1; t <= nowSecond; ++t) {
+        const LoadPoint& point = m_seconds[(size_t)((uint64_t)t % kSecondPoints)];
+        if (point.second == t) total += point.requests;
+    }
+    return (double)total / windowSeconds;
+}
+
+// ---------------------------------------------------------------------------
+// StubStatusPoller
+
+StubStatusPoller::~StubStatusPoller() {
+    Stop();
+}
+
+void StubStatusPoller::Start(const std::string& confPath) {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        if (m_worker.joinable() && confPath == m_confPath) return;
+    }
+    Launch(confPath, nullptr);
+}
+
+void StubStatusPoller::StartEndpoint(const StubStatusEndpoint& endpoint) {
+    Launch(std::string(), &endpoint);
+}
+
+void StubStatusPoller::Launch(const std::string& confPath, const StubStatusEndpoint* endpoint) {
+    Stop();
+
+    {
+        std::lock_guard<std::mutex> lock(m_dataMutex);
+        m_series.Reset();
+        m_snapshot = StubStatusSnapshot();
+    }
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    m_stopping = false;
+    m_rediscover = false;
+    m_confPath = confPath;
+    m_worker = std::thread(&StubStatusPoller::Run, this, confPath, endpoint != nullptr,
+                           endpoint ? *endpoint : StubStatusEndpoint());
+}
+
+void StubStatusPoller::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+void StubStatusPoller::Rediscover() {
+    {
+        std::lock_guard<std::mutex> lock(m_controlMutex);
+        m_rediscover = true;
+    }
+    m_wake.notify_all();
+}
+
+StubStatusSnapshot StubStatusPoller::Snapshot() const {
+    std::lock_guard<std::mutex> lock(m_dataMutex);
+    StubStatusSnapshot snapshot = m_snapshot;
+    snapshot.requestsPerSec = m_series.HasSample() ? m_series.RequestRate(m_series.LatestSecond(), 10) : 0;
+    return snapshot;
+}
+
+size_t StubStatusPoller::Query(int64_t fromSecond, int64_t toSecond, bool minutes,
+                               std::vector<LoadPoint>* points) const {
+    std::lock_guard<std::mutex> lock(m_dataMutex);
+    return m_series.Query(fromSecond, toSecond, minutes, points);
+}
+
+void StubStatusPoller::Run(std::string confPath, bool fixedEndpoint, StubStatusEndpoint endpoint) {
+    TraceSetThreadName("stub-status");
+    HttpClient client;
+    bool haveEndpoint = fixedEndpoint;
+    bool discover = !fixedEndpoint;
+    uint64_t nextDiscovery = 0;
+    if (haveEndpoint) client.SetTarget(endpoint.host, endpoint.port, endpoint.hostHeader);
+
+    HttpResponse response;
+    std::unique_lock<std::mutex> control(m_controlMutex);
+    while (!m_stopping) {
+        discover = discover || m_rediscover;
+        m_rediscover = false;
+        uint32_t intervalMs = m_intervalMs;
+        control.unlock();
+
+        uint64_t now = MonotonicMicros();
+        if (!fixedEndpoint && (discover || (!haveEndpoint && now >= nextDiscovery))) {
+            // 配置解析只需几毫秒，但不必每次采样都做：只在启动、重新加载后或采样异常时进行
+            NginxConfig config;
+            std::string error;
+            haveEndpoint = config.Load(confPath, &error) && FindStubStatusEndpoint(config, &endpoint);
+            discover = false;
+            nextDiscovery = now + kRediscoverMicros;
+
+            std::lock_guard<std::mutex> lock(m_dataMutex);
+            m_snapshot.configured = haveEndpoint;
+            if (haveEndpoint) {
+                client.SetTarget(endpoint.host, endpoint.port, endpoint.hostHeader);
+                m_snapshot.endpoint = endpoint.host + ":" + std::to_string(endpoint.port) + endpoint.path;
+            } else {
+                client.Close();
+                m_snapshot.available = false;
+                m_snapshot.endpoint.clear();
+                m_snapshot.error = error.empty() ? "配置中未启用 stub_status" : error;
+            }
+        } else if (fixedEndpoint) {
+            std::lock_guard<std::mutex> lock(m_dataMutex);
+            m_snapshot.configured = true;
+            m_snapshot.endpoint = endpoint.host + ":" + std::to_string(endpoint.port) + endpoint.path;
+        }
+
+        if (haveEndpoint) {
+            uint64_t begin = MonotonicMicros();
+            std::string error;
+            StubStatus status;
+            bool ok = client.Get(endpoint.path, kRequestTimeoutMs, &response, &error);
+            bool valid = ok && response.status == 200 && ParseStubStatus(response.body, &status);
+            uint64_t latency = MonotonicMicros() - begin;
+
+            std::lock_guard<std::mutex> lock(m_dataMutex);
+            m_snapshot.available = valid;
+            m_snapshot.connections = client.Connections();
+            m_snapshot.latencyMicros = latency;
+            if (valid) {
+                m_series.Add((int64_t)time(nullptr), status);
+                m_snapshot.latest = status;
+                m_snapshot.samples++;
+                m_snapshot.error.clear();
+            } else if (ok) {
+                // 能连上但不是 stub_status 页面：location 可能已被修改，稍后重新读取配置
+                m_snapshot.error = "stub_status 返回 HTTP " + std::to_string(response.status);
+                if (!fixedEndpoint && MonotonicMicros() >= nextDiscovery) discover = true;
+            } else {
+                m_snapshot.error = error;
+            }
+        }
+
+        control.lock();
+        m_wake.wait_for(control, std::chrono::milliseconds(intervalMs),
+                        [this]() { return m_stopping || m_rediscover; });
+    }
+}
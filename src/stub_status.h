@@ -0,0 +1,146 @@
+// nginx-manager/src/stub_status.h
+// stub_status 轮询 - 长连接采集连接数与请求总数，写入固定内存的多分辨率时间序列
+
+#ifndef STUB_STATUS_H
+#define STUB_STATUS_H
+
+#include "http_client.h"
+#include "nginx_conf.h"
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// 一次 stub_status 采样
+struct StubStatus {
+    uint64_t active = 0;             // 当前活动连接数（含等待中的空闲连接）
+    uint64_t accepts = 0;
+    uint64_t handled = 0;
+    uint64_t requests = 0;           // 累计请求数，nginx 重启后归零
+    uint64_t reading = 0;
+    uint64_t writing = 0;
+    uint64_t waiting = 0;
+};
+
+// 解析 stub_status 页面：
+//   Active connections: 291
+//   server accepts handled requests
+//    16630948 16630948 31070465
+//   Reading: 6 Writing: 179 Waiting: 106
+bool ParseStubStatus(std::string_view body, StubStatus* status);
+
+// 配置中 stub_status 所在的地址
+struct StubStatusEndpoint {
+    std::string host;                // 连接地址
+    uint16_t port = 0;
+    std::string hostHeader;          // server_name，未配置时为空
+    std::string path;                // location 路径
+};
+
+// 查找配置中第一个可访问的 stub_status location（正则 location 无法构造请求路径，跳过）
+bool FindStubStatusEndpoint(const NginxConfig& config, StubStatusEndpoint* endpoint);
+
+// 时间序列中的一个桶：桶内所有采样的聚合值
+struct LoadPoint {
+    int64_t second = -1;             // 桶起始时间（UTC 秒），-1 表示空桶
+    uint32_t samples = 0;
+    uint32_t activeMax = 0;
+    uint64_t activeSum = 0;
+    uint64_t readingSum = 0;
+    uint64_t writingSum = 0;
+    uint64_t waitingSum = 0;
+    uint64_t requests = 0;           // 桶内新增的请求数
+
+    double ActiveAverage() const { return samples ? (double)activeSum / samples : 0; }
+};
+
+// 多分辨率时间序列：最近 1 小时按秒、最近 1 天按分钟
+// 两级均为按时间取模的环形数组，每次写入同时累加到两级桶中，内存固定为约 5000 个桶。
+class LoadSeries {
+public:
+    static const size_t kSecondPoints = 3600;
+    static const size_t kMinutePoints = 1440;
+
+    LoadSeries();
+
+    // 加入一次采样；请求数增量由相邻两次采样的累计值相减得到
+    void Add(int64_t second, const StubStatus& sample);
+    void Reset();
+
+    // 按时间顺序返回 [fromSecond, toSecond) 内的非空桶；minutes 选择分钟分辨率
+    size_t Query(int64_t fromSecond, int64_t toSecond, bool minutes, std::vector<LoadPoint>* points) const;
+
+    // 截至 nowSecond 的最近 windowSeconds 秒平均请求速率
+    double RequestRate(int64_t nowSecond, uint32_t windowSeconds) const;
+
+    bool HasSample() const { return m_hasPrevious; }
+    const StubStatus& Latest() const { return m_previous; }
+    int64_t LatestSecond() const { return m_latestSecond; }
+
+private:
+    static void Accumulate(LoadPoint* point, int64_t start, const StubStatus& sample, uint64_t requests);
+
+    std::vector<LoadPoint> m_seconds;
+    std::vector<LoadPoint> m_minutes;
+    StubStatus m_previous;
+    bool m_hasPrevious = false;
+    int64_t m_latestSecond = 0;
+};
+
+// 轮询状态快照
+struct StubStatusSnapshot {
+    bool available = false;          // 最近一次采样成功
+    bool configured = false;         // 配置中找到了 stub_status
+    StubStatus latest;
+    double requestsPerSec = 0;       // 最近 10 秒
+    uint64_t connections = 0;        // 累计建立的 TCP 连接数
+    uint64_t samples = 0;
+    uint64_t latencyMicros = 0;      // 最近一次请求耗时
+    std::string endpoint;            // host:port/path
+    std::string error;
+};
+
+// 后台轮询线程：每秒请求一次 stub_status，连接在两次采样间保持
+class StubStatusPoller {
+public:
+    StubStatusPoller() {}
+    ~StubStatusPoller();
+
+    StubStatusPoller(const StubStatusPoller&) = delete;
+    StubStatusPoller& operator=(const StubStatusPoller&) = delete;
+
+    // 按配置文件查找 stub_status 并开始轮询，路径未变时为空操作
+    void Start(const std::string& confPath);
+    // 直接轮询指定地址（不读取配置）
+    void StartEndpoint(const StubStatusEndpoint& endpoint);
+    void Stop();
+
+    // 配置可能已变化（重新加载后调用），下一次轮询前重新查找 stub_status
+    void Rediscover();
+
+    void SetInterval(uint32_t intervalMs) { m_intervalMs = intervalMs; }
+
+    StubStatusSnapshot Snapshot() const;
+    // 读取时间序列，参数同 LoadSeries::Query
+    size_t Query(int64_t fromSecond, int64_t toSecond, bool minutes, std::vector<LoadPoint>* points) const;
+
+private:
+    void Launch(const std::string& confPath, const StubStatusEndpoint* endpoint);
+    void Run(std::string confPath, bool fixedEndpoint, StubStatusEndpoint endpoint);
+
+    std::thread m_worker;
+    std::mutex m_controlMutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+    bool m_rediscover = false;
+    std::string m_confPath;
+    uint32_t m_intervalMs = 1000;
+
+    mutable std::mutex m_dataMutex;
+    LoadSeries m_series;
+    StubStatusSnapshot m_snapshot;
+};
+
+#endif // STUB_STATUS_H
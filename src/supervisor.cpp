@@ -0,0 +1,393 @@
+// nginx-manager/src/supervisor.cpp
+// 崩溃监护 - 阻塞等待 master 进程句柄 / pidfd，意外退出后按指数退避（带抖动）自动重启，识别崩溃循环
+
+#include "supervisor.h"
+#include "file_util.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// 内核不支持 pidfd 时检查进程是否存在的间隔
+static const uint32_t kPollIntervalMs = 500;
+
+// master 退出后 pid 文件是否已被删除（或已记录另一个进程）：nginx 只在正常退出时删除 pid 文件
+static bool PidFileReleased(const std::string& path, ProcessId pid) {
+    FILE* file = OpenFile(path, "rb");
+    if (!file) return true;
+    unsigned long value = 0;
+    bool same = fscanf(file, "%lu", &value) == 1 && value == (unsigned long)pid;
+    fclose(file);
+    return !same;
+}
+
+const char* SupervisorStateName(SupervisorState state) {
+    switch (state) {
+        case SUPERVISOR_IDLE: return "idle";
+        case SUPERVISOR_WATCHING: return "watching";
+        case SUPERVISOR_BACKOFF: return "backoff";
+        case SUPERVISOR_RESTARTING: return "restarting";
+        case SUPERVISOR_GAVE_UP: return "gave-up";
+        default: return "unknown";
+    }
+}
+
+Supervisor::Supervisor() : m_random((uint32_t)MonotonicMicros()) {
+}
+
+Supervisor::~Supervisor() {
+    Stop();
+}
+
+bool Supervisor::Start(EventHandler handler, std::string* error) {
+    Stop();
+    m_handler = handler;
+    m_stopping = false;
+#ifdef _WIN32
+    m_wakeEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!m_wakeEvent) {
+        if (error) *error = "无法创建监护事件";
+        return false;
+    }
+#else
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_epoll < 0 || m_wakeFd < 0) {
+        if (m_epoll >= 0) close(m_epoll);
+        if (m_wakeFd >= 0) close(m_wakeFd);
+        m_epoll = m_wakeFd = -1;
+        if (error) *error = "无法创建监护事件";
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeFd;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+#endif
+    m_worker = std::thread(&Supervisor::Run, this);
+    return true;
+}
+
+void Supervisor::Stop() {
+    if (!m_worker.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    Wake();
+    m_worker.join();
+#ifdef _WIN32
+    if (m_process) CloseHandle(m_process);
+    CloseHandle(m_wakeEvent);
+    m_process = NULL;
+    m_wakeEvent = NULL;
+#else
+    if (m_pidfd >= 0) close(m_pidfd);
+    close(m_wakeFd);
+    close(m_epoll);
+    m_pidfd = m_wakeFd = m_epoll = -1;
+#endif
+    m_openedPid = 0;
+}
+
+void Supervisor::Wake() {
+#ifdef _WIN32
+    if (m_wakeEvent) SetEvent(m_wakeEvent);
+#else
+    if (m_wakeFd >= 0) {
+        uint64_t one = 1;
+        ssize_t written = write(m_wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+}
+
+void Supervisor::SetPolicy(const SupervisorPolicy& policy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_policy = policy;
+}
+
+void Supervisor::SetEnabled(bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_enabled = enabled;
+        if (!enabled && m_state == SUPERVISOR_BACKOFF) m_state = SUPERVISOR_IDLE;
+    }
+    Wake();
+}
+
+void Supervisor::Watch(ProcessId masterPid, const std::string& pidFile) {
+    if (masterPid == 0) {
+        Unwatch();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state == SUPERVISOR_WATCHING && m_targetPid == masterPid) return;
+        m_state = SUPERVISOR_WATCHING;
+        m_targetPid = masterPid;
+        m_targetPidFile = pidFile;
+        m_watchMicros = MonotonicMicros();
+        m_outageMicros = 0;
+        m_attempt = 0;
+        m_crashes.clear();
+    }
+    Wake();
+}
+
+void Supervisor::Unwatch() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_state = SUPERVISOR_IDLE;
+        m_targetPid = 0;
+        m_targetPidFile.clear();
+        m_outageMicros = 0;
+        m_attempt = 0;
+        m_crashes.clear();
+    }
+    Wake();
+}
+
+void Supervisor::RestartSucceeded(ProcessId masterPid, const std::string& pidFile) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 等待结果期间已被 Unwatch / Watch 改变，结果作废
+        if (m_state != SUPERVISOR_RESTARTING) return;
+        uint64_t now = MonotonicMicros();
+        SupervisorEvent event;
+        event.type = SUPERVISOR_RECOVERED;
+        event.pid = masterPid;
+        event.attempt = m_attempt;
+        event.recentCrashes = (uint32_t)m_crashes.size();
+        event.downtimeMicros = m_outageMicros ? now - m_outageMicros : 0;
+        m_events.push_back(event);
+
+        m_state = masterPid ? SUPERVISOR_WATCHING : SUPERVISOR_IDLE;
+        m_targetPid = masterPid;
+        m_targetPidFile = pidFile;
+        m_watchMicros = now;
+        m_outageMicros = 0;
+    }
+    Wake();
+}
+
+void Supervisor::RestartFailed(const std::string& reason) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state != SUPERVISOR_RESTARTING) return;
+        uint64_t now = MonotonicMicros();
+        SupervisorEvent event;
+        event.type = SUPERVISOR_RESTART_FAILED;
+        event.attempt = m_attempt;
+        event.reason = reason;
+        event.recentCrashes = RecordCrash(now);
+        if (event.recentCrashes >= m_policy.loopCrashes) {
+            m_state = SUPERVISOR_GAVE_UP;
+            m_events.push_back(event);
+            event.type = SUPERVISOR_CRASH_LOOP;
+        } else if (!m_enabled) {
+            m_state = SUPERVISOR_IDLE;
+        } else {
+            ++m_attempt;
+            event.delayMs = NextDelayMs();
+            m_restartAtMicros = now + (uint64_t)event.delayMs * 1000;
+            m_state = SUPERVISOR_BACKOFF;
+        }
+        m_events.push_back(event);
+    }
+    Wake();
+}
+
+SupervisorState Supervisor::State() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_state;
+}
+
+ProcessId Supervisor::WatchedPid() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_state == SUPERVISOR_WATCHING ? m_targetPid : 0;
+}
+
+// 指数退避 + 抖动：基准为 initial * 2^(attempt-1)（不超过上限），实际取 [基准/2, 基准) 内的随机值，
+// 避免多个实例同时崩溃后在同一时刻一起重启
+uint32_t Supervisor::NextDelayMs() {
+    uint64_t base = m_policy.initialDelayMs;
+    for (uint32_t i = 1; i < m_attempt && base < m_policy.maxDelayMs; ++i) base *= 2;
+    if (base > m_policy.maxDelayMs) base = m_policy.maxDelayMs;
+    uint32_t half = (uint32_t)(base / 2);
+    std::uniform_int_distribution<uint32_t> jitter(0, half > 0 ? half - 1 : 0);
+    return half + jitter(m_random);
+}
+
+uint32_t Supervisor::RecordCrash(uint64_t now) {
+    m_crashes.push_back(now);
+    uint64_t window = (uint64_t)m_policy.loopWindowMs * 1000;
+    while (!m_crashes.empty() && now - m_crashes.front() > window) m_crashes.pop_front();
+    return (uint32_t)m_crashes.size();
+}
+
+void Supervisor::Run() {
+    TraceSetThreadName("supervisor");
+    std::vector<SupervisorEvent> events;
+    for (;;) {
+        ProcessId target = 0;
+        std::string pidFile;
+        uint64_t restartAt = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_stopping) break;
+            if (m_state == SUPERVISOR_WATCHING) {
+                target = m_targetPid;
+                pidFile = m_targetPidFile;
+            }
+            if (m_state == SUPERVISOR_BACKOFF) restartAt = m_restartAtMicros;
+            events.swap(m_events);
+        }
+        for (const SupervisorEvent& event : events) {
+            if (m_handler) m_handler(event);
+        }
+        events.clear();
+
+        // 句柄只在本线程中打开与关闭，目标变化时先换掉正在等待的句柄
+        bool gone = false;
+        if (target != m_openedPid) {
+#ifdef _WIN32
+            if (m_process) CloseHandle(m_process);
+            m_process = NULL;
+            if (target) {
+                m_process = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, target);
+                gone = m_process == NULL && GetLastError() == ERROR_INVALID_PARAMETER;
+            }
+#else
+            if (m_pidfd >= 0) close(m_pidfd);
+            m_pidfd = -1;
+            m_polling = false;
+            if (target) {
+#ifdef SYS_pidfd_open
+                m_pidfd = (int)syscall(SYS_pidfd_open, (pid_t)target, 0);
+#endif
+                if (m_pidfd >= 0) {
+                    epoll_event event = {};
+                    event.events = EPOLLIN;
+                    event.data.fd = m_pidfd;
+                    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_pidfd, &event);
+                } else if (kill((pid_t)target, 0) != 0 && errno == ESRCH) {
+                    gone = true;
+                } else {
+                    m_polling = true;
+                }
+            }
+#endif
+            m_openedPid = target;
+        }
+
+        // 只有退避中才有超时，其余时间无限期等待
+        uint64_t now = MonotonicMicros();
+        if (!gone) {
+#ifdef _WIN32
+            DWORD timeout = INFINITE;
+            if (restartAt) timeout = restartAt > now ? (DWORD)((restartAt - now + 999) / 1000) : 0;
+            HANDLE handles[2] = { m_wakeEvent, m_process };
+            DWORD count = (target && m_process) ? 2 : 1;
+            DWORD result = WaitForMultipleObjects(count, handles, FALSE, timeout);
+            gone = count == 2 && result == WAIT_OBJECT_0 + 1;
+#else
+            int timeout = -1;
+            if (restartAt) timeout = restartAt > now ? (int)((restartAt - now + 999) / 1000) : 0;
+            if (m_polling && (timeout < 0 || timeout > (int)kPollIntervalMs)) timeout = (int)kPollIntervalMs;
+            epoll_event ready[2];
+            int count = epoll_wait(m_epoll, ready, 2, timeout);
+            for (int i = 0; i < count; ++i) {
+                if (ready[i].data.fd == m_wakeFd) {
+                    uint64_t value;
+                    ssize_t got = read(m_wakeFd, &value, sizeof(value));
+                    (void)got;
+                } else if (m_pidfd >= 0 && ready[i].data.fd == m_pidfd) {
+                    gone = true;
+                }
+            }
+            if (m_polling && target && kill((pid_t)target, 0) != 0 && errno == ESRCH) gone = true;
+#endif
+        }
+        now = MonotonicMicros();
+
+        SupervisorEvent exited;
+        bool haveExit = false;
+        if (gone && target) {
+            exited.type = SUPERVISOR_EXITED;
+            exited.pid = target;
+#ifdef _WIN32
+            DWORD code = 0;
+            if (m_process && GetExitCodeProcess(m_process, &code)) {
+                exited.exitCodeKnown = true;
+                exited.exitCode = (int)code;
+            }
+            if (m_process) CloseHandle(m_process);
+            m_process = NULL;
+#else
+            // 只有本进程的子进程（前台运行的 master）能取得退出状态，同时回收僵尸进程；被信号结束时记为 128 + 信号
+            siginfo_t info = {};
+            if (waitid(P_PID, (id_t)target, &info, WEXITED | WNOHANG) == 0 && info.si_pid == (pid_t)target) {
+                exited.exitCodeKnown = true;
+                exited.exitCode = info.si_code == CLD_EXITED ? info.si_status : 128 + info.si_status;
+            }
+            if (m_pidfd >= 0) close(m_pidfd);
+            m_pidfd = -1;
+            m_polling = false;
+#endif
+            m_openedPid = 0;
+            // 取不到退出码（后台运行的 master 是 init 的子进程）时，以 pid 文件是否被 nginx 删除区分正常退出与崩溃
+            if (exited.exitCodeKnown) {
+                exited.clean = exited.exitCode == 0;
+            } else {
+                exited.clean = !pidFile.empty() && PidFileReleased(pidFile, target);
+            }
+            haveExit = true;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (haveExit && m_state == SUPERVISOR_WATCHING && m_targetPid == target) {
+            exited.uptimeMicros = now - m_watchMicros;
+            if (exited.uptimeMicros >= (uint64_t)m_policy.stableMs * 1000) m_attempt = 0;
+            if (m_outageMicros == 0) m_outageMicros = now;
+            m_targetPid = 0;
+            m_targetPidFile.clear();
+
+            // 正常退出（如在命令行执行了 nginx -s quit / stop）不算崩溃；已关闭自动重启时同样只报告
+            if (!m_enabled || exited.clean) {
+                m_state = SUPERVISOR_IDLE;
+                m_outageMicros = 0;
+                m_events.push_back(exited);
+                continue;
+            }
+            exited.recentCrashes = RecordCrash(now);
+            if (exited.recentCrashes >= m_policy.loopCrashes) {
+                m_state = SUPERVISOR_GAVE_UP;
+                m_events.push_back(exited);
+                exited.type = SUPERVISOR_CRASH_LOOP;
+                m_events.push_back(exited);
+                continue;
+            }
+            ++m_attempt;
+            exited.attempt = m_attempt;
+            exited.delayMs = NextDelayMs();
+            m_restartAtMicros = now + (uint64_t)exited.delayMs * 1000;
+            m_state = SUPERVISOR_BACKOFF;
+            m_events.push_back(exited);
+        } else if (m_state == SUPERVISOR_BACKOFF && now >= m_restartAtMicros) {
+            SupervisorEvent restart;
+            restart.type = SUPERVISOR_RESTART;
+            restart.attempt = m_attempt;
+            restart.recentCrashes = (uint32_t)m_crashes.size();
+            m_state = SUPERVISOR_RESTARTING;
+            m_events.push_back(restart);
+        }
+    }
+}
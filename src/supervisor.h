@@ -0,0 +1,129 @@
+// nginx-manager/src/supervisor.h
+// 崩溃监护 - 阻塞等待 master 进程句柄 / pidfd，意外退出后按指数退避（带抖动）自动重启，识别崩溃循环
+
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include "platform.h"
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum SupervisorState {
+    SUPERVISOR_IDLE,                 // 没有需要监护的进程（未运行或已被主动停止）
+    SUPERVISOR_WATCHING,             // 正在等待 master 退出
+    SUPERVISOR_BACKOFF,              // master 意外退出，等待退避时间结束
+    SUPERVISOR_RESTARTING,           // 已请求重启，等待 RestartSucceeded / RestartFailed
+    SUPERVISOR_GAVE_UP               // 判定为崩溃循环，不再自动重启
+};
+
+const char* SupervisorStateName(SupervisorState state);
+
+enum SupervisorEventType {
+    SUPERVISOR_EXITED,               // master 退出（clean 为 true 时是正常退出，不重启）
+    SUPERVISOR_RESTART,              // 退避结束，处理方应执行重启并回报结果
+    SUPERVISOR_RECOVERED,            // 自动重启成功
+    SUPERVISOR_RESTART_FAILED,       // 自动重启失败，退避后再试
+    SUPERVISOR_CRASH_LOOP            // 短时间内崩溃过多，放弃自动重启
+};
+
+struct SupervisorEvent {
+    SupervisorEventType type = SUPERVISOR_EXITED;
+    ProcessId pid = 0;               // EXITED: 退出的 master；RECOVERED: 新的 master
+    bool exitCodeKnown = false;      // Linux 上只有本进程的子进程才能取得退出码
+    int exitCode = 0;
+    bool clean = false;              // EXITED: 正常退出（退出码为 0，或取不到退出码时 nginx 已删除自己的 pid 文件）
+    uint64_t uptimeMicros = 0;       // EXITED: 这个 master 被监护的时长
+    uint32_t attempt = 0;            // 连续第几次自动重启（从 1 开始）
+    uint32_t delayMs = 0;            // EXITED / RESTART_FAILED: 下一次重启前的等待，不再重启时为 0
+    uint32_t recentCrashes = 0;      // 崩溃循环窗口内的退出与重启失败次数
+    uint64_t downtimeMicros = 0;     // RECOVERED: 从检测到退出到新 master 就绪
+    std::string reason;              // RESTART_FAILED / CRASH_LOOP: 重启失败原因
+};
+
+struct SupervisorPolicy {
+    uint32_t initialDelayMs = 500;   // 第一次重启前的等待
+    uint32_t maxDelayMs = 60000;
+    uint32_t stableMs = 60000;       // 连续运行超过这个时长后，退避从头开始
+    uint32_t loopCrashes = 5;        // 窗口内达到这个次数即判定为崩溃循环
+    uint32_t loopWindowMs = 120000;
+};
+
+// 崩溃监护
+// 后台线程阻塞在 master 进程句柄 (WaitForMultipleObjects) 或 pidfd (epoll) 上，进程退出时立即返回；
+// 没有进程需要监护、也不在退避中时无限期等待，空闲时不占用 CPU，也没有定时器。
+// 主动停止 / 强制重启前必须先调用 Unwatch，否则结束进程会被当作崩溃。
+// 事件在监护线程中回调，回调中不要调用会阻塞的操作。
+class Supervisor {
+public:
+    typedef std::function<void(const SupervisorEvent& event)> EventHandler;
+
+    Supervisor();
+    ~Supervisor();
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    bool Start(EventHandler handler, std::string* error);
+    void Stop();
+
+    void SetPolicy(const SupervisorPolicy& policy);
+    // 关闭时仍报告意外退出，但不再请求重启
+    void SetEnabled(bool enabled);
+
+    // 开始监护手动启动的 master（清空退避与崩溃记录）；pid 与当前监护的相同时为空操作。
+    // pidFile 为 master 的 pid 文件：后台运行的 master 不是本进程的子进程，Linux 上取不到退出码，
+    // nginx -s quit / stop 等正常退出时 nginx 会删除 pid 文件，崩溃或被强制结束时则会留下
+    void Watch(ProcessId masterPid, const std::string& pidFile = std::string());
+    // 主动停止：不再监护，取消等待中的重启
+    void Unwatch();
+
+    // 回报 SUPERVISOR_RESTART 的结果
+    void RestartSucceeded(ProcessId masterPid, const std::string& pidFile = std::string());
+    void RestartFailed(const std::string& reason);
+
+    SupervisorState State() const;
+    ProcessId WatchedPid() const;
+
+private:
+    void Run();
+    void Wake();
+    // 以下在持有 m_mutex 时调用
+    uint32_t NextDelayMs();
+    uint32_t RecordCrash(uint64_t now);
+
+    // 由监护线程打开与关闭，其他线程只修改 m_targetPid 再唤醒
+#ifdef _WIN32
+    HANDLE m_wakeEvent = NULL;
+    HANDLE m_process = NULL;
+#else
+    int m_epoll = -1;
+    int m_wakeFd = -1;
+    int m_pidfd = -1;
+    bool m_polling = false;          // 内核不支持 pidfd 时退化为定期 kill(pid, 0) 检查
+#endif
+    ProcessId m_openedPid = 0;
+
+    std::thread m_worker;
+    mutable std::mutex m_mutex;
+    EventHandler m_handler;
+    SupervisorPolicy m_policy;
+    bool m_stopping = false;
+    bool m_enabled = true;
+    SupervisorState m_state = SUPERVISOR_IDLE;
+    ProcessId m_targetPid = 0;       // 应当监护的 master
+    std::string m_targetPidFile;     // 其 pid 文件，未知时为空
+    uint64_t m_watchMicros = 0;      // 开始监护的时刻
+    uint64_t m_outageMicros = 0;     // 本次停机中第一次检测到退出的时刻，未停机时为 0
+    uint64_t m_restartAtMicros = 0;  // 退避结束的时刻
+    uint32_t m_attempt = 0;          // 连续重启次数，稳定运行后清零
+    std::vector<SupervisorEvent> m_events;   // 其他线程产生、待监护线程回调的事件
+    std::deque<uint64_t> m_crashes;  // 窗口内的退出 / 重启失败时刻
+    std::mt19937 m_random;
+};
+
+#endif // SUPERVISOR_H
@@ -0,0 +1,81 @@
+// nginx-manager/src/timer_wheel.cpp
+// 时间轮 - 大量定时器的 O(1) 设置 / 改设 / 取消，按固定刻度推进，定时器以连续的整数 ID 标识
+
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(uint64_t tickMicros, size_t slots) : m_tickMicros(tickMicros ? tickMicros : 1) {
+    size_t size = 1;
+    while (size < slots) size <<= 1;
+    m_mask = size - 1;
+    m_heads.assign(size, kNone);
+}
+
+void TimerWheel::Reset(size_t capacity, uint64_t now) {
+    m_heads.assign(m_heads.size(), kNone);
+    m_nodes.assign(capacity, Node());
+    m_origin = now;
+    m_current = 0;
+    m_size = 0;
+}
+
+void TimerWheel::Schedule(uint32_t id, uint64_t deadline) {
+    if (m_nodes[id].slot != kNone) Unlink(id);
+
+    // 向上取整：处理到某个刻度时，该刻度上的定时器都已到期
+    uint64_t tick = deadline > m_origin ? (deadline - m_origin + m_tickMicros - 1) / m_tickMicros : 0;
+    if (tick < m_current) tick = m_current;
+
+    Node& node = m_nodes[id];
+    node.tick = tick;
+    node.slot = (uint32_t)(tick & m_mask);
+    node.prev = kNone;
+    node.next = m_heads[node.slot];
+    if (node.next != kNone) m_nodes[node.next].prev = id;
+    m_heads[node.slot] = id;
+    ++m_size;
+}
+
+void TimerWheel::Cancel(uint32_t id) {
+    if (m_nodes[id].slot != kNone) Unlink(id);
+}
+
+void TimerWheel::Unlink(uint32_t id) {
+    Node& node = m_nodes[id];
+    if (node.prev != kNone) {
+        m_nodes[node.prev].next = node.next;
+    } else {
+        m_heads[node.slot] = node.next;
+    }
+    if (node.next != kNone) m_nodes[node.next].prev = node.prev;
+    node.prev = node.next = node.slot = kNone;
+    --m_size;
+}
+
+void TimerWheel::Advance(uint64_t now, std::vector<uint32_t>* expired) {
+    if (now < m_origin) return;
+    uint64_t nowTick = (now - m_origin) / m_tickMicros;
+    if (nowTick < m_current) return;
+
+    // 落后超过一圈时每个槽只需扫描一遍
+    uint64_t last = nowTick - m_current > m_mask ? m_current + m_mask : nowTick;
+    for (uint64_t tick = m_current; tick <= last && m_size > 0; ++tick) {
+        uint32_t id = m_heads[tick & m_mask];
+        while (id != kNone) {
+            uint32_t next = m_nodes[id].next;
+            if (m_nodes[id].tick <= nowTick) {
+                Unlink(id);
+                expired->push_back(id);
+            }
+            id = next;
+        }
+    }
+    m_current = nowTick + 1;
+}
+
+uint64_t TimerWheel::NextWake() const {
+    if (m_size == 0) return UINT64_MAX;
+    for (uint64_t tick = m_current; tick <= m_current + m_mask; ++tick) {
+        if (m_heads[tick & m_mask] != kNone) return m_origin + tick * m_tickMicros;
+    }
+    return UINT64_MAX;
+}
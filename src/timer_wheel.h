@@ -0,0 +1,57 @@
+// nginx-manager/src/timer_wheel.h
+// 时间轮 - 大量定时器的 O(1) 设置 / 改设 / 取消，按固定刻度推进，定时器以连续的整数 ID 标识
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 单层哈希时间轮
+// 每个 ID 至多一个定时器，节点按 ID 预先分配，槽内以双向链表串联（下标而非指针），设置与取消都不分配内存。
+// 到期时刻向上取整到刻度，因此定时器不会早于设定时刻到期，最多晚一个刻度（加上调用方的等待误差）。
+// 一圈覆盖 tickMicros * slots，更远的定时器留在槽中，等转到对应的圈才到期。
+class TimerWheel {
+public:
+    // slots 向上取整为 2 的幂
+    TimerWheel(uint64_t tickMicros, size_t slots);
+
+    // 清空所有定时器，ID 范围为 [0, capacity)，时间从 now 起算
+    void Reset(size_t capacity, uint64_t now);
+
+    // 设置定时器 id 在 deadline（与 now 同一时钟）到期，已设置时改设；早于已推进到的时刻时下一次 Advance 即到期
+    void Schedule(uint32_t id, uint64_t deadline);
+    void Cancel(uint32_t id);
+    bool Scheduled(uint32_t id) const { return m_nodes[id].slot != kNone; }
+    size_t Size() const { return m_size; }
+
+    // 推进到 now，到期的定时器被移除并把 ID 追加到 expired
+    void Advance(uint64_t now, std::vector<uint32_t>* expired);
+
+    // 最近一个非空槽的时刻，用作等待超时；槽中的定时器可能属于之后的圈，届时 Advance 不返回它们。
+    // 没有定时器时返回 UINT64_MAX
+    uint64_t NextWake() const;
+
+private:
+    static constexpr uint32_t kNone = 0xFFFFFFFFu;
+
+    struct Node {
+        uint64_t tick = 0;           // 到期的刻度（自 Reset 起）
+        uint32_t prev = kNone;
+        uint32_t next = kNone;
+        uint32_t slot = kNone;       // kNone 表示未设置
+    };
+
+    void Unlink(uint32_t id);
+
+    uint64_t m_tickMicros;
+    size_t m_mask;
+    std::vector<uint32_t> m_heads;
+    std::vector<Node> m_nodes;
+    uint64_t m_origin = 0;
+    uint64_t m_current = 0;          // 下一个待处理的刻度，之前的刻度均已处理
+    size_t m_size = 0;
+};
+
+#endif // TIMER_WHEEL_H
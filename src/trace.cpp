@@ -0,0 +1,411 @@
+// nginx-manager/src/trace.cpp
+// 追踪 - 各线程把耗时区间写入自己的无锁环形缓冲并累计直方图，汇总为诊断表或导出 Chrome trace JSON
+
+#include "trace.h"
+#include "file_util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+
+std::atomic<bool> g_traceEnabled(false);
+
+namespace {
+
+const size_t kRingCapacity = 4096;   // 每个线程保留最近的区间数，须为 2 的幂
+const size_t kMaxLabels = 48;        // 每个线程的标签表容量
+
+// 直方图分桶：16 以下每个值一桶；更大的值按最高位所在的量级各分 8 桶，量级上限 2^40 微秒
+const unsigned kSubBucketBits = 3;
+const unsigned kMaxWidth = 40;
+const size_t kExactBuckets = 16;
+const size_t kBuckets = kExactBuckets + (kMaxWidth - 4) * ((size_t)1 << kSubBucketBits);
+
+size_t BucketOf(uint64_t value) {
+    if (value < kExactBuckets) return (size_t)value;
+    unsigned width = 0;
+    for (uint64_t v = value; v; v >>= 1) ++width;
+    if (width > kMaxWidth) return kBuckets - 1;
+    unsigned shift = width - 1 - kSubBucketBits;
+    size_t sub = (size_t)(value >> shift) - ((size_t)1 << kSubBucketBits);
+    return kExactBuckets + (width - 5) * ((size_t)1 << kSubBucketBits) + sub;
+}
+
+// 桶的中点，相对误差不超过 1/16
+uint64_t BucketMiddle(size_t index) {
+    if (index < kExactBuckets) return index;
+    size_t offset = index - kExactBuckets;
+    unsigned shift = (unsigned)(offset >> kSubBucketBits) + 1;
+    uint64_t low = (uint64_t)((offset & (((size_t)1 << kSubBucketBits) - 1)) + ((size_t)1 << kSubBucketBits)) << shift;
+    return low + ((1ull << shift) >> 1);
+}
+
+// 环形缓冲的一项。各字段只由所属线程写入，读取方可能读到正在改写的项，靠前后两次读取 head 剔除
+struct TraceSlot {
+    std::atomic<uint64_t> begin{0};
+    std::atomic<uint64_t> end{0};
+    std::atomic<const char*> label{nullptr};
+    std::atomic<int64_t> arg{0};
+    std::atomic<uint8_t> kind{0};
+};
+
+// 一个标签的直方图。label 为空表示未使用，所属线程初始化完其余字段后才发布 label
+struct LabelHistogram {
+    std::atomic<const char*> label{nullptr};
+    std::atomic<uint8_t> kind{0};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> max{0};
+    std::atomic<uint32_t> buckets[kBuckets];
+};
+
+// 单写者计数：只有所属线程修改，读改写不需要原子指令
+template <typename T>
+inline void Bump(std::atomic<T>& counter, T delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> head{0};   // 已写入的区间总数，slots[head % kRingCapacity] 为下一项
+    std::atomic<uint64_t> overflow{0};
+    TraceSlot slots[kRingCapacity];
+    LabelHistogram labels[kMaxLabels];
+
+    ThreadBuffer() {
+        for (LabelHistogram& histogram : labels) {
+            for (std::atomic<uint32_t>& bucket : histogram.buckets) bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 按 (标签, 类别) 查找：同一操作名既用于排队也用于执行
+    LabelHistogram* Find(const char* label, TraceKind kind) {
+        size_t start = (size_t)((((uintptr_t)label >> 3) + kind) * 0x9E3779B97F4A7C15ull >> 40) % kMaxLabels;
+        for (size_t probe = 0; probe < kMaxLabels; ++probe) {
+            LabelHistogram& histogram = labels[(start + probe) % kMaxLabels];
+            const char* current = histogram.label.load(std::memory_order_relaxed);
+            if (current == label && histogram.kind.load(std::memory_order_relaxed) == (uint8_t)kind) return &histogram;
+            if (current == nullptr) {
+                histogram.kind.store((uint8_t)kind, std::memory_order_relaxed);
+                histogram.label.store(label, std::memory_order_release);
+                return &histogram;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// 所有线程的缓冲只增不减：线程退出后缓冲留给之后新建的线程复用，已记录的区间与直方图保留
+std::mutex g_registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;
+std::vector<ThreadBuffer*> g_freeBuffers;
+std::atomic<uint64_t> g_enabledMicros(0);
+
+thread_local const char* t_threadName = nullptr;
+
+struct ThreadBufferHolder {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadBufferHolder() {
+        if (!buffer) return;
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        g_freeBuffers.push_back(buffer);
+    }
+};
+
+thread_local ThreadBufferHolder t_holder;
+
+ThreadBuffer* AcquireBuffer() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    ThreadBuffer* buffer;
+    if (!g_freeBuffers.empty()) {
+        buffer = g_freeBuffers.back();
+        g_freeBuffers.pop_back();
+    } else {
+        g_buffers.emplace_back(new ThreadBuffer());
+        buffer = g_buffers.back().get();
+        buffer->tid = (uint32_t)g_buffers.size();
+    }
+    buffer->name.store(t_threadName, std::memory_order_relaxed);
+    t_holder.buffer = buffer;
+    return buffer;
+}
+
+std::vector<ThreadBuffer*> SnapshotBuffers() {
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    std::vector<ThreadBuffer*> buffers;
+    for (const auto& buffer : g_buffers) buffers.push_back(buffer.get());
+    return buffers;
+}
+
+struct TraceEvent {
+    uint64_t begin;
+    uint64_t end;
+    const char* label;
+    int64_t arg;
+    TraceKind kind;
+    uint32_t tid;
+};
+
+// 读出一个线程环形缓冲中的区间：复制前后各读一次 head，复制期间可能被覆盖的项丢弃
+void CopyEvents(const ThreadBuffer& buffer, std::vector<TraceEvent>* events) {
+    uint64_t head = buffer.head.load(std::memory_order_acquire);
+    uint64_t first = head > kRingCapacity ? head - kRingCapacity : 0;
+    size_t base = events->size();
+    for (uint64_t index = first; index < head; ++index) {
+        const TraceSlot& slot = buffer.slots[index & (kRingCapacity - 1)];
+        TraceEvent event;
+        event.begin = slot.begin.load(std::memory_order_relaxed);
+        event.end = slot.end.load(std::memory_order_relaxed);
+        event.label = slot.label.load(std::memory_order_relaxed);
+        event.arg = slot.arg.load(std::memory_order_relaxed);
+        event.kind = (TraceKind)slot.kind.load(std::memory_order_relaxed);
+        event.tid = buffer.tid;
+        events->push_back(event);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = buffer.head.load(std::memory_order_relaxed);
+    if (after + 1 > first + kRingCapacity) {
+        // 下标不超过 after - kRingCapacity 的项可能已被（或正在被）改写
+        uint64_t valid = after + 1 - kRingCapacity;
+        size_t drop = (size_t)std::min<uint64_t>(valid - first, head - first);
+        events->erase(events->begin() + base, events->begin() + base + drop);
+    }
+}
+
+void AppendJsonString(std::string* out, const char* text) {
+    out->push_back('"');
+    for (const char* p = text; *p; ++p) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            out->push_back('\\');
+            out->push_back((char)c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out->append(escaped);
+        } else {
+            out->push_back((char)c);
+        }
+    }
+    out->push_back('"');
+}
+
+std::string FormatMillis(uint64_t micros) {
+    char text[32];
+    if (micros < 10000) {
+        snprintf(text, sizeof(text), "%.2f", micros / 1000.0);
+    } else {
+        snprintf(text, sizeof(text), "%.0f", micros / 1000.0);
+    }
+    return text;
+}
+
+} // namespace
+
+const char* TraceKindName(TraceKind kind) {
+    static const char* const kNames[] = { "operation", "queue", "process", "probe", "wait", "config", "paint" };
+    return kind >= 0 && kind < TRACE_KIND_COUNT ? kNames[kind] : "unknown";
+}
+
+void TraceEnable(bool enabled) {
+    if (enabled && !g_traceEnabled.load()) {
+        uint64_t expected = 0;
+        g_enabledMicros.compare_exchange_strong(expected, MonotonicMicros());
+    }
+    g_traceEnabled.store(enabled);
+}
+
+void TraceSetThreadName(const char* name) {
+    t_threadName = name;
+    if (t_holder.buffer) t_holder.buffer->name.store(name, std::memory_order_relaxed);
+}
+
+void TraceRecord(TraceKind kind, const char* label, uint64_t beginMicros, uint64_t endMicros, int64_t arg) {
+    ThreadBuffer* buffer = t_holder.buffer ? t_holder.buffer : AcquireBuffer();
+    uint64_t duration = endMicros > beginMicros ? endMicros - beginMicros : 0;
+
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    TraceSlot& slot = buffer->slots[head & (kRingCapacity - 1)];
+    slot.begin.store(beginMicros, std::memory_order_relaxed);
+    slot.end.store(beginMicros + duration, std::memory_order_relaxed);
+    slot.label.store(label, std::memory_order_relaxed);
+    slot.arg.store(arg, std::memory_order_relaxed);
+    slot.kind.store((uint8_t)kind, std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+
+    LabelHistogram* histogram = buffer->Find(label, kind);
+    if (!histogram) {
+        Bump<uint64_t>(buffer->overflow, 1);
+        return;
+    }
+    Bump<uint32_t>(histogram->buckets[BucketOf(duration)], 1);
+    Bump<uint64_t>(histogram->count, 1);
+    Bump<uint64_t>(histogram->total, duration);
+    if (duration > histogram->max.load(std::memory_order_relaxed)) {
+        histogram->max.store(duration, std::memory_order_relaxed);
+    }
+}
+
+TraceSummary CollectTraceSummary() {
+    TraceSummary summary;
+    summary.enabled = TraceEnabled();
+
+    // 同一标签在各线程（以及不同编译单元的同名字面量）中分别计数，按文本合并
+    struct Merged {
+        TraceKind kind;
+        uint64_t count = 0;
+        uint64_t total = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> buckets = std::vector<uint64_t>(kBuckets, 0);
+    };
+    std::map<std::pair<int, std::string>, Merged> merged;
+
+    for (ThreadBuffer* buffer : SnapshotBuffers()) {
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        if (head == 0) continue;
+        summary.threads++;
+        summary.spans += head;
+        summary.retained += std::min<uint64_t>(head, kRingCapacity);
+        summary.overflowLabels += buffer->overflow.load(std::memory_order_relaxed);
+        for (const LabelHistogram& histogram : buffer->labels) {
+            const char* label = histogram.label.load(std::memory_order_acquire);
+            if (!label) continue;
+            TraceKind kind = (TraceKind)histogram.kind.load(std::memory_order_relaxed);
+            Merged& entry = merged[std::make_pair((int)kind, std::string(label))];
+            entry.kind = kind;
+            entry.count += histogram.count.load(std::memory_order_relaxed);
+            entry.total += histogram.total.load(std::memory_order_relaxed);
+            entry.max = std::max(entry.max, histogram.max.load(std::memory_order_relaxed));
+            for (size_t i = 0; i < kBuckets; ++i) {
+                entry.buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    for (const auto& item : merged) {
+        const Merged& entry = item.second;
+        uint64_t bucketed = 0;
+        for (uint64_t n : entry.buckets) bucketed += n;
+        if (bucketed == 0) continue;
+
+        TraceStat stat;
+        stat.label = item.first.second;
+        stat.kind = entry.kind;
+        stat.count = entry.count;
+        stat.totalMicros = entry.total;
+        stat.maxMicros = entry.max;
+        const double percentiles[] = { 50, 90, 99 };
+        uint64_t* outputs[] = { &stat.p50Micros, &stat.p90Micros, &stat.p99Micros };
+        for (int p = 0; p < 3; ++p) {
+            uint64_t target = (uint64_t)(percentiles[p] / 100.0 * (double)bucketed + 0.5);
+            if (target == 0) target = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < kBuckets; ++i) {
+                seen += entry.buckets[i];
+                if (seen >= target) {
+                    *outputs[p] = std::min(BucketMiddle(i), entry.max);
+                    break;
+                }
+            }
+        }
+        summary.stats.push_back(stat);
+    }
+
+    std::sort(summary.stats.begin(), summary.stats.end(), [](const TraceStat& a, const TraceStat& b) {
+        if (a.kind != b.kind) return a.kind < b.kind;
+        return a.totalMicros > b.totalMicros;
+    });
+    return summary;
+}
+
+std::string FormatTraceSummary(const TraceSummary& summary) {
+    std::string text = std::string("追踪") + (summary.enabled ? "开启" : "关闭") + ": " +
+                       std::to_string(summary.spans) + " 个区间, " + std::to_string(summary.threads) + " 个线程, " +
+                       "可导出 " + std::to_string(summary.retained) + " 个";
+    if (summary.overflowLabels) text += ", " + std::to_string(summary.overflowLabels) + " 个未计入直方图 (标签过多)";
+    if (summary.stats.empty()) return text + "\n(暂无数据)";
+
+    char line[256];
+    snprintf(line, sizeof(line), "\n%-10s %-22s %8s %10s %9s %9s %9s %9s", "类别", "区间", "次数", "总计ms",
+             "p50", "p90", "p99", "max");
+    text += line;
+    for (const TraceStat& stat : summary.stats) {
+        snprintf(line, sizeof(line), "\n%-10s %-22s %8llu %10s %9s %9s %9s %9s", TraceKindName(stat.kind),
+                 stat.label.c_str(), (unsigned long long)stat.count, FormatMillis(stat.totalMicros).c_str(),
+                 FormatMillis(stat.p50Micros).c_str(), FormatMillis(stat.p90Micros).c_str(),
+                 FormatMillis(stat.p99Micros).c_str(), FormatMillis(stat.maxMicros).c_str());
+        text += line;
+    }
+    return text;
+}
+
+std::string TraceExportPath(const std::string& directory) {
+    time_t now = time(nullptr);
+    struct tm parts;
+#ifdef _WIN32
+    localtime_s(&parts, &now);
+    const char* separator = "\\";
+#else
+    localtime_r(&now, &parts);
+    const char* separator = "/";
+#endif
+    char name[48];
+    snprintf(name, sizeof(name), "trace-%04d%02d%02d-%02d%02d%02d.json", parts.tm_year + 1900, parts.tm_mon + 1,
+             parts.tm_mday, parts.tm_hour, parts.tm_min, parts.tm_sec);
+    return directory + separator + name;
+}
+
+bool ExportChromeTrace(const std::string& path, size_t* exported, std::string* error) {
+    std::vector<ThreadBuffer*> buffers = SnapshotBuffers();
+    std::vector<TraceEvent> events;
+    for (ThreadBuffer* buffer : buffers) CopyEvents(*buffer, &events);
+    std::sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        if (a.begin != b.begin) return a.begin < b.begin;
+        return a.end > b.end;            // 同时开始时外层区间在前
+    });
+
+    // 时间戳从开启追踪（或最早的区间）算起
+    uint64_t origin = g_enabledMicros.load();
+    if (!events.empty() && (origin == 0 || events.front().begin < origin)) origin = events.front().begin;
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    char number[160];
+    for (ThreadBuffer* buffer : buffers) {
+        if (buffer->head.load(std::memory_order_acquire) == 0) continue;
+        const char* name = buffer->name.load(std::memory_order_relaxed);
+        std::string fallback = "thread-" + std::to_string(buffer->tid);
+        if (!first) json += ",\n";
+        first = false;
+        snprintf(number, sizeof(number), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                 buffer->tid);
+        json += number;
+        AppendJsonString(&json, name ? name : fallback.c_str());
+        json += "}}";
+    }
+    for (const TraceEvent& event : events) {
+        if (!first) json += ",\n";
+        first = false;
+        json += "{\"name\":";
+        AppendJsonString(&json, event.label ? event.label : "?");
+        snprintf(number, sizeof(number), ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u",
+                 TraceKindName(event.kind), (unsigned long long)(event.begin - origin),
+                 (unsigned long long)(event.end - event.begin), event.tid);
+        json += number;
+        if (event.arg) {
+            snprintf(number, sizeof(number), ",\"args\":{\"arg\":%lld}", (long long)event.arg);
+            json += number;
+        }
+        json += "}";
+    }
+    json += "\n]}\n";
+
+    if (!WriteFileAtomically(path, json, error)) return false;
+    if (exported) *exported = events.size();
+    return true;
+}
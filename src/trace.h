@@ -0,0 +1,106 @@
+// nginx-manager/src/trace.h
+// 追踪 - 各线程把耗时区间写入自己的无锁环形缓冲并累计直方图，汇总为诊断表或导出 Chrome trace JSON
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "platform.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 区间的类别，导出时为 Chrome trace 的 cat
+enum TraceKind {
+    TRACE_OPERATION,                 // 操作队列中的一个操作 (arg 为操作 kind)
+    TRACE_QUEUE,                     // 操作提交到开始执行的排队时间
+    TRACE_PROCESS,                   // 创建 nginx 进程、nginx -t / -s、发信号、强制结束
+    TRACE_PROBE,                     // 进程表扫描与存活检查、listen 端口探测
+    TRACE_WAIT,                      // 就绪 / 退出 / 新一代 worker 的等待
+    TRACE_CONFIG,                    // 配置解析、指纹、写入与设置保存
+    TRACE_PAINT,                     // 界面重绘
+    TRACE_KIND_COUNT
+};
+
+const char* TraceKindName(TraceKind kind);
+
+extern std::atomic<bool> g_traceEnabled;
+
+// 关闭时每个追踪点只有这一次标志读取与分支
+inline bool TraceEnabled() {
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+// 开启 / 关闭追踪；关闭后已记录的区间与直方图保留，再次开启时继续累计
+void TraceEnable(bool enabled);
+
+// 当前线程的名称，导出时显示在时间线上；name 须为静态字符串，在该线程记录第一个区间之前调用
+void TraceSetThreadName(const char* name);
+
+// 记录一个已结束的区间 [beginMicros, endMicros)（MonotonicMicros）；label 须为静态字符串。
+// 只写调用线程自己的缓冲，不加锁也不做原子读改写；调用方应先检查 TraceEnabled()
+void TraceRecord(TraceKind kind, const char* label, uint64_t beginMicros, uint64_t endMicros, int64_t arg = 0);
+
+// 作用域区间：构造时计时，析构时记录
+//   TraceSpan span(TRACE_WAIT, "wait-start");
+class TraceSpan {
+public:
+    TraceSpan(TraceKind kind, const char* label, int64_t arg = 0) {
+        if (TraceEnabled()) {
+            m_kind = kind;
+            m_label = label;
+            m_arg = arg;
+            m_begin = MonotonicMicros();
+        }
+    }
+    ~TraceSpan() {
+        if (m_begin) TraceRecord(m_kind, m_label, m_begin, MonotonicMicros(), m_arg);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    void SetArg(int64_t arg) { m_arg = arg; }
+
+private:
+    uint64_t m_begin = 0;            // 0 表示构造时追踪未开启
+    TraceKind m_kind = TRACE_OPERATION;
+    const char* m_label = nullptr;
+    int64_t m_arg = 0;
+};
+
+// 一个标签的耗时统计（微秒），分位数来自对数分桶的直方图，相对误差不超过约 6%（16µs 以下精确）
+struct TraceStat {
+    std::string label;
+    TraceKind kind = TRACE_OPERATION;
+    uint64_t count = 0;
+    uint64_t totalMicros = 0;
+    uint64_t p50Micros = 0;
+    uint64_t p90Micros = 0;
+    uint64_t p99Micros = 0;
+    uint64_t maxMicros = 0;
+};
+
+struct TraceSummary {
+    bool enabled = false;
+    uint32_t threads = 0;            // 记录过区间的线程数
+    uint64_t spans = 0;              // 累计记录的区间
+    uint64_t retained = 0;           // 仍在环形缓冲中、可导出的区间
+    uint64_t overflowLabels = 0;     // 线程的标签表已满而未计入直方图的区间
+    std::vector<TraceStat> stats;    // 按类别、总耗时降序
+};
+
+// 汇总各线程的直方图；可与记录并发进行
+TraceSummary CollectTraceSummary();
+
+// 诊断表（UTF-8，多行），首行为概况
+std::string FormatTraceSummary(const TraceSummary& summary);
+
+// 默认的导出文件：<directory>/trace-<YYYYMMDD-HHMMSS>.json（本地时间）
+std::string TraceExportPath(const std::string& directory);
+
+// 把各线程环形缓冲中的区间导出为 Chrome trace JSON（chrome://tracing、Perfetto 可直接打开），
+// 先写 .tmp 再改名；返回导出的区间数
+bool ExportChromeTrace(const std::string& path, size_t* exported, std::string* error);
+
+#endif // TRACE_H
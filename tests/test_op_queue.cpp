@@ -0,0 +1,112 @@
+// nginx-manager/tests/test_op_queue.cpp
+// 测试 - 操作队列的合并与取代：同类操作合并为一次执行，同组的新操作取消排队中与正在执行的旧操作
+//
+// 编译 (MinGW):  g++ -O2 -I../src test_op_queue.cpp ../src/op_queue.cpp ../src/file_util.cpp ../src/trace.cpp -o test_op_queue.exe
+// 编译 (Linux):  g++ -O2 -pthread -I../src test_op_queue.cpp ../src/op_queue.cpp ../src/file_util.cpp ../src/trace.cpp -o test_op_queue
+
+#include "op_queue.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+enum {
+    OP_REFRESH = 1,
+    OP_START,
+    OP_STOP
+};
+
+static const int kGroupService = 1;
+
+static int g_failures = 0;
+
+static void Check(bool condition, const char* what) {
+    printf("%-4s %s\n", condition ? "ok" : "FAIL", what);
+    if (!condition) ++g_failures;
+}
+
+// 连续提交五次刷新：合并为一个操作，只执行一次，完成回调也只有一次
+static void TestMergeIdentical() {
+    std::vector<OperationResult> results;
+    OperationQueue queue([&](const OperationResult& result) { results.push_back(result); });
+
+    int runs = 0;
+    uint64_t first = queue.Submit(OP_REFRESH, 0, [&](OperationContext&) { ++runs; });
+    bool sameId = true;
+    for (int i = 0; i < 4; ++i) {
+        sameId = queue.Submit(OP_REFRESH, 0, [&](OperationContext&) { ++runs; }) == first && sameId;
+    }
+    Check(queue.PendingCount() == 1, "五次刷新只排队一个操作");
+    Check(sameId, "合并的提交沿用第一次的操作 ID");
+
+    while (queue.RunOne()) {
+    }
+    Check(runs == 1, "刷新只执行一次");
+    Check(results.size() == 1 && results[0].id == first && !results[0].cancelled, "完成回调只调用一次且未取消");
+}
+
+// 排队中的启动被同组的停止取代：启动不执行，完成回调以 cancelled 通知
+static void TestSupersedeQueued() {
+    std::vector<OperationResult> results;
+    OperationQueue queue([&](const OperationResult& result) { results.push_back(result); });
+
+    bool started = false;
+    bool stopped = false;
+    uint64_t start = queue.Submit(OP_START, kGroupService, [&](OperationContext&) { started = true; });
+    Check(results.empty(), "提交启动时没有回调");
+
+    uint64_t stop = queue.Submit(OP_STOP, kGroupService, [&](OperationContext&) { stopped = true; });
+    Check(stop != start, "停止是新的操作");
+    Check(results.size() == 1 && results[0].id == start && results[0].kind == OP_START && results[0].cancelled,
+          "被取代的启动立即以 cancelled 回调");
+    Check(queue.PendingCount() == 1, "队列中只剩停止");
+
+    while (queue.RunOne()) {
+    }
+    Check(!started, "被取代的启动没有执行");
+    Check(stopped, "停止已执行");
+    Check(results.size() == 2 && results[1].id == stop && !results[1].cancelled, "停止正常完成");
+}
+
+// 正在执行的启动被同组的停止取代：启动通过上下文观察到取消并中止，结果标记为 cancelled
+static void TestSupersedeRunning() {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<OperationResult> results;
+    OperationQueue queue([&](const OperationResult& result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.push_back(result);
+        changed.notify_all();
+    });
+    queue.Start();
+
+    std::atomic<bool> running(false);
+    std::atomic<bool> sawCancel(false);
+    uint64_t start = queue.Submit(OP_START, kGroupService, [&](OperationContext& context) {
+        running = true;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!context.IsCancelled() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        sawCancel = context.IsCancelled();
+    });
+    while (!running) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    uint64_t stop = queue.Submit(OP_STOP, kGroupService, [](OperationContext&) {});
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, std::chrono::seconds(5), [&]() { return results.size() >= 2; });
+    }
+    queue.Stop();
+
+    Check(sawCancel, "正在执行的启动观察到取消");
+    Check(results.size() == 2 && results[0].id == start && results[0].cancelled, "启动的完成回调标记为 cancelled");
+    Check(results.size() == 2 && results[1].id == stop && !results[1].cancelled, "随后执行停止");
+}
+
+int main() {
+    TestMergeIdentical();
+    TestSupersedeQueued();
+    TestSupersedeRunning();
+    printf("\n%s (%d 项失败)\n", g_failures ? "FAILED" : "PASSED", g_failures);
+    return g_failures ? 1 : 0;
+}